@@ -0,0 +1,290 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MemoryUsage.h"
+#include "RainKernels.h"
+
+// Dynamic bounding box tree over moving rectangles, for finding the few of many that a region
+// overlaps in time logarithmic in their number. Each rectangle is a leaf holding a fattened
+// copy of its box, so moving it only touches the tree once it leaves the fat box. Leaves go in
+// next to the sibling that grows the tree's perimeter least, and every node on the way back up
+// is rotated to keep the two sides within one level of each other
+class AabbTree {
+public:
+    static const std::uint32_t NONE = 0xffffffffu;
+
+    // Leaves are fattened by margin on every side
+    explicit AabbTree(float margin) : root(NONE), freeList(NONE), margin(margin) {}
+
+    // Adds box, reported to queries as id. Returns the proxy to move or remove it by
+    std::uint32_t insert(const HitBox& box, std::uint32_t id) {
+        const std::uint32_t proxy = allocateNode();
+        nodes[proxy].box = fatten(box, 0.0f);
+        nodes[proxy].id = id;
+        insertLeaf(proxy);
+        return proxy;
+    }
+
+    void remove(std::uint32_t proxy) {
+        removeLeaf(proxy);
+        freeNode(proxy);
+    }
+
+    // Moves a proxy's box, which moved by dx since the last call. The fat box is stretched
+    // by dx on the side it's heading, so steady motion reinserts it less often. Returns true if
+    // the box left its fat box and the leaf had to be reinserted
+    bool move(std::uint32_t proxy, const HitBox& box, float dx) {
+        const HitBox& fat = nodes[proxy].box;
+        if (fat.left <= box.left && fat.top <= box.top && box.right <= fat.right && box.bottom <= fat.bottom) {
+            return false;
+        }
+        removeLeaf(proxy);
+        nodes[proxy].box = fatten(box, dx);
+        insertLeaf(proxy);
+        return true;
+    }
+
+    // Calls fn(id) for every box whose fat box overlaps box, edges included. Callers still run
+    // the precise test; this only narrows the candidates
+    template <typename Fn>
+    void query(const HitBox& box, Fn&& fn) const {
+        if (root == NONE) {
+            return;
+        }
+        std::uint32_t stack[MAX_DEPTH];
+        std::size_t depth = 0;
+        stack[depth++] = root;
+        while (depth > 0) {
+            const Node& node = nodes[stack[--depth]];
+            if (!overlaps(node.box, box)) {
+                continue;
+            }
+            if (node.isLeaf()) {
+                fn(node.id);
+            }
+            else {
+                stack[depth++] = node.left;
+                stack[depth++] = node.right;
+            }
+        }
+    }
+
+    // Levels below the root, 0 for one leaf or none
+    int height() const {
+        return root == NONE ? 0 : nodes[root].height;
+    }
+
+    MemoryUsage memoryUsage() const {
+        return vectorUsage(nodes);
+    }
+
+private:
+    // Balanced, the tree is under 1.44 log2(leaves) deep, so this covers any tree that fits in memory
+    static const std::size_t MAX_DEPTH = 128;
+
+    struct Node {
+        HitBox box;
+        std::uint32_t parent; // Next free node, on the free list
+        std::uint32_t left;   // Children, NONE for a leaf
+        std::uint32_t right;
+        std::uint32_t id;
+        int height;           // 0 for a leaf
+
+        bool isLeaf() const {
+            return left == NONE;
+        }
+    };
+
+    std::vector<Node> nodes;
+    std::uint32_t root;
+    std::uint32_t freeList;
+    float margin;
+
+    static bool overlaps(const HitBox& a, const HitBox& b) {
+        return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+    }
+
+    static HitBox combine(const HitBox& a, const HitBox& b) {
+        const HitBox box = { std::min(a.left, b.left), std::min(a.top, b.top), std::max(a.right, b.right), std::max(a.bottom, b.bottom) };
+        return box;
+    }
+
+    static float perimeter(const HitBox& box) {
+        return 2.0f * ((box.right - box.left) + (box.bottom - box.top));
+    }
+
+    HitBox fatten(const HitBox& box, float dx) const {
+        const HitBox fat = { box.left - margin + std::min(dx, 0.0f), box.top - margin, box.right + margin + std::max(dx, 0.0f), box.bottom + margin };
+        return fat;
+    }
+
+    std::uint32_t allocateNode() {
+        std::uint32_t index = freeList;
+        if (index == NONE) {
+            index = static_cast<std::uint32_t>(nodes.size());
+            nodes.push_back(Node());
+        }
+        else {
+            freeList = nodes[index].parent;
+        }
+        Node& node = nodes[index];
+        node.parent = NONE;
+        node.left = NONE;
+        node.right = NONE;
+        node.id = NONE;
+        node.height = 0;
+        return index;
+    }
+
+    void freeNode(std::uint32_t index) {
+        nodes[index].parent = freeList;
+        nodes[index].height = -1;
+        freeList = index;
+    }
+
+    // What putting a leaf with box under index would cost, beyond what its ancestors pay
+    float descendCost(std::uint32_t index, const HitBox& box, float inherited) const {
+        const Node& node = nodes[index];
+        const float grown = perimeter(combine(node.box, box));
+        return node.isLeaf() ? grown + inherited : grown - perimeter(node.box) + inherited;
+    }
+
+    void insertLeaf(std::uint32_t leaf) {
+        if (root == NONE) {
+            root = leaf;
+            nodes[leaf].parent = NONE;
+            return;
+        }
+
+        // Walk down to the sibling that grows the tree least, stopping early once pairing with the
+        // whole subtree is cheaper than going into either side
+        const HitBox box = nodes[leaf].box;
+        std::uint32_t index = root;
+        while (!nodes[index].isLeaf()) {
+            const Node& node = nodes[index];
+            const float combined = perimeter(combine(node.box, box));
+            const float here = 2.0f * combined;
+            const float inherited = 2.0f * (combined - perimeter(node.box));
+            const float left = descendCost(node.left, box, inherited);
+            const float right = descendCost(node.right, box, inherited);
+            if (here < left && here < right) {
+                break;
+            }
+            index = left < right ? node.left : node.right;
+        }
+
+        const std::uint32_t sibling = index;
+        const std::uint32_t oldParent = nodes[sibling].parent;
+        const std::uint32_t newParent = allocateNode(); // May move nodes, so nothing above holds a reference
+        nodes[newParent].parent = oldParent;
+        nodes[newParent].box = combine(nodes[sibling].box, box);
+        nodes[newParent].height = nodes[sibling].height + 1;
+        nodes[newParent].left = sibling;
+        nodes[newParent].right = leaf;
+        if (oldParent == NONE) {
+            root = newParent;
+        }
+        else if (nodes[oldParent].left == sibling) {
+            nodes[oldParent].left = newParent;
+        }
+        else {
+            nodes[oldParent].right = newParent;
+        }
+        nodes[sibling].parent = newParent;
+        nodes[leaf].parent = newParent;
+        refitFrom(newParent);
+    }
+
+    void removeLeaf(std::uint32_t leaf) {
+        if (leaf == root) {
+            root = NONE;
+            return;
+        }
+        const std::uint32_t parent = nodes[leaf].parent;
+        const std::uint32_t grandParent = nodes[parent].parent;
+        const std::uint32_t sibling = nodes[parent].left == leaf ? nodes[parent].right : nodes[parent].left;
+        freeNode(parent);
+        nodes[sibling].parent = grandParent;
+        if (grandParent == NONE) {
+            root = sibling;
+            return;
+        }
+        if (nodes[grandParent].left == parent) {
+            nodes[grandParent].left = sibling;
+        }
+        else {
+            nodes[grandParent].right = sibling;
+        }
+        refitFrom(grandParent);
+    }
+
+    // Rebalances and refits index and everything above it
+    void refitFrom(std::uint32_t index) {
+        while (index != NONE) {
+            index = balance(index);
+            Node& node = nodes[index];
+            node.height = 1 + std::max(nodes[node.left].height, nodes[node.right].height);
+            node.box = combine(nodes[node.left].box, nodes[node.right].box);
+            index = node.parent;
+        }
+    }
+
+    // If one side of a is two or more levels taller than the other, lifts that side's root into
+    // a's place, with a taking the shorter of its children. Returns the subtree's new root
+    std::uint32_t balance(std::uint32_t a) {
+        if (nodes[a].isLeaf() || nodes[a].height < 2) {
+            return a;
+        }
+        const std::uint32_t b = nodes[a].left;
+        const std::uint32_t c = nodes[a].right;
+        const int lean = nodes[c].height - nodes[b].height;
+        if (lean > 1) {
+            return rotateUp(a, c, b, false);
+        }
+        if (lean < -1) {
+            return rotateUp(a, b, c, true);
+        }
+        return a;
+    }
+
+    // Puts up, the taller child of a, in a's place. a keeps other, its shorter child, and takes
+    // the shorter of up's children in place of up, where fromLeft says which side up was on
+    std::uint32_t rotateUp(std::uint32_t a, std::uint32_t up, std::uint32_t other, bool fromLeft) {
+        const std::uint32_t f = nodes[up].left;
+        const std::uint32_t g = nodes[up].right;
+        const std::uint32_t parent = nodes[a].parent;
+        nodes[up].left = a;
+        nodes[up].parent = parent;
+        nodes[a].parent = up;
+        if (parent == NONE) {
+            root = up;
+        }
+        else if (nodes[parent].left == a) {
+            nodes[parent].left = up;
+        }
+        else {
+            nodes[parent].right = up;
+        }
+
+        const bool keepF = nodes[f].height > nodes[g].height;
+        const std::uint32_t kept = keepF ? f : g;
+        const std::uint32_t given = keepF ? g : f;
+        nodes[up].right = kept;
+        if (fromLeft) {
+            nodes[a].left = given;
+        }
+        else {
+            nodes[a].right = given;
+        }
+        nodes[given].parent = a;
+        nodes[a].box = combine(nodes[other].box, nodes[given].box);
+        nodes[a].height = 1 + std::max(nodes[other].height, nodes[given].height);
+        nodes[up].box = combine(nodes[a].box, nodes[kept].box);
+        nodes[up].height = 1 + std::max(nodes[a].height, nodes[kept].height);
+        return up;
+    }
+};
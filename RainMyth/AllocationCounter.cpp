@@ -0,0 +1,117 @@
+#include "AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace {
+
+std::atomic<std::uint64_t> allocations(0);
+
+#if defined(RAINMYTH_TRACK_ALLOCATIONS)
+
+// Zone 0 is everything outside a zone. The rest are claimed by name the first time a zone is
+// entered and never given up, so a zone keeps its index for the whole run
+std::atomic<const char*> zoneNames[MAX_ALLOCATION_ZONES];
+std::atomic<std::uint64_t> zoneCounts[MAX_ALLOCATION_ZONES];
+thread_local std::size_t currentZone = 0;
+
+const char* const OUTSIDE_ZONES = "(outside any zone)";
+const char* const REPORT_ZONE = "Allocation report";
+
+// The same name may be a different literal in each file, so names are compared by contents.
+// Zones past the last slot are counted as outside any
+std::size_t zoneIndex(const char* name) {
+    for (std::size_t i = 1; i < MAX_ALLOCATION_ZONES; ++i) {
+        const char* claimed = zoneNames[i].load(std::memory_order_acquire);
+        if (claimed == nullptr && zoneNames[i].compare_exchange_strong(claimed, name, std::memory_order_acq_rel)) {
+            return i;
+        }
+        if (std::strcmp(claimed, name) == 0) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+#endif
+
+} // namespace
+
+std::uint64_t allocationCount() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+#if defined(RAINMYTH_TRACK_ALLOCATIONS)
+
+AllocationZone::AllocationZone(const char* name)
+    : previous(currentZone) {
+    currentZone = zoneIndex(name);
+}
+
+AllocationZone::~AllocationZone() {
+    currentZone = previous;
+}
+
+ZoneAllocationWatch::ZoneAllocationWatch() {
+    for (std::size_t i = 0; i < MAX_ALLOCATION_ZONES; ++i) {
+        last[i] = 0;
+        settledTotal[i] = 0;
+    }
+}
+
+void ZoneAllocationWatch::endFrame(bool settled, std::ostream& out) {
+    const AllocationZone zone(REPORT_ZONE);
+    for (std::size_t i = 0; i < MAX_ALLOCATION_ZONES; ++i) {
+        const std::uint64_t count = zoneCounts[i].load(std::memory_order_relaxed);
+        const char* name = i > 0 ? zoneNames[i].load(std::memory_order_acquire) : OUTSIDE_ZONES;
+        const std::uint64_t added = count - last[i];
+        last[i] = count;
+        if (!settled || added == 0 || name == nullptr || std::strcmp(name, REPORT_ZONE) == 0) {
+            continue;
+        }
+        if (settledTotal[i] == 0) {
+            out << "Allocation in a steady frame: " << added << " in " << name << std::endl;
+        }
+        settledTotal[i] += added;
+    }
+}
+
+void ZoneAllocationWatch::print(std::ostream& out) const {
+    for (std::size_t i = 0; i < MAX_ALLOCATION_ZONES; ++i) {
+        if (settledTotal[i] > 0) {
+            out << "  " << (i > 0 ? zoneNames[i].load(std::memory_order_acquire) : OUTSIDE_ZONES) << ": "
+                << settledTotal[i] << " allocations" << std::endl;
+        }
+    }
+}
+
+#endif
+
+// The library's array and nothrow forms call this one and its other deletes call these, so
+// replacing them counts every allocation made through new
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+#if defined(RAINMYTH_TRACK_ALLOCATIONS)
+    zoneCounts[currentZone].fetch_add(1, std::memory_order_relaxed);
+#endif
+    for (;;) {
+        if (void* memory = std::malloc(size > 0 ? size : 1)) {
+            return memory;
+        }
+        const std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
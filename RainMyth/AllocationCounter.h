@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include "Constants.h"
+
+// Calls to the global operator new since the program started, counted by the replacement in
+// AllocationCounter.cpp. Only the difference between two reads means anything
+std::uint64_t allocationCount();
+
+#if defined(RAINMYTH_TRACK_ALLOCATIONS)
+
+// Counts the calling thread's allocations against name while it lives, instead of against
+// the zone it was made in. RAINMYTH_ZONE makes one in tracking builds, so every profiler zone
+// is also an allocation zone; allocations made outside any are counted together
+class AllocationZone {
+public:
+    explicit AllocationZone(const char* name);
+    ~AllocationZone();
+
+    AllocationZone(const AllocationZone&) = delete;
+    AllocationZone& operator=(const AllocationZone&) = delete;
+
+private:
+    std::size_t previous;
+};
+
+// Checks once a frame which zones allocated since the last check. Once the loop has settled,
+// each zone that still allocates is named on the first frame it does, and the totals since
+// settling are kept for the report at exit. The check itself runs in a zone of its own that
+// isn't reported, since printing may allocate
+class ZoneAllocationWatch {
+public:
+    ZoneAllocationWatch();
+
+    void endFrame(bool settled, std::ostream& out);
+
+    // Every zone that allocated after settling, with how often. Nothing if none did
+    void print(std::ostream& out) const;
+
+private:
+    std::uint64_t last[MAX_ALLOCATION_ZONES];
+    std::uint64_t settledTotal[MAX_ALLOCATION_ZONES];
+};
+
+#endif
@@ -0,0 +1,43 @@
+#include "Analytic.h"
+
+#include "DropSizes.h"
+#include "TerminalVelocity.h"
+
+namespace {
+
+// Sizes averaged over, evenly spaced in probability across the size distribution
+const int ANALYTIC_SIZE_SAMPLES = 64;
+
+} // namespace
+
+WetnessEstimate estimateWetness(const AnalyticParams& p) {
+    // Drops are size x 2*size rectangles with size drawn from the size model. A drop touches
+    // the person when its rectangle overlaps theirs, so for a drop of size s the person is
+    // effectively s wider and 2s taller. Average each surface's catch over the sizes
+    RainConfig model;
+    model.minSize = p.minSize;
+    model.maxSize = p.maxSize;
+    model.sizeModel = p.sizeModel;
+    model.rainIntensity = p.rainIntensity;
+    const DropSizeTable sizes(model);
+    float topPerDrop = 0.0f;   // Area times catching width
+    float frontPerDrop = 0.0f; // Area times catching height over fall speed
+    for (int i = 0; i < ANALYTIC_SIZE_SAMPLES; ++i) {
+        const float s = sizes.lookup((i + 0.5f) / ANALYTIC_SIZE_SAMPLES);
+        const float area = 2.0f * s * s;
+        topPerDrop += area * (p.personWidth + s);
+        frontPerDrop += area * (p.personHeight + 2.0f * s) / terminalSpeed(s);
+    }
+    topPerDrop /= ANALYTIC_SIZE_SAMPLES;
+    frontPerDrop /= ANALYTIC_SIZE_SAMPLES;
+
+    const float crossingTime = p.distance / p.speed;
+
+    WetnessEstimate estimate;
+    // Drops cross any horizontal line at spawnRate per pixel per second
+    estimate.top = p.spawnRate * crossingTime * topPerDrop;
+    // Drops of speed v hang in the air at density spawnRate / v. Sweeping the person's height
+    // through that for the whole distance doesn't depend on the crossing speed at all
+    estimate.front = p.spawnRate * p.distance * frontPerDrop;
+    return estimate;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "RainConfig.h"
+
+// Inputs to the flux model, all in simulation units (pixels, seconds)
+struct AnalyticParams {
+    float spawnRate;  // Drops per second per pixel of width
+    float minSize;    // Drop sizes are drawn from sizeModel in [minSize, maxSize]
+    float maxSize;
+    DropSizeModel sizeModel;
+    float rainIntensity;
+    float personTop;  // Top edge of the person while crossing
+    float personWidth;
+    float personHeight;
+    float speed;      // Crossing speed
+    float distance;   // Length of the crossing
+};
+
+// Expected wetness of one crossing, split by the surface that caught the rain
+struct WetnessEstimate {
+    float top;   // Rain landing on the head and shoulders
+    float front; // Rain walked into
+    float total() const {
+        return top + front;
+    }
+};
+
+// Closed-form expected wetness of a straight crossing at constant speed through steady rain,
+// counting each drop's area once when it first touches the person. The top surface sweeps
+// through rain falling at the spawn rate for the crossing time, so it shrinks with speed. The
+// front sweeps each column of air once whatever the speed, catching every drop that falls
+// through the person's height while passing it, so slow drops count for more. Drops fall at
+// terminalSpeed() for their size. Sheltering by platforms isn't modelled
+WetnessEstimate estimateWetness(const AnalyticParams& params);
@@ -0,0 +1,167 @@
+#include "AssetPack.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+#include <vector>
+
+namespace {
+
+const char ASSET_PACK_MAGIC[4] = { 'R', 'M', 'A', 'P' };
+const std::uint32_t ASSET_PACK_VERSION = 1;
+const std::uint64_t ASSET_PACK_ALIGNMENT = 16;
+
+struct AssetPackHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t entryCount;
+    std::uint32_t entrySize; // sizeof(AssetPackEntry) when written
+};
+
+bool entryBefore(const AssetPackEntry& entry, const std::string& name) {
+    return std::strncmp(entry.name, name.c_str(), ASSET_NAME_LENGTH) < 0;
+}
+
+} // namespace
+
+AssetPack::AssetPack() : entries(nullptr), entryCount(0) {}
+
+bool AssetPack::open(const std::string& path) {
+    entries = nullptr;
+    entryCount = 0;
+    if (!file.open(path)) {
+        std::cerr << "Couldn't open asset pack " << path << std::endl;
+        return false;
+    }
+
+    // The table and every file it lists have to be inside the pack, and the names terminated
+    const unsigned char* data = file.data();
+    const std::size_t bytes = file.size();
+    AssetPackHeader header;
+    bool valid = bytes >= sizeof(header);
+    if (valid) {
+        std::memcpy(&header, data, sizeof(header));
+        valid = std::memcmp(header.magic, ASSET_PACK_MAGIC, sizeof(ASSET_PACK_MAGIC)) == 0 && header.version == ASSET_PACK_VERSION
+            && header.entrySize == sizeof(AssetPackEntry) && header.entryCount <= (bytes - sizeof(header)) / sizeof(AssetPackEntry);
+    }
+    const AssetPackEntry* table = reinterpret_cast<const AssetPackEntry*>(data + sizeof(header));
+    for (std::uint32_t i = 0; valid && i < header.entryCount; ++i) {
+        const AssetPackEntry& entry = table[i];
+        valid = entry.name[ASSET_NAME_LENGTH - 1] == '\0' && entry.offset <= bytes && entry.size <= bytes - entry.offset
+            && (i == 0 || std::strncmp(table[i - 1].name, entry.name, ASSET_NAME_LENGTH) < 0);
+    }
+    if (!valid) {
+        std::cerr << path << " isn't an asset pack this build can read" << std::endl;
+        file.close();
+        return false;
+    }
+    entries = table;
+    entryCount = header.entryCount;
+    return true;
+}
+
+bool AssetPack::find(const std::string& name, AssetData& found) const {
+    const AssetPackEntry* end = entries + entryCount;
+    const AssetPackEntry* entry = std::lower_bound(entries, end, name, entryBefore);
+    if (entry == end || name.size() >= ASSET_NAME_LENGTH || std::strncmp(entry->name, name.c_str(), ASSET_NAME_LENGTH) != 0) {
+        return false;
+    }
+    found.data = file.data() + entry->offset;
+    found.size = static_cast<std::size_t>(entry->size);
+    return true;
+}
+
+bool writeAssetPack(const std::string& root, const std::string& path) {
+    std::error_code error;
+    std::vector<AssetPackEntry> table;
+    std::vector<std::filesystem::path> files;
+    for (std::filesystem::recursive_directory_iterator it(root, error), end; !error && it != end; it.increment(error)) {
+        if (!it->is_regular_file()) {
+            continue;
+        }
+        const std::string name = std::filesystem::relative(it->path(), root).generic_string();
+        if (name.size() >= ASSET_NAME_LENGTH) {
+            std::cerr << "Asset " << name << " has a name too long to pack, leaving it out" << std::endl;
+            continue;
+        }
+        AssetPackEntry entry = AssetPackEntry();
+        std::memcpy(entry.name, name.c_str(), name.size());
+        entry.size = it->file_size();
+        table.push_back(entry);
+        files.push_back(it->path());
+    }
+    if (error) {
+        std::cerr << "Couldn't list the assets in " << root << std::endl;
+        return false;
+    }
+
+    std::vector<std::size_t> order(table.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return std::strncmp(table[a].name, table[b].name, ASSET_NAME_LENGTH) < 0;
+    });
+    std::vector<AssetPackEntry> sorted(table.size());
+    std::uint64_t offset = sizeof(AssetPackHeader) + sorted.size() * sizeof(AssetPackEntry);
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        offset = (offset + ASSET_PACK_ALIGNMENT - 1) / ASSET_PACK_ALIGNMENT * ASSET_PACK_ALIGNMENT;
+        sorted[i] = table[order[i]];
+        sorted[i].offset = offset;
+        offset += sorted[i].size;
+    }
+
+    std::ofstream out(path, std::ios::binary);
+    AssetPackHeader header;
+    std::memcpy(header.magic, ASSET_PACK_MAGIC, sizeof(ASSET_PACK_MAGIC));
+    header.version = ASSET_PACK_VERSION;
+    header.entryCount = static_cast<std::uint32_t>(sorted.size());
+    header.entrySize = sizeof(AssetPackEntry);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(sorted.data()), sorted.size() * sizeof(AssetPackEntry));
+    std::vector<char> contents;
+    for (std::size_t i = 0; i < order.size() && out; ++i) {
+        std::ifstream in(files[order[i]], std::ios::binary);
+        contents.assign(static_cast<std::size_t>(sorted[i].size), '\0');
+        if (!in.read(contents.data(), contents.size())) {
+            std::cerr << "Couldn't read asset " << files[order[i]].string() << std::endl;
+            return false;
+        }
+        const std::uint64_t at = static_cast<std::uint64_t>(out.tellp());
+        out.write(std::string(static_cast<std::size_t>(sorted[i].offset - at), '\0').data(), sorted[i].offset - at);
+        out.write(contents.data(), contents.size());
+    }
+    if (!out) {
+        std::cerr << "Couldn't write asset pack " << path << std::endl;
+        return false;
+    }
+    std::cout << "Packed " << sorted.size() << " assets, " << offset << " bytes, into " << path << std::endl;
+    return true;
+}
+
+AssetPack& assets() {
+    static AssetPack pack;
+    return pack;
+}
+
+std::string assetName(const std::string& path) {
+    std::string name = path;
+    std::replace(name.begin(), name.end(), '\\', '/');
+    const char prefix[] = "Assets/";
+    if (name.compare(0, sizeof(prefix) - 1, prefix) == 0) {
+        name.erase(0, sizeof(prefix) - 1);
+    }
+    return name;
+}
+
+std::istream& openText(const std::string& path, std::istringstream& packed, std::ifstream& loose) {
+    AssetData found;
+    if (assets().isOpen() && assets().find(assetName(path), found)) {
+        packed.str(std::string(reinterpret_cast<const char*>(found.data), found.size));
+        return packed;
+    }
+    loose.open(path);
+    return loose;
+}
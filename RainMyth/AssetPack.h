@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "MappedFile.h"
+
+const std::size_t ASSET_NAME_LENGTH = 56; // Longest packed name, terminator included
+
+// One file in a pack, as the table at its start lists it
+struct AssetPackEntry {
+    char name[ASSET_NAME_LENGTH]; // Path below the packed directory, with forward slashes
+    std::uint64_t offset;         // From the start of the pack
+    std::uint64_t size;
+};
+
+// Bytes of one packed file, pointing into the pack's mapping
+struct AssetData {
+    const unsigned char* data;
+    std::size_t size;
+};
+
+// Every asset in one file, opened once and kept mapped, so starting up costs one open however
+// many assets there are; pass what find() gives to sf::Texture::loadFromMemory and the like.
+// The table of entries sits after a small header, sorted by name, and each file's bytes are
+// aligned after it. Whatever format each asset is in, PNG or DDS, is stored as it is
+class AssetPack {
+public:
+    AssetPack();
+
+    // Maps the pack at path and checks its table. Problems are reported on stderr; returns
+    // false, leaving the pack empty, if it isn't a pack this build can read
+    bool open(const std::string& path);
+
+    bool isOpen() const {
+        return entryCount > 0;
+    }
+
+    // The packed file under name, as assetName gives it. Returns false if there's none
+    bool find(const std::string& name, AssetData& found) const;
+
+private:
+    MappedFile file;
+    const AssetPackEntry* entries;
+    std::uint32_t entryCount;
+};
+
+// Packs every file below root into a pack at path. Problems are reported on stderr; returns
+// false if it couldn't be written
+bool writeAssetPack(const std::string& root, const std::string& path);
+
+// The pack --assets opened for the run, empty without one
+AssetPack& assets();
+
+// The name a path is packed under: separators forward and a leading "Assets/" dropped, so
+// "Assets\Scenes\Shelters.txt" finds what packing the Assets directory stored
+std::string assetName(const std::string& path);
+
+// Opens the text at path, from the open pack if it has it and from disk otherwise, in
+// whichever of the two streams fits, and returns it
+std::istream& openText(const std::string& path, std::istringstream& packed, std::ifstream& loose);
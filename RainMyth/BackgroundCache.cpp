@@ -0,0 +1,53 @@
+#include "BackgroundCache.h"
+
+#include <iostream>
+
+#include "SfmlCompat.h"
+
+namespace {
+
+bool sameView(const sf::View& a, const sf::View& b) {
+    return a.getCenter() == b.getCenter() && a.getSize() == b.getSize() && a.getRotation() == b.getRotation()
+        && a.getViewport() == b.getViewport();
+}
+
+} // namespace
+
+BackgroundCache::BackgroundCache(sf::Color background)
+    : background(background), size(0, 0), valid(false), failed(false) {}
+
+void BackgroundCache::draw(sf::RenderTarget& target, const Scene& scene) {
+    if (!failed && (!valid || target.getSize() != size || !sameView(target.getView(), view))) {
+        render(target, scene);
+    }
+    if (failed) {
+        target.clear(background);
+        sceneDrawing.draw(target, scene);
+        return;
+    }
+
+    // Opaque and unblended, so the quad overwrites the last frame without reading it back
+    const sf::View shown = target.getView();
+    target.setView(target.getDefaultView());
+    target.draw(sf::Sprite(texture->getTexture()), sf::RenderStates(sf::BlendNone));
+    target.setView(shown);
+}
+
+void BackgroundCache::render(sf::RenderTarget& target, const Scene& scene) {
+    size = target.getSize();
+    view = target.getView();
+    if (!texture) {
+        texture.reset(new sf::RenderTexture());
+    }
+    if (!createRenderTexture(*texture, size)) {
+        std::cerr << "Couldn't create the background texture, redrawing the scene every frame" << std::endl;
+        texture.reset();
+        failed = true;
+        return;
+    }
+    texture->setView(view);
+    texture->clear(background);
+    sceneDrawing.draw(*texture, scene);
+    texture->display();
+    valid = true;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <memory>
+
+#include "MemoryUsage.h"
+#include "Scene.h"
+#include "SceneDrawing.h"
+
+// Everything drawn behind the rain that doesn't move, the cleared background and the scene's
+// colliders, rendered once into a texture the size of the target and put back each frame as
+// one opaque quad. That's a single write per pixel instead of a clear plus every layer's
+// fill, which is what bounds the frame on fill-rate-limited GPUs. The texture is redrawn when
+// the target's size or view changes or after invalidate(); until it can be created, draw()
+// falls back to clearing and drawing the scene directly
+class BackgroundCache {
+public:
+    BackgroundCache(sf::Color background);
+
+    // Call after changing the scene
+    void invalidate() {
+        valid = false;
+    }
+
+    // Replaces whatever target held with the background and the scene, as seen through the
+    // target's current view
+    void draw(sf::RenderTarget& target, const Scene& scene);
+
+    MemoryUsage memoryUsage() const {
+        const std::size_t bytes = texture ? static_cast<std::size_t>(size.x) * size.y * 4 : 0;
+        const MemoryUsage usage = { bytes, bytes };
+        return usage;
+    }
+
+private:
+    std::unique_ptr<sf::RenderTexture> texture;
+    SceneDrawing sceneDrawing;
+    sf::Color background;
+    sf::Vector2u size;
+    sf::View view;   // The target's view the texture was drawn through
+    bool valid;
+    bool failed;     // Couldn't create the texture, so draw() won't try again
+
+    void render(sf::RenderTarget& target, const Scene& scene);
+};
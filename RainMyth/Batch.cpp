@@ -0,0 +1,103 @@
+#include "Batch.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "Headless.h"
+#include "Scene.h"
+
+namespace {
+
+// Reads one line's keys over crossing. seeded says whether it gave a seed. False, with a
+// message on stderr, on a key it doesn't know or a value it can't use
+bool parseTrial(const std::string& line, const std::string& where, Crossing& crossing, bool& seeded) {
+    std::istringstream fields(line);
+    std::string key;
+    seeded = false;
+    while (fields >> key) {
+        if (key == "seed") {
+            unsigned long long seed = 0;
+            if (!(fields >> seed)) {
+                std::cerr << where << ": expected a seed after seed" << std::endl;
+                return false;
+            }
+            crossing.rain.seed = seed;
+            seeded = true;
+            continue;
+        }
+        float* target = nullptr;
+        if (key == "speed") {
+            target = &crossing.speed;
+        }
+        else if (key == "spawn-rate") {
+            target = &crossing.rain.spawnRate;
+        }
+        else if (key == "person-width") {
+            target = &crossing.personWidth;
+        }
+        else if (key == "person-height") {
+            target = &crossing.personHeight;
+        }
+        float value = 0.0f;
+        if (target == nullptr || !(fields >> value) || value < 0.0f) {
+            std::cerr << where << ": expected a known key and a value of 0 or more" << std::endl;
+            return false;
+        }
+        *target = value;
+    }
+    return true;
+}
+
+} // namespace
+
+int runBatch(const Options& options, IntegrateKernel integrate, JobSystem& jobs) {
+    std::ifstream file;
+    const bool fromStdin = options.batchPath == "-";
+    if (!fromStdin) {
+        file.open(options.batchPath);
+        if (!file) {
+            std::cerr << "Couldn't open " << options.batchPath << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    std::istream& in = fromStdin ? std::cin : file;
+    const std::string name = fromStdin ? std::string("stdin") : options.batchPath;
+
+    const Scene scene = loadScene(options.scenePath, sf::Vector2u(options.width, options.height));
+    TrialRunner runner(options, scene, integrate, jobs);
+    Crossing crossing;
+    crossing.rain = options.rain;
+    crossing.personWidth = options.scenario.personWidth;
+    crossing.personHeight = options.scenario.personHeight;
+    crossing.speed = options.scenario.walkSpeed;
+
+    std::cout << "trial,seed,speed,spawn_rate,person_width,person_height,wetness,wetness_top,wetness_front,wetness_back,seconds" << std::endl;
+    const auto started = std::chrono::steady_clock::now();
+    std::size_t trials = 0;
+    std::string line;
+    for (int lineNumber = 1; std::getline(in, line); ++lineNumber) {
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue; // Blank or comment
+        }
+        bool seeded = false;
+        if (!parseTrial(line, name + ":" + std::to_string(lineNumber), crossing, seeded)) {
+            return EXIT_FAILURE;
+        }
+        const auto trialStarted = std::chrono::steady_clock::now();
+        SurfaceWetness split;
+        const float wetness = runner.run(crossing, trials > 0 && !seeded, &split);
+        const std::chrono::duration<double> trialTime = std::chrono::steady_clock::now() - trialStarted;
+        std::cout << trials << "," << crossing.rain.seed << "," << crossing.speed << "," << crossing.rain.spawnRate << ","
+            << crossing.personWidth << "," << crossing.personHeight << "," << wetness << "," << split.top << ","
+            << split.front << "," << split.back << "," << trialTime.count() << std::endl;
+        ++trials;
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+    std::cerr << "Ran " << trials << " trials in " << elapsed.count() << " s" << std::endl;
+    return 0;
+}
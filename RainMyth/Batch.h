@@ -0,0 +1,22 @@
+#pragma once
+
+#include "JobSystem.h"
+#include "Options.h"
+#include "RainKernels.h"
+
+// Runs trial after trial in one long-lived TrialRunner, see Headless.h, reading them from
+// options.batchPath, or standard input for "-", as they arrive. Each line is one trial, as
+// "key value" pairs with # comments, with any of these keys:
+//
+//   seed           rain to cross, drawn afresh and warmed up
+//   speed          pixels per second
+//   spawn-rate     drops per second per pixel of width
+//   person-width   pixels
+//   person-height  pixels
+//
+// Keys a line leaves out keep the last line's values, starting from the options. A line
+// without a seed carries on in the rain the last trial left instead of starting over, as long
+// as the spawn rate and person size haven't changed, so back-to-back crossings of a long
+// storm skip the warm-up too. Writes a CSV row per trial to standard output as it finishes.
+// Returns the process exit code
+int runBatch(const Options& options, IntegrateKernel integrate, JobSystem& jobs);
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A priority queue for items due at known times, bucketed by time on a wheel. Each bucket
+// covers bucketWidth seconds and the wheel covers bucketCount of them ahead of the present, so
+// push is an append and popping a step's worth of items visits only that step's buckets: both
+// O(1) amortized however many items are waiting, where a binary heap is O(log N) per item.
+// Items due further ahead than the wheel wait in an overflow list until it comes round.
+//
+// Items are handed out in time order to the resolution of a bucket, and in the order they
+// were pushed within one. Sized so a bucket is about one step, that is all a fixed-step
+// simulation can tell apart anyway
+template <typename T>
+class CalendarQueue {
+public:
+    // bucketCount is rounded up to a power of two
+    CalendarQueue(double bucketWidth, std::size_t bucketCount)
+        : width(bucketWidth), current(0), items(0) {
+        std::size_t count = 1;
+        while (count < bucketCount) {
+            count *= 2;
+        }
+        buckets.resize(count);
+        mask = count - 1;
+    }
+
+    // Schedules item for time. Times already in the past go in the bucket popped next
+    void push(double time, const T& item) {
+        std::uint64_t index = bucketOf(time);
+        if (index < current) {
+            index = current;
+        }
+        const Entry entry = { time, item };
+        if (index - current > mask) {
+            overflow.push_back(entry);
+        }
+        else {
+            buckets[index & mask].push_back(entry);
+        }
+        ++items;
+    }
+
+    // Removes every item due at or before time and calls visit(item) for each
+    template <typename Visit>
+    void popUntil(double time, Visit visit) {
+        const std::uint64_t last = bucketOf(time);
+        while (current < last) {
+            std::vector<Entry>& bucket = buckets[current & mask];
+            for (const Entry& entry : bucket) {
+                visit(entry.item);
+            }
+            items -= bucket.size();
+            bucket.clear();
+            ++current;
+            refill();
+        }
+
+        // The bucket time falls in is due only up to time; the rest of it stays
+        std::vector<Entry>& bucket = buckets[current & mask];
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < bucket.size(); ++i) {
+            if (bucket[i].time <= time) {
+                visit(bucket[i].item);
+            }
+            else {
+                bucket[kept++] = bucket[i];
+            }
+        }
+        items -= bucket.size() - kept;
+        bucket.resize(kept);
+    }
+
+    std::size_t size() const {
+        return items;
+    }
+
+    bool empty() const {
+        return items == 0;
+    }
+
+private:
+    struct Entry {
+        double time;
+        T item;
+    };
+
+    double width;
+    std::vector<std::vector<Entry>> buckets;
+    std::uint64_t mask;
+    std::uint64_t current;        // Bucket the present falls in; no earlier one holds anything
+    std::vector<Entry> overflow;  // Items too far ahead for the wheel
+    std::size_t items;
+
+    std::uint64_t bucketOf(double time) const {
+        return time > 0.0 ? static_cast<std::uint64_t>(std::floor(time / width)) : 0;
+    }
+
+    // Moves the overflow items the wheel now reaches into their buckets. They were all ahead
+    // of it when pushed, so none is behind it now
+    void refill() {
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < overflow.size(); ++i) {
+            const std::uint64_t index = bucketOf(overflow[i].time);
+            if (index - current <= mask) {
+                buckets[index & mask].push_back(overflow[i]);
+            }
+            else {
+                overflow[kept++] = overflow[i];
+            }
+        }
+        overflow.resize(kept);
+    }
+};
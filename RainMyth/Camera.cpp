@@ -0,0 +1,51 @@
+#include "Camera.h"
+
+#include <algorithm>
+
+#include "Constants.h"
+#include "SfmlCompat.h"
+#include "WorldView.h"
+
+Camera::Camera(sf::Vector2u world)
+    : world(world), zoomLevel(1.0f), centre(this->world / 2.0f), following(true) {}
+
+void Camera::zoom(float factor) {
+    zoomLevel = std::min(std::max(zoomLevel * factor, CAMERA_MIN_ZOOM), CAMERA_MAX_ZOOM);
+}
+
+void Camera::pan(sf::Vector2f fraction) {
+    following = false;
+    centre.x += fraction.x * world.x / zoomLevel;
+    centre.y += fraction.y * world.y / zoomLevel;
+}
+
+void Camera::reset() {
+    zoomLevel = 1.0f;
+    centre = world / 2.0f;
+    following = true;
+}
+
+sf::View Camera::view(sf::Vector2u target, sf::Vector2f focus) {
+    sf::View shown = worldView(sf::Vector2u(world), target);
+    const sf::Vector2f size = world / zoomLevel;
+    if (following) {
+        centre = focus;
+    }
+
+    // Zoomed out, the world sits in the middle; zoomed in, the view is kept inside it
+    if (zoomLevel <= 1.0f) {
+        centre = world / 2.0f;
+    }
+    else {
+        centre.x = std::min(std::max(centre.x, size.x / 2.0f), world.x - size.x / 2.0f);
+        centre.y = std::min(std::max(centre.y, size.y / 2.0f), world.y - size.y / 2.0f);
+    }
+    shown.setSize(size);
+    shown.setCenter(centre);
+    return shown;
+}
+
+float Camera::pixelsPerUnit(sf::Vector2u target) const {
+    const sf::View shown = worldView(sf::Vector2u(world), target);
+    return target.x * rectWidth(shown.getViewport()) * zoomLevel / world.x;
+}
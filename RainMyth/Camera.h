@@ -0,0 +1,43 @@
+#pragma once
+
+#include <SFML/Graphics/View.hpp>
+
+// What the window looks at. Zoom 1 shows the whole world, as worldView() does; zooming in
+// shows less of it, larger, and zooming out shows the world smaller in the middle of the
+// window. While following, the view is centred on the point given to view(), normally the
+// person, so zooming in closes in on them; panning lets go of it until follow() or reset().
+// However far in, the view never leaves the world
+class Camera {
+public:
+    explicit Camera(sf::Vector2u world);
+
+    // Multiplies the zoom by factor, within CAMERA_MIN_ZOOM and CAMERA_MAX_ZOOM
+    void zoom(float factor);
+
+    // Moves the view by these fractions of its size and stops following
+    void pan(sf::Vector2f fraction);
+
+    void follow() {
+        following = true;
+    }
+
+    // Back to the whole world, following
+    void reset();
+
+    float getZoom() const {
+        return zoomLevel;
+    }
+
+    // The view for a target of this size, centred on focus while following. The viewport is
+    // worldView's, so the world keeps its shape
+    sf::View view(sf::Vector2u target, sf::Vector2f focus);
+
+    // Screen pixels a world unit covers in that view
+    float pixelsPerUnit(sf::Vector2u target) const;
+
+private:
+    sf::Vector2f world;
+    float zoomLevel;
+    sf::Vector2f centre; // Where the view was last centred
+    bool following;
+};
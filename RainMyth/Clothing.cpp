@@ -0,0 +1,56 @@
+#include "Clothing.h"
+
+#include <cmath>
+
+namespace {
+
+// Soaks caught into a face holding held of capacity, and returns what ran off
+float soakFace(float& held, float capacity, float caught) {
+    if (caught <= 0.0f) {
+        return 0.0f;
+    }
+    const float before = held;
+    held = capacity - (capacity - held) * std::exp(-caught / capacity);
+    return caught - (held - before);
+}
+
+} // namespace
+
+Clothing::Clothing(float capacity) : capacity(capacity) {}
+
+std::size_t Clothing::addPerson(float width, float height) {
+    topCapacity.push_back(capacity * width);
+    sideCapacity.push_back(capacity * height);
+    top.push_back(0.0f);
+    front.push_back(0.0f);
+    back.push_back(0.0f);
+    ranOff.push_back(0.0f);
+    return topCapacity.size() - 1;
+}
+
+void Clothing::setSize(std::size_t person, float width, float height) {
+    topCapacity[person] = capacity * width;
+    sideCapacity[person] = capacity * height;
+}
+
+void Clothing::soak(const SurfaceWetness* caught) {
+    for (std::size_t i = 0; i < topCapacity.size(); ++i) {
+        const float spilt = soakFace(top[i], topCapacity[i], caught[i].top) / 2.0f;
+        ranOff[i] += soakFace(front[i], sideCapacity[i], caught[i].front + spilt);
+        ranOff[i] += soakFace(back[i], sideCapacity[i], caught[i].back + spilt);
+    }
+}
+
+void Clothing::reset() {
+    for (std::size_t i = 0; i < topCapacity.size(); ++i) {
+        top[i] = 0.0f;
+        front[i] = 0.0f;
+        back[i] = 0.0f;
+        ranOff[i] = 0.0f;
+    }
+}
+
+SurfaceWetness Clothing::held(std::size_t person) const {
+    const SurfaceWetness split = { top[person], front[person], back[person] };
+    return split;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "SurfaceWetness.h"
+
+// What people's clothes keep of the rain they catch, with the total caught being only what
+// reached them. Each face holds at most its capacity, the clothing capacity per pixel of the
+// face's edge, and soaks up a share of what reaches it that shrinks as it fills: held water h
+// grows as dh = (1 - h / capacity) dc with the catch c, and the rest runs off. What runs off the
+// top runs down the front and back, half each, and soaks into them the same way.
+//
+// That integrates exactly, to h = capacity - (capacity - h0) * exp(-c / capacity) over a catch
+// c, so the water held after any number of steps is what one step with their whole catch
+// would give: it depends on what was caught and not on how the time was cut up. Everyone is
+// kept in flat arrays, a face to an array, and a step is a few exps per person
+class Clothing {
+public:
+    explicit Clothing(float capacity);
+
+    // Adds someone width by height, dry, and returns their index
+    std::size_t addPerson(float width, float height);
+
+    // Resizes person's faces. Clothes holding more than they now can lose the rest as they next soak
+    void setSize(std::size_t person, float width, float height);
+
+    // Soaks each person's catch of a step, caught[i] for person i, into their clothes
+    void soak(const SurfaceWetness* caught);
+
+    // Dries everyone
+    void reset();
+
+    // Water person holds, by face
+    SurfaceWetness held(std::size_t person) const;
+
+    // Water that has run off person so far
+    float runoff(std::size_t person) const {
+        return ranOff[person];
+    }
+
+    std::size_t size() const {
+        return topCapacity.size();
+    }
+
+private:
+    float capacity;
+    std::vector<float> topCapacity;
+    std::vector<float> sideCapacity;
+    std::vector<float> top;
+    std::vector<float> front;
+    std::vector<float> back;
+    std::vector<float> ranOff;
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+#include "MemoryUsage.h"
+
+// Uniform-grid broadphase over the drop store. Drops are binned by the cell holding their
+// top-left corner with a counting sort, so a build is two linear passes and never allocates
+// once the arrays have grown. Queries then only visit the cells a rectangle overlaps.
+// The grid also keeps a per-cell bitmask of the colliders covering each cell, so a single
+// pass over the drops can skip every collider test with one lookup outside occupied cells
+class CollisionGrid {
+public:
+    CollisionGrid(float originX, float originY, float width, float height, float cellSize)
+        : originX(originX), originY(originY), invCellSize(1.0f / cellSize) {
+        columns = std::max(1, static_cast<int>(width * invCellSize) + 1);
+        rows = std::max(1, static_cast<int>(height * invCellSize) + 1);
+        cellStart.assign(static_cast<std::size_t>(columns) * rows + 1, 0);
+        colliderMasks.assign(static_cast<std::size_t>(columns) * rows, 0);
+    }
+
+    void clearColliders() {
+        std::fill(colliderMasks.begin(), colliderMasks.end(), 0);
+    }
+
+    // Sets bit (1 << id) in every cell overlapping [left, right] x [top, bottom]. Up to 32 colliders
+    void addCollider(int id, float left, float top, float right, float bottom) {
+        const std::uint32_t bit = 1u << id;
+        const int c0 = columnOf(left);
+        const int c1 = columnOf(right);
+        for (int r = rowOf(top); r <= rowOf(bottom); ++r) {
+            std::uint32_t* row = &colliderMasks[static_cast<std::size_t>(r) * columns];
+            for (int c = c0; c <= c1; ++c) {
+                row[c] |= bit;
+            }
+        }
+    }
+
+    // Bitmask of the colliders whose cells contain the point (x, y)
+    std::uint32_t collidersAt(float x, float y) const {
+        return colliderMasks[cellOf(x, y)];
+    }
+
+    // Re-bins the first count drops from their packed x and y arrays
+    void build(const float* x, const float* y, std::size_t count) {
+        dropCell.resize(count);
+        entries.resize(count);
+        std::fill(cellStart.begin(), cellStart.end(), 0);
+
+        // Histogram, offset by one so the prefix sum below turns it into start indices
+        for (std::size_t i = 0; i < count; ++i) {
+            const std::uint32_t cell = cellOf(x[i], y[i]);
+            dropCell[i] = cell;
+            ++cellStart[cell + 1];
+        }
+        for (std::size_t c = 1; c < cellStart.size(); ++c) {
+            cellStart[c] += cellStart[c - 1];
+        }
+
+        // Scatter drop indices into their cell ranges, using cursor as per-cell write heads
+        cursor.assign(cellStart.begin(), cellStart.end() - 1);
+        for (std::size_t i = 0; i < count; ++i) {
+            entries[cursor[dropCell[i]]++] = static_cast<std::uint32_t>(i);
+        }
+    }
+
+    // Calls fn(index) for every drop binned in a cell overlapping [left, right] x [top, bottom].
+    // Callers still run the precise test; this only narrows the candidates
+    template <typename Fn>
+    void query(float left, float top, float right, float bottom, Fn&& fn) const {
+        const int c0 = columnOf(left);
+        const int c1 = columnOf(right);
+        const int r0 = rowOf(top);
+        const int r1 = rowOf(bottom);
+        for (int r = r0; r <= r1; ++r) {
+            // Cells of a row are contiguous, so each row is a single index range
+            const std::size_t rowBase = static_cast<std::size_t>(r) * columns;
+            const std::uint32_t begin = cellStart[rowBase + c0];
+            const std::uint32_t end = cellStart[rowBase + c1 + 1];
+            for (std::uint32_t e = begin; e < end; ++e) {
+                fn(static_cast<std::size_t>(entries[e]));
+            }
+        }
+    }
+
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage = vectorUsage(cellStart);
+        usage += vectorUsage(entries);
+        usage += vectorUsage(dropCell);
+        usage += vectorUsage(cursor);
+        usage += vectorUsage(colliderMasks);
+        return usage;
+    }
+
+private:
+    float originX;
+    float originY;
+    float invCellSize;
+    int columns;
+    int rows;
+    std::vector<std::uint32_t> cellStart; // Prefix sums: cell c owns entries[cellStart[c], cellStart[c + 1])
+    std::vector<std::uint32_t> entries;
+    std::vector<std::uint32_t> dropCell;
+    std::vector<std::uint32_t> cursor;
+    std::vector<std::uint32_t> colliderMasks;
+
+    int columnOf(float x) const {
+        return std::min(std::max(static_cast<int>((x - originX) * invCellSize), 0), columns - 1);
+    }
+
+    int rowOf(float y) const {
+        return std::min(std::max(static_cast<int>((y - originY) * invCellSize), 0), rows - 1);
+    }
+
+    std::uint32_t cellOf(float x, float y) const {
+        return static_cast<std::uint32_t>(rowOf(y) * columns + columnOf(x));
+    }
+};
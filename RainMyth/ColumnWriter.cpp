@@ -0,0 +1,166 @@
+#include "ColumnWriter.h"
+
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#include "IoService.h"
+
+namespace {
+
+// The file is "RMCT", a version and the number of columns, then each column's type as a byte,
+// the length of its name as a byte and the name. Row groups follow: each is its row count as a
+// 32-bit integer and then every column's values for those rows, packed, one column after
+// another. The footer is each group's offset from the start of the file, the number of groups,
+// the number of rows, all 64-bit, and "RMCT" again, so a reader can find the index from the
+// end. Numbers are in the machine's own byte order like the telemetry's
+const char COLUMN_MAGIC[4] = { 'R', 'M', 'C', 'T' };
+const std::uint32_t COLUMN_VERSION = 1;
+
+std::size_t widthOf(ColumnType type) {
+    return type == COLUMN_UINT64 ? 8 : 4;
+}
+
+} // namespace
+
+bool isColumnarPath(const std::string& path) {
+    const std::string suffix(".cols");
+    return path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+ColumnWriter::ColumnWriter(const std::string& path, std::size_t groupRows)
+    : path(path), out(path, std::ios::binary), groupRows(groupRows > 0 ? groupRows : 1), groupFill(0), rows(0), offset(0), started(false) {
+    if (!out) {
+        std::cerr << "Couldn't open " << path << " for writing" << std::endl;
+        out.close();
+    }
+}
+
+std::size_t ColumnWriter::addColumn(const std::string& name, ColumnType type) {
+    if (started) {
+        std::cerr << "Column " << name << " added after the first row, ignoring it" << std::endl;
+        return columns.size();
+    }
+    Column column;
+    column.name = name.substr(0, 255);
+    column.type = type;
+    column.values.reserve(groupRows * widthOf(type));
+    columns.push_back(column);
+    return columns.size() - 1;
+}
+
+void ColumnWriter::put(std::size_t column, float value) {
+    if (column >= columns.size()) {
+        return;
+    }
+    Column& target = columns[column];
+    if (target.type != COLUMN_FLOAT32) {
+        put(column, static_cast<std::uint64_t>(value));
+        return;
+    }
+    const std::size_t at = target.values.size();
+    target.values.resize(at + sizeof(value));
+    std::memcpy(&target.values[at], &value, sizeof(value));
+}
+
+void ColumnWriter::put(std::size_t column, std::uint64_t value) {
+    if (column >= columns.size()) {
+        return;
+    }
+    Column& target = columns[column];
+    const std::size_t at = target.values.size();
+    if (target.type == COLUMN_FLOAT32) {
+        put(column, static_cast<float>(value));
+    }
+    else if (target.type == COLUMN_UINT32) {
+        const std::uint32_t narrow = static_cast<std::uint32_t>(value);
+        target.values.resize(at + sizeof(narrow));
+        std::memcpy(&target.values[at], &narrow, sizeof(narrow));
+    }
+    else {
+        target.values.resize(at + sizeof(value));
+        std::memcpy(&target.values[at], &value, sizeof(value));
+    }
+}
+
+void ColumnWriter::endRow() {
+    if (!started) {
+        writeHeader();
+    }
+    ++rows;
+    if (++groupFill == groupRows) {
+        writeGroup();
+    }
+}
+
+bool ColumnWriter::finish() {
+    if (!isOpen()) {
+        return false;
+    }
+    if (!started) {
+        writeHeader();
+    }
+    writeGroup();
+    for (std::uint64_t groupOffset : groupOffsets) {
+        writeBytes(&groupOffset, sizeof(groupOffset));
+    }
+    const std::uint64_t groups = groupOffsets.size();
+    writeBytes(&groups, sizeof(groups));
+    writeBytes(&rows, sizeof(rows));
+    writeBytes(COLUMN_MAGIC, sizeof(COLUMN_MAGIC));
+    handOver();
+    ioService().drain();
+    out.close();
+    if (!out) {
+        std::cerr << "Couldn't write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void ColumnWriter::writeHeader() {
+    started = true;
+    writeBytes(COLUMN_MAGIC, sizeof(COLUMN_MAGIC));
+    writeBytes(&COLUMN_VERSION, sizeof(COLUMN_VERSION));
+    const std::uint32_t count = static_cast<std::uint32_t>(columns.size());
+    writeBytes(&count, sizeof(count));
+    for (const Column& column : columns) {
+        const std::uint8_t type = static_cast<std::uint8_t>(column.type);
+        const std::uint8_t length = static_cast<std::uint8_t>(column.name.size());
+        writeBytes(&type, sizeof(type));
+        writeBytes(&length, sizeof(length));
+        writeBytes(column.name.data(), length);
+    }
+}
+
+// Writes the rows gathered so far as a group, if there are any
+void ColumnWriter::writeGroup() {
+    if (groupFill == 0) {
+        return;
+    }
+    groupOffsets.push_back(offset);
+    const std::uint32_t count = static_cast<std::uint32_t>(groupFill);
+    writeBytes(&count, sizeof(count));
+    for (Column& column : columns) {
+        column.values.resize(groupFill * widthOf(column.type)); // A row that missed a column gets zeros there
+        writeBytes(column.values.data(), column.values.size());
+        column.values.clear();
+    }
+    groupFill = 0;
+    handOver();
+}
+
+void ColumnWriter::writeBytes(const void* data, std::size_t bytes) {
+    if (isOpen()) {
+        const std::uint8_t* from = static_cast<const std::uint8_t*>(data);
+        pending.insert(pending.end(), from, from + bytes);
+    }
+    offset += bytes;
+}
+
+void ColumnWriter::handOver() {
+    if (!pending.empty()) {
+        ioService().write(out, std::move(pending));
+        pending.clear(); // Moved from, so valid but unspecified
+    }
+}
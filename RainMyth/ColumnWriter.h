@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Constants.h"
+
+// Whether results going to path should be written by a ColumnWriter rather than as CSV: whether
+// it ends in .cols
+bool isColumnarPath(const std::string& path);
+
+// How a column's values are stored
+enum ColumnType {
+    COLUMN_FLOAT32,
+    COLUMN_UINT32,
+    COLUMN_UINT64
+};
+
+// Writes a table one column after another rather than row by row, for results too big to load
+// quickly as CSV. Rows are gathered into row groups of groupRows; each group is written as every
+// column's values in turn, so a reader can take one column of a group with a single read and
+// no parsing, and a footer indexes the groups so it can go straight to any of them. The layout
+// is described in ColumnWriter.cpp.
+//
+// Columns are added before the first row. Each row then puts one value in every column, in any
+// order, and ends with endRow(). Each group goes to the I/O thread, see IoService.h, so the
+// rows after it don't wait on the disk. finish() writes what's left and the footer, and waits
+// for it all to be written
+class ColumnWriter {
+public:
+    // Opens path for writing. Problems are reported on stderr and leave the writer closed
+    explicit ColumnWriter(const std::string& path, std::size_t groupRows = COLUMN_GROUP_ROWS);
+
+    bool isOpen() const {
+        return out.is_open();
+    }
+
+    // Adds a column and returns its number, for put()
+    std::size_t addColumn(const std::string& name, ColumnType type);
+
+    void put(std::size_t column, float value);
+    void put(std::size_t column, std::uint64_t value);
+
+    void endRow();
+
+    // Writes the last group and the footer. Returns false, reporting it on stderr, if anything
+    // couldn't be written
+    bool finish();
+
+    std::uint64_t rowCount() const {
+        return rows;
+    }
+
+private:
+    struct Column {
+        std::string name;
+        ColumnType type;
+        std::vector<std::uint8_t> values; // The current group's, packed
+    };
+
+    std::string path;
+    std::ofstream out;
+    std::size_t groupRows;
+    std::vector<Column> columns;
+    std::vector<std::uint64_t> groupOffsets;
+    std::vector<std::uint8_t> pending; // Bytes not yet handed to the I/O thread
+    std::size_t groupFill; // Rows in the current group
+    std::uint64_t rows;
+    std::uint64_t offset;  // Bytes written so far
+    bool started;          // Whether the header is out, after which no columns can be added
+
+    void writeHeader();
+    void writeGroup();
+    void writeBytes(const void* data, std::size_t bytes);
+    void handOver();
+};
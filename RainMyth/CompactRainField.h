@@ -0,0 +1,58 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Constants.h"
+#include "RainField.h"
+
+// An 8-byte-per-drop layout of a RainField, for runs with so many drops that the update is
+// bound by memory bandwidth rather than arithmetic. Only RainMythBench uses it, packing a store
+// and timing integrateCompact() against the float kernels; nothing simulates in it, so it can
+// be filled but not read back. Positions are 16-bit fixed point in 1/COMPACT_SUBPIXELS pixels,
+// so x and y must stay within +-2048 pixels. Rather than a speed, each drop keeps how far it
+// falls in one fixed step, which integrateCompact() adds with integer SIMD, and its width is an
+// 8-bit code between RAINDROP_MIN_SIZE and RAINDROP_MAX_SIZE. Only the first 8 people's
+// absorbed bits fit in the last byte.
+//
+// The integration step touches 6 bytes per drop instead of the float layout's 12. Rounding
+// dy to a whole subpixel changes a drop's speed by at most half a subpixel per step; at 60 Hz
+// that's under 0.2% of the slowest drop's speed
+struct CompactRainField {
+    std::vector<std::int16_t> x;
+    std::vector<std::int16_t> y;
+    std::vector<std::int16_t> dy;  // Fall per step
+    std::vector<std::uint8_t> size;
+    std::vector<std::uint8_t> absorbed;
+
+    static std::int16_t toFixed(float pixels) {
+        const float scaled = std::round(pixels * COMPACT_SUBPIXELS);
+        return static_cast<std::int16_t>(std::min(std::max(scaled, -32768.0f), 32767.0f));
+    }
+
+    std::size_t count() const {
+        return y.size();
+    }
+
+    // Replaces the contents with drops' live drops, stepped by timestep
+    void pack(const RainField& drops, float timestep) {
+        const std::size_t n = drops.count();
+        x.resize(n);
+        y.resize(n);
+        dy.resize(n);
+        size.resize(n);
+        absorbed.resize(n);
+        const float sizeScale = 255.0f / (RAINDROP_MAX_SIZE - RAINDROP_MIN_SIZE);
+        for (std::size_t i = 0; i < n; ++i) {
+            x[i] = toFixed(drops.x[i]);
+            y[i] = toFixed(drops.y[i]);
+            dy[i] = toFixed(drops.vy[i] * timestep);
+            const float code = std::round((drops.size[i] - RAINDROP_MIN_SIZE) * sizeScale);
+            size[i] = static_cast<std::uint8_t>(std::min(std::max(code, 0.0f), 255.0f));
+            absorbed[i] = static_cast<std::uint8_t>(drops.absorbed[i] & 0xFF);
+        }
+    }
+};
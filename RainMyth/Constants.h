@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstddef>
+
+// Constants for the simulation
+const float GRAVITY = 9.81f * 100; // 9.81 m/s^2 assumes 1 pixel is a meter. We want it to be 100 pixels is a meter
+const float RAINDROP_MIN_SIZE = 0.5f;
+const float RAINDROP_MAX_SIZE = 1.5f;
+const float RAINDROP_MM_PER_PIXEL = 2.0f; // Real drop diameter per pixel of drop width, for the terminal speed model
+const std::size_t TERMINAL_SPEED_TABLE_SIZE = 256; // Entries in the per-size terminal speed table
+const std::size_t DROP_SIZE_TABLE_SIZE = 256; // Steps in the inverse cumulative size distribution drops are drawn from
+const float RAIN_INTENSITY = 5.0f; // Default rain rate for the Marshall-Palmer size model, in mm per hour. Moderate rain
+const float RAIN_SLICE_DEPTH = 2.0f; // Depth in meters of the air the 2D world stands for, turning mm/h into a spawn rate.
+                                     // At this depth and with uniform sizes, RAINDROP_SPAWN_RATE is about RAIN_INTENSITY
+const float RAINDROP_SPAWN_RATE = 175.0f * 60.0f / 1920.0f; // Drops per second per pixel of width. The old 175 per frame at 60 fps on a 1920 wide screen
+const float WALK_SPEED = 50.0f; // Pixels per second
+const float RUN_SPEED = 200.0f; // Pixels per second
+const float MAX_PERSON_SPEED = 1000.0f; // Pixels per second. A person's box moving further in a step is taken to have been reset
+const float PERSON_WIDTH = 40.0f;
+const float PERSON_HEIGHT = 100.0f;
+const float PERSON_LEAN = 0.2f; // Radians a leaning body tips forward, about 11 degrees
+const float MAX_WETNESS = 1000.0f; // A threshold for the maximum visual wetness
+const float TRAJECTORY_SAMPLE_RATE = 240.0f; // Samples per second a Trajectory is precomputed at
+const int WETNESS_COLOR_LEVELS = 256; // Shades a person is drawn in from dry to MAX_WETNESS, one per step of the widest channel
+
+// Layout of the default scene, measured from the bottom of the world. The platforms sit under
+// where a crossing starts and ends, at these fractions of the world's width, and people stand
+// above their centres
+constexpr float PLATFORM_WIDTH = 200.0f;
+constexpr float PLATFORM_HEIGHT = 50.0f;
+constexpr float PLATFORM_RISE = 250.0f;                // Centre of each platform above the ground
+constexpr float PERSON_RISE = PLATFORM_RISE + 150.0f;  // Centre of a person at the start or end above the ground
+constexpr float START_ACROSS = 1.0f / 8.0f;
+constexpr float END_ACROSS = 7.0f / 8.0f;
+const float GRID_CELL_SIZE = 32.0f; // Broadphase cell size in pixels
+const float RASTER_HIT_CELL_SIZE = 4.0f; // Cells people are rasterized into for HITS_RASTER, in pixels
+const float COLUMN_BUCKET_WIDTH = 8.0f; // Width of the column buckets RainConfig::columnBuckets keeps drops in, in pixels
+const float GROUND_CELL_WIDTH = 16.0f; // Columns GroundWater keeps a depth for, in pixels
+const float GROUND_WATER_POOLED = 0.05f; // Fraction of each drop reaching the ground that pools rather than soaking in
+const float GROUND_WATER_DRAIN = 4.0f; // Seconds for standing water to drain to 1/e of its depth
+const float GROUND_WATER_MAX_DEPTH = 24.0f; // Deepest the water is drawn, in pixels
+const float SHELTER_HOLD = 20.0f; // Water a collider holds per pixel of its width before the rest drips off, in drop area
+const float SHELTER_DRIP_TIME = 0.5f; // Seconds for a collider's excess water to drip down to 1/e of itself
+const std::size_t COALESCE_NEIGHBOURS = 16; // Drops after each in its cell that coalescing checks it against
+const float WIND_CELL_SIZE = 128.0f; // Spacing of the wind grid's samples in pixels
+const std::size_t MAX_PEOPLE = 32; // People one RainSystem collides against, one broadphase bit each
+const std::size_t PEOPLE_TREE_MIN = 8; // People from which hit tests only visit those the tree finds near each run of candidates
+const std::size_t HIT_RUN_DROPS = 64; // Candidates tested together against the people near all of them
+const float PEOPLE_TREE_MARGIN = 8.0f; // Slack around each person's box in the tree, so small moves don't reinsert them
+const std::size_t DROPS_PER_CHUNK = 16384; // Unit of parallel work. A multiple of 16 so chunks own whole flag bytes and whole cache lines
+const std::size_t CACHE_LINE_BYTES = 64; // What state written by different threads is kept apart by
+const std::size_t LIFETIME_BINS = 32; // Bins of DropLifetimes' histogram, the last taking every longer life
+const std::size_t LIFETIME_BIN_STEPS = 8; // Steps of a drop's life each bin covers
+const std::size_t SPAWNS_PER_CHUNK = 4096; // Drops one job spawns, when a step spawns enough to split. Whole cache lines too
+const std::size_t SORT_DROPS_PER_BLOCK = 32768; // Fewest drops worth a block of their own when sorting the store in parallel
+const std::size_t FRAME_ARENA_BYTES = 1u << 20; // Starting size of each FrameArena. A chunk's hit-test scratch is ~770 KB
+const float PROCEDURAL_CELL_WIDTH = 16.0f; // Columns of ProceduralRain's cells, in pixels
+const float PROCEDURAL_CELL_SECONDS = 1.0f / 32.0f; // Length of their time slots
+const float DENSITY_CELL_SIZE = 4.0f; // Side of DensityRain's cells, in pixels
+const std::size_t DENSITY_SIZE_CLASSES = 8; // Layers DensityRain splits the drop sizes into
+const float DENSITY_PARTICLE_BAND = 16.0f; // How far past anyone's box, widened for the biggest drop, DensityRain's particles reach
+const float CROWD_CELL_WIDTH = 32.0f; // Columns --crowd bins pedestrians and drops into, in pixels
+const std::size_t CROWD_JOB_PEOPLE = 256; // Pedestrians one job of Crowd::update moves
+const float CROWD_RUNNERS = 0.5f; // Share of the crowd that runs
+const float CROWD_SIZE_SPREAD = 0.15f; // How far a pedestrian's size is from the scenario's person's, either way
+const float CROWD_STREET_DEPTH = 24.0f; // Depth of the crowd's pavement, drawn as that many pixels up the screen
+const float CROWD_PERSON_DEPTH = 10.0f; // How far apart across the pavement two pedestrians have to be to pass
+const float CROWD_AVOID_RANGE = 48.0f; // How far ahead a pedestrian steers round others, in pixels
+const float CROWD_DODGE_SPEED = 40.0f; // Fastest a pedestrian steps aside, in pixels per second
+const unsigned MAX_DEPTH_LAYERS = 3; // Most layers of far-off rain FarRain draws behind the simulated rain
+const std::size_t IMPORTANCE_BATCH = 65536; // Drops one job of sampleCrossing draws and tests
+const std::size_t TIMED_SPAN_RING = 4096; // Slots of each thread's ring of timed spans, a power of two
+const std::size_t TRACE_MAX_SPANS = 1 << 20; // Spans --trace keeps, the rest of the run's being left to drop
+const double CYCLE_CALIBRATION_SECONDS = 1.0; // How long the cycle counter is measured against the steady clock before its rate is fixed
+const float SCRIPT_TIME_LIMIT = 3600.0f; // Simulated seconds a headless script may wait before it's given up on
+const float COMPACT_SUBPIXELS = 16.0f; // Fixed-point steps per pixel in CompactRainField, so positions span +-2048 pixels
+const std::size_t RAINDROP_CAPACITY = 1u << 18; // Default size of the drop pool. Steady state at the default spawn rate is ~16k
+const float SIM_HZ = 60.0f; // Default fixed simulation rate, in steps per second
+const float FRAME_SPIN_MS = 2.0f; // How close to each deadline --pacing precise sleeps before spinning, in milliseconds
+const float IDLE_FPS = 20.0f; // Frame rate --idle-after drops to while nobody's using the app
+const float STALL_SECONDS = 0.1f; // A frame longer than this is a stall, which --stall decides what to do with
+const float MAX_FRAME_TIME = 0.25f; // Longest frame the fixed-step loop will catch up on, in seconds
+const unsigned SETTLE_FRAMES = 120; // Frames the rendered loop is given to reach its steady state before allocations are reported
+const float STRESS_TARGET_FPS = 60.0f; // Frame rate --stress finds the most drops for
+const float STRESS_RAMP = 1.25f; // Factor --stress raises the spawn rate by from one level to the next
+const float STRESS_SETTLE_SECONDS = 3.0f; // Seconds each level is given to fill the sky before it's timed
+const float STRESS_LEVEL_SECONDS = 5.0f; // Seconds each level is timed for
+const std::size_t STRESS_MAX_LEVELS = 40; // Levels --stress gives up after, in case nothing slows the machine down
+const std::size_t MAX_ALLOCATION_ZONES = 64; // Distinct zones RAINMYTH_TRACK_ALLOCATIONS builds count allocations in
+const std::size_t SPLASH_CAPACITY = 16384; // Size of the splash droplet ring
+const std::size_t SPLASH_DROPLETS = 3; // Droplets thrown up by each impact
+const std::size_t SPLASH_BUDGET = 2048; // Default cap on droplets emitted per frame
+const float SPLASH_LIFETIME = 0.3f; // Seconds a splash droplet lives
+const std::size_t AUDIO_VOICES = 16; // sf::Sound voices impact sounds share, the oldest giving way when all are busy
+const std::size_t AUDIO_ZONES = 8; // Strips across the world that impacts are counted in for placing their sounds
+const std::size_t AUDIO_IMPACT_SAMPLES = 256; // Landings a step keeps for placing sounds, when splashes don't keep more
+const float AUDIO_VOLUME = 60.0f; // Default --audio-volume, out of 100
+const float CAMERA_ZOOM_STEP = 1.25f; // Zoom each press of + or - multiplies or divides by
+const float CAMERA_MIN_ZOOM = 0.25f; // Furthest the camera zooms out, showing the world a quarter of its size
+const float CAMERA_MAX_ZOOM = 32.0f; // Furthest it zooms in
+const float CAMERA_PAN_STEP = 0.1f; // Fraction of the view each arrow or page key pans it by
+const float STICK_DEAD_ZONE = 15.0f; // Percent of a joystick axis's travel --joystick reads as centred
+const float STICK_TOP_PACE = 2.0f; // With --joystick, the stick all the way over asks for this many times the run speed
+const float STICK_PACE_STEP = 2.0f; // Pixels per second the stick's pace has to move by before it's sent again
+const float TILE_DETAIL_PIXELS = 0.5f; // Below this many screen pixels per world unit, the rain is drawn as density tiles
+const float STREAK_DETAIL_PIXELS = 4.0f; // Above it, each drop is drawn with its whole motion streak
+const float ADAPTIVE_LINE_PIXELS = 2.0f; // --render adaptive draws drops narrower than this on screen as lines
+const float DENSITY_TILE_PIXELS = 8.0f; // Screen width of a density tile
+const std::size_t CAPTURE_FRAMES = 8; // Captured frames that can wait on the PNG encoder before --capture drops one
+const std::size_t CAPTURE_READBACKS = 3; // Frames a capture's GPU readback runs behind the frame being drawn
+const std::size_t TELEMETRY_SAMPLES = 1u << 18; // Default size of the telemetry ring, over an hour of steps at 60 Hz
+const std::size_t HIT_LOG_CHUNK_HITS = 256; // Catches a chunk of drops can record in one step for --hit-log
+const std::size_t HIT_LOG_BUFFER_BYTES = 1u << 20; // Size of each buffer --hit-log encodes into and writes out whole
+const std::size_t HIT_LOG_BUFFERS = 8; // Buffers the hit log's writer can fall behind by before the simulation waits on it
+const std::size_t STORM_PREFETCH_BYTES = 1u << 16; // How far ahead of the line it's reached a --storm file is read in
+const std::size_t STORM_LINE_BYTES = 256; // Longest line a --storm file may have
+const std::size_t IO_QUEUE_WRITES = 64; // Writes IoService holds before whoever hands it another waits for room
+const float HIT_LOG_SIZE_STEP = 1.0f / 1024.0f; // Drop sizes in a hit log are rounded to this many world units
+const float OPTIMIZE_SPEED_TOLERANCE = 1.0f; // Width in pixels per second --optimize narrows the best speed down to
+const float VALIDATE_TOLERANCE = 1.0e-4f; // Relative wetness --validate lets an optimized path differ from the reference by
+const float VALIDATE_POSITION_TOLERANCE = 1.0e-3f; // Pixels a drop may be from where the reference put it
+const float VALIDATE_EVENT_TOLERANCE = 0.05f; // Relative wetness between EventRain and stepped rain, which draw their drops differently
+const unsigned short SWEEP_PORT = 47860; // Port --sweep-worker connects to when none is given
+const std::size_t COLUMN_GROUP_ROWS = 65536; // Rows in each row group of a columnar sweep or trial file
+const unsigned MAX_WALL_DISPLAYS = 8; // Most windows --wall opens
+// Size of the world every run simulates, in the same units as everything above: 100 to the
+// meter, as GRAVITY assumes, so 19.2 by 10.8 meters. A window only decides how big it's drawn
+const unsigned WORLD_WIDTH = 1920;
+const unsigned WORLD_HEIGHT = 1080;
@@ -0,0 +1,244 @@
+#include "Crowd.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Constants.h"
+#include "JobSystem.h"
+#include "RainKernels.h"
+#include "Rng.h"
+
+namespace {
+
+std::size_t columnOf(float x, std::size_t columns) {
+    return static_cast<std::size_t>(std::min(std::max(x / CROWD_CELL_WIDTH, 0.0f), static_cast<float>(columns - 1)));
+}
+
+// Turns counts, one per column from start[1] on, into where each column starts
+void countsToStarts(std::vector<std::size_t>& start) {
+    for (std::size_t c = 1; c < start.size(); ++c) {
+        start[c] += start[c - 1];
+    }
+}
+
+} // namespace
+
+Crowd::Crowd(std::size_t count, sf::Vector2u windowSize, sf::Vector2f size, float walkSpeed, float runSpeed, float runners, float maxDropSize,
+    std::uint64_t seed)
+    : streetWidth(static_cast<float>(windowSize.x)), ground(windowSize.y - PERSON_RISE + size.y / 2.0f), widest(0.0f), fastest(0.0f), bandTop(0.0f),
+      bandBottom(0.0f) {
+    Rng rng(seed);
+    float tallest = 0.0f;
+    for (std::size_t i = 0; i < count; ++i) {
+        const float scale = rng.uniform(1.0f - CROWD_SIZE_SPREAD, 1.0f + CROWD_SIZE_SPREAD);
+        width.push_back(size.x * scale);
+        height.push_back(size.y * scale);
+        x.push_back(rng.uniform(width.back() / 2.0f, streetWidth - width.back() / 2.0f));
+        depth.push_back(rng.uniform(0.0f, CROWD_STREET_DEPTH));
+        y.push_back(ground - depth.back() - height.back() / 2.0f);
+        strategy.push_back(rng.uniform() < runners ? STRATEGY_RUN : STRATEGY_WALK);
+        const float speed = strategy.back() == STRATEGY_RUN ? runSpeed : walkSpeed;
+        cruise.push_back(rng.uniform() < 0.5f ? -speed : speed);
+        vx.push_back(cruise.back());
+        wetness.push_back(0.0f);
+        widest = std::max(widest, width.back());
+        fastest = std::max(fastest, speed);
+        tallest = std::max(tallest, height.back());
+    }
+    bandTop = ground - CROWD_STREET_DEPTH - tallest - RainField::heightOf(maxDropSize);
+    bandBottom = ground;
+
+    const std::size_t columns = static_cast<std::size_t>(std::ceil(streetWidth / CROWD_CELL_WIDTH));
+    peopleStart.assign(columns + 1, 0);
+    dropStart.assign(columns + 1, 0);
+    cursor.assign(columns, 0);
+    order.resize(count);
+    nextVx.resize(count);
+    nextDepth.resize(count);
+}
+
+void Crowd::binPeople() {
+    const std::size_t columns = cursor.size();
+    std::fill(peopleStart.begin(), peopleStart.end(), 0);
+    for (std::size_t i = 0; i < size(); ++i) {
+        ++peopleStart[columnOf(x[i] - width[i] / 2.0f, columns) + 1];
+    }
+    countsToStarts(peopleStart);
+    std::copy(peopleStart.begin(), peopleStart.end() - 1, cursor.begin());
+    for (std::size_t i = 0; i < size(); ++i) {
+        order[cursor[columnOf(x[i] - width[i] / 2.0f, columns)]++] = static_cast<std::uint32_t>(i);
+    }
+}
+
+void Crowd::update(float deltaTime, JobSystem& jobs) {
+    binPeople();
+
+    // Everyone steers by where the others are at the start of the step, so the order the
+    // columns run in doesn't matter. Only those in the columns around their own can be near
+    const std::size_t columns = cursor.size();
+    const std::size_t around = static_cast<std::size_t>((CROWD_AVOID_RANGE + widest) / CROWD_CELL_WIDTH) + 1;
+    jobs.run(columns, [&](std::size_t c, unsigned) {
+        const std::size_t nearFirst = peopleStart[c > around ? c - around : 0];
+        const std::size_t nearLast = peopleStart[std::min(c + around + 1, columns)];
+        for (std::size_t k = peopleStart[c]; k < peopleStart[c + 1]; ++k) {
+            const std::uint32_t i = order[k];
+            const float heading = cruise[i] < 0.0f ? -1.0f : 1.0f;
+            const float speed = std::abs(cruise[i]);
+            float keepSide = 0.0f; // From anyone oncoming
+            float passSide = 0.0f; // Round the nearest going their way
+            float nearest = CROWD_AVOID_RANGE;
+            float pace = 1.0f;
+            for (std::size_t m = nearFirst; m < nearLast; ++m) {
+                const std::uint32_t j = order[m];
+                const float ahead = (x[j] - x[i]) * heading;
+                if (j == i || ahead <= 0.0f || ahead >= CROWD_AVOID_RANGE || std::abs(depth[j] - depth[i]) >= CROWD_PERSON_DEPTH) {
+                    continue;
+                }
+                // Step aside, the sooner the nearer they are. From anyone coming the other way
+                // to their own side, those heading right towards the kerb and left away from it,
+                // so the two directions sort into lanes; round the nearest going their way on
+                // whichever side is further from them, the one listed first going back when
+                // level, so two never mirror each other. Oncoming people come first, or else
+                // someone might be kept stepping into a lane they're meeting others in, and jam
+                const float closeness = 1.0f - ahead / CROWD_AVOID_RANGE;
+                if (cruise[j] * heading < 0.0f) {
+                    keepSide = std::max(keepSide, closeness);
+                }
+                else if (ahead < nearest) {
+                    nearest = ahead;
+                    passSide = (depth[j] != depth[i] ? (depth[j] < depth[i] ? 1.0f : -1.0f) : (i < j ? 1.0f : -1.0f)) * closeness;
+                }
+
+                // And slow towards their pace along the street, all the way once there's no gap
+                // left, until they're passed
+                if (speed > 0.0f) {
+                    const float theirs = std::max(cruise[j] * heading, 0.0f) / speed;
+                    if (theirs < 1.0f) {
+                        const float gap = ahead - (width[i] + width[j]) / 2.0f;
+                        const float room = std::min(std::max(gap / CROWD_AVOID_RANGE, 0.0f), 1.0f);
+                        pace = std::min(pace, theirs + (1.0f - theirs) * room);
+                    }
+                }
+            }
+            nextVx[i] = cruise[i] * pace;
+            const float side = keepSide > 0.0f ? -heading * keepSide : passSide;
+            const float step = side * CROWD_DODGE_SPEED * deltaTime;
+            nextDepth[i] = std::min(std::max(depth[i] + step, 0.0f), CROWD_STREET_DEPTH);
+        }
+    });
+
+    const std::size_t chunks = (size() + CROWD_JOB_PEOPLE - 1) / CROWD_JOB_PEOPLE;
+    jobs.run(chunks, [&](std::size_t chunk, unsigned) {
+        const std::size_t end = std::min((chunk + 1) * CROWD_JOB_PEOPLE, size());
+        for (std::size_t i = chunk * CROWD_JOB_PEOPLE; i < end; ++i) {
+            const float half = width[i] / 2.0f;
+            vx[i] = nextVx[i];
+            depth[i] = nextDepth[i];
+            x[i] += vx[i] * deltaTime;
+            if (x[i] < half) {
+                x[i] = half;
+                cruise[i] = std::abs(cruise[i]);
+                vx[i] = std::abs(vx[i]);
+            }
+            else if (x[i] > streetWidth - half) {
+                x[i] = streetWidth - half;
+                cruise[i] = -std::abs(cruise[i]);
+                vx[i] = -std::abs(vx[i]);
+            }
+            y[i] = ground - depth[i] - height[i] / 2.0f;
+        }
+    });
+}
+
+void Crowd::collide(const RainField& drops, float deltaTime, JobSystem& jobs) {
+    const std::size_t columns = cursor.size();
+
+    // The drops that were or are low enough to reach anyone, by the column of their left edge
+    dropIndex.clear();
+    std::fill(dropStart.begin(), dropStart.end(), 0);
+    for (std::size_t i = 0; i < drops.count(); ++i) {
+        const float top = drops.y[i];
+        if (top + RainField::heightOf(drops.size[i]) > bandTop && top - drops.vy[i] * deltaTime < bandBottom) {
+            dropIndex.push_back(static_cast<std::uint32_t>(i));
+            ++dropStart[columnOf(drops.x[i], columns) + 1];
+        }
+    }
+    countsToStarts(dropStart);
+    const std::size_t near = dropIndex.size();
+    dropLeft.resize(near);
+    dropTop.resize(near);
+    dropRight.resize(near);
+    dropBottom.resize(near);
+    dropArea.resize(near);
+    startTop.resize(near);
+    startBottom.resize(near);
+    std::copy(dropStart.begin(), dropStart.end() - 1, cursor.begin());
+    for (std::uint32_t i : dropIndex) {
+        const std::size_t k = cursor[columnOf(drops.x[i], columns)]++;
+        const float dropHeight = RainField::heightOf(drops.size[i]);
+        const float fallen = drops.vy[i] * deltaTime;
+        dropLeft[k] = drops.x[i];
+        dropTop[k] = drops.y[i];
+        dropRight[k] = drops.x[i] + drops.size[i];
+        dropBottom[k] = drops.y[i] + dropHeight;
+        dropArea[k] = RainField::areaOf(drops.size[i]);
+        startTop[k] = drops.y[i] - fallen;
+        startBottom[k] = drops.y[i] - fallen + dropHeight;
+    }
+
+    // A drop can touch someone whose left edge is in its column or the next few, as far as the
+    // widest person reaches, or, being up to a column wide, in the one before. People are
+    // still in the columns update binned them into, which they've moved up to slack out of
+    const std::size_t slack = static_cast<std::size_t>(fastest * deltaTime / CROWD_CELL_WIDTH) + 1;
+    const std::size_t reach = static_cast<std::size_t>(widest / CROWD_CELL_WIDTH) + 1 + slack;
+    jobs.run(columns, [&](std::size_t c, unsigned worker) {
+        const std::size_t first = peopleStart[c];
+        const std::size_t last = peopleStart[c + 1];
+        const std::size_t from = dropStart[c > slack ? c - 1 - slack : 0];
+        const std::size_t to = dropStart[std::min(c + reach + 1, columns)];
+        const std::size_t count = to - from;
+        if (first == last || count == 0) {
+            return;
+        }
+        FrameArena& arena = jobs.arena(worker);
+        const FrameArena::Scope scope(arena);
+        std::uint32_t* none = arena.allocate<std::uint32_t>(count);
+        std::uint32_t* touching = arena.allocate<std::uint32_t>(count);
+        std::uint32_t* hits = arena.allocate<std::uint32_t>(count);
+        std::fill(none, none + count, 0u);
+        const HitBatch atStart = { &dropLeft[from], &startTop[from], &dropRight[from], &startBottom[from], &dropArea[from], none };
+        const HitBatch atEnd = { &dropLeft[from], &dropTop[from], &dropRight[from], &dropBottom[from], &dropArea[from], touching };
+        for (std::size_t group = first; group < last; group += MAX_PEOPLE) {
+            const std::size_t people = std::min(last - group, MAX_PEOPLE);
+            HitBox before[MAX_PEOPLE];
+            HitBox after[MAX_PEOPLE];
+            float caught[MAX_PEOPLE] = {};
+            for (std::size_t j = 0; j < people; ++j) {
+                const std::uint32_t p = order[group + j];
+                const float left = x[p] - width[p] / 2.0f;
+                const float top = y[p] - height[p] / 2.0f;
+                const HitBox box = { left, top, left + width[p], top + height[p] };
+                const float moved = vx[p] * deltaTime;
+                const HitBox start = { box.left - moved, box.top, box.right - moved, box.bottom };
+                after[j] = box;
+                before[j] = start;
+            }
+            hitTestPeople(atStart, count, before, people, touching, nullptr);
+            hitTestPeople(atEnd, count, after, people, hits, caught);
+            for (std::size_t j = 0; j < people; ++j) {
+                wetness[order[group + j]] += caught[j];
+            }
+        }
+    });
+}
+
+void Crowd::print(std::ostream& out) const {
+    double sums[2] = { 0.0, 0.0 };
+    std::size_t counts[2] = { 0, 0 };
+    for (std::size_t i = 0; i < size(); ++i) {
+        sums[strategy[i]] += wetness[i];
+        ++counts[strategy[i]];
+    }
+    out << "Crowd of " << size() << ": walkers' mean wetness " << (counts[STRATEGY_WALK] ? sums[STRATEGY_WALK] / counts[STRATEGY_WALK] : 0.0)
+        << ", runners' " << (counts[STRATEGY_RUN] ? sums[STRATEGY_RUN] / counts[STRATEGY_RUN] : 0.0) << std::endl;
+}
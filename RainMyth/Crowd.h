@@ -0,0 +1,95 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "RainField.h"
+
+class JobSystem;
+
+// How a pedestrian gets along the street
+enum CrowdStrategy : std::uint8_t {
+    STRATEGY_WALK,
+    STRATEGY_RUN
+};
+
+// --crowd: a street of pedestrians walking to and fro through the rain, turning round at
+// either end. Each field is one array, as in RainField, so moving them and testing them
+// against drops run over flat memory, split across the job system.
+//
+// Each step they're binned into CROWD_CELL_WIDTH columns by their left edge, once, and the
+// bins serve both for steering and for the rain. Steering: the pavement is CROWD_STREET_DEPTH
+// deep, drawn as height up the screen, and anyone with someone less than CROWD_PERSON_DEPTH
+// to either side of them within CROWD_AVOID_RANGE ahead steps aside, and slows towards their
+// pace if they're slower, until they've passed. Only people in the columns around their own
+// are looked at, so that's linear in the crowd too.
+//
+// The drops low enough to reach anyone are binned the same way. A column is a job: its
+// pedestrians are tested against the drops that could touch them with hitTestPeople, the
+// kernel RainSystem tests its people with, thirty-two at a time, and it writes only their
+// wetness. So a thousand people cost the drops near the ground a few more tests each,
+// whatever the size of the street.
+// Drops aren't used up: each pedestrian catches a drop once, when it first touches them, which
+// is when it overlaps them at the end of the step and didn't at the start, wind's drift over
+// the step aside
+class Crowd {
+public:
+    // count people of around size, a share runners of them running at runSpeed and the rest
+    // walking at walkSpeed, spread along the ground of a windowSize screen, in rain whose drops
+    // are at most maxDropSize wide
+    Crowd(std::size_t count, sf::Vector2u windowSize, sf::Vector2f size, float walkSpeed, float runSpeed, float runners, float maxDropSize,
+        std::uint64_t seed);
+
+    // Moves everyone deltaTime on, stepping round each other
+    void update(float deltaTime, JobSystem& jobs);
+
+    // Has everyone catch what reached them of drops, which have just moved deltaTime on. Uses
+    // the bins update made, so it follows update in each step
+    void collide(const RainField& drops, float deltaTime, JobSystem& jobs);
+
+    std::size_t size() const {
+        return x.size();
+    }
+
+    // Mean wetness by strategy
+    void print(std::ostream& out) const;
+
+    std::vector<float> x;  // Centre
+    std::vector<float> y;
+    std::vector<float> vx;     // Pixels per second, negative heading left
+    std::vector<float> cruise; // The speed they'd go at with no one in the way
+    std::vector<float> depth;  // How far across the pavement, 0 at the kerb
+    std::vector<float> width;
+    std::vector<float> height;
+    std::vector<float> wetness;
+    std::vector<std::uint8_t> strategy;
+
+private:
+    float streetWidth;
+    float ground; // Where everyone's feet are at the kerb
+    float widest;
+    float fastest;
+    float bandTop;    // Highest a drop's top can be and still reach anyone
+    float bandBottom;
+
+    // Per step, everyone and the drops near the ground in column order
+    std::vector<std::size_t> peopleStart; // Per column, where its people start in order
+    std::vector<std::uint32_t> order;
+    std::vector<std::size_t> cursor;
+    std::vector<float> nextVx;    // Steering's results, applied once everyone's steered
+    std::vector<float> nextDepth;
+    std::vector<std::size_t> dropStart;
+    std::vector<float> dropLeft;
+    std::vector<float> dropTop;
+    std::vector<float> dropRight;
+    std::vector<float> dropBottom;
+    std::vector<float> dropArea;
+    std::vector<float> startTop;          // Where each was when the step began
+    std::vector<float> startBottom;
+    std::vector<std::uint32_t> dropIndex; // Scratch for binning
+
+    void binPeople();
+};
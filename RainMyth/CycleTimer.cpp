@@ -0,0 +1,117 @@
+#include "CycleTimer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+#include "Constants.h"
+#include "SpscQueue.h"
+
+namespace {
+
+// The counter and the steady clock read together, when the program started
+struct Reading {
+    std::uint64_t cycles;
+    std::chrono::steady_clock::time_point time;
+};
+
+const Reading origin = { cycleCount(), std::chrono::steady_clock::now() };
+std::atomic<double> calibrated(0.0);
+
+struct SpanRing {
+    SpscQueue<TimedSpan, TIMED_SPAN_RING> spans;
+    std::atomic<std::uint64_t> dropped;
+    std::uint32_t thread;
+};
+
+// Every thread's ring, in the order they were made. Rings are kept for the life of the
+// program, so a drain never has to wonder whether a thread that timed something has gone
+std::mutex ringsMutex;
+std::vector<std::unique_ptr<SpanRing>> rings;
+
+SpanRing* makeRing() {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    rings.emplace_back(new SpanRing());
+    rings.back()->dropped.store(0, std::memory_order_relaxed);
+    rings.back()->thread = static_cast<std::uint32_t>(rings.size() - 1);
+    return rings.back().get();
+}
+
+thread_local SpanRing* threadRing = nullptr;
+
+} // namespace
+
+double secondsPerCycle() {
+    const double known = calibrated.load(std::memory_order_relaxed);
+    if (known > 0.0) {
+        return known;
+    }
+    const std::uint64_t cycles = cycleCount();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - origin.time;
+    if (cycles <= origin.cycles || elapsed.count() <= 0.0) {
+        return 1e-9;
+    }
+    const double rate = elapsed.count() / static_cast<double>(cycles - origin.cycles);
+    if (elapsed.count() >= CYCLE_CALIBRATION_SECONDS) {
+        calibrated.store(rate, std::memory_order_relaxed);
+    }
+    return rate;
+}
+
+void recordSpan(const char* name, std::uint64_t begin, std::uint64_t end) {
+    if (threadRing == nullptr) {
+        threadRing = makeRing();
+    }
+    const TimedSpan span = { name, begin, end, threadRing->thread };
+    if (!threadRing->spans.push(span)) {
+        threadRing->dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void drainSpans(std::vector<TimedSpan>& out) {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    for (const std::unique_ptr<SpanRing>& ring : rings) {
+        while (const TimedSpan* span = ring->spans.peek()) {
+            out.push_back(*span);
+            ring->spans.pop();
+        }
+    }
+}
+
+std::uint64_t droppedSpans() {
+    std::lock_guard<std::mutex> lock(ringsMutex);
+    std::uint64_t dropped = 0;
+    for (const std::unique_ptr<SpanRing>& ring : rings) {
+        dropped += ring->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
+
+bool writeTrace(const std::string& path, const std::vector<TimedSpan>& spans) {
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "Couldn't open " << path << " for writing" << std::endl;
+        return false;
+    }
+    std::uint64_t first = spans.empty() ? 0 : spans.front().begin;
+    for (const TimedSpan& span : spans) {
+        first = std::min(first, span.begin);
+    }
+    const double microseconds = secondsPerCycle() * 1e6;
+    out << "{\"traceEvents\":[\n";
+    for (std::size_t i = 0; i < spans.size(); ++i) {
+        const TimedSpan& span = spans[i];
+        out << "{\"name\":\"" << span.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << span.thread
+            << ",\"ts\":" << (span.begin - first) * microseconds << ",\"dur\":" << (span.end - span.begin) * microseconds << "}"
+            << (i + 1 < spans.size() ? ",\n" : "\n");
+    }
+    out << "]}\n";
+    if (!out) {
+        std::cerr << "Couldn't write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Instrument.h"
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define RAINMYTH_HAS_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define RAINMYTH_HAS_TSC 1
+#endif
+
+// Timing for inner loops, cheap enough to leave on in release builds. cycleCount() reads the
+// processor's time-stamp counter, which ticks at a fixed rate on anything recent, in a couple
+// of dozen cycles and without a system call; where there is no counter it reads the steady
+// clock in nanoseconds instead. Counts are turned into seconds once they're differences, by
+// the rate measured against the steady clock since the program started.
+//
+// RAINMYTH_TIMED(name) also records the enclosing scope as a span in the calling thread's own
+// ring, a lock-free single-producer queue, so timing a scope is two counter reads and a store.
+// One thread at a time drains every thread's ring for the trace; a ring that isn't drained
+// fills up and then drops its thread's spans until it is, so spans cost the same whether or
+// not anyone is listening. name must be a string literal
+
+inline std::uint64_t cycleCount() {
+#if defined(RAINMYTH_HAS_TSC)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+// Seconds per count. Measured afresh on each call until CYCLE_CALIBRATION_SECONDS have
+// passed since the program started and fixed from then on
+double secondsPerCycle();
+
+inline float cycleSeconds(std::uint64_t cycles) {
+    return static_cast<float>(static_cast<double>(cycles) * secondsPerCycle());
+}
+
+// A scope some thread timed. thread numbers threads in the order they first timed anything
+struct TimedSpan {
+    const char* name;
+    std::uint64_t begin;
+    std::uint64_t end;
+    std::uint32_t thread;
+};
+
+// Adds the span to the calling thread's ring, or counts it dropped if the ring is full
+void recordSpan(const char* name, std::uint64_t begin, std::uint64_t end);
+
+// Moves every span recorded since the last drain onto the end of out, thread by thread.
+// Only one thread may drain at a time
+void drainSpans(std::vector<TimedSpan>& out);
+
+// Spans dropped so far because their thread's ring was full
+std::uint64_t droppedSpans();
+
+// Writes spans as a Chrome trace, viewable in chrome://tracing or Perfetto, with times from
+// the first span's start. Reports problems on stderr and returns false
+bool writeTrace(const std::string& path, const std::vector<TimedSpan>& spans);
+
+// Records its own lifetime as a span named name
+class TimedScope {
+public:
+    explicit TimedScope(const char* name) : name(name), begin(cycleCount()) {}
+
+    ~TimedScope() {
+        recordSpan(name, begin, cycleCount());
+    }
+
+    TimedScope(const TimedScope&) = delete;
+    TimedScope& operator=(const TimedScope&) = delete;
+
+private:
+    const char* name;
+    std::uint64_t begin;
+};
+
+#define RAINMYTH_TIMED(name) TimedScope RAINMYTH_CONCAT(timedScope, __LINE__)(name)
@@ -0,0 +1,434 @@
+#include "DensityRain.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Constants.h"
+#include "DropSizes.h"
+#include "RainField.h"
+#include "TerminalVelocity.h"
+
+namespace {
+
+// Sizes each layer's area and speed are averaged over, evenly spaced in probability
+const int DENSITY_CLASS_SAMPLES = 32;
+
+// Height of the spawn strip, as the drop engines spawn in it
+const float SPAWN_STRIP = 50.0f;
+
+// Bilinearly interpolated and clamped at the grid's edges, as driftDrops reads it
+float windAt(const WindGrid& wind, float x, float y) {
+    const float gx = std::min(std::max((x - wind.originX) * wind.invCellSize, 0.0f), static_cast<float>(wind.columns - 1) - 1e-3f);
+    const float gy = std::min(std::max((y - wind.originY) * wind.invCellSize, 0.0f), static_cast<float>(wind.rows - 1) - 1e-3f);
+    const int column = static_cast<int>(gx);
+    const int row = static_cast<int>(gy);
+    const float tx = gx - column;
+    const float ty = gy - row;
+    const float* cell = wind.cells + row * wind.columns + column;
+    const float upper = cell[0] + (cell[1] - cell[0]) * tx;
+    const float lower = cell[wind.columns] + (cell[wind.columns + 1] - cell[wind.columns]) * tx;
+    return upper + (lower - upper) * ty;
+}
+
+} // namespace
+
+float DensityRain::snapRow(float y) const {
+    return gridTop + std::round((y - gridTop) / DENSITY_CELL_SIZE) * DENSITY_CELL_SIZE;
+}
+
+DensityRain::DensityRain(sf::Vector2u windowSize, const RainConfig& config, const Scene& scene, bool particles)
+    : windowSize(windowSize), columns(0), rows(0), gridTop(-SPAWN_STRIP - 50.0f), spawnTop(-50.0f), time(0.0f),
+      wind(static_cast<float>(windowSize.x), static_cast<float>(windowSize.y), config.wind, config.seed),
+      layers(DENSITY_SIZE_CLASSES), shadowTop(scene.rainShadow(windowSize)), particlesNearPeople(particles), rng(config.seed) {
+    const DropSizeTable sizes(config);
+    const TerminalVelocityTable speeds(config.minSize, config.maxSize);
+    for (std::size_t k = 0; k < layers.size(); ++k) {
+        // The speed that gives the layer the density its sizes add up to: each holds its
+        // inflow for as long as it takes to fall through a cell
+        double area = 0.0;
+        double areaTime = 0.0;
+        for (int i = 0; i < DENSITY_CLASS_SAMPLES; ++i) {
+            const float size = sizes.lookup((k + (i + 0.5f) / DENSITY_CLASS_SAMPLES) / layers.size());
+            area += RainField::areaOf(size);
+            areaTime += RainField::areaOf(size) / std::max(speeds.lookup(size), 1e-3f);
+        }
+        Layer& layer = layers[k];
+        layer.size = sizes.lookup((k + 0.5f) / layers.size());
+        layer.height = RainField::heightOf(layer.size);
+        layer.speed = static_cast<float>(area / areaTime);
+        layer.inflow = static_cast<float>(config.spawnRate * DENSITY_CELL_SIZE * area / DENSITY_CLASS_SAMPLES / layers.size());
+        layer.dropArea = static_cast<float>(area / DENSITY_CLASS_SAMPLES);
+    }
+    layout();
+    fill();
+}
+
+void DensityRain::setSpawnTop(float top) {
+    spawnTop = top;
+    gridTop = top - SPAWN_STRIP;
+    layout();
+    fill();
+}
+
+float DensityRain::spawnTopAbove(float left, float right) const {
+    float highest = static_cast<float>(windowSize.y);
+    const std::size_t last = shadowTop.size() - 1;
+    for (std::size_t x = std::min(static_cast<std::size_t>(std::max(left, 0.0f)), last); x <= std::min(static_cast<std::size_t>(std::max(right, 0.0f)), last); ++x) {
+        highest = std::min(highest, shadowTop[x]);
+    }
+    return highest - RainField::heightOf(layers.back().size);
+}
+
+double DensityRain::airborne() const {
+    double total = 0.0;
+    for (const Layer& layer : layers) {
+        for (float water : layer.water) {
+            total += water;
+        }
+    }
+    for (const Particle& particle : particles) {
+        total += layers[particle.layer].dropArea;
+    }
+    return total;
+}
+
+void DensityRain::layout() {
+    columns = static_cast<std::size_t>(std::ceil(windowSize.x / DENSITY_CELL_SIZE));
+    rows = static_cast<std::size_t>(std::ceil((windowSize.y - gridTop) / DENSITY_CELL_SIZE)) + 1;
+    for (Layer& layer : layers) {
+        layer.water.assign(columns * rows, 0.0f);
+    }
+    scratch.assign(columns * rows, 0.0f);
+    windSpeed.assign(columns * rows, 0.0f);
+    band.assign(columns * rows, 0);
+    particles.clear();
+
+    // Water lands once its corner is past the shadow, which a cell's is once its middle is
+    landRow.resize(columns);
+    for (std::size_t c = 0; c < columns; ++c) {
+        const std::size_t x = std::min(static_cast<std::size_t>((c + 0.5f) * DENSITY_CELL_SIZE), shadowTop.size() - 1);
+        const float row = std::ceil((shadowTop[x] - gridTop) / DENSITY_CELL_SIZE - 0.5f);
+        landRow[c] = static_cast<std::size_t>(std::min(std::max(row, 0.0f), static_cast<float>(rows)));
+    }
+    stripShare.assign(rows, 0.0f);
+    for (std::size_t r = 0; r < rows; ++r) {
+        const float top = gridTop + r * DENSITY_CELL_SIZE;
+        const float covered = std::min(top + DENSITY_CELL_SIZE, spawnTop) - std::max(top, gridTop);
+        stripShare[r] = std::max(covered, 0.0f) / SPAWN_STRIP;
+    }
+}
+
+// Steady calm rain: below the strip, every cell holds what flows into its column while water
+// takes to fall through it, and through the strip that builds up with the spawns above
+void DensityRain::fill() {
+    for (Layer& layer : layers) {
+        const float full = layer.inflow * DENSITY_CELL_SIZE / layer.speed;
+        for (std::size_t r = 0; r < rows; ++r) {
+            const float above = std::min(std::max((r + 0.5f) * DENSITY_CELL_SIZE / SPAWN_STRIP, 0.0f), 1.0f);
+            for (std::size_t c = 0; c < columns; ++c) {
+                layer.water[r * columns + c] = r < landRow[c] ? full * above : 0.0f;
+            }
+        }
+    }
+}
+
+// Each layer falls at one speed, so its water moves down the same fraction of a cell
+// everywhere and is shared between the two rows it straddles. What passes the last row or its
+// column's shadow has landed
+void DensityRain::fall(Layer& layer, float deltaTime) {
+    const float cells = layer.speed * deltaTime / DENSITY_CELL_SIZE;
+    const std::size_t whole = static_cast<std::size_t>(cells);
+    const float part = cells - whole;
+    std::fill(scratch.begin(), scratch.end(), 0.0f);
+    for (std::size_t r = 0; r + whole < rows; ++r) {
+        const float* from = &layer.water[r * columns];
+        float* stay = &scratch[(r + whole) * columns];
+        for (std::size_t c = 0; c < columns; ++c) {
+            stay[c] += from[c] * (1.0f - part);
+        }
+        if (r + whole + 1 < rows) {
+            float* next = stay + columns;
+            for (std::size_t c = 0; c < columns; ++c) {
+                next[c] += from[c] * part;
+            }
+        }
+    }
+    for (std::size_t r = 0; r < rows; ++r) {
+        const float spawned = layer.inflow * deltaTime * stripShare[r];
+        if (spawned > 0.0f) {
+            for (std::size_t c = 0; c < columns; ++c) {
+                scratch[r * columns + c] += spawned;
+            }
+        }
+    }
+    for (std::size_t c = 0; c < columns; ++c) {
+        for (std::size_t r = landRow[c]; r < rows; ++r) {
+            scratch[r * columns + c] = 0.0f;
+        }
+    }
+    layer.water.swap(scratch);
+}
+
+// Upwind fluxes between neighbouring cells at the wind on the face between them, in as many
+// substeps as keep each under a cell. Water blown off one side comes back in on the other,
+// as drops do
+void DensityRain::blow(Layer& layer, float deltaTime, int substeps) {
+    const float scale = deltaTime / substeps / DENSITY_CELL_SIZE;
+    float* flux = scratch.data(); // Into column c across its left face, one row at a time
+    for (int s = 0; s < substeps; ++s) {
+        for (std::size_t r = 0; r < rows; ++r) {
+            float* water = &layer.water[r * columns];
+            const float* speed = &windSpeed[r * columns];
+            for (std::size_t c = 0; c < columns; ++c) {
+                const std::size_t before = c == 0 ? columns - 1 : c - 1;
+                const float face = 0.5f * (speed[before] + speed[c]) * scale;
+                flux[c] = face > 0.0f ? water[before] * face : water[c] * face;
+            }
+            for (std::size_t c = 0; c < columns; ++c) {
+                const std::size_t after = c + 1 == columns ? 0 : c + 1;
+                water[c] += flux[c] - flux[after];
+            }
+        }
+    }
+}
+
+float DensityRain::take(Layer& layer, std::size_t column, float top, float bottom, float share) {
+    float taken = 0.0f;
+    const float firstRow = std::max(std::floor((top - gridTop) / DENSITY_CELL_SIZE), 0.0f);
+    const float lastRow = std::min(std::ceil((bottom - gridTop) / DENSITY_CELL_SIZE), static_cast<float>(rows));
+    for (float r = firstRow; r < lastRow; ++r) {
+        const float cellTop = gridTop + r * DENSITY_CELL_SIZE;
+        const float covered = share * (std::min(bottom, cellTop + DENSITY_CELL_SIZE) - std::max(top, cellTop)) / DENSITY_CELL_SIZE;
+        float& water = layer.water[static_cast<std::size_t>(r) * columns + column];
+        taken += water * covered;
+        water -= water * covered;
+    }
+    return taken;
+}
+
+void DensityRain::update(float deltaTime, const PersonPath* people, std::size_t count, float* wetness, SurfaceWetness* surfaces) {
+    const float from = time;
+    time += deltaTime;
+    wind.update(deltaTime);
+    const bool windy = !wind.isCalm();
+    int substeps = 0;
+    if (windy) {
+        // The wind at each cell's middle, as driftDrops would read it for a drop there
+        const WindGrid grid = wind.getGrid();
+        float fastest = 0.0f;
+        for (std::size_t r = 0; r < rows; ++r) {
+            const float y = gridTop + (r + 0.5f) * DENSITY_CELL_SIZE;
+            for (std::size_t c = 0; c < columns; ++c) {
+                windSpeed[r * columns + c] = windAt(grid, (c + 0.5f) * DENSITY_CELL_SIZE, y);
+                fastest = std::max(fastest, std::abs(windSpeed[r * columns + c]));
+            }
+        }
+        substeps = std::max(static_cast<int>(std::ceil(fastest * deltaTime / DENSITY_CELL_SIZE)), 1);
+    }
+    catchers.resize(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const PersonPath& path = people[i];
+        Catcher& catcher = catchers[i];
+        catcher.before = path.leftAt(from);
+        catcher.left = path.leftAt(time);
+        catcher.bottom = snapRow(path.top + path.height);
+        catcher.moved = std::abs(catcher.left - catcher.before);
+        catcher.caught = SurfaceWetness();
+        const float ahead = path.endLeft >= path.left ? 1.0f : -1.0f;
+        const float velocity = path.startTime <= time && from <= path.arrivalTime() ? ahead * path.speed : 0.0f;
+        float air = 0.0f;
+        if (windy) {
+            const float middle = catcher.left + path.width / 2.0f;
+            const std::size_t c = std::min(static_cast<std::size_t>(std::max(middle / DENSITY_CELL_SIZE, 0.0f)), columns - 1);
+            const std::size_t r = std::min(static_cast<std::size_t>(std::max((path.top + path.height / 2.0f - gridTop) / DENSITY_CELL_SIZE, 0.0f)), rows - 1);
+            air = windSpeed[r * columns + c];
+        }
+        const float relative = air - velocity; // Of the rain to them, sideways
+        catcher.side = !windy ? SURFACE_TOP : (relative > 0.0f) == (ahead < 0.0f) ? SURFACE_FRONT : SURFACE_BACK;
+    }
+
+    if (particlesNearPeople) {
+        // Only the particles reach anyone, so the grid moves on its own
+        for (Layer& layer : layers) {
+            fall(layer, deltaTime);
+            if (windy) {
+                blow(layer, deltaTime, substeps);
+            }
+        }
+        markBand(people, count);
+        moveParticles(people, count, deltaTime, windy);
+        makeParticles();
+    }
+    else {
+        // In wind what fell in is caught before it's blown, or what fell into the downwind
+        // edge of someone's box would be blown back out of it first, more of it the longer the
+        // step
+        for (Layer& layer : layers) {
+            fall(layer, deltaTime);
+            if (windy) {
+                for (std::size_t i = 0; i < count; ++i) {
+                    catchIn(layer, people[i], catchers[i], deltaTime, CATCH_FALLEN);
+                }
+                blow(layer, deltaTime, substeps);
+            }
+            for (std::size_t i = 0; i < count; ++i) {
+                catchIn(layer, people[i], catchers[i], deltaTime, windy ? CATCH_BLOWN : CATCH_FALLEN | CATCH_BLOWN);
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        const PersonPath& path = people[i];
+        const SurfaceWetness& caught = catchers[i].caught;
+        const float walking = std::max(std::min(time, path.arrivalTime()) - std::max(from, path.startTime), 0.0f) / deltaTime;
+        if (walking > 0.0f) {
+            wetness[i] += caught.total() * walking;
+            if (surfaces) {
+                surfaces[i].top += caught.top * walking;
+                surfaces[i].front += caught.front * walking;
+                surfaces[i].back += caught.back * walking;
+            }
+        }
+    }
+}
+
+void DensityRain::markBand(const PersonPath* people, std::size_t count) {
+    std::fill(band.begin(), band.end(), 0);
+    const Layer& biggest = layers.back();
+    for (std::size_t i = 0; i < count; ++i) {
+        const PersonPath& path = people[i];
+        const Catcher& catcher = catchers[i];
+        const float left = std::min(catcher.before, catcher.left) - biggest.size - DENSITY_PARTICLE_BAND;
+        const float right = std::max(catcher.before, catcher.left) + path.width + DENSITY_PARTICLE_BAND;
+        const float top = path.top - biggest.height - DENSITY_PARTICLE_BAND;
+        const float bottom = path.top + path.height + DENSITY_PARTICLE_BAND;
+        const std::size_t firstColumn = static_cast<std::size_t>(std::max(std::floor(left / DENSITY_CELL_SIZE), 0.0f));
+        const std::size_t lastColumn = static_cast<std::size_t>(std::min(std::ceil(right / DENSITY_CELL_SIZE), static_cast<float>(columns)));
+        const std::size_t firstRow = static_cast<std::size_t>(std::max(std::floor((top - gridTop) / DENSITY_CELL_SIZE), 0.0f));
+        const std::size_t lastRow = static_cast<std::size_t>(std::min(std::ceil((bottom - gridTop) / DENSITY_CELL_SIZE), static_cast<float>(rows)));
+        for (std::size_t r = firstRow; r < lastRow; ++r) {
+            std::fill(&band[r * columns + firstColumn], &band[r * columns] + lastColumn, 1);
+        }
+    }
+}
+
+void DensityRain::moveParticles(const PersonPath* people, std::size_t count, float deltaTime, bool windy) {
+    const WindGrid grid = wind.getGrid();
+    const float width = static_cast<float>(windowSize.x);
+    std::size_t kept = 0;
+    for (std::size_t k = 0; k < particles.size(); ++k) {
+        Particle particle = particles[k];
+        const Layer& layer = layers[particle.layer];
+        const float dx = windy ? windAt(grid, particle.x, particle.y) * deltaTime : 0.0f;
+        const float dy = layer.speed * deltaTime;
+        const float moved = particle.x + dx;
+        const float x = moved - std::floor(moved / width) * width;
+        const float y = particle.y + dy;
+        const float shadow = shadowTop[std::min(static_cast<std::size_t>(x), shadowTop.size() - 1)];
+        const float reach = (std::min(y, shadow) - particle.y) / dy;
+
+        // The first person it meets catches it, as RainSystem's drops go to everyone they meet
+        // in the step but a drop here is water that can only be caught once
+        bool caught = false;
+        for (std::size_t i = 0; i < count && !caught; ++i) {
+            const PersonPath& path = people[i];
+            Catcher& catcher = catchers[i];
+            const float boxDx = catcher.left - catcher.before;
+            if (sweptContact(particle.x, particle.y, particle.x + layer.size, particle.y + layer.height, dx, dy,
+                    catcher.before, path.top, catcher.before + path.width, path.top + path.height, boxDx, reach)) {
+                const float facing = path.endLeft >= path.left ? 1.0f : -1.0f;
+                const BodySurface surface = classifyHit(particle.x, particle.x + layer.size, particle.y + layer.height, dx, dy,
+                    catcher.before, path.top, catcher.before + path.width, boxDx, facing);
+                catcher.caught.add(surface, layer.dropArea);
+                caught = true;
+            }
+        }
+        if (caught || y >= shadow) {
+            continue;
+        }
+
+        const std::size_t column = std::min(static_cast<std::size_t>(x / DENSITY_CELL_SIZE), columns - 1);
+        const std::size_t row = static_cast<std::size_t>(std::max((y - gridTop) / DENSITY_CELL_SIZE, 0.0f));
+        if (row >= landRow[column]) {
+            continue;
+        }
+        const std::size_t cell = row * columns + column;
+        if (band[cell]) {
+            particle.x = x;
+            particle.y = y;
+            particles[kept++] = particle;
+        }
+        else {
+            layers[particle.layer].water[cell] += layer.dropArea;
+        }
+    }
+    particles.resize(kept);
+}
+
+void DensityRain::makeParticles() {
+    for (std::size_t k = 0; k < layers.size(); ++k) {
+        Layer& layer = layers[k];
+        for (std::size_t cell = 0; cell < band.size(); ++cell) {
+            if (!band[cell] || layer.water[cell] <= 0.0f) {
+                continue;
+            }
+            // The whole drops the water makes, and one more as often as the rest comes to, so
+            // the water is kept on average
+            const float drops = layer.water[cell] / layer.dropArea;
+            std::size_t made = static_cast<std::size_t>(drops);
+            if (rng.uniform() < drops - made) {
+                ++made;
+            }
+            layer.water[cell] = 0.0f;
+            const float left = (cell % columns) * DENSITY_CELL_SIZE;
+            const float top = gridTop + (cell / columns) * DENSITY_CELL_SIZE;
+            for (std::size_t d = 0; d < made; ++d) {
+                const Particle particle = { left + rng.uniform() * DENSITY_CELL_SIZE, top + rng.uniform() * DENSITY_CELL_SIZE, k };
+                particles.push_back(particle);
+            }
+        }
+    }
+}
+
+void DensityRain::catchIn(Layer& layer, const PersonPath& path, Catcher& catcher, float deltaTime, unsigned parts) {
+    const float before = catcher.before;
+    const float left = catcher.left;
+    const float right = left + path.width;
+    const float bottom = catcher.bottom;
+    const float catchTop = snapRow(path.top - layer.height);
+    // The rows below the top that what came in over it this step was shared into
+    const float fallen = std::min(std::ceil(layer.speed * deltaTime / DENSITY_CELL_SIZE) * DENSITY_CELL_SIZE, bottom - catchTop);
+    const float startLeft = before - layer.size;
+    const float endLeft = left - layer.size;
+    const float firstColumn = std::max(std::ceil(std::min(startLeft, endLeft) / DENSITY_CELL_SIZE - 0.5f), 0.0f);
+    const float lastColumn = std::min(std::ceil((std::max(before, left) + path.width) / DENSITY_CELL_SIZE - 0.5f), static_cast<float>(columns));
+    SurfaceWetness& caught = catcher.caught;
+    for (float c = firstColumn; c < lastColumn; ++c) {
+        const std::size_t column = static_cast<std::size_t>(c);
+        const float middle = (c + 0.5f) * DENSITY_CELL_SIZE;
+        const bool atStart = middle >= startLeft && middle < before + path.width;
+        const bool atEnd = middle >= endLeft && middle < right;
+        if (atStart && atEnd) {
+            if (parts & CATCH_FALLEN) {
+                caught.top += take(layer, column, catchTop, catchTop + fallen, 1.0f);
+            }
+            if (parts & CATCH_BLOWN) {
+                caught.add(catcher.side, take(layer, column, catchTop, bottom, 1.0f));
+            }
+        }
+        else if (atEnd && (parts & CATCH_BLOWN)) {
+            // Walked into it part way through the step: what's there now, and what fell out of
+            // the bottom since it came over the column
+            const float edge = left > before ? before + path.width : startLeft;
+            const float share = 1.0f - std::min(std::abs(middle - edge) / catcher.moved, 1.0f);
+            caught.front += take(layer, column, catchTop, bottom, 1.0f);
+            caught.top += take(layer, column, bottom, bottom + fallen, share);
+        }
+        else if (atStart && !atEnd && (parts & CATCH_FALLEN)) {
+            // Left it part way through: what fell in until then
+            const float edge = left > before ? startLeft : before + path.width;
+            const float share = std::min(std::abs(middle - edge) / catcher.moved, 1.0f);
+            caught.top += take(layer, column, catchTop, catchTop + fallen, share);
+        }
+    }
+}
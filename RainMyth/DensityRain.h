@@ -0,0 +1,141 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "EventRain.h"
+#include "RainConfig.h"
+#include "Rng.h"
+#include "Scene.h"
+#include "SurfaceWetness.h"
+#include "WindField.h"
+
+// Rain as an amount of water per cell rather than as drops, for downpours too heavy to store.
+// The sky is a grid of DENSITY_CELL_SIZE cells, one layer per DENSITY_SIZE_CLASSES slice of the
+// size distribution, each holding the area of drops of its sizes whose top left corners are in
+// the cell. Each step the spawn rate pours into the spawn strip, every layer moves down at its
+// sizes' speed and sideways with the wind, and water whose corner passes the scene's rain
+// shadow lands. A step costs the same however hard it rains, and wind is no harder than calm.
+//
+// A person catches the water in the cells whose middles are in their box, widened by a layer's
+// drop size to the left and its drop height above, as a drop there would overlap them, and the
+// water is gone from then on, so unlike the other engines one person can shelter another.
+// What fell into the box over the step wets their top, a column they walk into their front,
+// and in wind what's blown in the side it blows at. Moving water between cells spreads it out
+// a little every step, so single drops' timing is lost, but the water that crosses any line is
+// exact: in calm air the wetness comes out the same at any step. Wind spreads it sideways
+// too, which wets someone walking with or against it a few percent more at shorter steps.
+// Straight walks only, as EventRain's PersonPath describes them
+//
+// With particles, the water in the cells within DENSITY_PARTICLE_BAND of anyone's box is
+// turned into drops instead, as many of the layer's mean drop area as the water makes, and
+// those fall and blow as the stepped engine's do, hitting people by sweptContact and wetting
+// the face classifyHit says. A drop that leaves the band without landing or hitting anyone
+// goes back into the cell it's in. So the hits are single drops', at their own moments, and
+// the cost is still the grid's with only the few drops near people on top
+class DensityRain {
+public:
+    // The sky starts full, as it would be in steady calm rain
+    DensityRain(sf::Vector2u windowSize, const RainConfig& config, const Scene& scene, bool particles);
+
+    // As RainSystem's namesakes. Setting the top refills the sky
+    void setSpawnTop(float top);
+    float spawnTopAbove(float left, float right) const;
+
+    // Moves the water deltaTime on and has everyone in people catch what reaches them. Their
+    // catch is added to wetness and under the face it came in by to surfaces, when given, while
+    // they're walking; before setting off it's only taken out of the air
+    void update(float deltaTime, const PersonPath* people, std::size_t count, float* wetness, SurfaceWetness* surfaces);
+
+    float getTime() const {
+        return time;
+    }
+
+    // Area of rain in the air, in the grid and as drops
+    double airborne() const;
+
+    // Drops made out of the grid near people, none without particles
+    std::size_t particleCount() const {
+        return particles.size();
+    }
+
+private:
+    // Someone's box this step and what they've caught in it so far
+    struct Catcher {
+        float before;  // Left edge at the start of the step
+        float left;    // And at the end
+        float bottom;
+        float moved;
+        BodySurface side; // The face rain blown at them comes in by
+        SurfaceWetness caught;
+    };
+
+    // The water a catch takes: what fell in over the top this step, and the rest
+    enum CatchPart {
+        CATCH_FALLEN = 1,
+        CATCH_BLOWN = 2
+    };
+
+    struct Layer {
+        float size;   // Of the slice's middle drop, for widening the catch
+        float height;
+        float speed;  // Downwards, in pixels per second
+        float inflow; // Area entering each column of cells per second
+        float dropArea; // Mean over the slice, the water a particle carries
+        std::vector<float> water; // Row by row
+    };
+
+    sf::Vector2u windowSize;
+    std::size_t columns;
+    std::size_t rows;
+    float gridTop;  // Top of the first row: the top of the spawn strip
+    float spawnTop;
+    float time;
+    WindField wind;
+    std::vector<Layer> layers;
+    std::vector<float> shadowTop;
+    std::vector<std::size_t> landRow; // Per column, the first row whose water has landed
+    std::vector<float> stripShare;    // Per row, its share of what's spawned
+    std::vector<float> scratch;
+    std::vector<float> windSpeed;     // Per cell, this step's wind
+    std::vector<Catcher> catchers;
+
+    // A drop made out of a cell's water near someone, the layer's size, speed and drop area
+    struct Particle {
+        float x;
+        float y;
+        std::size_t layer;
+    };
+
+    bool particlesNearPeople;
+    Rng rng;
+    std::vector<Particle> particles;
+    std::vector<std::uint8_t> band; // Per cell, whether it's near enough anyone for particles
+
+    // The row boundary nearest y
+    float snapRow(float y) const;
+
+    void layout();
+    void fill();
+    void fall(Layer& layer, float deltaTime);
+    void blow(Layer& layer, float deltaTime, int substeps);
+
+    // Marks the cells near anyone in band
+    void markBand(const PersonPath* people, std::size_t count);
+
+    // Moves the particles deltaTime on, gives the ones that hit someone to their catchers and
+    // the ones that have left the band back to the grid
+    void moveParticles(const PersonPath* people, std::size_t count, float deltaTime, bool windy);
+
+    // Turns the water in the band into particles
+    void makeParticles();
+
+    // Has the person whose box catcher holds take the parts of what reached them in layer
+    void catchIn(Layer& layer, const PersonPath& path, Catcher& catcher, float deltaTime, unsigned parts);
+
+    // Takes share of the water between top and bottom in column out of layer, with the rows
+    // the two cut through counted in part, and returns the area taken
+    float take(Layer& layer, std::size_t column, float top, float bottom, float share);
+};
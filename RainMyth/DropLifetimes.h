@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include "Constants.h"
+
+// How a drop left the store
+enum DropFate {
+    FATE_GROUND, // Fell to the bottom of the screen
+    FATE_SCENE,  // Landed on a collider
+    FATE_CAUGHT, // Caught by everyone it could still wet
+    FATE_MERGED, // Coalesced into a drop near it, see RainConfig::coalesceDistance
+    FATE_COUNT
+};
+
+// How long drops lived and how they went, to tell how much of the simulation goes on drops
+// that never reach anyone. Each chunk tallies its own, like its share of the wetness, and the
+// chunks' are summed afterwards
+struct DropLifetimes {
+    std::uint64_t removed[FATE_COUNT];      // Drops that went each way
+    std::uint64_t steps[FATE_COUNT];        // The steps they lived, summed
+    std::uint64_t histogram[LIFETIME_BINS]; // Drops by steps lived, LIFETIME_BIN_STEPS to a bin
+    std::uint64_t liveSteps;                // Drops alive at each step, summed
+    std::uint64_t stepCount;
+
+    void add(DropFate fate, std::size_t lived) {
+        ++removed[fate];
+        steps[fate] += lived;
+        ++histogram[std::min(lived / LIFETIME_BIN_STEPS, LIFETIME_BINS - 1)];
+    }
+
+    DropLifetimes& operator+=(const DropLifetimes& other) {
+        for (std::size_t fate = 0; fate < FATE_COUNT; ++fate) {
+            removed[fate] += other.removed[fate];
+            steps[fate] += other.steps[fate];
+        }
+        for (std::size_t bin = 0; bin < LIFETIME_BINS; ++bin) {
+            histogram[bin] += other.histogram[bin];
+        }
+        liveSteps += other.liveSteps;
+        stepCount += other.stepCount;
+        return *this;
+    }
+
+    std::uint64_t totalRemoved() const {
+        return removed[FATE_GROUND] + removed[FATE_SCENE] + removed[FATE_CAUGHT] + removed[FATE_MERGED];
+    }
+
+    // Drops alive in the average step
+    double meanLive() const {
+        return stepCount > 0 ? static_cast<double>(liveSteps) / stepCount : 0.0;
+    }
+
+    // A line per fate with its drops' share and mean life, the average live count, and a line
+    // per bin of the histogram that has any drops in it
+    void print(std::ostream& out) const {
+        static const char* const names[FATE_COUNT] = { "ground", "scene", "caught", "merged" };
+        const std::uint64_t total = totalRemoved();
+        out << "Drop lifetimes: " << total << " removed over " << stepCount << " steps, " << meanLive() << " alive on average" << std::endl;
+        const std::uint64_t lived = steps[FATE_GROUND] + steps[FATE_SCENE] + steps[FATE_CAUGHT] + steps[FATE_MERGED];
+        for (std::size_t fate = 0; fate < FATE_COUNT; ++fate) {
+            out << "  " << names[fate] << ": " << removed[fate] << " drops, "
+                << (removed[fate] > 0 ? static_cast<double>(steps[fate]) / removed[fate] : 0.0) << " steps each, "
+                << (lived > 0 ? 100.0 * steps[fate] / lived : 0.0) << "% of drop steps" << std::endl;
+        }
+        for (std::size_t bin = 0; bin < LIFETIME_BINS; ++bin) {
+            if (histogram[bin] == 0) {
+                continue;
+            }
+            out << "  " << bin * LIFETIME_BIN_STEPS;
+            if (bin + 1 < LIFETIME_BINS) {
+                out << "-" << (bin + 1) * LIFETIME_BIN_STEPS - 1;
+            }
+            else {
+                out << "+";
+            }
+            out << " steps: " << histogram[bin] << std::endl;
+        }
+    }
+};
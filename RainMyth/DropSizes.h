@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "Constants.h"
+#include "RainConfig.h"
+#include "Rng.h"
+
+// Density of drop widths under the config's model, up to a constant factor. Marshall and
+// Palmer's N(D) = N0 exp(-lambda D) takes lambda = 4.1 R^-0.21 per mm of diameter at a rain
+// intensity of R mm/h, so heavier rain has relatively more large drops
+inline float dropSizeDensity(const RainConfig& config, float size) {
+    if (config.sizeModel == DROP_SIZES_MARSHALL_PALMER) {
+        const float lambda = 4.1f * std::pow(std::max(config.rainIntensity, 1e-3f), -0.21f);
+        return std::exp(-lambda * size * RAINDROP_MM_PER_PIXEL);
+    }
+    return 1.0f;
+}
+
+// The inverse of the size model's cumulative distribution over [minSize, maxSize], sampled
+// evenly in probability, so a width is drawn from one uniform number with a multiply-add and
+// a lerp whatever the model's shape. The distribution is integrated numerically from
+// dropSizeDensity(), so a new model only needs its density. Uniform sizes skip the table and
+// come straight from the generator, so the default rain is drawn exactly as it always was
+class DropSizeTable {
+public:
+    explicit DropSizeTable(const RainConfig& config)
+        : minSize(config.minSize), maxSize(config.maxSize), uniform(config.sizeModel == DROP_SIZES_UNIFORM),
+          quantiles(DROP_SIZE_TABLE_SIZE + 1) {
+        // Cumulative density over cells much finer than the table, then read back at even steps
+        const std::size_t cells = DROP_SIZE_TABLE_SIZE * 8;
+        const float width = std::max(maxSize - minSize, 1e-6f) / cells;
+        std::vector<double> cumulative(cells + 1, 0.0);
+        for (std::size_t i = 0; i < cells; ++i) {
+            const float below = dropSizeDensity(config, minSize + width * i);
+            const float above = dropSizeDensity(config, minSize + width * (i + 1));
+            cumulative[i + 1] = cumulative[i] + 0.5 * (below + above) * width;
+        }
+        const double total = cumulative.back() > 0.0 ? cumulative.back() : 1.0;
+        std::size_t cell = 0;
+        for (std::size_t i = 0; i < quantiles.size(); ++i) {
+            const double target = total * i / DROP_SIZE_TABLE_SIZE;
+            while (cell + 1 < cells && cumulative[cell + 1] < target) {
+                ++cell;
+            }
+            const double span = cumulative[cell + 1] - cumulative[cell];
+            const double t = span > 0.0 ? std::min(std::max((target - cumulative[cell]) / span, 0.0), 1.0) : 0.0;
+            quantiles[i] = minSize + static_cast<float>((cell + t) * width);
+        }
+        quantiles.front() = minSize;
+        quantiles.back() = maxSize;
+    }
+
+    // The width at probability u in [0, 1]
+    float lookup(float u) const {
+        if (uniform) {
+            return minSize + (maxSize - minSize) * u;
+        }
+        const float position = std::min(std::max(u, 0.0f), 1.0f) * DROP_SIZE_TABLE_SIZE;
+        const std::size_t index = std::min(static_cast<std::size_t>(position), DROP_SIZE_TABLE_SIZE - 1);
+        const float t = position - index;
+        return quantiles[index] + (quantiles[index + 1] - quantiles[index]) * t;
+    }
+
+    float draw(Rng& rng) const {
+        return uniform ? rng.uniform(minSize, maxSize) : lookup(rng.uniform());
+    }
+
+    // Fills out[0..count) with widths
+    void fill(Rng& rng, float* out, std::size_t count) const {
+        if (uniform) {
+            rng.fillUniform(out, count, minSize, maxSize);
+            return;
+        }
+        rng.fillUniform(out, count, 0.0f, 1.0f);
+        for (std::size_t i = 0; i < count; ++i) {
+            out[i] = lookup(out[i]);
+        }
+    }
+
+    // DROP_SIZE_TABLE_SIZE + 1 widths at probabilities 0, 1 / DROP_SIZE_TABLE_SIZE, ..., 1, for the GPU
+    const std::vector<float>& getQuantiles() const {
+        return quantiles;
+    }
+
+private:
+    float minSize;
+    float maxSize;
+    bool uniform;
+    std::vector<float> quantiles; // One more entry than steps, so u = 1 needs no special case
+};
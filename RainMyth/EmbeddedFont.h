@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstddef>
+
+// The HUD's font, compiled into the binary so a rendered run doesn't depend on the working
+// directory or on Windows path separators to find it. Hand it to sf::Font::loadFromMemory,
+// which reads it in place, so it must outlive the font
+extern const unsigned char ROBOTO_REGULAR_TTF[];
+extern const std::size_t ROBOTO_REGULAR_TTF_SIZE;
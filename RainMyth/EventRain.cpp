@@ -0,0 +1,199 @@
+#include "EventRain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Constants.h"
+
+float PersonPath::arrivalTime() const {
+    return startTime + std::abs(endLeft - left) / speed;
+}
+
+float PersonPath::leftAt(float time) const {
+    const float walked = std::min(std::max(time - startTime, 0.0f) * speed, std::abs(endLeft - left));
+    return endLeft >= left ? left + walked : left - walked;
+}
+
+// The box's left edge only ever moves one way, so the times it spends in (from - width, to)
+// form one interval, pieced together from the wait, the walk and the stay at the end
+bool PersonPath::overlapTimes(float from, float to, float& begin, float& end) const {
+    const float infinity = std::numeric_limits<float>::infinity();
+    const float low = from - width;
+    const float high = to;
+    const float arrival = arrivalTime();
+    begin = infinity;
+    end = -infinity;
+    auto cover = [&](float pieceBegin, float pieceEnd) {
+        if (pieceBegin < pieceEnd) {
+            begin = std::min(begin, pieceBegin);
+            end = std::max(end, pieceEnd);
+        }
+    };
+
+    if (left > low && left < high) {
+        cover(-infinity, startTime);
+    }
+    if (endLeft > low && endLeft < high) {
+        cover(arrival, infinity);
+    }
+    if (arrival > startTime) {
+        const float velocity = (endLeft - left) / (arrival - startTime);
+        float enter = startTime + (low - left) / velocity;
+        float leave = startTime + (high - left) / velocity;
+        if (enter > leave) {
+            std::swap(enter, leave);
+        }
+        cover(std::max(enter, startTime), std::min(leave, arrival));
+    }
+    return begin < end;
+}
+
+bool PersonPath::firstOverlap(float from, float to, float after, float before, float& time) const {
+    float begin = 0.0f;
+    float end = 0.0f;
+    if (!overlapTimes(from, to, begin, end)) {
+        return false;
+    }
+    begin = std::max(begin, after);
+    end = std::min(end, before);
+    if (begin >= end) {
+        return false;
+    }
+    time = begin;
+    return true;
+}
+
+namespace {
+
+// Buckets for a wheel that reaches past the longest any drop can live: from the top of the
+// spawn band, wherever that is put, to the bottom of the screen at the slowest drop's speed
+std::size_t bucketsFor(sf::Vector2u windowSize, const RainConfig& config, float timestep) {
+    const float lifetime = (windowSize.y + 2.0f * 150.0f) / terminalSpeed(config.minSize);
+    return static_cast<std::size_t>(lifetime / timestep) + 1;
+}
+
+} // namespace
+
+EventRain::EventRain(sf::Vector2u windowSize, const RainConfig& config, const Scene& scene, float timestep)
+    : windowSize(windowSize), rng(config.seed), spawnRate(config.spawnRate), spawnCarry(0.0f),
+      spawnLeft(0.0f), spawnRight(static_cast<float>(windowSize.x)), spawnTop(-50.0f),
+      minSize(config.minSize), maxSize(config.maxSize), sizes(config), speeds(config.minSize, config.maxSize),
+      shadowTop(scene.rainShadow(windowSize)), events(timestep, bucketsFor(windowSize, config, timestep)), capacity(config.maxDrops), live(0), now(0.0f) {}
+
+void EventRain::setSpawnBand(float left, float right) {
+    spawnLeft = std::max(left, 0.0f);
+    spawnRight = std::max(std::min(right, static_cast<float>(windowSize.x)), spawnLeft);
+}
+
+void EventRain::setSpawnTop(float top) {
+    spawnTop = top;
+}
+
+float EventRain::spawnTopAbove(float left, float right) const {
+    float highest = static_cast<float>(windowSize.y);
+    for (std::size_t column = columnOf(left); column <= columnOf(right); ++column) {
+        highest = std::min(highest, shadowTop[column]);
+    }
+    return highest - RainField::heightOf(maxSize);
+}
+
+void EventRain::addPerson(const PersonPath& path) {
+    if (people.size() < MAX_PEOPLE) {
+        people.push_back(path);
+    }
+}
+
+void EventRain::update(float deltaTime, float* wetness, SurfaceWetness* surfaces) {
+    const float end = now + deltaTime;
+    events.popUntil(end, [&](const Event& event) {
+        if (event.kind == EVENT_REMOVE) {
+            freeSlots.push_back(event.drop);
+            --live;
+            return;
+        }
+        const PersonPath& path = people[event.person];
+        if (event.time >= path.startTime && event.time <= path.arrivalTime()) {
+            const float area = RainField::areaOf(drops[event.drop].size);
+            wetness[event.person] += area;
+            if (surfaces) {
+                surfaces[event.person].add(static_cast<BodySurface>(event.surface), area);
+            }
+        }
+    });
+    now = end;
+
+    // Same bookkeeping as RainSystem, so both spawn the same number of drops per second
+    const float expected = spawnRate * (spawnRight - spawnLeft) * deltaTime + spawnCarry;
+    const std::size_t count = static_cast<std::size_t>(expected);
+    spawnCarry = expected - count;
+    for (std::size_t i = 0; i < count; ++i) {
+        spawn(now);
+    }
+}
+
+// Draws a drop and schedules everything that will happen to it: a catch for each person it
+// touches before it lands, then its removal, once it lands or the last of them has it
+void EventRain::spawn(float time) {
+    if (live >= capacity) {
+        return;
+    }
+    Drop drop;
+    drop.x = rng.uniform(spawnLeft, spawnRight);
+    drop.y = rng.uniform(spawnTop - 50.0f, spawnTop);
+    drop.size = sizes.draw(rng);
+    drop.vy = std::max(speeds.lookup(drop.size), 1e-3f);
+    drop.spawnTime = time;
+
+    std::uint32_t slot;
+    if (freeSlots.empty()) {
+        slot = static_cast<std::uint32_t>(drops.size());
+        drops.push_back(drop);
+    }
+    else {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+        drops[slot] = drop;
+    }
+    ++live;
+
+    // A drop can touch things until its top edge passes the shadow, as in the swept test
+    const float height = RainField::heightOf(drop.size);
+    const float landing = time + std::max(shadowTop[columnOf(drop.x)] - drop.y, 0.0f) / drop.vy;
+    float lastCatch = time;
+    std::size_t caughtBy = 0;
+    for (std::size_t p = 0; p < people.size(); ++p) {
+        const PersonPath& path = people[p];
+        const float reach = time + std::max(path.top - height - drop.y, 0.0f) / drop.vy;
+        const float pass = time + (path.top + path.height - drop.y) / drop.vy;
+        float caughtAt = 0.0f;
+        if (path.firstOverlap(drop.x, drop.x + drop.size, reach, std::min(pass, landing), caughtAt)) {
+            // Caught the moment it reached their height, it came down on them; any later and
+            // they walked into it
+            const BodySurface surface = caughtAt > reach ? SURFACE_FRONT : SURFACE_TOP;
+            const Event event = { caughtAt, slot, EVENT_CATCH, static_cast<std::uint8_t>(surface), static_cast<std::uint16_t>(p) };
+            events.push(caughtAt, event);
+            lastCatch = std::max(lastCatch, caughtAt);
+            ++caughtBy;
+        }
+    }
+    const float removal = caughtBy == people.size() && caughtBy > 0 ? lastCatch : landing;
+    drops[slot].removeTime = removal;
+    const Event event = { removal, slot, EVENT_REMOVE, SURFACE_TOP, 0 };
+    events.push(removal, event);
+}
+
+void EventRain::positionsAt(float time, RainField& out) const {
+    out.clear();
+    for (const Drop& drop : drops) {
+        // Free slots hold drops removed by now, so the time range leaves them out too
+        if (drop.spawnTime <= time && time < drop.removeTime && !out.add(drop.x, drop.y + drop.vy * (time - drop.spawnTime), drop.vy, drop.size)) {
+            return;
+        }
+    }
+}
+
+std::size_t EventRain::columnOf(float x) const {
+    const float column = std::min(std::max(x, 0.0f), static_cast<float>(shadowTop.size() - 1));
+    return static_cast<std::size_t>(column);
+}
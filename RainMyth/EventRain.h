@@ -0,0 +1,142 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CalendarQueue.h"
+#include "DropSizes.h"
+#include "RainConfig.h"
+#include "RainField.h"
+#include "Rng.h"
+#include "Scene.h"
+#include "SurfaceWetness.h"
+#include "TerminalVelocity.h"
+
+// Where a person is over time when it's known in advance: standing with their box at
+// (left, top) until startTime, walking at speed to endLeft in a straight line, then standing there
+struct PersonPath {
+    float left;
+    float top;
+    float width;
+    float height;
+    float endLeft;
+    float speed;
+    float startTime;
+
+    float arrivalTime() const;
+
+    // Left edge of their box at time
+    float leftAt(float time) const;
+
+    // The times their box overlaps columns (from, to) with the strict rule of
+    // sf::FloatRect::intersects, as [begin, end), unbounded on either side if they stand over
+    // them before setting off or after arriving. Returns false if it never does
+    bool overlapTimes(float from, float to, float& begin, float& end) const;
+
+    // The earliest time their box overlaps columns (from, to) within times (after, before).
+    // Returns false if it never does
+    bool firstOverlap(float from, float to, float after, float before, float& time) const;
+};
+
+// Event-driven rain for headless runs in calm air. A drop falls in a straight line at its
+// terminal speed, so the moment it lands and the moment it first touches each person on a
+// known path are solved for when it spawns. Those moments go into a calendar queue with one
+// bucket per step, and a step only spawns its drops and handles the events in its bucket:
+// there is no per-drop work between spawn and impact, and scheduling an event and handling it
+// are O(1) amortized, so a step costs what its own events do rather than O(N).
+//
+// The rules follow RainSystem: the same spawn band and rate, a drop caught by a person counts
+// once for them and dies once everyone has caught it, and rain lands at the scene's shadow.
+// Contact is continuous rather than tested step by step, so counts differ slightly from
+// RainSystem's at coarse steps. Wind can't be solved this way, so the caller must use
+// RainSystem when there is any
+class EventRain {
+public:
+    // timestep is the step update() will be called with, which sizes the event queue's buckets
+    EventRain(sf::Vector2u windowSize, const RainConfig& config, const Scene& scene, float timestep);
+
+    // As RainSystem's namesakes
+    void setSpawnBand(float left, float right);
+    void setSpawnTop(float top);
+    float spawnTopAbove(float left, float right) const;
+
+    // Adds someone to catch rain, up to MAX_PEOPLE, before the first update. Only what they
+    // catch between setting off and arriving is counted
+    void addPerson(const PersonPath& path);
+
+    // Spawns deltaTime's worth of drops and handles every impact until then, adding the area
+    // of each drop a person catches on their way to wetness[person], and to surfaces[person]
+    // under the face it came in by if given. In still air a drop only comes down onto someone
+    // or gets walked into, so nothing reaches a back
+    void update(float deltaTime, float* wetness, SurfaceWetness* surfaces = nullptr);
+
+    // Simulated time so far
+    float getTime() const {
+        return now;
+    }
+
+    const PersonPath& getPerson(std::size_t person) const {
+        return people[person];
+    }
+
+    // Drops in the air
+    std::size_t count() const {
+        return live;
+    }
+
+    // Puts every drop in the air at time, no later than getTime(), into out in place of what it
+    // held, each where its straight fall from its spawn has taken it by then. Drops are never
+    // moved in between, so this is the only work positions cost, and only when someone looks.
+    // Drops that don't fit out are left out
+    void positionsAt(float time, RainField& out) const;
+
+private:
+    struct Drop {
+        float x;
+        float y;        // Top edge at spawnTime
+        float vy;
+        float size;
+        float spawnTime;
+        float removeTime; // When it lands or the last person catches it
+    };
+
+    // A step handles its events in no particular order. A removed drop's slot is only reused
+    // by the spawns after them, so a catch in the same step as its removal still finds the drop
+    enum EventKind {
+        EVENT_CATCH,
+        EVENT_REMOVE
+    };
+
+    struct Event {
+        float time;
+        std::uint32_t drop;
+        std::uint8_t kind;
+        std::uint8_t surface; // BodySurface a catch came in by
+        std::uint16_t person;
+    };
+
+    sf::Vector2u windowSize;
+    Rng rng;
+    float spawnRate;
+    float spawnCarry;
+    float spawnLeft;
+    float spawnRight;
+    float spawnTop;
+    float minSize;
+    float maxSize;
+    DropSizeTable sizes;
+    TerminalVelocityTable speeds;
+    std::vector<float> shadowTop;
+    std::vector<PersonPath> people;
+    std::vector<Drop> drops;           // Slots, reused through freeSlots
+    std::vector<std::uint32_t> freeSlots;
+    CalendarQueue<Event> events;
+    std::size_t capacity;
+    std::size_t live;
+    float now;
+
+    void spawn(float time);
+    std::size_t columnOf(float x) const;
+};
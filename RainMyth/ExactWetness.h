@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Analytic.h"
+#include "Headless.h"
+#include "Options.h"
+#include "Scene.h"
+
+// Expected wetness of crossing in calm air, integrated over everything that can reach the
+// person rather than sampled, with the scene's shelter and ProceduralRain's contact rules.
+//
+// A drop falls in a straight line at its speed, so for a given size and column the spawn
+// times from which it is caught, counted while they cross, form one interval: from when it
+// would pass their feet just as they come over the column to when it would reach their head
+// just as they leave, cut short where it lands first or where they'd have caught it before
+// setting off. Its length times the spawn rate is the catch per pixel of that column, so the
+// wetness is that integrated over the columns and the size distribution, which is done here
+// by the midpoint rule, finely enough that what's left is rounding. Independent of any seed:
+// the ground truth the simulated engines' means should come out at. Shelter drips aren't
+// modelled, as in ProceduralRain
+WetnessEstimate integrateCrossing(const Options& options, const Crossing& crossing, const Scene& scene);
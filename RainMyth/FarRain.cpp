@@ -0,0 +1,147 @@
+#include "FarRain.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+#include "Constants.h"
+#include "SfmlCompat.h"
+#include "ShaderCompiler.h"
+#include "TerminalVelocity.h"
+
+namespace {
+
+// gl_FragCoord is in the target's pixels, counting up from its bottom, so it's mapped back into
+// the world through the view's viewport: pixelOrigin is the world's top-left corner in those
+// pixels and unitsPerPixel how much world each covers. Each lane gets a hashed phase and speed; one streak head passes every period pixels, and its
+// tail fades out over the distance it falls in a thirtieth of a second. laneOffset moves each
+// depth layer's hashes off the others', so their lanes don't line up
+const char* FAR_RAIN_FRAGMENT_SHADER = R"(
+#version 120
+uniform float time;
+uniform vec2 pixelOrigin;
+uniform vec2 unitsPerPixel;
+uniform float speed;
+uniform float lanePeriod;
+uniform float laneWidth;
+uniform float laneOffset;
+uniform vec4 color;
+
+float hash(float n) {
+    return fract(sin(n) * 43758.5453);
+}
+
+void main() {
+    float x = (gl_FragCoord.x - pixelOrigin.x) * unitsPerPixel.x;
+    float y = (pixelOrigin.y - gl_FragCoord.y) * unitsPerPixel.y;
+    float lane = floor(x / laneWidth) + laneOffset;
+    if (fract(x / laneWidth) > max(1.0, unitsPerPixel.x) / laneWidth) {
+        discard;
+    }
+
+    float laneSpeed = speed * (0.75 + 0.5 * hash(lane * 78.233));
+    float period = lanePeriod * laneSpeed / speed;
+    float behind = (1.0 - fract((y - time * laneSpeed) / period + hash(lane * 12.9898))) * period;
+    float tail = laneSpeed / 30.0;
+    if (behind > tail) {
+        discard;
+    }
+    gl_FragColor = vec4(color.rgb, color.a * (1.0 - behind / tail));
+}
+)";
+
+} // namespace
+
+FarRain::FarRain(const RainConfig& config, sf::Vector2u screen, bool background)
+    : screen(screen), nearLeft(0.0f), nearRight(0.0f), time(0.0f), depthLayers(0) {
+    // A lane laneWidth pixels wide sees spawnRate * laneWidth drops a second. At speed v that
+    // puts one drop every v / (spawnRate * laneWidth) pixels down the lane
+    speed = terminalSpeed((config.minSize + config.maxSize) * 0.5f);
+    lanePeriod = speed / std::max(config.spawnRate * 3.0f, 1e-3f);
+    if (!sf::Shader::isAvailable()) {
+        return;
+    }
+    if (background) {
+        compileShaderInBackground(compiling, nullptr, nullptr, FAR_RAIN_FRAGMENT_SHADER);
+        return;
+    }
+    adopt(compileShader(nullptr, nullptr, FAR_RAIN_FRAGMENT_SHADER));
+}
+
+void FarRain::poll() {
+    if (compiling.pending()) {
+        adopt(compiling.take());
+    }
+}
+
+void FarRain::adopt(std::unique_ptr<sf::Shader> compiled) {
+    shader = std::move(compiled);
+}
+
+void FarRain::setDepthLayers(unsigned count) {
+    depthLayers = std::min(count, MAX_DEPTH_LAYERS);
+}
+
+void FarRain::setLayer(sf::RenderTarget& target, unsigned depth, sf::Color color, float lag) const {
+    // Rain depth layers back is seen at 1 / (depth + 1) the scale: it falls that much slower
+    // across the screen, in lanes that much narrower, so more of it shows through the same
+    // width, and fainter for the air in front of it
+    const float scale = 1.0f / (depth + 1.0f);
+    shader->setUniform("speed", speed * scale);
+    shader->setUniform("lanePeriod", lanePeriod * scale);
+    shader->setUniform("laneWidth", 3.0f * scale);
+    shader->setUniform("laneOffset", 7919.0f * depth);
+    color.a = static_cast<std::uint8_t>(color.a * scale);
+    shader->setUniform("color", sf::Glsl::Vec4(color));
+
+    shader->setUniform("time", time - lag);
+    const sf::IntRect viewport = target.getViewport(target.getView());
+    const sf::Vector2f unitsPerPixel(screen.x / static_cast<float>(std::max(rectWidth(viewport), 1)), screen.y / static_cast<float>(std::max(rectHeight(viewport), 1)));
+    shader->setUniform("pixelOrigin", sf::Glsl::Vec2(static_cast<float>(rectLeft(viewport)), static_cast<float>(target.getSize().y - rectTop(viewport))));
+    shader->setUniform("unitsPerPixel", sf::Glsl::Vec2(unitsPerPixel));
+}
+
+void FarRain::drawDepth(sf::RenderTarget& target, sf::Color color, float lag) const {
+    if (!shader) {
+        return;
+    }
+    const float width = static_cast<float>(screen.x);
+    const float height = static_cast<float>(screen.y);
+    sf::Vertex screenQuad[QUAD_VERTICES];
+    writeQuad(screenQuad, sf::Vertex{ sf::Vector2f(0.0f, 0.0f) }, sf::Vertex{ sf::Vector2f(width, 0.0f) },
+        sf::Vertex{ sf::Vector2f(width, height) }, sf::Vertex{ sf::Vector2f(0.0f, height) });
+    for (unsigned depth = depthLayers; depth > 0; --depth) {
+        setLayer(target, depth, color, lag);
+        target.draw(screenQuad, QUAD_VERTICES, QUAD_PRIMITIVE, shader.get());
+    }
+}
+
+void FarRain::draw(sf::RenderTarget& target, sf::Color color, float lag) const {
+    if (!shader) {
+        return;
+    }
+    setLayer(target, 0, color, lag);
+
+    // Everything left and right of the near band, as plain quads: a RectangleShape would
+    // rebuild its outline and fill vertices, on the heap, every frame
+    const float width = static_cast<float>(screen.x);
+    const float height = static_cast<float>(screen.y);
+    const float left = std::max(nearLeft, 0.0f);
+    const float right = std::min(nearRight, width);
+    sf::Vertex sides[2 * QUAD_VERTICES];
+    std::size_t count = 0;
+    const auto addSide = [&](float from, float to) {
+        writeQuad(sides + count, sf::Vertex{ sf::Vector2f(from, 0.0f) }, sf::Vertex{ sf::Vector2f(to, 0.0f) },
+            sf::Vertex{ sf::Vector2f(to, height) }, sf::Vertex{ sf::Vector2f(from, height) });
+        count += QUAD_VERTICES;
+    };
+    if (left > 0.0f) {
+        addSide(0.0f, left);
+    }
+    if (right < width) {
+        addSide(right, width);
+    }
+    if (count > 0) {
+        target.draw(sides, count, QUAD_PRIMITIVE, shader.get());
+    }
+}
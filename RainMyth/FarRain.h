@@ -0,0 +1,79 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <memory>
+
+#include "RainConfig.h"
+#include "Scene.h"
+#include "Startup.h"
+
+// The cheap half of level-of-detail rain. Only drops that can reach the person or land on the
+// scene need simulating, so RainSystem spawns in a near band around them and this layer fills
+// the rest of the screen with rain drawn procedurally by a fragment shader: streaks in 3 pixel
+// lanes, scrolling down at terminal speed, spaced so each lane passes as many drops per second
+// as the simulated rain would. Nothing is stored per drop, so the far layer costs the same
+// however wide the screen is. isAvailable() is false without shader support, and the caller
+// should simulate the whole screen instead.
+//
+// The same shader draws depth layers behind it: rain further off, over the whole screen, each
+// layer slower, finer, denser and fainter than the one in front, for depth without simulating
+// a drop more. Only the simulated rain, the one level with the person, reaches anyone
+class FarRain {
+public:
+    // In the background, the shader is compiled on a thread of its own, in a GL context shared
+    // with the window's, so the first frame doesn't wait on the driver's compiler. Until
+    // isCompiling() turns false, after a poll(), the layer isn't available
+    FarRain(const RainConfig& config, sf::Vector2u screen, bool background = false);
+
+    bool isAvailable() const {
+        return shader != nullptr;
+    }
+
+    bool isCompiling() const {
+        return compiling.pending();
+    }
+
+    // Takes the shader over if the background compile has finished
+    void poll();
+
+    // Columns [left, right) belong to the near layer and are left alone
+    void setNearBand(float left, float right) {
+        nearLeft = left;
+        nearRight = right;
+    }
+
+    // How many depth layers drawDepth draws, up to MAX_DEPTH_LAYERS
+    void setDepthLayers(unsigned count);
+
+    unsigned getDepthLayers() const {
+        return depthLayers;
+    }
+
+    void update(float deltaTime) {
+        time += deltaTime;
+    }
+
+    // Draws the streaks where they were lag seconds ago, to match near rain drawn between steps
+    void draw(sf::RenderTarget& target, sf::Color color, float lag = 0.0f) const;
+
+    // Draws the depth layers, furthest first, as one full-screen batch each. Goes before the
+    // near rain and draw()
+    void drawDepth(sf::RenderTarget& target, sf::Color color, float lag = 0.0f) const;
+
+private:
+    void adopt(std::unique_ptr<sf::Shader> compiled);
+
+    // Sets the uniforms that place the layer depth layers in front, 0 being the near rain's,
+    // and the time and viewport every layer shares
+    void setLayer(sf::RenderTarget& target, unsigned depth, sf::Color color, float lag) const;
+
+    std::unique_ptr<sf::Shader> shader;
+    Deferred<sf::Shader> compiling;
+    sf::Vector2u screen;
+    float nearLeft;
+    float nearRight;
+    float time;
+    float speed;
+    float lanePeriod;
+    unsigned depthLayers;
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// FNV-1a, 64-bit, fed a field at a time. Fields go in as their bytes in the machine's own
+// order, so a fingerprint is only comparable with others taken on the same kind of machine
+class Fingerprint {
+public:
+    Fingerprint() : hash(14695981039346656037ull) {}
+
+    void addBytes(const void* data, std::size_t bytes) {
+        const unsigned char* at = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < bytes; ++i) {
+            hash = (hash ^ at[i]) * 1099511628211ull;
+        }
+    }
+
+    template <typename T>
+    void add(const T& value) {
+        addBytes(&value, sizeof(value));
+    }
+
+    void add(const std::string& text) {
+        add(static_cast<std::uint64_t>(text.size()));
+        addBytes(text.data(), text.size());
+    }
+
+    std::uint64_t value() const {
+        return hash;
+    }
+
+private:
+    std::uint64_t hash;
+};
@@ -0,0 +1,55 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+
+FrameArena::FrameArena(std::size_t capacity)
+    : current(0), offset(0), before(0), highWater(0) {
+    addBlock(std::max<std::size_t>(capacity, 1));
+}
+
+void FrameArena::reset() {
+    if (blocks.size() > 1) {
+        blocks.clear();
+        addBlock(highWater);
+    }
+    current = 0;
+    offset = 0;
+    before = 0;
+}
+
+MemoryUsage FrameArena::memoryUsage() const {
+    MemoryUsage usage = { 0, highWater };
+    for (const Block& block : blocks) {
+        usage.reserved += block.size;
+    }
+    return usage;
+}
+
+// The space skipped at the end of a block that couldn't fit an allocation counts as in use,
+// so the high-water mark is always enough to hold the same allocations in one block
+void* FrameArena::allocateBytes(std::size_t bytes, std::size_t alignment) {
+    for (;;) {
+        const Block& block = blocks[current];
+        const std::size_t start = (offset + alignment - 1) / alignment * alignment;
+        if (start + bytes <= block.size) {
+            offset = start + bytes;
+            highWater = std::max(highWater, before + offset);
+            return block.bytes.get() + start;
+        }
+        // Blocks chained on earlier are still there after a rewind, so they're used again
+        // before asking the heap for another
+        if (current + 1 == blocks.size()) {
+            addBlock(std::max(block.size, bytes + alignment));
+        }
+        before += blocks[current].size;
+        ++current;
+        offset = 0;
+    }
+}
+
+void FrameArena::addBlock(std::size_t size) {
+    Block block;
+    block.bytes.reset(new unsigned char[size]);
+    block.size = size;
+    blocks.push_back(std::move(block));
+}
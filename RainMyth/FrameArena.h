@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "Constants.h"
+#include "MemoryUsage.h"
+
+// Linear allocator for scratch data that lives no longer than a frame. Allocating bumps an
+// offset into a block and nothing is freed on its own: reset() drops everything at once, and
+// a Scope gives back whatever was taken while it was open. A block that runs out chains on
+// another from the heap, and the next reset() swaps the chain for one block as large as the
+// most ever in use, so after the first few frames the arena never goes near the heap.
+//
+// Destructors are never run, so only trivially destructible types can be allocated. One
+// thread at a time
+class FrameArena {
+public:
+    explicit FrameArena(std::size_t capacity = FRAME_ARENA_BYTES);
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Room for count uninitialized values of T, valid until the next reset() or until the
+    // Scope open when it was taken closes
+    template <typename T>
+    T* allocate(std::size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "FrameArena never runs destructors");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "Blocks are only aligned for fundamental types");
+        return static_cast<T*>(allocateBytes(count * sizeof(T), alignof(T)));
+    }
+
+    // Drops every allocation. Where the last frames spilled into more blocks, they're replaced
+    // by one that holds as much as was ever in use
+    void reset();
+
+    // How far into the arena allocation has got, to rewind() to later
+    struct Mark {
+        std::size_t block;
+        std::size_t offset;
+        std::size_t before; // Bytes in the blocks ahead of block
+    };
+
+    Mark mark() const {
+        const Mark here = { current, offset, before };
+        return here;
+    }
+
+    // Gives back everything allocated since at was taken
+    void rewind(const Mark& at) {
+        current = at.block;
+        offset = at.offset;
+        before = at.before;
+    }
+
+    // Rewinds the arena to where it was when the scope opened once it closes
+    class Scope {
+    public:
+        explicit Scope(FrameArena& arena) : arena(arena), start(arena.mark()) {}
+        ~Scope() {
+            arena.rewind(start);
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        FrameArena& arena;
+        Mark start;
+    };
+
+    // Every block held, of which the most ever in use at once
+    MemoryUsage memoryUsage() const;
+
+private:
+    struct Block {
+        std::unique_ptr<unsigned char[]> bytes;
+        std::size_t size;
+    };
+
+    std::vector<Block> blocks;
+    std::size_t current; // Block being allocated from
+    std::size_t offset;  // Into it
+    std::size_t before;
+    std::size_t highWater;
+
+    void* allocateBytes(std::size_t bytes, std::size_t alignment);
+    void addBlock(std::size_t size);
+};
@@ -0,0 +1,244 @@
+#include "FrameCapture.h"
+
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/OpenGL.hpp>
+#include <SFML/Window/Context.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#include "Instrument.h"
+#include "IoService.h"
+#include "SfmlCompat.h"
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+namespace {
+
+// Pixel buffer objects are OpenGL 2.1, past what the Windows headers declare
+const GLenum GL_PIXEL_PACK_BUFFER_ = 0x88EB;
+const GLenum GL_STREAM_READ_ = 0x88E1;
+const GLenum GL_READ_ONLY_ = 0x88B8;
+
+struct PixelBufferFunctions {
+    void (APIENTRY* genBuffers)(GLsizei, GLuint*);
+    void (APIENTRY* deleteBuffers)(GLsizei, const GLuint*);
+    void (APIENTRY* bindBuffer)(GLenum, GLuint);
+    void (APIENTRY* bufferData)(GLenum, std::ptrdiff_t, const void*, GLenum);
+    void* (APIENTRY* mapBuffer)(GLenum, GLenum);
+    GLboolean (APIENTRY* unmapBuffer)(GLenum);
+};
+
+PixelBufferFunctions gl;
+
+template <typename Fn>
+bool loadFunction(Fn& fn, const char* name) {
+    fn = reinterpret_cast<Fn>(sf::Context::getFunction(name));
+    return fn != nullptr;
+}
+
+bool loadFunctions() {
+    return loadFunction(gl.genBuffers, "glGenBuffers") && loadFunction(gl.deleteBuffers, "glDeleteBuffers")
+        && loadFunction(gl.bindBuffer, "glBindBuffer") && loadFunction(gl.bufferData, "glBufferData")
+        && loadFunction(gl.mapBuffer, "glMapBuffer") && loadFunction(gl.unmapBuffer, "glUnmapBuffer");
+}
+
+std::size_t bytesFor(sf::Vector2u size) {
+    return static_cast<std::size_t>(size.x) * size.y * 4;
+}
+
+} // namespace
+
+FrameCapture::FrameCapture(const std::string& directory, bool dropWhenBehind)
+    : directory(directory), dropWhenBehind(dropWhenBehind), pixelBuffers(false), bufferSize(0, 0), frames(0), dropped(0),
+      stopping(false) {
+    pixelBuffers = loadFunctions();
+    if (!pixelBuffers) {
+        std::cerr << "No pixel buffer objects, capturing without async readback" << std::endl;
+    }
+    for (Readback& readback : readbacks) {
+        readback.buffer = 0;
+        readback.pending = false;
+        if (pixelBuffers) {
+            gl.genBuffers(1, &readback.buffer);
+        }
+    }
+    for (std::uint32_t frame = 0; frame < CAPTURE_FRAMES; ++frame) {
+        freeFrames.push(frame);
+    }
+    encoder = std::thread(&FrameCapture::encode, this);
+}
+
+FrameCapture::~FrameCapture() {
+    resize(sf::Vector2u(0, 0)); // Collects what's in flight
+    if (pixelBuffers) {
+        for (Readback& readback : readbacks) {
+            gl.deleteBuffers(1, &readback.buffer);
+        }
+    }
+    stopping = true;
+    wake.notify_one();
+    encoder.join();
+    ioService().drain();
+    std::cout << "Captured " << frames - dropped << " frames to " << directory;
+    if (dropped > 0) {
+        std::cout << ", dropped " << dropped << " while the encoder was behind";
+    }
+    std::cout << std::endl;
+}
+
+MemoryUsage FrameCapture::memoryUsage() const {
+    MemoryUsage usage = MemoryUsage();
+    for (const std::vector<std::uint8_t>& frame : pixels) {
+        usage += vectorUsage(frame);
+    }
+    if (pixelBuffers) {
+        const MemoryUsage gpu = { CAPTURE_READBACKS * bytesFor(bufferSize), CAPTURE_READBACKS * bytesFor(bufferSize) };
+        usage += gpu;
+    }
+    return usage;
+}
+
+void FrameCapture::capture(sf::RenderTarget& target) {
+    if (!target.setActive(true)) {
+        return;
+    }
+    const sf::Vector2u size = target.getSize();
+    const std::uint64_t number = frames++;
+    if (!pixelBuffers) {
+        std::uint32_t frame = 0;
+        if (takeFrame(frame)) {
+            pixels[frame].resize(bytesFor(size));
+            glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, pixels[frame].data());
+            send(frame, number, size);
+        }
+        return;
+    }
+
+    if (size != bufferSize) {
+        resize(size);
+    }
+
+    // The read that went into this buffer a ring ago has had the frames since to finish
+    Readback& readback = readbacks[number % CAPTURE_READBACKS];
+    if (readback.pending) {
+        collect(readback);
+    }
+    gl.bindBuffer(GL_PIXEL_PACK_BUFFER_, readback.buffer);
+    glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    gl.bindBuffer(GL_PIXEL_PACK_BUFFER_, 0);
+    readback.pending = true;
+    readback.number = number;
+    readback.size = size;
+}
+
+// A free frame buffer, waited for if frames mustn't be dropped. Returns false, counting the
+// frame as dropped, if there's none
+bool FrameCapture::takeFrame(std::uint32_t& frame) {
+    for (;;) {
+        if (const std::uint32_t* free = freeFrames.peek()) {
+            frame = *free;
+            freeFrames.pop();
+            return true;
+        }
+        if (dropWhenBehind) {
+            ++dropped;
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void FrameCapture::send(std::uint32_t frame, std::uint64_t number, sf::Vector2u size) {
+    const Job job = { frame, number, size, true };
+    jobs.push(job); // Never full: there are only CAPTURE_FRAMES frames to send
+    wake.notify_one();
+}
+
+void FrameCapture::collect(Readback& readback) {
+    readback.pending = false;
+    std::uint32_t frame = 0;
+    if (!takeFrame(frame)) {
+        return;
+    }
+    pixels[frame].resize(bytesFor(readback.size));
+    gl.bindBuffer(GL_PIXEL_PACK_BUFFER_, readback.buffer);
+    if (const void* mapped = gl.mapBuffer(GL_PIXEL_PACK_BUFFER_, GL_READ_ONLY_)) {
+        std::memcpy(pixels[frame].data(), mapped, pixels[frame].size());
+        gl.unmapBuffer(GL_PIXEL_PACK_BUFFER_);
+        send(frame, readback.number, readback.size);
+    }
+    else {
+        // The encoder is the free queue's one producer, so the frame goes back by way of it
+        const Job unused = { frame, readback.number, readback.size, false };
+        jobs.push(unused);
+        ++dropped;
+    }
+    gl.bindBuffer(GL_PIXEL_PACK_BUFFER_, 0);
+}
+
+// Collects every pending read, oldest first, then reallocates the pixel buffers for size
+void FrameCapture::resize(sf::Vector2u size) {
+    if (!pixelBuffers) {
+        return;
+    }
+    for (std::uint64_t i = 0; i < CAPTURE_READBACKS; ++i) {
+        Readback& readback = readbacks[(frames + i) % CAPTURE_READBACKS];
+        if (readback.pending) {
+            collect(readback);
+        }
+    }
+    bufferSize = size;
+    if (bytesFor(size) == 0) {
+        return;
+    }
+    for (Readback& readback : readbacks) {
+        gl.bindBuffer(GL_PIXEL_PACK_BUFFER_, readback.buffer);
+        gl.bufferData(GL_PIXEL_PACK_BUFFER_, static_cast<std::ptrdiff_t>(bytesFor(size)), nullptr, GL_STREAM_READ_);
+    }
+    gl.bindBuffer(GL_PIXEL_PACK_BUFFER_, 0);
+}
+
+// Encoder thread: writes frames as they arrive until told to stop and the queue is empty
+void FrameCapture::encode() {
+    RAINMYTH_THREAD("Capture encoder");
+    sf::Image image;
+    for (;;) {
+        const Job* job = jobs.peek();
+        if (job == nullptr) {
+            if (stopping) {
+                return;
+            }
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait_for(lock, std::chrono::milliseconds(10));
+            continue;
+        }
+        if (!job->filled) {
+            freeFrames.push(job->frame);
+            jobs.pop();
+            continue;
+        }
+
+        RAINMYTH_ZONE("Encode frame");
+
+        // GL reads rows bottom up
+        createImage(image, job->size, pixels[job->frame].data());
+        image.flipVertically();
+        // Encoded here and written on the I/O thread, so the next frame doesn't wait on the disk
+        char name[32];
+        std::snprintf(name, sizeof(name), "/frame_%06llu.png", static_cast<unsigned long long>(job->number));
+        std::vector<std::uint8_t> encoded;
+        if (saveImageToMemory(image, "png", encoded)) {
+            ioService().writeFile(directory + name, std::move(encoded));
+        }
+        else {
+            std::cerr << "Couldn't encode " << directory << name << std::endl;
+        }
+        freeFrames.push(job->frame);
+        jobs.pop();
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Constants.h"
+#include "MemoryUsage.h"
+#include "SpscQueue.h"
+
+// Writes what a render target shows to a numbered PNG sequence without waiting on the GPU or
+// the disk. Each capture() only queues a read of the frame into one of a small ring of pixel
+// buffers, and the frame that went into the same buffer CAPTURE_READBACKS frames earlier is
+// mapped and copied out, by which time the GPU has long finished it. The copies go to a worker
+// thread that flips and encodes them for the I/O thread to write, see IoService.h, through
+// lock-free queues and a fixed pool of CAPTURE_FRAMES frame buffers, so the render loop
+// allocates nothing once the first frames are under way.
+//
+// A real-time capture that gets more than the pool ahead of the encoder drops frames rather
+// than stalling the render loop; their numbers are skipped, so the gaps show. One that must
+// keep everything, for offline rendering, waits on the encoder instead. Without pixel buffer
+// objects (OpenGL 2.1) each frame is read back directly, which does stall
+class FrameCapture {
+public:
+    // Frames go to directory/frame_000000.png and on, which must exist
+    FrameCapture(const std::string& directory, bool dropWhenBehind);
+
+    // Finishes the reads in flight and waits for every queued frame to be written
+    ~FrameCapture();
+
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    // Captures target as drawn so far. For a window, call it before display()
+    void capture(sf::RenderTarget& target);
+
+    std::uint64_t framesCaptured() const {
+        return frames;
+    }
+
+    std::uint64_t framesDropped() const {
+        return dropped;
+    }
+
+    // The frame pool, which the encoder may be reading, and the pixel buffers on the GPU
+    MemoryUsage memoryUsage() const;
+
+private:
+    struct Readback {
+        unsigned buffer;      // Pixel buffer object
+        bool pending;         // Holds a read not yet copied out
+        std::uint64_t number; // Frame it holds
+        sf::Vector2u size;
+    };
+
+    // A frame buffer on its way to the encoder
+    struct Job {
+        std::uint32_t frame;
+        std::uint64_t number;
+        sf::Vector2u size;
+        bool filled; // False if the read failed, so it only goes back to the pool
+    };
+
+    std::string directory;
+    bool dropWhenBehind;
+    bool pixelBuffers;         // Whether the PBO path is in use
+    Readback readbacks[CAPTURE_READBACKS];
+    sf::Vector2u bufferSize;   // What the pixel buffers are allocated for
+    std::vector<std::uint8_t> pixels[CAPTURE_FRAMES];
+    SpscQueue<Job, CAPTURE_FRAMES * 2> jobs;                  // To the encoder
+    SpscQueue<std::uint32_t, CAPTURE_FRAMES * 2> freeFrames;  // Back from it, and only from it
+    std::uint64_t frames;
+    std::uint64_t dropped;
+
+    std::thread encoder;
+    std::mutex mutex;          // Only for sleeping on wake
+    std::condition_variable wake;
+    std::atomic<bool> stopping;
+
+    bool takeFrame(std::uint32_t& frame);
+    void send(std::uint32_t frame, std::uint64_t number, sf::Vector2u size);
+    void collect(Readback& readback);
+    void resize(sf::Vector2u size);
+    void encode();
+};
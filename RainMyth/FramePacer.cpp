@@ -0,0 +1,64 @@
+#include "FramePacer.h"
+
+#include <SFML/OpenGL.hpp>
+#include <SFML/System/Sleep.hpp>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "Constants.h"
+
+FramePacer::FramePacer(sf::RenderWindow& window, PacingMode mode, float fps, bool finish)
+    : mode(mode), fps(std::max(fps, 1.0f)), throttled(0.0f), finish(finish),
+      period(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / std::max(fps, 1.0f)))),
+      deadline(Clock::now()) {
+    attach(window);
+}
+
+void FramePacer::attach(sf::RenderWindow& window) {
+    window.setVerticalSyncEnabled(mode == PACING_VSYNC && throttled == 0.0f);
+    window.setFramerateLimit(mode == PACING_SLEEP && throttled == 0.0f ? static_cast<unsigned>(std::lround(fps)) : 0);
+}
+
+void FramePacer::throttle(sf::RenderWindow& window, float rate) {
+    throttled = std::max(rate, 0.0f);
+    const double seconds = 1.0 / (throttled > 0.0f ? throttled : fps);
+    period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    deadline = Clock::now();
+    attach(window);
+}
+
+void FramePacer::wait() {
+    if (finish) {
+        glFinish();
+    }
+    if (mode != PACING_PRECISE && throttled == 0.0f) {
+        return; // The window or the driver does the waiting, if any
+    }
+
+    deadline += period;
+    Clock::time_point now = Clock::now();
+    if (now > deadline + period) {
+        deadline = now; // Too far behind to catch up
+        return;
+    }
+
+    // sf::sleep can overshoot by a whole timer tick, so it stops short and the tail is spun
+    const Clock::duration margin = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float, std::milli>(FRAME_SPIN_MS));
+    if (deadline - now > margin) {
+        const auto sleepFor = std::chrono::duration_cast<std::chrono::microseconds>(deadline - now - margin);
+        sf::sleep(sf::microseconds(sleepFor.count()));
+    }
+    while (Clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+}
+
+FramePacer::Clock::time_point FramePacer::spareUntil(Clock::duration work) const {
+    const Clock::time_point now = Clock::now();
+    if (mode == PACING_UNCAPPED && throttled == 0.0f) {
+        return now;
+    }
+    const Clock::time_point next = now + period - work;
+    return mode == PACING_PRECISE || throttled > 0.0f ? std::min(next, deadline + period) : next;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <SFML/Graphics/RenderWindow.hpp>
+#include <algorithm>
+#include <chrono>
+
+#include "Constants.h"
+
+// How the rendered loop waits between frames
+enum PacingMode {
+    PACING_SLEEP,    // SFML's frame limit: one sf::sleep per frame, only as even as the OS timer
+    PACING_VSYNC,    // The driver holds each display() to the monitor's refresh
+    PACING_UNCAPPED, // No wait at all, to measure what the machine can do
+    PACING_PRECISE   // Sleep to within FRAME_SPIN_MS of each deadline, then spin the rest
+};
+
+// What the fixed-step loop makes of a stall, a frame longer than STALL_SECONDS. Every step is
+// timestep long whatever the policy, so nothing ever moves further in one than it normally would
+enum StallPolicy {
+    STALL_CATCH_UP, // Take the steps it missed, up to MAX_FRAME_TIME's worth, so the rain keeps to the clock
+    STALL_CLAMP,    // Take one step for it, so the rain only slows down
+    STALL_PAUSE     // Take none for it, as though the stall never happened
+};
+
+// The simulated seconds a frame frameTime long banks under policy
+inline float stallBanked(StallPolicy policy, float frameTime, float timestep) {
+    if (frameTime <= STALL_SECONDS) {
+        return frameTime;
+    }
+    return policy == STALL_CLAMP ? timestep : policy == STALL_PAUSE ? 0.0f : std::min(frameTime, MAX_FRAME_TIME);
+}
+
+// Holds the rendered loop to a frame rate. Deadlines are kept on a fixed grid, so a frame that
+// wakes late is made up by the next one's shorter wait rather than pushing every later frame
+// back; after a hitch of more than a frame the grid restarts from now instead of rushing
+// through the frames it missed
+class FramePacer {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    // Sets the window up for mode. fps applies to PACING_SLEEP and PACING_PRECISE. With finish,
+    // every wait() first waits for the GPU to have presented the frame, so the driver never
+    // queues frames ahead and a frame is on screen when wait() returns, at the cost of the
+    // CPU and GPU no longer overlapping across frames
+    FramePacer(sf::RenderWindow& window, PacingMode mode, float fps, bool finish = false);
+
+    // Sets a recreated window up again: vsync and the frame limit belong to the window
+    void attach(sf::RenderWindow& window);
+
+    // Holds every frame to rate frames a second, sleeping precisely whatever the mode, until
+    // it's called again with 0 to go back to the mode's own pacing
+    void throttle(sf::RenderWindow& window, float rate);
+
+    // Call right after window.display()
+    void wait();
+
+    // Until when, called after display() and before wait(), there's time to spare before the
+    // next frame has to start: a frame's period on from now, less the work that went into this
+    // one, assuming the next takes as long, and no later than the deadline wait() holds to.
+    // Vsync is taken to run at the frame rate. Uncapped, no time is spare
+    Clock::time_point spareUntil(Clock::duration work) const;
+
+private:
+    PacingMode mode;
+    float fps;
+    float throttled; // Frame rate throttle() holds to, 0 when it isn't
+    bool finish;
+    Clock::duration period;
+    Clock::time_point deadline;
+};
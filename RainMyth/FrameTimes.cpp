@@ -0,0 +1,89 @@
+#include "FrameTimes.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+
+namespace {
+
+const double REPORTED_FRACTIONS[] = { 0.5, 0.9, 0.99, 0.999 };
+
+std::size_t bucketOf(std::uint32_t micros) {
+    if (micros < 2 * FRAME_HISTOGRAM_SUBBUCKETS) {
+        return micros;
+    }
+    unsigned top = 0;
+    while ((micros >> top) > 1) {
+        ++top;
+    }
+    const unsigned shift = top - FRAME_HISTOGRAM_BITS;
+    return 2 * FRAME_HISTOGRAM_SUBBUCKETS + (shift - 1) * FRAME_HISTOGRAM_SUBBUCKETS + ((micros >> shift) - FRAME_HISTOGRAM_SUBBUCKETS);
+}
+
+// Middle of the bucket, in microseconds
+double middleOf(std::size_t bucket) {
+    if (bucket < 2 * FRAME_HISTOGRAM_SUBBUCKETS) {
+        return bucket + 0.5;
+    }
+    const std::size_t above = bucket - 2 * FRAME_HISTOGRAM_SUBBUCKETS;
+    const unsigned shift = static_cast<unsigned>(above / FRAME_HISTOGRAM_SUBBUCKETS) + 1;
+    const double lower = static_cast<double>((above % FRAME_HISTOGRAM_SUBBUCKETS + FRAME_HISTOGRAM_SUBBUCKETS) << shift);
+    return lower + static_cast<double>(std::size_t(1) << shift) / 2.0;
+}
+
+void printRow(std::ostream& out, const char* name, const DurationHistogram& histogram) {
+    out << "  " << std::left << std::setw(10) << name << std::right;
+    for (double fraction : REPORTED_FRACTIONS) {
+        out << std::setw(10) << histogram.percentile(fraction);
+    }
+    out << std::setw(10) << histogram.maxMilliseconds() << std::endl;
+}
+
+} // namespace
+
+DurationHistogram::DurationHistogram() : counts(), total(0), largest(0) {}
+
+void DurationHistogram::add(float seconds) {
+    const double micros = std::min(std::max(seconds * 1e6, 0.0), static_cast<double>(std::numeric_limits<std::uint32_t>::max()));
+    const std::uint32_t value = static_cast<std::uint32_t>(micros);
+    ++counts[bucketOf(value)];
+    ++total;
+    largest = std::max(largest, value);
+}
+
+float DurationHistogram::percentile(double fraction) const {
+    if (total == 0) {
+        return 0.0f;
+    }
+    // The smallest bucket with at least that fraction of the durations at or below it
+    const std::uint64_t rank = std::max<std::uint64_t>(static_cast<std::uint64_t>(std::ceil(fraction * total)), 1);
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < FRAME_HISTOGRAM_BUCKETS; ++bucket) {
+        seen += counts[bucket];
+        if (seen >= rank) {
+            return static_cast<float>(std::min(middleOf(bucket), static_cast<double>(largest)) / 1000.0);
+        }
+    }
+    return maxMilliseconds();
+}
+
+void FrameTimes::add(float frameSeconds, const Profiler& profiler) {
+    frame.add(frameSeconds);
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        phases[p].add(profiler.frameSeconds(static_cast<ProfilePhase>(p)));
+    }
+}
+
+void FrameTimes::print(std::ostream& out) const {
+    if (frame.count() == 0) {
+        return;
+    }
+    out << "Frame times over " << frame.count() << " frames, in ms:" << std::endl;
+    out << "  " << std::left << std::setw(10) << "" << std::right << std::setw(10) << "p50" << std::setw(10) << "p90"
+        << std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(10) << "max" << std::endl;
+    printRow(out, "Frame", frame);
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        printRow(out, phaseName(static_cast<ProfilePhase>(p)), phases[p]);
+    }
+}
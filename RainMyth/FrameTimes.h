@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include "Profiler.h"
+
+// Counts of durations in buckets whose width grows with the duration, as HdrHistogram lays
+// them out: one bucket per microsecond up to 2^(FRAME_HISTOGRAM_BITS + 1), then each power of
+// two split into 2^FRAME_HISTOGRAM_BITS buckets, so any percentile read back is within about
+// 3% of the true one however long the run. Fixed size, so adding is an index and an increment
+const unsigned FRAME_HISTOGRAM_BITS = 5;
+const std::size_t FRAME_HISTOGRAM_SUBBUCKETS = std::size_t(1) << FRAME_HISTOGRAM_BITS;
+const std::size_t FRAME_HISTOGRAM_BUCKETS = 2 * FRAME_HISTOGRAM_SUBBUCKETS + (32 - FRAME_HISTOGRAM_BITS - 1) * FRAME_HISTOGRAM_SUBBUCKETS;
+
+class DurationHistogram {
+public:
+    DurationHistogram();
+
+    void add(float seconds);
+
+    std::uint64_t count() const {
+        return total;
+    }
+
+    // Milliseconds below which fraction of the durations fall, at the middle of their bucket
+    float percentile(double fraction) const;
+
+    float maxMilliseconds() const {
+        return largest / 1000.0f;
+    }
+
+private:
+    std::uint64_t counts[FRAME_HISTOGRAM_BUCKETS];
+    std::uint64_t total;
+    std::uint32_t largest; // Microseconds, exactly
+};
+
+// Every rendered frame's time and how it split across the profiler's phases, for the
+// percentiles an average hides: a run at a steady 60 fps with a 100 ms stall a second looks
+// fine in the mean and awful on screen. The phases are those of the frame, so the update and
+// collision columns are the simulation job's, which overlaps the rest rather than adding to it
+class FrameTimes {
+public:
+    // Adds a finished frame, before profiler.endFrame forgets its phases
+    void add(float frameSeconds, const Profiler& profiler);
+
+    std::uint64_t count() const {
+        return frame.count();
+    }
+
+    // p50, p90, p99, p99.9 and the worst, of the frame and of each phase, if there were frames
+    void print(std::ostream& out) const;
+
+private:
+    DurationHistogram frame;
+    DurationHistogram phases[PHASE_COUNT];
+};
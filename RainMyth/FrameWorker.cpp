@@ -0,0 +1,76 @@
+#include "FrameWorker.h"
+
+#include "Instrument.h"
+
+FrameWorker::FrameWorker(bool threaded)
+    : busy(false), wanted(false), stopping(false) {
+    if (threaded) {
+        thread = std::thread(&FrameWorker::loop, this);
+    }
+}
+
+FrameWorker::~FrameWorker() {
+    if (!thread.joinable()) {
+        return;
+    }
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    thread.join();
+}
+
+void FrameWorker::start(std::function<void()> next) {
+    if (!thread.joinable()) {
+        next();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = std::move(next);
+        busy = true;
+        wanted = false;
+    }
+    wake.notify_all();
+}
+
+void FrameWorker::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    wanted = true;
+    wake.notify_all();
+    done.wait(lock, [this] { return !busy; });
+}
+
+bool FrameWorker::rest(Clock::time_point until) {
+    if (!thread.joinable()) {
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    wake.wait_until(lock, until, [this] { return wanted; });
+    return wanted;
+}
+
+void FrameWorker::loop() {
+    RAINMYTH_THREAD("Simulation");
+    for (;;) {
+        std::function<void()> current;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return busy || stopping; });
+            if (!busy) {
+                return;
+            }
+            current = std::move(job);
+        }
+
+        current();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busy = false;
+        }
+        done.notify_one();
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// One background thread that runs a single job at a time, so a frame's simulation can run
+// while the main thread renders the last one. start() hands a job over and returns at once and
+// wait() blocks until it has finished. The two threads only meet at those calls, once a frame
+// each, so nothing the job works on is ever locked while it runs: between start and wait the
+// job owns its data and the caller must leave it alone.
+//
+// A job can also run for as long as the caller leaves it, resting between pieces of work with
+// rest(), which wait() cuts short. Then the caller's stalls don't hold the job up: it carries
+// on until its results are wanted, however late that is.
+//
+// A worker that isn't threaded runs each job inline in start(), for when the job has to stay
+// on the calling thread or there's nothing to overlap it with
+class FrameWorker {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    explicit FrameWorker(bool threaded);
+    ~FrameWorker();
+
+    FrameWorker(const FrameWorker&) = delete;
+    FrameWorker& operator=(const FrameWorker&) = delete;
+
+    bool isThreaded() const {
+        return thread.joinable();
+    }
+
+    // Runs job, which must not be called while another one is in flight
+    void start(std::function<void()> job);
+
+    // Asks the last job started to finish, see rest(), and returns once it has
+    void wait();
+
+    // For the job: waits until until, or until wait() asks for its results, and returns
+    // whether they're wanted. Run inline, nobody can ask, so it returns false at once, and a
+    // job that's run inline has to end of its own accord
+    bool rest(Clock::time_point until);
+
+private:
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::function<void()> job;
+    bool busy;
+    bool wanted; // wait() has been called for the job in flight
+    bool stopping;
+
+    void loop();
+};
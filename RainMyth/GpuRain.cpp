@@ -0,0 +1,1127 @@
+#include "GpuRain.h"
+
+#include <SFML/OpenGL.hpp>
+#include <SFML/Window/Context.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Rng.h"
+#include "SfmlCompat.h"
+#include "TerminalVelocity.h"
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+namespace {
+
+// Only OpenGL 1.1 is declared by the system headers on Windows, so the enums this path needs
+// from 2.0 and 3.0 are spelled out here
+const GLenum GL_ARRAY_BUFFER_ = 0x8892;
+const GLenum GL_STREAM_DRAW_ = 0x88E0;
+const GLenum GL_VERTEX_SHADER_ = 0x8B31;
+const GLenum GL_FRAGMENT_SHADER_ = 0x8B30;
+const GLenum GL_COMPILE_STATUS_ = 0x8B81;
+const GLenum GL_LINK_STATUS_ = 0x8B82;
+const GLenum GL_INFO_LOG_LENGTH_ = 0x8B84;
+const GLenum GL_TRANSFORM_FEEDBACK_BUFFER_ = 0x8C8E;
+const GLenum GL_INTERLEAVED_ATTRIBS_ = 0x8C8C;
+const GLenum GL_FRAMEBUFFER_ = 0x8D40;
+const GLenum GL_COLOR_ATTACHMENT0_ = 0x8CE0;
+const GLenum GL_FRAMEBUFFER_COMPLETE_ = 0x8CD5;
+const GLenum GL_RGBA32F_ = 0x8814;
+const GLenum GL_R32F_ = 0x822E;
+const GLenum GL_RED_ = 0x1903;
+const GLenum GL_PROGRAM_POINT_SIZE_ = 0x8642;
+const GLenum GL_GEOMETRY_SHADER_ = 0x8DD9;
+const GLenum GL_PIXEL_PACK_BUFFER_ = 0x88EB;
+const GLenum GL_STREAM_READ_ = 0x88E1;
+const GLenum GL_READ_ONLY_ = 0x88B8;
+const GLenum GL_RASTERIZER_DISCARD_ = 0x8C89;
+const GLenum GL_TRANSFORM_FEEDBACK_ = 0x8E22;
+const GLenum GL_COMPUTE_SHADER_ = 0x91B9;
+const GLenum GL_SHADER_STORAGE_BUFFER_ = 0x90D2;
+const GLenum GL_DRAW_INDIRECT_BUFFER_ = 0x8F3F;
+const GLbitfield GL_SHADER_STORAGE_BARRIER_BIT_ = 0x2000;
+const GLbitfield GL_COMMAND_BARRIER_BIT_ = 0x0040;
+const GLbitfield GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT_ = 0x4000;
+const GLbitfield GL_MAP_READ_BIT_ = 0x0001;
+const GLbitfield GL_MAP_WRITE_BIT_ = 0x0002;
+const GLbitfield GL_MAP_PERSISTENT_BIT_ = 0x0040;
+const GLbitfield GL_MAP_COHERENT_BIT_ = 0x0080;
+const GLbitfield GL_DYNAMIC_STORAGE_BIT_ = 0x0100;
+const GLenum GL_SYNC_GPU_COMMANDS_COMPLETE_ = 0x9117;
+const GLbitfield GL_SYNC_FLUSH_COMMANDS_BIT_ = 0x0001;
+const GLenum GL_TIMEOUT_EXPIRED_ = 0x911B;
+const GLenum GL_PROGRAM_BINARY_RETRIEVABLE_HINT_ = 0x8257;
+const GLenum GL_PROGRAM_BINARY_LENGTH_ = 0x8741;
+const GLenum GL_NUM_PROGRAM_BINARY_FORMATS_ = 0x87FE;
+
+// Drops one compute work group advances
+const unsigned COMPUTE_GROUP_SIZE = 256;
+
+// The compute backend sums hit areas as integers of this fraction of a square unit
+const float HIT_UNITS = 1024.0f;
+
+typedef char GlChar;
+typedef std::ptrdiff_t GlSizeiptr;
+typedef std::ptrdiff_t GlIntptr;
+typedef struct GlSyncObject* GlSync;
+
+// The post-1.1 entry points, loaded through SFML once a context is active
+struct GlFunctions {
+    void (APIENTRY* genBuffers)(GLsizei, GLuint*);
+    void (APIENTRY* deleteBuffers)(GLsizei, const GLuint*);
+    void (APIENTRY* bindBuffer)(GLenum, GLuint);
+    void (APIENTRY* bufferData)(GLenum, GlSizeiptr, const void*, GLenum);
+    void* (APIENTRY* mapBuffer)(GLenum, GLenum);
+    GLboolean (APIENTRY* unmapBuffer)(GLenum);
+    void (APIENTRY* bindBufferBase)(GLenum, GLuint, GLuint);
+    GLuint (APIENTRY* createShader)(GLenum);
+    void (APIENTRY* deleteShader)(GLuint);
+    void (APIENTRY* shaderSource)(GLuint, GLsizei, const GlChar* const*, const GLint*);
+    void (APIENTRY* compileShader)(GLuint);
+    void (APIENTRY* getShaderiv)(GLuint, GLenum, GLint*);
+    void (APIENTRY* getShaderInfoLog)(GLuint, GLsizei, GLsizei*, GlChar*);
+    GLuint (APIENTRY* createProgram)();
+    void (APIENTRY* deleteProgram)(GLuint);
+    void (APIENTRY* attachShader)(GLuint, GLuint);
+    void (APIENTRY* bindAttribLocation)(GLuint, GLuint, const GlChar*);
+    void (APIENTRY* transformFeedbackVaryings)(GLuint, GLsizei, const GlChar* const*, GLenum);
+    void (APIENTRY* linkProgram)(GLuint);
+    void (APIENTRY* getProgramiv)(GLuint, GLenum, GLint*);
+    void (APIENTRY* getProgramInfoLog)(GLuint, GLsizei, GLsizei*, GlChar*);
+    void (APIENTRY* useProgram)(GLuint);
+    GLint (APIENTRY* getUniformLocation)(GLuint, const GlChar*);
+    void (APIENTRY* uniform1i)(GLint, GLint);
+    void (APIENTRY* uniform1ui)(GLint, GLuint);
+    void (APIENTRY* uniform1f)(GLint, GLfloat);
+    void (APIENTRY* uniform2f)(GLint, GLfloat, GLfloat);
+    void (APIENTRY* uniform1fv)(GLint, GLsizei, const GLfloat*);
+    void (APIENTRY* uniform4f)(GLint, GLfloat, GLfloat, GLfloat, GLfloat);
+    void (APIENTRY* uniform4fv)(GLint, GLsizei, const GLfloat*);
+    void (APIENTRY* enableVertexAttribArray)(GLuint);
+    void (APIENTRY* disableVertexAttribArray)(GLuint);
+    void (APIENTRY* vertexAttribPointer)(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*);
+    void (APIENTRY* beginTransformFeedback)(GLenum);
+    void (APIENTRY* endTransformFeedback)();
+    void (APIENTRY* genFramebuffers)(GLsizei, GLuint*);
+    void (APIENTRY* deleteFramebuffers)(GLsizei, const GLuint*);
+    void (APIENTRY* bindFramebuffer)(GLenum, GLuint);
+    void (APIENTRY* framebufferTexture2D)(GLenum, GLenum, GLenum, GLuint, GLint);
+    GLenum (APIENTRY* checkFramebufferStatus)(GLenum);
+
+    // OpenGL 4.0, for compaction; left null without it
+    void (APIENTRY* genTransformFeedbacks)(GLsizei, GLuint*);
+    void (APIENTRY* deleteTransformFeedbacks)(GLsizei, const GLuint*);
+    void (APIENTRY* bindTransformFeedback)(GLenum, GLuint);
+    void (APIENTRY* drawTransformFeedback)(GLenum, GLuint);
+
+    // OpenGL 4.4, for the compute backend; left null without it
+    void (APIENTRY* dispatchCompute)(GLuint, GLuint, GLuint);
+    void (APIENTRY* memoryBarrier)(GLbitfield);
+    void (APIENTRY* bufferStorage)(GLenum, GlSizeiptr, const void*, GLbitfield);
+    void (APIENTRY* bufferSubData)(GLenum, GlIntptr, GlSizeiptr, const void*);
+    void* (APIENTRY* mapBufferRange)(GLenum, GlIntptr, GlSizeiptr, GLbitfield);
+    void (APIENTRY* drawArraysIndirect)(GLenum, const void*);
+    GlSync (APIENTRY* fenceSync)(GLenum, GLbitfield);
+    GLenum (APIENTRY* clientWaitSync)(GlSync, GLbitfield, std::uint64_t);
+    void (APIENTRY* deleteSync)(GlSync);
+
+    // OpenGL 4.1 or ARB_get_program_binary, for the program cache; left null without it
+    void (APIENTRY* getProgramBinary)(GLuint, GLsizei, GLsizei*, GLenum*, void*);
+    void (APIENTRY* programBinary)(GLuint, GLenum, const void*, GLsizei);
+    void (APIENTRY* programParameteri)(GLuint, GLenum, GLint);
+};
+
+GlFunctions gl;
+
+// Where linked programs are kept, empty when they aren't, see GpuRain.h
+std::string programCacheDir;
+
+template <typename Fn>
+bool loadFunction(Fn& fn, const char* name) {
+    fn = reinterpret_cast<Fn>(sf::Context::getFunction(name));
+    return fn != nullptr;
+}
+
+bool loadFunctions() {
+    return loadFunction(gl.genBuffers, "glGenBuffers") && loadFunction(gl.deleteBuffers, "glDeleteBuffers")
+        && loadFunction(gl.bindBuffer, "glBindBuffer") && loadFunction(gl.bufferData, "glBufferData")
+        && loadFunction(gl.mapBuffer, "glMapBuffer") && loadFunction(gl.unmapBuffer, "glUnmapBuffer")
+        && loadFunction(gl.bindBufferBase, "glBindBufferBase") && loadFunction(gl.createShader, "glCreateShader")
+        && loadFunction(gl.deleteShader, "glDeleteShader") && loadFunction(gl.shaderSource, "glShaderSource")
+        && loadFunction(gl.compileShader, "glCompileShader") && loadFunction(gl.getShaderiv, "glGetShaderiv")
+        && loadFunction(gl.getShaderInfoLog, "glGetShaderInfoLog") && loadFunction(gl.createProgram, "glCreateProgram")
+        && loadFunction(gl.deleteProgram, "glDeleteProgram") && loadFunction(gl.attachShader, "glAttachShader")
+        && loadFunction(gl.bindAttribLocation, "glBindAttribLocation")
+        && loadFunction(gl.transformFeedbackVaryings, "glTransformFeedbackVaryings")
+        && loadFunction(gl.linkProgram, "glLinkProgram") && loadFunction(gl.getProgramiv, "glGetProgramiv")
+        && loadFunction(gl.getProgramInfoLog, "glGetProgramInfoLog") && loadFunction(gl.useProgram, "glUseProgram")
+        && loadFunction(gl.getUniformLocation, "glGetUniformLocation") && loadFunction(gl.uniform1i, "glUniform1i")
+        && loadFunction(gl.uniform1ui, "glUniform1ui") && loadFunction(gl.uniform1f, "glUniform1f")
+        && loadFunction(gl.uniform2f, "glUniform2f") && loadFunction(gl.uniform1fv, "glUniform1fv") && loadFunction(gl.uniform4f, "glUniform4f")
+        && loadFunction(gl.uniform4fv, "glUniform4fv")
+        && loadFunction(gl.enableVertexAttribArray, "glEnableVertexAttribArray")
+        && loadFunction(gl.disableVertexAttribArray, "glDisableVertexAttribArray")
+        && loadFunction(gl.vertexAttribPointer, "glVertexAttribPointer")
+        && loadFunction(gl.beginTransformFeedback, "glBeginTransformFeedback")
+        && loadFunction(gl.endTransformFeedback, "glEndTransformFeedback")
+        && loadFunction(gl.genFramebuffers, "glGenFramebuffers") && loadFunction(gl.deleteFramebuffers, "glDeleteFramebuffers")
+        && loadFunction(gl.bindFramebuffer, "glBindFramebuffer")
+        && loadFunction(gl.framebufferTexture2D, "glFramebufferTexture2D")
+        && loadFunction(gl.checkFramebufferStatus, "glCheckFramebufferStatus");
+}
+
+bool loadCompactionFunctions() {
+    return loadFunction(gl.genTransformFeedbacks, "glGenTransformFeedbacks")
+        && loadFunction(gl.deleteTransformFeedbacks, "glDeleteTransformFeedbacks")
+        && loadFunction(gl.bindTransformFeedback, "glBindTransformFeedback")
+        && loadFunction(gl.drawTransformFeedback, "glDrawTransformFeedback");
+}
+
+bool loadComputeFunctions() {
+    return loadFunction(gl.dispatchCompute, "glDispatchCompute") && loadFunction(gl.memoryBarrier, "glMemoryBarrier")
+        && loadFunction(gl.bufferStorage, "glBufferStorage") && loadFunction(gl.bufferSubData, "glBufferSubData")
+        && loadFunction(gl.mapBufferRange, "glMapBufferRange") && loadFunction(gl.drawArraysIndirect, "glDrawArraysIndirect")
+        && loadFunction(gl.fenceSync, "glFenceSync") && loadFunction(gl.clientWaitSync, "glClientWaitSync")
+        && loadFunction(gl.deleteSync, "glDeleteSync");
+}
+
+// Whether programs can be saved and loaded, by the driver's own binary formats
+bool loadBinaryFunctions() {
+    if (!loadFunction(gl.getProgramBinary, "glGetProgramBinary") || !loadFunction(gl.programBinary, "glProgramBinary")
+        || !loadFunction(gl.programParameteri, "glProgramParameteri")) {
+        return false;
+    }
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_, &formats);
+    return formats > 0;
+}
+
+bool hasCompute(const sf::ContextSettings& settings) {
+    const bool core = settings.majorVersion > 4 || (settings.majorVersion == 4 && settings.minorVersion >= 4);
+    const bool extended = settings.majorVersion == 4 && settings.minorVersion == 3 && sf::Context::isExtensionAvailable("GL_ARB_buffer_storage");
+    return (core || extended) && loadComputeFunctions();
+}
+
+// How both backends respawn a drop, put into their vertex and compute shaders
+const char* RESPAWN_FUNCTIONS = R"(
+uniform float sizeQuantiles[DROP_SIZE_TABLE_SIZE + 1]; // DropSizeTable's, to draw new widths from
+
+uint hash(uint x) {
+    x ^= x >> 16u; x *= 0x7feb352du;
+    x ^= x >> 15u; x *= 0x846ca68bu;
+    x ^= x >> 16u;
+    return x;
+}
+
+float random(inout uint s) {
+    s = hash(s);
+    return float(s >> 8u) * (1.0 / 16777216.0);
+}
+
+// Same as DropSizeTable::lookup on the CPU
+float dropSize(float u) {
+    float position = u * float(DROP_SIZE_TABLE_SIZE);
+    int index = min(int(position), DROP_SIZE_TABLE_SIZE - 1);
+    return mix(sizeQuantiles[index], sizeQuantiles[index + 1], position - float(index));
+}
+
+// Same fit as terminalSpeed() on the CPU
+float terminalSpeed(float size) {
+    return max(9.65 - 10.3 * exp(-0.6 * size * RAINDROP_MM_PER_PIXEL), 0.0) * 100.0;
+}
+)";
+
+// Advances one drop per vertex and streams its new state out through transform feedback. A
+// drop that touched someone is also placed on their pixel of the hit row, the first person's
+// it touched, where the fragment shader adds its area
+const char* UPDATE_VERTEX_SHADER = R"(
+#version 130
+in vec4 state; // x, y, vy, size
+out vec4 outState;
+flat out float hitArea;
+
+uniform float deltaTime;
+uniform vec4 people[MAX_PEOPLE]; // left, top, right, bottom
+uniform int personCount;
+uniform sampler2D shadow; // Shadow height per screen column
+uniform vec2 screenSize;
+uniform uint seed;
+
+void main() {
+    float size = state.w;
+    float previousY = state.y;
+    float y = previousY + state.z * deltaTime;
+    int column = clamp(int(state.x), 0, int(screenSize.x) - 1);
+    float shadowTop = texelFetch(shadow, ivec2(column, 0), 0).r;
+    float reachedY = min(y, shadowTop);
+
+    // The rectangle the drop swept on its way down, against each person, as FloatRect::intersects does
+    int hitBy = -1;
+    for (int i = 0; i < personCount && hitBy < 0; ++i) {
+        vec4 person = people[i];
+        if (max(state.x, person.x) < min(state.x + size, person.z) && max(previousY, person.y) < min(reachedY + 2.0 * size, person.w)) {
+            hitBy = i;
+        }
+    }
+    bool hit = hitBy >= 0;
+    hitArea = 2.0 * size * size;
+    gl_Position = hit ? vec4((float(hitBy) + 0.5) / float(MAX_PEOPLE) * 2.0 - 1.0, 0.0, 0.0, 1.0) : vec4(2.0, 2.0, 0.0, 1.0);
+    gl_PointSize = 1.0;
+
+    outState = vec4(state.x, y, state.z, size);
+    if (y > shadowTop || hit) {
+        // Landed or caught: respawn just above the screen, like RainSystem's spawner
+        uint s = hash(uint(gl_VertexID) ^ hash(seed));
+        float newSize = dropSize(random(s));
+        outState = vec4(random(s) * screenSize.x, -100.0 + 50.0 * random(s), terminalSpeed(newSize), newSize);
+    }
+}
+)";
+
+const char* UPDATE_FRAGMENT_SHADER = R"(
+#version 130
+flat in float hitArea;
+out vec4 color;
+
+void main() {
+    color = vec4(hitArea);
+}
+)";
+
+// Draws each drop as a point sprite centred on its rectangle
+const char* DRAW_VERTEX_SHADER = R"(
+#version 130
+in vec4 state;
+uniform vec2 screenSize;
+uniform float pixelsPerUnit;
+
+void main() {
+    vec2 centre = vec2(state.x + 0.5 * state.w, state.y + state.w);
+    gl_Position = vec4(centre.x / screenSize.x * 2.0 - 1.0, 1.0 - centre.y / screenSize.y * 2.0, 0.0, 1.0);
+    gl_PointSize = max(2.0 * state.w * pixelsPerUnit, 1.0);
+}
+)";
+
+// Compaction: passes the drops through untouched to a geometry shader that keeps only the
+// ones showing on screen, which transform feedback packs into the visible buffer. Drops in
+// the spawn band above the screen are the ones it leaves out
+const char* COMPACT_VERTEX_SHADER = R"(
+#version 150
+in vec4 state;
+out vec4 drop;
+
+void main() {
+    drop = state;
+}
+)";
+
+const char* COMPACT_GEOMETRY_SHADER = R"(
+#version 150
+layout(points) in;
+layout(points, max_vertices = 1) out;
+in vec4 drop[];
+out vec4 visibleState;
+uniform vec2 screenSize;
+
+void main() {
+    vec4 s = drop[0];
+    if (s.y + 2.0 * s.w > 0.0 && s.y < screenSize.y && s.x + s.w > 0.0 && s.x < screenSize.x) {
+        visibleState = s;
+        EmitVertex();
+        EndPrimitive();
+    }
+}
+)";
+
+const char* DRAW_FRAGMENT_SHADER = R"(
+#version 130
+uniform vec4 color;
+out vec4 fragColor;
+
+void main() {
+    fragColor = color;
+}
+)";
+
+// The compute backend's step: the update vertex shader's rules, a thread per drop, on the
+// state in place. Hits are added to this frame's slot of the hit row, and the drops left on
+// screen append their index to the visible list, counted in the draw command's instance count
+const char* UPDATE_COMPUTE_SHADER = R"(
+#version 430
+layout(local_size_x = COMPUTE_GROUP_SIZE) in;
+layout(std430, binding = 0) buffer State { vec4 drops[]; };
+layout(std430, binding = 1) writeonly buffer Visible { uint visible[]; };
+layout(std430, binding = 2) buffer Command { uint vertexCount; uint instanceCount; uint first; uint baseInstance; };
+layout(std430, binding = 3) buffer Hits { uint hits[]; };
+
+uniform float deltaTime;
+uniform vec4 people[MAX_PEOPLE]; // left, top, right, bottom
+uniform int personCount;
+uniform sampler2D shadow;
+uniform vec2 screenSize;
+uniform uint seed;
+uniform uint dropCount;
+uniform uint hitSlot; // Offset of this frame's slot in the hit row
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= dropCount) {
+        return;
+    }
+    vec4 state = drops[i];
+    float size = state.w;
+    float previousY = state.y;
+    float y = previousY + state.z * deltaTime;
+    int column = clamp(int(state.x), 0, int(screenSize.x) - 1);
+    float shadowTop = texelFetch(shadow, ivec2(column, 0), 0).r;
+    float reachedY = min(y, shadowTop);
+
+    int hitBy = -1;
+    for (int p = 0; p < personCount && hitBy < 0; ++p) {
+        vec4 person = people[p];
+        if (max(state.x, person.x) < min(state.x + size, person.z) && max(previousY, person.y) < min(reachedY + 2.0 * size, person.w)) {
+            hitBy = p;
+        }
+    }
+    if (hitBy >= 0) {
+        atomicAdd(hits[hitSlot + uint(hitBy)], uint(2.0 * size * size * HIT_UNITS + 0.5));
+    }
+
+    state = vec4(state.x, y, state.z, size);
+    if (y > shadowTop || hitBy >= 0) {
+        uint s = hash(i ^ hash(seed));
+        float newSize = dropSize(random(s));
+        state = vec4(random(s) * screenSize.x, -100.0 + 50.0 * random(s), terminalSpeed(newSize), newSize);
+    }
+    drops[i] = state;
+
+    if (state.y + 2.0 * state.w > 0.0 && state.y < screenSize.y && state.x + state.w > 0.0 && state.x < screenSize.x) {
+        visible[atomicAdd(instanceCount, 1u)] = i;
+    }
+}
+)";
+
+// Draws the visible drops an instance each, as a four-vertex strip over the drop's rectangle
+const char* INSTANCED_VERTEX_SHADER = R"(
+#version 430
+layout(std430, binding = 0) readonly buffer State { vec4 drops[]; };
+layout(std430, binding = 1) readonly buffer Visible { uint visible[]; };
+uniform vec2 screenSize;
+
+void main() {
+    vec4 state = drops[visible[gl_InstanceID]];
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+    vec2 position = state.xy + corner * vec2(state.w, 2.0 * state.w);
+    gl_Position = vec4(position.x / screenSize.x * 2.0 - 1.0, 1.0 - position.y / screenSize.y * 2.0, 0.0, 1.0);
+}
+)";
+
+const char* INSTANCED_FRAGMENT_SHADER = R"(
+#version 430
+uniform vec4 color;
+out vec4 fragColor;
+
+void main() {
+    fragColor = color;
+}
+)";
+
+// A stage's source as it's compiled
+std::string shaderText(GLenum type, const char* source) {
+    // The GPU terminal speed uses the same scale as the CPU one, and the size table the same length
+    std::string header = "#define RAINDROP_MM_PER_PIXEL " + std::to_string(RAINDROP_MM_PER_PIXEL) + "\n"
+        + "#define DROP_SIZE_TABLE_SIZE " + std::to_string(DROP_SIZE_TABLE_SIZE) + "\n"
+        + "#define MAX_PEOPLE " + std::to_string(MAX_PEOPLE) + "\n"
+        + "#define COMPUTE_GROUP_SIZE " + std::to_string(COMPUTE_GROUP_SIZE) + "\n"
+        + "#define HIT_UNITS " + std::to_string(HIT_UNITS) + "\n";
+    if (type == GL_VERTEX_SHADER_ || type == GL_COMPUTE_SHADER_) {
+        header += RESPAWN_FUNCTIONS;
+    }
+    std::string text(source);
+    const std::size_t versionEnd = text.find('\n', text.find("#version")) + 1;
+    text.insert(versionEnd, header);
+    return text;
+}
+
+GLuint compileShader(GLenum type, const char* source) {
+    const std::string text = shaderText(type, source);
+    const GLuint shader = gl.createShader(type);
+    const GlChar* sources[] = { text.c_str() };
+    gl.shaderSource(shader, 1, sources, nullptr);
+    gl.compileShader(shader);
+    GLint status = GL_FALSE;
+    gl.getShaderiv(shader, GL_COMPILE_STATUS_, &status);
+    if (status != GL_TRUE) {
+        GLint length = 0;
+        gl.getShaderiv(shader, GL_INFO_LOG_LENGTH_, &length);
+        std::vector<GlChar> log(static_cast<std::size_t>(length) + 1);
+        gl.getShaderInfoLog(shader, length, nullptr, log.data());
+        std::cerr << "GPU rain shader failed to compile: " << log.data() << std::endl;
+        gl.deleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+// Whether program linked, and if it didn't, why, with the program deleted
+bool checkLinked(GLuint program) {
+    GLint status = GL_FALSE;
+    gl.getProgramiv(program, GL_LINK_STATUS_, &status);
+    if (status != GL_TRUE) {
+        GLint length = 0;
+        gl.getProgramiv(program, GL_INFO_LOG_LENGTH_, &length);
+        std::vector<GlChar> log(static_cast<std::size_t>(length) + 1);
+        gl.getProgramInfoLog(program, length, nullptr, log.data());
+        std::cerr << "GPU rain shader failed to link: " << log.data() << std::endl;
+        gl.deleteProgram(program);
+        return false;
+    }
+    return true;
+}
+
+// The cache file for a program made from text, empty with no cache. Named by an FNV-1a hash
+// of the text and of the driver, which owns the binary format
+std::string cachedProgramPath(const std::string& text) {
+    if (programCacheDir.empty()) {
+        return std::string();
+    }
+    std::uint64_t hash = 14695981039346656037ull;
+    const auto add = [&hash](const char* bytes) {
+        for (; bytes != nullptr && *bytes != '\0'; ++bytes) {
+            hash = (hash ^ static_cast<unsigned char>(*bytes)) * 1099511628211ull;
+        }
+    };
+    add(text.c_str());
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+        add(reinterpret_cast<const char*>(glGetString(name)));
+    }
+    std::ostringstream path;
+    path << std::hex << std::setw(16) << std::setfill('0') << hash << ".bin";
+    return (std::filesystem::path(programCacheDir) / path.str()).string();
+}
+
+// The program kept at path, or 0 if there's none or the driver won't take it back. A binary
+// format followed by the binary
+GLuint loadCachedProgram(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::uint32_t format = 0;
+    if (!in.read(reinterpret_cast<char*>(&format), sizeof(format))) {
+        return 0;
+    }
+    const std::vector<char> binary((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    const GLuint program = gl.createProgram();
+    gl.programBinary(program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+    GLint status = GL_FALSE;
+    gl.getProgramiv(program, GL_LINK_STATUS_, &status);
+    if (status != GL_TRUE) {
+        gl.deleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+// Written beside path and renamed over it, so a run that dies part way leaves no torn binary
+void saveCachedProgram(GLuint program, const std::string& path) {
+    GLint length = 0;
+    gl.getProgramiv(program, GL_PROGRAM_BINARY_LENGTH_, &length);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<char> binary(static_cast<std::size_t>(length));
+    GLenum format = 0;
+    gl.getProgramBinary(program, length, nullptr, &format, binary.data());
+    std::error_code error;
+    std::filesystem::create_directories(programCacheDir, error);
+    const std::string partial = path + ".tmp";
+    {
+        std::ofstream out(partial, std::ios::binary | std::ios::trunc);
+        const std::uint32_t stored = format;
+        out.write(reinterpret_cast<const char*>(&stored), sizeof(stored));
+        out.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+        if (!out) {
+            std::cerr << "Couldn't write the GPU rain's program cache to " << partial << std::endl;
+            return;
+        }
+    }
+    std::filesystem::rename(partial, path, error);
+}
+
+// Links a program with the drop state bound to attribute 0. feedback names the varying that
+// transform feedback captures, or is null for a program that doesn't use it. The geometry
+// shader is optional, and so is the fragment shader for a program that only feeds back
+GLuint linkProgram(const char* vertexSource, const char* fragmentSource, const char* feedback, const char* geometrySource = nullptr) {
+    std::string text = shaderText(GL_VERTEX_SHADER_, vertexSource);
+    text += geometrySource ? shaderText(GL_GEOMETRY_SHADER_, geometrySource) : std::string();
+    text += fragmentSource ? shaderText(GL_FRAGMENT_SHADER_, fragmentSource) : std::string();
+    text += feedback ? feedback : "";
+    const std::string cached = cachedProgramPath(text);
+    if (!cached.empty()) {
+        if (const GLuint program = loadCachedProgram(cached)) {
+            return program;
+        }
+    }
+
+    const GLuint vertex = compileShader(GL_VERTEX_SHADER_, vertexSource);
+    const GLuint geometry = geometrySource ? compileShader(GL_GEOMETRY_SHADER_, geometrySource) : 0;
+    const GLuint fragment = fragmentSource ? compileShader(GL_FRAGMENT_SHADER_, fragmentSource) : 0;
+    if (vertex == 0 || (geometrySource && geometry == 0) || (fragmentSource && fragment == 0)) {
+        for (GLuint shader : { vertex, geometry, fragment }) {
+            if (shader != 0) {
+                gl.deleteShader(shader);
+            }
+        }
+        return 0;
+    }
+
+    const GLuint program = gl.createProgram();
+    gl.attachShader(program, vertex);
+    if (geometry != 0) {
+        gl.attachShader(program, geometry);
+    }
+    if (fragment != 0) {
+        gl.attachShader(program, fragment);
+    }
+    gl.bindAttribLocation(program, 0, "state");
+    if (feedback != nullptr) {
+        const GlChar* varyings[] = { feedback };
+        gl.transformFeedbackVaryings(program, 1, varyings, GL_INTERLEAVED_ATTRIBS_);
+    }
+    if (!cached.empty()) {
+        gl.programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT_, GL_TRUE);
+    }
+    gl.linkProgram(program);
+    for (GLuint shader : { vertex, geometry, fragment }) {
+        if (shader != 0) {
+            gl.deleteShader(shader);
+        }
+    }
+    if (!checkLinked(program)) {
+        return 0;
+    }
+    if (!cached.empty()) {
+        saveCachedProgram(program, cached);
+    }
+    return program;
+}
+
+GLuint linkComputeProgram(const char* source) {
+    const std::string cached = cachedProgramPath(shaderText(GL_COMPUTE_SHADER_, source));
+    if (!cached.empty()) {
+        if (const GLuint program = loadCachedProgram(cached)) {
+            return program;
+        }
+    }
+    const GLuint compute = compileShader(GL_COMPUTE_SHADER_, source);
+    if (compute == 0) {
+        return 0;
+    }
+    const GLuint program = gl.createProgram();
+    gl.attachShader(program, compute);
+    if (!cached.empty()) {
+        gl.programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT_, GL_TRUE);
+    }
+    gl.linkProgram(program);
+    gl.deleteShader(compute);
+    if (!checkLinked(program)) {
+        return 0;
+    }
+    if (!cached.empty()) {
+        saveCachedProgram(program, cached);
+    }
+    return program;
+}
+
+// Start from a screen already full of rain, as RainSystem::prefill does
+std::vector<float> prefilledState(std::size_t dropCount, sf::Vector2u size, const RainConfig& config, const DropSizeTable& sizes) {
+    std::vector<float> state(dropCount * 4);
+    Rng rng(config.seed);
+    for (std::size_t i = 0; i < dropCount; ++i) {
+        const float dropSize = sizes.draw(rng);
+        state[i * 4 + 0] = rng.uniform(0.0f, static_cast<float>(size.x));
+        state[i * 4 + 1] = rng.uniform(-100.0f, static_cast<float>(size.y));
+        state[i * 4 + 2] = terminalSpeed(dropSize);
+        state[i * 4 + 3] = dropSize;
+    }
+    return state;
+}
+
+// The shadow is a one-row float texture, read with texelFetch so there's no filtering
+GLuint createShadowTexture(const std::vector<float>& shadow) {
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F_, static_cast<GLsizei>(shadow.size()), 1, 0, GL_RED_, GL_FLOAT, shadow.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return texture;
+}
+
+void bindState(GLuint buffer) {
+    gl.bindBuffer(GL_ARRAY_BUFFER_, buffer);
+    gl.enableVertexAttribArray(0);
+    gl.vertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), nullptr);
+}
+
+} // namespace
+
+GpuRain::GpuRain(sf::RenderWindow& window, sf::Vector2u worldSize, const RainConfig& config, const Scene& scene, std::size_t dropCount, GpuRainBackend backend,
+    const std::string& programCache)
+    : window(window), windowSize(worldSize), config(config), sizes(config), dropCount(dropCount), available(false), current(0),
+      updateProgram(0), drawProgram(0), shadowTexture(0), hitTexture(0), hitFramebuffer(0), step(0),
+      readbackCurrent(0), readbackPending(false), compactProgram(0), visibleBuffer(0), visibleFeedback(0), compacting(false),
+      computing(false), drawCommand(0), hitBuffer(0), hits(nullptr) {
+    stateBuffers[0] = stateBuffers[1] = 0;
+    hitReadback[0] = hitReadback[1] = 0;
+    hitFences[0] = hitFences[1] = nullptr;
+    if (this->dropCount == 0) {
+        // Drops live for the time it takes to fall from the spawn band to the ground
+        const float meanSpeed = terminalSpeed((config.minSize + config.maxSize) / 2.0f);
+        this->dropCount = static_cast<std::size_t>(config.spawnRate * windowSize.x * (windowSize.y + 75.0f) / meanSpeed);
+    }
+    window.setActive(true);
+    programCacheDir = !programCache.empty() && loadBinaryFunctions() ? programCache : std::string();
+    if (backend == GPU_COMPUTE) {
+        computing = createCompute(scene);
+        if (!computing) {
+            destroy();
+            std::cerr << "Running the GPU rain with transform feedback instead" << std::endl;
+        }
+    }
+    available = computing || create(scene);
+    if (!available) {
+        destroy();
+    }
+    window.resetGLStates();
+}
+
+GpuRain::~GpuRain() {
+    destroy();
+}
+
+bool GpuRain::create(const Scene& scene) {
+    const sf::ContextSettings settings = sf::Context::getActiveContext() != nullptr
+        ? sf::Context::getActiveContext()->getSettings() : sf::ContextSettings();
+    if (settings.majorVersion < 3 || !loadFunctions()) {
+        std::cerr << "GPU rain needs OpenGL 3.0" << std::endl;
+        return false;
+    }
+
+    updateProgram = linkProgram(UPDATE_VERTEX_SHADER, UPDATE_FRAGMENT_SHADER, "outState");
+    drawProgram = linkProgram(DRAW_VERTEX_SHADER, DRAW_FRAGMENT_SHADER, nullptr);
+    if (updateProgram == 0 || drawProgram == 0) {
+        return false;
+    }
+
+    const std::vector<float> state = prefilledState(dropCount, windowSize, config, sizes);
+    gl.genBuffers(2, stateBuffers);
+    for (GLuint buffer : stateBuffers) {
+        gl.bindBuffer(GL_ARRAY_BUFFER_, buffer);
+        gl.bufferData(GL_ARRAY_BUFFER_, static_cast<GlSizeiptr>(state.size() * sizeof(float)), state.data(), GL_STREAM_DRAW_);
+    }
+    gl.bindBuffer(GL_ARRAY_BUFFER_, 0);
+
+    shadowTexture = createShadowTexture(scene.rainShadow(windowSize));
+
+    glGenTextures(1, &hitTexture);
+    glBindTexture(GL_TEXTURE_2D, hitTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F_, static_cast<GLsizei>(MAX_PEOPLE), 1, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    gl.genFramebuffers(1, &hitFramebuffer);
+    gl.bindFramebuffer(GL_FRAMEBUFFER_, hitFramebuffer);
+    gl.framebufferTexture2D(GL_FRAMEBUFFER_, GL_COLOR_ATTACHMENT0_, GL_TEXTURE_2D, hitTexture, 0);
+    const bool complete = gl.checkFramebufferStatus(GL_FRAMEBUFFER_) == GL_FRAMEBUFFER_COMPLETE_;
+    if (complete) {
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+    gl.bindFramebuffer(GL_FRAMEBUFFER_, 0);
+    if (!complete) {
+        std::cerr << "GPU rain can't render to a float target" << std::endl;
+        return false;
+    }
+
+    // Each frame's hits are copied into one of these to be read the frame after, by when the copy is done
+    gl.genBuffers(2, hitReadback);
+    for (GLuint buffer : hitReadback) {
+        gl.bindBuffer(GL_PIXEL_PACK_BUFFER_, buffer);
+        gl.bufferData(GL_PIXEL_PACK_BUFFER_, static_cast<GlSizeiptr>(MAX_PEOPLE * 4 * sizeof(float)), nullptr, GL_STREAM_READ_);
+    }
+    gl.bindBuffer(GL_PIXEL_PACK_BUFFER_, 0);
+
+    // Compaction is an extra the rain works without, on cards short of OpenGL 4.0
+    if (settings.majorVersion >= 4 && loadCompactionFunctions()) {
+        compactProgram = linkProgram(COMPACT_VERTEX_SHADER, nullptr, "visibleState", COMPACT_GEOMETRY_SHADER);
+    }
+    if (compactProgram != 0) {
+        gl.genBuffers(1, &visibleBuffer);
+        gl.bindBuffer(GL_ARRAY_BUFFER_, visibleBuffer);
+        gl.bufferData(GL_ARRAY_BUFFER_, static_cast<GlSizeiptr>(dropCount * 4 * sizeof(float)), nullptr, GL_STREAM_DRAW_);
+        gl.bindBuffer(GL_ARRAY_BUFFER_, 0);
+        gl.genTransformFeedbacks(1, &visibleFeedback);
+        gl.bindTransformFeedback(GL_TRANSFORM_FEEDBACK_, visibleFeedback);
+        gl.bindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER_, 0, visibleBuffer);
+        gl.bindTransformFeedback(GL_TRANSFORM_FEEDBACK_, 0);
+        compacting = true;
+    }
+    return true;
+}
+
+bool GpuRain::createCompute(const Scene& scene) {
+    const sf::ContextSettings settings = sf::Context::getActiveContext() != nullptr
+        ? sf::Context::getActiveContext()->getSettings() : sf::ContextSettings();
+    if (!loadFunctions() || !hasCompute(settings)) {
+        std::cerr << "The GPU rain's compute backend needs OpenGL 4.4" << std::endl;
+        return false;
+    }
+
+    updateProgram = linkComputeProgram(UPDATE_COMPUTE_SHADER);
+    drawProgram = linkProgram(INSTANCED_VERTEX_SHADER, INSTANCED_FRAGMENT_SHADER, nullptr);
+    if (updateProgram == 0 || drawProgram == 0) {
+        return false;
+    }
+
+    // The state and the visible list never leave the card, so they're storage with no mapping
+    const std::vector<float> state = prefilledState(dropCount, windowSize, config, sizes);
+    gl.genBuffers(1, &stateBuffers[0]);
+    gl.bindBuffer(GL_SHADER_STORAGE_BUFFER_, stateBuffers[0]);
+    gl.bufferStorage(GL_SHADER_STORAGE_BUFFER_, static_cast<GlSizeiptr>(state.size() * sizeof(float)), state.data(), 0);
+    gl.genBuffers(1, &visibleBuffer);
+    gl.bindBuffer(GL_SHADER_STORAGE_BUFFER_, visibleBuffer);
+    gl.bufferStorage(GL_SHADER_STORAGE_BUFFER_, static_cast<GlSizeiptr>(dropCount * sizeof(std::uint32_t)), nullptr, 0);
+
+    // Four vertices per instance, the instance count filled in by each step
+    const std::uint32_t command[4] = { 4, 0, 0, 0 };
+    gl.genBuffers(1, &drawCommand);
+    gl.bindBuffer(GL_SHADER_STORAGE_BUFFER_, drawCommand);
+    gl.bufferStorage(GL_SHADER_STORAGE_BUFFER_, sizeof(command), command, GL_DYNAMIC_STORAGE_BIT_);
+
+    // The hit row stays mapped: the GPU adds into a slot, and the CPU reads it once the
+    // frame's fence has passed and zeroes it for reuse, with no copy or map in between
+    const GLbitfield flags = GL_MAP_READ_BIT_ | GL_MAP_WRITE_BIT_ | GL_MAP_PERSISTENT_BIT_ | GL_MAP_COHERENT_BIT_;
+    const GlSizeiptr hitBytes = static_cast<GlSizeiptr>(2 * MAX_PEOPLE * sizeof(std::uint32_t));
+    const std::vector<std::uint32_t> zeros(2 * MAX_PEOPLE, 0);
+    gl.genBuffers(1, &hitBuffer);
+    gl.bindBuffer(GL_SHADER_STORAGE_BUFFER_, hitBuffer);
+    gl.bufferStorage(GL_SHADER_STORAGE_BUFFER_, hitBytes, zeros.data(), flags);
+    hits = static_cast<std::uint32_t*>(gl.mapBufferRange(GL_SHADER_STORAGE_BUFFER_, 0, hitBytes, flags));
+    gl.bindBuffer(GL_SHADER_STORAGE_BUFFER_, 0);
+    if (hits == nullptr) {
+        std::cerr << "GPU rain couldn't map its hit row" << std::endl;
+        return false;
+    }
+
+    shadowTexture = createShadowTexture(scene.rainShadow(windowSize));
+    return true;
+}
+
+void GpuRain::destroy() {
+    if (gl.deleteBuffers == nullptr) {
+        return; // Nothing was created
+    }
+    if (stateBuffers[0] != 0) {
+        gl.deleteBuffers(2, stateBuffers);
+    }
+    if (updateProgram != 0) {
+        gl.deleteProgram(updateProgram);
+    }
+    if (drawProgram != 0) {
+        gl.deleteProgram(drawProgram);
+    }
+    if (hitFramebuffer != 0) {
+        gl.deleteFramebuffers(1, &hitFramebuffer);
+    }
+    if (shadowTexture != 0) {
+        glDeleteTextures(1, &shadowTexture);
+    }
+    if (hitTexture != 0) {
+        glDeleteTextures(1, &hitTexture);
+    }
+    if (hitReadback[0] != 0) {
+        gl.deleteBuffers(2, hitReadback);
+    }
+    if (compactProgram != 0) {
+        gl.deleteProgram(compactProgram);
+    }
+    if (visibleBuffer != 0) {
+        gl.deleteBuffers(1, &visibleBuffer);
+    }
+    if (visibleFeedback != 0) {
+        gl.deleteTransformFeedbacks(1, &visibleFeedback);
+    }
+    if (drawCommand != 0) {
+        gl.deleteBuffers(1, &drawCommand);
+    }
+    // Deleting the hit buffer unmaps it
+    if (hitBuffer != 0) {
+        gl.deleteBuffers(1, &hitBuffer);
+    }
+    for (void*& fence : hitFences) {
+        if (fence != nullptr) {
+            gl.deleteSync(static_cast<GlSync>(fence));
+            fence = nullptr;
+        }
+    }
+    stateBuffers[0] = stateBuffers[1] = 0;
+    hitReadback[0] = hitReadback[1] = 0;
+    readbackPending = false;
+    updateProgram = drawProgram = shadowTexture = hitTexture = hitFramebuffer = 0;
+    compactProgram = visibleBuffer = visibleFeedback = 0;
+    compacting = false;
+    drawCommand = hitBuffer = 0;
+    hits = nullptr;
+}
+
+void GpuRain::update(float deltaTime, const sf::FloatRect& personBounds) {
+    update(deltaTime, &personBounds, 1);
+}
+
+void GpuRain::update(float deltaTime, const sf::FloatRect* people, std::size_t peopleCount) {
+    if (!available) {
+        return;
+    }
+    peopleCount = std::min(peopleCount, MAX_PEOPLE);
+    float boxes[MAX_PEOPLE * 4];
+    for (std::size_t i = 0; i < peopleCount; ++i) {
+        boxes[i * 4 + 0] = rectLeft(people[i]);
+        boxes[i * 4 + 1] = rectTop(people[i]);
+        boxes[i * 4 + 2] = rectLeft(people[i]) + rectWidth(people[i]);
+        boxes[i * 4 + 3] = rectTop(people[i]) + rectHeight(people[i]);
+    }
+    if (computing) {
+        updateCompute(deltaTime, boxes, peopleCount);
+        return;
+    }
+    const GLuint source = stateBuffers[current];
+    const GLuint target = stateBuffers[1 - current];
+
+    gl.useProgram(updateProgram);
+    gl.uniform1f(gl.getUniformLocation(updateProgram, "deltaTime"), deltaTime);
+    if (peopleCount > 0) {
+        gl.uniform4fv(gl.getUniformLocation(updateProgram, "people"), static_cast<GLsizei>(peopleCount), boxes);
+    }
+    gl.uniform1i(gl.getUniformLocation(updateProgram, "personCount"), static_cast<GLint>(peopleCount));
+    gl.uniform2f(gl.getUniformLocation(updateProgram, "screenSize"), static_cast<float>(windowSize.x), static_cast<float>(windowSize.y));
+    const std::vector<float>& quantiles = sizes.getQuantiles();
+    gl.uniform1fv(gl.getUniformLocation(updateProgram, "sizeQuantiles"), static_cast<GLsizei>(quantiles.size()), quantiles.data());
+    gl.uniform1ui(gl.getUniformLocation(updateProgram, "seed"), static_cast<GLuint>(config.seed) ^ (step++ * 0x9E3779B9u));
+    gl.uniform1i(gl.getUniformLocation(updateProgram, "shadow"), 0);
+    glBindTexture(GL_TEXTURE_2D, shadowTexture);
+
+    // Hits add up in the person's pixel of the hit row; everything else is placed outside it and clipped
+    gl.bindFramebuffer(GL_FRAMEBUFFER_, hitFramebuffer);
+    glViewport(0, 0, static_cast<GLsizei>(MAX_PEOPLE), 1);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+    glEnable(GL_PROGRAM_POINT_SIZE_);
+
+    bindState(source);
+    gl.bindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER_, 0, target);
+    gl.beginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(dropCount));
+    gl.endTransformFeedback();
+    gl.bindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER_, 0, 0);
+    current = 1 - current;
+
+    restoreState();
+}
+
+float GpuRain::takeWetness() {
+    float wetness = 0.0f;
+    takeWetness(&wetness, 1);
+    return wetness;
+}
+
+void GpuRain::takeWetness(float* wetness, std::size_t peopleCount) {
+    std::fill(wetness, wetness + peopleCount, 0.0f);
+    if (!available) {
+        return;
+    }
+    if (computing) {
+        takeComputedWetness(wetness, peopleCount);
+        return;
+    }
+
+    // Start copying this frame's row into one buffer and clear it for the next; the copy goes
+    // on while the CPU carries on, instead of glReadPixels waiting for every step queued so far
+    gl.bindFramebuffer(GL_FRAMEBUFFER_, hitFramebuffer);
+    gl.bindBuffer(GL_PIXEL_PACK_BUFFER_, hitReadback[readbackCurrent]);
+    glReadPixels(0, 0, static_cast<GLsizei>(MAX_PEOPLE), 1, GL_RGBA, GL_FLOAT, nullptr);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // and read last frame's from the other, which has long since arrived
+    if (readbackPending) {
+        gl.bindBuffer(GL_PIXEL_PACK_BUFFER_, hitReadback[1 - readbackCurrent]);
+        if (const float* row = static_cast<const float*>(gl.mapBuffer(GL_PIXEL_PACK_BUFFER_, GL_READ_ONLY_))) {
+            for (std::size_t i = 0; i < std::min(peopleCount, MAX_PEOPLE); ++i) {
+                wetness[i] = row[i * 4];
+            }
+            gl.unmapBuffer(GL_PIXEL_PACK_BUFFER_);
+        }
+    }
+    readbackPending = true;
+    readbackCurrent = 1 - readbackCurrent;
+    gl.bindBuffer(GL_PIXEL_PACK_BUFFER_, 0);
+    gl.bindFramebuffer(GL_FRAMEBUFFER_, 0);
+    window.resetGLStates();
+}
+
+void GpuRain::draw(sf::Color color) {
+    if (!available) {
+        return;
+    }
+    if (computing) {
+        drawCompute(color);
+        return;
+    }
+    if (compacting) {
+        // Pack the drops on screen into the visible buffer. The count stays with the feedback
+        // object, which the draw below takes it from, so the CPU never waits to learn it
+        gl.useProgram(compactProgram);
+        gl.uniform2f(gl.getUniformLocation(compactProgram, "screenSize"), static_cast<float>(windowSize.x), static_cast<float>(windowSize.y));
+        glEnable(GL_RASTERIZER_DISCARD_);
+        bindState(stateBuffers[current]);
+        gl.bindTransformFeedback(GL_TRANSFORM_FEEDBACK_, visibleFeedback);
+        gl.beginTransformFeedback(GL_POINTS);
+        glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(dropCount));
+        gl.endTransformFeedback();
+        gl.bindTransformFeedback(GL_TRANSFORM_FEEDBACK_, 0);
+        glDisable(GL_RASTERIZER_DISCARD_);
+    }
+    gl.useProgram(drawProgram);
+    gl.uniform2f(gl.getUniformLocation(drawProgram, "screenSize"), static_cast<float>(windowSize.x), static_cast<float>(windowSize.y));
+    gl.uniform4f(gl.getUniformLocation(drawProgram, "color"), color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f);
+
+    // The world fills the view's viewport, which GL counts from the bottom of the window
+    const sf::IntRect viewport = window.getViewport(window.getView());
+    gl.uniform1f(gl.getUniformLocation(drawProgram, "pixelsPerUnit"), rectWidth(viewport) / static_cast<float>(windowSize.x));
+    glViewport(rectLeft(viewport), static_cast<GLint>(window.getSize().y) - (rectTop(viewport) + rectHeight(viewport)), rectWidth(viewport), rectHeight(viewport));
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable(GL_PROGRAM_POINT_SIZE_);
+
+    if (compacting) {
+        bindState(visibleBuffer);
+        gl.drawTransformFeedback(GL_POINTS, visibleFeedback);
+    }
+    else {
+        bindState(stateBuffers[current]);
+        glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(dropCount));
+    }
+
+    restoreState();
+}
+
+void GpuRain::updateCompute(float deltaTime, const float* boxes, std::size_t peopleCount) {
+    // Each step lists the visible drops afresh
+    const std::uint32_t noInstances = 0;
+    gl.bindBuffer(GL_SHADER_STORAGE_BUFFER_, drawCommand);
+    gl.bufferSubData(GL_SHADER_STORAGE_BUFFER_, sizeof(std::uint32_t), sizeof(noInstances), &noInstances);
+    gl.bindBuffer(GL_SHADER_STORAGE_BUFFER_, 0);
+
+    gl.useProgram(updateProgram);
+    gl.uniform1f(gl.getUniformLocation(updateProgram, "deltaTime"), deltaTime);
+    if (peopleCount > 0) {
+        gl.uniform4fv(gl.getUniformLocation(updateProgram, "people"), static_cast<GLsizei>(peopleCount), boxes);
+    }
+    gl.uniform1i(gl.getUniformLocation(updateProgram, "personCount"), static_cast<GLint>(peopleCount));
+    gl.uniform2f(gl.getUniformLocation(updateProgram, "screenSize"), static_cast<float>(windowSize.x), static_cast<float>(windowSize.y));
+    const std::vector<float>& quantiles = sizes.getQuantiles();
+    gl.uniform1fv(gl.getUniformLocation(updateProgram, "sizeQuantiles"), static_cast<GLsizei>(quantiles.size()), quantiles.data());
+    gl.uniform1ui(gl.getUniformLocation(updateProgram, "seed"), static_cast<GLuint>(config.seed) ^ (step++ * 0x9E3779B9u));
+    gl.uniform1ui(gl.getUniformLocation(updateProgram, "dropCount"), static_cast<GLuint>(dropCount));
+    gl.uniform1ui(gl.getUniformLocation(updateProgram, "hitSlot"), static_cast<GLuint>(readbackCurrent * MAX_PEOPLE));
+    gl.uniform1i(gl.getUniformLocation(updateProgram, "shadow"), 0);
+    glBindTexture(GL_TEXTURE_2D, shadowTexture);
+
+    gl.bindBufferBase(GL_SHADER_STORAGE_BUFFER_, 0, stateBuffers[0]);
+    gl.bindBufferBase(GL_SHADER_STORAGE_BUFFER_, 1, visibleBuffer);
+    gl.bindBufferBase(GL_SHADER_STORAGE_BUFFER_, 2, drawCommand);
+    gl.bindBufferBase(GL_SHADER_STORAGE_BUFFER_, 3, hitBuffer);
+    const std::size_t groups = (dropCount + COMPUTE_GROUP_SIZE - 1) / COMPUTE_GROUP_SIZE;
+    gl.dispatchCompute(static_cast<GLuint>(groups), 1, 1);
+
+    // The next step and the draw read what this one wrote, the draw's count included
+    gl.memoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT_ | GL_COMMAND_BARRIER_BIT_);
+    restoreState();
+}
+
+// The frame's slot is fenced and the other one, last frame's, read once its own fence has
+// passed, which it all but always has by now. It's then zeroed for the frame to come
+void GpuRain::takeComputedWetness(float* wetness, std::size_t peopleCount) {
+    gl.memoryBarrier(GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT_);
+    hitFences[readbackCurrent] = gl.fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE_, 0);
+    readbackCurrent = 1 - readbackCurrent;
+
+    if (GlSync fence = static_cast<GlSync>(hitFences[readbackCurrent])) {
+        GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT_;
+        while (gl.clientWaitSync(fence, flags, 1000000000ull) == GL_TIMEOUT_EXPIRED_) {
+            flags = 0;
+        }
+        gl.deleteSync(fence);
+        hitFences[readbackCurrent] = nullptr;
+    }
+    std::uint32_t* slot = hits + readbackCurrent * MAX_PEOPLE;
+    if (readbackPending) {
+        for (std::size_t i = 0; i < std::min(peopleCount, MAX_PEOPLE); ++i) {
+            wetness[i] = slot[i] / HIT_UNITS;
+        }
+    }
+    std::fill(slot, slot + MAX_PEOPLE, 0u);
+    readbackPending = true;
+}
+
+void GpuRain::drawCompute(sf::Color color) {
+    gl.useProgram(drawProgram);
+    gl.uniform2f(gl.getUniformLocation(drawProgram, "screenSize"), static_cast<float>(windowSize.x), static_cast<float>(windowSize.y));
+    gl.uniform4f(gl.getUniformLocation(drawProgram, "color"), color.r / 255.0f, color.g / 255.0f, color.b / 255.0f, color.a / 255.0f);
+
+    const sf::IntRect viewport = window.getViewport(window.getView());
+    glViewport(rectLeft(viewport), static_cast<GLint>(window.getSize().y) - (rectTop(viewport) + rectHeight(viewport)), rectWidth(viewport), rectHeight(viewport));
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // Everything comes out of the storage buffers, so SFML's client arrays must be off
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    gl.bindBufferBase(GL_SHADER_STORAGE_BUFFER_, 0, stateBuffers[0]);
+    gl.bindBufferBase(GL_SHADER_STORAGE_BUFFER_, 1, visibleBuffer);
+    gl.bindBuffer(GL_DRAW_INDIRECT_BUFFER_, drawCommand);
+    gl.drawArraysIndirect(GL_TRIANGLE_STRIP, nullptr);
+    gl.bindBuffer(GL_DRAW_INDIRECT_BUFFER_, 0);
+
+    restoreState();
+}
+
+// Puts back what SFML expects: no program or buffer bound and the default framebuffer. Its
+// cached states are reset too, since the blend mode and viewport changed under it
+void GpuRain::restoreState() {
+    gl.disableVertexAttribArray(0);
+    gl.bindBuffer(GL_ARRAY_BUFFER_, 0);
+    gl.useProgram(0);
+    gl.bindFramebuffer(GL_FRAMEBUFFER_, 0);
+    if (computing) {
+        for (GLuint binding = 0; binding < 4; ++binding) {
+            gl.bindBufferBase(GL_SHADER_STORAGE_BUFFER_, binding, 0);
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_PROGRAM_POINT_SIZE_);
+    window.resetGLStates();
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Constants.h"
+#include "DropSizes.h"
+#include "MemoryUsage.h"
+#include "RainConfig.h"
+#include "Scene.h"
+
+// Optional rain simulation that runs entirely on the GPU. The drop state lives in a pair of
+// buffers that a vertex shader ping-pongs between with transform feedback, so nothing is ever
+// uploaded per frame. Drops that land or are caught by the person respawn at the top in the
+// same pass, keeping a fixed population on the card.
+//
+// Drawing starts with a compaction pass where there's OpenGL 4.0: a geometry shader keeps the
+// drops that are on screen, transform feedback packs them into a buffer of their own, and the
+// draw takes its count straight from the feedback object. The drops waiting above the screen
+// cost no draw work, and the CPU never reads the count back.
+//
+// The same pass tests every drop against up to MAX_PEOPLE boxes in a uniform array and
+// rasterizes each one that hit someone as a point onto that person's pixel of a row of float
+// pixels, where additive blending sums the areas. That row, a few hundred bytes, is the only
+// thing read back: takeWetness() copies it into a pixel buffer each frame and reads the one
+// copied the frame before, so the CPU never waits on the GPU and wetness arrives one frame
+// late. Needs OpenGL 3.0; isAvailable() is false when the context can't do it, and
+// the caller should fall back to RainSystem.
+//
+// The compute backend, where there's OpenGL 4.4 or 4.3 with ARB_buffer_storage, does the
+// same work with less driver in the way. One compute dispatch advances every drop in place in
+// a storage buffer, sums hits with atomics straight into a persistently mapped row, and packs
+// the indices of the drops on screen along with their count into an indirect draw command.
+// The draw is then one instanced call drawing a quad per visible drop out of the storage
+// buffer, with nothing bound but buffers. Hits sum in fixed point there, as atomics only add
+// integers. Without it the transform feedback path runs instead
+//
+// Given a cache directory, each program is linked once and kept there as the driver's binary,
+// where there's OpenGL 4.1 or ARB_get_program_binary, and later runs load it instead of
+// compiling. A binary is named after its sources and the driver, so a new one of either is
+// compiled afresh, and one the driver turns down is too
+//
+// Everything runs in the window's context, which has to be active for every call. Since the
+// raw GL calls bypass SFML, each one leaves the window's cached GL states reset
+enum GpuRainBackend {
+    GPU_FEEDBACK, // Transform feedback, OpenGL 3.0
+    GPU_COMPUTE   // Compute shaders and persistently mapped buffers, OpenGL 4.4
+};
+
+class GpuRain {
+public:
+    // dropCount of 0 picks the population the CPU rain settles at for config's spawn rate
+    // Simulates a world of worldSize units, drawn through the window's current view
+    // GPU_COMPUTE falls back to GPU_FEEDBACK where the context can't run it
+    // An empty programCache caches nothing
+    GpuRain(sf::RenderWindow& window, sf::Vector2u worldSize, const RainConfig& config, const Scene& scene, std::size_t dropCount, GpuRainBackend backend,
+        const std::string& programCache = std::string());
+    ~GpuRain();
+
+    GpuRain(const GpuRain&) = delete;
+    GpuRain& operator=(const GpuRain&) = delete;
+
+    bool isAvailable() const {
+        return available;
+    }
+
+    // Advances every drop by deltaTime and adds the area of the drops touching each of the
+    // people to theirs pending readback. Follows the CPU rules: swept person test, column
+    // shadow. A drop touching two people counts for the first
+    void update(float deltaTime, const sf::FloatRect* people, std::size_t peopleCount);
+    void update(float deltaTime, const sf::FloatRect& personBounds);
+
+    // The wetness each person gathered in the frame before the last call's, one frame late so
+    // it never stalls, and starts fetching the frame since. The first call gives zeros
+    void takeWetness(float* wetness, std::size_t peopleCount);
+    float takeWetness(); // For the first person
+
+    void draw(sf::Color color);
+
+    std::size_t count() const {
+        return dropCount;
+    }
+
+    // GPU memory: both state buffers, the visible buffer, the shadow texture and the hit row and
+    // its copies. The compute backend has one state buffer, an index per visible drop and the
+    // hit row's two slots
+    MemoryUsage memoryUsage() const {
+        std::size_t bytes = 0;
+        if (available && computing) {
+            bytes = dropCount * (4 * sizeof(float) + sizeof(std::uint32_t)) + windowSize.x * sizeof(float) + 2 * MAX_PEOPLE * sizeof(std::uint32_t) + 4 * sizeof(std::uint32_t);
+        }
+        else if (available) {
+            const std::size_t buffers = compacting ? 3 : 2;
+            bytes = buffers * dropCount * 4 * sizeof(float) + windowSize.x * sizeof(float) + 3 * MAX_PEOPLE * 4 * sizeof(float);
+        }
+        const MemoryUsage usage = { bytes, bytes };
+        return usage;
+    }
+
+private:
+    sf::RenderWindow& window;
+    sf::Vector2u windowSize; // The world's size; it used to be the window's
+    RainConfig config;
+    DropSizeTable sizes;
+    std::size_t dropCount;
+    bool available;
+
+    unsigned stateBuffers[2]; // Ping-pong buffers of (x, y, vy, size) per drop; only the first when computing
+    unsigned current;         // Index of the buffer holding the latest state
+    unsigned updateProgram;   // A compute program when computing
+    unsigned drawProgram;
+    unsigned shadowTexture;   // Rain shadow heights, one texel per screen column
+    unsigned hitTexture;      // MAX_PEOPLE x 1 float target the hits are summed into, a pixel per person
+    unsigned hitFramebuffer;
+    std::uint32_t step;       // Seeds the respawn hash, so every step draws new drops
+    unsigned hitReadback[2];  // Pixel buffers the hit row is copied into, a frame apart
+    unsigned readbackCurrent; // The one this frame's row goes into
+    bool readbackPending;     // Whether the other holds last frame's
+    unsigned compactProgram;  // Keeps the drops on screen, when there's compaction
+    unsigned visibleBuffer;   // The drops it kept, packed; their indices when computing
+    unsigned visibleFeedback; // Transform feedback object holding how many that was
+    bool compacting;
+    bool computing;
+    unsigned drawCommand;     // Indirect draw command the compute pass counts the visible drops into
+    unsigned hitBuffer;       // The compute backend's hit row, a slot per frame, mapped for good
+    std::uint32_t* hits;      // Where it's mapped
+    void* hitFences[2];       // Passed once the GPU is done adding to each slot
+
+    bool create(const Scene& scene);
+    bool createCompute(const Scene& scene);
+    void destroy();
+    void restoreState();
+    void updateCompute(float deltaTime, const float* boxes, std::size_t peopleCount);
+    void takeComputedWetness(float* wetness, std::size_t peopleCount);
+    void drawCompute(sf::Color color);
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "Constants.h"
+#include "MemoryUsage.h"
+
+// Water standing on the ground, as a depth per GROUND_CELL_WIDTH column of the world. Every
+// drop that reaches the ground pools GROUND_WATER_POOLED of its area in its column, the rest
+// soaking in, and what stands drains away with a time constant of GROUND_WATER_DRAIN seconds,
+// so steady rain settles at a steady depth. Drops that land on the scene run off it.
+//
+// The cost is the same whatever the rain: RainSystem adds up each step's landings per chunk,
+// as it does everything else, and hands the sums over once in chunk order
+class GroundWater {
+public:
+    GroundWater() {}
+
+    explicit GroundWater(unsigned worldWidth)
+        : depths(static_cast<std::size_t>(std::ceil(worldWidth / GROUND_CELL_WIDTH)) + 1, 0.0f) {}
+
+    std::size_t cells() const {
+        return depths.size();
+    }
+
+    std::size_t cellOf(float x) const {
+        return std::min(static_cast<std::size_t>(std::max(x, 0.0f) / GROUND_CELL_WIDTH), depths.size() - 1);
+    }
+
+    // Drains deltaTime's worth of what stands, then pools the area landed[c] that reached cell c
+    void step(float deltaTime, const float* landed) {
+        const float kept = std::exp(-deltaTime / GROUND_WATER_DRAIN);
+        const float pooled = GROUND_WATER_POOLED / GROUND_CELL_WIDTH;
+        for (std::size_t c = 0; c < depths.size(); ++c) {
+            depths[c] = depths[c] * kept + landed[c] * pooled;
+        }
+    }
+
+    void clear() {
+        std::fill(depths.begin(), depths.end(), 0.0f);
+    }
+
+    float depthAt(std::size_t cell) const {
+        return depths[cell];
+    }
+
+    // Writes the water as one triangle strip standing on groundY, two vertices per cell edge,
+    // each edge as deep as the cells either side of it on average and no deeper than
+    // GROUND_WATER_MAX_DEPTH. The strip's vertex array is resized, so reusing one never allocates
+    void build(sf::VertexArray& strip, float groundY, sf::Color color) const {
+        strip.setPrimitiveType(sf::PrimitiveType::TriangleStrip);
+        strip.resize(2 * (depths.size() + 1));
+        for (std::size_t edge = 0; edge <= depths.size(); ++edge) {
+            const float left = edge > 0 ? depths[edge - 1] : depths.front();
+            const float right = edge < depths.size() ? depths[edge] : depths.back();
+            const float depth = std::min((left + right) * 0.5f, GROUND_WATER_MAX_DEPTH);
+            const float x = edge * GROUND_CELL_WIDTH;
+            strip[2 * edge] = sf::Vertex{ sf::Vector2f(x, groundY - depth), color };
+            strip[2 * edge + 1] = sf::Vertex{ sf::Vector2f(x, groundY), color };
+        }
+    }
+
+    MemoryUsage memoryUsage() const {
+        return vectorUsage(depths);
+    }
+
+private:
+    std::vector<float> depths;
+};
@@ -0,0 +1,683 @@
+#include "Headless.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+#include "Clothing.h"
+#include "Constants.h"
+#include "CycleTimer.h"
+#include "DensityRain.h"
+#include "EventRain.h"
+#include "ExactWetness.h"
+#include "Person.h"
+#include "ProceduralRain.h"
+#include "RainSystem.h"
+#include "RunSummary.h"
+#include "SfmlCompat.h"
+#include "Snapshot.h"
+#include "TerminalVelocity.h"
+
+namespace {
+
+// The columns rain has to fall in to reach anyone in the crowd, and the top of that rain: just
+// above the tallest head. Sheltering in the scene may raise the top further
+struct CrowdBand {
+    float left;
+    float right;
+    float top;
+};
+
+CrowdBand crowdBand(sf::Vector2u screen, const RainConfig& rain, const std::vector<Walker>& walkers, std::size_t count) {
+    CrowdBand band = { static_cast<float>(screen.x), 0.0f, static_cast<float>(screen.y) };
+    for (std::size_t i = 0; i < count; ++i) {
+        const sf::FloatRect corridor = travelCorridor(screen, sf::Vector2f(walkers[i].personWidth, walkers[i].personHeight));
+        float left = rectLeft(corridor);
+        float right = rectLeft(corridor) + rectWidth(corridor);
+        if (walkers[i].trajectory != nullptr) {
+            left = std::min(left, walkers[i].trajectory->minX() - walkers[i].personWidth / 2.0f);
+            right = std::max(right, walkers[i].trajectory->maxX() + walkers[i].personWidth / 2.0f);
+        }
+        band.left = std::min(band.left, left - rain.maxSize);
+        band.right = std::max(band.right, right);
+        band.top = std::min(band.top, rectTop(corridor) - RainField::heightOf(rain.maxSize));
+    }
+    return band;
+}
+
+// simulateCrowd in calm air, on EventRain. Every path is known up front: each person stands at
+// the start until the rain has settled and their start time has come, then walks to the end
+std::vector<float> simulateCrowdEvents(const Options& options, const RainConfig& rain, const Scene& scene, const std::vector<Walker>& walkers,
+    Telemetry* telemetry, std::vector<SurfaceWetness>* surfaces) {
+    const sf::Vector2u screen(options.width, options.height);
+    const float timestep = 1.0f / options.simHz;
+    const std::size_t count = std::min(walkers.size(), MAX_PEOPLE);
+    EventRain eventRain(screen, rain, scene, timestep);
+
+    const CrowdBand band = crowdBand(screen, rain, walkers, count);
+    const float spawnTop = std::min(band.top, eventRain.spawnTopAbove(band.left, band.right));
+    eventRain.setSpawnBand(band.left, band.right);
+    eventRain.setSpawnTop(spawnTop);
+
+    const float warmup = (options.height - spawnTop + 50.0f) / terminalSpeed(rain.minSize);
+    const sf::Vector2f start = startPoint(screen);
+    const sf::Vector2f end = endPoint(screen);
+    float lastArrival = 0.0f;
+    for (std::size_t i = 0; i < count; ++i) {
+        PersonPath path;
+        path.width = walkers[i].personWidth;
+        path.height = walkers[i].personHeight;
+        path.left = start.x - path.width / 2.0f;
+        path.top = start.y - path.height / 2.0f;
+        path.endLeft = end.x - path.width / 2.0f;
+        path.speed = walkers[i].speed;
+        path.startTime = warmup + walkers[i].startTime;
+        eventRain.addPerson(path);
+        lastArrival = std::max(lastArrival, path.arrivalTime());
+    }
+
+    std::vector<float> wetness(count, 0.0f);
+    std::vector<SurfaceWetness> split(count, SurfaceWetness());
+    std::vector<float> before(count);
+    const std::uint32_t firstTrack = telemetry ? telemetry->addTracks(count) : 0;
+    std::uint64_t steps = 0;
+    std::uint64_t dropSteps = 0;
+    while (eventRain.getTime() <= lastArrival) {
+        const std::uint64_t stepStarted = cycleCount();
+        before = wetness;
+        eventRain.update(timestep, wetness.data(), split.data());
+        ++steps;
+        dropSteps += eventRain.count();
+        if (telemetry && eventRain.getTime() > warmup) {
+            const float stepSeconds = cycleSeconds(cycleCount() - stepStarted);
+            for (std::size_t i = 0; i < count; ++i) {
+                const PersonPath& path = eventRain.getPerson(i);
+                const TelemetrySample sample = { eventRain.getTime() - warmup, path.leftAt(eventRain.getTime()) + path.width / 2.0f,
+                    path.top + path.height / 2.0f, (wetness[i] - before[i]) / timestep, wetness[i], stepSeconds,
+                    static_cast<std::uint32_t>(eventRain.count()), firstTrack + static_cast<std::uint32_t>(i), 0, 0, 0, 0, 0, 0, 0, 0 };
+                telemetry->record(sample);
+            }
+        }
+    }
+    addSimulatedWork(steps, dropSteps);
+    if (surfaces) {
+        *surfaces = split;
+    }
+    return wetness;
+}
+
+// simulateCrowd in calm air, on ProceduralRain. The rain has always been falling, so everyone
+// sets off at their start time with no warmup, and each step asks only for the drops that
+// could reach them during it
+std::vector<float> simulateCrowdProcedural(const Options& options, const RainConfig& rain, const Scene& scene,
+    const std::vector<Walker>& walkers, Telemetry* telemetry, std::vector<SurfaceWetness>* surfaces) {
+    const sf::Vector2u screen(options.width, options.height);
+    const float timestep = 1.0f / options.simHz;
+    const std::size_t count = std::min(walkers.size(), MAX_PEOPLE);
+    ProceduralRain proceduralRain(screen, rain, scene);
+
+    const CrowdBand band = crowdBand(screen, rain, walkers, count);
+    proceduralRain.setSpawnTop(std::min(band.top, proceduralRain.spawnTopAbove(band.left, band.right)));
+
+    const sf::Vector2f start = startPoint(screen);
+    const sf::Vector2f end = endPoint(screen);
+    std::vector<PersonPath> paths(count);
+    float lastArrival = 0.0f;
+    for (std::size_t i = 0; i < count; ++i) {
+        PersonPath& path = paths[i];
+        path.width = walkers[i].personWidth;
+        path.height = walkers[i].personHeight;
+        path.left = start.x - path.width / 2.0f;
+        path.top = start.y - path.height / 2.0f;
+        path.endLeft = end.x - path.width / 2.0f;
+        path.speed = walkers[i].speed;
+        path.startTime = walkers[i].startTime;
+        lastArrival = std::max(lastArrival, path.arrivalTime());
+    }
+
+    std::vector<float> wetness(count, 0.0f);
+    std::vector<SurfaceWetness> split(count, SurfaceWetness());
+    std::vector<float> caught(count);
+    const std::uint32_t firstTrack = telemetry ? telemetry->addTracks(count) : 0;
+    std::uint64_t steps = 0;
+    for (float t = 0.0f; t <= lastArrival; t += timestep) {
+        const std::uint64_t stepStarted = cycleCount();
+        ++steps;
+        for (std::size_t i = 0; i < count; ++i) {
+            caught[i] = 0.0f;
+            // Once they've arrived, nothing more is caught, so the cells aren't worth visiting
+            if (t + timestep > paths[i].startTime && t <= paths[i].arrivalTime()) {
+                caught[i] = proceduralRain.catches(paths[i], t, t + timestep, &split[i]);
+                wetness[i] += caught[i];
+            }
+        }
+        if (telemetry) {
+            const float stepSeconds = cycleSeconds(cycleCount() - stepStarted);
+            for (std::size_t i = 0; i < count; ++i) {
+                const PersonPath& path = paths[i];
+                const TelemetrySample sample = { t + timestep, path.leftAt(t + timestep) + path.width / 2.0f, path.top + path.height / 2.0f,
+                    caught[i] / timestep, wetness[i], stepSeconds, 0, firstTrack + static_cast<std::uint32_t>(i), 0, 0, 0, 0, 0, 0, 0, 0 };
+                telemetry->record(sample);
+            }
+        }
+    }
+    addSimulatedWork(steps, 0); // The drops are only ever looked up, never kept
+    if (surfaces) {
+        *surfaces = split;
+    }
+    return wetness;
+}
+
+// simulateCrowd on DensityRain, wind or not. The sky starts full, so everyone only waits at
+// the start long enough for the rain that was already inside them to have gone
+std::vector<float> simulateCrowdDensity(const Options& options, const RainConfig& rain, const Scene& scene,
+    const std::vector<Walker>& walkers, Telemetry* telemetry, std::vector<SurfaceWetness>* surfaces) {
+    const sf::Vector2u screen(options.width, options.height);
+    const float timestep = 1.0f / options.simHz;
+    const std::size_t count = std::min(walkers.size(), MAX_PEOPLE);
+    DensityRain densityRain(screen, rain, scene, options.densityParticles);
+
+    const CrowdBand band = crowdBand(screen, rain, walkers, count);
+    densityRain.setSpawnTop(std::min(band.top, densityRain.spawnTopAbove(band.left, band.right)));
+
+    const sf::Vector2f start = startPoint(screen);
+    const sf::Vector2f end = endPoint(screen);
+    float tallest = 0.0f;
+    for (std::size_t i = 0; i < count; ++i) {
+        tallest = std::max(tallest, walkers[i].personHeight);
+    }
+    const float warmup = (tallest + RainField::heightOf(rain.maxSize) + DENSITY_CELL_SIZE) / terminalSpeed(rain.minSize);
+    std::vector<PersonPath> paths(count);
+    float lastArrival = 0.0f;
+    for (std::size_t i = 0; i < count; ++i) {
+        PersonPath& path = paths[i];
+        path.width = walkers[i].personWidth;
+        path.height = walkers[i].personHeight;
+        path.left = start.x - path.width / 2.0f;
+        path.top = start.y - path.height / 2.0f;
+        path.endLeft = end.x - path.width / 2.0f;
+        path.speed = walkers[i].speed;
+        path.startTime = warmup + walkers[i].startTime;
+        lastArrival = std::max(lastArrival, path.arrivalTime());
+    }
+
+    std::vector<float> wetness(count, 0.0f);
+    std::vector<SurfaceWetness> split(count, SurfaceWetness());
+    std::vector<float> before(count);
+    const std::uint32_t firstTrack = telemetry ? telemetry->addTracks(count) : 0;
+    std::uint64_t steps = 0;
+    std::uint64_t dropSteps = 0;
+    while (densityRain.getTime() <= lastArrival) {
+        const std::uint64_t stepStarted = cycleCount();
+        before = wetness;
+        densityRain.update(timestep, paths.data(), count, wetness.data(), split.data());
+        ++steps;
+        dropSteps += densityRain.particleCount();
+        if (telemetry && densityRain.getTime() > warmup) {
+            const float stepSeconds = cycleSeconds(cycleCount() - stepStarted);
+            for (std::size_t i = 0; i < count; ++i) {
+                const PersonPath& path = paths[i];
+                const TelemetrySample sample = { densityRain.getTime() - warmup, path.leftAt(densityRain.getTime()) + path.width / 2.0f,
+                    path.top + path.height / 2.0f, (wetness[i] - before[i]) / timestep, wetness[i], stepSeconds, 0,
+                    firstTrack + static_cast<std::uint32_t>(i), 0, 0, 0, 0, 0, 0, 0, 0 };
+                telemetry->record(sample);
+            }
+        }
+    }
+    addSimulatedWork(steps, dropSteps);
+    if (surfaces) {
+        *surfaces = split;
+    }
+    return wetness;
+}
+
+// Restores the warmed-up rain and crowd from --snapshot if it was saved with the same world,
+// rain, scene and crowd sizes. The spawn band follows the sizes, so they have to match too.
+// Returns false, leaving everything as it was, if there's no snapshot or it doesn't match
+bool resumeSnapshot(const Options& options, sf::Vector2u screen, const RainConfig& rain, const Scene& scene,
+    const std::vector<Walker>& walkers, std::size_t count, RainSystem& rainSystem, std::vector<Person>& people) {
+    if (options.snapshotPath.empty()) {
+        return false;
+    }
+    SnapshotView snapshot;
+    if (!snapshot.open(options.snapshotPath)) {
+        return false;
+    }
+    bool matches = snapshot.matches(screen, rain, scene) && snapshot.header().personCount == count;
+    for (std::size_t i = 0; matches && i < count; ++i) {
+        matches = snapshot.people()[i].width == walkers[i].personWidth && snapshot.people()[i].height == walkers[i].personHeight;
+    }
+    if (!matches) {
+        std::cerr << "Snapshot " << options.snapshotPath << " is of other rain or another crowd, warming up instead" << std::endl;
+        return false;
+    }
+    snapshot.restore(rainSystem, people);
+    return true;
+}
+
+// Confines rainSystem's spawning to the columns rain can reach the crowd from, and returns how
+// long the slowest drop takes to fall from the top of that band to the bottom of the screen.
+//
+// Only drops in someone's corridor can reach them, so only those are simulated: spawning is
+// confined to the corridors' columns, at the per-pixel rate the whole screen would get, and
+// starts just above the tallest head or anything sheltering one. Drops fall at terminal speed
+// from the moment they spawn, so the rain reaching each person is the same as with the full
+// screen, for a fraction of the drops
+float confineToCrowd(sf::Vector2u screen, const RainConfig& rain, const std::vector<Walker>& walkers, std::size_t count, RainSystem& rainSystem) {
+    const CrowdBand band = crowdBand(screen, rain, walkers, count);
+    const float left = band.left;
+    const float right = band.right;
+
+    // Columns a collider shelters above everyone's heads get no rain down to them, so in calm
+    // air they aren't spawned in, and don't hold the spawn top up either
+    rainSystem.setSpawnBand(left, right);
+    rainSystem.setSpawnReach(band.top);
+    const float spawnTop = std::min(band.top, rainSystem.spawnTopAbove(left, right));
+
+    // In wind, rain reaches the corridor from upwind. The band widens by the furthest the
+    // fastest wind can carry the slowest drop on its way down, in both directions since gusts
+    // and turbulence can reverse it
+    const float fallTime = (screen.y - spawnTop + 50.0f) / terminalSpeed(rain.minSize);
+    const float drift = rain.wind.maxSpeed() * fallTime;
+    rainSystem.setSpawnBand(left - drift, right + drift);
+    rainSystem.setSpawnTop(spawnTop);
+    return fallTime;
+}
+
+// Lets the rain fill the corridor before the clock starts, with people standing where they
+// are: long enough for the slowest drops to fall from the top of the spawn band to the bottom
+// of the screen. --prewarm places the rain it would have left instead of simulating it
+void warmUp(const Options& options, RainSystem& rainSystem, const std::vector<Person>& people, float fallTime) {
+    const float timestep = 1.0f / options.simHz;
+    std::vector<sf::FloatRect> bounds(people.size());
+    std::vector<float> caught(people.size());
+    for (std::size_t i = 0; i < people.size(); ++i) {
+        bounds[i] = people[i].getBounds();
+    }
+    if (options.prewarm) {
+        rainSystem.prewarm(bounds.data(), people.size());
+        return;
+    }
+    const DropLifetimes before = rainSystem.getLifetimes();
+    for (float t = 0.0f; t < fallTime; t += timestep) {
+        rainSystem.update(timestep, bounds.data(), people.size(), caught.data());
+    }
+    addSimulatedWork(rainSystem.getLifetimes().stepCount - before.stepCount, rainSystem.getLifetimes().liveSteps - before.liveSteps);
+}
+
+// Walks the crowd across from where people stand at the start, once the rain is warm. Everyone
+// waits at the start until their start time and only counts the rain of the steps they spend
+// crossing, the one they arrive in included
+void crossStepped(const Options& options, const std::vector<Walker>& walkers, RainSystem& rainSystem, std::vector<Person>& people,
+    Telemetry* telemetry, HitLog* hitLog) {
+    const sf::Vector2u screen(options.width, options.height);
+    const float timestep = 1.0f / options.simHz;
+    const std::size_t count = people.size();
+    std::vector<sf::FloatRect> bounds(count);
+    std::vector<float> caught(count);
+    std::vector<bool> started(count, false);
+    std::vector<bool> crossing(count, false);
+    std::vector<SurfaceWetness> split(count);
+    std::size_t finished = 0;
+    const std::uint32_t firstTrack = telemetry ? telemetry->addTracks(count) : 0;
+    const std::uint32_t firstLogged = hitLog ? hitLog->addTracks(count) : 0;
+    if (hitLog) {
+        rainSystem.recordHits(HIT_LOG_CHUNK_HITS);
+    }
+    const DropLifetimes before = rainSystem.getLifetimes();
+    std::uint64_t steps = 0;
+    for (float t = 0.0f; finished < count; t += timestep) {
+        const std::uint64_t stepStarted = cycleCount();
+        for (std::size_t i = 0; i < count; ++i) {
+            if (!started[i] && t >= walkers[i].startTime) {
+                started[i] = true;
+                if (walkers[i].trajectory != nullptr) {
+                    people[i].startTrajectory(*walkers[i].trajectory);
+                }
+                else {
+                    people[i].startMove(endPoint(screen), walkers[i].speed);
+                }
+            }
+            crossing[i] = people[i].isMovingToTarget();
+            people[i].update(timestep);
+            bounds[i] = people[i].getBounds();
+            caught[i] = 0.0f;
+            split[i] = SurfaceWetness();
+        }
+        rainSystem.update(timestep, bounds.data(), count, caught.data(), split.data());
+        ++steps;
+        if (hitLog) {
+            hitLog->record(steps, firstLogged, rainSystem.getHits());
+        }
+
+        finished = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            if (crossing[i]) {
+                people[i].addWetness(caught[i]);
+                people[i].addSurfaceWetness(split[i]);
+            }
+            if (started[i] && !people[i].isMovingToTarget()) {
+                ++finished;
+            }
+        }
+
+        if (telemetry) {
+            const float stepSeconds = cycleSeconds(cycleCount() - stepStarted);
+            const CollisionCounters& counted = rainSystem.getCounters();
+            for (std::size_t i = 0; i < count; ++i) {
+                const sf::Vector2f position = people[i].getPosition();
+                const TelemetrySample sample = { t + timestep, position.x, position.y, crossing[i] ? caught[i] / timestep : 0.0f,
+                    people[i].getWetness(), stepSeconds, static_cast<std::uint32_t>(rainSystem.getDrops().count()),
+                    firstTrack + static_cast<std::uint32_t>(i), counted.tested, counted.candidates, counted.pairs,
+                    counted.contacts, counted.hits, counted.culledByScene, counted.culledOffscreen, 0 };
+                telemetry->record(sample);
+            }
+        }
+    }
+    addSimulatedWork(rainSystem.getLifetimes().stepCount - before.stepCount, rainSystem.getLifetimes().liveSteps - before.liveSteps);
+}
+
+std::vector<Person> crowdAtStart(sf::Vector2u screen, const std::vector<Walker>& walkers, std::size_t count) {
+    std::vector<Person> people;
+    for (std::size_t i = 0; i < count; ++i) {
+        people.push_back(Person(startPoint(screen), sf::Vector2f(walkers[i].personWidth, walkers[i].personHeight)));
+    }
+    return people;
+}
+
+// simulateCrowd on the stepped rain. Given laneSeeds, walker i crosses its own rain, drawn
+// from laneSeeds[i], instead of everyone sharing rain's
+std::vector<float> simulateCrowdStepped(const Options& options, const RainConfig& rain, const Scene& scene, const std::vector<Walker>& walkers,
+    IntegrateKernel integrate, JobSystem& jobs, Telemetry* telemetry, std::vector<SurfaceWetness>* surfaces, HitLog* hitLog,
+    const std::vector<std::uint64_t>& laneSeeds) {
+    const sf::Vector2u screen(options.width, options.height);
+    const std::size_t count = std::min(walkers.size(), MAX_PEOPLE);
+    RainSystem rainSystem(screen, rain, scene, integrate, jobs);
+    if (!laneSeeds.empty()) {
+        rainSystem.setLanes(laneSeeds.data(), count);
+    }
+    std::vector<Person> people = crowdAtStart(screen, walkers, count);
+    const float fallTime = confineToCrowd(screen, rain, walkers, count, rainSystem);
+
+    // A snapshot saved once warm by a crowd of the same sizes in the same rain stands in for
+    // the warm-up. Snapshots hold one rain, so lanes always warm up
+    if (!laneSeeds.empty() || !resumeSnapshot(options, screen, rain, scene, walkers, count, rainSystem, people)) {
+        warmUp(options, rainSystem, people, fallTime);
+        if (!options.saveSnapshotPath.empty() && laneSeeds.empty()) {
+            writeSnapshot(options.saveSnapshotPath, screen, rain, rainSystem, people, scene);
+        }
+    }
+    crossStepped(options, walkers, rainSystem, people, telemetry, hitLog);
+
+    if (options.dropLifetimes) {
+        // Crossings can run side by side, so each report goes out in one piece
+        std::ostringstream report;
+        report << "Seed " << rain.seed << ", warm-up included. ";
+        rainSystem.getLifetimes().print(report);
+        std::cout << report.str() << std::flush;
+    }
+    if (rainSystem.lostHitCount() > 0) {
+        std::cerr << rainSystem.lostHitCount() << " hits didn't fit in the hit log's rows and weren't logged" << std::endl;
+    }
+    if (!laneSeeds.empty() && rainSystem.getDrops().rejectedCount() > 0) {
+        std::cerr << count << " lanes of rain overflowed the drop pool, raise --max-drops" << std::endl;
+    }
+
+    std::vector<float> wetness(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        wetness[i] = people[i].getWetness();
+    }
+    if (surfaces) {
+        surfaces->resize(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            (*surfaces)[i] = people[i].getSurfaceWetness();
+        }
+    }
+    return wetness;
+}
+
+// simulateCrowd on whichever engine the options and the walkers allow, without clothes
+std::vector<float> simulateCrowdOn(const Options& options, const RainConfig& rain, const Scene& scene, const std::vector<Walker>& walkers,
+    IntegrateKernel integrate, JobSystem& jobs, Telemetry* telemetry, std::vector<SurfaceWetness>* surfaces, HitLog* hitLog) {
+    // EventRain solves for straight walks, so anyone on a route needs the drops stepped
+    bool straight = true;
+    for (const Walker& walker : walkers) {
+        straight = straight && walker.trajectory == nullptr;
+    }
+    if (options.densityField && straight && !hitLog) {
+        return simulateCrowdDensity(options, rain, scene, walkers, telemetry, surfaces);
+    }
+    if (options.procedural && rain.wind.isCalm() && straight && !hitLog) {
+        return simulateCrowdProcedural(options, rain, scene, walkers, telemetry, surfaces);
+    }
+    if (options.eventDriven && rain.wind.isCalm() && straight && !hitLog) {
+        return simulateCrowdEvents(options, rain, scene, walkers, telemetry, surfaces);
+    }
+    return simulateCrowdStepped(options, rain, scene, walkers, integrate, jobs, telemetry, surfaces, hitLog, std::vector<std::uint64_t>());
+}
+
+// With --clothing, swaps what each walker caught for what their clothes held of it. The
+// clothes soak a whole crossing at once, which comes to what soaking it step by step would
+void wearClothing(const Options& options, const std::vector<Walker>& walkers, std::vector<float>& wetness, std::vector<SurfaceWetness>& split) {
+    if (options.clothingCapacity <= 0.0f) {
+        return;
+    }
+    Clothing clothing(options.clothingCapacity);
+    for (std::size_t i = 0; i < wetness.size(); ++i) {
+        clothing.addPerson(walkers[i].personWidth, walkers[i].personHeight);
+    }
+    clothing.soak(split.data());
+    for (std::size_t i = 0; i < wetness.size(); ++i) {
+        split[i] = clothing.held(i);
+        wetness[i] = split[i].total();
+    }
+}
+
+} // namespace
+
+Options withoutSnapshotSave(const Options& options) {
+    Options unsaved = options;
+    unsaved.saveSnapshotPath.clear();
+    return unsaved;
+}
+
+Crossing defaultCrossing(const Options& options, float speed) {
+    Crossing crossing;
+    crossing.rain = options.rain;
+    crossing.personWidth = options.scenario.personWidth;
+    crossing.personHeight = options.scenario.personHeight;
+    crossing.speed = speed;
+    return crossing;
+}
+
+std::vector<float> simulateCrowd(const Options& options, const RainConfig& rain, const Scene& scene, const std::vector<Walker>& walkers,
+    IntegrateKernel integrate, JobSystem& jobs, Telemetry* telemetry, std::vector<SurfaceWetness>* surfaces, HitLog* hitLog) {
+    std::vector<SurfaceWetness> split;
+    std::vector<float> wetness = simulateCrowdOn(options, rain, scene, walkers, integrate, jobs, telemetry,
+        surfaces || options.clothingCapacity > 0.0f ? &split : nullptr, hitLog);
+    wearClothing(options, walkers, wetness, split);
+    if (surfaces) {
+        *surfaces = split;
+    }
+    return wetness;
+}
+
+float simulateCrossing(const Options& options, const Crossing& crossing, const Scene& scene, IntegrateKernel integrate, JobSystem& jobs,
+    Telemetry* telemetry, SurfaceWetness* surfaces, HitLog* hitLog) {
+    Walker walker;
+    walker.personWidth = crossing.personWidth;
+    walker.personHeight = crossing.personHeight;
+    walker.speed = crossing.speed;
+    walker.startTime = 0.0f;
+    std::vector<SurfaceWetness> split;
+    const float wetness = simulateCrowd(options, crossing.rain, scene, std::vector<Walker>(1, walker), integrate, jobs, telemetry, &split, hitLog).front();
+    if (surfaces) {
+        *surfaces = split.front();
+    }
+    return wetness;
+}
+
+std::vector<float> simulateTrials(const Options& options, const Crossing& crossing, const std::vector<std::uint64_t>& seeds, const Scene& scene,
+    IntegrateKernel integrate, JobSystem& jobs, std::vector<SurfaceWetness>* surfaces) {
+    std::vector<float> wetness(seeds.size());
+    std::vector<SurfaceWetness> split(seeds.size());
+    const bool lanes = crossing.rain.wind.isCalm() && !crossing.rain.shelterDrips && !options.procedural && !options.eventDriven;
+    const Options unsaved = withoutSnapshotSave(options); // Lanes never save, and one at a time only the first does
+    for (std::size_t first = 0; first < seeds.size();) {
+        const std::size_t count = lanes ? std::min(seeds.size() - first, MAX_PEOPLE) : 1;
+        Crossing one = crossing;
+        one.rain.seed = seeds[first];
+        if (count == 1) {
+            wetness[first] = simulateCrossing(first == 0 ? options : unsaved, one, scene, integrate, jobs, nullptr, &split[first]);
+        }
+        else {
+            Walker walker;
+            walker.personWidth = crossing.personWidth;
+            walker.personHeight = crossing.personHeight;
+            walker.speed = crossing.speed;
+            walker.startTime = 0.0f;
+            const std::vector<std::uint64_t> laneSeeds(seeds.begin() + first, seeds.begin() + first + count);
+            const std::vector<Walker> laneWalkers(count, walker);
+            std::vector<SurfaceWetness> laneSplit;
+            std::vector<float> laneWetness = simulateCrowdStepped(options, one.rain, scene, laneWalkers, integrate, jobs, nullptr, &laneSplit,
+                nullptr, laneSeeds);
+            wearClothing(options, laneWalkers, laneWetness, laneSplit);
+            std::copy(laneWetness.begin(), laneWetness.end(), wetness.begin() + first);
+            std::copy(laneSplit.begin(), laneSplit.end(), split.begin() + first);
+        }
+        first += count;
+    }
+    if (surfaces) {
+        *surfaces = split;
+    }
+    return wetness;
+}
+
+TrialRunner::TrialRunner(const Options& options, const Scene& scene, IntegrateKernel integrate, JobSystem& jobs)
+    : options(options), rainSystem(new RainSystem(sf::Vector2u(options.width, options.height), options.rain, scene, integrate, jobs)),
+      warm(false), last() {}
+
+TrialRunner::~TrialRunner() {}
+
+float TrialRunner::run(const Crossing& crossing, bool carryOn, SurfaceWetness* surfaces) {
+    const sf::Vector2u screen(options.width, options.height);
+    Walker walker;
+    walker.personWidth = crossing.personWidth;
+    walker.personHeight = crossing.personHeight;
+    walker.speed = crossing.speed;
+    walker.startTime = 0.0f;
+    const std::vector<Walker> walkers(1, walker);
+    std::vector<Person> people = crowdAtStart(screen, walkers, 1);
+    const bool sameRain = warm && crossing.rain.spawnRate == last.rain.spawnRate && crossing.personWidth == last.personWidth
+        && crossing.personHeight == last.personHeight;
+    if (!carryOn || !sameRain) {
+        rainSystem->reset(crossing.rain.seed);
+        rainSystem->setSpawnRate(crossing.rain.spawnRate);
+        const float fallTime = confineToCrowd(screen, crossing.rain, walkers, 1, *rainSystem);
+        warmUp(options, *rainSystem, people, fallTime);
+    }
+    crossStepped(options, walkers, *rainSystem, people, nullptr, nullptr);
+    warm = true;
+    last = crossing;
+    std::vector<float> wetness(1, people.front().getWetness());
+    std::vector<SurfaceWetness> split(1, people.front().getSurfaceWetness());
+    wearClothing(options, walkers, wetness, split);
+    if (surfaces) {
+        *surfaces = split.front();
+    }
+    return wetness.front();
+}
+
+WetnessEstimate estimateCrossing(const Options& options, const Crossing& crossing) {
+    const sf::Vector2u screen(options.width, options.height);
+    const sf::Vector2f start = startPoint(screen);
+    const sf::Vector2f end = endPoint(screen);
+
+    AnalyticParams params;
+    params.spawnRate = crossing.rain.spawnRate;
+    params.minSize = crossing.rain.minSize;
+    params.maxSize = crossing.rain.maxSize;
+    params.sizeModel = crossing.rain.sizeModel;
+    params.rainIntensity = crossing.rain.rainIntensity;
+    params.personTop = start.y - crossing.personHeight / 2.0f;
+    params.personWidth = crossing.personWidth;
+    params.personHeight = crossing.personHeight;
+    params.speed = crossing.speed;
+    params.distance = std::abs(end.x - start.x);
+    return estimateWetness(params);
+}
+
+int runHeadless(const Options& options, IntegrateKernel integrate, JobSystem& jobs, std::vector<float>* wetness) {
+    Crossing walkCrossing = defaultCrossing(options, options.scenario.walkSpeed);
+    Crossing runCrossing = defaultCrossing(options, options.scenario.runSpeed);
+
+    const WetnessEstimate walkEstimate = estimateCrossing(options, walkCrossing);
+    const WetnessEstimate runEstimate = estimateCrossing(options, runCrossing);
+    std::cout << "Analytic walk wetness: " << walkEstimate.total() << " (top " << walkEstimate.top << ", front " << walkEstimate.front << ")" << std::endl;
+    std::cout << "Analytic run wetness: " << runEstimate.total() << " (top " << runEstimate.top << ", front " << runEstimate.front << ")" << std::endl;
+    const Scene scene = loadScene(options.scenePath, sf::Vector2u(options.width, options.height));
+    if (options.rain.wind.isCalm()) {
+        const WetnessEstimate walkExact = integrateCrossing(options, walkCrossing, scene);
+        const WetnessEstimate runExact = integrateCrossing(options, runCrossing, scene);
+        std::cout << "Exact walk wetness: " << walkExact.total() << " (top " << walkExact.top << ", front " << walkExact.front << ")" << std::endl;
+        std::cout << "Exact run wetness: " << runExact.total() << " (top " << runExact.top << ", front " << runExact.front << ")" << std::endl;
+    }
+    if (options.analyticOnly) {
+        return 0;
+    }
+
+    // Walk and run each get their own rain, drawn from consecutive seeds, unless with
+    // --common-rain they're to cross the same drops
+    runCrossing.rain.seed = options.commonRain ? options.rain.seed : options.rain.seed + 1;
+    std::unique_ptr<Telemetry> telemetry;
+    if (!options.telemetryPath.empty()) {
+        telemetry.reset(new Telemetry(options.telemetrySamples));
+    }
+    std::unique_ptr<HitLog> hitLog;
+    if (!options.hitLogPath.empty()) {
+        hitLog.reset(new HitLog(options.hitLogPath, 1.0f / options.simHz));
+    }
+    HitLog* logging = hitLog && hitLog->isOpen() ? hitLog.get() : nullptr;
+    SurfaceWetness walkSplit;
+    SurfaceWetness runSplit;
+    // The walk is the one --save-snapshot saves
+    const Options unsaved = withoutSnapshotSave(options);
+    const float walk = simulateCrossing(options, walkCrossing, scene, integrate, jobs, telemetry.get(), &walkSplit, logging);
+    const float run = simulateCrossing(unsaved, runCrossing, scene, integrate, jobs, telemetry.get(), &runSplit, logging);
+    hitLog.reset(); // Walk's hits are person 0 and run's person 1
+    if (wetness) {
+        wetness->assign({ walk, run });
+    }
+    if (telemetry && telemetry->write(options.telemetryPath)) {
+        std::cout << "Wrote " << telemetry->size() << " telemetry samples to " << options.telemetryPath << std::endl;
+    }
+
+    std::cout << "Seed: " << options.rain.seed << std::endl;
+    std::cout << "Walk wetness: " << walk << " (top " << walkSplit.top << ", front " << walkSplit.front << ", back " << walkSplit.back << ")" << std::endl;
+    std::cout << "Run wetness: " << run << " (top " << runSplit.top << ", front " << runSplit.front << ", back " << runSplit.back << ")" << std::endl;
+    std::cout << (walk < run ? "Walking" : "Running") << " keeps you drier" << std::endl;
+
+    if (!options.route.empty()) {
+        const sf::Vector2u screen(options.width, options.height);
+        Trajectory route(startPoint(screen));
+        if (!parseTrajectory(options.route, startPoint(screen), endPoint(screen), route)) {
+            return 1;
+        }
+        Walker walker;
+        walker.personWidth = options.scenario.personWidth;
+        walker.personHeight = options.scenario.personHeight;
+        walker.speed = options.scenario.walkSpeed;
+        walker.startTime = 0.0f;
+        walker.trajectory = &route;
+        std::vector<SurfaceWetness> routeSplit;
+        const float routeWetness = simulateCrowd(unsaved, walkCrossing.rain, scene, std::vector<Walker>(1, walker), integrate, jobs, nullptr, &routeSplit).front();
+        std::cout << "Route wetness: " << routeWetness << " over " << route.duration() << " s (top " << routeSplit.front().top
+            << ", front " << routeSplit.front().front << ", back " << routeSplit.front().back << ")" << std::endl;
+        if (wetness) {
+            wetness->push_back(routeWetness);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Analytic.h"
+#include "HitLog.h"
+#include "JobSystem.h"
+#include "Options.h"
+#include "RainConfig.h"
+#include "RainKernels.h"
+#include "Scene.h"
+#include "SurfaceWetness.h"
+#include "Telemetry.h"
+#include "Trajectory.h"
+
+// One walk from the start platform to the end platform, with everything a study may vary
+struct Crossing {
+    RainConfig rain;
+    float personWidth;
+    float personHeight;
+    float speed;
+};
+
+// One person in a crowd. The rain is shared, so it isn't part of them
+struct Walker {
+    float personWidth;
+    float personHeight;
+    float speed;
+    float startTime; // Seconds after the rain settles that they set off
+    const Trajectory* trajectory = nullptr; // Route to follow instead of walking straight to the end at speed
+};
+
+// Simulates everyone in walkers crossing from the start platform to the end platform through
+// the same rain, up to MAX_PEOPLE of them, and returns the wetness each picked up between
+// setting off and arriving, or with --clothing what their clothes held of it. Costs about as much as a single crossing. With --event-driven and
+// no wind it runs on EventRain instead, and integrate and jobs go unused. Given telemetry, each
+// step from the start of the clock is sampled, one track per walker. Given surfaces, it's
+// resized to the crowd and gets each walker's wetness split by the surface that caught it.
+// Given hitLog, every catch from the start of the clock is logged, one person per walker; that
+// needs the drops themselves, so it always runs on the stepped rain. With --save-snapshot, a
+// crowd on the stepped rain saves itself once warm, so a caller running several gives all but
+// one of them withoutSnapshotSave's options
+std::vector<float> simulateCrowd(const Options& options, const RainConfig& rain, const Scene& scene, const std::vector<Walker>& walkers,
+    IntegrateKernel integrate, JobSystem& jobs, Telemetry* telemetry = nullptr, std::vector<SurfaceWetness>* surfaces = nullptr,
+    HitLog* hitLog = nullptr);
+
+// options with no --save-snapshot
+Options withoutSnapshotSave(const Options& options);
+
+// The walk or run at speed that --headless compares, in the configured rain
+Crossing defaultCrossing(const Options& options, float speed);
+
+// Simulates a crossing through the scene on the fixed --sim-hz step over an options.width x
+// options.height screen and returns the wetness picked up on the way, split by surface into
+// surfaces if given
+float simulateCrossing(const Options& options, const Crossing& crossing, const Scene& scene, IntegrateKernel integrate, JobSystem& jobs,
+    Telemetry* telemetry = nullptr, SurfaceWetness* surfaces = nullptr, HitLog* hitLog = nullptr);
+
+// Simulates the crossing once in each of several independent rains, drawn from seeds in
+// place of crossing.rain.seed, and returns the wetness of each, split by surface into surfaces
+// if given. Up to MAX_PEOPLE rains run at once as lanes of one RainSystem, see setLanes, so
+// a small corridor's per-step costs are paid once for them all and its kernels work on every
+// rain's drops together. Each comes out as simulateCrossing would give it, to rounding. Windy
+// rain, shelter drips and the event-driven and procedural engines run a crossing at a time
+std::vector<float> simulateTrials(const Options& options, const Crossing& crossing, const std::vector<std::uint64_t>& seeds, const Scene& scene,
+    IntegrateKernel integrate, JobSystem& jobs, std::vector<SurfaceWetness>* surfaces = nullptr);
+
+class RainSystem;
+
+// Runs crossings one after another in one RainSystem, reset in place between them, so past
+// the first a trial allocates nothing and costs only its own steps. The drop sizes, pool, wind
+// and scene come from the options and the scene it's made with; each trial brings its own
+// seed, speed, spawn rate and person size. Always steps the rain, whatever engine the options
+// pick
+class TrialRunner {
+public:
+    TrialRunner(const Options& options, const Scene& scene, IntegrateKernel integrate, JobSystem& jobs);
+    ~TrialRunner();
+
+    TrialRunner(const TrialRunner&) = delete;
+    TrialRunner& operator=(const TrialRunner&) = delete;
+
+    // Simulates crossing as simulateCrossing would, in fresh rain drawn from crossing.rain.seed
+    // and warmed up first. With carryOn, and the same spawn rate and person size as the last
+    // trial, it instead starts straight away in the rain the last trial left, which is warm
+    float run(const Crossing& crossing, bool carryOn, SurfaceWetness* surfaces = nullptr);
+
+private:
+    const Options& options;
+    std::unique_ptr<RainSystem> rainSystem;
+    bool warm;     // Whether a trial has run, and last is it
+    Crossing last;
+};
+
+// Flux-model estimate for the same crossing
+WetnessEstimate estimateCrossing(const Options& options, const Crossing& crossing);
+
+// Runs one walk and one run through the rain with no window, GL context or font, as fast as
+// the machine allows, and prints the wetness of each. With --telemetry, the walk is track 0
+// and the run track 1. Given wetness, it gets the walk's and the run's, then the --route's if
+// there is one. Returns the process exit code
+int runHeadless(const Options& options, IntegrateKernel integrate, JobSystem& jobs, std::vector<float>* wetness = nullptr);
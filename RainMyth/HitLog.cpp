@@ -0,0 +1,149 @@
+#include "HitLog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include "Instrument.h"
+#include "IoService.h"
+#include "RainSystem.h"
+
+namespace {
+
+// The file is "RMHL", a version, the step length in seconds and the size step as floats, then
+// the catches to the end of the file. Each catch is four LEB128 varints, low seven bits first:
+//
+//   the step minus the catch before's, zigzagged, since a second crossing starts the steps again
+//   the drop's slot minus the catch before's, zigzagged
+//   the person shifted left two bits, with the BodySurface below
+//   the drop's size in size steps, rounded
+//
+// The first catch is encoded against step 0 and slot 0. Floats are in the machine's own byte
+// order like the telemetry's
+const char HIT_LOG_MAGIC[4] = { 'R', 'M', 'H', 'L' };
+const std::uint32_t HIT_LOG_VERSION = 1;
+const std::size_t MAX_VARINT_BYTES = 10;
+const std::size_t MAX_HIT_BYTES = 4 * MAX_VARINT_BYTES;
+
+std::uint64_t zigzag(std::int64_t value) {
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+} // namespace
+
+HitLog::HitLog(const std::string& path, float timestep)
+    : path(path), out(path, std::ios::binary), current(0), used(0), hits(0), bytes(0), stalls(0), tracks(0), lastStep(0), lastDrop(0),
+      failed(false) {
+    if (!out) {
+        std::cerr << "Couldn't open " << path << " for writing, not logging hits" << std::endl;
+        out.close();
+        return;
+    }
+    for (std::uint32_t buffer = 0; buffer < HIT_LOG_BUFFERS; ++buffer) {
+        buffers[buffer].resize(HIT_LOG_BUFFER_BYTES);
+        if (buffer > 0) {
+            freeBuffers.push(buffer);
+        }
+    }
+    std::uint8_t* header = buffers[current].data();
+    std::copy(HIT_LOG_MAGIC, HIT_LOG_MAGIC + sizeof(HIT_LOG_MAGIC), reinterpret_cast<char*>(header));
+    std::memcpy(header + 4, &HIT_LOG_VERSION, sizeof(HIT_LOG_VERSION));
+    std::memcpy(header + 8, &timestep, sizeof(timestep));
+    std::memcpy(header + 12, &HIT_LOG_SIZE_STEP, sizeof(HIT_LOG_SIZE_STEP));
+    used = 16;
+    bytes = used;
+}
+
+HitLog::~HitLog() {
+    if (!isOpen()) {
+        return;
+    }
+    send();
+    ioService().drain();
+    out.close();
+    if (failed || !out) {
+        std::cerr << "Couldn't write " << path << std::endl;
+        return;
+    }
+    std::cout << "Logged " << hits << " hits to " << path << " in " << bytes << " bytes";
+    if (hits > 0) {
+        std::cout << ", " << static_cast<double>(bytes) / hits << " a hit";
+    }
+    if (stalls > 0) {
+        std::cout << ", waiting on the disk " << stalls << " times";
+    }
+    std::cout << std::endl;
+}
+
+std::uint32_t HitLog::addTracks(std::size_t count) {
+    const std::uint32_t first = tracks;
+    tracks += static_cast<std::uint32_t>(count);
+    return first;
+}
+
+void HitLog::record(std::uint64_t step, std::uint32_t firstTrack, const std::vector<RainHit>& stepHits) {
+    if (!isOpen()) {
+        return;
+    }
+    for (const RainHit& hit : stepHits) {
+        if (HIT_LOG_BUFFER_BYTES - used < MAX_HIT_BYTES) {
+            send();
+        }
+        const std::size_t before = used;
+        putVarint(zigzag(static_cast<std::int64_t>(step - lastStep)));
+        putVarint(zigzag(static_cast<std::int64_t>(hit.drop) - static_cast<std::int64_t>(lastDrop)));
+        putVarint(static_cast<std::uint64_t>(firstTrack + hit.person) << 2 | static_cast<std::uint64_t>(hit.surface));
+        putVarint(static_cast<std::uint64_t>(std::lround(hit.size / HIT_LOG_SIZE_STEP)));
+        lastStep = step;
+        lastDrop = hit.drop;
+        bytes += used - before;
+        ++hits;
+    }
+}
+
+MemoryUsage HitLog::memoryUsage() const {
+    MemoryUsage usage = MemoryUsage();
+    for (const std::vector<std::uint8_t>& buffer : buffers) {
+        usage += vectorUsage(buffer);
+    }
+    return usage;
+}
+
+void HitLog::putVarint(std::uint64_t value) {
+    std::uint8_t* at = buffers[current].data() + used;
+    while (value >= 0x80) {
+        *at++ = static_cast<std::uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    *at++ = static_cast<std::uint8_t>(value);
+    used = at - buffers[current].data();
+}
+
+// Hands the current buffer to the I/O thread and takes a free one, waiting for a write to
+// finish if there's none
+void HitLog::send() {
+    if (used == 0) {
+        return;
+    }
+    const std::uint32_t sent = current;
+    ioService().write(out, buffers[sent].data(), used, [this, sent](bool written) {
+        if (!written) {
+            failed = true;
+        }
+        freeBuffers.push(sent); // Only the I/O thread pushes
+    });
+    used = 0;
+    const std::uint32_t* free = freeBuffers.peek();
+    if (free == nullptr) {
+        ++stalls;
+        RAINMYTH_ZONE("Wait for hit log");
+        while ((free = freeBuffers.peek()) == nullptr) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    current = *free;
+    freeBuffers.pop();
+}
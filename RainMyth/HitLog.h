@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Constants.h"
+#include "MemoryUsage.h"
+#include "SpscQueue.h"
+
+struct RainHit;
+
+// Every catch of a run, written to disk as it happens for analysis afterwards. Each one is the
+// step it happened in, the drop, its size, the surface it hit and the person, packed as a few
+// varints of the differences from the catch before, so most take five or six bytes. They're
+// encoded into one of a fixed pool of HIT_LOG_BUFFERS buffers; a full buffer goes to the I/O
+// thread, see IoService.h, and is written out in one go, so the simulation never waits on the
+// disk unless the writes are a whole pool behind, and then it waits rather than lose any.
+// The layout is described in HitLog.cpp.
+//
+// One thread records, the simulation's; nothing is allocated once the log is open
+class HitLog {
+public:
+    // Opens path for writing, steps timestep seconds long. Problems are reported on stderr and
+    // leave the log closed, recording nothing
+    HitLog(const std::string& path, float timestep);
+
+    // Writes what's left and waits for it to be written
+    ~HitLog();
+
+    HitLog(const HitLog&) = delete;
+    HitLog& operator=(const HitLog&) = delete;
+
+    bool isOpen() const {
+        return out.is_open();
+    }
+
+    // Reserves count consecutive person numbers for the people of one simulation and returns
+    // the first, like Telemetry::addTracks
+    std::uint32_t addTracks(std::size_t count);
+
+    // Logs the catches of step, with person p of the hits logged as firstTrack + p
+    void record(std::uint64_t step, std::uint32_t firstTrack, const std::vector<RainHit>& hits);
+
+    std::uint64_t hitCount() const {
+        return hits;
+    }
+
+    // The buffer pool, which the I/O thread may be writing from
+    MemoryUsage memoryUsage() const;
+
+private:
+    std::string path;
+    std::ofstream out;
+    std::vector<std::uint8_t> buffers[HIT_LOG_BUFFERS];
+    SpscQueue<std::uint32_t, HIT_LOG_BUFFERS * 2> freeBuffers; // Back from the I/O thread
+    std::uint32_t current;  // Buffer being encoded into
+    std::size_t used;       // Bytes of it filled
+    std::uint64_t hits;
+    std::uint64_t bytes;    // Encoded so far, header included
+    std::uint64_t stalls;   // Times the simulation waited on the disk
+    std::uint32_t tracks;
+    std::uint64_t lastStep; // The catch before's fields, which the next is encoded against
+    std::uint32_t lastDrop;
+
+    std::atomic<bool> failed;
+
+    void putVarint(std::uint64_t value);
+    void send();
+};
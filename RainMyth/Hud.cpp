@@ -0,0 +1,51 @@
+#include "Hud.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+Hud::Hud(sf::Text& text, float interval)
+    : target(text), interval(interval), sinceUpdate(interval), length(0), shownLength(0) {
+    buffer[0] = '\0';
+    shown[0] = '\0';
+}
+
+bool Hud::begin(float frameSeconds) {
+    sinceUpdate += frameSeconds;
+    if (sinceUpdate < interval) {
+        return false;
+    }
+    sinceUpdate = 0.0f;
+    length = 0;
+    return true;
+}
+
+void Hud::text(const char* text) {
+    const std::size_t count = std::min(std::strlen(text), CAPACITY - 1 - length);
+    std::memcpy(buffer + length, text, count);
+    length += count;
+}
+
+void Hud::number(float value, int precision) {
+    const std::to_chars_result result = std::to_chars(buffer + length, buffer + CAPACITY - 1, value, std::chars_format::fixed, precision);
+    if (result.ec == std::errc()) {
+        length = static_cast<std::size_t>(result.ptr - buffer);
+    }
+}
+
+void Hud::number(std::size_t value) {
+    const std::to_chars_result result = std::to_chars(buffer + length, buffer + CAPACITY - 1, value);
+    if (result.ec == std::errc()) {
+        length = static_cast<std::size_t>(result.ptr - buffer);
+    }
+}
+
+void Hud::end() {
+    buffer[length] = '\0';
+    if (length == shownLength && std::memcmp(buffer, shown, length) == 0) {
+        return;
+    }
+    std::memcpy(shown, buffer, length + 1);
+    shownLength = length;
+    target.setString(shown);
+}
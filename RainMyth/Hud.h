@@ -0,0 +1,37 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+
+// Builds the overlay text without allocating. Each readout is formatted into a fixed buffer,
+// numbers with std::to_chars, and handed to the sf::Text only when it differs from what's on
+// screen, since setString reallocates and makes the text rebuild its glyph quads. Readouts are
+// also throttled to a few a second: begin() says whether one is due, so a frame that won't
+// show anything new doesn't even format it. Text past the buffer's end is cut off
+class Hud {
+public:
+    // interval is the least time in seconds between readouts
+    explicit Hud(sf::Text& text, float interval = 0.25f);
+
+    // Counts frameSeconds towards the next readout and returns true, ready for it, once it's due
+    bool begin(float frameSeconds);
+
+    // Appends to the readout begun
+    void text(const char* text);
+    void number(float value, int precision);
+    void number(std::size_t value);
+
+    // Shows the readout, if anything changed
+    void end();
+
+private:
+    static const std::size_t CAPACITY = 768;
+
+    sf::Text& target;
+    float interval;
+    float sinceUpdate;
+    char buffer[CAPACITY];
+    char shown[CAPACITY]; // What the text holds now
+    std::size_t length;
+    std::size_t shownLength;
+};
@@ -0,0 +1,32 @@
+#include "IdleTasks.h"
+
+#include <algorithm>
+#include <utility>
+
+void IdleTasks::add(Task task, unsigned maxWaitFrames) {
+    Entry entry = { std::move(task), maxWaitFrames, 0, Clock::duration::zero(), Clock::now() };
+    entries.push_back(std::move(entry));
+    order.push_back(order.size());
+}
+
+void IdleTasks::run(Clock::time_point deadline) {
+    // Ties keep the order they were added in. std::stable_sort would want a buffer every frame
+    std::sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) {
+        return entries[a].waited != entries[b].waited ? entries[a].waited > entries[b].waited : a < b;
+    });
+    for (std::size_t i : order) {
+        Entry& entry = entries[i];
+        const Clock::time_point started = Clock::now();
+        if (entry.waited < entry.maxWaitFrames && started + entry.cost > deadline) {
+            ++entry.waited;
+            continue;
+        }
+        const std::chrono::duration<float> since = started - entry.lastRun;
+        entry.task(since.count());
+        const Clock::time_point finished = Clock::now();
+        // A quarter of each new time, so one slow run doesn't keep a task out for long
+        entry.cost += (finished - started - entry.cost) / 4;
+        entry.lastRun = started;
+        entry.waited = 0;
+    }
+}
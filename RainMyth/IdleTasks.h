@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// Housekeeping the main thread can put off: the remote control, the scenario file, the
+// metrics datagram, the HUD readout. run() goes through them in the time a frame has left
+// before the next one is due, the ones that have waited longest first, and skips any whose
+// usual cost doesn't fit, so a heavy frame puts them off instead of growing by them. A task
+// put off maxWaitFrames frames in a row runs anyway, so a long heavy stretch slows
+// housekeeping down without starving it. Tasks are given the seconds since they last ran,
+// for throttles counted in time rather than frames
+class IdleTasks {
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::function<void(float)> Task;
+
+    void add(Task task, unsigned maxWaitFrames);
+
+    // Call once a frame
+    void run(Clock::time_point deadline);
+
+private:
+    struct Entry {
+        Task task;
+        unsigned maxWaitFrames;
+        unsigned waited;         // Frames in a row it's been put off
+        Clock::duration cost;    // Smoothed time a run takes
+        Clock::time_point lastRun;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<std::size_t> order; // run()'s working space, made as tasks are added
+};
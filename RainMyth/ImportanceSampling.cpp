@@ -0,0 +1,175 @@
+#include "ImportanceSampling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "Constants.h"
+#include "DropSizes.h"
+#include "EventRain.h"
+#include "Person.h"
+#include "RainField.h"
+#include "Rng.h"
+#include "TerminalVelocity.h"
+
+namespace {
+
+float toUnit(std::uint32_t word) {
+    return static_cast<float>(word >> 8) * (1.0f / 16777216.0f);
+}
+
+// What one batch of samples adds up, reduced in batch order so the sums don't depend on who ran what
+struct SampleSums {
+    double sum;
+    double squares;
+    double top;
+    double front;
+    std::size_t hits;
+};
+
+void printSampled(const char* name, const SampledWetness& sampled) {
+    std::cout << "Importance-sampled " << name << " wetness: " << sampled.wetness << " +/- " << sampled.halfWidth95
+        << " (top " << sampled.surfaces.top << ", front " << sampled.surfaces.front << "), " << sampled.hits << " of "
+        << sampled.samples << " samples caught" << std::endl;
+}
+
+} // namespace
+
+SampledWetness sampleCrossing(const Options& options, const Crossing& crossing, const Scene& scene, std::size_t samples, JobSystem& jobs) {
+    const sf::Vector2u screen(options.width, options.height);
+    const RainConfig& rain = crossing.rain;
+    const DropSizeTable sizes(rain);
+    const TerminalVelocityTable speeds(rain.minSize, rain.maxSize);
+    const std::vector<float> shadowTop = scene.rainShadow(screen);
+    const CounterRng rng(rain.seed);
+
+    PersonPath path;
+    path.width = crossing.personWidth;
+    path.height = crossing.personHeight;
+    path.left = startPoint(screen).x - path.width / 2.0f;
+    path.top = startPoint(screen).y - path.height / 2.0f;
+    path.endLeft = endPoint(screen).x - path.width / 2.0f;
+    path.speed = crossing.speed;
+    path.startTime = 0.0f;
+    const float start = path.startTime;
+    const float end = path.arrivalTime();
+    const float minLeft = std::min(path.left, path.endLeft);
+    const float maxLeft = std::max(path.left, path.endLeft);
+
+    // As confineToCrowd places it: just above their head or anything sheltering it
+    auto columnOf = [&shadowTop](float x) {
+        return static_cast<std::size_t>(std::min(std::max(x, 0.0f), static_cast<float>(shadowTop.size() - 1)));
+    };
+    float highest = static_cast<float>(screen.y);
+    for (std::size_t column = columnOf(minLeft - rain.maxSize); column <= columnOf(maxLeft + path.width); ++column) {
+        highest = std::min(highest, shadowTop[column]);
+    }
+    const float spawnTop = std::min(path.top, highest) - RainField::heightOf(rain.maxSize);
+
+    const std::size_t batches = (samples + IMPORTANCE_BATCH - 1) / IMPORTANCE_BATCH;
+    std::vector<SampleSums> batchSums(batches, SampleSums());
+    jobs.run(batches, [&](std::size_t batch, unsigned) {
+        SampleSums& sums = batchSums[batch];
+        const std::size_t last = std::min(samples, (batch + 1) * IMPORTANCE_BATCH);
+        for (std::size_t i = batch * IMPORTANCE_BATCH; i < last; ++i) {
+            std::uint32_t words[4];
+            rng.generate(static_cast<std::uint64_t>(i >> 32), static_cast<std::uint32_t>(i), words);
+            const float size = sizes.lookup(toUnit(words[0]));
+            const float vy = std::max(speeds.lookup(size), 1e-3f);
+            const float height = RainField::heightOf(size);
+            const float y = spawnTop - 50.0f + 50.0f * toUnit(words[1]);
+
+            // Columns whose drops the box covers at some point of the walk, and for the one
+            // drawn, the part of the walk it covers them
+            const float columnsWidth = maxLeft - minLeft + path.width + size;
+            const float x = minLeft - size + columnsWidth * toUnit(words[2]);
+            float enter = start;
+            float leave = end;
+            if (path.endLeft != path.left) {
+                const float velocity = (path.endLeft - path.left) / (end - start);
+                enter = start + (x - path.width - path.left) / velocity;
+                leave = start + (x + size - path.left) / velocity;
+                if (enter > leave) {
+                    std::swap(enter, leave);
+                }
+                enter = std::max(enter, start);
+                leave = std::min(leave, end);
+            }
+
+            // Spawned in this window, it is between their head and feet at some point of that
+            // part of the walk: no earlier and it has passed their feet, no later and it hasn't
+            // reached their head
+            const float reachDelay = std::max(path.top - height - y, 0.0f) / vy;
+            const float passDelay = (path.top + path.height - y) / vy;
+            const float timesLength = leave - enter + passDelay - reachDelay;
+            if (timesLength <= 0.0f) {
+                continue;
+            }
+            const float spawnTime = enter - passDelay + timesLength * toUnit(words[3]);
+
+            // As ProceduralRain::catches tests it
+            const float landing = spawnTime + std::max(shadowTop[columnOf(x)] - y, 0.0f) / vy;
+            const float reach = spawnTime + reachDelay;
+            const float pass = spawnTime + passDelay;
+            float caughtAt = 0.0f;
+            if (!path.firstOverlap(x, x + size, reach, std::min(pass, landing), caughtAt) || caughtAt < start || caughtAt > end) {
+                continue;
+            }
+            const double weighted = static_cast<double>(rain.spawnRate) * columnsWidth * timesLength * RainField::areaOf(size);
+            sums.sum += weighted;
+            sums.squares += weighted * weighted;
+            if (caughtAt > reach) {
+                sums.front += weighted;
+            }
+            else {
+                sums.top += weighted;
+            }
+            ++sums.hits;
+        }
+    });
+
+    SampleSums total = SampleSums();
+    for (const SampleSums& sums : batchSums) {
+        total.sum += sums.sum;
+        total.squares += sums.squares;
+        total.top += sums.top;
+        total.front += sums.front;
+        total.hits += sums.hits;
+    }
+    SampledWetness sampled = SampledWetness();
+    sampled.samples = samples;
+    sampled.hits = total.hits;
+    if (samples == 0) {
+        return sampled;
+    }
+    const double n = static_cast<double>(samples);
+    sampled.wetness = total.sum / n;
+    const double variance = samples > 1 ? std::max(total.squares - n * sampled.wetness * sampled.wetness, 0.0) / (n - 1.0) : 0.0;
+    sampled.halfWidth95 = 1.96 * std::sqrt(variance / n);
+    sampled.surfaces.top = static_cast<float>(total.top / n);
+    sampled.surfaces.front = static_cast<float>(total.front / n);
+    return sampled;
+}
+
+int runImportance(const Options& options, JobSystem& jobs) {
+    if (!options.rain.wind.isCalm()) {
+        std::cerr << "Importance sampling solves each drop's fall in closed form, which wind rules out" << std::endl;
+        return 1;
+    }
+    const Scene scene = loadScene(options.scenePath, sf::Vector2u(options.width, options.height));
+    Crossing walkCrossing = defaultCrossing(options, options.scenario.walkSpeed);
+    Crossing runCrossing = defaultCrossing(options, options.scenario.runSpeed);
+    runCrossing.rain.seed = options.commonRain ? options.rain.seed : options.rain.seed + 1;
+    const SampledWetness walk = sampleCrossing(options, walkCrossing, scene, options.importanceSamples, jobs);
+    const SampledWetness run = sampleCrossing(options, runCrossing, scene, options.importanceSamples, jobs);
+
+    std::cout << "Seed: " << options.rain.seed << std::endl;
+    printSampled("walk", walk);
+    printSampled("run", run);
+    const double halfWidth = std::sqrt(walk.halfWidth95 * walk.halfWidth95 + run.halfWidth95 * run.halfWidth95);
+    std::cout << "Walk - run: " << walk.wetness - run.wetness << " +/- " << halfWidth << std::endl;
+    std::cout << (walk.wetness < run.wetness ? "Walking" : "Running") << " keeps you drier" << std::endl;
+    return 0;
+}
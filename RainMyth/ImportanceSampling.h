@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+
+#include "Headless.h"
+#include "JobSystem.h"
+#include "Options.h"
+#include "Scene.h"
+#include "SurfaceWetness.h"
+
+// A crossing's expected wetness estimated from sampled drops, with the half-width of its
+// normal-approximation 95% interval
+struct SampledWetness {
+    double wetness;
+    double halfWidth95;
+    SurfaceWetness surfaces; // The estimate split by the face the drops came in by
+    std::size_t samples;
+    std::size_t hits;        // Of those, the ones that reached the person
+};
+
+// Estimates the expected wetness of crossing in calm air from samples drops, drawn only from
+// the ones that could reach the person on the way rather than from all the rain.
+//
+// A drop is its size, where in the spawn strip it starts, its column and when it spawns. Size
+// and start height are drawn as the rain draws them. The column is drawn from the ones the
+// person covers at some point of the walk, and the spawn time from the window in which a drop
+// there would be falling through the person's height while they cover it. Each drop is then
+// tested with ProceduralRain's contact rules and, if caught, weighted by its likelihood ratio:
+// the spawn rate times the width and length of the windows it was drawn from, times its area.
+// Every drop that can be caught lies inside those windows, so the mean is unbiased, and since
+// nearly every sample is caught it settles with a tiny fraction of the drops a simulation
+// spends. Shelter drips aren't modelled, as in ProceduralRain. Samples are drawn from a
+// counter-based generator keyed by crossing.rain.seed, so the estimate doesn't depend on the
+// thread count
+SampledWetness sampleCrossing(const Options& options, const Crossing& crossing, const Scene& scene, std::size_t samples, JobSystem& jobs);
+
+// --importance N: estimates the walk and run with N samples each and prints them and their
+// difference. Returns the process exit code
+int runImportance(const Options& options, JobSystem& jobs);
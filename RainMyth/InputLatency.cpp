@@ -0,0 +1,42 @@
+#include "InputLatency.h"
+
+#include <algorithm>
+
+InputLatency::InputLatency()
+    : pendingFirst(0), pendingCount(0), samples(MAX_SAMPLES), recorded(0), last(-1.0f) {
+}
+
+void InputLatency::pressed() {
+    if (pendingCount == MAX_PENDING) {
+        return;
+    }
+    pending[(pendingFirst + pendingCount) % MAX_PENDING] = Clock::now();
+    ++pendingCount;
+}
+
+float InputLatency::presented(unsigned movesStarted) {
+    float latest = -1.0f;
+    const Clock::time_point now = Clock::now();
+    for (; movesStarted > 0 && pendingCount > 0; --movesStarted) {
+        const std::chrono::duration<float, std::milli> latency = now - pending[pendingFirst];
+        pendingFirst = (pendingFirst + 1) % MAX_PENDING;
+        --pendingCount;
+        latest = latency.count();
+        samples[recorded % MAX_SAMPLES] = latest;
+        ++recorded;
+    }
+    if (latest >= 0.0f) {
+        last = latest;
+    }
+    return latest;
+}
+
+void InputLatency::print(std::ostream& out) const {
+    if (recorded == 0) {
+        return;
+    }
+    std::vector<float> sorted(samples.begin(), samples.begin() + std::min(recorded, MAX_SAMPLES));
+    std::sort(sorted.begin(), sorted.end());
+    out << "Input latency over " << recorded << " presses: median " << sorted[sorted.size() / 2] << " ms, 95th percentile "
+        << sorted[std::min(sorted.size() - 1, sorted.size() * 95 / 100)] << " ms, worst " << sorted.back() << " ms" << std::endl;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// End-to-end latency of W and R: from the frame that polled the key press, or the remote
+// command, to the present of the first frame showing the walk it started. The press goes through the command queue, the
+// job's steps and, pipelined, a frame of latency before it's on screen, and this times all of
+// it. Presses are matched to presents in order, by how many moves each shown frame started.
+// Everything is kept in storage made up front, so it costs nothing per frame
+class InputLatency {
+public:
+    InputLatency();
+
+    // A W or R, or a remote walk or run, was just polled
+    void pressed();
+
+    // The frame just presented started this many moves. Returns the latency of the last one it
+    // completes in milliseconds, or a negative number if none
+    float presented(unsigned movesStarted);
+
+    float lastMilliseconds() const {
+        return last;
+    }
+
+    std::size_t count() const {
+        return recorded;
+    }
+
+    // Median, 95th percentile and worst of the presses timed, if there were any
+    void print(std::ostream& out) const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    static const std::size_t MAX_PENDING = 16;  // Presses not yet on screen; more than a frame's worth are dropped
+    static const std::size_t MAX_SAMPLES = 4096; // Latencies kept for the summary, the latest
+
+    Clock::time_point pending[MAX_PENDING];
+    std::size_t pendingFirst;
+    std::size_t pendingCount;
+    std::vector<float> samples;
+    std::size_t recorded;
+    float last;
+};
@@ -0,0 +1,33 @@
+#include "Instrument.h"
+
+// Only the ETW backend has anything to define: its provider, registered for the life of the process
+#if defined(RAINMYTH_ETW)
+
+#include <string>
+
+// {1B7C5E56-3F43-4A63-9B6A-6E2D5C2A9F10}
+TRACELOGGING_DEFINE_PROVIDER(rainMythProvider, "RainMyth",
+    (0x1b7c5e56, 0x3f43, 0x4a63, 0x9b, 0x6a, 0x6e, 0x2d, 0x5c, 0x2a, 0x9f, 0x10));
+
+namespace {
+
+struct ProviderRegistration {
+    ProviderRegistration() {
+        TraceLoggingRegister(rainMythProvider);
+    }
+
+    ~ProviderRegistration() {
+        TraceLoggingUnregister(rainMythProvider);
+    }
+};
+
+ProviderRegistration registration;
+
+} // namespace
+
+void nameThread(const char* name) {
+    const std::string narrow(name);
+    SetThreadDescription(GetCurrentThread(), std::wstring(narrow.begin(), narrow.end()).c_str());
+}
+
+#endif
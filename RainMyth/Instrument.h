@@ -0,0 +1,86 @@
+#pragma once
+
+// Zones for an external profiler, compiled out unless the build defines one of:
+//
+//   RAINMYTH_TRACY  Tracy. Put Tracy's public directory on the include path and build its
+//                   TracyClient.cpp in with TRACY_ENABLE defined
+//   RAINMYTH_ETW    Windows ETW through TraceLogging, as start and stop events of the
+//                   "RainMyth" provider that WPA pairs into regions. Record with
+//                   wpr -start GeneralProfile, or any session enabling the provider's GUID
+//
+// With neither, every macro expands to nothing, so zones cost nothing in a normal build.
+//
+// Independently, a build defining RAINMYTH_TRACK_ALLOCATIONS counts the allocations made in
+// each zone, through AllocationZone, and the rendered loop names any zone that still
+// allocates once it has settled. Meant for debug builds: every zone entered costs a lookup
+//
+// RAINMYTH_ZONE(name) times the rest of the enclosing scope; name must be a string literal.
+// RAINMYTH_FRAME() marks the end of a rendered frame. RAINMYTH_THREAD(name) names the calling
+// thread in the trace
+
+#define RAINMYTH_CONCAT_(a, b) a##b
+#define RAINMYTH_CONCAT(a, b) RAINMYTH_CONCAT_(a, b)
+
+#if defined(RAINMYTH_TRACK_ALLOCATIONS)
+
+#include "AllocationCounter.h"
+
+#define RAINMYTH_ALLOCATION_ZONE(name) AllocationZone RAINMYTH_CONCAT(allocationZone, __LINE__)(name)
+
+#else
+
+#define RAINMYTH_ALLOCATION_ZONE(name) ((void)0)
+
+#endif
+
+#if defined(RAINMYTH_TRACY)
+
+#include <tracy/Tracy.hpp>
+
+// Named by line, as the ETW zones are, so a scope can hold more than one
+#define RAINMYTH_ZONE(name) RAINMYTH_ALLOCATION_ZONE(name); ZoneNamedN(RAINMYTH_CONCAT(tracyZone, __LINE__), name, true)
+#define RAINMYTH_FRAME() FrameMark
+#define RAINMYTH_THREAD(name) tracy::SetThreadName(name)
+
+#elif defined(RAINMYTH_ETW)
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <TraceLoggingProvider.h>
+#include <winmeta.h>
+
+TRACELOGGING_DECLARE_PROVIDER(rainMythProvider);
+
+// Writes a zone's start event when made and its stop event when destroyed. Both are on the
+// same thread, which is how WPA matches them up
+class EtwZone {
+public:
+    explicit EtwZone(const char* name) : name(name) {
+        TraceLoggingWrite(rainMythProvider, "Zone", TraceLoggingOpcode(WINEVENT_OPCODE_START), TraceLoggingString(name, "Name"));
+    }
+
+    ~EtwZone() {
+        TraceLoggingWrite(rainMythProvider, "Zone", TraceLoggingOpcode(WINEVENT_OPCODE_STOP), TraceLoggingString(name, "Name"));
+    }
+
+    EtwZone(const EtwZone&) = delete;
+    EtwZone& operator=(const EtwZone&) = delete;
+
+private:
+    const char* name;
+};
+
+void nameThread(const char* name);
+
+#define RAINMYTH_ZONE(name) RAINMYTH_ALLOCATION_ZONE(name); EtwZone RAINMYTH_CONCAT(etwZone, __LINE__)(name)
+#define RAINMYTH_FRAME() TraceLoggingWrite(rainMythProvider, "Frame")
+#define RAINMYTH_THREAD(name) nameThread(name)
+
+#else
+
+#define RAINMYTH_ZONE(name) RAINMYTH_ALLOCATION_ZONE(name)
+#define RAINMYTH_FRAME() ((void)0)
+#define RAINMYTH_THREAD(name) ((void)0)
+
+#endif
@@ -0,0 +1,104 @@
+#include "IoService.h"
+
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+#include "Instrument.h"
+
+IoService::~IoService() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+void IoService::write(std::ostream& out, const void* data, std::size_t bytes, Done done) {
+    Write write = { &out, std::string(), data, bytes, std::vector<std::uint8_t>(), std::move(done) };
+    push(std::move(write));
+}
+
+void IoService::write(std::ostream& out, std::vector<std::uint8_t>&& bytes) {
+    Write write = { &out, std::string(), nullptr, 0, std::move(bytes), Done() };
+    push(std::move(write));
+}
+
+void IoService::writeFile(const std::string& path, std::vector<std::uint8_t>&& bytes) {
+    Write write = { nullptr, path, nullptr, 0, std::move(bytes), Done() };
+    push(std::move(write));
+}
+
+void IoService::drain() {
+    std::unique_lock<std::mutex> lock(mutex);
+    const std::uint64_t until = handedOver;
+    changed.wait(lock, [&]() { return written >= until; });
+}
+
+void IoService::push(Write&& write) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!writer.joinable()) {
+        writer = std::thread(&IoService::run, this);
+    }
+    if (count == IO_QUEUE_WRITES) {
+        RAINMYTH_ZONE("Wait for the I/O thread");
+        changed.wait(lock, [this]() { return count < IO_QUEUE_WRITES; });
+    }
+    queue[(head + count) % IO_QUEUE_WRITES] = std::move(write);
+    ++count;
+    ++handedOver;
+    lock.unlock();
+    changed.notify_all();
+}
+
+// I/O thread: writes what's handed over as it comes until told to stop and the queue is empty
+void IoService::run() {
+    RAINMYTH_THREAD("I/O");
+    for (;;) {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this]() { return count > 0 || stopping; });
+        if (count == 0) {
+            return;
+        }
+        // Taken out of the ring, so its slot is free for the next while this one is written
+        Write job = std::move(queue[head]);
+        head = (head + 1) % IO_QUEUE_WRITES;
+        --count;
+        lock.unlock();
+        changed.notify_all();
+
+        RAINMYTH_ZONE("Write output");
+        const char* data = job.owned.empty() ? static_cast<const char*>(job.data) : reinterpret_cast<const char*>(job.owned.data());
+        const std::size_t bytes = job.owned.empty() ? job.bytes : job.owned.size();
+        bool ok = true;
+        if (job.out != nullptr) {
+            ok = static_cast<bool>(job.out->write(data, static_cast<std::streamsize>(bytes)));
+        }
+        else {
+            std::ofstream file(job.path, std::ios::binary);
+            file.write(data, static_cast<std::streamsize>(bytes));
+            file.close();
+            ok = !file.fail();
+            if (!ok) {
+                std::cerr << "Couldn't write " << job.path << std::endl;
+            }
+        }
+        if (job.done) {
+            job.done(ok);
+        }
+        job = Write(); // Its buffer is freed before the write counts as done
+
+        lock.lock();
+        ++written;
+        lock.unlock();
+        changed.notify_all();
+    }
+}
+
+IoService& ioService() {
+    static IoService service;
+    return service;
+}
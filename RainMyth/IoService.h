@@ -0,0 +1,68 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Constants.h"
+
+// The one thread output is written from. The sinks that produce as a run goes, the hit log,
+// columnar trial and sweep files and captured frames, hand it whole buffers and carry on; it
+// writes them in the order they were handed over, so each file's writes land in order, and
+// no thread that simulates, draws or encodes waits on the disk. A stream handed to it is only
+// written by it from then on, until drain() says it's done with everything so far.
+//
+// Up to IO_QUEUE_WRITES writes wait at once; past that, whoever hands over another waits for
+// room, which takes a disk far slower than the run. Made on first use, and at exit it writes
+// what's left before it stops
+class IoService {
+public:
+    // Called on the I/O thread once a write is done, with whether it all went out
+    typedef std::function<void(bool)> Done;
+
+    ~IoService();
+
+    // Writes bytes from data, which the caller keeps alive and untouched until done is called
+    void write(std::ostream& out, const void* data, std::size_t bytes, Done done);
+
+    // Writes bytes, freed once written
+    void write(std::ostream& out, std::vector<std::uint8_t>&& bytes);
+
+    // Writes bytes to a new file at path, replacing any there. Problems are reported on stderr
+    void writeFile(const std::string& path, std::vector<std::uint8_t>&& bytes);
+
+    // Waits until everything handed over so far is written
+    void drain();
+
+private:
+    struct Write {
+        std::ostream* out;          // Null for a whole file at path
+        std::string path;
+        const void* data;
+        std::size_t bytes;
+        std::vector<std::uint8_t> owned;
+        Done done;
+    };
+
+    Write queue[IO_QUEUE_WRITES]; // A ring
+    std::size_t head = 0;
+    std::size_t count = 0;
+    std::uint64_t handedOver = 0;
+    std::uint64_t written = 0;
+    bool stopping = false;
+    std::mutex mutex;
+    std::condition_variable changed; // Something was handed over or written
+    std::thread writer;
+
+    void push(Write&& write);
+    void run();
+};
+
+// The process's I/O thread
+IoService& ioService();
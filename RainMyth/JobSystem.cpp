@@ -0,0 +1,154 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include "Instrument.h"
+
+JobSystem::JobSystem(unsigned threadCount, bool pin) {
+    threadCount = std::max(1u, threadCount);
+    if (pin) {
+        processors = pinningOrder();
+        pinned = !processors.empty() && pinCurrentThread(processors[0]);
+        if (!pinned) {
+            std::cerr << "Couldn't pin the job threads, leaving them to the OS" << std::endl;
+            processors.clear();
+        }
+    }
+    for (unsigned i = 0; i < threadCount; ++i) {
+        queues.emplace_back(new Queue());
+        arenas.emplace_back(new FrameArena());
+    }
+    // Worker 0 is whichever thread calls run()
+    for (unsigned i = 1; i < threadCount; ++i) {
+        threads.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void JobSystem::resetArenas() {
+    for (const std::unique_ptr<FrameArena>& arena : arenas) {
+        arena->reset();
+    }
+}
+
+MemoryUsage JobSystem::arenaUsage() const {
+    MemoryUsage usage = MemoryUsage();
+    for (const std::unique_ptr<FrameArena>& arena : arenas) {
+        usage += arena->memoryUsage();
+    }
+    return usage;
+}
+
+unsigned JobSystem::defaultThreadCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void JobSystem::runErased(std::size_t chunks, std::size_t span, void* context, ChunkFn fn) {
+    if (chunks == 0) {
+        return;
+    }
+    if (threads.empty() || chunks == 1) {
+        for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+            fn(context, chunk, 0);
+        }
+        return;
+    }
+
+    // Deal each worker a contiguous share of the span, so neighbouring chunks usually stay on
+    // one thread. Shares past the last chunk are empty, and their workers go straight to stealing
+    const std::size_t workers = queues.size();
+    for (std::size_t w = 0; w < workers; ++w) {
+        std::lock_guard<std::mutex> lock(queues[w]->mutex);
+        queues[w]->begin = std::min(chunks, span * w / workers);
+        queues[w]->end = std::min(chunks, span * (w + 1) / workers);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        jobContext = context;
+        jobFn = fn;
+        remaining.store(chunks);
+        busyWorkers = static_cast<unsigned>(threads.size());
+        ++generation;
+    }
+    wake.notify_all();
+
+    drain(0);
+
+    // Wait until every background worker has finished and gone back to sleep, so nothing is
+    // still touching this run's context when we return
+    std::unique_lock<std::mutex> lock(wakeMutex);
+    done.wait(lock, [this] { return busyWorkers == 0; });
+}
+
+void JobSystem::workerLoop(unsigned worker) {
+    RAINMYTH_THREAD("Job worker");
+    if (!processors.empty()) {
+        pinCurrentThread(processors[worker % processors.size()]);
+    }
+    std::size_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wake.wait(lock, [this, seen] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+
+        drain(worker);
+
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        if (--busyWorkers == 0) {
+            done.notify_one();
+        }
+    }
+}
+
+void JobSystem::drain(unsigned worker) {
+    std::size_t chunk = 0;
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (!popOwn(worker, chunk) && !steal(worker, chunk)) {
+            // Everything left is already being run by someone else
+            break;
+        }
+        RAINMYTH_ZONE("Job chunk");
+        jobFn(jobContext, chunk, worker);
+        remaining.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+bool JobSystem::popOwn(unsigned worker, std::size_t& chunk) {
+    Queue& queue = *queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.begin == queue.end) {
+        return false;
+    }
+    chunk = queue.begin++;
+    return true;
+}
+
+bool JobSystem::steal(unsigned thief, std::size_t& chunk) {
+    const std::size_t workers = queues.size();
+    for (std::size_t offset = 1; offset < workers; ++offset) {
+        Queue& victim = *queues[(thief + offset) % workers];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.begin != victim.end) {
+            chunk = --victim.end;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "FrameArena.h"
+#include "MemoryUsage.h"
+#include "ThreadAffinity.h"
+
+// Fixed pool of worker threads that run chunked parallel loops. Each run splits the chunks
+// into one contiguous range per thread; a thread works through its own range from the front
+// and, once it's empty, steals from the back of someone else's. The calling thread takes part
+// as worker 0, so a pool of one thread simply runs everything inline.
+//
+// Work is always handed out by chunk index, so callers that write per-chunk results and reduce
+// them in chunk order get the same answer regardless of the thread count.
+//
+// Each worker has a FrameArena for its scratch memory, which only it touches during a run. The
+// caller, as worker 0, may use the first one between runs too.
+//
+// Pinned, each thread stays on one processor, see ThreadAffinity.h, and runPlaced gives every
+// chunk of a store the same worker every time, so memory that worker first wrote stays on its
+// NUMA node rather than being read across sockets
+class JobSystem {
+public:
+    // pin keeps each thread, the calling one as worker 0 included, on its own processor
+    explicit JobSystem(unsigned threadCount, bool pin = false);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    unsigned threadCount() const {
+        return static_cast<unsigned>(queues.size());
+    }
+
+    // Calls fn(chunk, worker) for every chunk in [0, chunks) and returns once all are done.
+    // worker is in [0, threadCount()) and can index per-thread scratch data
+    template <typename Fn>
+    void run(std::size_t chunks, Fn&& fn) {
+        using FnType = typename std::remove_reference<Fn>::type;
+        runErased(chunks, chunks, &fn, [](void* context, std::size_t chunk, unsigned worker) {
+            (*static_cast<FnType*>(context))(chunk, worker);
+        });
+    }
+
+    // As run, for chunks of a store span chunks long. Pinned, chunk c is dealt to worker
+    // c * threadCount() / span however many chunks this run has, so a worker keeps the same
+    // part of the store from run to run and only steals elsewhere once its own is done
+    template <typename Fn>
+    void runPlaced(std::size_t chunks, std::size_t span, Fn&& fn) {
+        using FnType = typename std::remove_reference<Fn>::type;
+        runErased(chunks, pinned ? std::max(span, chunks) : chunks, &fn, [](void* context, std::size_t chunk, unsigned worker) {
+            (*static_cast<FnType*>(context))(chunk, worker);
+        });
+    }
+
+    // Whether every thread was pinned
+    bool isPinned() const {
+        return pinned;
+    }
+
+    // Worker's scratch arena. Whoever runs the jobs resets them, once a frame
+    FrameArena& arena(unsigned worker) {
+        return *arenas[worker];
+    }
+
+    // Call between runs only
+    void resetArenas();
+
+    MemoryUsage arenaUsage() const;
+
+    // Thread count used when none is configured: one per hardware thread
+    static unsigned defaultThreadCount();
+
+private:
+    typedef void (*ChunkFn)(void* context, std::size_t chunk, unsigned worker);
+
+    // One worker's share of the current run, as the half-open range [begin, end)
+    struct Queue {
+        std::mutex mutex;
+        std::size_t begin = 0;
+        std::size_t end = 0;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::unique_ptr<FrameArena>> arenas;
+    std::vector<std::thread> threads;
+    std::vector<Processor> processors; // Worker w runs on processors[w % size], when pinned
+    bool pinned = false;
+
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::size_t generation = 0;
+    bool stopping = false;
+
+    void* jobContext = nullptr;
+    ChunkFn jobFn = nullptr;
+    std::atomic<std::size_t> remaining{ 0 };
+    unsigned busyWorkers = 0;
+
+    void runErased(std::size_t chunks, std::size_t span, void* context, ChunkFn fn);
+    void workerLoop(unsigned worker);
+    void drain(unsigned worker);
+    bool popOwn(unsigned worker, std::size_t& chunk);
+    bool steal(unsigned thief, std::size_t& chunk);
+};
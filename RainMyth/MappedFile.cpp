@@ -0,0 +1,99 @@
+#include "MappedFile.h"
+
+#include <algorithm>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+    : bytes(nullptr), length(0)
+#if defined(_WIN32)
+      , file(INVALID_HANDLE_VALUE), mapping(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+#if defined(_WIN32)
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER size;
+    if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size)) {
+        close();
+        return false;
+    }
+    length = static_cast<std::size_t>(size.QuadPart);
+    mapping = length > 0 ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    bytes = mapping ? static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+#else
+    const int descriptor = ::open(path.c_str(), O_RDONLY);
+    struct stat status;
+    if (descriptor < 0 || fstat(descriptor, &status) != 0) {
+        if (descriptor >= 0) {
+            ::close(descriptor);
+        }
+        return false;
+    }
+    length = static_cast<std::size_t>(status.st_size);
+    void* mapped = length > 0 ? mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0) : MAP_FAILED;
+    ::close(descriptor); // The mapping keeps the file
+    bytes = mapped != MAP_FAILED ? static_cast<const unsigned char*>(mapped) : nullptr;
+#endif
+    if (bytes == nullptr) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::prefetch(std::size_t offset, std::size_t count) const {
+    if (bytes == nullptr || offset >= length) {
+        return;
+    }
+    count = std::min(count, length - offset);
+#if defined(_WIN32)
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = const_cast<unsigned char*>(bytes + offset);
+    range.NumberOfBytes = count;
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+    // madvise wants the start on a page boundary, and the mapping starts on one
+    const std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    const std::size_t start = offset / page * page;
+    madvise(const_cast<unsigned char*>(bytes + start), count + offset - start, MADV_WILLNEED);
+#endif
+}
+
+void MappedFile::close() {
+#if defined(_WIN32)
+    if (bytes) {
+        UnmapViewOfFile(bytes);
+    }
+    if (mapping) {
+        CloseHandle(mapping);
+    }
+    if (file != INVALID_HANDLE_VALUE) {
+        CloseHandle(file);
+    }
+    mapping = nullptr;
+    file = INVALID_HANDLE_VALUE;
+#else
+    if (bytes) {
+        munmap(const_cast<unsigned char*>(bytes), length);
+    }
+#endif
+    bytes = nullptr;
+    length = 0;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// A whole file mapped read-only into memory, so reading it costs one open and the pages it
+// touches rather than a copy. data() stays valid until the file is closed or the object goes
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Maps the file at path. Returns false, with nothing mapped, if it couldn't be opened or
+    // mapped or is empty; callers say which of their files it was
+    bool open(const std::string& path);
+    void close();
+
+    const unsigned char* data() const {
+        return bytes;
+    }
+
+    std::size_t size() const {
+        return length;
+    }
+
+    // Asks the OS to start reading count bytes from offset in, clipped to the file, without
+    // waiting for them, so touching them later needn't wait on the disk
+    void prefetch(std::size_t offset, std::size_t count) const;
+
+private:
+    const unsigned char* bytes;
+    std::size_t length;
+#if defined(_WIN32)
+    void* file;
+    void* mapping;
+#endif
+};
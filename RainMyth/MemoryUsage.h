@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+// Bytes something has set aside and how many of them hold live data. Everything that owns a
+// sizeable buffer reports one through a memoryUsage() method, CPU and GPU memory alike, so the
+// pool sizes can be set against what a machine actually has
+struct MemoryUsage {
+    std::size_t reserved;
+    std::size_t used;
+
+    MemoryUsage& operator+=(const MemoryUsage& other) {
+        reserved += other.reserved;
+        used += other.used;
+        return *this;
+    }
+};
+
+// What a vector has reserved, of which its first used elements are live
+template <typename T, typename Alloc>
+MemoryUsage vectorUsage(const std::vector<T, Alloc>& values, std::size_t used) {
+    const MemoryUsage usage = { values.capacity() * sizeof(T), used * sizeof(T) };
+    return usage;
+}
+
+template <typename T, typename Alloc>
+MemoryUsage vectorUsage(const std::vector<T, Alloc>& values) {
+    return vectorUsage(values, values.size());
+}
+
+// Named usages gathered from around the program, for the HUD and the report at exit
+class MemoryReport {
+public:
+    void add(const char* name, const MemoryUsage& usage) {
+        const Entry entry = { name, usage };
+        entries.push_back(entry);
+    }
+
+    void clear() {
+        entries.clear();
+    }
+
+    MemoryUsage total() const {
+        MemoryUsage sum = MemoryUsage();
+        for (const Entry& entry : entries) {
+            sum += entry.usage;
+        }
+        return sum;
+    }
+
+    // One line per entry and one for the total, in megabytes
+    void print(std::ostream& out) const {
+        const double megabyte = 1024.0 * 1024.0;
+        const MemoryUsage sum = total();
+        out << "Memory: " << sum.reserved / megabyte << " MB reserved, " << sum.used / megabyte << " MB used" << std::endl;
+        for (const Entry& entry : entries) {
+            out << "  " << entry.name << ": " << entry.usage.reserved / megabyte << " MB reserved, "
+                << entry.usage.used / megabyte << " MB used" << std::endl;
+        }
+    }
+
+private:
+    struct Entry {
+        const char* name;
+        MemoryUsage usage;
+    };
+
+    std::vector<Entry> entries;
+};
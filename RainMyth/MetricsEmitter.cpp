@@ -0,0 +1,77 @@
+#include "MetricsEmitter.h"
+
+#include <SFML/Network/Packet.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+#include "SfmlNetworkCompat.h"
+
+namespace {
+
+const char METRICS_MAGIC[4] = { 'R', 'M', 'M', 'T' };
+const std::uint32_t METRICS_VERSION = 3;
+
+} // namespace
+
+MetricsEmitter::MetricsEmitter(const std::string& address)
+    : host(sf::IpAddress::Any), port(0), available(false), sequence(0), elapsed(0.0f), frames(0), kept(0), worstLatency(0.0f) {
+    const std::string::size_type colon = address.rfind(':');
+    const unsigned long value = colon == std::string::npos ? 0 : std::strtoul(address.c_str() + colon + 1, nullptr, 10);
+    if (value == 0 || value > 65535) {
+        std::cerr << "Couldn't read metrics address " << address << ", expected host:port" << std::endl;
+        return;
+    }
+    port = static_cast<unsigned short>(value);
+    if (!resolveAddress(address.substr(0, colon), host)) {
+        std::cerr << "Couldn't resolve metrics collector " << address << std::endl;
+        return;
+    }
+    if (socket.bind(sf::Socket::AnyPort) != sf::Socket::Status::Done) {
+        std::cerr << "Couldn't open a socket for metrics" << std::endl;
+        return;
+    }
+    socket.setBlocking(false);
+    available = true;
+}
+
+void MetricsEmitter::addFrame(float frameSeconds) {
+    if (!available) {
+        return;
+    }
+    elapsed += frameSeconds;
+    ++frames;
+    if (kept < MAX_FRAMES) {
+        frameTimes[kept++] = frameSeconds;
+    }
+}
+
+void MetricsEmitter::send(const Profiler& profiler, std::size_t drops, float wetness) {
+    if (!available || frames == 0) {
+        return;
+    }
+
+    // Percentiles of the frames kept, sorted in place since they're done with after this
+    std::sort(frameTimes, frameTimes + kept);
+    auto percentile = [this](std::size_t perMille) {
+        return frameTimes[std::min(kept - 1, kept * perMille / 1000)] * 1000.0f;
+    };
+
+    sf::Packet packet;
+    packet.append(METRICS_MAGIC, sizeof(METRICS_MAGIC));
+    packet << METRICS_VERSION << sequence++
+        << frames / elapsed << elapsed * 1000.0f / frames << percentile(990)
+        << static_cast<std::uint32_t>(drops) << wetness;
+    for (int phase = 0; phase < PHASE_COUNT; ++phase) {
+        packet << profiler.milliseconds(static_cast<ProfilePhase>(phase));
+    }
+    packet << worstLatency;
+    packet << percentile(500) << percentile(900) << percentile(999) << frameTimes[kept - 1] * 1000.0f;
+
+    // Partial sends only happen on TCP; on UDP it's all or nothing, and nothing is fine
+    (void)socket.send(packet, host, port);
+    elapsed = 0.0f;
+    frames = 0;
+    kept = 0;
+    worstLatency = 0.0f;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <SFML/Network/IpAddress.hpp>
+#include <SFML/Network/UdpSocket.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <string>
+
+#include "Profiler.h"
+
+// Sends a summary of the last second's frames to a collector over UDP, for watching a kiosk or
+// wall display from elsewhere. Frames are only counted as they go; once a second has passed,
+// the caller sends when it has the time to, and one datagram goes out on a non-blocking
+// socket, and if the OS can't take it right away it's skipped rather than waited for. Each
+// datagram is, in network byte order:
+//
+//   "RMMT", uint32 version, uint32 sequence number
+//   float fps, mean frame ms, p99 frame ms
+//   uint32 drop count, float wetness
+//   PHASE_COUNT floats, the profiler's smoothed milliseconds for each phase in ProfilePhase order
+//   float worst input latency ms over the second, see InputLatency.h, 0 with no presses
+//   float p50, p90, p99.9 and worst frame ms, since version 3
+//
+// Datagrams can be lost or reordered; the sequence number shows which
+class MetricsEmitter {
+public:
+    // address is "host:port". isAvailable() says whether it could be resolved and a socket bound
+    explicit MetricsEmitter(const std::string& address);
+
+    bool isAvailable() const {
+        return available;
+    }
+
+    // Counts one frame towards the next datagram
+    void addFrame(float frameSeconds);
+
+    // Whether a second's worth of frames are in
+    bool isDue() const {
+        return available && elapsed >= 1.0f;
+    }
+
+    // Sends the frames counted so far with the rest of the readings, and starts counting again
+    void send(const Profiler& profiler, std::size_t drops, float wetness);
+
+    // Counts a W or R press that has reached the screen, towards the next datagram
+    void addInputLatency(float milliseconds) {
+        worstLatency = std::max(worstLatency, milliseconds);
+    }
+
+private:
+    static const std::size_t MAX_FRAMES = 1024; // Frames a second is summarized over; any past that are left out of the percentiles
+
+    sf::UdpSocket socket;
+    sf::IpAddress host;
+    unsigned short port;
+    bool available;
+    std::uint32_t sequence;
+    float elapsed;  // Seconds of frames counted towards the next datagram
+    std::size_t frames;
+    std::size_t kept; // Frames that made it into frameTimes
+    float worstLatency;
+    float frameTimes[MAX_FRAMES];
+};
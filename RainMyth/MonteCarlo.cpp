@@ -0,0 +1,216 @@
+#include "MonteCarlo.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ColumnWriter.h"
+#include "Constants.h"
+#include "Headless.h"
+#include "Scene.h"
+
+namespace {
+
+// Trials of each kind before stopping is considered, so the variance estimate means something
+const std::size_t MONTE_CARLO_MIN_TRIALS = 10;
+
+void printStats(const char* name, const RunningStats& stats) {
+    std::cout << name << ": " << stats.mean() << " +/- " << stats.halfWidth95()
+        << " (variance " << stats.variance() << ")" << std::endl;
+}
+
+// Half-width of the 95% interval of walk - run. Independent trials add their variances; with
+// common rain the walk and run of a trial share their noise, which largely cancels in the
+// difference, so its own spread is the one to go by
+double differenceHalfWidth(const Options& options, const RunningStats& walk, const RunningStats& run, const RunningStats& difference) {
+    if (options.commonRain) {
+        return difference.halfWidth95();
+    }
+    return 1.96 * std::sqrt(walk.varianceOfMean() + run.varianceOfMean());
+}
+
+// One trial, as --trials-out writes it
+struct TrialRow {
+    std::uint32_t trial;
+    std::uint32_t running; // 0 for the walk, 1 for the run
+    std::uint64_t seed;
+    float speed;
+    float wetness;
+    SurfaceWetness surfaces;
+    float seconds; // Wall time the trial took
+};
+
+// Writes trials to a columnar file or a CSV as they come, a batch at a time
+class TrialWriter {
+public:
+    explicit TrialWriter(const std::string& path) : path(path) {
+        if (isColumnarPath(path)) {
+            table.reset(new ColumnWriter(path));
+            trial = table->addColumn("trial", COLUMN_UINT32);
+            running = table->addColumn("running", COLUMN_UINT32);
+            seed = table->addColumn("seed", COLUMN_UINT64);
+            speed = table->addColumn("speed", COLUMN_FLOAT32);
+            wetness = table->addColumn("wetness", COLUMN_FLOAT32);
+            top = table->addColumn("wetness_top", COLUMN_FLOAT32);
+            front = table->addColumn("wetness_front", COLUMN_FLOAT32);
+            back = table->addColumn("wetness_back", COLUMN_FLOAT32);
+            seconds = table->addColumn("seconds", COLUMN_FLOAT32);
+            return;
+        }
+        csv.open(path);
+        if (!csv) {
+            std::cerr << "Couldn't open " << path << " for writing" << std::endl;
+            return;
+        }
+        csv << "trial,running,seed,speed,wetness,wetness_top,wetness_front,wetness_back,seconds\n";
+    }
+
+    void add(const TrialRow& row) {
+        if (table) {
+            table->put(trial, static_cast<std::uint64_t>(row.trial));
+            table->put(running, static_cast<std::uint64_t>(row.running));
+            table->put(seed, row.seed);
+            table->put(speed, row.speed);
+            table->put(wetness, row.wetness);
+            table->put(top, row.surfaces.top);
+            table->put(front, row.surfaces.front);
+            table->put(back, row.surfaces.back);
+            table->put(seconds, row.seconds);
+            table->endRow();
+        }
+        else if (csv.is_open()) {
+            csv << row.trial << ',' << row.running << ',' << row.seed << ',' << row.speed << ',' << row.wetness << ','
+                << row.surfaces.top << ',' << row.surfaces.front << ',' << row.surfaces.back << ',' << row.seconds << '\n';
+        }
+    }
+
+    bool finish() {
+        if (table) {
+            return table->finish();
+        }
+        csv.close();
+        if (!csv) {
+            std::cerr << "Couldn't write " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::string path;
+    std::unique_ptr<ColumnWriter> table;
+    std::ofstream csv;
+    std::size_t trial, running, seed, speed, wetness, top, front, back, seconds;
+};
+
+} // namespace
+
+int runMonteCarlo(const Options& options, IntegrateKernel integrate, JobSystem& jobs) {
+    const sf::Vector2u screen(options.width, options.height);
+    const Scene scene = loadScene(options.scenePath, screen);
+
+    Crossing walk;
+    walk.rain = options.rain;
+    walk.personWidth = options.scenario.personWidth;
+    walk.personHeight = options.scenario.personHeight;
+    walk.speed = options.scenario.walkSpeed;
+    Crossing run = walk;
+    run.speed = options.scenario.runSpeed;
+
+    // Every batch gives each worker a walk and a run, or with --trial-lanes a lane's worth of
+    // each. Trial i walks in seed + 2i and runs in seed + 2i + 1, or with --common-rain both
+    // in seed + i, so the result doesn't depend on the batch size, lanes or thread count
+    const std::size_t lanes = std::min(std::max<std::size_t>(options.trialLanes, 1), MAX_PEOPLE);
+    const std::size_t batch = std::max<std::size_t>(jobs.threadCount() * lanes, MONTE_CARLO_MIN_TRIALS / 2);
+    std::cout << "Up to " << options.trials << " trials each, target precision " << options.precision
+        << ", on " << jobs.threadCount() << " threads" << (lanes > 1 ? ", " + std::to_string(lanes) + " trials to a store" : std::string()) << std::endl;
+    const auto started = std::chrono::steady_clock::now();
+
+    RunningStats walkStats;
+    RunningStats runStats;
+    RunningStats differenceStats; // Of each trial's walk - run, which only pairing makes meaningful
+    std::vector<float> wetness(batch * 2);
+    std::vector<TrialRow> rows(options.trialsPath.empty() ? 0 : batch * 2);
+    std::unique_ptr<TrialWriter> trialWriter;
+    if (!options.trialsPath.empty()) {
+        trialWriter.reset(new TrialWriter(options.trialsPath));
+    }
+    const Options unsaved = withoutSnapshotSave(options);
+    std::size_t trials = 0;
+    bool settled = false;
+    while (trials < options.trials && !settled) {
+        const std::size_t count = std::min(batch, options.trials - trials);
+        const std::size_t groups = (count + lanes - 1) / lanes;
+        jobs.run(groups * 2, [&](std::size_t job, unsigned) {
+            const std::size_t running = job % 2;
+            const std::size_t first = job / 2 * lanes;
+            const Crossing& crossing = running == 0 ? walk : run;
+            std::vector<std::uint64_t> seeds(std::min(lanes, count - first));
+            for (std::size_t i = 0; i < seeds.size(); ++i) {
+                const std::size_t trial = trials + first + i;
+                seeds[i] = options.commonRain ? options.rain.seed + trial : options.rain.seed + 2 * trial + running;
+            }
+            JobSystem serial(1);
+            const auto trialStarted = std::chrono::steady_clock::now();
+            std::vector<SurfaceWetness> surfaces;
+            const Options& trialOptions = trials == 0 && job == 0 ? options : unsaved; // Only the first walk saves --save-snapshot
+            const std::vector<float> results = simulateTrials(trialOptions, crossing, seeds, scene, integrate, serial,
+                rows.empty() ? nullptr : &surfaces);
+            const std::chrono::duration<float> trialTime = std::chrono::steady_clock::now() - trialStarted;
+            for (std::size_t i = 0; i < seeds.size(); ++i) {
+                const std::size_t slot = (first + i) * 2 + running;
+                wetness[slot] = results[i];
+                if (rows.empty()) {
+                    continue;
+                }
+                TrialRow& row = rows[slot];
+                row.trial = static_cast<std::uint32_t>(trials + first + i);
+                row.running = static_cast<std::uint32_t>(running);
+                row.seed = seeds[i];
+                row.speed = crossing.speed;
+                row.wetness = results[i];
+                row.surfaces = surfaces[i];
+                row.seconds = trialTime.count() / seeds.size(); // Lanes share their time
+            }
+        });
+        if (trialWriter) {
+            for (std::size_t job = 0; job < count * 2; ++job) {
+                trialWriter->add(rows[job]);
+            }
+        }
+        for (std::size_t i = 0; i < count; ++i) {
+            walkStats.add(wetness[i * 2]);
+            runStats.add(wetness[i * 2 + 1]);
+            differenceStats.add(wetness[i * 2] - wetness[i * 2 + 1]);
+        }
+        trials += count;
+
+        const double difference = walkStats.mean() - runStats.mean();
+        const double halfWidth = differenceHalfWidth(options, walkStats, runStats, differenceStats);
+        settled = trials >= MONTE_CARLO_MIN_TRIALS && halfWidth <= options.precision * std::abs(difference);
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+    if (trialWriter && trialWriter->finish()) {
+        std::cout << "Wrote " << trials * 2 << " trials to " << options.trialsPath << std::endl;
+    }
+
+    const double difference = walkStats.mean() - runStats.mean();
+    const double halfWidth = differenceHalfWidth(options, walkStats, runStats, differenceStats);
+    std::cout << "Trials: " << trials << (settled ? " (target precision reached)" : " (trial limit reached)")
+        << " in " << elapsed.count() << " s" << std::endl;
+    printStats("Walk wetness", walkStats);
+    printStats("Run wetness", runStats);
+    std::cout << "Walk - run: " << difference << " +/- " << halfWidth << (options.commonRain ? " (paired)" : "") << std::endl;
+    if (std::abs(difference) > halfWidth) {
+        std::cout << (difference < 0.0 ? "Walking" : "Running") << " keeps you drier at 95% confidence" << std::endl;
+    }
+    else {
+        std::cout << "No significant difference between walking and running" << std::endl;
+    }
+    return 0;
+}
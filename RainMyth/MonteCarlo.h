@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+
+#include "JobSystem.h"
+#include "Options.h"
+#include "RainKernels.h"
+
+// Mean and variance of a stream of samples, by Welford's update, so adding a sample never
+// needs the earlier ones
+class RunningStats {
+public:
+    RunningStats() : n(0), sum(0.0), m2(0.0) {}
+
+    void add(double sample) {
+        ++n;
+        const double delta = sample - sum;
+        sum += delta / n;
+        m2 += delta * (sample - sum);
+    }
+
+    std::size_t count() const {
+        return n;
+    }
+
+    double mean() const {
+        return sum;
+    }
+
+    // Sample variance, 0 until there are two samples
+    double variance() const {
+        return n > 1 ? m2 / (n - 1) : 0.0;
+    }
+
+    // Variance of the mean itself
+    double varianceOfMean() const {
+        return n > 0 ? variance() / n : 0.0;
+    }
+
+    // Half-width of the normal-approximation 95% confidence interval of the mean
+    double halfWidth95() const {
+        return 1.96 * std::sqrt(varianceOfMean());
+    }
+
+private:
+    std::size_t n;
+    double sum; // Running mean
+    double m2;  // Sum of squared deviations from it
+};
+
+// Runs seeded walk and run trials in batches across the job pool until the 95%
+// interval of the walk minus run difference is within options.precision of the difference
+// itself, or options.trials of each have run. With --common-rain each trial's walk and run
+// share a seed and the interval comes from the paired differences, which settles far sooner. A clear difference settles after a few batches;
+// a close one keeps going, so the time goes where the answer is actually in doubt. Prints the
+// mean, variance and interval of each and of the difference. Returns the process exit code
+int runMonteCarlo(const Options& options, IntegrateKernel integrate, JobSystem& jobs);
@@ -0,0 +1,185 @@
+#include "Offline.h"
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+#include "BackgroundCache.h"
+#include "Constants.h"
+#include "EventRain.h"
+#include "FrameCapture.h"
+#include "Person.h"
+#include "PersonSprite.h"
+#include "ProceduralRain.h"
+#include "RainBatch.h"
+#include "RainSystem.h"
+#include "Scene.h"
+#include "SfmlCompat.h"
+#include "SplashSystem.h"
+#include "SpriteAtlas.h"
+#include "TerminalVelocity.h"
+#include "WorldView.h"
+
+int runOffline(const Options& options, IntegrateKernel integrate, JobSystem& jobs) {
+    if (options.gpu || options.lod) {
+        std::cerr << "Offline renders simulate every drop on the CPU, ignoring --gpu and --lod" << std::endl;
+    }
+    // As for headless crossings, procedural rain wins over event-driven
+    const bool procedural = options.procedural && options.rain.wind.isCalm();
+    const bool eventDriven = options.eventDriven && options.rain.wind.isCalm() && !procedural;
+
+    // The texture's context is the only one, so it has to exist before anything that draws
+    sf::RenderTexture target;
+    if (!createRenderTexture(target, sf::Vector2u(options.offlineWidth, options.offlineHeight))) {
+        std::cerr << "Couldn't create a " << options.offlineWidth << "x" << options.offlineHeight << " render texture" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const sf::Vector2u world(options.width, options.height);
+    target.setView(worldView(world, target.getSize()));
+    (void)target.setActive(true);
+
+    const Scenario& scenario = options.scenario;
+    Scene scene = loadScene(options.scenePath, world);
+    RainSystem rainSystem(world, options.rain, scene, integrate, jobs);
+    SplashSystem splashes(options.splashBudget, options.rain.seed);
+    rainSystem.recordImpacts(options.splashBudget > 0 ? options.splashBudget / SPLASH_DROPLETS + 1 : 0);
+    RainBatch rainBatch(true, options.renderMode);
+    rainBatch.setStreaks(options.streakExposure, options.streakPersistence);
+    rainBatch.setResolution(options.rainResolution);
+    rainBatch.setVisibleArea(viewBounds(target.getView()));
+    rainBatch.setDropPixels(options.rain.maxSize * std::min(options.offlineWidth / static_cast<float>(world.x), options.offlineHeight / static_cast<float>(world.y)));
+    SpriteAtlas atlas;
+    const bool useAtlas = atlas.build();
+    if (useAtlas) {
+        rainBatch.setAtlas(&atlas);
+    }
+    sf::VertexArray splashVertices(QUAD_PRIMITIVE);
+    const sf::Color rainColor(173, 216, 230, 200);
+    const sf::Color waterColor(90, 140, 190, 170);
+    sf::VertexArray groundStrip;
+    BackgroundCache background(sf::Color::Black);
+
+    Person person(startPoint(world), sf::Vector2f(scenario.personWidth, scenario.personHeight));
+    person.setMaxWetness(scenario.maxWetness);
+    PersonSprite personSprite;
+    if (useAtlas) {
+        personSprite.setTexture(&atlas.getTexture(), atlas.getRect(SPRITE_PERSON));
+    }
+    if (options.prewarm) {
+        const sf::FloatRect bounds = person.getBounds();
+        rainSystem.prewarm(&bounds, 1);
+    }
+    person.startMove(endPoint(world), options.offlineRun ? scenario.runSpeed : scenario.walkSpeed);
+
+    // Event-driven, the person's walk is known up front, so the rain runs on EventRain and its
+    // drops are only ever placed once a frame, for drawing. It rains for a drop's lifetime
+    // before the first frame, so the air is as full as prewarming leaves it
+    //
+    // Procedurally, the drops aren't even kept: each step asks what the walk catches, and each
+    // frame regenerates the drops on screen. The rain has always been falling, so the walk
+    // starts at once
+    const sf::FloatRect bounds = person.getBounds();
+    PersonPath path;
+    path.left = rectLeft(bounds);
+    path.top = rectTop(bounds);
+    path.width = rectWidth(bounds);
+    path.height = rectHeight(bounds);
+    path.endLeft = endPoint(world).x - rectWidth(bounds) / 2.0f;
+    path.speed = options.offlineRun ? scenario.runSpeed : scenario.walkSpeed;
+    path.startTime = 0.0f;
+    std::unique_ptr<EventRain> eventRain;
+    std::unique_ptr<ProceduralRain> proceduralRain;
+    RainField placedDrops(options.rain.maxDrops);
+    if (procedural) {
+        proceduralRain.reset(new ProceduralRain(world, options.rain, scene));
+    }
+    if (eventDriven) {
+        const float timestep = 1.0f / options.simHz;
+        eventRain.reset(new EventRain(world, options.rain, scene, timestep));
+        const float warmup = (world.y + 100.0f) / terminalSpeed(options.rain.minSize);
+        path.startTime = std::ceil(warmup / timestep) * timestep;
+        eventRain->addPerson(path);
+        float ignored = 0.0f;
+        while (eventRain->getTime() + timestep / 2.0f < path.startTime) {
+            eventRain->update(timestep, &ignored);
+        }
+    }
+
+    // Frame n shows the simulation at exactly n / fps seconds: the steps up to that time are
+    // taken, and the person is drawn the rest of the way into the next one. Counting from the
+    // start rather than adding up frame times keeps rounding from drifting the two apart
+    FrameCapture capture(options.offlinePath, false);
+    const float timestep = 1.0f / options.simHz;
+    const double stepsPerFrame = options.simHz / static_cast<double>(options.offlineFps);
+    std::uint64_t step = 0;
+    std::uint64_t frame = 0;
+    double arrivedAt = -1.0; // Seconds into the render the person reached the end
+    sf::Clock clock;
+    for (;; ++frame) {
+        const double seconds = frame / static_cast<double>(options.offlineFps);
+        if (options.offlineSeconds > 0.0f ? seconds > options.offlineSeconds : arrivedAt >= 0.0 && seconds > arrivedAt + 1.0) {
+            break; // Without a length, a second after arriving
+        }
+
+        const double due = frame * stepsPerFrame;
+        splashes.beginFrame();
+        for (; step + 1 <= due + 1e-9; ++step) {
+            person.update(timestep);
+            SurfaceWetness split = SurfaceWetness();
+            if (proceduralRain) {
+                person.addWetness(proceduralRain->catches(path, step * timestep, (step + 1) * timestep, &split));
+            }
+            else if (eventRain) {
+                float wetness = 0.0f;
+                eventRain->update(timestep, &wetness, &split);
+                person.addWetness(wetness);
+            }
+            else {
+                person.addWetness(rainSystem.update(timestep, person.getBounds(), &split));
+                splashes.emit(rainSystem.getImpacts());
+            }
+            person.addSurfaceWetness(split);
+            splashes.update(timestep);
+            if (arrivedAt < 0.0 && !person.isMovingToTarget()) {
+                arrivedAt = (step + 1) * static_cast<double>(timestep);
+            }
+        }
+        const float alpha = static_cast<float>(std::min(std::max(due - step, 0.0), 1.0));
+
+        // The rain is drawn as far between the last two steps as the person is
+        const float lag = (1.0f - alpha) * timestep;
+        if (proceduralRain) {
+            proceduralRain->positionsAt(step * timestep - lag, 0.0f, static_cast<float>(world.x), placedDrops);
+            rainBatch.build(placedDrops, rainColor);
+        }
+        else if (eventRain) {
+            eventRain->positionsAt(eventRain->getTime() - lag, placedDrops);
+            rainBatch.build(placedDrops, rainColor);
+        }
+        else {
+            rainBatch.build(rainSystem.getDrops(), rainColor, lag);
+        }
+        background.draw(target, scene);
+        rainBatch.draw(target);
+        rainSystem.getGroundWater().build(groundStrip, static_cast<float>(world.y), waterColor);
+        target.draw(groundStrip);
+        splashes.build(rainColor, splashVertices, useAtlas ? atlas.getTexCoords(SPRITE_SPLASH) : sf::FloatRect(), lag);
+        target.draw(splashVertices, useAtlas ? &atlas.getTexture() : nullptr);
+        personSprite.draw(target, person, alpha);
+        capture.capture(target);
+        target.display();
+
+        if (frame % options.offlineFps == 0 && frame > 0) {
+            std::cout << "Rendered " << frame << " frames, " << seconds << " s, at " << frame / clock.getElapsedTime().asSeconds()
+                << " frames per second" << std::endl;
+        }
+    }
+
+    std::cout << (options.offlineRun ? "Run" : "Walk") << " wetness: " << person.getWetness() << " after " << frame
+        << " frames at " << options.offlineFps << " fps" << std::endl;
+    return EXIT_SUCCESS;
+}
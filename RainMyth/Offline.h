@@ -0,0 +1,15 @@
+#pragma once
+
+#include "JobSystem.h"
+#include "Options.h"
+#include "RainKernels.h"
+
+// Renders one walk, or one run with --offline-run, into an offscreen texture of
+// --offline-size and writes every frame to the --offline directory as numbered PNGs. Each
+// output frame advances the --sim-hz simulation by exactly 1 / --offline-fps seconds however
+// long it takes to simulate, draw and encode, and no frame is ever dropped, so the sequence
+// plays back at --offline-fps with the timing of a machine fast enough to show it live.
+// With --event-driven in calm air the rain is EventRain's, its drops placed only for each
+// frame drawn, and there are no splashes.
+// Needs a GL context but no window. Returns the process exit code
+int runOffline(const Options& options, IntegrateKernel integrate, JobSystem& jobs);
@@ -0,0 +1,177 @@
+#include "Optimizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "Constants.h"
+#include "Fingerprint.h"
+#include "Headless.h"
+#include "MonteCarlo.h"
+#include "Person.h"
+#include "ResultCache.h"
+#include "Scene.h"
+#include "Trajectory.h"
+
+namespace {
+
+// Wetness of each trial at every speed tried so far, by speed. Given a cache, trials run by
+// an earlier search are looked up there, and new ones kept
+class SpeedEvaluator {
+public:
+    SpeedEvaluator(const Options& options, const Scene& scene, IntegrateKernel integrate, JobSystem& jobs, ResultCache* cache)
+        : options(options), unsaved(withoutSnapshotSave(options)), scene(scene), integrate(integrate), jobs(jobs), cache(cache) {}
+
+    const std::vector<float>& trials(float speed) {
+        std::vector<float>& wetness = results[speed];
+        if (!wetness.empty()) {
+            return wetness;
+        }
+        const sf::Vector2u screen(options.width, options.height);
+        Trajectory route(startPoint(screen));
+        route.moveTo(endPoint(screen), speed, options.optimizeAcceleration);
+        wetness.resize(options.optimizeTrials);
+        jobs.run(wetness.size(), [&](std::size_t trial, unsigned) {
+            RainConfig rain = options.rain;
+            rain.seed = options.rain.seed + trial;
+            Walker walker;
+            walker.personWidth = options.scenario.personWidth;
+            walker.personHeight = options.scenario.personHeight;
+            walker.speed = speed;
+            walker.startTime = 0.0f;
+            walker.trajectory = options.optimizeAcceleration > 0.0f ? &route : nullptr;
+            const std::vector<Walker> walkers(1, walker);
+            std::uint64_t key = 0;
+            if (cache) {
+                // The route is a straight one, so its acceleration is all that tells routes apart
+                Fingerprint routeKey;
+                routeKey.add(options.optimizeAcceleration);
+                key = crowdKey(options, rain, scene, walkers, routeKey.value());
+                std::vector<float> kept;
+                if (cache->find(key, kept) && kept.size() == 1) {
+                    wetness[trial] = kept.front();
+                    return;
+                }
+            }
+            JobSystem serial(1);
+            // Only the first speed's first trial saves --save-snapshot
+            const Options& trialOptions = results.size() == 1 && trial == 0 ? options : unsaved;
+            wetness[trial] = simulateCrowd(trialOptions, rain, scene, walkers, integrate, serial).front();
+            if (cache) {
+                cache->add(key, std::vector<float>(1, wetness[trial]));
+            }
+        });
+        return wetness;
+    }
+
+    double mean(float speed) {
+        RunningStats stats;
+        for (float wetness : trials(speed)) {
+            stats.add(wetness);
+        }
+        return stats.mean();
+    }
+
+    std::size_t evaluated() const {
+        return results.size();
+    }
+
+    // The driest speed of all those tried
+    float best() {
+        float driest = results.begin()->first;
+        for (const auto& result : results) {
+            if (mean(result.first) < mean(driest)) {
+                driest = result.first;
+            }
+        }
+        return driest;
+    }
+
+private:
+    const Options& options;
+    const Options unsaved;
+    const Scene& scene;
+    IntegrateKernel integrate;
+    JobSystem& jobs;
+    ResultCache* cache;
+    std::map<float, std::vector<float>> results;
+};
+
+// Mean and 95% interval of the paired difference between two speeds' trials in the same rain
+void printComparison(const char* name, float speed, float best, SpeedEvaluator& evaluator) {
+    if (speed == best) {
+        return;
+    }
+    const std::vector<float>& theirs = evaluator.trials(speed);
+    const std::vector<float>& ours = evaluator.trials(best);
+    RunningStats difference;
+    for (std::size_t i = 0; i < ours.size(); ++i) {
+        difference.add(theirs[i] - ours[i]);
+    }
+    std::cout << "Against " << name << " at " << speed << ": " << difference.mean() << " +/- " << difference.halfWidth95() << " wetter";
+    if (difference.mean() > difference.halfWidth95()) {
+        std::cout << ", significant at 95%" << std::endl;
+    }
+    else {
+        std::cout << ", not significant" << std::endl;
+    }
+}
+
+} // namespace
+
+int runOptimizer(const Options& options, IntegrateKernel integrate, JobSystem& jobs) {
+    const sf::Vector2u screen(options.width, options.height);
+    const Scene scene = loadScene(options.scenePath, screen);
+    std::unique_ptr<ResultCache> cache;
+    if (!options.cachePath.empty()) {
+        cache.reset(new ResultCache(options.cachePath));
+    }
+    SpeedEvaluator evaluator(options, scene, integrate, jobs, cache.get());
+    std::cout << "Optimizing speed over " << options.optimizeMinSpeed << " to " << options.optimizeMaxSpeed << " with "
+        << options.optimizeTrials << " trials per candidate on " << jobs.threadCount() << " threads" << std::endl;
+    const auto started = std::chrono::steady_clock::now();
+
+    // Keep the two interior points at the golden ratio, so each step reuses one of them. The
+    // search never reaches the ends themselves, and the driest speed is often the fastest, so
+    // they're tried too
+    const float ratio = 0.618034f;
+    float low = options.optimizeMinSpeed;
+    float high = std::max(options.optimizeMaxSpeed, low);
+    evaluator.trials(low);
+    evaluator.trials(high);
+    float left = high - (high - low) * ratio;
+    float right = low + (high - low) * ratio;
+    while (high - low > OPTIMIZE_SPEED_TOLERANCE) {
+        if (evaluator.mean(left) < evaluator.mean(right)) {
+            high = right;
+            right = left;
+            left = high - (high - low) * ratio;
+        }
+        else {
+            low = left;
+            left = right;
+            right = low + (high - low) * ratio;
+        }
+    }
+    const float best = evaluator.best();
+    RunningStats bestStats;
+    for (float wetness : evaluator.trials(best)) {
+        bestStats.add(wetness);
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+    std::cout << "Evaluated " << evaluator.evaluated() << " speeds in " << elapsed.count() << " s" << std::endl;
+    std::cout << "Best speed: " << best << " (the search closed in on " << low << " to " << high << "), wetness "
+        << bestStats.mean() << " +/- " << bestStats.halfWidth95() << std::endl;
+    printComparison("walking", options.scenario.walkSpeed, best, evaluator);
+    printComparison("running", options.scenario.runSpeed, best, evaluator);
+    printComparison("the slowest", options.optimizeMinSpeed, best, evaluator);
+    printComparison("the fastest", options.optimizeMaxSpeed, best, evaluator);
+    if (cache) {
+        std::cout << cache->hitCount() << " of " << cache->hitCount() + cache->missCount() << " trials came from " << options.cachePath << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "JobSystem.h"
+#include "Options.h"
+#include "RainKernels.h"
+
+// Searches --optimize-range for the crossing speed that keeps the person driest, by
+// golden-section search on the mean wetness of --optimize trials per candidate. Every
+// candidate crosses the same rain, seeds seed to seed + trials - 1, so comparisons between
+// candidates are paired and the noise they share cancels: far fewer trials settle which of
+// two speeds is drier than independent rain would need. A candidate's trials run in parallel
+// across the job pool. With --optimize-accel, each candidate speeds up from rest and slows to a
+// stop at the end at that acceleration instead of moving at full speed throughout. Assumes
+// wetness has one minimum over the range, as it does in steady rain and wind. With --cache,
+// trials an earlier search ran are looked up instead of simulated again. Prints the best
+// speed, its wetness and how sure the comparison with walking and running is, and returns the
+// process exit code
+int runOptimizer(const Options& options, IntegrateKernel integrate, JobSystem& jobs);
@@ -0,0 +1,580 @@
+#include "Options.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+#include "AssetPack.h"
+#include "Constants.h"
+#include "JobSystem.h"
+#include "RainIntensity.h"
+
+namespace {
+
+SweepRange singlePoint(float value) {
+    SweepRange range;
+    range.first = value;
+    range.last = value;
+    range.steps = 1;
+    return range;
+}
+
+// "first:last:steps" or just "value"
+SweepRange parseRange(const char* text) {
+    char* end = nullptr;
+    SweepRange range = singlePoint(std::strtof(text, &end));
+    if (*end == ':') {
+        range.last = std::strtof(end + 1, &end);
+        range.steps = 2;
+        if (*end == ':') {
+            range.steps = static_cast<unsigned>(std::max(1ul, std::strtoul(end + 1, &end, 10)));
+        }
+    }
+    if (*end != '\0') {
+        std::cerr << "Couldn't read range " << text << ", expected first:last:steps" << std::endl;
+    }
+    return range;
+}
+
+} // namespace
+
+Options parseOptions(int argc, char* argv[]) {
+    Options options;
+    options.rain.seed = std::random_device{}();
+    options.seedGiven = false;
+    options.threads = JobSystem::defaultThreadCount();
+    options.simHz = SIM_HZ;
+    options.scenario = defaultScenario();
+    options.hud = true;
+    options.startupTimes = false;
+    options.audioVolume = AUDIO_VOLUME;
+    options.windowed = false;
+    options.lowLatency = false;
+    options.prewarm = false;
+    options.stress = false;
+    options.pipeline = true;
+    options.freeSim = false;
+    options.stallPolicy = STALL_CATCH_UP;
+    options.eventDriven = false;
+    options.procedural = false;
+    options.densityField = false;
+    options.densityParticles = false;
+    options.clothingCapacity = 0.0f;
+    options.crowdCount = 0;
+    options.idleSeconds = 0.0f;
+    options.previewThreads = 0;
+    options.splashBudget = SPLASH_BUDGET;
+    options.targetMs = 0.0f;
+    options.headless = false;
+    options.analyticOnly = false;
+    options.dropLifetimes = false;
+    options.validate = false;
+    options.pinThreads = false;
+    options.rainPreset = false;
+    options.lod = false;
+    options.depthLayers = 0;
+    options.trials = 0;
+    options.importanceSamples = 0;
+    options.trialLanes = 1;
+    options.precision = 0.1f;
+    options.optimizeTrials = 0;
+    options.optimizeMinSpeed = 10.0f;
+    options.optimizeMaxSpeed = 0.0f; // Twice the run speed, once the scenario is known
+    options.optimizeAcceleration = 0.0f;
+    options.commonRain = false;
+    options.joystick = false;
+    options.gpu = false;
+    options.controlPort = 0;
+    options.wallDisplays = 0;
+    options.renderMode = RENDER_QUADS;
+    options.pacing = PACING_SLEEP;
+    options.fps = 60.0f;
+    options.streakExposure = 1.0f / 30.0f;
+    options.streakPersistence = 0.0f;
+    options.rainResolution = 1.0f;
+    options.gpuDrops = 0;
+    options.gpuBackend = GPU_FEEDBACK;
+    options.telemetrySamples = TELEMETRY_SAMPLES;
+    options.sweepServePort = 0;
+    options.width = WORLD_WIDTH;
+    options.height = WORLD_HEIGHT;
+    options.offlineWidth = WORLD_WIDTH;
+    options.offlineHeight = WORLD_HEIGHT;
+    options.offlineFps = 60;
+    options.offlineSeconds = 0.0f;
+    options.offlineRun = false;
+    options.sweep.speed = parseRange("10:400:40");
+    options.sweep.spawnRate = singlePoint(RAINDROP_SPAWN_RATE);
+    options.sweep.dropSize = singlePoint((RAINDROP_MIN_SIZE + RAINDROP_MAX_SIZE) / 2.0f);
+    options.sweep.personWidth = singlePoint(PERSON_WIDTH);
+    options.sweep.personHeight = singlePoint(PERSON_HEIGHT);
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        // Flags
+        if (std::strcmp(arg, "--headless") == 0) {
+            options.headless = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--analytic") == 0) {
+            options.analyticOnly = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--lifetimes") == 0) {
+            options.dropLifetimes = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--validate") == 0) {
+            options.validate = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--pin-threads") == 0) {
+            options.pinThreads = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--event-driven") == 0) {
+            options.eventDriven = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--density-field") == 0) {
+            options.densityField = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--density-particles") == 0) {
+            options.densityParticles = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--procedural") == 0) {
+            options.procedural = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--no-pipeline") == 0) {
+            options.pipeline = false;
+            continue;
+        }
+        if (std::strcmp(arg, "--free-sim") == 0) {
+            options.freeSim = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--joystick") == 0) {
+            options.joystick = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--common-rain") == 0) {
+            options.commonRain = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--stress") == 0) {
+            options.stress = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--prewarm") == 0) {
+            options.prewarm = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--low-latency") == 0) {
+            options.lowLatency = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--windowed") == 0) {
+            options.windowed = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--no-hud") == 0) {
+            options.hud = false;
+            continue;
+        }
+        if (std::strcmp(arg, "--startup-times") == 0) {
+            options.startupTimes = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--column-buckets") == 0) {
+            options.rain.columnBuckets = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--drips") == 0) {
+            options.rain.shelterDrips = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--lod") == 0) {
+            options.lod = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--offline-run") == 0) {
+            options.offlineRun = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--gpu") == 0) {
+            options.gpu = true;
+            continue;
+        }
+
+        // Everything else takes a value
+        if (value == nullptr) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            break;
+        }
+        if (std::strcmp(arg, "--seed") == 0) {
+            options.rain.seed = std::strtoull(value, nullptr, 10);
+            options.seedGiven = true;
+        }
+        else if (std::strcmp(arg, "--max-drops") == 0) {
+            options.rain.maxDrops = static_cast<std::size_t>(std::strtoull(value, nullptr, 10));
+        }
+        else if (std::strcmp(arg, "--coalesce") == 0) {
+            options.rain.coalesceDistance = std::max(static_cast<float>(std::atof(value)), 0.0f);
+        }
+        else if (std::strcmp(arg, "--coarse-steps") == 0) {
+            options.rain.coarseSteps = std::max<std::size_t>(static_cast<std::size_t>(std::strtoull(value, nullptr, 10)), 1);
+        }
+        else if (std::strcmp(arg, "--depth-layers") == 0) {
+            options.depthLayers = std::min(static_cast<unsigned>(std::strtoul(value, nullptr, 10)), MAX_DEPTH_LAYERS);
+        }
+        else if (std::strcmp(arg, "--spawn-rate") == 0) {
+            options.rain.spawnRate = static_cast<float>(std::atof(value));
+        }
+        else if (std::strcmp(arg, "--drop-sizes") == 0) {
+            if (std::strcmp(value, "marshall-palmer") == 0) {
+                options.rain.sizeModel = DROP_SIZES_MARSHALL_PALMER;
+            }
+            else {
+                options.rain.sizeModel = DROP_SIZES_UNIFORM;
+                if (std::strcmp(value, "uniform") != 0) {
+                    std::cerr << "Unknown drop size model " << value << ", using uniform" << std::endl;
+                }
+            }
+        }
+        else if (std::strcmp(arg, "--hits") == 0) {
+            if (std::strcmp(value, "raster") == 0) {
+                options.rain.hits = HITS_RASTER;
+            }
+            else {
+                options.rain.hits = HITS_SWEPT;
+                if (std::strcmp(value, "swept") != 0) {
+                    std::cerr << "Unknown hit test " << value << ", using swept" << std::endl;
+                }
+            }
+        }
+        else if (std::strcmp(arg, "--body") == 0) {
+            if (std::strcmp(value, "capsule") == 0) {
+                options.rain.body = BODY_CAPSULE;
+            }
+            else if (std::strcmp(value, "leaning") == 0) {
+                options.rain.body = BODY_LEANING;
+            }
+            else {
+                options.rain.body = BODY_BOX;
+                if (std::strcmp(value, "box") != 0) {
+                    std::cerr << "Unknown body shape " << value << ", using box" << std::endl;
+                }
+            }
+        }
+        else if (std::strcmp(arg, "--rain") == 0) {
+            options.rainPreset = parseRainIntensity(value, options.rain.rainIntensity);
+            if (!options.rainPreset) {
+                std::cerr << "Expected --rain drizzle, moderate, heavy, downpour or mm per hour, got " << value << std::endl;
+            }
+        }
+        else if (std::strcmp(arg, "--rain-intensity") == 0) {
+            options.rain.rainIntensity = static_cast<float>(std::atof(value));
+        }
+        else if (std::strcmp(arg, "--wind") == 0) {
+            options.rain.wind.speed = static_cast<float>(std::atof(value));
+        }
+        else if (std::strcmp(arg, "--gust") == 0) {
+            options.rain.wind.gust = static_cast<float>(std::atof(value));
+        }
+        else if (std::strcmp(arg, "--gust-period") == 0) {
+            options.rain.wind.gustPeriod = static_cast<float>(std::atof(value));
+        }
+        else if (std::strcmp(arg, "--turbulence") == 0) {
+            options.rain.wind.turbulence = static_cast<float>(std::atof(value));
+        }
+        else if (std::strcmp(arg, "--threads") == 0) {
+            options.threads = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+        }
+        else if (std::strcmp(arg, "--kernel") == 0) {
+            options.kernel = value;
+        }
+        else if (std::strcmp(arg, "--render") == 0) {
+            if (std::strcmp(value, "points") == 0) {
+                options.renderMode = RENDER_POINTS;
+            }
+            else if (std::strcmp(value, "streaks") == 0) {
+                options.renderMode = RENDER_STREAKS;
+            }
+            else if (std::strcmp(value, "adaptive") == 0) {
+                options.renderMode = RENDER_ADAPTIVE;
+            }
+            else {
+                options.renderMode = RENDER_QUADS;
+                if (std::strcmp(value, "quads") != 0) {
+                    std::cerr << "Unknown render mode " << value << ", using quads" << std::endl;
+                }
+            }
+        }
+        else if (std::strcmp(arg, "--stall") == 0) {
+            if (std::strcmp(value, "clamp") == 0) {
+                options.stallPolicy = STALL_CLAMP;
+            }
+            else if (std::strcmp(value, "pause") == 0) {
+                options.stallPolicy = STALL_PAUSE;
+            }
+            else {
+                options.stallPolicy = STALL_CATCH_UP;
+                if (std::strcmp(value, "catch-up") != 0) {
+                    std::cerr << "Unknown stall policy " << value << ", catching up" << std::endl;
+                }
+            }
+        }
+        else if (std::strcmp(arg, "--pacing") == 0) {
+            if (std::strcmp(value, "vsync") == 0) {
+                options.pacing = PACING_VSYNC;
+            }
+            else if (std::strcmp(value, "uncapped") == 0) {
+                options.pacing = PACING_UNCAPPED;
+            }
+            else if (std::strcmp(value, "precise") == 0) {
+                options.pacing = PACING_PRECISE;
+            }
+            else {
+                options.pacing = PACING_SLEEP;
+                if (std::strcmp(value, "sleep") != 0) {
+                    std::cerr << "Unknown pacing " << value << ", using sleep" << std::endl;
+                }
+            }
+        }
+        else if (std::strcmp(arg, "--fps") == 0) {
+            options.fps = static_cast<float>(std::atof(value));
+        }
+        else if (std::strcmp(arg, "--target-ms") == 0) {
+            options.targetMs = static_cast<float>(std::atof(value));
+        }
+        else if (std::strcmp(arg, "--splash-budget") == 0) {
+            options.splashBudget = static_cast<std::size_t>(std::strtoull(value, nullptr, 10));
+        }
+        else if (std::strcmp(arg, "--audio-volume") == 0) {
+            options.audioVolume = std::min(std::max(static_cast<float>(std::atof(value)), 0.0f), 100.0f);
+        }
+        else if (std::strcmp(arg, "--streak-exposure") == 0) {
+            options.streakExposure = static_cast<float>(std::atof(value));
+        }
+        else if (std::strcmp(arg, "--rain-resolution") == 0) {
+            options.rainResolution = static_cast<float>(std::atof(value));
+        }
+        else if (std::strcmp(arg, "--streak-persistence") == 0) {
+            options.streakPersistence = static_cast<float>(std::atof(value));
+        }
+        else if (std::strcmp(arg, "--sim-hz") == 0) {
+            const float hz = static_cast<float>(std::atof(value));
+            options.simHz = hz > 0.0f ? hz : SIM_HZ;
+        }
+        else if (std::strcmp(arg, "--clothing") == 0) {
+            options.clothingCapacity = std::max(static_cast<float>(std::atof(value)), 0.0f);
+        }
+        else if (std::strcmp(arg, "--idle-after") == 0) {
+            options.idleSeconds = std::max(static_cast<float>(std::atof(value)), 0.0f);
+        }
+        else if (std::strcmp(arg, "--preview") == 0) {
+            options.previewThreads = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+        }
+        else if (std::strcmp(arg, "--crowd") == 0) {
+            options.crowdCount = static_cast<std::size_t>(std::strtoull(value, nullptr, 10));
+        }
+        else if (std::strcmp(arg, "--width") == 0) {
+            options.width = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+        }
+        else if (std::strcmp(arg, "--height") == 0) {
+            options.height = static_cast<unsigned>(std::strtoul(value, nullptr, 10));
+        }
+        else if (std::strcmp(arg, "--gpu-drops") == 0) {
+            options.gpuDrops = static_cast<std::size_t>(std::strtoull(value, nullptr, 10));
+        }
+        else if (std::strcmp(arg, "--shader-cache") == 0) {
+            options.shaderCachePath = value;
+        }
+        else if (std::strcmp(arg, "--gpu-backend") == 0) {
+            if (std::strcmp(value, "compute") == 0) {
+                options.gpuBackend = GPU_COMPUTE;
+            }
+            else {
+                options.gpuBackend = GPU_FEEDBACK;
+                if (std::strcmp(value, "feedback") != 0) {
+                    std::cerr << "Unknown GPU backend " << value << ", using feedback" << std::endl;
+                }
+            }
+        }
+        else if (std::strcmp(arg, "--route") == 0) {
+            options.route = value;
+        }
+        else if (std::strcmp(arg, "--scene") == 0) {
+            options.scenePath = value;
+        }
+        else if (std::strcmp(arg, "--storm") == 0) {
+            options.stormPath = value;
+        }
+        else if (std::strcmp(arg, "--telemetry") == 0) {
+            options.telemetryPath = value;
+        }
+        else if (std::strcmp(arg, "--telemetry-samples") == 0) {
+            options.telemetrySamples = static_cast<std::size_t>(std::strtoull(value, nullptr, 10));
+        }
+        else if (std::strcmp(arg, "--hit-log") == 0) {
+            options.hitLogPath = value;
+        }
+        else if (std::strcmp(arg, "--trace") == 0) {
+            options.tracePath = value;
+        }
+        else if (std::strcmp(arg, "--summary") == 0) {
+            options.summaryPath = value;
+        }
+        else if (std::strcmp(arg, "--metrics") == 0) {
+            options.metricsAddress = value;
+        }
+        else if (std::strcmp(arg, "--control") == 0) {
+            const unsigned long port = std::strtoul(value, nullptr, 10);
+            if (port == 0 || port > 65535) {
+                std::cerr << "Expected --control PORT, got " << value << std::endl;
+            }
+            else {
+                options.controlPort = static_cast<unsigned short>(port);
+            }
+        }
+        else if (std::strcmp(arg, "--wall") == 0) {
+            const unsigned long count = std::strtoul(value, nullptr, 10);
+            if (count == 0 || count > MAX_WALL_DISPLAYS) {
+                std::cerr << "Expected --wall N from 1 to " << MAX_WALL_DISPLAYS << ", got " << value << std::endl;
+            }
+            else {
+                options.wallDisplays = static_cast<unsigned>(count);
+            }
+        }
+        else if (std::strcmp(arg, "--snapshot") == 0) {
+            options.snapshotPath = value;
+        }
+        else if (std::strcmp(arg, "--save-snapshot") == 0) {
+            options.saveSnapshotPath = value;
+        }
+        else if (std::strcmp(arg, "--capture") == 0) {
+            options.capturePath = value;
+        }
+        else if (std::strcmp(arg, "--offline") == 0) {
+            options.offlinePath = value;
+        }
+        else if (std::strcmp(arg, "--offline-size") == 0) {
+            if (std::sscanf(value, "%ux%u", &options.offlineWidth, &options.offlineHeight) != 2) {
+                std::cerr << "Expected --offline-size WxH, got " << value << std::endl;
+            }
+        }
+        else if (std::strcmp(arg, "--offline-fps") == 0) {
+            options.offlineFps = std::max(1u, static_cast<unsigned>(std::strtoul(value, nullptr, 10)));
+        }
+        else if (std::strcmp(arg, "--offline-seconds") == 0) {
+            options.offlineSeconds = static_cast<float>(std::atof(value));
+        }
+        else if (std::strcmp(arg, "--record") == 0) {
+            options.recordPath = value;
+        }
+        else if (std::strcmp(arg, "--replay") == 0) {
+            options.replayPath = value;
+        }
+        else if (std::strcmp(arg, "--script") == 0) {
+            options.scriptPath = value;
+        }
+        else if (std::strcmp(arg, "--importance") == 0) {
+            options.importanceSamples = static_cast<std::size_t>(std::strtoull(value, nullptr, 10));
+        }
+        else if (std::strcmp(arg, "--trials") == 0) {
+            options.trials = static_cast<std::size_t>(std::strtoull(value, nullptr, 10));
+        }
+        else if (std::strcmp(arg, "--trials-out") == 0) {
+            options.trialsPath = value;
+        }
+        else if (std::strcmp(arg, "--trial-lanes") == 0) {
+            options.trialLanes = static_cast<std::size_t>(std::strtoull(value, nullptr, 10));
+        }
+        else if (std::strcmp(arg, "--optimize") == 0) {
+            options.optimizeTrials = static_cast<std::size_t>(std::strtoull(value, nullptr, 10));
+        }
+        else if (std::strcmp(arg, "--optimize-range") == 0) {
+            if (std::sscanf(value, "%f:%f", &options.optimizeMinSpeed, &options.optimizeMaxSpeed) != 2) {
+                std::cerr << "Expected --optimize-range MIN:MAX, got " << value << std::endl;
+            }
+        }
+        else if (std::strcmp(arg, "--optimize-accel") == 0) {
+            options.optimizeAcceleration = static_cast<float>(std::atof(value));
+        }
+        else if (std::strcmp(arg, "--precision") == 0) {
+            options.precision = static_cast<float>(std::atof(value));
+        }
+        else if (std::strcmp(arg, "--assets") == 0) {
+            options.assetPackPath = value;
+        }
+        else if (std::strcmp(arg, "--pack-assets") == 0) {
+            options.packAssetsPath = value;
+        }
+        else if (std::strcmp(arg, "--scenario") == 0) {
+            options.scenarioPath = value;
+        }
+        else if (std::strcmp(arg, "--sweep") == 0) {
+            options.sweepPath = value;
+        }
+        else if (std::strcmp(arg, "--cache") == 0) {
+            options.cachePath = value;
+        }
+        else if (std::strcmp(arg, "--sweep-serve") == 0) {
+            options.sweepServePort = static_cast<unsigned short>(std::strtoul(value, nullptr, 10));
+        }
+        else if (std::strcmp(arg, "--sweep-worker") == 0) {
+            options.sweepWorker = value;
+        }
+        else if (std::strcmp(arg, "--batch") == 0) {
+            options.batchPath = value;
+        }
+        else if (std::strcmp(arg, "--sweep-speed") == 0) {
+            options.sweep.speed = parseRange(value);
+        }
+        else if (std::strcmp(arg, "--sweep-rate") == 0) {
+            options.sweep.spawnRate = parseRange(value);
+        }
+        else if (std::strcmp(arg, "--sweep-drop") == 0) {
+            options.sweep.dropSize = parseRange(value);
+        }
+        else if (std::strcmp(arg, "--sweep-width") == 0) {
+            options.sweep.personWidth = parseRange(value);
+        }
+        else if (std::strcmp(arg, "--sweep-height") == 0) {
+            options.sweep.personHeight = parseRange(value);
+        }
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            continue;
+        }
+        ++i;
+    }
+
+    if (options.rainPreset) {
+        applyRainIntensity(options);
+    }
+
+    // Everything after this may read from the pack
+    if (!options.assetPackPath.empty() && !assets().open(options.assetPackPath)) {
+        std::cerr << "Reading assets from disk" << std::endl;
+    }
+
+    // The scenario file is what gets edited between experiments, so what it sets wins
+    options.scenario.spawnRate = options.rain.spawnRate;
+    if (!options.scenarioPath.empty() && !loadScenario(options.scenarioPath, options.scenario)) {
+        std::cerr << "Using the default scenario" << std::endl;
+    }
+    options.rain.spawnRate = options.scenario.spawnRate;
+    if (options.optimizeMaxSpeed <= 0.0f) {
+        options.optimizeMaxSpeed = 2.0f * options.scenario.runSpeed;
+    }
+    return options;
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "RainBatch.h"
+#include "RainConfig.h"
+#include "FramePacer.h"
+#include "GpuRain.h"
+#include "Scenario.h"
+
+// Evenly spaced values from first to last inclusive. Parsed from "first:last:steps", or a
+// single number for a range of one
+struct SweepRange {
+    float first;
+    float last;
+    unsigned steps;
+
+    float at(unsigned i) const {
+        return steps > 1 ? first + (last - first) * i / (steps - 1) : first;
+    }
+};
+
+// Ranges a --sweep run crosses. Every combination is simulated
+struct SweepSpec {
+    SweepRange speed;        // --sweep-speed
+    SweepRange spawnRate;    // --sweep-rate
+    SweepRange dropSize;     // --sweep-drop. Mean drop width; the spread of the default sizes is kept
+    SweepRange personWidth;  // --sweep-width
+    SweepRange personHeight; // --sweep-height
+};
+
+// Everything that can be set from the command line
+struct Options {
+    RainConfig rain;          // --seed N (drawn from the OS once per launch by default), --max-drops N,
+                              // --spawn-rate N (drops per second per pixel of width), --wind N,
+                              // --gust N, --gust-period S, --turbulence N (pixels per second, see WindConfig),
+                              // --column-buckets, --drop-sizes uniform|marshall-palmer, --rain-intensity MM_PER_HOUR,
+                              // --coarse-steps N, --drips, --body box|capsule|leaning, --coalesce PIXELS,
+                              // --hits swept|raster
+    bool seedGiven;           // Whether --seed set rain.seed, rather than the OS
+    bool rainPreset;          // --rain drizzle|moderate|heavy|downpour|MM_PER_HOUR. Sets rain.rainIntensity and
+                              // from it the spawn rate and Marshall-Palmer sizes, and falls back to --lod or
+                              // --analytic when that's more rain than the drop pool holds
+    unsigned threads;         // --threads N. Job pool size, one per hardware thread by default
+    bool pinThreads;          // --pin-threads. Keep each job thread on one processor, spread over the NUMA nodes,
+                              // with the drop store's memory on the node of the thread that updates it
+    std::string kernel;       // --kernel scalar|sse2|avx2|neon. Widest supported by default
+    RainRenderMode renderMode; // --render quads|points|streaks|adaptive. Points expand each drop in a geometry
+                              // shader; streaks draw motion-blurred lines, so fewer drops look as dense;
+                              // adaptive draws quads, lines or pixels by how big the drops are on screen
+    float streakExposure;     // --streak-exposure S. Seconds of fall a streak's length shows
+    float streakPersistence;  // --streak-persistence P. Fraction of each frame's streaks kept into the next
+    float rainResolution;     // --rain-resolution S. Draw the rain additively at S of full resolution and stretch it
+                              // over the world, so dense rain's overdraw costs S squared as much. 1, the default, draws it directly
+    std::size_t splashBudget; // --splash-budget N. Most splash droplets emitted per frame, 0 for no splashes
+    float audioVolume;        // --audio-volume V. Loudness of the rendered rain's sound out of 100, 0 for silence
+    float targetMs;           // --target-ms N. Frame time the quality governor holds by thinning the
+                              // rain away from the person, 0 (the default) to leave quality alone
+    bool stress;              // --stress. Ramp the rain up until frames stop fitting in 60 fps, then report the most
+                              // drops that did and exit, see StressTest.h. Rendered runs on the CPU rain
+    bool prewarm;             // --prewarm. Start in steady rain instead of an empty sky: the window from the first
+                              // frame, --headless crowds without simulating a warmup
+    PacingMode pacing;        // --pacing sleep|vsync|uncapped|precise. Sleep, the default, is SFML's frame
+                              // limit; precise sleeps most of the frame and spins the rest, for even frames
+    float fps;                // --fps N. Frame rate sleep and precise pacing hold, 60 by default
+    bool lowLatency;          // --low-latency. Wait for each frame to reach the screen before the next, so the
+                              // driver queues none; with --no-pipeline too, presses show up soonest
+    bool windowed;            // --windowed. Start in a 1280x720 window instead of fullscreen; F11 switches either way
+    bool hud;                 // --no-hud clears it. Show the wetness and timings overlay; without it the font is never loaded
+    bool startupTimes;        // --startup-times. Report how long each stage of startup takes, up to a rendered run's first frame
+    bool pipeline;            // --no-pipeline clears it. Simulate each frame on a worker while the last one renders
+    StallPolicy stallPolicy;  // --stall catch-up|clamp|pause. What the fixed-step loop does about a frame that stalls,
+                              // catching up by default; see StallPolicy
+    bool joystick;            // --joystick. The first joystick steers the person's pace as they cross, see PaceStick
+    bool freeSim;             // --free-sim. The pipelined simulation steps on its own clock instead of as many steps as
+                              // each frame banked, so stalls on the main thread, in the message pump, don't pause it
+    float simHz;              // --sim-hz N. Fixed simulation rate in steps per second, rendered or headless
+    bool headless;            // --headless. Simulate walk and run with no window and print the results
+    bool eventDriven;         // --event-driven. Headless crossings and --offline renders in calm air solve impacts on
+                              // EventRain instead of stepping every drop
+    bool procedural;          // --procedural. Headless crossings in calm air on straight walks regenerate only the rain
+                              // near each person from ProceduralRain, storing none of it, however heavy. --offline
+                              // renders in calm air regenerate the rain on screen each frame too
+    bool densityField;        // --density-field. Headless crossings on straight walks carry the rain as a density grid
+                              // in DensityRain, wind or not, at a cost that doesn't grow with the rain
+    bool densityParticles;    // --density-particles. With --density-field, the rain near each person is turned into
+                              // drops that hit them one at a time, and back into the grid once they're past
+    float clothingCapacity;   // --clothing C. Wetness is the water people's clothes hold, C per pixel of each face's edge at
+                              // most, rather than all they catch; see Clothing. 0, the default, for no clothes
+    float idleSeconds;        // --idle-after SECONDS. After this long with no input and no one crossing, pause the
+                              // particles, draw the rain procedurally and drop to IDLE_FPS until the next input. 0, the
+                              // default, never
+    unsigned previewThreads;  // --preview N. With the HUD, estimate the walk's and the run's wetness in the scenario being
+                              // shown, refined by trials on N background threads as it's edited; see WetnessPreview. 0, the
+                              // default, for none
+    std::size_t crowdCount;   // --crowd N. Fill the street with N pedestrians, half of them running, who get wet in the
+                              // drawn rain alongside the person; see Crowd. 0, the default, for none
+    bool analyticOnly;        // --analytic. With --headless, print only the flux-model estimate and, in calm air, the
+                              // exact integral, see integrateCrossing
+    bool dropLifetimes;       // --lifetimes. Print how long drops lived and how they went, after each stepped headless
+                              // crossing and at exit. See DropLifetimes
+    std::string route;        // --route "move X SPEED [ACCELERATION]; wait SECONDS; ...". With --headless, also
+                              // cross on this route, in the walk's rain. See parseTrajectory
+    bool validate;            // --validate. Check the selected kernel, threads and rain against the scalar reference and exit
+    unsigned width;           // --width N / --height N. Size of the simulated world, whatever the display,
+    unsigned height;          // in units of a centimetre
+    bool lod;                 // --lod. Simulate drops only near the person and the scene and draw
+                              // the rest of the screen's rain procedurally
+    unsigned depthLayers;     // --depth-layers N. Draw up to 3 layers of far-off rain behind the simulated rain, for depth.
+                              // Drawn procedurally, so they cost no drops and never reach the person
+    bool gpu;                 // --gpu. Simulate the rain on the GPU where OpenGL 3.0 is available
+    std::size_t gpuDrops;     // --gpu-drops N. Fixed GPU drop population, matched to --spawn-rate by default
+    GpuRainBackend gpuBackend; // --gpu-backend feedback|compute. Compute, for the largest populations, simulates
+                              // in compute shaders and draws instanced where OpenGL 4.4 is available
+    std::string shaderCachePath; // --shader-cache DIR. Keep the GPU rain's linked programs here, so later runs
+                              // skip compiling them where the driver can hand them back
+    std::string scenePath;    // --scene FILE. Colliders to shelter under, instead of the two platforms
+    std::string stormPath;    // --storm FILE. Play a recorded storm's rain and wind into a live run, see StormTrack
+    std::string scenarioPath; // --scenario FILE. Tuning read at startup and watched for changes; its
+    Scenario scenario;        // spawn rate wins over --spawn-rate's
+    std::string assetPackPath; // --assets FILE. Read scenes and scenarios from this pack where it has them
+    std::string packAssetsPath; // --pack-assets FILE. Pack the Assets directory into FILE and exit
+    std::string telemetryPath; // --telemetry FILE. Sample the person every step and write the samples at the end,
+                              // as CSV if FILE ends in .csv and binary otherwise. Rendered and --headless runs
+    std::size_t telemetrySamples; // --telemetry-samples N. Most recent samples kept
+    std::string hitLogPath;   // --hit-log FILE. Write every catch to FILE as it happens, see HitLog.h. Rendered and
+                              // --headless runs on stepped rain
+    std::string tracePath;    // --trace FILE. Write the spans RAINMYTH_TIMED and the frame phases record on every thread
+                              // to FILE as a Chrome trace at exit, see CycleTimer.h. Rendered runs
+    std::string summaryPath;  // --summary FILE. Append each rendered crossing's run summary, or a windowless mode's
+                              // once it's done, to FILE as a line of JSON, see RunSummary. It's printed either way
+    std::string metricsAddress; // --metrics HOST:PORT. Send a summary of each second's frames there over UDP
+    unsigned short controlPort; // --control PORT. Take commands over TCP on this port, see RemoteControl.h. 0 for none
+    unsigned wallDisplays;    // --wall N. Also show the world across N more windows side by side, each drawing its
+                              // own strip of it on its own thread, see WallDisplay.h. 0 for none
+    std::string snapshotPath; // --snapshot FILE. Headless crowds start from the rain saved there instead of warming up, when it matches
+    std::string saveSnapshotPath; // --save-snapshot FILE. Save the first headless crowd's rain and people there once warmed up
+    std::string capturePath;  // --capture DIR. Write each rendered frame to DIR as numbered PNGs, dropping frames the
+                              // encoder can't keep up with rather than slowing the window
+    std::string offlinePath;  // --offline DIR. Render a walk into DIR as numbered PNGs with no window, however slowly
+    unsigned offlineWidth;    // --offline-size WxH. Size of the rendered frames, the world's by default
+    unsigned offlineHeight;
+    unsigned offlineFps;      // --offline-fps N. Frames per second of simulated time, 60 by default
+    float offlineSeconds;     // --offline-seconds S. Length of the render, by default until a second after arriving
+    bool offlineRun;          // --offline-run. Render a run instead of a walk
+    std::string recordPath;   // --record FILE. Log a rendered run's seed, settings and W/R presses
+    std::string replayPath;   // --replay FILE. Repeat a logged run, rendered or with --headless
+    std::string scriptPath;   // --script FILE. Play a scripted scenario out instead of waiting for keys, rendered or
+                              // with --headless. See Script.h
+    std::size_t importanceSamples; // --importance N. Estimate walk and run wetness from N drops each, drawn only from
+                              // the ones that could reach the person, see sampleCrossing. Calm air only
+    std::size_t trials;       // --trials N. Monte Carlo mode: up to N seeded walk and run trials each
+    std::string trialsPath;   // --trials-out FILE. Write every Monte Carlo trial to FILE, columnar if it ends in .cols
+    std::size_t trialLanes;   // --trial-lanes N. Run N Monte Carlo trials at once in one store, see simulateTrials. 1 by default
+                              // and CSV otherwise
+    std::size_t optimizeTrials; // --optimize N. Search for the speed that keeps the person driest, N trials per candidate
+    float optimizeMinSpeed;   // --optimize-range MIN:MAX. Speeds searched, 10 to twice the scenario's run speed by default
+    float optimizeMaxSpeed;
+    float optimizeAcceleration; // --optimize-accel A. Candidates start and stop at this acceleration. 0, the default, for none
+    bool commonRain;          // --common-rain. Walk and run cross the same rain, in every mode, so their difference is paired
+    float precision;          // --precision P. Stop once the 95% interval of walk - run is within P of it
+    std::string sweepPath;    // --sweep FILE. Simulate every point of the sweep ranges and write them to FILE,
+                              // columnar if it ends in .cols and CSV otherwise
+    SweepSpec sweep;
+    unsigned short sweepServePort; // --sweep-serve PORT. With --sweep, hand the sweep out to workers instead of simulating it
+    std::string sweepWorker;  // --sweep-worker HOST[:PORT]. Simulate crowds for the coordinator there until it's done
+    std::string cachePath;    // --cache FILE. Look sweep crowds and optimizer trials up in the result cache at FILE before
+                              // simulating them, and keep what's simulated there; see ResultCache
+    std::string batchPath;    // --batch FILE. Run the trials FILE lists, - for stdin, in one reused rain, see Batch.h
+};
+
+// Unknown arguments are reported on stderr and otherwise ignored
+Options parseOptions(int argc, char* argv[]);
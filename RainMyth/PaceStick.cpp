@@ -0,0 +1,39 @@
+#include "PaceStick.h"
+
+#include <SFML/Window/Joystick.hpp>
+#include <algorithm>
+#include <cmath>
+
+#include "Constants.h"
+
+PaceStick::PaceStick(float topPace)
+    : topPace(topPace), joystick(sf::Joystick::Count), startHeld(false), resetHeld(false), sentPace(0.0f) {}
+
+StickReading PaceStick::sample() {
+    StickReading reading = { false, false, false, false, 0.0f };
+    if (joystick == sf::Joystick::Count || !sf::Joystick::isConnected(joystick)) {
+        for (joystick = 0; joystick < sf::Joystick::Count && !sf::Joystick::isConnected(joystick); ++joystick) {}
+        startHeld = false;
+        resetHeld = false;
+        if (joystick == sf::Joystick::Count) {
+            return reading;
+        }
+    }
+    reading.connected = true;
+
+    const bool start = sf::Joystick::isButtonPressed(joystick, 0);
+    const bool reset = sf::Joystick::isButtonPressed(joystick, 1);
+    reading.start = start && !startHeld;
+    reading.reset = reset && !resetHeld;
+    startHeld = start;
+    resetHeld = reset;
+
+    const float travel = std::fabs(sf::Joystick::getAxisPosition(joystick, sf::Joystick::Axis::X));
+    reading.pace = std::max(travel - STICK_DEAD_ZONE, 0.0f) / (100.0f - STICK_DEAD_ZONE) * topPace;
+    // Coming back to rest always counts, so the person can be stopped dead
+    reading.paceChanged = std::fabs(reading.pace - sentPace) >= STICK_PACE_STEP || (reading.pace == 0.0f && sentPace != 0.0f);
+    if (reading.paceChanged) {
+        sentPace = reading.pace;
+    }
+    return reading;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+// What the joystick asked for since the last reading
+struct StickReading {
+    bool connected;
+    bool start;       // The start button, 0, went down: cross again from the start
+    bool reset;       // Button 1 went down: back to the start, dry
+    bool paceChanged; // pace has moved STICK_PACE_STEP or more from the last pace read as changed
+    float pace;       // Pixels per second
+};
+
+// --joystick: analog control of the person's pace, to find the best one by feel. The X axis
+// of the first connected joystick, either way past STICK_DEAD_ZONE, sets the pace from 0 up to
+// topPace at full travel. SFML updates joysticks along with the window's events, so sampling
+// more than once a frame would read the same state again; main samples once a frame, after
+// polling, and sends only what changed through the input queue, which hands it to the
+// simulation at the start of the step it falls in. Nothing here runs on the simulation's side
+class PaceStick {
+public:
+    explicit PaceStick(float topPace);
+
+    StickReading sample();
+
+private:
+    float topPace;
+    unsigned joystick; // The one being read, or sf::Joystick::Count while none is connected
+    bool startHeld;
+    bool resetHeld;
+    float sentPace;    // The pace last read as changed
+};
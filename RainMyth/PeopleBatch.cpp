@@ -0,0 +1,113 @@
+#include "PeopleBatch.h"
+
+#include "Constants.h"
+#include "Crowd.h"
+#include "PersonSprite.h"
+#include "SfmlCompat.h"
+#include "ShaderCompiler.h"
+
+namespace {
+
+// Instances pass their centre as the position, their size in texCoords and their level in
+// the colour's alpha
+const char* PEOPLE_VERTEX_SHADER = R"(
+#version 150 compatibility
+out vec2 personSize;
+out float personLevel;
+
+void main() {
+    gl_Position = gl_Vertex;
+    personSize = gl_MultiTexCoord0.xy;
+    personLevel = gl_Color.a * 255.0;
+}
+)";
+
+const char* PEOPLE_GEOMETRY_SHADER = R"(
+#version 150 compatibility
+layout(points) in;
+layout(triangle_strip, max_vertices = 4) out;
+in vec2 personSize[];
+in float personLevel[];
+flat out float level;
+
+void main() {
+    vec4 corner = gl_in[0].gl_Position - vec4(personSize[0] / 2.0, 0.0, 0.0);
+    level = personLevel[0];
+    gl_Position = gl_ModelViewProjectionMatrix * corner;
+    EmitVertex();
+    level = personLevel[0];
+    gl_Position = gl_ModelViewProjectionMatrix * (corner + vec4(personSize[0].x, 0.0, 0.0, 0.0));
+    EmitVertex();
+    level = personLevel[0];
+    gl_Position = gl_ModelViewProjectionMatrix * (corner + vec4(0.0, personSize[0].y, 0.0, 0.0));
+    EmitVertex();
+    level = personLevel[0];
+    gl_Position = gl_ModelViewProjectionMatrix * (corner + vec4(personSize[0], 0.0, 0.0));
+    EmitVertex();
+    EndPrimitive();
+}
+)";
+
+// The ramp of wetnessColor: brown dry to light blue at the last level
+const char* PEOPLE_FRAGMENT_SHADER = R"(
+#version 150 compatibility
+uniform float lastLevel;
+flat in float level;
+
+void main() {
+    vec3 dry = vec3(139.0, 69.0, 19.0) / 255.0;
+    vec3 soaked = vec3(173.0, 216.0, 230.0) / 255.0;
+    gl_FragColor = vec4(mix(dry, soaked, floor(level + 0.5) / lastLevel), 1.0);
+}
+)";
+
+} // namespace
+
+void appendPerson(sf::VertexArray& instances, sf::Vector2f centre, sf::Vector2f size, float wetness, float maxWetness) {
+    instances.append(sf::Vertex{ centre, sf::Color(0, 0, 0, static_cast<std::uint8_t>(wetnessLevel(wetness, maxWetness))), size });
+}
+
+void appendCrowd(sf::VertexArray& instances, const Crowd& crowd, float maxWetness, float lag) {
+    for (std::size_t i = 0; i < crowd.size(); ++i) {
+        appendPerson(instances, sf::Vector2f(crowd.x[i] - crowd.vx[i] * lag, crowd.y[i]), sf::Vector2f(crowd.width[i], crowd.height[i]),
+            crowd.wetness[i], maxWetness);
+    }
+}
+
+PeopleBatch::PeopleBatch() : quads(QUAD_PRIMITIVE), checkedGpu(false) {}
+
+void PeopleBatch::draw(sf::RenderTarget& target, const sf::VertexArray& instances) {
+    if (!checkedGpu) {
+        checkedGpu = true;
+        if (sf::Shader::isAvailable() && sf::Shader::isGeometryAvailable()) {
+            compileShaderInBackground(compile, PEOPLE_VERTEX_SHADER, PEOPLE_GEOMETRY_SHADER, PEOPLE_FRAGMENT_SHADER);
+        }
+    }
+    if (compile.pending()) {
+        shader = compile.take();
+        if (shader) {
+            shader->setUniform("lastLevel", static_cast<float>(WETNESS_COLOR_LEVELS - 1));
+        }
+    }
+    const std::size_t count = instances.getVertexCount();
+    if (count == 0) {
+        return;
+    }
+    if (shader) {
+        target.draw(instances, shader.get());
+        return;
+    }
+
+    quads.resize(count * QUAD_VERTICES);
+    for (std::size_t i = 0; i < count; ++i) {
+        const sf::Vertex& instance = instances[i];
+        const float left = instance.position.x - instance.texCoords.x / 2.0f;
+        const float top = instance.position.y - instance.texCoords.y / 2.0f;
+        const float right = left + instance.texCoords.x;
+        const float bottom = top + instance.texCoords.y;
+        const sf::Color color = wetnessColor(instance.color.a);
+        writeQuad(&quads[i * QUAD_VERTICES], sf::Vertex{ { left, top }, color }, sf::Vertex{ { right, top }, color },
+            sf::Vertex{ { right, bottom }, color }, sf::Vertex{ { left, bottom }, color });
+    }
+    target.draw(quads);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <memory>
+
+#include "Startup.h"
+
+class Crowd;
+
+// Appends a person as one instance: a point at their centre carrying their size in texCoords
+// and their wetness level, see wetnessLevel, in the colour's alpha. instances are points
+void appendPerson(sf::VertexArray& instances, sf::Vector2f centre, sf::Vector2f size, float wetness, float maxWetness);
+
+// Appends every pedestrian of crowd, drawn lag seconds behind where they are, as a Person is
+// drawn between updates
+void appendCrowd(sf::VertexArray& instances, const Crowd& crowd, float maxWetness, float lag);
+
+// Draws any number of people in one draw call from their instances. A geometry shader builds
+// each one's rectangle and the fragment shader tints it from brown to light blue by the level,
+// the ramp PersonSprite sets its colour from, so the CPU writes a vertex per person and never
+// works out a colour. The shader compiles in the background from the first draw; until it's
+// in, and where geometry shaders aren't available, the rectangles are built as quads instead
+class PeopleBatch {
+public:
+    PeopleBatch();
+
+    void draw(sf::RenderTarget& target, const sf::VertexArray& instances);
+
+private:
+    std::unique_ptr<sf::Shader> shader;
+    Deferred<sf::Shader> compile;
+    sf::VertexArray quads; // The fallback's
+    bool checkedGpu;
+};
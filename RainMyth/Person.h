@@ -0,0 +1,215 @@
+#pragma once
+
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "Constants.h"
+#include "SurfaceWetness.h"
+#include "Trajectory.h"
+
+// Everything a Person carries from one update to the next, as plain data for snapshots
+struct PersonState {
+    double wetness;
+    float x;          // Centre
+    float y;
+    float width;
+    float height;
+    float previousX;  // Centre before the last update
+    float previousY;
+    float targetX;
+    float targetY;
+    float speed;
+    float maxWetness;
+    SurfaceWetness surfaces;
+    std::uint32_t moving;
+};
+
+// A class to represent the person in the simulation. Only what the simulation needs: drawing
+// them is PersonSprite's job, in the front end
+class Person {
+public:
+    Person(sf::Vector2f position, sf::Vector2f size = sf::Vector2f(PERSON_WIDTH, PERSON_HEIGHT))
+        : position(position), size(size), previousPosition(position), currentSpeed(0.0f), totalWetness(0.0), isMoving(false),
+          maxWetness(MAX_WETNESS), surfaces(), trajectory(nullptr), trajectoryTime(0.0f) {}
+
+    // Starts movement towards a target position
+    void startMove(sf::Vector2f target, float speed) {
+        if (!isMoving) {
+            targetPosition = target;
+            currentSpeed = speed;
+            isMoving = true;
+        }
+    }
+
+    // Changes the pace of the move under way. Routes keep their own timing
+    void setSpeed(float speed) {
+        currentSpeed = speed;
+    }
+
+    // Follows a whole route from its start instead, until it ends. The route isn't copied, so it
+    // has to outlive the person's use of it
+    void startTrajectory(const Trajectory& route) {
+        trajectory = &route;
+        trajectoryTime = 0.0f;
+        isMoving = true;
+        position = route.positionAt(0.0f);
+        previousPosition = position;
+    }
+
+    // Resets the person's wetness and position
+    void reset(sf::Vector2f position) {
+        totalWetness = 0.0;
+        surfaces = SurfaceWetness();
+        isMoving = false;
+        trajectory = nullptr;
+        this->position = position;
+        previousPosition = position;
+    }
+
+    void update(float deltaTime) {
+        previousPosition = position;
+        if (trajectory != nullptr) {
+            trajectoryTime += deltaTime;
+            position = trajectory->positionAt(trajectoryTime);
+            if (trajectoryTime >= trajectory->duration()) {
+                isMoving = false;
+                trajectory = nullptr;
+            }
+        }
+        else if (isMoving) {
+            // Calculate the direction vector
+            sf::Vector2f direction = targetPosition - position;
+
+            // Stop if we are close to the target, or would reach it this step. Checking the
+            // step's length too keeps long steps from overshooting and swinging back and forth
+            float distance = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+            if (distance < 5.0f || distance <= currentSpeed * deltaTime) { // Arbitrary small threshold
+                isMoving = false;
+                position = targetPosition;
+            }
+            else {
+                // Normalize the direction vector and move
+                direction /= distance;
+                position += direction * currentSpeed * deltaTime;
+            }
+        }
+    }
+
+    // Resizes the person about their centre
+    void setSize(sf::Vector2f size) {
+        this->size = size;
+    }
+
+    // Wetness at which the person is drawn fully soaked
+    void setMaxWetness(float wetness) {
+        maxWetness = std::max(wetness, 1e-3f);
+    }
+
+    float getMaxWetness() const {
+        return maxWetness;
+    }
+
+    // True while the person is still on the way to their target
+    bool isMovingToTarget() const {
+        return isMoving;
+    }
+
+    // Accumulates wetness from a raindrop, or a step's worth. The total is kept in double: a
+    // long run adds hundreds of thousands of areas of a few pixels each, and a float total
+    // that large would round every one of them, by an amount that depends on the order they
+    // come in
+    void addWetness(float area) {
+        totalWetness += area;
+    }
+
+    // Accumulates the split of the same wetness by the surface that caught it. Kept apart from
+    // the total so the total stays exactly what the hit test summed
+    void addSurfaceWetness(const SurfaceWetness& split) {
+        surfaces += split;
+    }
+
+    const SurfaceWetness& getSurfaceWetness() const {
+        return surfaces;
+    }
+
+    // Centre of the person
+    sf::Vector2f getPosition() const {
+        return position;
+    }
+
+    // Centre of the person alpha of the way from their position before the last update to their
+    // current one, where they're drawn so movement stays smooth when physics runs at a different
+    // rate than the display
+    sf::Vector2f getDrawnPosition(float alpha) const {
+        return position + (previousPosition - position) * (1.0f - alpha);
+    }
+
+    sf::Vector2f getSize() const {
+        return size;
+    }
+
+    // Returns the person's bounding box for collision detection
+    sf::FloatRect getBounds() const {
+        return sf::FloatRect(position - size / 2.0f, size);
+    }
+
+    // Returns the total accumulated wetness
+    float getWetness() const {
+        return static_cast<float>(totalWetness);
+    }
+
+    PersonState getState() const {
+        const PersonState state = { totalWetness, position.x, position.y, size.x, size.y,
+            previousPosition.x, previousPosition.y, targetPosition.x, targetPosition.y, currentSpeed,
+            maxWetness, surfaces, isMoving ? 1u : 0u };
+        return state;
+    }
+
+    // Puts the person back exactly as getState found them, except for a route they were following
+    void setState(const PersonState& state) {
+        setSize(sf::Vector2f(state.width, state.height));
+        position = sf::Vector2f(state.x, state.y);
+        previousPosition = sf::Vector2f(state.previousX, state.previousY);
+        targetPosition = sf::Vector2f(state.targetX, state.targetY);
+        currentSpeed = state.speed;
+        totalWetness = state.wetness;
+        setMaxWetness(state.maxWetness);
+        surfaces = state.surfaces;
+        isMoving = state.moving != 0;
+        trajectory = nullptr;
+    }
+
+private:
+    sf::Vector2f position; // Centre
+    sf::Vector2f size;
+    sf::Vector2f targetPosition;
+    sf::Vector2f previousPosition;
+    float currentSpeed;
+    double totalWetness;
+    bool isMoving;
+    float maxWetness;
+    SurfaceWetness surfaces;
+    const Trajectory* trajectory; // Route being followed, if any, and how far into it
+    float trajectoryTime;
+};
+
+// Where a walk or run starts and ends: above the centre of the start and end platforms
+inline sf::Vector2f startPoint(sf::Vector2u windowSize) {
+    return sf::Vector2f(windowSize.x * START_ACROSS, windowSize.y - PERSON_RISE);
+}
+
+inline sf::Vector2f endPoint(sf::Vector2u windowSize) {
+    return sf::Vector2f(windowSize.x * END_ACROSS, windowSize.y - PERSON_RISE);
+}
+
+// Everything a person of the given size covers on the way from startPoint to endPoint. The
+// points are where the person's centre goes
+inline sf::FloatRect travelCorridor(sf::Vector2u windowSize, sf::Vector2f size) {
+    const sf::Vector2f start = startPoint(windowSize);
+    const sf::Vector2f end = endPoint(windowSize);
+    return sf::FloatRect(sf::Vector2f(std::min(start.x, end.x) - size.x / 2.0f, std::min(start.y, end.y) - size.y / 2.0f),
+        sf::Vector2f(std::abs(end.x - start.x) + size.x, std::abs(end.y - start.y) + size.y));
+}
@@ -0,0 +1,47 @@
+#include "PersonSprite.h"
+
+#include <algorithm>
+#include <cstdint>
+
+int wetnessLevel(float wetness, float maxWetness) {
+    return static_cast<int>(std::min(wetness, maxWetness) / maxWetness * (WETNESS_COLOR_LEVELS - 1));
+}
+
+sf::Color wetnessColor(int level) {
+    // Linearly interpolate between brown and light blue based on wetness
+    const float normalizedWetness = level / static_cast<float>(WETNESS_COLOR_LEVELS - 1);
+    std::uint8_t red = static_cast<std::uint8_t>(139 + normalizedWetness * (173 - 139));
+    std::uint8_t green = static_cast<std::uint8_t>(69 + normalizedWetness * (216 - 69));
+    std::uint8_t blue = static_cast<std::uint8_t>(19 + normalizedWetness * (230 - 19));
+    return sf::Color(red, green, blue);
+}
+
+PersonSprite::PersonSprite() : colorLevel(0) {
+    shape.setFillColor(sf::Color(139, 69, 19)); // Brown
+}
+
+void PersonSprite::setTexture(const sf::Texture* texture, const sf::IntRect& rect) {
+    shape.setTexture(texture);
+    shape.setTextureRect(rect);
+}
+
+void PersonSprite::draw(sf::RenderTarget& target, const Person& person, float alpha) {
+    // Resizing rebuilds the shape's points, so only when the person's size changed
+    const sf::Vector2f size = person.getSize();
+    if (size != shape.getSize()) {
+        shape.setSize(size);
+        shape.setOrigin(size / 2.0f);
+    }
+    shape.setPosition(person.getDrawnPosition(alpha));
+    updateColor(person);
+    target.draw(shape);
+}
+
+void PersonSprite::updateColor(const Person& person) {
+    const int level = wetnessLevel(person.getWetness(), person.getMaxWetness());
+    if (level == colorLevel) {
+        return;
+    }
+    colorLevel = level;
+    shape.setFillColor(wetnessColor(level));
+}
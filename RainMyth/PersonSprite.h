@@ -0,0 +1,35 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include "Person.h"
+
+// Which of the WETNESS_COLOR_LEVELS shades wetness out of maxWetness is drawn in, 0 when dry
+// to the last at maxWetness and past it
+int wetnessLevel(float wetness, float maxWetness);
+
+// The shade of level, brown for 0 to light blue for the last. PeopleBatch's shader has the same ramp
+sf::Color wetnessColor(int level);
+
+// How a Person looks: a rectangle at their drawn position, tinted from brown to light blue as
+// they get wetter, optionally textured. Kept out of Person so the simulation needs no graphics
+class PersonSprite {
+public:
+    PersonSprite();
+
+    // Draws with the part rect of texture, tinted by the wetness colour, or plain with nullptr.
+    // The texture has to outlive the sprite
+    void setTexture(const sf::Texture* texture, const sf::IntRect& rect);
+
+    // Draws person alpha of the way from their position before the last update to their
+    // current one, see Person::getDrawnPosition
+    void draw(sf::RenderTarget& target, const Person& person, float alpha);
+
+private:
+    sf::RectangleShape shape;
+    int colorLevel; // Wetness level the shape's colour was last set for
+
+    // Setting the fill colour rewrites every vertex of the shape, so it's only done when the
+    // wetness moves to another level
+    void updateColor(const Person& person);
+};
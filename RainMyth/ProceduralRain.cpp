@@ -0,0 +1,80 @@
+#include "ProceduralRain.h"
+
+#include <algorithm>
+
+ProceduralRain::ProceduralRain(sf::Vector2u windowSize, const RainConfig& config, const Scene& scene)
+    : windowSize(windowSize), rng(config.seed), spawnRate(config.spawnRate), spawnTop(-50.0f), minSize(config.minSize),
+      maxSize(config.maxSize), sizes(config), speeds(config.minSize, config.maxSize), shadowTop(scene.rainShadow(windowSize)) {}
+
+void ProceduralRain::setSpawnTop(float top) {
+    spawnTop = top;
+}
+
+float ProceduralRain::spawnTopAbove(float left, float right) const {
+    float highest = static_cast<float>(windowSize.y);
+    for (std::size_t column = columnOf(left); column <= columnOf(right); ++column) {
+        highest = std::min(highest, shadowTop[column]);
+    }
+    return highest - RainField::heightOf(maxSize);
+}
+
+float ProceduralRain::lifetime() const {
+    return (static_cast<float>(windowSize.y) - (spawnTop - 50.0f)) / std::max(speeds.lookup(minSize), 1e-3f);
+}
+
+// Only drops spawned within a lifetime before to can touch anyone by then, and only in the
+// columns the box covers on the way, widened by the widest drop, whose left edge is its x
+float ProceduralRain::catches(const PersonPath& path, float from, float to, SurfaceWetness* surfaces) const {
+    const float left = std::min(path.leftAt(from), path.leftAt(to)) - maxSize;
+    const float right = std::max(path.leftAt(from), path.leftAt(to)) + path.width;
+    const float columns = static_cast<float>(windowSize.x) / PROCEDURAL_CELL_WIDTH;
+    const std::int64_t firstColumn = static_cast<std::int64_t>(std::floor(std::max(left, 0.0f) / PROCEDURAL_CELL_WIDTH));
+    const std::int64_t lastColumn = static_cast<std::int64_t>(std::min(std::floor(right / PROCEDURAL_CELL_WIDTH), std::ceil(columns) - 1.0f));
+    const std::int64_t firstSlot = static_cast<std::int64_t>(std::floor((from - lifetime()) / PROCEDURAL_CELL_SECONDS));
+    const std::int64_t lastSlot = static_cast<std::int64_t>(std::floor(to / PROCEDURAL_CELL_SECONDS));
+    const float start = std::max(from, path.startTime);
+    const float end = std::min(to, path.arrivalTime());
+
+    float wetness = 0.0f;
+    forEachSpawn(firstColumn, lastColumn, firstSlot, lastSlot, [&](const Drop& drop) {
+        if (drop.spawnTime >= to) {
+            return;
+        }
+        // As EventRain schedules its catches: the drop can touch them from when its bottom edge
+        // reaches their top until its top passes their feet or it lands, whichever is first
+        const float height = RainField::heightOf(drop.size);
+        const float landing = drop.spawnTime + std::max(shadowTop[columnOf(drop.x)] - drop.y, 0.0f) / drop.vy;
+        const float reach = drop.spawnTime + std::max(path.top - height - drop.y, 0.0f) / drop.vy;
+        const float pass = drop.spawnTime + (path.top + path.height - drop.y) / drop.vy;
+        float caughtAt = 0.0f;
+        if (path.firstOverlap(drop.x, drop.x + drop.size, reach, std::min(pass, landing), caughtAt) && caughtAt >= start && caughtAt <= end
+            && caughtAt < to) {
+            const float area = RainField::areaOf(drop.size);
+            wetness += area;
+            if (surfaces) {
+                surfaces->add(caughtAt > reach ? SURFACE_FRONT : SURFACE_TOP, area);
+            }
+        }
+    });
+    return wetness;
+}
+
+void ProceduralRain::positionsAt(float time, float left, float right, RainField& out) const {
+    out.clear();
+    const float columns = static_cast<float>(windowSize.x) / PROCEDURAL_CELL_WIDTH;
+    const std::int64_t firstColumn = static_cast<std::int64_t>(std::floor(std::max(left, 0.0f) / PROCEDURAL_CELL_WIDTH));
+    const std::int64_t lastColumn = static_cast<std::int64_t>(std::min(std::floor(right / PROCEDURAL_CELL_WIDTH), std::ceil(columns) - 1.0f));
+    const std::int64_t firstSlot = static_cast<std::int64_t>(std::floor((time - lifetime()) / PROCEDURAL_CELL_SECONDS));
+    const std::int64_t lastSlot = static_cast<std::int64_t>(std::floor(time / PROCEDURAL_CELL_SECONDS));
+    forEachSpawn(firstColumn, lastColumn, firstSlot, lastSlot, [&](const Drop& drop) {
+        const float y = drop.y + drop.vy * (time - drop.spawnTime);
+        if (drop.spawnTime <= time && drop.x >= left && drop.x < right && y <= shadowTop[columnOf(drop.x)]) {
+            out.add(drop.x, y, drop.vy, drop.size);
+        }
+    });
+}
+
+std::size_t ProceduralRain::columnOf(float x) const {
+    const float column = std::min(std::max(x, 0.0f), static_cast<float>(shadowTop.size() - 1));
+    return static_cast<std::size_t>(column);
+}
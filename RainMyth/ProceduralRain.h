@@ -0,0 +1,106 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Constants.h"
+#include "DropSizes.h"
+#include "EventRain.h"
+#include "RainConfig.h"
+#include "RainField.h"
+#include "Rng.h"
+#include "Scene.h"
+#include "SurfaceWetness.h"
+#include "TerminalVelocity.h"
+
+// Rain that is never stored. The sky is cut into cells PROCEDURAL_CELL_WIDTH pixels wide and
+// PROCEDURAL_CELL_SECONDS long, and the drops spawned in a cell, how many and where, when and
+// how big, are drawn from a counter-based generator keyed by the cell alone. Any cell can be
+// regenerated at any time in any order and comes out the same, so a query only visits the
+// cells that can hold drops near it: a collision query the columns someone crosses over the
+// time rain takes to fall, a drawing query the columns on screen. Memory doesn't grow with the
+// rain at all, however heavy.
+//
+// A drop falls in a straight line at its terminal speed from where it spawned, as in
+// EventRain, so its contact with a person on a known path is solved in closed form, with the
+// same rules: it counts once, between their setting off and arriving, and it lands at the
+// scene's rain shadow. Rain is stationary, falling since forever, so there's no warm-up. The
+// spawn band is the whole screen; the rate per pixel is the config's. Calm air only
+class ProceduralRain {
+public:
+    ProceduralRain(sf::Vector2u windowSize, const RainConfig& config, const Scene& scene);
+
+    // As RainSystem's namesakes
+    void setSpawnTop(float top);
+    float spawnTopAbove(float left, float right) const;
+
+    // The area of the drops that first touch the person on path at times [from, to), added to
+    // surfaces under the face they came in by if given
+    float catches(const PersonPath& path, float from, float to, SurfaceWetness* surfaces = nullptr) const;
+
+    // Puts every drop within columns [left, right) in the air at time into out in place of what
+    // it held, where its fall has taken it by then. Drops that don't fit out are left out
+    void positionsAt(float time, float left, float right, RainField& out) const;
+
+private:
+    struct Drop {
+        float x;
+        float y;         // Top edge at spawnTime
+        float vy;
+        float size;
+        float spawnTime;
+    };
+
+    sf::Vector2u windowSize;
+    CounterRng rng;
+    float spawnRate;
+    float spawnTop;
+    float minSize;
+    float maxSize;
+    DropSizeTable sizes;
+    TerminalVelocityTable speeds;
+    std::vector<float> shadowTop;
+
+    // Longest any drop is in the air, from the top of the spawn strip to the ground at the slowest speed
+    float lifetime() const;
+
+    // Calls visit(drop) for every drop spawned in columns [firstColumn, lastColumn] of cells and
+    // time slots [firstSlot, lastSlot]. The count in a cell is the expected count rounded down,
+    // plus one with the remainder's probability, drawn from the cell's own counter
+    template <typename Visit>
+    void forEachSpawn(std::int64_t firstColumn, std::int64_t lastColumn, std::int64_t firstSlot, std::int64_t lastSlot, Visit&& visit) const {
+        const float expected = spawnRate * PROCEDURAL_CELL_WIDTH * PROCEDURAL_CELL_SECONDS;
+        const float whole = std::floor(expected);
+        for (std::int64_t slot = firstSlot; slot <= lastSlot; ++slot) {
+            for (std::int64_t column = std::max<std::int64_t>(firstColumn, 0); column <= lastColumn; ++column) {
+                const std::uint64_t stream = (static_cast<std::uint64_t>(slot) << 32) | static_cast<std::uint32_t>(column);
+                std::uint32_t words[4];
+                rng.generate(stream, ~0u, words);
+                const std::uint32_t count = static_cast<std::uint32_t>(whole) + (toUnit(words[0]) < expected - whole ? 1u : 0u);
+                for (std::uint32_t i = 0; i < count; ++i) {
+                    rng.generate(stream, i, words);
+                    Drop drop;
+                    drop.x = (column + toUnit(words[0])) * PROCEDURAL_CELL_WIDTH;
+                    if (drop.x >= windowSize.x) {
+                        continue; // The last column of cells hangs off the screen
+                    }
+                    drop.spawnTime = (slot + toUnit(words[1])) * PROCEDURAL_CELL_SECONDS;
+                    drop.y = spawnTop - 50.0f + 50.0f * toUnit(words[2]);
+                    drop.size = sizes.lookup(toUnit(words[3]));
+                    drop.vy = std::max(speeds.lookup(drop.size), 1e-3f);
+                    visit(drop);
+                }
+            }
+        }
+    }
+
+    static float toUnit(std::uint32_t word) {
+        return static_cast<float>(word >> 8) * (1.0f / 16777216.0f);
+    }
+
+    std::size_t columnOf(float x) const;
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+
+#include "CycleTimer.h"
+
+// Parts of a frame the HUD breaks the frame time into
+enum ProfilePhase {
+    PHASE_UPDATE,    // Every rainSystem.update of the frame, collision included
+    PHASE_COLLISION, // Drop-collider tests inside update, summed over workers
+    PHASE_BUILD,     // Writing the rain batch
+    PHASE_DRAW,      // Issuing draw calls
+    PHASE_DISPLAY,   // window.display, including the wait FramePacer or vsync holds each frame to and the housekeeping done in it
+    PHASE_COUNT
+};
+
+inline const char* phaseName(ProfilePhase phase) {
+    static const char* const names[PHASE_COUNT] = { "Update", "Collision", "Build", "Draw", "Display" };
+    return names[phase];
+}
+
+// Collects per-phase times over a frame and keeps a smoothed average of each, so the overlay
+// stays readable instead of flickering with every frame's noise
+class Profiler {
+public:
+    Profiler() {
+        for (int p = 0; p < PHASE_COUNT; ++p) {
+            current[p] = 0.0f;
+            average[p] = 0.0f;
+        }
+    }
+
+    // Adds seconds to a phase of the frame in progress. A phase may be timed several times per frame
+    void add(ProfilePhase phase, float seconds) {
+        current[phase] += seconds;
+    }
+
+    // Seconds added to a phase so far this frame
+    float frameSeconds(ProfilePhase phase) const {
+        return current[phase];
+    }
+
+    // Folds the finished frame into the averages and starts a new one
+    void endFrame(float frameSeconds) {
+        for (int p = 0; p < PHASE_COUNT; ++p) {
+            average[p] += (current[p] - average[p]) * SMOOTHING;
+            current[p] = 0.0f;
+        }
+        averageFrame += (frameSeconds - averageFrame) * SMOOTHING;
+    }
+
+    float milliseconds(ProfilePhase phase) const {
+        return average[phase] * 1000.0f;
+    }
+
+    float frameMilliseconds() const {
+        return averageFrame * 1000.0f;
+    }
+
+private:
+    static constexpr float SMOOTHING = 0.05f; // Weight of the newest frame, about a 20 frame window
+
+    float current[PHASE_COUNT];
+    float average[PHASE_COUNT];
+    float averageFrame = 0.0f;
+};
+
+// Times its own lifetime into one phase of a Profiler, and records it as a span for the trace
+class ScopedTimer {
+public:
+    ScopedTimer(Profiler& profiler, ProfilePhase phase)
+        : profiler(profiler), phase(phase), begin(cycleCount()) {}
+
+    ~ScopedTimer() {
+        const std::uint64_t end = cycleCount();
+        profiler.add(phase, cycleSeconds(end - begin));
+        recordSpan(phaseName(phase), begin, end);
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Profiler& profiler;
+    ProfilePhase phase;
+    std::uint64_t begin;
+};
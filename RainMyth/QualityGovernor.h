@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+
+// Trades visual detail for frame time. Every ADJUST_FRAMES frames it looks at the smoothed
+// frame time and moves a single quality level between MIN_LEVEL and 1: down by a tenth when
+// frames run over the target, back up by a twentieth when there's clear headroom. The frame
+// limiter makes every frame under target look the same length, so headroom is judged on the
+// time spent working, the frame less the wait in display. The steps are uneven on purpose,
+// backing off fast and recovering slowly, so the level doesn't oscillate around the target.
+//
+// The caller scales what only affects the picture by the level: drop density away from the
+// people, streak length, the splash budget and the size adaptive rendering takes the drops
+// to be. Nothing that changes the wetness
+class QualityGovernor {
+public:
+    explicit QualityGovernor(float targetMilliseconds)
+        : target(targetMilliseconds), level(1.0f), frames(0) {}
+
+    bool isEnabled() const {
+        return target > 0.0f;
+    }
+
+    // Feeds one frame's smoothed times in. Returns true when the level changed
+    bool update(float frameMilliseconds, float workMilliseconds) {
+        if (!isEnabled() || ++frames < ADJUST_FRAMES) {
+            return false;
+        }
+        frames = 0;
+
+        const float previous = level;
+        if (frameMilliseconds > target * 1.1f) {
+            level = std::max(level * 0.9f, MIN_LEVEL);
+        }
+        else if (workMilliseconds < target * 0.7f) {
+            level = std::min(level * 1.05f, 1.0f);
+        }
+        return level != previous;
+    }
+
+    float getLevel() const {
+        return level;
+    }
+
+private:
+    static constexpr int ADJUST_FRAMES = 15;  // Frames between adjustments, so each one shows in the average
+    static constexpr float MIN_LEVEL = 0.1f;
+
+    float target;
+    float level;
+    int frames;
+};
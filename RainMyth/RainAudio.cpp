@@ -0,0 +1,195 @@
+#include "RainAudio.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const unsigned AUDIO_SAMPLE_RATE = 22050;
+const std::size_t AMBIENCE_CHUNK = 1024;   // Samples the ambience synthesizes at a time, about 46 ms
+const float AMBIENCE_EASING = 20.0f;       // How fast the ambience follows a new landing rate, per second: a 50 ms time constant
+const float CRACKLES_PER_LANDING = 0.05f;  // Crackles in the ambience per drop landing
+const float AMBIENCE_FULL_RATE = 20000.0f; // Landings per second the ambience is at full volume for
+const float AUDIO_SMOOTHING = 0.5f;        // Seconds the ambience takes to follow a change in the landing rate
+const float PLIPS_PER_LANDING = 0.002f;    // Impact sounds per drop landing on the scene or the ground
+const float MAX_PLIPS_PER_SECOND = 40.0f;
+const float PATTERS_PER_WETNESS = 0.01f;   // Impact sounds per unit of wetness the person catches
+const float MAX_PATTERS_PER_SECOND = 20.0f;
+const float PI = 3.14159265f;
+
+std::int16_t toSample(float value) {
+    return static_cast<std::int16_t>(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f);
+}
+
+// A drop on something hard: a click, then a ring at pitch falling a little as it dies away
+std::vector<std::int16_t> synthesizePlip(Rng& rng, float pitch) {
+    const std::size_t length = static_cast<std::size_t>(0.08f * AUDIO_SAMPLE_RATE);
+    std::vector<std::int16_t> samples(length);
+    float phase = 0.0f;
+    for (std::size_t i = 0; i < length; ++i) {
+        const float t = i / static_cast<float>(AUDIO_SAMPLE_RATE);
+        phase += 2.0f * PI * pitch * (1.0f - 2.0f * t) / AUDIO_SAMPLE_RATE;
+        const float ring = std::sin(phase) * std::exp(-t / 0.015f);
+        const float click = t < 0.002f ? rng.uniform(-1.0f, 1.0f) * (1.0f - t / 0.002f) : 0.0f;
+        samples[i] = toSample(0.6f * ring + 0.4f * click);
+    }
+    return samples;
+}
+
+// A drop on cloth: a short dull thud of low-passed noise
+std::vector<std::int16_t> synthesizePatter(Rng& rng) {
+    const std::size_t length = static_cast<std::size_t>(0.05f * AUDIO_SAMPLE_RATE);
+    std::vector<std::int16_t> samples(length);
+    float low = 0.0f;
+    for (std::size_t i = 0; i < length; ++i) {
+        const float t = i / static_cast<float>(AUDIO_SAMPLE_RATE);
+        low += (rng.uniform(-1.0f, 1.0f) - low) * 0.3f;
+        samples[i] = toSample(2.0f * low * std::exp(-t / 0.01f));
+    }
+    return samples;
+}
+
+void loadBuffer(sf::SoundBuffer& buffer, const std::vector<std::int16_t>& samples) {
+#if SFML_VERSION_MAJOR >= 3
+    (void)buffer.loadFromSamples(samples.data(), samples.size(), 1, AUDIO_SAMPLE_RATE, { sf::SoundChannel::Mono });
+#else
+    buffer.loadFromSamples(samples.data(), samples.size(), 1, AUDIO_SAMPLE_RATE);
+#endif
+}
+
+} // namespace
+
+void RainSoundEvents::clear() {
+    landings = 0;
+    std::fill(zoneImpacts, zoneImpacts + AUDIO_ZONES, 0u);
+    std::fill(zoneHeight, zoneHeight + AUDIO_ZONES, 0.0f);
+    personCatch = 0.0f;
+}
+
+void RainSoundEvents::addImpacts(const std::vector<RainImpact>& impacts, float width) {
+    for (const RainImpact& impact : impacts) {
+        const float zone = std::min(std::max(impact.x / width * AUDIO_ZONES, 0.0f), static_cast<float>(AUDIO_ZONES - 1));
+        const std::size_t i = static_cast<std::size_t>(zone);
+        ++zoneImpacts[i];
+        zoneHeight[i] += impact.y;
+    }
+}
+
+RainNoiseStream::RainNoiseStream()
+    : landingRate(0.0f), chunk(AMBIENCE_CHUNK), rng(0x484953ull), level(0.0f), crackleLevel(0.0f), hiss(0.0f), crackle(0.0f) {
+#if SFML_VERSION_MAJOR >= 3
+    initialize(1, AUDIO_SAMPLE_RATE, { sf::SoundChannel::Mono });
+#else
+    initialize(1, AUDIO_SAMPLE_RATE);
+#endif
+}
+
+RainNoiseStream::~RainNoiseStream() {
+    stop(); // The audio thread reads the members, so it has to be done before they go
+}
+
+void RainNoiseStream::setLandingRate(float rate) {
+    landingRate.store(rate, std::memory_order_relaxed);
+}
+
+bool RainNoiseStream::onGetData(Chunk& data) {
+    const float rate = landingRate.load(std::memory_order_relaxed);
+    const float targetLevel = std::min(std::sqrt(rate / AMBIENCE_FULL_RATE), 1.0f);
+    const float targetCrackles = std::min(rate * CRACKLES_PER_LANDING / AUDIO_SAMPLE_RATE, 1.0f);
+    const float easing = AMBIENCE_EASING / AUDIO_SAMPLE_RATE;
+    for (std::int16_t& sample : chunk) {
+        level += (targetLevel - level) * easing;
+        crackleLevel += (targetCrackles - crackleLevel) * easing;
+        const float white = rng.uniform(-1.0f, 1.0f);
+        hiss += (white - hiss) * 0.15f;
+        crackle *= 0.9f;
+        if (rng.uniform() < crackleLevel) {
+            crackle += rng.uniform(-0.5f, 0.5f);
+        }
+        sample = toSample(level * (0.7f * hiss + 0.15f * white + crackle));
+    }
+    data.samples = chunk.data();
+    data.sampleCount = chunk.size();
+    return true; // Rain doesn't end
+}
+
+RainAudio::RainAudio(sf::Vector2u world, float volume)
+    : world(static_cast<float>(world.x), static_cast<float>(world.y)), volume(volume), rng(0x524149ull),
+      now(0.0), landingRate(0.0f), plipCarry(0.0f), patterCarry(0.0f) {
+    for (std::size_t i = 0; i < PLIP_VARIANTS; ++i) {
+        loadBuffer(plipBuffers[i], synthesizePlip(rng, 1500.0f + 700.0f * i));
+    }
+    loadBuffer(patterBuffer, synthesizePatter(rng));
+
+    ambience.setRelativeToListener(true);
+    ambience.setVolume(volume);
+    ambience.play();
+    // SFML 3 sounds can't be made without a buffer, so they start out on the patter's
+    voices.reserve(AUDIO_VOICES);
+    for (std::size_t i = 0; i < AUDIO_VOICES; ++i) {
+        // Heard from straight ahead at one unit, left to right, never quieter for distance
+        voices.emplace_back(patterBuffer);
+        voices[i].setRelativeToListener(true);
+        voices[i].setAttenuation(0.0f);
+        voiceStarted[i] = 0.0;
+    }
+}
+
+void RainAudio::update(const RainSoundEvents& events, float frameSeconds, sf::Vector2f personCentre) {
+    if (frameSeconds <= 0.0f) {
+        return;
+    }
+    now += frameSeconds;
+
+    const float rate = events.landings / frameSeconds;
+    landingRate += (rate - landingRate) * std::min(frameSeconds / AUDIO_SMOOTHING, 1.0f);
+    ambience.setLandingRate(landingRate);
+
+    // Impact sounds on the scene, in the strips that impacts were recorded in, as many more
+    // often as they landed there. Without any recorded, anywhere along the ground
+    std::uint32_t recorded = 0;
+    for (std::size_t zone = 0; zone < AUDIO_ZONES; ++zone) {
+        recorded += events.zoneImpacts[zone];
+    }
+    plipCarry = std::min(plipCarry + events.landings * PLIPS_PER_LANDING, MAX_PLIPS_PER_SECOND * frameSeconds + 1.0f);
+    for (; plipCarry >= 1.0f; plipCarry -= 1.0f) {
+        std::size_t zone = static_cast<std::size_t>(rng.uniform() * AUDIO_ZONES);
+        float y = world.y;
+        if (recorded > 0) {
+            std::uint32_t pick = static_cast<std::uint32_t>(rng.uniform() * recorded);
+            for (zone = 0; zone + 1 < AUDIO_ZONES && pick >= events.zoneImpacts[zone]; ++zone) {
+                pick -= events.zoneImpacts[zone];
+            }
+            y = events.zoneHeight[zone] / std::max(events.zoneImpacts[zone], 1u);
+        }
+        const float x = (zone + rng.uniform()) / AUDIO_ZONES * world.x;
+        // Nearer the top of the world is further from the ground the listener stands on
+        play(plipBuffers[rng.next() % PLIP_VARIANTS], x, rng.uniform(0.3f, 1.0f) * (0.5f + 0.5f * y / world.y));
+    }
+
+    patterCarry = std::min(patterCarry + events.personCatch * PATTERS_PER_WETNESS, MAX_PATTERS_PER_SECOND * frameSeconds + 1.0f);
+    for (; patterCarry >= 1.0f; patterCarry -= 1.0f) {
+        play(patterBuffer, personCentre.x, rng.uniform(0.6f, 1.0f));
+    }
+}
+
+void RainAudio::play(const sf::SoundBuffer& buffer, float x, float gain) {
+    std::size_t voice = 0;
+    for (std::size_t i = 0; i < AUDIO_VOICES; ++i) {
+        if (voices[i].getStatus() == sf::Sound::Status::Stopped) {
+            voice = i;
+            break;
+        }
+        if (voiceStarted[i] < voiceStarted[voice]) {
+            voice = i;
+        }
+    }
+    sf::Sound& sound = voices[voice];
+    sound.stop();
+    sound.setBuffer(buffer);
+    sound.setPosition(sf::Vector3f(std::min(std::max(x / world.x, 0.0f), 1.0f) * 2.0f - 1.0f, 0.0f, -1.0f));
+    sound.setPitch(rng.uniform(0.85f, 1.2f));
+    sound.setVolume(volume * gain);
+    sound.play();
+    voiceStarted[voice] = now;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <SFML/Audio.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Constants.h"
+#include "Rng.h"
+#include "SplashSystem.h"
+
+// What the rain did over one frame's steps that can be heard, added up by the simulation job
+// and handed to RainAudio with the frame. Fixed size, so gathering it never allocates
+struct RainSoundEvents {
+    std::uint32_t landings;             // Drops that reached the scene or the ground
+    std::uint32_t zoneImpacts[AUDIO_ZONES]; // Recorded landings in each strip of the world
+    float zoneHeight[AUDIO_ZONES];      // Their heights summed, for where in the strip to put the sound
+    float personCatch;                  // Wetness the person caught
+
+    void clear();
+
+    // Counts impacts into the strips of a world width across
+    void addImpacts(const std::vector<RainImpact>& impacts, float width);
+};
+
+// The rain's hiss, synthesized as it plays on SFML's audio thread rather than looped from a
+// recording: low-passed noise for the far rain, with crackle from near drops as often as the
+// landing rate says, both scaled to it. The rate is the only thing shared with the thread
+// that sets it, through an atomic, so nothing waits on a lock; the stream eases towards each
+// new rate by the sample, so changes never click. Memory is one chunk, however long it plays
+class RainNoiseStream : public sf::SoundStream {
+public:
+    RainNoiseStream();
+    ~RainNoiseStream();
+
+    // Landings per second to sound like, from any thread
+    void setLandingRate(float rate);
+
+private:
+    std::atomic<float> landingRate;
+    std::vector<std::int16_t> chunk; // Only the audio thread touches these
+    Rng rng;
+    float level;                  // Loudness now, easing towards the landing rate's
+    float crackleLevel;           // How often drops crackle now, likewise
+    float hiss;                   // Low-pass filter state
+    float crackle;                // Ringing of the last crackle
+
+    bool onGetData(Chunk& data) override;
+    void onSeek(sf::Time) override {}
+};
+
+// Rain you can hear: streamed noise whose loudness follows the rate drops land at, and
+// short impact sounds on the scene and on the person, panned to where they happen. Impact
+// sounds play on a fixed pool of AUDIO_VOICES voices; when every voice is busy the one that
+// started longest ago is cut off for the new sound. Every buffer is synthesized up front, so
+// update() neither allocates nor touches a file
+class RainAudio {
+public:
+    // volume is out of 100
+    RainAudio(sf::Vector2u world, float volume);
+
+    // Plays what happened over a frame of frameSeconds, the person standing at personCentre
+    void update(const RainSoundEvents& events, float frameSeconds, sf::Vector2f personCentre);
+
+private:
+    static const std::size_t PLIP_VARIANTS = 4;
+
+    sf::Vector2f world;
+    float volume;
+    Rng rng;
+    sf::SoundBuffer plipBuffers[PLIP_VARIANTS]; // Drops on hard surfaces, higher and lower
+    sf::SoundBuffer patterBuffer;               // Drops on the person's clothes
+    RainNoiseStream ambience;
+    std::vector<sf::Sound> voices;              // AUDIO_VOICES of them
+    double voiceStarted[AUDIO_VOICES];          // When each voice last started, for choosing which to steal
+    double now;                                 // Seconds of audio played
+    float landingRate;                          // Smoothed landings per second, for the ambience
+    float plipCarry;                            // Fractions of a sound owed from earlier frames
+    float patterCarry;
+
+    // Starts buffer on a free voice, or the oldest busy one, panned to x, at gain of the volume
+    void play(const sf::SoundBuffer& buffer, float x, float gain);
+};
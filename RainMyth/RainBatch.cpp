@@ -0,0 +1,449 @@
+#include "RainBatch.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "SfmlCompat.h"
+#include "ShaderCompiler.h"
+#include "WorldView.h"
+
+namespace {
+
+// Points pass their drop's top-left corner as the position and its width in texCoords.x
+const char* POINT_VERTEX_SHADER = R"(
+#version 150 compatibility
+out float dropSize;
+
+void main() {
+    gl_Position = gl_Vertex;
+    dropSize = gl_MultiTexCoord0.x;
+}
+)";
+
+// Expands each point into the size x 2*size rectangle RainField::heightOf describes
+const char* POINT_GEOMETRY_SHADER = R"(
+#version 150 compatibility
+layout(points) in;
+layout(triangle_strip, max_vertices = 4) out;
+in float dropSize[];
+
+void main() {
+    vec4 corner = gl_in[0].gl_Position;
+    float width = dropSize[0];
+    float height = 2.0 * width;
+    gl_Position = gl_ModelViewProjectionMatrix * corner;
+    EmitVertex();
+    gl_Position = gl_ModelViewProjectionMatrix * (corner + vec4(width, 0.0, 0.0, 0.0));
+    EmitVertex();
+    gl_Position = gl_ModelViewProjectionMatrix * (corner + vec4(0.0, height, 0.0, 0.0));
+    EmitVertex();
+    gl_Position = gl_ModelViewProjectionMatrix * (corner + vec4(width, height, 0.0, 0.0));
+    EmitVertex();
+    EndPrimitive();
+}
+)";
+
+// Lays the low-resolution rain over the world, as bright as drops drawn straight onto black
+// would be. They add up offscreen, so where dense rain overlaps it can pass 1; above the knee
+// the curve bends that smoothly towards full brightness instead of clipping it
+const char* COMPOSITE_FRAGMENT_SHADER = R"(
+#version 120
+uniform sampler2D rain;
+const float knee = 0.8;
+
+void main() {
+    vec3 sum = texture2D(rain, gl_TexCoord[0].xy).rgb;
+    vec3 bent = knee + (1.0 - knee) * (1.0 - exp(-(sum - knee) / (1.0 - knee)));
+    gl_FragColor = vec4(mix(sum, bent, step(knee, sum)), 1.0);
+}
+)";
+
+const char* POINT_FRAGMENT_SHADER = R"(
+#version 150 compatibility
+uniform vec4 color;
+
+void main() {
+    gl_FragColor = color;
+}
+)";
+
+} // namespace
+
+// Support is queried on first use, so a batch that is never built never touches GL. The
+// buffer and shader are GL resources themselves, so they're only created once we know we'll use them
+void RainBatch::checkGpu() {
+    checkedGpu = true;
+    vertices.setPrimitiveType(mode == RENDER_STREAKS ? sf::PrimitiveType::Lines : QUAD_PRIMITIVE);
+    if (mode == RENDER_POINTS && sf::Shader::isAvailable() && sf::Shader::isGeometryAvailable()) {
+        if (backgroundCompile) {
+            compileShaderInBackground(pointCompile, POINT_VERTEX_SHADER, POINT_GEOMETRY_SHADER, POINT_FRAGMENT_SHADER);
+        }
+        else {
+            adoptPointShader(compileShader(POINT_VERTEX_SHADER, POINT_GEOMETRY_SHADER, POINT_FRAGMENT_SHADER));
+        }
+    }
+
+    stream.reset(new VertexStream());
+    if (stream->isAvailable()) {
+        return;
+    }
+    stream.reset();
+    useVertexBuffer();
+}
+
+// Switches to points, between builds, if shader compiled
+void RainBatch::adoptPointShader(std::unique_ptr<sf::Shader> shader) {
+    if (!shader) {
+        return;
+    }
+    pointShader = std::move(shader);
+    usePoints = true;
+    vertices.setPrimitiveType(sf::PrimitiveType::Points);
+    if (buffer) {
+        buffer->setPrimitiveType(sf::PrimitiveType::Points);
+    }
+}
+
+void RainBatch::adoptCompositeShader(std::unique_ptr<sf::Shader> shader) {
+    if (shader) {
+        compositeShader = std::move(shader);
+        compositeShader->setUniform("rain", sf::Shader::CurrentTexture);
+    }
+}
+
+// The next best way to upload the vertices, when there's no stream
+void RainBatch::useVertexBuffer() {
+    useBuffer = sf::VertexBuffer::isAvailable();
+    if (useBuffer) {
+        buffer.reset(new sf::VertexBuffer(vertices.getPrimitiveType(), sf::VertexBuffer::Usage::Stream));
+    }
+}
+
+void RainBatch::contextChanged() {
+    if (stream) {
+        stream.reset(new VertexStream());
+        if (!stream->isAvailable()) {
+            stream.reset();
+            useVertexBuffer();
+        }
+    }
+}
+
+MemoryUsage RainBatch::memoryUsage() const {
+    const std::size_t vertexBytes = sizeof(sf::Vertex);
+    MemoryUsage usage = { vertices.getVertexCount() * vertexBytes, stream || arena ? 0 : vertexCount * vertexBytes };
+    if (stream) {
+        usage += stream->memoryUsage();
+    }
+    if (buffer) {
+        const MemoryUsage gpu = { buffer->getVertexCount() * vertexBytes, useBuffer ? vertexCount * vertexBytes : 0 };
+        usage += gpu;
+    }
+    if (trails) {
+        const std::size_t bytes = static_cast<std::size_t>(trails->getSize().x) * trails->getSize().y * 4;
+        const MemoryUsage texture = { bytes, bytes };
+        usage += texture;
+    }
+    return usage;
+}
+
+void RainBatch::build(const RainField& drops, sf::Color color, float lag) {
+    if (!checkedGpu) {
+        checkGpu();
+    }
+    if (pointCompile.pending()) {
+        adoptPointShader(pointCompile.take());
+    }
+
+    // Room is reserved for every drop, and the count cut down to the ones written
+    const std::size_t count = drops.count();
+    if (usePoints) {
+        vertexCount = buildPoints(drops, lag, reserve(count));
+        pointShader->setUniform("color", sf::Glsl::Vec4(color));
+    }
+    else if (mode == RENDER_STREAKS) {
+        vertexCount = buildStreaks(drops, color, lag, reserve(count * 2)) * 2;
+    }
+    else if (mode == RENDER_ADAPTIVE && dropPixels < 1.0f) {
+        setShape(SHAPE_PIXELS);
+        vertexCount = buildPixels(drops, color, lag, reserve(count));
+    }
+    else if (mode == RENDER_ADAPTIVE && dropPixels < ADAPTIVE_LINE_PIXELS) {
+        setShape(SHAPE_LINES);
+        vertexCount = buildLines(drops, color, lag, reserve(count * 2)) * 2;
+    }
+    else {
+        setShape(SHAPE_QUADS);
+        vertexCount = buildQuads(drops, color, lag, reserve(count * QUAD_VERTICES)) * QUAD_VERTICES;
+    }
+
+    if (!stream && useBuffer && vertexCount > 0) {
+        // Grow the buffer geometrically so it's only reallocated while the rain builds up
+        if (buffer->getVertexCount() < vertexCount) {
+            useBuffer = buffer->create(vertexCount + vertexCount / 2);
+        }
+        if (useBuffer) {
+            useBuffer = buffer->update(staged, vertexCount, 0);
+        }
+    }
+}
+
+// Room for count vertices: the stream's next region, or the arena or else the vertex array if
+// there's no stream or it has just failed
+sf::Vertex* RainBatch::reserve(std::size_t count) {
+    vertexCount = count;
+    if (stream) {
+        if (sf::Vertex* out = stream->map(count)) {
+            return out;
+        }
+        stream.reset();
+        useVertexBuffer();
+    }
+    if (arena) {
+        staged = arena->allocate<sf::Vertex>(count);
+        return staged;
+    }
+    vertices.resize(count);
+    staged = count > 0 ? &vertices[0] : nullptr;
+    return staged;
+}
+
+// The vertices may be write-combined GPU memory, so every field is written exactly once and
+// nothing is read back, not even through a chained assignment
+std::size_t RainBatch::buildQuads(const RainField& drops, sf::Color color, float lag, sf::Vertex* out) const {
+    const std::size_t count = drops.count();
+    const float visibleLeft = rectLeft(visible);
+    const float visibleTop = rectTop(visible);
+    const float visibleRight = visibleLeft + rectWidth(visible);
+    const float visibleBottom = visibleTop + rectHeight(visible);
+    std::size_t written = 0;
+    const sf::FloatRect sprite = atlas ? atlas->getTexCoords(SPRITE_DROP) : sf::FloatRect();
+    const sf::Vector2f spriteTopLeft(rectLeft(sprite), rectTop(sprite));
+    const sf::Vector2f spriteTopRight(rectLeft(sprite) + rectWidth(sprite), rectTop(sprite));
+    const sf::Vector2f spriteBottomRight(rectLeft(sprite) + rectWidth(sprite), rectTop(sprite) + rectHeight(sprite));
+    const sf::Vector2f spriteBottomLeft(rectLeft(sprite), rectTop(sprite) + rectHeight(sprite));
+    for (std::size_t i = 0; i < count; ++i) {
+        const float left = drops.x[i];
+        const float top = drops.y[i] - drops.vy[i] * lag;
+        const float right = left + drops.size[i];
+        const float bottom = top + RainField::heightOf(drops.size[i]);
+        if (culling && (right <= visibleLeft || left >= visibleRight || bottom <= visibleTop || top >= visibleBottom)) {
+            continue;
+        }
+
+        writeQuad(out + written++ * QUAD_VERTICES, sf::Vertex{ sf::Vector2f(left, top), color, spriteTopLeft },
+            sf::Vertex{ sf::Vector2f(right, top), color, spriteTopRight }, sf::Vertex{ sf::Vector2f(right, bottom), color, spriteBottomRight },
+            sf::Vertex{ sf::Vector2f(left, bottom), color, spriteBottomLeft });
+    }
+    return written;
+}
+
+// A point is culled by the quad the geometry shader will make of it
+std::size_t RainBatch::buildPoints(const RainField& drops, float lag, sf::Vertex* out) const {
+    const std::size_t count = drops.count();
+    const float visibleLeft = rectLeft(visible);
+    const float visibleTop = rectTop(visible);
+    const float visibleRight = visibleLeft + rectWidth(visible);
+    const float visibleBottom = visibleTop + rectHeight(visible);
+    std::size_t written = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const float left = drops.x[i];
+        const float top = drops.y[i] - drops.vy[i] * lag;
+        if (culling && (left + drops.size[i] <= visibleLeft || left >= visibleRight || top + RainField::heightOf(drops.size[i]) <= visibleTop || top >= visibleBottom)) {
+            continue;
+        }
+        sf::Vertex& point = out[written++];
+        point.position = sf::Vector2f(left, top);
+        point.texCoords.x = drops.size[i];
+    }
+    return written;
+}
+
+// Each streak runs from the drop's bottom edge, at full colour, up to where it was
+// streakExposure seconds ago, fully transparent
+// A streak is culled by the box around the line, which reaches above the drop
+std::size_t RainBatch::buildStreaks(const RainField& drops, sf::Color color, float lag, sf::Vertex* out) const {
+    const std::size_t count = drops.count();
+    const float visibleLeft = rectLeft(visible);
+    const float visibleTop = rectTop(visible);
+    const float visibleRight = visibleLeft + rectWidth(visible);
+    const float visibleBottom = visibleTop + rectHeight(visible);
+    std::size_t written = 0;
+    sf::Color tail = color;
+    tail.a = 0;
+    const sf::FloatRect white = atlas ? atlas->getTexCoords(SPRITE_WHITE) : sf::FloatRect();
+    const sf::Vector2f solid(rectLeft(white), rectTop(white));
+
+    for (std::size_t i = 0; i < count; ++i) {
+        const float centre = drops.x[i] + drops.size[i] * 0.5f;
+        const float bottom = drops.y[i] - drops.vy[i] * lag + RainField::heightOf(drops.size[i]);
+        const float top = bottom - drops.vy[i] * streakExposure;
+        if (culling && (centre < visibleLeft || centre > visibleRight || bottom <= visibleTop || top >= visibleBottom)) {
+            continue;
+        }
+
+        sf::Vertex* line = out + written++ * 2;
+        line[0].position = sf::Vector2f(centre, bottom);
+        line[0].color = color;
+        line[0].texCoords = solid;
+        line[1].position = sf::Vector2f(centre, top);
+        line[1].color = tail;
+        line[1].texCoords = solid;
+    }
+    return written;
+}
+
+// A line down the middle of the drop, from its top to its bottom edge
+std::size_t RainBatch::buildLines(const RainField& drops, sf::Color color, float lag, sf::Vertex* out) const {
+    const std::size_t count = drops.count();
+    const float visibleLeft = rectLeft(visible);
+    const float visibleTop = rectTop(visible);
+    const float visibleRight = visibleLeft + rectWidth(visible);
+    const float visibleBottom = visibleTop + rectHeight(visible);
+    std::size_t written = 0;
+    const sf::FloatRect white = atlas ? atlas->getTexCoords(SPRITE_WHITE) : sf::FloatRect();
+    const sf::Vector2f solid(rectLeft(white), rectTop(white));
+    for (std::size_t i = 0; i < count; ++i) {
+        const float centre = drops.x[i] + drops.size[i] * 0.5f;
+        const float top = drops.y[i] - drops.vy[i] * lag;
+        const float bottom = top + RainField::heightOf(drops.size[i]);
+        if (culling && (centre < visibleLeft || centre > visibleRight || bottom <= visibleTop || top >= visibleBottom)) {
+            continue;
+        }
+
+        sf::Vertex* line = out + written++ * 2;
+        line[0].position = sf::Vector2f(centre, top);
+        line[0].color = color;
+        line[0].texCoords = solid;
+        line[1].position = sf::Vector2f(centre, bottom);
+        line[1].color = color;
+        line[1].texCoords = solid;
+    }
+    return written;
+}
+
+// A point at the middle of the drop, which rasterizes as the one pixel it lands in
+std::size_t RainBatch::buildPixels(const RainField& drops, sf::Color color, float lag, sf::Vertex* out) const {
+    const std::size_t count = drops.count();
+    const float visibleLeft = rectLeft(visible);
+    const float visibleTop = rectTop(visible);
+    const float visibleRight = visibleLeft + rectWidth(visible);
+    const float visibleBottom = visibleTop + rectHeight(visible);
+    std::size_t written = 0;
+    const sf::FloatRect white = atlas ? atlas->getTexCoords(SPRITE_WHITE) : sf::FloatRect();
+    const sf::Vector2f solid(rectLeft(white), rectTop(white));
+    for (std::size_t i = 0; i < count; ++i) {
+        const sf::Vector2f centre(drops.x[i] + drops.size[i] * 0.5f, drops.y[i] - drops.vy[i] * lag + RainField::heightOf(drops.size[i]) * 0.5f);
+        if (culling && (centre.x < visibleLeft || centre.x >= visibleRight || centre.y < visibleTop || centre.y >= visibleBottom)) {
+            continue;
+        }
+
+        sf::Vertex& point = out[written++];
+        point.position = centre;
+        point.color = color;
+        point.texCoords = solid;
+    }
+    return written;
+}
+
+// The primitive goes with the vertex array and the vertex buffer, so both follow the shape
+void RainBatch::setShape(DropShape next) {
+    if (mode != RENDER_ADAPTIVE || usePoints || next == shape) {
+        return;
+    }
+    shape = next;
+    const sf::PrimitiveType type = shape == SHAPE_PIXELS ? sf::PrimitiveType::Points : shape == SHAPE_LINES ? sf::PrimitiveType::Lines : QUAD_PRIMITIVE;
+    vertices.setPrimitiveType(type);
+    if (buffer) {
+        buffer->setPrimitiveType(type);
+    }
+}
+
+void RainBatch::draw(sf::RenderTarget& target) {
+    if ((mode == RENDER_STREAKS && !usePoints && streakPersistence > 0.0f) || resolution < 1.0f) {
+        drawOffscreen(target);
+        return;
+    }
+    sf::RenderStates states;
+    states.shader = pointShader.get();
+    states.texture = atlas && !usePoints ? &atlas->getTexture() : nullptr;
+    drawVertices(target, states);
+}
+
+void RainBatch::drawVertices(sf::RenderTarget& target, const sf::RenderStates& states) const {
+    if (stream) {
+        stream->draw(target, vertices.getPrimitiveType(), vertexCount, states);
+    }
+    else if (useBuffer) {
+        target.draw(*buffer, 0, vertexCount, states);
+    }
+    else if (vertexCount > 0) {
+        target.draw(staged, vertexCount, vertices.getPrimitiveType(), states);
+    }
+}
+
+// Draws the rain into the offscreen texture at resolution texels per world unit and lays it
+// over the target additively. Trails fade what the texture already holds towards transparent
+// black first; without them it starts clear every frame. The texture looks through the
+// target's view, wherever that has panned to, so the trails stay where they were left in the
+// world; a view that moves leaves them behind it
+void RainBatch::drawOffscreen(sf::RenderTarget& target) {
+    const sf::FloatRect shown = viewBounds(target.getView());
+    const sf::Vector2f world(rectWidth(shown), rectHeight(shown));
+    const sf::Vector2u size(std::max(static_cast<unsigned>(world.x * resolution), 1u), std::max(static_cast<unsigned>(world.y * resolution), 1u));
+    const bool fading = mode == RENDER_STREAKS && !usePoints && streakPersistence > 0.0f;
+    if (!trails || trails->getSize() != size) {
+        trails.reset(new sf::RenderTexture());
+        if (!createRenderTexture(*trails, size)) {
+            trails.reset();
+            streakPersistence = 0.0f; // No offscreen targets, so draw directly from now on
+            resolution = 1.0f;
+            sf::RenderStates states;
+            states.texture = atlas ? &atlas->getTexture() : nullptr;
+            drawVertices(target, states);
+            return;
+        }
+        trails->setSmooth(true); // Bilinear when it's stretched back over the world
+        trails->clear(sf::Color::Transparent);
+        if (!compositeShader && !compositeCompile.pending() && sf::Shader::isAvailable()) {
+            if (backgroundCompile) {
+                compileShaderInBackground(compositeCompile, nullptr, nullptr, COMPOSITE_FRAGMENT_SHADER);
+            }
+            else {
+                adoptCompositeShader(compileShader(nullptr, nullptr, COMPOSITE_FRAGMENT_SHADER));
+            }
+        }
+    }
+    if (compositeCompile.pending()) {
+        adoptCompositeShader(compositeCompile.take());
+    }
+
+    trails->setView(sf::View(shown));
+    if (fading) {
+        // Multiplying every channel by the persistence fades colour and alpha together
+        const std::uint8_t keep = static_cast<std::uint8_t>(std::min(std::max(streakPersistence, 0.0f), 1.0f) * 255.0f);
+        // A quad of its own rather than a RectangleShape, whose outline and fill vertices would
+        // be allocated afresh every frame
+        const sf::Color fade(keep, keep, keep, keep);
+        sf::Vertex quad[QUAD_VERTICES];
+        const sf::Vector2f topLeft(rectLeft(shown), rectTop(shown));
+        writeQuad(quad, sf::Vertex{ topLeft, fade }, sf::Vertex{ topLeft + sf::Vector2f(world.x, 0.0f), fade },
+            sf::Vertex{ topLeft + world, fade }, sf::Vertex{ topLeft + sf::Vector2f(0.0f, world.y), fade });
+        trails->draw(quad, QUAD_VERTICES, QUAD_PRIMITIVE, sf::BlendMultiply);
+    }
+    else {
+        trails->clear(sf::Color::Transparent);
+    }
+    sf::RenderStates states(sf::BlendAdd);
+    states.texture = atlas ? &atlas->getTexture() : nullptr;
+    states.shader = pointShader.get();
+    drawVertices(*trails, states);
+    trails->display();
+
+    sf::Sprite sprite(trails->getTexture());
+    sprite.setPosition(sf::Vector2f(rectLeft(shown), rectTop(shown)));
+    sprite.setScale(sf::Vector2f(world.x / size.x, world.y / size.y));
+    sf::RenderStates composite(sf::BlendAdd);
+    composite.shader = fading ? nullptr : compositeShader.get(); // Trails keep the plain additive look they've always had
+    target.draw(sprite, composite);
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+
+#include "Constants.h"
+#include "FrameArena.h"
+#include "RainField.h"
+#include "SfmlCompat.h"
+#include "SpriteAtlas.h"
+#include "Startup.h"
+#include "VertexStream.h"
+
+// How RainBatch turns drops into vertices
+enum RainRenderMode {
+    RENDER_QUADS,  // A quad per drop, built on the CPU: four vertices, or six under SFML 3
+    RENDER_POINTS, // One vertex per drop, expanded into its quad by a geometry shader
+    RENDER_STREAKS, // A line per drop as long as the distance it falls in the exposure time
+    RENDER_ADAPTIVE // Quads, drop-length lines or single pixels, whichever the drops' size on screen calls for
+};
+
+// The name --render takes for mode
+inline const char* renderModeName(RainRenderMode mode) {
+    static const char* const names[] = { "quads", "points", "streaks", "adaptive" };
+    return names[mode];
+}
+
+// Draws the whole rain field in one draw call. Every drop becomes one quad, written straight
+// into a persistently mapped VertexStream where the driver has them. Elsewhere the quads go
+// into a shared vertex array, which is streamed into a GPU vertex buffer when the driver
+// supports them. In points mode each drop is a single vertex carrying its size, a quarter of
+// the data to write and upload, and a geometry shader builds the quad with the colour as a
+// uniform. Points mode falls back to quads where geometry shaders aren't available.
+//
+// Streaks mode draws each drop as a motion-blurred line fading out behind it, which covers far
+// more of the screen than the drop itself, so the rain looks as dense with several times fewer
+// drops. With persistence above zero the streaks also build up in an offscreen texture that
+// fades by that factor each frame, for a longer trail at no extra vertex cost.
+//
+// Adaptive mode picks each build's primitive by how wide the widest drop is on screen: under a
+// pixel a drop only ever covers one, so it's a single point; under ADAPTIVE_LINE_PIXELS it's
+// a line a pixel wide down its length, the way it falls; only wider than that is a quad worth
+// its two triangles' setup. Plain points and lines need no shader, so it works everywhere.
+//
+// Given an atlas, quads are drawn with its drop sprite and streaks, lines and pixels with its
+// white block, so the rain shares a texture with everything else drawn from the atlas. Points
+// stay plain
+class RainBatch {
+public:
+    // A batch that may not use the GPU never touches GL, so it can be built without a window
+    // for measuring the vertex work on its own. Points mode then falls back to quads
+    explicit RainBatch(bool allowGpu = true, RainRenderMode mode = RENDER_QUADS)
+        : vertices(QUAD_PRIMITIVE), vertexCount(0), mode(mode), useBuffer(false), usePoints(false), checkedGpu(!allowGpu),
+          streakExposure(1.0f / 30.0f), streakPersistence(0.0f), resolution(1.0f), atlas(nullptr), arena(nullptr), staged(nullptr),
+          culling(false), backgroundCompile(false), dropPixels(ADAPTIVE_LINE_PIXELS), shape(SHAPE_QUADS) {}
+
+    // exposure is the shutter time in seconds a streak's length covers; persistence is the
+    // fraction of last frame's streaks kept each frame, 0 for none
+    void setStreaks(float exposure, float persistence) {
+        streakExposure = exposure;
+        streakPersistence = persistence;
+    }
+
+    // Draws the rain into an offscreen texture of scale texels per world unit, additively, and
+    // stretches that over the world, 1 to draw straight into the target. However many drops
+    // overlap, each pixel drawn costs scale squared of one drawn full size, and the one pass
+    // back over the world costs the same whatever the rain is like
+    void setResolution(float scale) {
+        resolution = std::min(std::max(scale, 0.05f), 1.0f);
+    }
+
+    // Texture the drops from atlas from the next build on, or not with nullptr. The atlas has to
+    // outlive the batch
+    void setAtlas(const SpriteAtlas* sprites) {
+        atlas = sprites;
+    }
+
+    // How many pixels the widest drop covers across where the rain is drawn, for adaptive mode
+    // to pick the next builds' shape by. The caller scales it down with the quality governor's
+    // level, so a frame running over drops to cheaper shapes sooner
+    void setDropPixels(float widest) {
+        dropPixels = widest;
+    }
+
+    // Compile the point and composite shaders in the background from the first build on, and
+    // draw quads and composite plainly until each is ready, rather than have that build wait on
+    // the driver. Renders that have to draw every frame alike leave it off
+    void setBackgroundCompile(bool background) {
+        backgroundCompile = background;
+    }
+
+    // Stage the vertices in arena from the next build on, where they aren't streamed, instead of
+    // in the batch's own vertex array, or not with nullptr. The arena mustn't be reset between a
+    // build and the draw that follows it
+    void setArena(FrameArena* scratch) {
+        arena = scratch;
+    }
+
+    // From the next build on, drops wholly outside area, in world units, get no vertices and
+    // aren't drawn: those waiting above the top edge, and any a view leaves out. The test is
+    // made as each drop is written, so the vertices stay packed. Pass the bounds of the view
+    // the rain is drawn through, see viewBounds()
+    void setVisibleArea(const sf::FloatRect& area) {
+        visible = area;
+        culling = true;
+    }
+
+    // Rewrites the vertex data from the current drop positions, drawn lag seconds back along
+    // their fall. A frame presented part way into the next step passes what's left of it, so
+    // the rain is shown between the last two steps the same way the person is. A step moves a
+    // drop by its new velocity alone, so stepping back along it lands exactly on the step before
+    void build(const RainField& drops, sf::Color color, float lag = 0.0f);
+
+    void draw(sf::RenderTarget& target);
+
+    // Call once the window has been recreated. A vertex stream only works in the context it was
+    // made in, so it's made again in the new one; everything else is shared between contexts
+    void contextChanged();
+
+    // The vertices in CPU memory and whichever GPU buffer they go through, plus the streak trails
+    MemoryUsage memoryUsage() const;
+
+    // Mode actually in use, once the first build has checked what the driver supports, and
+    // with background compiles once the point shader has come in
+    RainRenderMode renderMode() const {
+        return usePoints ? RENDER_POINTS : mode == RENDER_STREAKS || mode == RENDER_ADAPTIVE ? mode : RENDER_QUADS;
+    }
+
+private:
+    // What adaptive mode made of the drops in the last build
+    enum DropShape {
+        SHAPE_QUADS,
+        SHAPE_LINES,
+        SHAPE_PIXELS
+    };
+
+    sf::VertexArray vertices; // Holds the vertices unless they're streamed, and the primitive type always
+    std::size_t vertexCount;
+    std::unique_ptr<VertexStream> stream;
+    std::unique_ptr<sf::VertexBuffer> buffer;
+    std::unique_ptr<sf::Shader> pointShader;
+    RainRenderMode mode;
+    bool useBuffer; // Falls back to the plain vertex array if the buffer can't be created
+    bool usePoints;
+    bool checkedGpu;
+    float streakExposure;
+    float streakPersistence;
+    std::unique_ptr<sf::RenderTexture> trails; // Streak accumulation or the low-resolution rain, created on first draw
+    std::unique_ptr<sf::Shader> compositeShader;
+    float resolution;
+    const SpriteAtlas* atlas;
+    FrameArena* arena;
+    sf::Vertex* staged; // The last build's vertices, when they aren't streamed
+    sf::FloatRect visible;
+    bool culling;
+    bool backgroundCompile;
+    Deferred<sf::Shader> pointCompile;
+    Deferred<sf::Shader> compositeCompile;
+    float dropPixels;
+    DropShape shape;
+
+    void checkGpu();
+    void useVertexBuffer();
+    void adoptPointShader(std::unique_ptr<sf::Shader> shader);
+    void adoptCompositeShader(std::unique_ptr<sf::Shader> shader);
+    sf::Vertex* reserve(std::size_t count);
+    // Each returns how many drops it wrote, those not culled
+    std::size_t buildQuads(const RainField& drops, sf::Color color, float lag, sf::Vertex* out) const;
+    std::size_t buildPoints(const RainField& drops, float lag, sf::Vertex* out) const;
+    std::size_t buildStreaks(const RainField& drops, sf::Color color, float lag, sf::Vertex* out) const;
+    std::size_t buildLines(const RainField& drops, sf::Color color, float lag, sf::Vertex* out) const;
+    std::size_t buildPixels(const RainField& drops, sf::Color color, float lag, sf::Vertex* out) const;
+    void setShape(DropShape next);
+    void drawVertices(sf::RenderTarget& target, const sf::RenderStates& states) const;
+    void drawOffscreen(sf::RenderTarget& target);
+};
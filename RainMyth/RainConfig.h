@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "Constants.h"
+
+// Settings for the wind, all in pixels per second. Positive blows to the right
+struct WindConfig {
+    float speed = 0.0f;       // Steady wind across the whole screen
+    float gust = 0.0f;        // How far gusts push the whole screen's wind above or below speed
+    float gustPeriod = 4.0f;  // Seconds between gust peaks
+    float turbulence = 0.0f;  // How far the wind varies from place to place, over WIND_CELL_SIZE
+
+    // The fastest the wind can blow anywhere, for widening spawn bands and collision margins
+    float maxSpeed() const {
+        return std::abs(speed) + std::abs(gust) + std::abs(turbulence);
+    }
+
+    bool isCalm() const {
+        return maxSpeed() == 0.0f;
+    }
+};
+
+// How drop widths are spread over [minSize, maxSize]
+enum DropSizeModel {
+    DROP_SIZES_UNIFORM,        // Every width equally likely
+    DROP_SIZES_MARSHALL_PALMER // Exponential in diameter, as Marshall and Palmer (1948) measured, cut off at the ends
+};
+
+// What people catch rain with
+enum BodyShape {
+    BODY_BOX,     // Their bounds
+    BODY_CAPSULE, // As wide as their bounds, rounded off at the head and feet
+    BODY_LEANING  // Their bounds tipped forward by PERSON_LEAN the way they last moved
+};
+
+// How drops are found to have hit people
+enum HitTest {
+    HITS_SWEPT, // Each drop near someone is tested against them, swept over the step
+    HITS_RASTER // Each drop looks up who covers where its bottom reached, in a grid of RASTER_HIT_CELL_SIZE cells
+};
+
+// Tunables for one RainSystem
+struct RainConfig {
+    std::uint64_t seed = 0;
+    std::size_t maxDrops = RAINDROP_CAPACITY;  // Size of the drop pool
+    float spawnRate = RAINDROP_SPAWN_RATE;     // Drops per second per pixel of spawn width
+    float minSize = RAINDROP_MIN_SIZE;         // Drop widths are drawn from sizeModel in [minSize, maxSize]
+    float maxSize = RAINDROP_MAX_SIZE;
+    DropSizeModel sizeModel = DROP_SIZES_UNIFORM;
+    float rainIntensity = RAIN_INTENSITY;      // mm per hour, which sets the Marshall-Palmer slope
+    WindConfig wind;                           // Calm by default
+    bool columnBuckets = false;                // Keep the store sorted into COLUMN_BUCKET_WIDTH columns every step, moving
+                                               // only drops the wind carried across one, and test people against only the
+                                               // columns they cover
+    std::size_t coarseSteps = 1;               // In calm air without column buckets, let chunks of drops well above
+                                               // everything skip up to coarseSteps - 1 steps and catch up in one move
+    BodyShape body = BODY_BOX;
+    bool shelterDrips = false;                 // Collect the rain landing on each collider and drip what it can't hold off
+                                               // its edges as new drops. Snapshots don't keep the water collected
+    float coalesceDistance = 0.0f;             // Without column buckets or coarse steps, merge drops of a GRID_CELL_SIZE cell
+                                               // closer than this many pixels, keeping their area, up to maxSize. 0 never does
+    HitTest hits = HITS_SWEPT;                 // Without column buckets, which test people their own way
+};
@@ -0,0 +1,90 @@
+#include "RainDetail.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "Constants.h"
+#include "SfmlCompat.h"
+
+RainDetailLevel rainDetailFor(float pixelsPerUnit) {
+    if (pixelsPerUnit < TILE_DETAIL_PIXELS) {
+        return DETAIL_TILES;
+    }
+    return pixelsPerUnit > STREAK_DETAIL_PIXELS ? DETAIL_STREAKS : DETAIL_DROPS;
+}
+
+void RainDetail::buildTiles(const RainField& drops, sf::Color color, const sf::FloatRect& area, float tileSize, float lag) {
+    const float left = std::floor(rectLeft(area) / tileSize) * tileSize;
+    const float top = std::floor(rectTop(area) / tileSize) * tileSize;
+    const std::size_t columns = static_cast<std::size_t>(std::ceil((rectLeft(area) + rectWidth(area) - left) / tileSize));
+    const std::size_t rows = static_cast<std::size_t>(std::ceil((rectTop(area) + rectHeight(area) - top) / tileSize));
+    coverage.assign(columns * rows, 0.0f);
+
+    // Each drop counts whole towards the tile holding its centre
+    const std::size_t count = drops.count();
+    for (std::size_t i = 0; i < count; ++i) {
+        const float height = RainField::heightOf(drops.size[i]);
+        const float column = (drops.x[i] + drops.size[i] * 0.5f - left) / tileSize;
+        const float row = (drops.y[i] - drops.vy[i] * lag + height * 0.5f - top) / tileSize;
+        if (column < 0.0f || row < 0.0f || column >= columns || row >= rows) {
+            continue;
+        }
+        coverage[static_cast<std::size_t>(row) * columns + static_cast<std::size_t>(column)] += RainField::areaOf(drops.size[i]);
+    }
+
+    if (vertices.size() < coverage.size() * QUAD_VERTICES) {
+        vertices.resize(coverage.size() * QUAD_VERTICES);
+    }
+    const float tileArea = tileSize * tileSize;
+    std::size_t written = 0;
+    for (std::size_t row = 0; row < rows; ++row) {
+        for (std::size_t column = 0; column < columns; ++column) {
+            const float covered = coverage[row * columns + column] / tileArea;
+            if (covered <= 0.0f) {
+                continue;
+            }
+            sf::Color shade = color;
+            shade.a = static_cast<std::uint8_t>(color.a * std::min(covered, 1.0f));
+            const float x = left + column * tileSize;
+            const float y = top + row * tileSize;
+            writeQuad(&vertices[written++ * QUAD_VERTICES], sf::Vertex{ sf::Vector2f(x, y), shade }, sf::Vertex{ sf::Vector2f(x + tileSize, y), shade },
+                sf::Vertex{ sf::Vector2f(x + tileSize, y + tileSize), shade }, sf::Vertex{ sf::Vector2f(x, y + tileSize), shade });
+        }
+    }
+    vertexCount = written * QUAD_VERTICES;
+}
+
+void RainDetail::buildStreaks(const RainField& drops, sf::Color color, const sf::FloatRect& area, float exposure, float lag) {
+    const float visibleLeft = rectLeft(area);
+    const float visibleTop = rectTop(area);
+    const float visibleRight = visibleLeft + rectWidth(area);
+    const float visibleBottom = visibleTop + rectHeight(area);
+    sf::Color tail = color;
+    tail.a = 0;
+
+    // Room grows with the drops in view, not with all of them
+    const std::size_t count = drops.count();
+    std::size_t written = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const float left = drops.x[i];
+        const float right = left + drops.size[i];
+        const float bottom = drops.y[i] - drops.vy[i] * lag + RainField::heightOf(drops.size[i]);
+        const float top = bottom - RainField::heightOf(drops.size[i]) - drops.vy[i] * exposure;
+        if (right <= visibleLeft || left >= visibleRight || bottom <= visibleTop || top >= visibleBottom) {
+            continue;
+        }
+        if ((written + 1) * QUAD_VERTICES > vertices.size()) {
+            vertices.resize(std::max<std::size_t>(vertices.size() * 2, 1024 * QUAD_VERTICES));
+        }
+        writeQuad(&vertices[written++ * QUAD_VERTICES], sf::Vertex{ sf::Vector2f(left, top), tail }, sf::Vertex{ sf::Vector2f(right, top), tail },
+            sf::Vertex{ sf::Vector2f(right, bottom), color }, sf::Vertex{ sf::Vector2f(left, bottom), color });
+    }
+    vertexCount = written * QUAD_VERTICES;
+}
+
+void RainDetail::draw(sf::RenderTarget& target) const {
+    if (vertexCount > 0) {
+        target.draw(vertices.data(), vertexCount, QUAD_PRIMITIVE);
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <vector>
+
+#include "MemoryUsage.h"
+#include "RainField.h"
+
+// How much of each drop is drawn at a camera's zoom
+enum RainDetailLevel {
+    DETAIL_TILES,  // Far out: drops under a pixel, drawn as tiles shaded by how much rain covers them
+    DETAIL_DROPS,  // RainBatch's drops, in whichever render mode was asked for
+    DETAIL_STREAKS // Close in: each drop a quad as wide as itself running back along its fall
+};
+
+// The level for a view where a world unit covers this many screen pixels
+RainDetailLevel rainDetailFor(float pixelsPerUnit);
+
+// Draws the rain at the levels RainBatch doesn't, so the draw cost stays bounded whatever the
+// zoom. Tiles are DENSITY_TILE_PIXELS across on screen, so there are never more than the
+// window holds, however many drops are in view; streaks are only drawn close in, where the
+// view holds few drops. Both skip drops outside the area in view and are built as quads on
+// the CPU into one array, drawn in one call
+class RainDetail {
+public:
+    RainDetail() : vertexCount(0) {}
+
+    // Sums the area of the drops in each tile of a grid over area, tileSize world units square
+    // and anchored to the world's origin so it doesn't shimmer as the view pans, and writes a
+    // quad per tile with any rain in it, its alpha color's scaled by the fraction covered
+    void buildTiles(const RainField& drops, sf::Color color, const sf::FloatRect& area, float tileSize, float lag);
+
+    // A quad per drop in area from where it was exposure seconds ago, transparent, down to its
+    // bottom edge in color
+    void buildStreaks(const RainField& drops, sf::Color color, const sf::FloatRect& area, float exposure, float lag);
+
+    void draw(sf::RenderTarget& target) const;
+
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage = vectorUsage(vertices, vertexCount);
+        usage += vectorUsage(coverage);
+        return usage;
+    }
+
+private:
+    std::vector<sf::Vertex> vertices; // Only grows, so it stops allocating once the view has been everywhere
+    std::size_t vertexCount;
+    std::vector<float> coverage;      // Drop area per tile
+};
@@ -0,0 +1,373 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "Constants.h"
+#include "JobSystem.h"
+#include "MemoryUsage.h"
+
+// std::allocator, except that every block starts on a cache line. An array split into chunks a
+// whole number of cache lines long then splits on line boundaries, so threads working on
+// neighbouring chunks never write to the same line
+template <typename T>
+struct LineAlignedAllocator {
+    typedef T value_type;
+
+    LineAlignedAllocator() {}
+
+    template <typename U>
+    LineAlignedAllocator(const LineAlignedAllocator<U>&) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(CACHE_LINE_BYTES)));
+    }
+
+    void deallocate(T* p, std::size_t) {
+        ::operator delete(p, std::align_val_t(CACHE_LINE_BYTES));
+    }
+
+    template <typename U>
+    bool operator==(const LineAlignedAllocator<U>&) const {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const LineAlignedAllocator<U>&) const {
+        return false;
+    }
+};
+
+// Rows of per-chunk results, each a whole number of lines long
+template <typename T>
+using LineVector = std::vector<T, LineAlignedAllocator<T>>;
+
+// LineAlignedAllocator, except that elements made without a value are left unwritten. A vector
+// of floats sized through it doesn't touch its pages, so each lands on the NUMA node of the
+// thread that first writes it rather than the one that allocated it
+template <typename T>
+struct UntouchedAllocator : LineAlignedAllocator<T> {
+    UntouchedAllocator() {}
+
+    template <typename U>
+    UntouchedAllocator(const UntouchedAllocator<U>&) {}
+
+    template <typename U>
+    void construct(U* p) {
+        ::new (static_cast<void*>(p)) U;
+    }
+
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+};
+
+// Chunks of the store, and spawns, start on cache lines of every array
+static_assert(DROPS_PER_CHUNK % (CACHE_LINE_BYTES / sizeof(float)) == 0, "DROPS_PER_CHUNK must fill whole cache lines");
+static_assert(SPAWNS_PER_CHUNK % (CACHE_LINE_BYTES / sizeof(float)) == 0, "SPAWNS_PER_CHUNK must fill whole cache lines");
+
+// Structure-of-arrays storage for every live raindrop. Each drop is just four floats and a
+// bit mask spread over five contiguous arrays, so a pass over one attribute streams through
+// memory instead of hopping over whole sf::RectangleShape objects.
+//
+// The store is a fixed-capacity pool: the arrays are allocated once up front and live drops
+// are always packed into [0, count()). Removal either swaps the last live drop into the hole,
+// when order doesn't matter, or is left to the caller to compact in order with move() and
+// truncate(), when the store is sorted. Nothing is allocated after construction
+class RainField {
+public:
+    // With touch false the arrays are left unwritten until zero() is called on every part of
+    // them, so whichever threads do that decide which NUMA node each part's memory is on
+    explicit RainField(std::size_t capacity, bool touch = true)
+        : x(capacity), y(capacity), vy(capacity), size(capacity), absorbed(capacity), live(0), highWater(0), rejected(0) {
+        if (touch) {
+            zero(0, capacity);
+        }
+    }
+
+    // Zeroes slots [begin, end) of every array
+    void zero(std::size_t begin, std::size_t end) {
+        std::fill(x.begin() + begin, x.begin() + end, 0.0f);
+        std::fill(y.begin() + begin, y.begin() + end, 0.0f);
+        std::fill(vy.begin() + begin, vy.begin() + end, 0.0f);
+        std::fill(size.begin() + begin, size.begin() + end, 0.0f);
+        std::fill(absorbed.begin() + begin, absorbed.begin() + end, 0u);
+    }
+
+    // Appends a drop at (px, py) with vertical speed pvy and width psize if there's room
+    bool add(float px, float py, float pvy, float psize) {
+        std::size_t first = 0;
+        if (grow(1, first) == 0) {
+            return false;
+        }
+        x[first] = px;
+        y[first] = py;
+        vy[first] = pvy;
+        size[first] = psize;
+        absorbed[first] = 0;
+        return true;
+    }
+
+    // Claims up to n uninitialized slots at the end of the live range, so a spawner can fill
+    // the new tail of every array in bulk. Returns how many were granted and sets first to the
+    // index of the first one; requests past capacity are counted in rejectedCount()
+    std::size_t grow(std::size_t n, std::size_t& first) {
+        first = live;
+        const std::size_t granted = std::min(n, capacity() - live);
+        rejected += n - granted;
+        live += granted;
+        highWater = std::max(highWater, live);
+        return granted;
+    }
+
+    // Copies drop src into slot dst
+    void move(std::size_t dst, std::size_t src) {
+        x[dst] = x[src];
+        y[dst] = y[src];
+        vy[dst] = vy[src];
+        size[dst] = size[src];
+        absorbed[dst] = absorbed[src];
+    }
+
+    // O(1) removal: the last live drop takes over slot i. Drop order is not preserved
+    void swapRemove(std::size_t i) {
+        --live;
+        if (i != live) {
+            move(i, live);
+        }
+    }
+
+    // Replaces the live drops with count copied from the given arrays, up to capacity, without
+    // reallocating
+    void assign(const float* px, const float* py, const float* pvy, const float* psize, const std::uint32_t* pabsorbed, std::size_t count) {
+        const std::size_t n = std::min(count, capacity());
+        std::copy(px, px + n, x.begin());
+        std::copy(py, py + n, y.begin());
+        std::copy(pvy, pvy + n, vy.begin());
+        std::copy(psize, psize + n, size.begin());
+        std::copy(pabsorbed, pabsorbed + n, absorbed.begin());
+        live = n;
+        highWater = std::max(highWater, live);
+    }
+
+    // Makes this store a copy of other's live drops and counters, without reallocating. Both
+    // stores must have the same capacity
+    void copyLive(const RainField& other) {
+        const std::size_t n = other.live;
+        std::copy(other.x.begin(), other.x.begin() + n, x.begin());
+        std::copy(other.y.begin(), other.y.begin() + n, y.begin());
+        std::copy(other.vy.begin(), other.vy.begin() + n, vy.begin());
+        std::copy(other.size.begin(), other.size.begin() + n, size.begin());
+        std::copy(other.absorbed.begin(), other.absorbed.begin() + n, absorbed.begin());
+        live = n;
+        highWater = other.highWater;
+        rejected = other.rejected;
+    }
+
+    // Reorders the live drops by the column of cellSize-wide cells their x falls in, leftmost
+    // first, with a stable counting sort through scratch: two passes over the store and no
+    // comparisons. Within a column drops keep their order, which for drops spawned in order
+    // and falling at similar speeds is roughly top to bottom, so the store ends up walking the
+    // screen cell by cell. Afterwards counts[c] is where column c's drops end. Scratch must
+    // have the same capacity, and its contents are swapped in and lost.
+    //
+    // Both passes run on jobs, a block of the store per worker: each block counts its drops
+    // into its own row of blockCounts, a prefix sum over cells and then blocks turns the rows
+    // into where each block's drops of each cell start, and every block then scatters its own.
+    // A cell's drops from one block go after those from the block before, so the order is the
+    // one a single pass would give, whatever the thread count, and nothing is allocated once
+    // counts and blockCounts have grown. Blocks start on cache lines of the store and each
+    // block's row of counts on its own line, so no two workers write to one line but in scratch
+    void sortByColumn(float cellSize, float width, RainField& scratch, std::vector<std::uint32_t>& counts,
+        LineVector<std::uint32_t>& blockCounts, JobSystem& jobs) {
+        sortByCell(cellSize, width, 0.0f, 0.0f, scratch, counts, blockCounts, jobs);
+    }
+
+    // The same by square cellSize cells, a row at a time from top down to top + height and
+    // left to right within a row, so that each stretch of the store covers a few rows rather
+    // than the whole fall. Drops above or below go with the first or last row. counts gets a
+    // slot for every cell
+    void sortByCell(float cellSize, float width, float top, float height, RainField& scratch, std::vector<std::uint32_t>& counts,
+        LineVector<std::uint32_t>& blockCounts, JobSystem& jobs) {
+        const float invCell = 1.0f / cellSize;
+        const std::size_t columns = static_cast<std::size_t>(width * invCell) + 1;
+        const std::size_t rows = static_cast<std::size_t>(height * invCell) + 1;
+        const std::size_t cells = columns * rows;
+        auto cellOf = [&](float px, float py) {
+            const float column = std::min(std::max(px * invCell, 0.0f), static_cast<float>(columns - 1));
+            const float row = std::min(std::max((py - top) * invCell, 0.0f), static_cast<float>(rows - 1));
+            return static_cast<std::size_t>(row) * columns + static_cast<std::size_t>(column);
+        };
+        const std::size_t blocks = std::max<std::size_t>(std::min<std::size_t>(jobs.threadCount(), live / SORT_DROPS_PER_BLOCK), 1);
+        const std::size_t dropsPerLine = CACHE_LINE_BYTES / sizeof(float);
+        const std::size_t blockSize = ((live + blocks - 1) / blocks + dropsPerLine - 1) / dropsPerLine * dropsPerLine;
+        const std::size_t countsPerLine = CACHE_LINE_BYTES / sizeof(std::uint32_t);
+        const std::size_t rowStride = (cells + countsPerLine - 1) / countsPerLine * countsPerLine;
+        auto eachBlock = [&](auto&& fn) {
+            if (blocks == 1) {
+                fn(0, 0, live);
+                return;
+            }
+            jobs.run(blocks, [&](std::size_t block, unsigned) {
+                fn(block, std::min(block * blockSize, live), std::min(block * blockSize + blockSize, live));
+            });
+        };
+
+        blockCounts.assign(blocks * rowStride, 0u);
+        eachBlock([&](std::size_t block, std::size_t begin, std::size_t end) {
+            std::uint32_t* row = &blockCounts[block * rowStride];
+            for (std::size_t i = begin; i < end; ++i) {
+                ++row[cellOf(x[i], y[i])];
+            }
+        });
+        counts.resize(cells + 1);
+        std::uint32_t total = 0;
+        for (std::size_t c = 0; c < cells; ++c) {
+            for (std::size_t block = 0; block < blocks; ++block) {
+                std::uint32_t& count = blockCounts[block * rowStride + c];
+                const std::uint32_t start = total;
+                total += count;
+                count = start;
+            }
+            counts[c] = total;
+        }
+        counts[cells] = total;
+        eachBlock([&](std::size_t block, std::size_t begin, std::size_t end) {
+            std::uint32_t* row = &blockCounts[block * rowStride];
+            for (std::size_t i = begin; i < end; ++i) {
+                const std::size_t to = row[cellOf(x[i], y[i])]++;
+                scratch.x[to] = x[i];
+                scratch.y[to] = y[i];
+                scratch.vy[to] = vy[i];
+                scratch.size[to] = size[i];
+                scratch.absorbed[to] = absorbed[i];
+            }
+        });
+        x.swap(scratch.x);
+        y.swap(scratch.y);
+        vy.swap(scratch.vy);
+        size.swap(scratch.size);
+        absorbed.swap(scratch.absorbed);
+    }
+
+    // For a store whose first sorted drops are as a sortByColumn with cellSize and width left
+    // them, bar drops removed in order with counts' ends moved down to match, and whose drops
+    // after those are new: sorts the new ones into their columns, with the same result as
+    // sorting the whole store. The sorted drops are each moved once, and not looked at; only
+    // the new ones go through scratch. added is working space
+    void mergeByColumn(std::size_t sorted, float cellSize, float width, RainField& scratch, std::vector<std::uint32_t>& counts,
+        std::vector<std::uint32_t>& added) {
+        const float invCell = 1.0f / cellSize;
+        const std::size_t columns = static_cast<std::size_t>(width * invCell) + 1;
+        auto columnOf = [&](float px) {
+            return static_cast<std::size_t>(std::min(std::max(px * invCell, 0.0f), static_cast<float>(columns - 1)));
+        };
+
+        // A stable counting sort of the new drops alone, after which added[c] is how many of
+        // them go in columns up to c
+        added.assign(columns + 1, 0u);
+        for (std::size_t i = sorted; i < live; ++i) {
+            ++added[columnOf(x[i]) + 1];
+        }
+        for (std::size_t c = 1; c <= columns; ++c) {
+            added[c] += added[c - 1];
+        }
+        for (std::size_t i = sorted; i < live; ++i) {
+            const std::size_t to = added[columnOf(x[i])]++;
+            scratch.x[to] = x[i];
+            scratch.y[to] = y[i];
+            scratch.vy[to] = vy[i];
+            scratch.size[to] = size[i];
+            scratch.absorbed[to] = absorbed[i];
+        }
+
+        // From the last column back, each column's sorted drops move up past the new drops of
+        // the columns before it, and its own new drops go in after them. Moving up never lands
+        // on a drop that hasn't been moved yet
+        for (std::size_t c = columns; c-- > 0;) {
+            const std::size_t begin = c > 0 ? counts[c - 1] : 0;
+            const std::size_t end = counts[c];
+            const std::size_t before = c > 0 ? added[c - 1] : 0;
+            if (before > 0) {
+                std::copy_backward(x.begin() + begin, x.begin() + end, x.begin() + end + before);
+                std::copy_backward(y.begin() + begin, y.begin() + end, y.begin() + end + before);
+                std::copy_backward(vy.begin() + begin, vy.begin() + end, vy.begin() + end + before);
+                std::copy_backward(size.begin() + begin, size.begin() + end, size.begin() + end + before);
+                std::copy_backward(absorbed.begin() + begin, absorbed.begin() + end, absorbed.begin() + end + before);
+            }
+            const std::size_t from = before;
+            const std::size_t to = end + before;
+            std::copy(scratch.x.begin() + from, scratch.x.begin() + added[c], x.begin() + to);
+            std::copy(scratch.y.begin() + from, scratch.y.begin() + added[c], y.begin() + to);
+            std::copy(scratch.vy.begin() + from, scratch.vy.begin() + added[c], vy.begin() + to);
+            std::copy(scratch.size.begin() + from, scratch.size.begin() + added[c], size.begin() + to);
+            std::copy(scratch.absorbed.begin() + from, scratch.absorbed.begin() + added[c], absorbed.begin() + to);
+            counts[c] = static_cast<std::uint32_t>(end + added[c]);
+        }
+        counts[columns] = static_cast<std::uint32_t>(live);
+    }
+
+    // Drops every element past the first n
+    void truncate(std::size_t n) {
+        live = std::min(live, n);
+    }
+
+    void clear() {
+        live = 0;
+    }
+
+    std::size_t count() const {
+        return live;
+    }
+
+    std::size_t capacity() const {
+        return x.size();
+    }
+
+    // The arrays, of which count() drops are live
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage = vectorUsage(x, live);
+        usage += vectorUsage(y, live);
+        usage += vectorUsage(vy, live);
+        usage += vectorUsage(size, live);
+        usage += vectorUsage(absorbed, live);
+        return usage;
+    }
+
+    // Largest number of drops that were ever live at once, for sizing the pool
+    std::size_t highWaterMark() const {
+        return highWater;
+    }
+
+    // Number of spawns that were turned away because the pool was full
+    std::size_t rejectedCount() const {
+        return rejected;
+    }
+
+    // Drops are drawn and collided as size x 2*size rectangles
+    static float heightOf(float dropSize) {
+        return dropSize * 2.0f;
+    }
+
+    static float areaOf(float dropSize) {
+        return dropSize * heightOf(dropSize);
+    }
+
+    // Only the first count() elements of each array are live
+    std::vector<float, UntouchedAllocator<float>> x;
+    std::vector<float, UntouchedAllocator<float>> y;
+    std::vector<float, UntouchedAllocator<float>> vy;
+    std::vector<float, UntouchedAllocator<float>> size;
+    std::vector<std::uint32_t, UntouchedAllocator<std::uint32_t>> absorbed; // Bit p set once person p has caught the drop
+
+private:
+    std::size_t live;
+    std::size_t highWater;
+    std::size_t rejected;
+};
@@ -0,0 +1,111 @@
+#include "RainIntensity.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "Constants.h"
+#include "DropSizes.h"
+#include "Options.h"
+#include "Person.h"
+#include "RainField.h"
+#include "SfmlCompat.h"
+#include "TerminalVelocity.h"
+
+namespace {
+
+struct IntensityPreset {
+    const char* name;
+    float mmPerHour;
+};
+
+// Roughly where the meteorological bands sit
+const IntensityPreset INTENSITY_PRESETS[] = {
+    { "drizzle", 1.0f },
+    { "moderate", RAIN_INTENSITY },
+    { "heavy", 20.0f },
+    { "downpour", 60.0f },
+};
+
+// Sizes averaged over, evenly spaced in probability as the flux model does
+const int INTENSITY_SIZE_SAMPLES = 64;
+
+} // namespace
+
+bool parseRainIntensity(const char* text, float& mmPerHour) {
+    for (const IntensityPreset& preset : INTENSITY_PRESETS) {
+        if (std::strcmp(text, preset.name) == 0) {
+            mmPerHour = preset.mmPerHour;
+            return true;
+        }
+    }
+    char* end = nullptr;
+    const float value = std::strtof(text, &end);
+    if (end == text || *end != '\0' || value <= 0.0f) {
+        return false;
+    }
+    mmPerHour = value;
+    return true;
+}
+
+float spawnRateFor(const RainConfig& config) {
+    // Water volume of the average drop, a sphere of diameter size * RAINDROP_MM_PER_PIXEL mm
+    const DropSizeTable sizes(config);
+    double volume = 0.0;
+    for (int i = 0; i < INTENSITY_SIZE_SAMPLES; ++i) {
+        const double diameter = sizes.lookup((i + 0.5f) / INTENSITY_SIZE_SAMPLES) * RAINDROP_MM_PER_PIXEL;
+        volume += 3.14159265358979 / 6.0 * diameter * diameter * diameter;
+    }
+    volume /= INTENSITY_SIZE_SAMPLES;
+
+    // R mm per hour over one pixel of width by the slice's depth, both in mm. A pixel is a centimetre
+    const double area = 10.0 * RAIN_SLICE_DEPTH * 1000.0;
+    const double water = config.rainIntensity / 3600.0 * area;
+    return static_cast<float>(water / volume);
+}
+
+float steadyDropCount(const RainConfig& config, float width, float fallHeight) {
+    // Drops of speed v fill the air at spawnRate / v per pixel of width, per pixel of height
+    const DropSizeTable sizes(config);
+    double slowness = 0.0;
+    for (int i = 0; i < INTENSITY_SIZE_SAMPLES; ++i) {
+        slowness += 1.0 / std::max(terminalSpeed(sizes.lookup((i + 0.5f) / INTENSITY_SIZE_SAMPLES)), 1e-3f);
+    }
+    slowness /= INTENSITY_SIZE_SAMPLES;
+    return static_cast<float>(config.spawnRate * width * fallHeight * slowness);
+}
+
+RainStrategy chooseRainStrategy(const RainConfig& config, sf::Vector2u world, sf::Vector2f personSize) {
+    // Everything spawns in the 50 pixels above its top
+    if (steadyDropCount(config, static_cast<float>(world.x), world.y + 50.0f) <= config.maxDrops) {
+        return STRATEGY_FULL;
+    }
+    const sf::FloatRect corridor = travelCorridor(world, personSize);
+    const float fall = world.y - rectTop(corridor) + RainField::heightOf(config.maxSize) + 50.0f;
+    if (steadyDropCount(config, rectWidth(corridor) + config.maxSize, fall) <= config.maxDrops) {
+        return STRATEGY_CORRIDOR;
+    }
+    return STRATEGY_ANALYTIC;
+}
+
+void applyRainIntensity(Options& options) {
+    options.rain.sizeModel = DROP_SIZES_MARSHALL_PALMER;
+    options.rain.spawnRate = spawnRateFor(options.rain);
+    const sf::Vector2u world(options.width, options.height);
+    const RainStrategy strategy = chooseRainStrategy(options.rain, world, sf::Vector2f(options.scenario.personWidth, options.scenario.personHeight));
+    const float drops = steadyDropCount(options.rain, static_cast<float>(world.x), world.y + 50.0f);
+    std::cout << options.rain.rainIntensity << " mm/h is " << options.rain.spawnRate << " drops per second per pixel, about "
+        << static_cast<std::size_t>(drops) << " in the air at once for a pool of " << options.rain.maxDrops << std::endl;
+
+    // Headless crossings only ever simulate their corridor
+    if (options.headless) {
+        if (strategy == STRATEGY_ANALYTIC && !options.analyticOnly) {
+            std::cout << "Too many to simulate even along the person's way, so only the flux model is used (--analytic)" << std::endl;
+            options.analyticOnly = true;
+        }
+    }
+    else if (strategy != STRATEGY_FULL && !options.lod) {
+        std::cout << "Too many to simulate everywhere, so only the person's columns are and the rest is drawn (--lod)" << std::endl;
+        options.lod = true;
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+#include <cstddef>
+
+#include "RainConfig.h"
+
+struct Options;
+
+// How a run simulates its rain, cheapest last
+enum RainStrategy {
+    STRATEGY_FULL,     // Every drop on screen is a particle
+    STRATEGY_CORRIDOR, // Particles only where they can reach the person, as headless crossings do and, by column, --lod
+    STRATEGY_ANALYTIC  // Too many drops for even the corridor: the flux model's estimate instead
+};
+
+// Reads a named preset (drizzle, moderate, heavy or downpour) or a number of mm per hour.
+// Returns false, leaving mmPerHour alone, for anything else
+bool parseRainIntensity(const char* text, float& mmPerHour);
+
+// Spawn rate, in drops per second per pixel of width, that brings config.rainIntensity mm of
+// water per hour down through a slice of air RAIN_SLICE_DEPTH deep in drops of config's sizes
+float spawnRateFor(const RainConfig& config);
+
+// Drops in the air at once, in steady state, over width pixels of rain falling fallHeight pixels
+float steadyDropCount(const RainConfig& config, float width, float fallHeight);
+
+// The most rain that still fits in config.maxDrops as particles: the whole world's, else the
+// corridor's, from just above the person's head down, else none
+RainStrategy chooseRainStrategy(const RainConfig& config, sf::Vector2u world, sf::Vector2f personSize);
+
+// For --rain: sets the spawn rate and Marshall-Palmer sizes for options.rain.rainIntensity,
+// then turns on --lod for a rendered run too heavy for the drop pool, or --analytic for a
+// headless one too heavy even for its corridor. Says what it picked and why on stdout
+void applyRainIntensity(Options& options);
@@ -0,0 +1,832 @@
+#include "RainKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "DropSizes.h"
+#include "Rng.h"
+#include "TerminalVelocity.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define RAINMYTH_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define RAINMYTH_NEON 1
+#include <arm_neon.h>
+#endif
+
+// MSVC lets any function use any intrinsic; GCC and Clang need the target spelled out per function
+#if defined(RAINMYTH_X86) && (defined(__GNUC__) || defined(__clang__))
+#define RAINMYTH_TARGET(isa) __attribute__((target(isa)))
+#else
+#define RAINMYTH_TARGET(isa)
+#endif
+
+// Fast math reassociates behind the strict mode's back, so it has to be asked for by name
+#if (defined(__FAST_MATH__) || defined(_M_FP_FAST)) && !defined(RAINMYTH_FAST_FLOAT)
+#error "Fast math breaks the strict float mode; define RAINMYTH_FAST_FLOAT to build the fast one"
+#endif
+
+namespace {
+
+// Finishes a partial block of up to 8 drops starting at first
+void integrateTail(float* y, const float* vy, std::size_t first, std::size_t count, const IntegrateParams& p, std::uint8_t* flags) {
+    if (first >= count) {
+        return;
+    }
+    std::uint8_t bits = 0;
+    for (std::size_t i = first; i < count; ++i) {
+        y[i] += vy[i] * p.deltaTime;
+        const bool flagged = y[i] > p.killY || (y[i] >= p.bandTop && y[i] <= p.bandBottom);
+        bits |= static_cast<std::uint8_t>(flagged) << (i - first);
+    }
+    flags[first >> 3] = bits;
+}
+
+// Finishes a partial block of up to 8 compact drops starting at first
+void integrateCompactTail(std::int16_t* y, const std::int16_t* dy, std::size_t first, std::size_t count,
+    const CompactIntegrateParams& p, std::uint8_t* flags) {
+    if (first >= count) {
+        return;
+    }
+    std::uint8_t bits = 0;
+    for (std::size_t i = first; i < count; ++i) {
+        const int moved = std::min(std::max(y[i] + dy[i], static_cast<int>(std::numeric_limits<std::int16_t>::min())),
+            static_cast<int>(std::numeric_limits<std::int16_t>::max()));
+        y[i] = static_cast<std::int16_t>(moved);
+        const bool flagged = y[i] > p.killY || (y[i] >= p.bandTop && y[i] <= p.bandBottom);
+        bits |= static_cast<std::uint8_t>(flagged) << (i - first);
+    }
+    flags[first >> 3] = bits;
+}
+
+#if (defined(RAINMYTH_X86) && !defined(__AVX2__)) || defined(RAINMYTH_NEON)
+
+// The four samples around each of four drops, for driftDrops where there's no gather: each
+// lane's cell and the ones right of it, below it and below right
+void gatherTaps(const WindGrid& wind, const std::int32_t* columns, const std::int32_t* rows, float (&taps)[4][4]) {
+    for (int lane = 0; lane < 4; ++lane) {
+        const float* cell = wind.cells + rows[lane] * wind.columns + columns[lane];
+        taps[0][lane] = cell[0];
+        taps[1][lane] = cell[1];
+        taps[2][lane] = cell[wind.columns];
+        taps[3][lane] = cell[wind.columns + 1];
+    }
+}
+
+#endif
+
+#ifdef RAINMYTH_X86
+
+RAINMYTH_TARGET("sse2")
+void integrateSse2(float* y, const float* vy, std::size_t count, const IntegrateParams& p, std::uint8_t* flags) {
+    const __m128 dt = _mm_set1_ps(p.deltaTime);
+    const __m128 killY = _mm_set1_ps(p.killY);
+    const __m128 bandTop = _mm_set1_ps(p.bandTop);
+    const __m128 bandBottom = _mm_set1_ps(p.bandBottom);
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        int bits = 0;
+        for (int half = 0; half < 2; ++half) {
+            const std::size_t j = i + half * 4;
+            const __m128 pos = _mm_add_ps(_mm_loadu_ps(y + j), _mm_mul_ps(_mm_loadu_ps(vy + j), dt));
+            _mm_storeu_ps(y + j, pos);
+
+            const __m128 inBand = _mm_and_ps(_mm_cmpge_ps(pos, bandTop), _mm_cmple_ps(pos, bandBottom));
+            const __m128 flagged = _mm_or_ps(_mm_cmpgt_ps(pos, killY), inBand);
+            bits |= _mm_movemask_ps(flagged) << (half * 4);
+        }
+        flags[i >> 3] = static_cast<std::uint8_t>(bits);
+    }
+    integrateTail(y, vy, i, count, p, flags);
+}
+
+RAINMYTH_TARGET("avx2")
+void integrateAvx2(float* y, const float* vy, std::size_t count, const IntegrateParams& p, std::uint8_t* flags) {
+    const __m256 dt = _mm256_set1_ps(p.deltaTime);
+    const __m256 killY = _mm256_set1_ps(p.killY);
+    const __m256 bandTop = _mm256_set1_ps(p.bandTop);
+    const __m256 bandBottom = _mm256_set1_ps(p.bandBottom);
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        // Multiply and add stay separate instructions so results match the scalar kernel exactly
+        const __m256 pos = _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(_mm256_loadu_ps(vy + i), dt));
+        _mm256_storeu_ps(y + i, pos);
+
+        const __m256 inBand = _mm256_and_ps(_mm256_cmp_ps(pos, bandTop, _CMP_GE_OQ), _mm256_cmp_ps(pos, bandBottom, _CMP_LE_OQ));
+        const __m256 flagged = _mm256_or_ps(_mm256_cmp_ps(pos, killY, _CMP_GT_OQ), inBand);
+        flags[i >> 3] = static_cast<std::uint8_t>(_mm256_movemask_ps(flagged));
+    }
+    integrateTail(y, vy, i, count, p, flags);
+}
+
+bool cpuHasAvx2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    // AVX needs OS support for saving the YMM registers (OSXSAVE + XCR0 bits 1 and 2)
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // RAINMYTH_X86
+
+#ifdef RAINMYTH_NEON
+
+void integrateNeon(float* y, const float* vy, std::size_t count, const IntegrateParams& p, std::uint8_t* flags) {
+    const float32x4_t dt = vdupq_n_f32(p.deltaTime);
+    const float32x4_t killY = vdupq_n_f32(p.killY);
+    const float32x4_t bandTop = vdupq_n_f32(p.bandTop);
+    const float32x4_t bandBottom = vdupq_n_f32(p.bandBottom);
+    const uint32_t laneBitsInit[4] = { 1, 2, 4, 8 };
+    const uint32x4_t laneBits = vld1q_u32(laneBitsInit);
+
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        std::uint32_t bits = 0;
+        for (int half = 0; half < 2; ++half) {
+            const std::size_t j = i + half * 4;
+            const float32x4_t pos = vaddq_f32(vld1q_f32(y + j), vmulq_f32(vld1q_f32(vy + j), dt));
+            vst1q_f32(y + j, pos);
+
+            const uint32x4_t inBand = vandq_u32(vcgeq_f32(pos, bandTop), vcleq_f32(pos, bandBottom));
+            const uint32x4_t flagged = vorrq_u32(vcgtq_f32(pos, killY), inBand);
+            bits |= vaddvq_u32(vandq_u32(flagged, laneBits)) << (half * 4);
+        }
+        flags[i >> 3] = static_cast<std::uint8_t>(bits);
+    }
+    integrateTail(y, vy, i, count, p, flags);
+}
+
+#endif // RAINMYTH_NEON
+
+} // namespace
+
+void integrateCompact(std::int16_t* y, const std::int16_t* dy, std::size_t count, const CompactIntegrateParams& p, std::uint8_t* flags) {
+    std::size_t i = 0;
+#if defined(RAINMYTH_X86)
+    // SSE2 has no >= or <= on 16-bit lanes, so the band test is !(y < top) && !(y > bottom)
+    const __m128i killY = _mm_set1_epi16(p.killY);
+    const __m128i bandTop = _mm_set1_epi16(p.bandTop);
+    const __m128i bandBottom = _mm_set1_epi16(p.bandBottom);
+    for (; i + 8 <= count; i += 8) {
+        __m128i* at = reinterpret_cast<__m128i*>(y + i);
+        const __m128i pos = _mm_adds_epi16(_mm_loadu_si128(at), _mm_loadu_si128(reinterpret_cast<const __m128i*>(dy + i)));
+        _mm_storeu_si128(at, pos);
+
+        const __m128i outside = _mm_or_si128(_mm_cmplt_epi16(pos, bandTop), _mm_cmpgt_epi16(pos, bandBottom));
+        const __m128i flagged = _mm_or_si128(_mm_cmpgt_epi16(pos, killY), _mm_andnot_si128(outside, _mm_set1_epi16(-1)));
+        flags[i >> 3] = static_cast<std::uint8_t>(_mm_movemask_epi8(_mm_packs_epi16(flagged, _mm_setzero_si128())));
+    }
+#elif defined(RAINMYTH_NEON)
+    const int16x8_t killY = vdupq_n_s16(p.killY);
+    const int16x8_t bandTop = vdupq_n_s16(p.bandTop);
+    const int16x8_t bandBottom = vdupq_n_s16(p.bandBottom);
+    const std::uint16_t laneBitsInit[8] = { 1, 2, 4, 8, 16, 32, 64, 128 };
+    const uint16x8_t laneBits = vld1q_u16(laneBitsInit);
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t pos = vqaddq_s16(vld1q_s16(y + i), vld1q_s16(dy + i));
+        vst1q_s16(y + i, pos);
+
+        const uint16x8_t inBand = vandq_u16(vcgeq_s16(pos, bandTop), vcleq_s16(pos, bandBottom));
+        const uint16x8_t flagged = vorrq_u16(vcgtq_s16(pos, killY), inBand);
+        flags[i >> 3] = static_cast<std::uint8_t>(vaddvq_u16(vandq_u16(flagged, laneBits)));
+    }
+#else
+    for (; i + 8 <= count; i += 8) {
+        integrateCompactTail(y, dy, i, i + 8, p, flags);
+    }
+#endif
+    integrateCompactTail(y, dy, i, count, p, flags);
+}
+
+const char* missingInstructionSet() {
+#if defined(RAINMYTH_X86) && defined(__AVX2__)
+    return cpuHasAvx2() ? nullptr : "AVX2";
+#else
+    return nullptr;
+#endif
+}
+
+bool isStrictFloatBuild() {
+#ifdef RAINMYTH_FAST_FLOAT
+    return false;
+#else
+    return true;
+#endif
+}
+
+void integrateScalar(float* y, const float* vy, std::size_t count, const IntegrateParams& params, std::uint8_t* flags) {
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        integrateTail(y, vy, i, i + 8, params, flags);
+    }
+    integrateTail(y, vy, i, count, params, flags);
+}
+
+IntegrateKernel selectIntegrateKernel(const char* requested, const char** name) {
+    const char* want = requested != nullptr ? requested : "";
+
+    if (std::strcmp(want, "scalar") == 0) {
+        *name = "scalar";
+        return integrateScalar;
+    }
+#ifdef RAINMYTH_X86
+    const bool hasAvx2 = cpuHasAvx2();
+    if (std::strcmp(want, "sse2") == 0 || !hasAvx2) {
+        *name = "sse2";
+        return integrateSse2;
+    }
+    *name = "avx2";
+    return integrateAvx2;
+#elif defined(RAINMYTH_NEON)
+    *name = "neon";
+    return integrateNeon;
+#else
+    *name = "scalar";
+    return integrateScalar;
+#endif
+}
+
+void hitTestPeople(const HitBatch& drops, std::size_t count, const HitBox* people, std::size_t peopleCount,
+    std::uint32_t* hits, float* wetness) {
+    std::memset(hits, 0, count * sizeof(std::uint32_t));
+    const std::size_t blocks = count / 4 * 4;
+    for (std::size_t p = 0; p < peopleCount; ++p) {
+        const HitBox& person = people[p];
+        const std::uint32_t bit = 1u << p;
+        float lanes[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        std::size_t i = 0;
+
+#if defined(RAINMYTH_X86)
+        const __m128 left = _mm_set1_ps(person.left);
+        const __m128 top = _mm_set1_ps(person.top);
+        const __m128 right = _mm_set1_ps(person.right);
+        const __m128 bottom = _mm_set1_ps(person.bottom);
+        const __m128i bits = _mm_set1_epi32(static_cast<int>(bit));
+        __m128 sum = _mm_setzero_ps();
+        for (; i < blocks; i += 4) {
+            const __m128 overlapX = _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(drops.left + i), right), _mm_cmpgt_ps(_mm_loadu_ps(drops.right + i), left));
+            const __m128 overlapY = _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(drops.top + i), bottom), _mm_cmpgt_ps(_mm_loadu_ps(drops.bottom + i), top));
+            const __m128i caught = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(drops.absorbed + i)), bits), bits);
+            const __m128 hit = _mm_andnot_ps(_mm_castsi128_ps(caught), _mm_and_ps(overlapX, overlapY));
+            sum = _mm_add_ps(sum, _mm_and_ps(hit, _mm_loadu_ps(drops.area + i)));
+            __m128i* out = reinterpret_cast<__m128i*>(hits + i);
+            _mm_storeu_si128(out, _mm_or_si128(_mm_loadu_si128(out), _mm_and_si128(_mm_castps_si128(hit), bits)));
+        }
+        _mm_storeu_ps(lanes, sum);
+#elif defined(RAINMYTH_NEON)
+        const float32x4_t left = vdupq_n_f32(person.left);
+        const float32x4_t top = vdupq_n_f32(person.top);
+        const float32x4_t right = vdupq_n_f32(person.right);
+        const float32x4_t bottom = vdupq_n_f32(person.bottom);
+        const uint32x4_t bits = vdupq_n_u32(bit);
+        float32x4_t sum = vdupq_n_f32(0.0f);
+        for (; i < blocks; i += 4) {
+            const uint32x4_t overlapX = vandq_u32(vcltq_f32(vld1q_f32(drops.left + i), right), vcgtq_f32(vld1q_f32(drops.right + i), left));
+            const uint32x4_t overlapY = vandq_u32(vcltq_f32(vld1q_f32(drops.top + i), bottom), vcgtq_f32(vld1q_f32(drops.bottom + i), top));
+            const uint32x4_t caught = vtstq_u32(vld1q_u32(drops.absorbed + i), bits);
+            const uint32x4_t hit = vbicq_u32(vandq_u32(overlapX, overlapY), caught);
+            sum = vaddq_f32(sum, vreinterpretq_f32_u32(vandq_u32(hit, vreinterpretq_u32_f32(vld1q_f32(drops.area + i)))));
+            vst1q_u32(hits + i, vorrq_u32(vld1q_u32(hits + i), vandq_u32(hit, bits)));
+        }
+        vst1q_f32(lanes, sum);
+#else
+        for (; i < blocks; i += 4) {
+            for (std::size_t lane = 0; lane < 4; ++lane) {
+                const std::size_t j = i + lane;
+                const bool hit = drops.left[j] < person.right && drops.right[j] > person.left
+                    && drops.top[j] < person.bottom && drops.bottom[j] > person.top && (drops.absorbed[j] & bit) == 0;
+                lanes[lane] += hit ? drops.area[j] : 0.0f;
+                hits[j] |= hit ? bit : 0u;
+            }
+        }
+#endif
+
+        // The last few drops go into the lanes they would have had in a full block
+        for (; i < count; ++i) {
+            const bool hit = drops.left[i] < person.right && drops.right[i] > person.left
+                && drops.top[i] < person.bottom && drops.bottom[i] > person.top && (drops.absorbed[i] & bit) == 0;
+            lanes[i % 4] += hit ? drops.area[i] : 0.0f;
+            hits[i] |= hit ? bit : 0u;
+        }
+        if (wetness) {
+            wetness[p] += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        }
+    }
+}
+
+void driftDrops(float* x, const float* y, std::size_t count, const WindGrid& wind, float deltaTime, float width, float* drift) {
+    // Keep the cell index one short of the last sample, so the four taps are always in the grid
+    const float maxColumn = static_cast<float>(wind.columns - 1) - 1e-3f;
+    const float maxRow = static_cast<float>(wind.rows - 1) - 1e-3f;
+    const float invWidth = 1.0f / width;
+    std::size_t i = 0;
+
+    // Lane for lane the scalar loop's operations in its order, clamps and floor included, so
+    // a drop drifts the same whichever path it takes
+#if defined(RAINMYTH_X86) && defined(__AVX2__)
+    const __m256 originX = _mm256_set1_ps(wind.originX);
+    const __m256 originY = _mm256_set1_ps(wind.originY);
+    const __m256 invCellSize = _mm256_set1_ps(wind.invCellSize);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 lastColumn = _mm256_set1_ps(maxColumn);
+    const __m256 lastRow = _mm256_set1_ps(maxRow);
+    const __m256 dt = _mm256_set1_ps(deltaTime);
+    const __m256 wrap = _mm256_set1_ps(width);
+    const __m256 invWrap = _mm256_set1_ps(invWidth);
+    const __m256i stride = _mm256_set1_epi32(wind.columns);
+    const __m256i one = _mm256_set1_epi32(1);
+    for (; i + 8 <= count; i += 8) {
+        const __m256 px = _mm256_loadu_ps(x + i);
+        // max(0, v) and min(last, v) return v itself for -0 and NaN, as std::max and std::min do
+        const __m256 gx = _mm256_min_ps(lastColumn, _mm256_max_ps(zero, _mm256_mul_ps(_mm256_sub_ps(px, originX), invCellSize)));
+        const __m256 gy = _mm256_min_ps(lastRow, _mm256_max_ps(zero, _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(y + i), originY), invCellSize)));
+        const __m256i column = _mm256_cvttps_epi32(gx);
+        const __m256i row = _mm256_cvttps_epi32(gy);
+        const __m256 tx = _mm256_sub_ps(gx, _mm256_cvtepi32_ps(column));
+        const __m256 ty = _mm256_sub_ps(gy, _mm256_cvtepi32_ps(row));
+
+        const __m256i cell = _mm256_add_epi32(_mm256_mullo_epi32(row, stride), column);
+        const __m256i below = _mm256_add_epi32(cell, stride);
+        const __m256 c0 = _mm256_i32gather_ps(wind.cells, cell, 4);
+        const __m256 c1 = _mm256_i32gather_ps(wind.cells, _mm256_add_epi32(cell, one), 4);
+        const __m256 c2 = _mm256_i32gather_ps(wind.cells, below, 4);
+        const __m256 c3 = _mm256_i32gather_ps(wind.cells, _mm256_add_epi32(below, one), 4);
+        const __m256 upper = _mm256_add_ps(c0, _mm256_mul_ps(_mm256_sub_ps(c1, c0), tx));
+        const __m256 lower = _mm256_add_ps(c2, _mm256_mul_ps(_mm256_sub_ps(c3, c2), tx));
+        const __m256 dx = _mm256_mul_ps(_mm256_add_ps(upper, _mm256_mul_ps(_mm256_sub_ps(lower, upper), ty)), dt);
+
+        const __m256 moved = _mm256_add_ps(px, dx);
+        _mm256_storeu_ps(x + i, _mm256_sub_ps(moved, _mm256_mul_ps(_mm256_floor_ps(_mm256_mul_ps(moved, invWrap)), wrap)));
+        _mm256_storeu_ps(drift + i, dx);
+    }
+#elif defined(RAINMYTH_X86)
+    const __m128 originX = _mm_set1_ps(wind.originX);
+    const __m128 originY = _mm_set1_ps(wind.originY);
+    const __m128 invCellSize = _mm_set1_ps(wind.invCellSize);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 lastColumn = _mm_set1_ps(maxColumn);
+    const __m128 lastRow = _mm_set1_ps(maxRow);
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 wrap = _mm_set1_ps(width);
+    const __m128 invWrap = _mm_set1_ps(invWidth);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 ones = _mm_set1_ps(1.0f);
+    alignas(16) std::int32_t columns[4];
+    alignas(16) std::int32_t rows[4];
+    alignas(16) float taps[4][4];
+    for (; i + 4 <= count; i += 4) {
+        const __m128 px = _mm_loadu_ps(x + i);
+        // max(0, v) and min(last, v) return v itself for -0 and NaN, as std::max and std::min do
+        const __m128 gx = _mm_min_ps(lastColumn, _mm_max_ps(zero, _mm_mul_ps(_mm_sub_ps(px, originX), invCellSize)));
+        const __m128 gy = _mm_min_ps(lastRow, _mm_max_ps(zero, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(y + i), originY), invCellSize)));
+        const __m128i column = _mm_cvttps_epi32(gx);
+        const __m128i row = _mm_cvttps_epi32(gy);
+        const __m128 tx = _mm_sub_ps(gx, _mm_cvtepi32_ps(column));
+        const __m128 ty = _mm_sub_ps(gy, _mm_cvtepi32_ps(row));
+
+        _mm_store_si128(reinterpret_cast<__m128i*>(columns), column);
+        _mm_store_si128(reinterpret_cast<__m128i*>(rows), row);
+        gatherTaps(wind, columns, rows, taps);
+        const __m128 c0 = _mm_load_ps(taps[0]);
+        const __m128 c2 = _mm_load_ps(taps[2]);
+        const __m128 upper = _mm_add_ps(c0, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(taps[1]), c0), tx));
+        const __m128 lower = _mm_add_ps(c2, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(taps[3]), c2), tx));
+        const __m128 dx = _mm_mul_ps(_mm_add_ps(upper, _mm_mul_ps(_mm_sub_ps(lower, upper), ty)), dt);
+
+        // SSE2 has no floor: truncate, step down where that rounded up, and keep -0's sign. The
+        // wrap's argument is a few widths at most, well inside what truncation can hold
+        const __m128 moved = _mm_add_ps(px, dx);
+        const __m128 scaled = _mm_mul_ps(moved, invWrap);
+        const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(scaled));
+        const __m128 floored = _mm_or_ps(_mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, scaled), ones)), _mm_and_ps(scaled, sign));
+        _mm_storeu_ps(x + i, _mm_sub_ps(moved, _mm_mul_ps(floored, wrap)));
+        _mm_storeu_ps(drift + i, dx);
+    }
+#elif defined(RAINMYTH_NEON)
+    const float32x4_t originX = vdupq_n_f32(wind.originX);
+    const float32x4_t originY = vdupq_n_f32(wind.originY);
+    const float32x4_t invCellSize = vdupq_n_f32(wind.invCellSize);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t lastColumn = vdupq_n_f32(maxColumn);
+    const float32x4_t lastRow = vdupq_n_f32(maxRow);
+    const float32x4_t dt = vdupq_n_f32(deltaTime);
+    const float32x4_t wrap = vdupq_n_f32(width);
+    const float32x4_t invWrap = vdupq_n_f32(invWidth);
+    std::int32_t columns[4];
+    std::int32_t rows[4];
+    float taps[4][4];
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t px = vld1q_f32(x + i);
+        // Selected as std::max and std::min choose, since vmaxq and vminq treat -0 and NaN otherwise
+        float32x4_t gx = vmulq_f32(vsubq_f32(px, originX), invCellSize);
+        gx = vbslq_f32(vcltq_f32(gx, zero), zero, gx);
+        gx = vbslq_f32(vcltq_f32(lastColumn, gx), lastColumn, gx);
+        float32x4_t gy = vmulq_f32(vsubq_f32(vld1q_f32(y + i), originY), invCellSize);
+        gy = vbslq_f32(vcltq_f32(gy, zero), zero, gy);
+        gy = vbslq_f32(vcltq_f32(lastRow, gy), lastRow, gy);
+        const int32x4_t column = vcvtq_s32_f32(gx);
+        const int32x4_t row = vcvtq_s32_f32(gy);
+        const float32x4_t tx = vsubq_f32(gx, vcvtq_f32_s32(column));
+        const float32x4_t ty = vsubq_f32(gy, vcvtq_f32_s32(row));
+
+        vst1q_s32(columns, column);
+        vst1q_s32(rows, row);
+        gatherTaps(wind, columns, rows, taps);
+        const float32x4_t c0 = vld1q_f32(taps[0]);
+        const float32x4_t c2 = vld1q_f32(taps[2]);
+        const float32x4_t upper = vaddq_f32(c0, vmulq_f32(vsubq_f32(vld1q_f32(taps[1]), c0), tx));
+        const float32x4_t lower = vaddq_f32(c2, vmulq_f32(vsubq_f32(vld1q_f32(taps[3]), c2), tx));
+        const float32x4_t dx = vmulq_f32(vaddq_f32(upper, vmulq_f32(vsubq_f32(lower, upper), ty)), dt);
+
+        const float32x4_t moved = vaddq_f32(px, dx);
+        vst1q_f32(x + i, vsubq_f32(moved, vmulq_f32(vrndmq_f32(vmulq_f32(moved, invWrap)), wrap)));
+        vst1q_f32(drift + i, dx);
+    }
+#endif
+    for (; i < count; ++i) {
+        const float gx = std::min(std::max((x[i] - wind.originX) * wind.invCellSize, 0.0f), maxColumn);
+        const float gy = std::min(std::max((y[i] - wind.originY) * wind.invCellSize, 0.0f), maxRow);
+        const int column = static_cast<int>(gx);
+        const int row = static_cast<int>(gy);
+        const float tx = gx - column;
+        const float ty = gy - row;
+
+        const float* cell = wind.cells + row * wind.columns + column;
+        const float upper = cell[0] + (cell[1] - cell[0]) * tx;
+        const float lower = cell[wind.columns] + (cell[wind.columns + 1] - cell[wind.columns]) * tx;
+        const float dx = (upper + (lower - upper) * ty) * deltaTime;
+
+        const float moved = x[i] + dx;
+        x[i] = moved - std::floor(moved * invWidth) * width;
+        drift[i] = dx;
+    }
+}
+
+HitShape boxHitShape(const HitBox& box) {
+    HitShape shape = HitShape();
+    shape.kind = HIT_SHAPE_BOX;
+    shape.bounds = box;
+    return shape;
+}
+
+HitShape orientedHitShape(float centreX, float centreY, float halfWidth, float halfHeight, float angle) {
+    HitShape shape = HitShape();
+    shape.kind = HIT_SHAPE_ORIENTED_BOX;
+    shape.x = centreX;
+    shape.y = centreY;
+    shape.ux = std::cos(angle);
+    shape.uy = std::sin(angle);
+    shape.halfWidth = halfWidth;
+    shape.halfHeight = halfHeight;
+    const float reachX = halfWidth * std::abs(shape.ux) + halfHeight * std::abs(shape.uy);
+    const float reachY = halfWidth * std::abs(shape.uy) + halfHeight * std::abs(shape.ux);
+    const HitBox bounds = { centreX - reachX, centreY - reachY, centreX + reachX, centreY + reachY };
+    shape.bounds = bounds;
+    return shape;
+}
+
+HitShape capsuleHitShape(float startX, float startY, float endX, float endY, float radius) {
+    HitShape shape = HitShape();
+    shape.kind = HIT_SHAPE_CAPSULE;
+    shape.x = startX;
+    shape.y = startY;
+    shape.ux = endX - startX;
+    shape.uy = endY - startY;
+    shape.halfWidth = radius;
+    const float lengthSquared = shape.ux * shape.ux + shape.uy * shape.uy;
+    shape.inverse = lengthSquared > 0.0f ? 1.0f / lengthSquared : 0.0f;
+    const HitBox bounds = { std::min(startX, endX) - radius, std::min(startY, endY) - radius, std::max(startX, endX) + radius,
+        std::max(startY, endY) + radius };
+    shape.bounds = bounds;
+    return shape;
+}
+
+namespace {
+
+// The precise tests, on one drop's rectangle. Those for four at a time below follow them step
+// for step. An oriented box is tested on its own two axes, the bounds test having covered the
+// screen's. Two segments in a plane that don't cross are closest at an end of one of them, so a
+// capsule only needs each end of one against the other, and a test for crossing
+bool touchesOrientedBox(const HitShape& shape, float left, float top, float right, float bottom) {
+    const float hx = (right - left) * 0.5f;
+    const float hy = (bottom - top) * 0.5f;
+    const float dx = left + hx - shape.x;
+    const float dy = top + hy - shape.y;
+    const float alongU = std::abs(dx * shape.ux + dy * shape.uy);
+    const float reachU = shape.halfWidth + hx * std::abs(shape.ux) + hy * std::abs(shape.uy);
+    const float alongV = std::abs(dy * shape.ux - dx * shape.uy);
+    const float reachV = shape.halfHeight + hx * std::abs(shape.uy) + hy * std::abs(shape.ux);
+    return alongU < reachU && alongV < reachV;
+}
+
+float distanceToSpineSquared(const HitShape& shape, float px, float py) {
+    const float ax = px - shape.x;
+    const float ay = py - shape.y;
+    const float s = std::min(std::max((ax * shape.ux + ay * shape.uy) * shape.inverse, 0.0f), 1.0f);
+    const float ex = ax - s * shape.ux;
+    const float ey = ay - s * shape.uy;
+    return ex * ex + ey * ey;
+}
+
+// From (px, py) to the vertical segment at x from top to bottom
+float distanceToLineSquared(float px, float py, float x, float top, float bottom) {
+    const float ex = px - x;
+    const float ey = std::max(std::max(top - py, py - bottom), 0.0f);
+    return ex * ex + ey * ey;
+}
+
+// Where a capsule's spine crosses a vertical line, without dividing: a line offset to the right
+// of the spine's start, flipped by sign when the spine runs left, crosses it offset / run of the
+// way along, at height (y * run + offset * uy) / run. An upright spine has no run and crosses nothing
+struct SpineCrossing {
+    float sign;
+    float run;
+
+    explicit SpineCrossing(const HitShape& shape) : sign(shape.ux < 0.0f ? -1.0f : 1.0f), run(std::abs(shape.ux)) {}
+};
+
+bool touchesCapsule(const HitShape& shape, float left, float top, float right, float bottom) {
+    // The drop as a capsule of its own: a vertical line through its middle, with its half width
+    // for radius, ending that far inside its top and bottom
+    const float hx = (right - left) * 0.5f;
+    const float cx = left + hx;
+    const float lineTop = top + hx;
+    const float lineBottom = std::max(bottom - hx, lineTop);
+    const float closest = std::min(std::min(distanceToSpineSquared(shape, cx, lineTop), distanceToSpineSquared(shape, cx, lineBottom)),
+        std::min(distanceToLineSquared(shape.x, shape.y, cx, lineTop, lineBottom),
+            distanceToLineSquared(shape.x + shape.ux, shape.y + shape.uy, cx, lineTop, lineBottom)));
+    const float reach = shape.halfWidth + hx;
+    const SpineCrossing crossing(shape);
+    const float offset = (cx - shape.x) * crossing.sign;
+    const float crossY = shape.y * crossing.run + offset * shape.uy;
+    const bool crosses = offset >= 0.0f && offset <= crossing.run && crossY >= lineTop * crossing.run && crossY <= lineBottom * crossing.run;
+    return closest < reach * reach || (crosses && crossing.run > 0.0f);
+}
+
+bool touchesShape(const HitShape& shape, float left, float top, float right, float bottom) {
+    switch (shape.kind) {
+    case HIT_SHAPE_ORIENTED_BOX:
+        return touchesOrientedBox(shape, left, top, right, bottom);
+    case HIT_SHAPE_CAPSULE:
+        return touchesCapsule(shape, left, top, right, bottom);
+    default:
+        return true;
+    }
+}
+
+#if defined(RAINMYTH_X86)
+__m128 absSse2(__m128 v) {
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+}
+
+__m128 touchesOrientedBoxSse2(const HitShape& shape, __m128 left, __m128 top, __m128 right, __m128 bottom) {
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 ux = _mm_set1_ps(shape.ux);
+    const __m128 uy = _mm_set1_ps(shape.uy);
+    const __m128 absUx = absSse2(ux);
+    const __m128 absUy = absSse2(uy);
+    const __m128 hx = _mm_mul_ps(_mm_sub_ps(right, left), half);
+    const __m128 hy = _mm_mul_ps(_mm_sub_ps(bottom, top), half);
+    const __m128 dx = _mm_sub_ps(_mm_add_ps(left, hx), _mm_set1_ps(shape.x));
+    const __m128 dy = _mm_sub_ps(_mm_add_ps(top, hy), _mm_set1_ps(shape.y));
+    const __m128 alongU = absSse2(_mm_add_ps(_mm_mul_ps(dx, ux), _mm_mul_ps(dy, uy)));
+    const __m128 reachU = _mm_add_ps(_mm_set1_ps(shape.halfWidth), _mm_add_ps(_mm_mul_ps(hx, absUx), _mm_mul_ps(hy, absUy)));
+    const __m128 alongV = absSse2(_mm_sub_ps(_mm_mul_ps(dy, ux), _mm_mul_ps(dx, uy)));
+    const __m128 reachV = _mm_add_ps(_mm_set1_ps(shape.halfHeight), _mm_add_ps(_mm_mul_ps(hx, absUy), _mm_mul_ps(hy, absUx)));
+    return _mm_and_ps(_mm_cmplt_ps(alongU, reachU), _mm_cmplt_ps(alongV, reachV));
+}
+
+__m128 distanceToSpineSquaredSse2(const HitShape& shape, __m128 px, __m128 py) {
+    const __m128 ux = _mm_set1_ps(shape.ux);
+    const __m128 uy = _mm_set1_ps(shape.uy);
+    const __m128 ax = _mm_sub_ps(px, _mm_set1_ps(shape.x));
+    const __m128 ay = _mm_sub_ps(py, _mm_set1_ps(shape.y));
+    const __m128 projected = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(ax, ux), _mm_mul_ps(ay, uy)), _mm_set1_ps(shape.inverse));
+    const __m128 s = _mm_min_ps(_mm_max_ps(projected, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+    const __m128 ex = _mm_sub_ps(ax, _mm_mul_ps(s, ux));
+    const __m128 ey = _mm_sub_ps(ay, _mm_mul_ps(s, uy));
+    return _mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey));
+}
+
+__m128 distanceToLineSquaredSse2(float px, float py, __m128 x, __m128 top, __m128 bottom) {
+    const __m128 y = _mm_set1_ps(py);
+    const __m128 ex = _mm_sub_ps(_mm_set1_ps(px), x);
+    const __m128 ey = _mm_max_ps(_mm_max_ps(_mm_sub_ps(top, y), _mm_sub_ps(y, bottom)), _mm_setzero_ps());
+    return _mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey));
+}
+
+__m128 touchesCapsuleSse2(const HitShape& shape, __m128 left, __m128 top, __m128 right, __m128 bottom) {
+    const __m128 hx = _mm_mul_ps(_mm_sub_ps(right, left), _mm_set1_ps(0.5f));
+    const __m128 cx = _mm_add_ps(left, hx);
+    const __m128 lineTop = _mm_add_ps(top, hx);
+    const __m128 lineBottom = _mm_max_ps(_mm_sub_ps(bottom, hx), lineTop);
+    const __m128 closest = _mm_min_ps(_mm_min_ps(distanceToSpineSquaredSse2(shape, cx, lineTop), distanceToSpineSquaredSse2(shape, cx, lineBottom)),
+        _mm_min_ps(distanceToLineSquaredSse2(shape.x, shape.y, cx, lineTop, lineBottom),
+            distanceToLineSquaredSse2(shape.x + shape.ux, shape.y + shape.uy, cx, lineTop, lineBottom)));
+    const __m128 reach = _mm_add_ps(_mm_set1_ps(shape.halfWidth), hx);
+    const SpineCrossing crossing(shape);
+    const __m128 run = _mm_set1_ps(crossing.run);
+    const __m128 offset = _mm_mul_ps(_mm_sub_ps(cx, _mm_set1_ps(shape.x)), _mm_set1_ps(crossing.sign));
+    const __m128 crossY = _mm_add_ps(_mm_set1_ps(shape.y * crossing.run), _mm_mul_ps(offset, _mm_set1_ps(shape.uy)));
+    const __m128 crosses = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(offset, _mm_setzero_ps()), _mm_cmple_ps(offset, run)),
+        _mm_and_ps(_mm_cmpge_ps(crossY, _mm_mul_ps(lineTop, run)), _mm_cmple_ps(crossY, _mm_mul_ps(lineBottom, run))));
+    return _mm_or_ps(_mm_cmplt_ps(closest, _mm_mul_ps(reach, reach)), _mm_and_ps(crosses, _mm_cmpgt_ps(run, _mm_setzero_ps())));
+}
+#elif defined(RAINMYTH_NEON)
+uint32x4_t touchesOrientedBoxNeon(const HitShape& shape, float32x4_t left, float32x4_t top, float32x4_t right, float32x4_t bottom) {
+    const float32x4_t half = vdupq_n_f32(0.5f);
+    const float32x4_t ux = vdupq_n_f32(shape.ux);
+    const float32x4_t uy = vdupq_n_f32(shape.uy);
+    const float32x4_t absUx = vabsq_f32(ux);
+    const float32x4_t absUy = vabsq_f32(uy);
+    const float32x4_t hx = vmulq_f32(vsubq_f32(right, left), half);
+    const float32x4_t hy = vmulq_f32(vsubq_f32(bottom, top), half);
+    const float32x4_t dx = vsubq_f32(vaddq_f32(left, hx), vdupq_n_f32(shape.x));
+    const float32x4_t dy = vsubq_f32(vaddq_f32(top, hy), vdupq_n_f32(shape.y));
+    const float32x4_t alongU = vabsq_f32(vaddq_f32(vmulq_f32(dx, ux), vmulq_f32(dy, uy)));
+    const float32x4_t reachU = vaddq_f32(vdupq_n_f32(shape.halfWidth), vaddq_f32(vmulq_f32(hx, absUx), vmulq_f32(hy, absUy)));
+    const float32x4_t alongV = vabsq_f32(vsubq_f32(vmulq_f32(dy, ux), vmulq_f32(dx, uy)));
+    const float32x4_t reachV = vaddq_f32(vdupq_n_f32(shape.halfHeight), vaddq_f32(vmulq_f32(hx, absUy), vmulq_f32(hy, absUx)));
+    return vandq_u32(vcltq_f32(alongU, reachU), vcltq_f32(alongV, reachV));
+}
+
+float32x4_t distanceToSpineSquaredNeon(const HitShape& shape, float32x4_t px, float32x4_t py) {
+    const float32x4_t ux = vdupq_n_f32(shape.ux);
+    const float32x4_t uy = vdupq_n_f32(shape.uy);
+    const float32x4_t ax = vsubq_f32(px, vdupq_n_f32(shape.x));
+    const float32x4_t ay = vsubq_f32(py, vdupq_n_f32(shape.y));
+    const float32x4_t projected = vmulq_f32(vaddq_f32(vmulq_f32(ax, ux), vmulq_f32(ay, uy)), vdupq_n_f32(shape.inverse));
+    const float32x4_t s = vminq_f32(vmaxq_f32(projected, vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f));
+    const float32x4_t ex = vsubq_f32(ax, vmulq_f32(s, ux));
+    const float32x4_t ey = vsubq_f32(ay, vmulq_f32(s, uy));
+    return vaddq_f32(vmulq_f32(ex, ex), vmulq_f32(ey, ey));
+}
+
+float32x4_t distanceToLineSquaredNeon(float px, float py, float32x4_t x, float32x4_t top, float32x4_t bottom) {
+    const float32x4_t y = vdupq_n_f32(py);
+    const float32x4_t ex = vsubq_f32(vdupq_n_f32(px), x);
+    const float32x4_t ey = vmaxq_f32(vmaxq_f32(vsubq_f32(top, y), vsubq_f32(y, bottom)), vdupq_n_f32(0.0f));
+    return vaddq_f32(vmulq_f32(ex, ex), vmulq_f32(ey, ey));
+}
+
+uint32x4_t touchesCapsuleNeon(const HitShape& shape, float32x4_t left, float32x4_t top, float32x4_t right, float32x4_t bottom) {
+    const float32x4_t hx = vmulq_f32(vsubq_f32(right, left), vdupq_n_f32(0.5f));
+    const float32x4_t cx = vaddq_f32(left, hx);
+    const float32x4_t lineTop = vaddq_f32(top, hx);
+    const float32x4_t lineBottom = vmaxq_f32(vsubq_f32(bottom, hx), lineTop);
+    const float32x4_t closest = vminq_f32(vminq_f32(distanceToSpineSquaredNeon(shape, cx, lineTop), distanceToSpineSquaredNeon(shape, cx, lineBottom)),
+        vminq_f32(distanceToLineSquaredNeon(shape.x, shape.y, cx, lineTop, lineBottom),
+            distanceToLineSquaredNeon(shape.x + shape.ux, shape.y + shape.uy, cx, lineTop, lineBottom)));
+    const float32x4_t reach = vaddq_f32(vdupq_n_f32(shape.halfWidth), hx);
+    const SpineCrossing crossing(shape);
+    const float32x4_t run = vdupq_n_f32(crossing.run);
+    const float32x4_t offset = vmulq_f32(vsubq_f32(cx, vdupq_n_f32(shape.x)), vdupq_n_f32(crossing.sign));
+    const float32x4_t crossY = vaddq_f32(vdupq_n_f32(shape.y * crossing.run), vmulq_f32(offset, vdupq_n_f32(shape.uy)));
+    const uint32x4_t crosses = vandq_u32(vandq_u32(vcgeq_f32(offset, vdupq_n_f32(0.0f)), vcleq_f32(offset, run)),
+        vandq_u32(vcgeq_f32(crossY, vmulq_f32(lineTop, run)), vcleq_f32(crossY, vmulq_f32(lineBottom, run))));
+    return vorrq_u32(vcltq_f32(closest, vmulq_f32(reach, reach)), vandq_u32(crosses, vcgtq_f32(run, vdupq_n_f32(0.0f))));
+}
+#endif
+
+} // namespace
+
+void hitTestShapes(const HitBatch& drops, std::size_t count, const HitShape* shapes, std::size_t shapeCount,
+    std::uint32_t* hits, float* wetness) {
+    std::memset(hits, 0, count * sizeof(std::uint32_t));
+    const std::size_t blocks = count / 4 * 4;
+    for (std::size_t p = 0; p < shapeCount; ++p) {
+        const HitShape& shape = shapes[p];
+        const HitBox& bounds = shape.bounds;
+        const std::uint32_t bit = 1u << p;
+        float lanes[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        std::size_t i = 0;
+
+#if defined(RAINMYTH_X86)
+        const __m128 left = _mm_set1_ps(bounds.left);
+        const __m128 top = _mm_set1_ps(bounds.top);
+        const __m128 right = _mm_set1_ps(bounds.right);
+        const __m128 bottom = _mm_set1_ps(bounds.bottom);
+        const __m128i bits = _mm_set1_epi32(static_cast<int>(bit));
+        __m128 sum = _mm_setzero_ps();
+        for (; i < blocks; i += 4) {
+            const __m128 dropLeft = _mm_loadu_ps(drops.left + i);
+            const __m128 dropTop = _mm_loadu_ps(drops.top + i);
+            const __m128 dropRight = _mm_loadu_ps(drops.right + i);
+            const __m128 dropBottom = _mm_loadu_ps(drops.bottom + i);
+            const __m128 overlapX = _mm_and_ps(_mm_cmplt_ps(dropLeft, right), _mm_cmpgt_ps(dropRight, left));
+            const __m128 overlapY = _mm_and_ps(_mm_cmplt_ps(dropTop, bottom), _mm_cmpgt_ps(dropBottom, top));
+            const __m128i caught = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(drops.absorbed + i)), bits), bits);
+            __m128 hit = _mm_andnot_ps(_mm_castsi128_ps(caught), _mm_and_ps(overlapX, overlapY));
+            if (_mm_movemask_ps(hit) == 0) {
+                continue;
+            }
+            if (shape.kind == HIT_SHAPE_ORIENTED_BOX) {
+                hit = _mm_and_ps(hit, touchesOrientedBoxSse2(shape, dropLeft, dropTop, dropRight, dropBottom));
+            }
+            else if (shape.kind == HIT_SHAPE_CAPSULE) {
+                hit = _mm_and_ps(hit, touchesCapsuleSse2(shape, dropLeft, dropTop, dropRight, dropBottom));
+            }
+            sum = _mm_add_ps(sum, _mm_and_ps(hit, _mm_loadu_ps(drops.area + i)));
+            __m128i* out = reinterpret_cast<__m128i*>(hits + i);
+            _mm_storeu_si128(out, _mm_or_si128(_mm_loadu_si128(out), _mm_and_si128(_mm_castps_si128(hit), bits)));
+        }
+        _mm_storeu_ps(lanes, sum);
+#elif defined(RAINMYTH_NEON)
+        const float32x4_t left = vdupq_n_f32(bounds.left);
+        const float32x4_t top = vdupq_n_f32(bounds.top);
+        const float32x4_t right = vdupq_n_f32(bounds.right);
+        const float32x4_t bottom = vdupq_n_f32(bounds.bottom);
+        const uint32x4_t bits = vdupq_n_u32(bit);
+        float32x4_t sum = vdupq_n_f32(0.0f);
+        for (; i < blocks; i += 4) {
+            const float32x4_t dropLeft = vld1q_f32(drops.left + i);
+            const float32x4_t dropTop = vld1q_f32(drops.top + i);
+            const float32x4_t dropRight = vld1q_f32(drops.right + i);
+            const float32x4_t dropBottom = vld1q_f32(drops.bottom + i);
+            const uint32x4_t overlapX = vandq_u32(vcltq_f32(dropLeft, right), vcgtq_f32(dropRight, left));
+            const uint32x4_t overlapY = vandq_u32(vcltq_f32(dropTop, bottom), vcgtq_f32(dropBottom, top));
+            const uint32x4_t caught = vtstq_u32(vld1q_u32(drops.absorbed + i), bits);
+            uint32x4_t hit = vbicq_u32(vandq_u32(overlapX, overlapY), caught);
+            const uint32x2_t folded = vorr_u32(vget_low_u32(hit), vget_high_u32(hit));
+            if ((vget_lane_u32(folded, 0) | vget_lane_u32(folded, 1)) == 0) {
+                continue;
+            }
+            if (shape.kind == HIT_SHAPE_ORIENTED_BOX) {
+                hit = vandq_u32(hit, touchesOrientedBoxNeon(shape, dropLeft, dropTop, dropRight, dropBottom));
+            }
+            else if (shape.kind == HIT_SHAPE_CAPSULE) {
+                hit = vandq_u32(hit, touchesCapsuleNeon(shape, dropLeft, dropTop, dropRight, dropBottom));
+            }
+            sum = vaddq_f32(sum, vreinterpretq_f32_u32(vandq_u32(hit, vreinterpretq_u32_f32(vld1q_f32(drops.area + i)))));
+            vst1q_u32(hits + i, vorrq_u32(vld1q_u32(hits + i), vandq_u32(hit, bits)));
+        }
+        vst1q_f32(lanes, sum);
+#endif
+
+        // Whatever the vector paths left, including every drop where there are none
+        for (; i < count; ++i) {
+            const bool hit = drops.left[i] < bounds.right && drops.right[i] > bounds.left && drops.top[i] < bounds.bottom
+                && drops.bottom[i] > bounds.top && (drops.absorbed[i] & bit) == 0
+                && touchesShape(shape, drops.left[i], drops.top[i], drops.right[i], drops.bottom[i]);
+            lanes[i % 4] += hit ? drops.area[i] : 0.0f;
+            hits[i] |= hit ? bit : 0u;
+        }
+        if (wetness) {
+            wetness[p] += (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        }
+    }
+}
+
+void fillSpawns(const CounterRng& rng, std::uint64_t step, std::uint32_t first, std::size_t count, const SpawnParams& params,
+    const DropSizeTable& sizes, const TerminalVelocityTable& speeds, float* x, float* y, float* vy, float* size, std::uint32_t* absorbed) {
+    rng.fillUniform3(step, first, count, x, y, size);
+    for (std::size_t i = 0; i < count; ++i) {
+        x[i] = params.left + x[i] * params.width;
+        y[i] = params.top - 50.0f + 50.0f * y[i];
+        size[i] = sizes.lookup(size[i]);
+        vy[i] = speeds.lookup(size[i]);
+    }
+    std::fill(absorbed, absorbed + count, params.caught);
+}
+
+std::size_t compactDrops(float* x, float* y, float* vy, float* size, std::uint32_t* absorbed, std::size_t count, const std::uint8_t* flags) {
+    // Skips the living up to the first death without moving them, a byte of flags at a time
+    std::size_t block = 0;
+    while (block * 8 < count && flags[block] == 0) {
+        ++block;
+    }
+    std::size_t kept = std::min(block * 8, count);
+    for (std::size_t i = kept; i < count; ++i) {
+        if (((flags[i >> 3] >> (i & 7)) & 1u) != 0) {
+            continue;
+        }
+        x[kept] = x[i];
+        y[kept] = y[i];
+        vy[kept] = vy[i];
+        size[kept] = size[i];
+        absorbed[kept] = absorbed[i];
+        ++kept;
+    }
+    return kept;
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class CounterRng;
+class DropSizeTable;
+class TerminalVelocityTable;
+
+// Inputs shared by every integration kernel for one step
+struct IntegrateParams {
+    float deltaTime;
+    float killY;        // Drops below this line are off-screen
+    float bandTop;      // Drops with bandTop <= y <= bandBottom may touch a collider
+    float bandBottom;
+};
+
+// Advances y of drops [0, count) in place by their fixed fall speed vy. Drops spawn at their
+// terminal velocity, so vy never changes and is only read. Sets bit (i & 7) of flags[i >> 3]
+// for every drop that ended the step off-screen or inside the collider band; all other bits
+// are cleared, so the caller only has to look at flagged drops. flags must hold (count + 7) / 8 bytes
+typedef void (*IntegrateKernel)(float* y, const float* vy, std::size_t count, const IntegrateParams& params, std::uint8_t* flags);
+
+// Reference implementation, always available
+void integrateScalar(float* y, const float* vy, std::size_t count, const IntegrateParams& params, std::uint8_t* flags);
+
+// Fixed-point counterpart of IntegrateParams for CompactRainField, in 1/COMPACT_SUBPIXELS pixels.
+// The step length is already folded into each drop's dy
+struct CompactIntegrateParams {
+    std::int16_t killY;
+    std::int16_t bandTop;
+    std::int16_t bandBottom;
+};
+
+// Same contract as IntegrateKernel, on 16-bit fixed-point positions: advances y of drops
+// [0, count) by dy, saturating rather than wrapping, and sets their flag bits the same way.
+// Eight drops at a time where SSE2 or NEON is there, with results identical to the scalar loop
+void integrateCompact(std::int16_t* y, const std::int16_t* dy, std::size_t count, const CompactIntegrateParams& params, std::uint8_t* flags);
+
+// A coarse grid of horizontal wind speeds, row by row, with the position of its first sample
+// and the inverse of the spacing between samples
+struct WindGrid {
+    const float* cells;
+    int columns;
+    int rows;
+    float originX;
+    float originY;
+    float invCellSize;
+};
+
+// Moves drops [0, count) sideways by the wind at their position over deltaTime, bilinearly
+// interpolated between the four surrounding grid samples and clamped at the grid's edges.
+// Drops blown off one side come back in on the other, so the rain's density holds. The
+// displacement of each drop goes to drift, for sweeping its collisions. Eight drops at a time
+// with AVX2's gathers where the build assumes it, else four with SSE2 or NEON reading the samples
+// lane by lane, with results identical to the scalar loop
+void driftDrops(float* x, const float* y, std::size_t count, const WindGrid& wind, float deltaTime, float width, float* drift);
+
+// An axis-aligned rectangle by its edges, for the hit test
+struct HitBox {
+    float left;
+    float top;
+    float right;
+    float bottom;
+};
+
+// A batch of drop rectangles as one array per edge, plus each drop's area and the people who
+// already caught it
+struct HitBatch {
+    const float* left;
+    const float* top;
+    const float* right;
+    const float* bottom;
+    const float* area;
+    const std::uint32_t* absorbed;
+};
+
+// Tests drops [0, count) of the batch against every one of peopleCount rectangles, with the
+// same strict overlap rule as sf::FloatRect::intersects for rectangles of positive size. Sets
+// bit p of hits[i] when drop i overlaps person p and bit p of its absorbed mask is clear, and
+// adds the areas of those drops to wetness[p], unless wetness is null, so a drop is only ever
+// caught once per person. Branchless and four drops at a time where SSE2 or NEON is there; the sums are taken lane by
+// lane and then across lanes, so they don't depend on which path ran
+void hitTestPeople(const HitBatch& drops, std::size_t count, const HitBox* people, std::size_t peopleCount,
+    std::uint32_t* hits, float* wetness);
+
+// What a person catches rain with, when that isn't simply their box
+enum HitShapeKind {
+    HIT_SHAPE_BOX,          // Just bounds
+    HIT_SHAPE_ORIENTED_BOX, // A rectangle turned about its centre
+    HIT_SHAPE_CAPSULE       // Everything within a radius of a line segment, its spine
+};
+
+// A shape with the box that encloses it, which hitTestShapes tests first and which is all it
+// tests for HIT_SHAPE_BOX. Made by the functions below
+struct HitShape {
+    HitShapeKind kind;
+    HitBox bounds;
+    float x;          // Centre of an oriented box, or the start of a capsule's spine
+    float y;
+    float ux;         // Unit vector along an oriented box's width, or a capsule's spine from start to end
+    float uy;
+    float halfWidth;  // Half an oriented box's extents along u and across it, or a capsule's radius
+    float halfHeight;
+    float inverse;    // A capsule's 1 / |u|^2, or 0 if its spine is a point
+};
+
+HitShape boxHitShape(const HitBox& box);
+// angle is in radians, clockwise on screen since y points down
+HitShape orientedHitShape(float centreX, float centreY, float halfWidth, float halfHeight, float angle);
+HitShape capsuleHitShape(float startX, float startY, float endX, float endY, float radius);
+
+// hitTestPeople for people of any HitShape, with the same contract: bit p of hits[i] is set and
+// the drop's area added to wetness[p] when drop i touches shape p and hasn't been caught by p
+// already. Each block of four drops is first tested against the shape's bounds, and only a
+// block with a drop inside them goes on to the precise test, which is also four at a time. A
+// drop counts as touching an oriented box when its rectangle overlaps it, and a capsule when
+// the capsule comes within half the drop's width of the drop's centre line
+void hitTestShapes(const HitBatch& drops, std::size_t count, const HitShape* shapes, std::size_t shapeCount,
+    std::uint32_t* hits, float* wetness);
+
+// Where a batch of spawns goes: across [left, left + width), and in the 50 pixels above top
+struct SpawnParams {
+    float left;
+    float width;
+    float top;
+    std::uint32_t caught; // People who count as having caught the new drops already
+};
+
+// Fills drops [0, count) of the arrays as spawns first to first + count - 1 of step, each drawn
+// from rng at that counter alone, with widths from sizes and fall speeds to match from speeds.
+// The same spawns come out whoever fills which part of a step
+void fillSpawns(const CounterRng& rng, std::uint64_t step, std::uint32_t first, std::size_t count, const SpawnParams& params,
+    const DropSizeTable& sizes, const TerminalVelocityTable& speeds, float* x, float* y, float* vy, float* size, std::uint32_t* absorbed);
+
+// Removes the drops among [0, count) flagged as integrate kernels flag them, sliding the rest
+// down over them so they keep their order, and returns how many are left
+std::size_t compactDrops(float* x, float* y, float* vy, float* size, std::uint32_t* absorbed, std::size_t count, const std::uint8_t* flags);
+
+// Picks a kernel by name ("scalar", "sse2", "avx2", "neon") or, for any other name, the widest
+// one this CPU supports. Unsupported names fall back to that too. name receives the choice
+IntegrateKernel selectIntegrateKernel(const char* requested, const char** name);
+
+// The instruction set this build was compiled to assume that this CPU lacks, such as AVX2 for
+// the Release-PGO configuration, or nullptr if it has everything the build uses. Programs
+// check it first, before anything compiled for that instruction set runs
+const char* missingInstructionSet();
+
+// Whether this build keeps every float operation as written, with no FMA contraction or
+// reassociation. Kernels of every width already share one order of operations, reductions
+// included: hits sum in four lanes combined pairwise, chunks of DROPS_PER_CHUNK in chunk
+// order. So a strict build gives the same bits with any kernel and thread count, and its
+// replays reproduce on any other strict build. Building with RAINMYTH_FAST_FLOAT lets the
+// compiler contract and reassociate, and only holds results to --validate's tolerances
+bool isStrictFloatBuild();
@@ -0,0 +1,1975 @@
+#pragma once
+
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "AabbTree.h"
+#include "CollisionGrid.h"
+#include "Constants.h"
+#include "CycleTimer.h"
+#include "DropLifetimes.h"
+#include "DropSizes.h"
+#include "GroundWater.h"
+#include "Instrument.h"
+#include "RainConfig.h"
+#include "JobSystem.h"
+#include "MemoryUsage.h"
+#include "RainField.h"
+#include "RainKernels.h"
+#include "Rng.h"
+#include "Scene.h"
+#include "SfmlCompat.h"
+#include "SplashSystem.h"
+#include "SurfaceWetness.h"
+#include "TerminalVelocity.h"
+#include "WindField.h"
+
+// Where the last RainSystem::update spent its time, in seconds
+struct StepTimings {
+    float integrate; // Wall time of the parallel integrate-and-collide pass
+    float collision; // Part of that pass spent testing flagged drops, summed over every worker,
+                     // so with several threads it can exceed the pass's wall time
+    float cull;      // Removing dead drops
+    float spawn;     // Spawning new ones
+};
+
+// How much work the last RainSystem::update's collision pass did, to check that the
+// broadphase is cutting it down. Each chunk counts into its own, like its share of the
+// wetness, so workers never share a counter, and the chunks' are summed afterwards
+struct CollisionCounters {
+    std::uint32_t tested;          // Drops the kernel flagged and the chunk looked at
+    std::uint32_t candidates;      // Of those, the ones the broadphase put near someone
+    std::uint32_t pairs;           // Candidate and person pairs the batched test ran
+    std::uint32_t contacts;        // Pairs whose swept boxes met, checked for the moment of contact
+    std::uint32_t hits;            // Catches
+    std::uint32_t culledByScene;   // Drops that landed on a collider
+    std::uint32_t culledOffscreen; // Drops that reached the ground
+
+    CollisionCounters& operator+=(const CollisionCounters& other) {
+        tested += other.tested;
+        candidates += other.candidates;
+        pairs += other.pairs;
+        contacts += other.contacts;
+        hits += other.hits;
+        culledByScene += other.culledByScene;
+        culledOffscreen += other.culledOffscreen;
+        return *this;
+    }
+};
+
+// A drop someone caught, for hit logs. Drops aren't tracked from step to step, so drop is only
+// where the drop sat in the store when it was caught; its size, fixed when it spawned, is what
+// tells it apart from the others caught by the same person or by someone else later on
+struct RainHit {
+    std::uint32_t drop;
+    std::uint32_t person;
+    float size;
+    BodySurface surface;
+};
+
+// Everything a RainSystem carries from one step to the next besides its drops, as plain data
+// for snapshots. How it was configured and the scene it was built for are kept alongside
+struct RainState {
+    std::uint32_t rng[4];
+    std::uint64_t spawnStep;
+    float windTime;
+    float spawnRate;
+    float spawnCarry;
+    float spawnLeft;
+    float spawnRight;
+    float spawnTop;
+    float fullLeft;
+    float fullRight;
+    float outerDensity;
+    std::uint32_t trackedPeople; // How many of previousBoxes are set
+    std::uint64_t displaced;
+    HitBox previousBoxes[MAX_PEOPLE];
+    float personFacing[MAX_PEOPLE];
+};
+
+// A class to manage the entire rain system
+class RainSystem {
+public:
+    RainSystem(sf::Vector2u windowSize, const RainConfig& config, const Scene& scene, IntegrateKernel integrate, JobSystem& jobs)
+        : drops(config.maxDrops, false), windowSize(windowSize), rng(config.seed), spawnRng(config.seed), spawnStep(0), spawnRate(config.spawnRate), spawnCarry(0.0f),
+          spawnLeft(0.0f), spawnRight(static_cast<float>(windowSize.x)), spawnTop(-50.0f),
+          fullLeft(0.0f), fullRight(static_cast<float>(windowSize.x)), outerDensity(1.0f),
+          spawnReach(-std::numeric_limits<float>::max()), openWidth(0.0f), openOnly(false),
+          minSize(config.minSize), maxSize(config.maxSize), sizes(config), speeds(config.minSize, config.maxSize),
+          wind(static_cast<float>(windowSize.x), static_cast<float>(windowSize.y), config.wind, config.seed),
+          grid(0.0f, -100.0f, static_cast<float>(windowSize.x), windowSize.y + 100.0f, GRID_CELL_SIZE),
+          rasterHits(config.hits == HITS_RASTER && !config.columnBuckets),
+          hitRaster(0.0f, -100.0f, rasterHits ? static_cast<float>(windowSize.x) : 0.0f, rasterHits ? windowSize.y + 100.0f : 0.0f, RASTER_HIT_CELL_SIZE),
+          rasterWidening(0.25f * (config.minSize + config.maxSize)),
+          flags(config.maxDrops / 8 + 1), integrate(integrate), jobs(jobs),
+          chunkSums(config.maxDrops / DROPS_PER_CHUNK + 1), chunkLags(chunkSums.size()), personMotion(MAX_PEOPLE, 0.0f), personFacing(MAX_PEOPLE, 1.0f), body(config.body), endShapes(MAX_PEOPLE), startShapes(MAX_PEOPLE),
+          peopleTree(PEOPLE_TREE_MARGIN),
+          impactCapacity(0), hitStride(0), lostHits(0), sortScratch(config.maxDrops, false), sortedDrops(0), displaced(0),
+          columnBuckets(config.columnBuckets), bucketDrift(columnBuckets && !config.wind.isCalm() ? config.maxDrops : 0),
+          coarseSteps(config.wind.isCalm() && !columnBuckets ? std::max<std::size_t>(config.coarseSteps, 1) : 1), bucketSurfaces(MAX_PEOPLE), timings(), counters(), lifetimes(),
+          ground(windowSize.x), groundStride(roundUpToLine(ground.cells())), chunkGround(chunkSums.size() * groundStride),
+          shelterDrips(config.shelterDrips), shelterStride(0),
+          coalesceDistance(columnBuckets || coarseSteps > 1 ? 0.0f : config.coalesceDistance) {
+        personBoxes.reserve(MAX_PEOPLE);
+        sweptBoxes.reserve(MAX_PEOPLE);
+        previousBoxes.reserve(MAX_PEOPLE);
+        placeStore();
+        if (wind.isCalm()) {
+            selectChunkUpdates<CalmAir>();
+        }
+        else {
+            selectChunkUpdates<WindyAir>();
+        }
+        setScene(scene);
+    }
+
+    // Rebuilds the rain shadow from the scene's colliders. A drop is dead once it passes the
+    // shadow height of its column, so testing it against every collider becomes one lookup by
+    // column. Only needs calling when the scene changes, and starts every collider dry
+    void setScene(const Scene& scene) {
+        shadowTop = scene.rainShadow(windowSize, &shadowOwner);
+
+        shelters.clear();
+        for (const SceneCollider& collider : scene.getColliders()) {
+            Shelter shelter = Shelter();
+            placeShelter(shelter, collider.bounds);
+            shelters.push_back(shelter);
+        }
+        shelterStride = roundUpToLine(shelters.size());
+        chunkShelters.assign(chunkSums.size() * shelterStride, 0.0f);
+        findShadowBand();
+    }
+
+    // Follows the scene's collider index from previous to where it is now, as the scene editor
+    // drags it. Only the shadow columns it left and the ones it covers are worked out again,
+    // and only its shelter, which keeps its water, so it costs in proportion to the collider's
+    // width rather than the screen's. Drops it moves onto land on it in their next step
+    void moveCollider(const Scene& scene, std::size_t index, const sf::FloatRect& previous) {
+        const sf::FloatRect& bounds = scene.getColliders()[index].bounds;
+        scene.updateRainShadow(previous, windowSize, shadowTop, &shadowOwner);
+        scene.updateRainShadow(bounds, windowSize, shadowTop, &shadowOwner);
+        placeShelter(shelters[index], bounds);
+        findShadowBand();
+        findOpenSpans();
+    }
+
+    // Runs count independent rains through the one store, up to MAX_PEOPLE of them, as count
+    // systems seeded seeds[0..count) would run them: lane i spawns and prewarms from seeds[i],
+    // and only person i can catch its drops. Each lane's drops start out marked as caught by
+    // everyone else, so they pass through the other lanes' people and die once their own
+    // catches them, and the kernels integrate every lane's drops side by side in the same
+    // vectors. update then needs one person per lane. The wind is shared, so lanes need calm
+    // air, and drips off shelters would belong to no lane, so they need shelter drips off.
+    // Call before the first update
+    void setLanes(const std::uint64_t* seeds, std::size_t count) {
+        count = std::min(count, MAX_PEOPLE);
+        const std::uint32_t everyone = count >= 32 ? ~0u : (1u << count) - 1u;
+        lanes.clear();
+        for (std::size_t i = 0; i < count; ++i) {
+            const Lane lane = { CounterRng(seeds[i]), Rng(seeds[i]), 0.0f, everyone & ~(1u << i), 0 };
+            lanes.push_back(lane);
+        }
+        spawnChunks.reserve(count);
+    }
+
+    // Starts over in fresh rain from seed, as a system just made with it would, but in the
+    // memory this one has: the drops, water, catches and counters go and every generator is
+    // reseeded, while the pools, arenas and per-chunk rows stay allocated. The spawn rate,
+    // band and top and the scene are kept, and lanes are dropped
+    void reset(std::uint64_t seed) {
+        drops.clear();
+        rng = Rng(seed);
+        spawnRng = CounterRng(seed);
+        spawnStep = 0;
+        spawnCarry = 0.0f;
+        lanes.clear();
+        wind.reseed(seed);
+        previousBoxes.clear();
+        std::fill(personMotion.begin(), personMotion.end(), 0.0f);
+        std::fill(personFacing.begin(), personFacing.end(), 1.0f);
+        std::fill(chunkLags.begin(), chunkLags.end(), ChunkLag());
+        for (Shelter& shelter : shelters) {
+            shelter.water = 0.0f;
+            shelter.due = 0.0f;
+            shelter.dripped = 0;
+        }
+        ground.clear();
+        impacts.clear();
+        hits.clear();
+        lostHits = 0;
+        sortedDrops = 0;
+        displaced = 0;
+        timings = StepTimings();
+        counters = CollisionCounters();
+        lifetimes = DropLifetimes();
+    }
+
+    // Spawns rate drops per pixel of width per second from now on
+    void setSpawnRate(float rate) {
+        spawnRate = std::max(rate, 0.0f);
+    }
+
+    float getSpawnRate() const {
+        return spawnRate;
+    }
+
+    // Whether setWindSpeed can be used. Column buckets and coarse steps rely on the air staying
+    // calm, so a system using either keeps the wind it was made with
+    bool canSetWind() const {
+        return !columnBuckets && coarseSteps == 1;
+    }
+
+    // Blows a steady wind of speed pixels per second from now on, if canSetWind()
+    void setWindSpeed(float speed) {
+        if (!canSetWind()) {
+            return;
+        }
+        wind.setSpeed(speed);
+        findOpenSpans();
+        if (wind.isCalm()) {
+            selectChunkUpdates<CalmAir>();
+        }
+        else {
+            selectChunkUpdates<WindyAir>();
+        }
+    }
+
+    // Confines spawning to columns [left, right) of the screen. The rate per pixel of width is
+    // kept, so the drop count follows the band's width rather than the screen's. Drops already
+    // falling outside the band are left to land
+    void setSpawnBand(float left, float right) {
+        spawnLeft = std::max(left, 0.0f);
+        spawnRight = std::max(std::min(right, static_cast<float>(windowSize.x)), spawnLeft);
+        findOpenSpans();
+    }
+
+    // Spawns only in the columns of the band whose rain shadow is at or below top, so none go
+    // where a collider would catch them before they got down to anyone below top. Those drops
+    // could never reach anyone, so leaving them out changes nothing but the work; the columns
+    // kept spawn at the usual rate, so each drop still stands for one and wetness keeps its
+    // expectation. Wind carries drops from column to column and drips bring the sheltered rain
+    // back down, so in either every column of the band is kept. setOuterDensity's thinning is
+    // for the rendered view and isn't applied on top
+    void setSpawnReach(float top) {
+        spawnReach = top;
+        findOpenSpans();
+    }
+
+    // Spawns only a fraction density of the usual rain outside columns [left, right), for
+    // thinning out rain that is only there to be looked at. Inside that range the rate is kept,
+    // so with the people inside it their wetness is unaffected, though the drops drawn change
+    void setOuterDensity(float left, float right, float density) {
+        fullLeft = left;
+        fullRight = std::max(right, left);
+        outerDensity = std::min(std::max(density, 0.0f), 1.0f);
+    }
+
+    // Moves the spawn band's top edge: new drops appear in the 50 pixels above top. Drops fall
+    // at terminal speed from the moment they spawn, so the flux below is the same wherever they
+    // start, and drops spawned lower reach the ground sooner and fewer are alive at once
+    void setSpawnTop(float top) {
+        spawnTop = top;
+    }
+
+    // Lowest top edge that spawns above everything in columns [left, right): the highest rain
+    // shadow there, less the tallest drop. Columns setSpawnReach leaves out don't count
+    float spawnTopAbove(float left, float right) const {
+        float highest = static_cast<float>(windowSize.y);
+        for (std::size_t column = columnOf(left); column <= columnOf(right); ++column) {
+            if (!openOnly || shadowTop[column] >= spawnReach) {
+                highest = std::min(highest, shadowTop[column]);
+            }
+        }
+        return highest - RainField::heightOf(maxSize);
+    }
+
+    // Advances the rain by one step for a single person and returns the wetness they picked up,
+    // adding it to surfaces by the face that caught it if given
+    float update(float deltaTime, const sf::FloatRect& personBounds, SurfaceWetness* surfaces = nullptr) {
+        float wetness = 0.0f;
+        update(deltaTime, &personBounds, 1, &wetness, surfaces);
+        return wetness;
+    }
+
+    // Advances the rain by one step. The store is split into fixed-size chunks that the job
+    // pool runs in parallel: the vectorized kernel integrates a chunk and flags the few drops
+    // that left the screen or sit in the collider band, and only those are tested against the
+    // rain shadow and the people's bounds. Collisions are swept over the whole step, so a drop
+    // that passed through something between two steps still hits it however long the step is.
+    // Dead drops are then removed serially.
+    //
+    // A drop someone catches counts once, the step it reaches them, and is never counted for
+    // them again however long it overlaps, so wetness doesn't depend on the step length. It is
+    // removed once everyone has caught it, which with one person is straight away.
+    //
+    // Everyone shares the one rain field, so comparing people costs about one simulation and
+    // they all see the same drops. People don't shelter each other: a drop one person caught
+    // still falls on the others, so the comparison stays the same as separate runs. Adds the
+    // wetness person i picked up during the step to wetness[i]. Up to MAX_PEOPLE people; any
+    // past that are ignored.
+    //
+    // People move too, from where their box was last update to where it is now, in a straight
+    // line. The broadphase and the batched test use the box swept over that move, and each drop
+    // that passes is then checked for the moment it and the moving box first overlap, so a step
+    // many times longer than a frame still only counts the drops someone actually met.
+    //
+    // Each catch is also put down to the face of the person it entered through, from the drop's
+    // motion relative to theirs over the step: straight down onto the top, or sideways into the
+    // front or back, which way they face being the way they last moved. How far someone moved is
+    // taken from where their box was last update, so the split needs the same people in the same
+    // order each step. Given surfaces, adds person i's split to surfaces[i]
+    //
+    // With column buckets the store is sorted by column every step, so the drops over anyone
+    // are a few contiguous runs. The kernel then only flags drops near the shadow, and people
+    // are tested against the runs their columns hold after the parallel pass. In wind, only the
+    // drops that drifted into another column are taken out and merged back, so keeping the
+    // buckets costs in proportion to the drops that cross, not to the store
+    //
+    // With coarse steps, a chunk whose lowest drop can't reach the band or the bottom of the
+    // screen even after all the time it has been held back plus this step is left where it is,
+    // for up to coarseSteps - 1 steps, and then moved the whole way at once. Drops fall at a
+    // fixed speed, so one long move lands them where the short ones would have, give or take
+    // rounding, and none of them could have hit anything on the way
+    //
+    // With the hit raster, people are rasterized into hitRaster instead, and each flagged drop
+    // is caught by whoever covers where its bottom reached, with one lookup and no test against
+    // anyone. That costs the drops plus the cells people cover, however many overlap, and is
+    // good to about a cell at their edges
+    void update(float deltaTime, const sf::FloatRect* people, std::size_t peopleCount, float* wetness, SurfaceWetness* surfaces = nullptr) {
+        RAINMYTH_ZONE("RainSystem::update");
+        RAINMYTH_TIMED("RainSystem::update");
+        peopleCount = std::min(peopleCount, MAX_PEOPLE);
+        wind.update(deltaTime);
+
+        // Rasterize person i into the grid as bit i, widened up and left by the largest drop
+        // since drops are located by their top-left corner, and stretched down by the furthest
+        // any drop falls in one step, because a drop that swept through them during the step may
+        // already be that far below. The same margin applies under every shadow edge. Wind can
+        // carry a drop sideways by up to drift in a step, so the person is widened by that too
+        const float sweep = speeds.lookup(maxSize) * deltaTime;
+        const float drift = wind.maxSpeed() * deltaTime;
+        float personTop = static_cast<float>(windowSize.y);
+        float personBottom = -static_cast<float>(windowSize.y);
+        grid.clearColliders();
+        if (rasterHits) {
+            hitRaster.clearColliders();
+        }
+        personBoxes.clear();
+        sweptBoxes.clear();
+        for (std::size_t i = 0; i < peopleCount; ++i) {
+            const sf::FloatRect& bounds = people[i];
+            HitBox box = { rectLeft(bounds), rectTop(bounds), rectLeft(bounds) + rectWidth(bounds), rectTop(bounds) + rectHeight(bounds) };
+
+            // A jump faster than anyone moves is a reset rather than a step, and isn't motion
+            const float moved = i < previousBoxes.size() ? box.left - previousBoxes[i].left : 0.0f;
+            personMotion[i] = std::abs(moved) <= MAX_PERSON_SPEED * deltaTime ? moved : 0.0f;
+            if (personMotion[i] != 0.0f) {
+                personFacing[i] = personMotion[i] > 0.0f ? 1.0f : -1.0f;
+            }
+
+            // A body that isn't its bounds is tested as its shape where the step ends and where
+            // it began, and everything else sees the box around that shape
+            if (body != BODY_BOX) {
+                endShapes[i] = bodyShape(box, personFacing[i]);
+                const HitBox start = { box.left - personMotion[i], box.top, box.right - personMotion[i], box.bottom };
+                startShapes[i] = bodyShape(start, personFacing[i]);
+                box = endShapes[i].bounds;
+            }
+            personBoxes.push_back(box);
+            const HitBox swept = { std::min(box.left, box.left - personMotion[i]), box.top, std::max(box.right, box.right - personMotion[i]), box.bottom };
+            sweptBoxes.push_back(swept);
+            if (rasterHits) {
+                // Drops look the raster up at the middle of their bottom edge, so widening by half
+                // a typical drop each side covers those that would overlap the box. Shrinking by
+                // half a cell then sets just the cells whose centres lie inside
+                const float inset = 0.5f * RASTER_HIT_CELL_SIZE;
+                hitRaster.addCollider(static_cast<int>(i), swept.left - rasterWidening + inset, swept.top + inset,
+                    swept.right + rasterWidening - inset, swept.bottom - inset);
+            }
+            const float top = rectTop(bounds) - RainField::heightOf(maxSize);
+            const float bottom = rectTop(bounds) + rectHeight(bounds) + sweep;
+            grid.addCollider(static_cast<int>(i), swept.left - maxSize - drift, top, swept.right + drift, bottom);
+            if (i == 0) {
+                const HitBox near = { swept.left - maxSize - drift, top, swept.right + drift, bottom };
+                nearBox = near;
+            }
+            personTop = std::min(personTop, top);
+            personBottom = std::max(personBottom, bottom);
+        }
+        previousBoxes.assign(personBoxes.begin(), personBoxes.end());
+        while (personProxies.size() > peopleCount) {
+            peopleTree.remove(personProxies.back());
+            personProxies.pop_back();
+        }
+        for (std::size_t i = 0; i < peopleCount; ++i) {
+            if (i < personProxies.size()) {
+                peopleTree.move(personProxies[i], sweptBoxes[i], personMotion[i]);
+            }
+            else {
+                personProxies.push_back(peopleTree.insert(sweptBoxes[i], static_cast<std::uint32_t>(i)));
+            }
+        }
+
+        // Buckets are only exact while nothing has moved since the last sort
+        const bool bucketed = columnBuckets && displaced == 0 && !sortCounts.empty();
+        IntegrateParams params;
+        params.deltaTime = deltaTime;
+        params.killY = static_cast<float>(windowSize.y);
+        params.bandTop = bucketed ? shadowHighest : std::min(personTop, shadowHighest);
+        params.bandBottom = bucketed ? shadowLowest + sweep : std::max(personBottom, shadowLowest + sweep);
+
+        // Chunks only read drop state and write their own flag bytes and partial sum, so they
+        // can run in any order on any thread
+        const std::size_t count = drops.count();
+        const std::size_t chunks = (count + DROPS_PER_CHUNK - 1) / DROPS_PER_CHUNK;
+        if (chunkSums.size() < chunks) {
+            chunkSums.resize(chunks);
+            chunkLags.resize(chunks);
+            chunkGround.resize(chunks * groundStride);
+            chunkShelters.resize(chunks * shelterStride);
+            chunkHits.resize(chunks * hitStride);
+        }
+        std::uint64_t phaseBegun = cycleCount();
+        auto phaseSeconds = [&phaseBegun]() {
+            const std::uint64_t now = cycleCount();
+            const float seconds = cycleSeconds(now - phaseBegun);
+            phaseBegun = now;
+            return seconds;
+        };
+        const std::size_t tested = bucketed ? 0 : peopleCount;
+        const ChunkUpdate updateChunk = rasterHits && tested > 0 ? chunkUpdates[3] : chunkUpdates[std::min<std::size_t>(tested, 2)];
+        jobs.runPlaced(chunks, storeChunks(), [this, count, &params, tested, peopleCount, updateChunk](std::size_t chunk, unsigned worker) {
+            FrameArena& arena = jobs.arena(worker);
+            const FrameArena::Scope scope(arena);
+            const std::size_t begin = chunk * DROPS_PER_CHUNK;
+            const std::size_t end = std::min(count, begin + DROPS_PER_CHUNK);
+            ChunkSums& sums = chunkSums[chunk];
+            std::fill(sums.wetness, sums.wetness + peopleCount, 0.0f);
+            std::fill(&chunkGround[chunk * groundStride], &chunkGround[chunk * groundStride] + ground.cells(), 0.0f);
+            std::fill(chunkShelters.begin() + chunk * shelterStride, chunkShelters.begin() + chunk * shelterStride + shelters.size(), 0.0f);
+            std::fill(sums.surfaces, sums.surfaces + peopleCount, SurfaceWetness());
+            sums.hits = 0;
+            sums.lostHits = 0;
+            sums.lifetimes = DropLifetimes();
+            if (holdBack(chunk, begin, end, params)) {
+                sums.counters = CollisionCounters();
+                sums.collisionTime = 0.0f;
+                return;
+            }
+            HitCandidates scratch(arena);
+            (this->*updateChunk)(begin, end, params, tested, scratch, sums.wetness, sums.surfaces);
+        });
+
+        // Reduce the partial sums in chunk order, so the totals don't depend on the thread count
+        timings.integrate = phaseSeconds();
+        timings.collision = 0.0f;
+        counters = CollisionCounters();
+        double stepWetness[MAX_PEOPLE] = {}; // Each chunk's sum is small, but a step's can be large enough to round
+        if (chunks == 0) {
+            std::fill(chunkGround.begin(), chunkGround.begin() + ground.cells(), 0.0f);
+        }
+        hits.clear();
+        lifetimes.liveSteps += count;
+        ++lifetimes.stepCount;
+        for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+            for (std::size_t s = 0; s < shelters.size(); ++s) {
+                shelters[s].water += chunkShelters[chunk * shelterStride + s];
+            }
+        }
+        for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+            const ChunkSums& sums = chunkSums[chunk];
+            for (std::size_t i = 0; i < peopleCount; ++i) {
+                stepWetness[i] += sums.wetness[i];
+                if (surfaces) {
+                    surfaces[i] += sums.surfaces[i];
+                }
+            }
+            timings.collision += sums.collisionTime;
+            counters += sums.counters;
+            lifetimes += sums.lifetimes;
+            takeHits(&chunkHits[chunk * hitStride], sums.hits, sums.lostHits);
+            if (chunk > 0) {
+                const float* landed = &chunkGround[chunk * groundStride];
+                for (std::size_t c = 0; c < ground.cells(); ++c) {
+                    chunkGround[c] += landed[c];
+                }
+            }
+        }
+        ground.step(deltaTime, chunkGround.data());
+        for (std::size_t i = 0; i < peopleCount; ++i) {
+            wetness[i] += static_cast<float>(stepWetness[i]);
+        }
+        if (bucketed) {
+            RAINMYTH_ZONE("Catch in columns");
+            RAINMYTH_TIMED("Catch in columns");
+            const std::uint64_t collisionBegun = cycleCount();
+            catchInColumns(params.deltaTime, peopleCount, wetness, surfaces, counters);
+            timings.collision += cycleSeconds(cycleCount() - collisionBegun);
+        }
+
+        // Only dead drops are still flagged. Those that died by landing rather than being caught
+        // are recorded as impacts on the way, up to the capacity asked for. Column buckets need
+        // the store in order, so it's compacted in order for them; otherwise order is only
+        // kept for locality, and each chunk swaps its own dead out in parallel
+        {
+            RAINMYTH_ZONE("Cull");
+            RAINMYTH_TIMED("Cull");
+            impacts.clear();
+            if (coarseSteps > 1) {
+                catchUpDonors(count);
+            }
+            if (columnBuckets) {
+                removeDeadInOrder(count);
+            }
+            else {
+                removeDeadByChunk(count);
+            }
+        }
+        timings.cull = phaseSeconds();
+
+        // The spawn count follows simulated time and spawn band width, not the step count. The
+        // fraction of a drop left over is carried into the next step
+        const std::uint64_t step = spawnStep++;
+        unboundChunks(drops.count());
+        if (lanes.empty()) {
+            const float expected = spawnRate * spawnWidth() * deltaTime + spawnCarry;
+            const float whole = std::floor(expected);
+            spawnCarry = expected - whole;
+            spawnDrops(step, static_cast<std::size_t>(whole), spawnRng, 0u);
+        }
+        else {
+            spawnLanes(step, deltaTime);
+        }
+        if (shelterDrips) {
+            dripShelters(deltaTime);
+        }
+
+        // Spawns land at the end of the store and every removal pulls the last drop into a hole,
+        // so order decays a little each step. Once an eighth of the store is out of place it's
+        // sorted back into columns, which costs a pass every few steps rather than every step.
+        // Column buckets need it exact, so they pay for the pass every step. Culling them
+        // kept the rest in order, so when the only drops out of place are the ones spawned at
+        // the end since, those are merged into their columns instead of sorting the lot.
+        // Coalescing finds its neighbours through the sort by cell, so it pays every step too
+        if (columnBuckets && sortedDrops > 0 && sortedDrops + displaced == drops.count()) {
+            RAINMYTH_ZONE("Merge spawns");
+            drops.mergeByColumn(sortedDrops, COLUMN_BUCKET_WIDTH, static_cast<float>(windowSize.x), sortScratch, sortCounts, mergeCounts);
+            sortedDrops = drops.count();
+            displaced = 0;
+        }
+        else if (displaced * 8 > drops.count() || (columnBuckets && displaced > 0) || coalesceDistance > 0.0f) {
+            RAINMYTH_ZONE("Sort by column");
+            catchUp();
+            unboundChunks(0);
+            if (coarseSteps > 1 || coalesceDistance > 0.0f) {
+                // Coarse steps hold back whole chunks, so they're only any use if each chunk
+                // covers a few rows rather than the whole height of the fall
+                const float top = spawnTop - 50.0f;
+                drops.sortByCell(GRID_CELL_SIZE, static_cast<float>(windowSize.x), top, static_cast<float>(windowSize.y) - top, sortScratch, sortCounts, sortBlockCounts, jobs);
+            }
+            else {
+                drops.sortByColumn(columnBuckets ? COLUMN_BUCKET_WIDTH : GRID_CELL_SIZE, static_cast<float>(windowSize.x), sortScratch, sortCounts, sortBlockCounts, jobs);
+            }
+            sortedDrops = columnBuckets ? drops.count() : 0;
+            displaced = 0;
+            if (coalesceDistance > 0.0f) {
+                coalesceDrops(deltaTime);
+            }
+        }
+        timings.spawn = phaseSeconds();
+    }
+
+    // Returns the drop store for rendering and stats, with any drops coarse steps held back
+    // moved up to the present first
+    const RainField& getDrops() const {
+        catchUp();
+        return drops;
+    }
+
+    const StepTimings& getTimings() const {
+        return timings;
+    }
+
+    const CollisionCounters& getCounters() const {
+        return counters;
+    }
+
+    // How the drops removed since the system was made or last reset lived and went
+    const DropLifetimes& getLifetimes() const {
+        return lifetimes;
+    }
+
+    // The water standing on the ground after the last update
+    const GroundWater& getGroundWater() const {
+        return ground;
+    }
+
+    // Everything the system holds: the drop store, the second store the sort writes into,
+    // which is reserved but only in use while sorting, and the per-drop, per-chunk and
+    // per-worker scratch of the step
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage = drops.memoryUsage();
+        const MemoryUsage sortUsage = { sortScratch.memoryUsage().reserved, 0 };
+        usage += sortUsage;
+        usage += vectorUsage(flags, (drops.count() + 7) / 8);
+        usage += grid.memoryUsage();
+        usage += vectorUsage(shadowTop);
+        usage += vectorUsage(chunkSums);
+        usage += vectorUsage(sortCounts);
+        usage += vectorUsage(sortBlockCounts);
+        usage += vectorUsage(bucketDrift);
+        usage += vectorUsage(columnTops);
+        usage += vectorUsage(columnBottoms);
+        usage += vectorUsage(impacts);
+        usage += vectorUsage(chunkHits);
+        usage += vectorUsage(hits);
+        usage += ground.memoryUsage();
+        usage += vectorUsage(chunkGround);
+        usage += vectorUsage(shadowOwner);
+        usage += vectorUsage(shelters);
+        usage += vectorUsage(chunkShelters);
+        usage += peopleTree.memoryUsage();
+        usage += vectorUsage(personProxies);
+        return usage;
+    }
+
+    // Keeps up to capacity of each step's landings for getImpacts, 0 for none. The space is
+    // taken up front, so recording never allocates
+    void recordImpacts(std::size_t capacity) {
+        impactCapacity = capacity;
+        impacts.reserve(capacity);
+    }
+
+    // Where drops landed during the last update
+    const std::vector<RainImpact>& getImpacts() const {
+        return impacts;
+    }
+
+    // Keeps every catch of each step for getHits, in a row of up to perChunk for each chunk of
+    // drops, 0 for none. The rows are filled by the chunks' own jobs and gathered in chunk order,
+    // so the catches come out the same on any number of threads. A chunk that catches more than
+    // its row holds loses the rest, counted by lostHitCount
+    void recordHits(std::size_t perChunk) {
+        hitStride = perChunk;
+        chunkHits.assign(chunkSums.size() * hitStride, RainHit());
+        hits.reserve(chunkHits.size());
+    }
+
+    // The catches of the last update, in store order within each chunk
+    const std::vector<RainHit>& getHits() const {
+        return hits;
+    }
+
+    std::uint64_t lostHitCount() const {
+        return lostHits;
+    }
+
+    RainState getState() const {
+        RainState state = RainState();
+        rng.getState(state.rng);
+        state.spawnStep = spawnStep;
+        state.windTime = wind.getTime();
+        state.spawnRate = spawnRate;
+        state.spawnCarry = spawnCarry;
+        state.spawnLeft = spawnLeft;
+        state.spawnRight = spawnRight;
+        state.spawnTop = spawnTop;
+        state.fullLeft = fullLeft;
+        state.fullRight = fullRight;
+        state.outerDensity = outerDensity;
+        state.trackedPeople = static_cast<std::uint32_t>(previousBoxes.size());
+        state.displaced = displaced;
+        std::copy(previousBoxes.begin(), previousBoxes.end(), state.previousBoxes);
+        std::copy(personFacing.begin(), personFacing.end(), state.personFacing);
+        return state;
+    }
+
+    // Picks up where a system with the same configuration and scene was when it gave state, with
+    // the count drops in the given arrays, so the steps after this one come out as its would have
+    void setState(const RainState& state, const float* x, const float* y, const float* vy, const float* size,
+        const std::uint32_t* absorbed, std::size_t count) {
+        rng.setState(state.rng);
+        spawnStep = state.spawnStep;
+        wind.setTime(state.windTime);
+        spawnRate = state.spawnRate;
+        spawnCarry = state.spawnCarry;
+        spawnLeft = state.spawnLeft;
+        spawnRight = state.spawnRight;
+        spawnTop = state.spawnTop;
+        fullLeft = state.fullLeft;
+        fullRight = state.fullRight;
+        outerDensity = state.outerDensity;
+        findOpenSpans();
+        previousBoxes.assign(state.previousBoxes, state.previousBoxes + std::min<std::size_t>(state.trackedPeople, MAX_PEOPLE));
+        personFacing.assign(state.personFacing, state.personFacing + MAX_PEOPLE);
+        drops.assign(x, y, vy, size, absorbed, count);
+        std::fill(chunkLags.begin(), chunkLags.end(), ChunkLag());
+        displaced = static_cast<std::size_t>(state.displaced);
+
+        // A store saved sorted is still sorted, and sorting it again keeps its order, so this
+        // only rebuilds the column buckets
+        sortedDrops = 0;
+        if (columnBuckets && displaced == 0) {
+            drops.sortByColumn(COLUMN_BUCKET_WIDTH, static_cast<float>(windowSize.x), sortScratch, sortCounts, sortBlockCounts, jobs);
+            sortedDrops = drops.count();
+        }
+    }
+
+    // Fills the air with the rain that would be falling had it been raining forever, with the
+    // spawn band, rate and scene as they are now and the people standing where they are. In
+    // steady rain the drops alive now are the ones spawned within one lifetime of the slowest
+    // drop, each one as far down as its age takes it, and none that has passed its shadow. That
+    // is sampled directly: each candidate drop gets an age as well as a spawn position, is
+    // placed where it has fallen to, and is kept if it hasn't landed. Faster drops land sooner
+    // and are kept less often, so sizes come out weighted as they are in the air. A drop that
+    // has passed through someone is marked as caught by them, and left out if everyone has it.
+    // Drops fall straight down in wind too, which the first second of rain evens out
+    void prewarm(const sf::FloatRect* people, std::size_t peopleCount) {
+        peopleCount = std::min(peopleCount, MAX_PEOPLE);
+        catchUp();
+        unboundChunks(drops.count());
+        if (lanes.empty()) {
+            prewarmRain(people, peopleCount, 0u);
+        }
+        // Each lane draws from its own generator, swapped in for its turn
+        for (Lane& lane : lanes) {
+            std::swap(rng, lane.rng);
+            prewarmRain(people, peopleCount, lane.others);
+            std::swap(rng, lane.rng);
+        }
+    }
+
+    // Fills the spawn band with count drops already in mid-fall, as if it had been raining for a while
+    void prefill(std::size_t count) {
+        catchUp();
+        unboundChunks(drops.count());
+        std::size_t first = 0;
+        count = drops.grow(count, first);
+        if (count == 0) {
+            return;
+        }
+        displaced += count;
+        placeSpawns(&drops.x[first], count);
+        rng.fillUniform(&drops.y[first], count, -100.0f, static_cast<float>(windowSize.y));
+        sizes.fill(rng, &drops.size[first], count);
+        std::fill(drops.absorbed.begin() + first, drops.absorbed.begin() + first + count, 0u);
+        setTerminalSpeeds(first, count);
+    }
+private:
+    // Swept rectangles of the drops a chunk found near someone, gathered for hitTestPeople.
+    // Each chunk takes one sized for the whole chunk from its worker's arena and gives it back
+    // when it's done, so gathering never allocates
+    struct HitCandidates {
+        float* left;
+        float* top;
+        float* right;
+        float* bottom;
+        float* area;
+        std::uint32_t* absorbed;
+        std::uint32_t* hits;
+        std::uint32_t* runAbsorbed; // absorbed, remapped to the people near each candidate's run
+        std::uint32_t* startHits;   // Which bodies each candidate touched where they began the step
+        std::size_t* index;   // Drop each candidate came from
+        float* drift;         // Per drop of the chunk, how far the wind moved it this step
+
+        // A chunk's worth, taken from arena
+        explicit HitCandidates(FrameArena& arena)
+            : left(arena.allocate<float>(DROPS_PER_CHUNK)), top(arena.allocate<float>(DROPS_PER_CHUNK)),
+              right(arena.allocate<float>(DROPS_PER_CHUNK)), bottom(arena.allocate<float>(DROPS_PER_CHUNK)),
+              area(arena.allocate<float>(DROPS_PER_CHUNK)), absorbed(arena.allocate<std::uint32_t>(DROPS_PER_CHUNK)),
+              hits(arena.allocate<std::uint32_t>(DROPS_PER_CHUNK)),
+              runAbsorbed(arena.allocate<std::uint32_t>(DROPS_PER_CHUNK)), startHits(arena.allocate<std::uint32_t>(DROPS_PER_CHUNK)), index(arena.allocate<std::size_t>(DROPS_PER_CHUNK)),
+              drift(arena.allocate<float>(DROPS_PER_CHUNK)) {}
+    };
+
+    // How far coarse steps have let a chunk fall behind, and how low its drops could be by now.
+    // The chunk's job writes it, so each has a cache line of its own
+    struct alignas(CACHE_LINE_BYTES) ChunkLag {
+        std::uint32_t heldSteps = 0; // Steps it has skipped since it last moved
+        float heldTime = 0.0f;       // Their total length, which its next move adds on
+        bool bounded = false;        // Whether lowest and fastest still describe its drops
+        float lowest = 0.0f;         // Largest y of its drops, as of when it last moved
+        float fastest = 0.0f;        // Largest vy
+    };
+
+    // Compile-time choices for updateChunk. A configuration's wind is fixed, so its Air is
+    // picked once at construction; People is picked each step from how many are tested, so each
+    // combination gets a loop with none of the others' checks in it
+    struct CalmAir {
+        static constexpr bool windy = false;
+    };
+
+    struct WindyAir {
+        static constexpr bool windy = true;
+    };
+
+    // Whether a located drop at (x, y) might reach someone, as the broadphase sees it
+    struct NoPeople {
+        static constexpr bool rastered = false;
+        static bool near(const RainSystem&, float, float) {
+            return false;
+        }
+    };
+
+    // One box needs no grid: the point test against it is a few compares
+    struct OnePerson {
+        static constexpr bool rastered = false;
+        static bool near(const RainSystem& rain, float x, float y) {
+            const HitBox& box = rain.nearBox;
+            return x >= box.left && x <= box.right && y >= box.top && y <= box.bottom;
+        }
+    };
+
+    struct Crowd {
+        static constexpr bool rastered = false;
+        static bool near(const RainSystem& rain, float x, float y) {
+            return rain.grid.collidersAt(x, y) != 0;
+        }
+    };
+
+    // HITS_RASTER gathers no one: each drop is caught by whoever hitRaster has under it
+    struct Rastered {
+        static constexpr bool rastered = true;
+        static bool near(const RainSystem&, float, float) {
+            return false;
+        }
+    };
+
+    typedef void (RainSystem::*ChunkUpdate)(std::size_t, std::size_t, const IntegrateParams&, std::size_t, HitCandidates&, float*, SurfaceWetness*);
+
+    // Fills chunkUpdates with Air's loops for no one, one person, a crowd and the hit raster
+    template <typename Air>
+    void selectChunkUpdates() {
+        chunkUpdates[0] = &RainSystem::updateChunk<Air, NoPeople>;
+        chunkUpdates[1] = &RainSystem::updateChunk<Air, OnePerson>;
+        chunkUpdates[2] = &RainSystem::updateChunk<Air, Crowd>;
+        chunkUpdates[3] = &RainSystem::updateChunk<Air, Rastered>;
+    }
+
+    // Whether coarse steps can leave chunk, drops [begin, end), where it is this step: it's been
+    // held back fewer than coarseSteps - 1 steps, and its lowest drop still wouldn't reach the
+    // band or the bottom of the screen if it moved for those and this one. Clears its flags if
+    // so, since none of its drops needs looking at
+    bool holdBack(std::size_t chunk, std::size_t begin, std::size_t end, const IntegrateParams& params) {
+        ChunkLag& lag = chunkLags[chunk];
+        if (coarseSteps <= 1 || !lag.bounded || lag.heldSteps + 1 >= coarseSteps) {
+            return false;
+        }
+        const float reach = lag.lowest + lag.fastest * (lag.heldTime + params.deltaTime);
+        if (reach >= params.bandTop || reach > params.killY) {
+            return false;
+        }
+        ++lag.heldSteps;
+        lag.heldTime += params.deltaTime;
+        std::fill(&flags[begin / 8], &flags[begin / 8] + (end - begin + 7) / 8, std::uint8_t(0));
+        return true;
+    }
+
+    // Records how low chunk's drops [begin, end) are and how fast the fastest falls, for holdBack.
+    // A chunk the kernel flagged any drop of is already down in the band and can't be held
+    // back next step, so that takes no pass over it
+    void boundChunk(ChunkLag& lag, std::size_t begin, std::size_t end, const std::uint8_t* chunkFlags) const {
+        lag.bounded = false;
+        for (std::size_t block = 0; block < (end - begin + 7) / 8; ++block) {
+            if (chunkFlags[block] != 0) {
+                return;
+            }
+        }
+        float lowest = -std::numeric_limits<float>::max();
+        float fastest = 0.0f;
+        for (std::size_t i = begin; i < end; ++i) {
+            lowest = std::max(lowest, drops.y[i]);
+            fastest = std::max(fastest, drops.vy[i]);
+        }
+        lag.lowest = lowest;
+        lag.fastest = fastest;
+        lag.bounded = true;
+    }
+
+    // Moves chunk's held-back drops the rest of the way to the present
+    void catchUpChunk(std::size_t chunk) const {
+        ChunkLag& lag = chunkLags[chunk];
+        if (lag.heldSteps == 0) {
+            return;
+        }
+        const std::size_t begin = chunk * DROPS_PER_CHUNK;
+        const std::size_t end = std::min(drops.count(), begin + DROPS_PER_CHUNK);
+        for (std::size_t i = begin; i < end; ++i) {
+            drops.y[i] += drops.vy[i] * lag.heldTime; // As the kernels do it
+        }
+        lag.lowest += lag.fastest * lag.heldTime;
+        lag.heldSteps = 0;
+        lag.heldTime = 0.0f;
+    }
+
+    void catchUp() const {
+        if (coarseSteps <= 1) {
+            return;
+        }
+        for (std::size_t chunk = 0; chunk * DROPS_PER_CHUNK < drops.count(); ++chunk) {
+            catchUpChunk(chunk);
+        }
+    }
+
+    // Brings level every chunk the cull of the step's count drops can pull a drop out of, or
+    // spawning appends to: a swap-remove takes the last drop still there, so with dead flagged
+    // they are all among the last dead, and spawns go after the last drop
+    void catchUpDonors(std::size_t count) {
+        std::size_t dead = 0;
+        for (std::size_t block = 0; block < (count + 7) / 8; ++block) {
+            dead += static_cast<std::size_t>(std::bitset<8>(flags[block]).count());
+        }
+        const std::size_t first = count - std::min(std::max<std::size_t>(dead, 1), count);
+        for (std::size_t chunk = first / DROPS_PER_CHUNK; chunk * DROPS_PER_CHUNK < count; ++chunk) {
+            catchUpChunk(chunk);
+        }
+    }
+
+    // prewarm for one rain, drawing from rng. Its drops start out caught by others, the people
+    // they can't reach
+    void prewarmRain(const sf::FloatRect* people, std::size_t peopleCount, std::uint32_t others) {
+        const float lifetime = (static_cast<float>(windowSize.y) - (spawnTop - 50.0f)) / std::max(speeds.lookup(minSize), 1e-3f);
+        const float expected = spawnRate * spawnWidth() * lifetime;
+        const std::uint32_t everyone = peopleCount >= 32 ? ~0u : (1u << peopleCount) - 1u;
+        for (std::size_t k = 0; k < static_cast<std::size_t>(expected); ++k) {
+            float x = 0.0f;
+            placeSpawns(&x, 1);
+            const float spawnY = rng.uniform(spawnTop - 50.0f, spawnTop);
+            const float size = sizes.draw(rng);
+            const float speed = speeds.lookup(size);
+            const float y = spawnY + speed * rng.uniform(0.0f, lifetime);
+            if (y > shadowTop[columnOf(x)]) {
+                continue; // Landed already
+            }
+            std::uint32_t caught = others;
+            for (std::size_t p = 0; p < peopleCount; ++p) {
+                const sf::FloatRect& box = people[p];
+                if (x < rectLeft(box) + rectWidth(box) && x + size > rectLeft(box) && spawnY < rectTop(box) + rectHeight(box) && y + RainField::heightOf(size) > rectTop(box)) {
+                    caught |= 1u << p;
+                }
+            }
+            if (peopleCount > 0 && caught == everyone) {
+                continue;
+            }
+            if (!drops.add(x, y, speed, size)) {
+                break;
+            }
+            drops.absorbed[drops.count() - 1] = caught;
+            ++displaced;
+        }
+    }
+
+    // Chunks the full store splits into, the span the update deals them out over
+    std::size_t storeChunks() const {
+        return (drops.capacity() + DROPS_PER_CHUNK - 1) / DROPS_PER_CHUNK;
+    }
+
+    // Zeroes the store and its sort scratch a chunk at a time, dealt out as the update deals
+    // them, so with the pool pinned each chunk's memory is on the node of the worker that will
+    // update it. The sort swaps the two, so both are placed alike
+    void placeStore() {
+        const std::size_t capacity = drops.capacity();
+        jobs.runPlaced(storeChunks(), storeChunks(), [this, capacity](std::size_t chunk, unsigned) {
+            const std::size_t begin = chunk * DROPS_PER_CHUNK;
+            const std::size_t end = std::min(capacity, begin + DROPS_PER_CHUNK);
+            drops.zero(begin, end);
+            sortScratch.zero(begin, end);
+        });
+    }
+
+    // Forgets the bounds of the chunks from the one holding drop first on, whose drops are changing
+    void unboundChunks(std::size_t first) {
+        for (std::size_t chunk = first / DROPS_PER_CHUNK; chunk < chunkLags.size(); ++chunk) {
+            chunkLags[chunk].bounded = false;
+        }
+    }
+
+    // Integrates drops [begin, end) and resolves the flagged ones. On return only the flag bits
+    // of dead drops are still set. Adds the wetness each of the first peopleCount people picked
+    // up from this range to wetness, and its split by surface to surfaces. With no people the
+    // flagged drops are only checked for landing
+    template <typename Air, typename People>
+    void updateChunk(std::size_t begin, std::size_t end, const IntegrateParams& params, std::size_t peopleCount,
+        HitCandidates& scratch, float* wetness, SurfaceWetness* surfaces) {
+        RAINMYTH_ZONE("Update chunk");
+        RAINMYTH_TIMED("Update chunk");
+        std::uint8_t* chunkFlags = &flags[begin / 8];
+        ChunkLag& lag = chunkLags[begin / DROPS_PER_CHUNK];
+        IntegrateParams moved = params;
+        moved.deltaTime += lag.heldTime;
+        integrate(&drops.y[begin], &drops.vy[begin], end - begin, moved, chunkFlags);
+        lag.heldSteps = 0;
+        lag.heldTime = 0.0f;
+        if (coarseSteps > 1) {
+            boundChunk(lag, begin, end, chunkFlags);
+        }
+        if constexpr (Air::windy) {
+            driftDrops(&drops.x[begin], &drops.y[begin], end - begin, wind.getGrid(), params.deltaTime,
+                static_cast<float>(windowSize.x), scratch.drift);
+            if (!bucketDrift.empty()) {
+                std::copy(scratch.drift, scratch.drift + (end - begin), &bucketDrift[begin]);
+            }
+        }
+        RAINMYTH_ZONE("Collide chunk");
+        const std::uint64_t collisionBegun = cycleCount();
+        CollisionCounters& counted = chunkSums[begin / DROPS_PER_CHUNK].counters;
+        counted = CollisionCounters();
+        float* landed = &chunkGround[(begin / DROPS_PER_CHUNK) * groundStride];
+        float* caught = &chunkShelters[(begin / DROPS_PER_CHUNK) * shelterStride];
+        DropLifetimes& lived = chunkSums[begin / DROPS_PER_CHUNK].lifetimes;
+
+        const float* x = drops.x.data();
+        const float* y = drops.y.data();
+        const float* vy = drops.vy.data();
+        const float* size = drops.size.data();
+        const std::uint32_t everyone = peopleCount >= 32 ? ~0u : (1u << peopleCount) - 1u;
+        HitRow row = { hitStride > 0 ? &chunkHits[begin / DROPS_PER_CHUNK * hitStride] : nullptr, hitStride, 0, 0 };
+        std::size_t near = 0;
+        for (std::size_t block = 0; block < (end - begin + 7) / 8; ++block) {
+            unsigned bits = chunkFlags[block];
+            for (int lane = 0; bits != 0 && lane < 8; ++lane) {
+                const unsigned bit = 1u << lane;
+                if ((bits & bit) == 0) {
+                    continue;
+                }
+                const std::size_t i = begin + block * 8 + lane;
+                ++counted.tested;
+
+                // Drops fall straight down, so the step swept each one's top edge along the
+                // segment from previousY to y, or only as far as the shadow if it landed there.
+                // Live drops always start the step above their shadow
+                const float previousY = y[i] - vy[i] * params.deltaTime;
+                const float shadow = shadowTop[columnOf(x[i])];
+                const float reachedY = std::min(y[i], shadow);
+                if (People::near(*this, x[i], reachedY)) {
+                    // Everything the drop covered on its way down, as one rectangle, tested
+                    // against everyone in one batch once the chunk is gathered
+                    const float previousX = Air::windy ? x[i] - scratch.drift[i - begin] : x[i];
+                    scratch.left[near] = std::min(previousX, x[i]);
+                    scratch.top[near] = previousY;
+                    scratch.right[near] = std::max(previousX, x[i]) + size[i];
+                    scratch.bottom[near] = reachedY + RainField::heightOf(size[i]);
+                    scratch.area[near] = RainField::areaOf(size[i]);
+                    scratch.absorbed[near] = drops.absorbed[i];
+                    scratch.index[near] = i;
+                    ++near;
+                }
+                if constexpr (People::rastered) {
+                    const float lookupX = x[i] + 0.5f * size[i];
+                    const std::uint32_t under = hitRaster.collidersAt(lookupX, reachedY + RainField::heightOf(size[i])) & everyone & ~drops.absorbed[i];
+                    if (under != 0 && catchRastered(i, under, everyone, Air::windy ? scratch.drift[i - begin] : 0.0f, params.deltaTime,
+                            wetness, surfaces, counted, row) && y[i] <= shadow) {
+                        lived.add(FATE_CAUGHT, ageOf(i, params.deltaTime));
+                        continue; // Dead
+                    }
+                }
+                if (y[i] > shadow) {
+                    // Landed on a collider or the ground, where it adds to the chunk's own row
+                    // of the collider's water or the ground's
+                    if (shadow < params.killY) {
+                        ++counted.culledByScene;
+                        lived.add(FATE_SCENE, ageOf(i, params.deltaTime));
+                        if (shelterDrips) {
+                            caught[shadowOwner[columnOf(x[i])]] += RainField::areaOf(size[i]);
+                        }
+                    }
+                    else {
+                        ++counted.culledOffscreen;
+                        lived.add(FATE_GROUND, ageOf(i, params.deltaTime));
+                        landed[ground.cellOf(x[i])] += RainField::areaOf(size[i]);
+                    }
+                    continue;
+                }
+                bits &= ~bit; // Survivor
+            }
+            chunkFlags[block] = static_cast<std::uint8_t>(bits);
+        }
+
+        counted.candidates += static_cast<std::uint32_t>(near);
+        ChunkSums& sums = chunkSums[begin / DROPS_PER_CHUNK];
+        resolveHits(scratch, near, peopleCount, params.deltaTime, Air::windy ? scratch.drift : nullptr, begin, wetness, surfaces, counted, lived, row);
+        sums.hits = row.count;
+        sums.lostHits = row.lost;
+        sums.collisionTime = cycleSeconds(cycleCount() - collisionBegun);
+    }
+
+    // Steps drop i has lived, for the lifetime tally. Ages aren't stored, so it's how far the drop
+    // has fallen since the middle of the spawn strip at the speed it falls, good to within the
+    // few steps it takes to fall 25 pixels. Drips start lower down, so theirs come out long
+    std::size_t ageOf(std::size_t i, float deltaTime) const {
+        const float fallen = drops.y[i] - (spawnTop - 25.0f);
+        return static_cast<std::size_t>(std::max(fallen / std::max(drops.vy[i] * deltaTime, 1e-3f), 0.0f));
+    }
+
+    // Where resolveHits writes its catches: a chunk's row of chunkHits, or none
+    struct HitRow {
+        RainHit* hits;
+        std::size_t capacity;
+        std::uint32_t count;
+        std::uint32_t lost;
+    };
+
+    // Hit tests the first near gathered candidates against the people, batched against their
+    // swept boxes and then one at a time for the moment of contact. Drops caught by everyone are
+    // dead, and get flagged for removal with the landed ones. Catches are few, so the contact
+    // test and the face each came in by are worked out one catch at a time, from where the drop
+    // and the person were when the step began, and their areas summed in candidate order.
+    // drift[i - driftBegin] is how far the wind moved drop i, null in calm air. The pairs tested
+    // and the catches are added to counted, the drops that die by them to lived, and the catches
+    // written to row while it has room
+    void resolveHits(HitCandidates& scratch, std::size_t near, std::size_t peopleCount, float deltaTime, const float* drift,
+        std::size_t driftBegin, float* wetness, SurfaceWetness* surfaces, CollisionCounters& counted, DropLifetimes& lived, HitRow& row) {
+        counted.pairs += static_cast<std::uint32_t>(testPeople(scratch, near, peopleCount));
+
+        const float* x = drops.x.data();
+        const float* y = drops.y.data();
+        const float* vy = drops.vy.data();
+        const float* size = drops.size.data();
+        const std::uint32_t everyone = peopleCount >= 32 ? ~0u : (1u << peopleCount) - 1u;
+        for (std::size_t k = 0; k < near; ++k) {
+            const std::size_t i = scratch.index[k];
+            for (std::uint32_t caught = scratch.hits[k]; caught != 0; caught &= caught - 1) {
+                ++counted.contacts;
+                std::size_t p = 0;
+                while (((caught >> p) & 1u) == 0) {
+                    ++p;
+                }
+                const float dropDx = drift ? drift[i - driftBegin] : 0.0f;
+                const float dropDy = vy[i] * deltaTime;
+                const float dropLeft = x[i] - dropDx;
+                const float dropTop = y[i] - dropDy;
+                const float dropHeight = RainField::heightOf(size[i]);
+                const float reach = (std::min(y[i], shadowTop[columnOf(x[i])]) - dropTop) / dropDy;
+                const HitBox& box = personBoxes[p];
+                const float boxLeft = box.left - personMotion[p];
+                const float boxRight = box.right - personMotion[p];
+                if (!sweptContact(dropLeft, dropTop, dropLeft + size[i], dropTop + dropHeight, dropDx, dropDy,
+                        boxLeft, box.top, boxRight, box.bottom, personMotion[p], reach)) {
+                    scratch.hits[k] &= ~(1u << p); // Passed through where they were or would be, but never met them
+                    continue;
+                }
+                const BodySurface surface = classifyHit(dropLeft, dropLeft + size[i], dropTop + dropHeight,
+                    dropDx, dropDy, boxLeft, box.top, boxRight, personMotion[p], personFacing[p]);
+                wetness[p] += scratch.area[k];
+                surfaces[p].add(surface, scratch.area[k]);
+                ++counted.hits;
+                if (row.count < row.capacity) {
+                    const RainHit hit = { static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(p), size[i], surface };
+                    row.hits[row.count++] = hit;
+                }
+                else if (row.hits) {
+                    ++row.lost;
+                }
+            }
+            drops.absorbed[i] |= scratch.hits[k];
+            if (drops.absorbed[i] == everyone) {
+                flags[i >> 3] |= static_cast<std::uint8_t>(1u << (i & 7)); // Chunks start on whole flag bytes
+                if (y[i] <= shadowTop[columnOf(x[i])]) {
+                    lived.add(FATE_CAUGHT, ageOf(i, deltaTime)); // Unless it landed as well, and went that way
+                }
+            }
+        }
+    }
+
+    // Puts drop i down to each of the people in caught, those the hit raster has under it, the
+    // same way resolveHits does a catch, with dropDx how far the wind moved it. Returns whether
+    // everyone has now caught it, in which case it stays flagged
+    bool catchRastered(std::size_t i, std::uint32_t caught, std::uint32_t everyone, float dropDx, float deltaTime, float* wetness,
+        SurfaceWetness* surfaces, CollisionCounters& counted, HitRow& row) {
+        const float size = drops.size[i];
+        const float area = RainField::areaOf(size);
+        const float dropDy = drops.vy[i] * deltaTime;
+        const float dropLeft = drops.x[i] - dropDx;
+        const float dropBottom = drops.y[i] - dropDy + RainField::heightOf(size);
+        for (std::uint32_t left = caught; left != 0; left &= left - 1) {
+            std::size_t p = 0;
+            while (((left >> p) & 1u) == 0) {
+                ++p;
+            }
+            const HitBox& box = personBoxes[p];
+            const BodySurface surface = classifyHit(dropLeft, dropLeft + size, dropBottom, dropDx, dropDy,
+                box.left - personMotion[p], box.top, box.right - personMotion[p], personMotion[p], personFacing[p]);
+            wetness[p] += area;
+            surfaces[p].add(surface, area);
+            ++counted.contacts;
+            ++counted.hits;
+            if (row.count < row.capacity) {
+                const RainHit hit = { static_cast<std::uint32_t>(i), static_cast<std::uint32_t>(p), size, surface };
+                row.hits[row.count++] = hit;
+            }
+            else if (row.hits) {
+                ++row.lost;
+            }
+        }
+        drops.absorbed[i] |= caught;
+        return drops.absorbed[i] == everyone;
+    }
+
+    // Sets scratch.hits for the first near candidates from hitTestPeople, and returns the drop
+    // and person pairs it tested. A crowd of PEOPLE_TREE_MIN or more is split up: each run of
+    // HIT_RUN_DROPS candidates, which lie close together since the store is kept in column
+    // order, is only tested against the people peopleTree finds around the run. That keeps the
+    // cost per candidate to the people nearby however big the crowd gets
+    std::size_t testPeople(HitCandidates& scratch, std::size_t near, std::size_t peopleCount) const {
+        if (peopleCount < PEOPLE_TREE_MIN) {
+            const HitBatch batch = { scratch.left, scratch.top, scratch.right, scratch.bottom, scratch.area, scratch.absorbed };
+            testBodies(batch, near, sweptBoxes.data(), endShapes.data(), startShapes.data(), peopleCount, scratch.hits, scratch.startHits);
+            return near * peopleCount;
+        }
+        std::size_t pairs = 0;
+        for (std::size_t begin = 0; begin < near; begin += HIT_RUN_DROPS) {
+            const std::size_t end = std::min(begin + HIT_RUN_DROPS, near);
+            HitBox bounds = { scratch.left[begin], scratch.top[begin], scratch.right[begin], scratch.bottom[begin] };
+            for (std::size_t k = begin + 1; k < end; ++k) {
+                bounds.left = std::min(bounds.left, scratch.left[k]);
+                bounds.top = std::min(bounds.top, scratch.top[k]);
+                bounds.right = std::max(bounds.right, scratch.right[k]);
+                bounds.bottom = std::max(bounds.bottom, scratch.bottom[k]);
+            }
+            HitBox boxes[MAX_PEOPLE];
+            HitShape ends[MAX_PEOPLE];
+            HitShape starts[MAX_PEOPLE];
+            std::uint32_t people[MAX_PEOPLE];
+            std::size_t found = 0;
+            peopleTree.query(bounds, [&](std::uint32_t p) {
+                boxes[found] = sweptBoxes[p];
+                ends[found] = endShapes[p];
+                starts[found] = startShapes[p];
+                people[found++] = p;
+            });
+            pairs += (end - begin) * found;
+
+            // Bit j of the run's masks stands for people[j] rather than person j
+            for (std::size_t k = begin; k < end; ++k) {
+                std::uint32_t absorbed = 0;
+                for (std::size_t j = 0; j < found; ++j) {
+                    absorbed |= ((scratch.absorbed[k] >> people[j]) & 1u) << j;
+                }
+                scratch.runAbsorbed[k] = absorbed;
+            }
+            const HitBatch batch = { scratch.left + begin, scratch.top + begin, scratch.right + begin, scratch.bottom + begin,
+                scratch.area + begin, scratch.runAbsorbed + begin };
+            testBodies(batch, end - begin, boxes, ends, starts, found, scratch.hits + begin, scratch.startHits + begin);
+            for (std::size_t k = begin; k < end; ++k) {
+                std::uint32_t hits = 0;
+                for (std::size_t j = 0; j < found; ++j) {
+                    hits |= ((scratch.hits[k] >> j) & 1u) << people[j];
+                }
+                scratch.hits[k] = hits;
+            }
+        }
+        return pairs;
+    }
+
+    // The batched test of count candidates against people, as hitTestPeople against their
+    // swept boxes, or for bodies that aren't boxes, as hitTestShapes against where each one's
+    // shape ended the step and where it began it. Only the hits are wanted: the contact test
+    // decides which of them count, so the kernels' wetness sums are left out
+    void testBodies(const HitBatch& batch, std::size_t count, const HitBox* boxes, const HitShape* ends, const HitShape* starts,
+        std::size_t peopleCount, std::uint32_t* hits, std::uint32_t* startHits) const {
+        if (body == BODY_BOX) {
+            hitTestPeople(batch, count, boxes, peopleCount, hits, nullptr);
+            return;
+        }
+        hitTestShapes(batch, count, ends, peopleCount, hits, nullptr);
+        hitTestShapes(batch, count, starts, peopleCount, startHits, nullptr);
+        for (std::size_t k = 0; k < count; ++k) {
+            hits[k] |= startHits[k];
+        }
+    }
+
+    // The shape a body of this system's kind has inside box, facing right for 1 and left for -1
+    HitShape bodyShape(const HitBox& box, float facing) const {
+        const float halfWidth = (box.right - box.left) * 0.5f;
+        const float halfHeight = (box.bottom - box.top) * 0.5f;
+        const float centreX = box.left + halfWidth;
+        if (body == BODY_CAPSULE) {
+            const float head = box.top + halfWidth;
+            return capsuleHitShape(centreX, head, centreX, std::max(box.bottom - halfWidth, head), halfWidth);
+        }
+        if (body == BODY_LEANING) {
+            return orientedHitShape(centreX, box.top + halfHeight, halfWidth, halfHeight, PERSON_LEAN * facing);
+        }
+        return boxHitShape(box);
+    }
+
+    // Records drop i, which has just died, as an impact if it landed and there's room
+    void recordImpact(std::size_t i) {
+        if (impacts.size() < impactCapacity) {
+            const float shadow = shadowTop[columnOf(drops.x[i])];
+            if (drops.y[i] > shadow) {
+                const RainImpact impact = { drops.x[i], shadow, drops.size[i] };
+                impacts.push_back(impact);
+            }
+        }
+    }
+
+    // Records the impacts among the flagged first count in store order, stopping once there's
+    // no room for more
+    void recordDeadImpacts(std::size_t count) {
+        for (std::size_t block = 0; block < (count + 7) / 8 && impacts.size() < impactCapacity; ++block) {
+            const unsigned bits = flags[block];
+            for (int lane = 0; bits >> lane != 0 && lane < 8; ++lane) {
+                if (((bits >> lane) & 1u) != 0) {
+                    recordImpact(block * 8 + lane);
+                }
+            }
+        }
+    }
+
+    // Removes the flagged drops from the count in the store, which nothing has added to since
+    // they were flagged, in two passes. Each chunk's job first closes up its own, swapping its
+    // last survivors into its holes from the back, so it keeps its survivors at its front and
+    // writes nothing outside itself. Then the survivors past the new end of the store fill the
+    // gaps the chunks left below it, one move per drop removed, which is all that stays serial.
+    // The result doesn't depend on the thread count. Each removal leaves another drop out of
+    // place
+    void removeDeadByChunk(std::size_t count) {
+        recordDeadImpacts(count);
+        const std::size_t chunks = (count + DROPS_PER_CHUNK - 1) / DROPS_PER_CHUNK;
+        jobs.runPlaced(chunks, storeChunks(), [this, count](std::size_t chunk, unsigned) {
+            const std::size_t begin = chunk * DROPS_PER_CHUNK;
+            std::size_t end = std::min(count, begin + DROPS_PER_CHUNK);
+            const std::size_t full = end;
+            for (std::size_t block = (end + 7) / 8; block-- > begin / 8;) {
+                const unsigned bits = flags[block];
+                for (int lane = 7; bits != 0 && lane >= 0; --lane) {
+                    const std::size_t i = block * 8 + lane;
+                    if (((bits >> lane) & 1u) != 0 && i < full) {
+                        if (i != --end) {
+                            drops.move(i, end);
+                        }
+                    }
+                }
+            }
+            chunkSums[chunk].kept = static_cast<std::uint32_t>(end - begin);
+            if (end != full) {
+                chunkLags[chunk].bounded = false;
+            }
+        });
+        std::size_t total = 0;
+        for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+            total += chunkSums[chunk].kept;
+        }
+        // Below total every chunk's gap is filled from the top of the last chunk that still has
+        // survivors at or past it. There are as many of those as there are gaps
+        std::size_t into = 0;
+        std::size_t from = chunks;
+        for (;;) {
+            while (into < chunks && into * DROPS_PER_CHUNK + chunkSums[into].kept >= std::min((into + 1) * DROPS_PER_CHUNK, total)) {
+                ++into;
+            }
+            if (into == chunks) {
+                break;
+            }
+            while ((from - 1) * DROPS_PER_CHUNK + chunkSums[from - 1].kept <= total) {
+                --from;
+            }
+            const std::uint32_t top = --chunkSums[from - 1].kept;
+            drops.move(into * DROPS_PER_CHUNK + chunkSums[into].kept++, (from - 1) * DROPS_PER_CHUNK + top);
+            chunkLags[into].bounded = false;
+        }
+        displaced += count - total;
+        drops.truncate(total);
+        sortedDrops = 0;
+    }
+
+    // Merges drops closer than coalesceDistance in the store sortByCell just left, where each
+    // GRID_CELL_SIZE cell's drops are together and sortCounts has where they end. Each drop
+    // takes in those of the next COALESCE_NEIGHBOURS in its cell that are near enough, have
+    // the same absorbed mask and leave it no bigger than maxSize, which keeps the pass linear
+    // however crowded a cell gets. The areas add, the merged drop sits at their area-weighted
+    // centre and falls at the terminal speed of its new size. A row of cells is a job, each
+    // changing only its own drops, and the merged-away are then removed in order, so the result
+    // doesn't depend on the thread count
+    void coalesceDrops(float deltaTime) {
+        RAINMYTH_ZONE("Coalesce");
+        const std::size_t columns = static_cast<std::size_t>(static_cast<float>(windowSize.x) * (1.0f / GRID_CELL_SIZE)) + 1;
+        const std::size_t rows = (sortCounts.size() - 1) / columns;
+        const float reach = coalesceDistance * coalesceDistance;
+        const float maxArea = RainField::areaOf(maxSize);
+        jobs.run(rows, [this, columns, reach, maxArea](std::size_t row, unsigned) {
+            for (std::size_t cell = row * columns; cell < (row + 1) * columns; ++cell) {
+                const std::size_t begin = cell > 0 ? sortCounts[cell - 1] : 0;
+                const std::size_t end = sortCounts[cell];
+                for (std::size_t i = begin; i < end; ++i) {
+                    if (drops.size[i] == 0.0f) {
+                        continue; // Already merged into an earlier drop
+                    }
+                    float area = RainField::areaOf(drops.size[i]);
+                    const float before = area;
+                    for (std::size_t j = i + 1; j < std::min(end, i + 1 + COALESCE_NEIGHBOURS); ++j) {
+                        if (drops.size[j] == 0.0f || drops.absorbed[j] != drops.absorbed[i]) {
+                            continue;
+                        }
+                        const float dx = drops.x[j] - drops.x[i];
+                        const float dy = drops.y[j] - drops.y[i];
+                        const float other = RainField::areaOf(drops.size[j]);
+                        if (dx * dx + dy * dy >= reach || area + other > maxArea) {
+                            continue;
+                        }
+                        const float joined = area + other;
+                        drops.x[i] = (drops.x[i] * area + drops.x[j] * other) / joined;
+                        drops.y[i] = (drops.y[i] * area + drops.y[j] * other) / joined;
+                        area = joined;
+                        drops.size[j] = 0.0f;
+                    }
+                    if (area != before) {
+                        drops.size[i] = std::min(std::sqrt(area * 0.5f), maxSize);
+                        drops.vy[i] = speeds.lookup(drops.size[i]);
+                    }
+                }
+            }
+        });
+
+        const std::size_t count = drops.count();
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            if (drops.size[i] == 0.0f) {
+                lifetimes.add(FATE_MERGED, ageOf(i, deltaTime));
+                continue;
+            }
+            if (kept != i) {
+                drops.move(kept, i);
+            }
+            ++kept;
+        }
+        drops.truncate(kept);
+    }
+
+    // Removes the flagged drops among the first count by sliding the living down over them in
+    // one pass, so the store keeps its order. Each column bucket's end moves down by the dead
+    // before it, and the buckets stay exact without sorting again. In wind, drops that drifted
+    // out of their bucket are taken out the same way, through sortScratch, and put back at the
+    // end for the merge after spawning to place. Every chunk from the first death or crossing
+    // on has new drops in it
+    void removeDeadInOrder(std::size_t count) {
+        const std::size_t columns = sortedDrops > 0 ? sortCounts.size() - 1 : 0;
+        const bool drifting = !bucketDrift.empty();
+        std::size_t kept = 0;
+        std::size_t crossed = 0;
+        std::size_t column = 0;
+        std::size_t firstDead = count;
+        for (std::size_t i = 0; i < count; ++i) {
+            for (; column < columns && i == sortCounts[column]; ++column) {
+                sortCounts[column] = static_cast<std::uint32_t>(kept);
+            }
+            if ((flags[i / 8] >> (i % 8)) & 1u) {
+                recordImpact(i);
+                firstDead = std::min(firstDead, i);
+                continue;
+            }
+            if (drifting && column < columns && bucketOf(drops.x[i], columns) != column) {
+                sortScratch.x[crossed] = drops.x[i];
+                sortScratch.y[crossed] = drops.y[i];
+                sortScratch.vy[crossed] = drops.vy[i];
+                sortScratch.size[crossed] = drops.size[i];
+                sortScratch.absorbed[crossed] = drops.absorbed[i];
+                ++crossed;
+                firstDead = std::min(firstDead, i);
+                continue;
+            }
+            if (kept != i) {
+                drops.move(kept, i);
+            }
+            ++kept;
+        }
+        for (; column < columns; ++column) {
+            sortCounts[column] = static_cast<std::uint32_t>(kept);
+        }
+        if (sortedDrops > 0) {
+            sortedDrops = sortCounts[columns - 1];
+            sortCounts[columns] = static_cast<std::uint32_t>(sortedDrops);
+        }
+        // Drops spawned past count, if any, follow the survivors down
+        for (std::size_t i = count; i < drops.count(); ++i) {
+            drops.move(kept++, i);
+        }
+        drops.truncate(kept);
+        std::size_t first = 0;
+        drops.grow(crossed, first);
+        for (std::size_t k = 0; k < crossed; ++k) {
+            drops.x[first + k] = sortScratch.x[k];
+            drops.y[first + k] = sortScratch.y[k];
+            drops.vy[first + k] = sortScratch.vy[k];
+            drops.size[first + k] = sortScratch.size[k];
+            drops.absorbed[first + k] = sortScratch.absorbed[k];
+        }
+        displaced += crossed;
+        for (std::size_t chunk = firstDead / DROPS_PER_CHUNK; firstDead < count && chunk < chunkLags.size(); ++chunk) {
+            chunkLags[chunk].bounded = false;
+        }
+    }
+
+    // Tests people against the drops in the column buckets their boxes cover, instead of the
+    // ones the kernel flagged. Drops fall straight down, or in wind drift at most its top speed
+    // sideways, so a drop whose bucket is outside those columns, widened by that drift, can't
+    // reach anyone, and each bucket is one run of the store. A bucket only keeps drops that can
+    // reach the heights of the people covering it, not anyone's, so someone up on a ledge doesn't
+    // make the columns of those below test drops at the ledge's height. Runs serially once the
+    // parallel pass is done, through scratch from the first worker's arena, a chunk's worth of candidates at a time
+    void catchInColumns(float deltaTime, std::size_t peopleCount, float* wetness, SurfaceWetness* surfaces, CollisionCounters& counted) {
+        const std::size_t columns = sortCounts.size() - 1;
+        const float* drift = bucketDrift.empty() ? nullptr : bucketDrift.data();
+        const float sideways = drift ? wind.maxSpeed() * deltaTime : 0.0f;
+        // A bucket nobody covers keeps a band with its top below its bottom, which no drop reaches
+        columnTops.assign(columns, static_cast<float>(windowSize.y));
+        columnBottoms.assign(columns, -static_cast<float>(windowSize.y));
+        for (std::size_t p = 0; p < peopleCount; ++p) {
+            const HitBox& box = sweptBoxes[p];
+            const std::size_t first = bucketOf(box.left - maxSize - sideways, columns);
+            const std::size_t last = bucketOf(box.right + sideways, columns);
+            for (std::size_t column = first; column <= last; ++column) {
+                columnTops[column] = std::min(columnTops[column], box.top);
+                columnBottoms[column] = std::max(columnBottoms[column], box.bottom);
+            }
+        }
+        std::fill(bucketSurfaces.begin(), bucketSurfaces.begin() + peopleCount, SurfaceWetness());
+
+        FrameArena& arena = jobs.arena(0);
+        const FrameArena::Scope scope(arena);
+        HitCandidates scratch(arena);
+        const float* x = drops.x.data();
+        const float* y = drops.y.data();
+        const float* vy = drops.vy.data();
+        const float* size = drops.size.data();
+        // The chunks' rows have been gathered by now, so their space takes this pass's catches
+        HitRow row = { hitStride > 0 ? chunkHits.data() : nullptr, chunkHits.size(), 0, 0 };
+        std::size_t near = 0;
+        for (std::size_t column = 0; column < columns; ++column) {
+            const float top = columnTops[column];
+            const float bottom = columnBottoms[column];
+            if (top > bottom) {
+                continue;
+            }
+            const std::size_t end = sortCounts[column];
+            for (std::size_t i = column > 0 ? sortCounts[column - 1] : 0; i < end; ++i) {
+                // The same swept rectangle as updateChunk's, skipped early if it can't reach the
+                // height of anyone over this bucket
+                const float previousY = y[i] - vy[i] * deltaTime;
+                const float reachedBottom = std::min(y[i], shadowTop[columnOf(x[i])]) + RainField::heightOf(size[i]);
+                if (reachedBottom < top || previousY > bottom) {
+                    continue;
+                }
+                const float previousX = drift ? x[i] - drift[i] : x[i];
+                scratch.left[near] = std::min(previousX, x[i]);
+                scratch.top[near] = previousY;
+                scratch.right[near] = std::max(previousX, x[i]) + size[i];
+                scratch.bottom[near] = reachedBottom;
+                scratch.area[near] = RainField::areaOf(size[i]);
+                scratch.absorbed[near] = drops.absorbed[i];
+                scratch.index[near] = i;
+                ++counted.candidates;
+                if (++near == DROPS_PER_CHUNK) {
+                    resolveHits(scratch, near, peopleCount, deltaTime, drift, 0, wetness, bucketSurfaces.data(), counted, lifetimes, row);
+                    near = 0;
+                }
+            }
+        }
+        resolveHits(scratch, near, peopleCount, deltaTime, drift, 0, wetness, bucketSurfaces.data(), counted, lifetimes, row);
+        if (surfaces) {
+            for (std::size_t p = 0; p < peopleCount; ++p) {
+                surfaces[p] += bucketSurfaces[p];
+            }
+        }
+        takeHits(chunkHits.data(), row.count, row.lost);
+    }
+
+    // Adds count catches from a row to the step's, and lost to the catches that didn't fit
+    void takeHits(const RainHit* row, std::size_t count, std::uint32_t lost) {
+        hits.insert(hits.end(), row, row + count);
+        lostHits += lost;
+    }
+
+    mutable RainField drops;      // Mutable so getDrops can move drops coarse steps held back into place
+    sf::Vector2u windowSize;
+    Rng rng;                      // Prewarm and prefill draws
+    CounterRng spawnRng;          // Spawned drops, by step and index, so they can be made in any order
+    std::uint64_t spawnStep;      // Steps so far, the stream spawnRng draws this step's drops from
+
+    // One of the independent rains setLanes runs through the store
+    struct Lane {
+        CounterRng spawnRng;
+        Rng rng;
+        float spawnCarry;
+        std::uint32_t others; // Everyone but the lane's own person
+        std::size_t spawning; // Drops it spawns this step
+    };
+    // One job's share of a step's spawns across the lanes: drops [begin, end) of the lane's
+    // spawns for the step, which go to the store from slot first + begin
+    struct SpawnChunk {
+        std::uint32_t lane;
+        std::size_t first;
+        std::size_t begin;
+        std::size_t end;
+    };
+    std::vector<SpawnChunk> spawnChunks;
+    std::vector<Lane> lanes; // Empty for the one rain of spawnRng and rng
+    float spawnRate;
+    float spawnCarry; // Fraction of a drop owed from previous steps
+    float spawnLeft;  // Columns new drops appear in
+    float spawnRight;
+    float spawnTop;   // Bottom of the 50 pixel strip they appear in
+    float fullLeft;   // Columns that get the full spawn rate; the rest get outerDensity of it
+    float fullRight;
+    float outerDensity;
+    float spawnReach; // Height the rain of a column has to get down to for it to be spawned in, see setSpawnReach
+    // A run of the band's columns rain reaches down from, and where it starts once the runs are
+    // laid end to end, which is how spawns are drawn over them
+    struct OpenSpan {
+        float left;
+        float right;
+        float offset;
+    };
+    std::vector<OpenSpan> openSpans;
+    float openWidth; // Of all of them
+    bool openOnly;   // Whether spawns go only in openSpans, when the reach shuts off any of the band
+    float minSize;
+    float maxSize;
+    DropSizeTable sizes;          // Drop widths by the config's size model
+    TerminalVelocityTable speeds; // Fall speed by drop size
+    WindField wind;
+    CollisionGrid grid;
+    bool rasterHits;              // HITS_RASTER, which column buckets leave out
+    CollisionGrid hitRaster;      // For rasterHits, person i as bit i of the cells their swept box covers. Empty otherwise
+    float rasterWidening;         // Half a typical drop's width, which each side of those boxes is widened by
+    HitBox nearBox;               // The first person's cells in grid, as OnePerson tests them
+    ChunkUpdate chunkUpdates[4];  // updateChunk for this wind, by min(people tested, 2), then the hit raster's
+    std::vector<float> shadowTop; // Per screen column, the height at which rain lands on the scene or the ground
+    float shadowHighest;          // Range of shadowTop over the sheltered columns
+    float shadowLowest;
+    std::vector<std::uint8_t> flags; // One bit per drop, written by the integration kernel
+    IntegrateKernel integrate;
+    JobSystem& jobs;
+    // What one chunk adds up while it runs. Each starts on its own cache line, so workers
+    // finishing neighbouring chunks never write to the same line, and they are reduced in
+    // chunk order rather than per thread, so the sums don't depend on who ran what
+    struct alignas(CACHE_LINE_BYTES) ChunkSums {
+        float wetness[MAX_PEOPLE];
+        SurfaceWetness surfaces[MAX_PEOPLE];
+        CollisionCounters counters;
+        DropLifetimes lifetimes;
+        float collisionTime;
+        std::uint32_t hits;     // Catches written to the chunk's row of chunkHits
+        std::uint32_t lostHits; // And those that didn't fit
+        std::uint32_t kept;     // Survivors the chunk closed up at its front when culling
+    };
+    std::vector<ChunkSums> chunkSums;
+    mutable std::vector<ChunkLag> chunkLags; // Per chunk. Mutable, like drops, so getDrops can catch them up
+    std::vector<HitBox> personBoxes;         // This step's people, where they are at the end of it
+    std::vector<HitBox> sweptBoxes;          // The same, stretched back to where they began it, as the batched test reads them
+    std::vector<HitBox> previousBoxes;       // Last step's, to tell how far each person moved
+    std::vector<float> personMotion;         // Per person, how far they moved right this step
+    std::vector<float> personFacing;         // Per person, 1 facing right and -1 facing left
+    BodyShape body;
+    std::vector<HitShape> endShapes;         // Per person, their body where the step ends, unless bodies are boxes
+    std::vector<HitShape> startShapes;       // And where it began
+    AabbTree peopleTree;                     // The swept boxes, for crowds too big to test every candidate against all of
+    std::vector<std::uint32_t> personProxies; // Per person, their leaf in peopleTree
+    std::vector<RainImpact> impacts;
+    std::size_t impactCapacity;
+    std::size_t hitStride;              // Catches one chunk can record in a step, 0 when they aren't recorded
+    std::vector<RainHit> chunkHits;     // Per chunk, a row of hitStride catches
+    std::vector<RainHit> hits;          // The last step's, gathered from the rows in chunk order
+    std::uint64_t lostHits;
+    RainField sortScratch;              // Where sortByColumn writes the store before swapping it in. A second pool's worth of memory
+    std::vector<std::uint32_t> sortCounts;
+    LineVector<std::uint32_t> sortBlockCounts; // Each sort block's count of each cell, see sortByCell
+    std::vector<std::uint32_t> mergeCounts;  // mergeByColumn's working space
+    std::size_t sortedDrops;            // With column buckets, how many drops at the front sortCounts' buckets hold. 0 when unknown
+    std::size_t displaced;              // Drops added or moved since the store was last sorted
+    bool columnBuckets;                 // Sort every step and use sortCounts as column buckets
+    std::vector<float> bucketDrift;     // With column buckets in wind, how far it moved each drop this step. Empty in calm air
+    std::size_t coarseSteps;            // Most steps in a row a chunk far above everything moves in. 1 moves every chunk every step
+    std::vector<float> columnTops;               // Per bucket, the highest top of the people covering it this step
+    std::vector<float> columnBottoms;            // And the lowest bottom
+    std::vector<SurfaceWetness> bucketSurfaces;  // Per person, catchInColumns' split before it's added to the caller's
+    StepTimings timings;
+    CollisionCounters counters;
+    DropLifetimes lifetimes;        // Since the last reset, gathered from the chunks' like counters
+    GroundWater ground;
+    std::size_t groundStride;       // Floats from one chunk's row of landings to the next, whole cache lines apart
+    LineVector<float> chunkGround; // Per chunk, the area that reached each ground cell this step. The first row ends up the total
+
+    // The water a collider has caught, and the edges it drips from
+    struct Shelter {
+        float left;   // Where a drip off the left edge starts, clear of the columns the collider shadows
+        float right;  // Likewise off the right edge
+        float bottom; // Drips start level with the underside
+        float hold;   // Water it holds without dripping
+        float water;  // Water on it now
+        float due;    // Water that has run off it but not yet been dripped, less than a drip's worth
+        std::uint32_t dripped;
+    };
+
+    bool shelterDrips;
+    std::vector<std::uint32_t> shadowOwner; // Per screen column, the collider shadowTop is the top of, or NO_COLLIDER
+    std::vector<Shelter> shelters;          // One per collider, in the scene's order
+    std::size_t shelterStride;              // Floats from one chunk's row of caught water to the next, whole cache lines apart
+    LineVector<float> chunkShelters;       // Per chunk, the area that landed on each collider this step
+
+    float coalesceDistance;                 // RainConfig::coalesceDistance, 0 with column buckets or coarse steps
+
+    void placeShelter(Shelter& shelter, const sf::FloatRect& bounds) const {
+        shelter.left = rectLeft(bounds) - 0.5f - maxSize; // Half a pixel out, clear of the columns it shadows
+        shelter.right = rectLeft(bounds) + rectWidth(bounds) + 0.5f;
+        shelter.bottom = rectTop(bounds) + rectHeight(bounds);
+        shelter.hold = SHELTER_HOLD * rectWidth(bounds);
+    }
+
+    // Heights at which some drop can land on something, for the integration kernel's band
+    void findShadowBand() {
+        const float ground = static_cast<float>(windowSize.y);
+        shadowHighest = ground;
+        shadowLowest = -ground;
+        for (float top : shadowTop) {
+            if (top < ground) {
+                shadowHighest = std::min(shadowHighest, top);
+                shadowLowest = std::max(shadowLowest, top);
+            }
+        }
+    }
+
+    static std::size_t roundUpToLine(std::size_t floats) {
+        const std::size_t perLine = CACHE_LINE_BYTES / sizeof(float);
+        return (floats + perLine - 1) / perLine * perLine;
+    }
+
+    // Adds count raindrops with a random size and position just above the top of the window,
+    // within the spawn band, marked as already caught by the people in caught. Drops that
+    // don't fit in the pool are skipped. Drop i of the step is drawn from from at counter
+    // (i, step) alone, so big spawns split into jobs and still come out bit for bit as they
+    // would on one thread
+    void spawnDrops(std::uint64_t step, std::size_t count, const CounterRng& from, std::uint32_t caught) {
+        RAINMYTH_ZONE("Spawn");
+        std::size_t first = 0;
+        count = drops.grow(count, first);
+        displaced += count;
+        if (count == 0) {
+            return;
+        }
+        // Jobs split the new drops where the store's SPAWNS_PER_CHUNK boundaries fall, not
+        // SPAWNS_PER_CHUNK from the first, so each writes whole cache lines but at the ends.
+        // Drop i comes out the same whichever job spawns it
+        const std::size_t lead = first % SPAWNS_PER_CHUNK;
+        const std::size_t chunks = (lead + count + SPAWNS_PER_CHUNK - 1) / SPAWNS_PER_CHUNK;
+        if (chunks == 1 || jobs.threadCount() == 1) {
+            spawnRange(step, first, 0, count, from, caught);
+            return;
+        }
+        jobs.run(chunks, [this, step, first, count, lead, &from, caught](std::size_t chunk, unsigned) {
+            const std::size_t begin = std::max(chunk * SPAWNS_PER_CHUNK, lead) - lead;
+            spawnRange(step, first, begin, std::min((chunk + 1) * SPAWNS_PER_CHUNK - lead, count), from, caught);
+        });
+    }
+
+    // Spawns every lane's drops for the step as spawnDrops would spawn each in turn, to the
+    // slot, but with one grow of the store for them all and one run over every lane's chunks.
+    // A lane only spawns its share of the rate, usually less than a chunk, so a lane at a time
+    // would run each one on a single thread
+    void spawnLanes(std::uint64_t step, float deltaTime) {
+        RAINMYTH_ZONE("Spawn");
+        std::size_t wanted = 0;
+        for (Lane& lane : lanes) {
+            const float expected = spawnRate * spawnWidth() * deltaTime + lane.spawnCarry;
+            const float whole = std::floor(expected);
+            lane.spawnCarry = expected - whole;
+            lane.spawning = static_cast<std::size_t>(whole);
+            wanted += lane.spawning;
+        }
+        std::size_t first = 0;
+        std::size_t room = drops.grow(wanted, first);
+        displaced += room;
+
+        // Lanes take their slots in order, so when the store fills up the later ones go short
+        spawnChunks.clear();
+        for (std::size_t i = 0; i < lanes.size(); ++i) {
+            const std::size_t count = std::min(lanes[i].spawning, room);
+            for (std::size_t begin = 0; begin < count; begin += SPAWNS_PER_CHUNK) {
+                const SpawnChunk chunk = { static_cast<std::uint32_t>(i), first, begin, std::min(begin + SPAWNS_PER_CHUNK, count) };
+                spawnChunks.push_back(chunk);
+            }
+            first += count;
+            room -= count;
+        }
+        auto spawnChunk = [this, step](std::size_t index, unsigned) {
+            const SpawnChunk& chunk = spawnChunks[index];
+            const Lane& lane = lanes[chunk.lane];
+            spawnRange(step, chunk.first, chunk.begin, chunk.end, lane.spawnRng, lane.others);
+        };
+        if (spawnChunks.size() == 1 || jobs.threadCount() == 1) {
+            for (std::size_t i = 0; i < spawnChunks.size(); ++i) {
+                spawnChunk(i, 0);
+            }
+            return;
+        }
+        jobs.run(spawnChunks.size(), spawnChunk);
+    }
+
+    // Lets each collider's water beyond what it holds run off, and drips what has run off as
+    // drops of the largest size, alternately off its left and right edges. The drips go into
+    // the pool the way spawns do, so this costs in proportion to how many drip, not to how much
+    // rain lands. Drips that don't fit in the pool, or that have no edge on the screen to fall
+    // from, wait on the collider
+    void dripShelters(float deltaTime) {
+        RAINMYTH_ZONE("Drip");
+        const float dripArea = RainField::areaOf(maxSize);
+        const float drain = 1.0f - std::exp(-deltaTime / SHELTER_DRIP_TIME);
+        const float lastX = static_cast<float>(windowSize.x) - maxSize;
+        std::size_t wanted = 0;
+        for (Shelter& shelter : shelters) {
+            const float runoff = std::max(shelter.water - shelter.hold, 0.0f) * drain;
+            shelter.water -= runoff;
+            shelter.due += runoff;
+            if (shelter.left >= 0.0f || shelter.right <= lastX) {
+                wanted += static_cast<std::size_t>(shelter.due / dripArea);
+            }
+        }
+        std::size_t first = 0;
+        const std::size_t room = drops.grow(wanted, first);
+        displaced += room;
+        std::size_t next = first;
+        for (Shelter& shelter : shelters) {
+            const bool leftOpen = shelter.left >= 0.0f;
+            const bool rightOpen = shelter.right <= lastX;
+            if (!leftOpen && !rightOpen) {
+                continue;
+            }
+            const std::size_t count = std::min(static_cast<std::size_t>(shelter.due / dripArea), first + room - next);
+            for (std::size_t k = 0; k < count; ++k, ++next) {
+                const bool left = leftOpen && (!rightOpen || shelter.dripped++ % 2 == 0);
+                drops.x[next] = left ? shelter.left : shelter.right;
+                drops.y[next] = shelter.bottom;
+                drops.size[next] = maxSize;
+                drops.absorbed[next] = 0;
+            }
+            shelter.due -= count * dripArea;
+        }
+        setTerminalSpeeds(first, room);
+    }
+
+    // Fills in spawns [begin, end) of this step, which went into the store from first on
+    void spawnRange(std::uint64_t step, std::size_t first, std::size_t begin, std::size_t end, const CounterRng& from, std::uint32_t caught) {
+        const std::size_t slot = first + begin;
+        const SpawnParams params = { 0.0f, spawnWidth(), spawnTop, caught };
+        fillSpawns(from, step, static_cast<std::uint32_t>(begin), end - begin, params, sizes, speeds,
+            &drops.x[slot], &drops.y[slot], &drops.vy[slot], &drops.size[slot], &drops.absorbed[slot]);
+        stretchSpawns(&drops.x[slot], end - begin);
+    }
+
+    // The part of the spawn band at the full rate, and the two parts either side of it
+    void spawnParts(float& left, float& full, float& right) const {
+        const float fullBegin = std::min(std::max(fullLeft, spawnLeft), spawnRight);
+        const float fullEnd = std::min(std::max(fullRight, fullBegin), spawnRight);
+        left = fullBegin - spawnLeft;
+        full = fullEnd - fullBegin;
+        right = spawnRight - fullEnd;
+    }
+
+    // Width of band that would spawn the same number of drops at the full rate everywhere
+    float spawnWidth() const {
+        if (openOnly) {
+            return openWidth;
+        }
+        float left, full, right;
+        spawnParts(left, full, right);
+        return full + (left + right) * outerDensity;
+    }
+
+    // Picks x for count new drops, uniformly over the spawn band's effective width and then
+    // stretched back out over the thinned parts, so the density comes out right in each
+    void placeSpawns(float* x, std::size_t count) {
+        rng.fillUniform(x, count, 0.0f, spawnWidth());
+        stretchSpawns(x, count);
+    }
+
+    // Works out openSpans from the band, the reach and the rain shadow, a column at a time
+    void findOpenSpans() {
+        openSpans.clear();
+        openWidth = 0.0f;
+        openOnly = spawnReach > -std::numeric_limits<float>::max() && wind.isCalm() && !shelterDrips;
+        if (!openOnly) {
+            return;
+        }
+        bool closed = false;
+        for (float column = std::floor(spawnLeft); column < spawnRight; column += 1.0f) {
+            const float left = std::max(column, spawnLeft);
+            const float right = std::min(column + 1.0f, spawnRight);
+            if (shadowTop[columnOf(column)] < spawnReach) {
+                closed = true;
+                continue;
+            }
+            if (openSpans.empty() || openSpans.back().right != left) {
+                const OpenSpan span = { left, left, openWidth };
+                openSpans.push_back(span);
+            }
+            openSpans.back().right = right;
+            openWidth += right - left;
+        }
+        // With nothing sheltered the band spawns as it would without a reach, thinning and all
+        openOnly = closed;
+    }
+
+    // Maps x of count new drops from [0, spawnWidth()) onto the spawn band
+    void stretchSpawns(float* x, std::size_t count) const {
+        if (openOnly) {
+            for (std::size_t i = 0; i < count; ++i) {
+                const float u = x[i];
+                auto span = std::upper_bound(openSpans.begin(), openSpans.end(), u,
+                    [](float offset, const OpenSpan& open) { return offset < open.offset; });
+                span = span == openSpans.begin() ? span : span - 1;
+                x[i] = span == openSpans.end() ? spawnLeft : std::min(span->left + (u - span->offset), span->right);
+            }
+            return;
+        }
+        float left, full, right;
+        spawnParts(left, full, right);
+        if (outerDensity >= 1.0f) {
+            for (std::size_t i = 0; i < count; ++i) {
+                x[i] += spawnLeft;
+            }
+            return;
+        }
+        const float thinLeft = left * outerDensity;
+        const float stretch = outerDensity > 0.0f ? 1.0f / outerDensity : 0.0f;
+        for (std::size_t i = 0; i < count; ++i) {
+            const float u = x[i];
+            if (u < thinLeft) {
+                x[i] = spawnLeft + u * stretch;
+            }
+            else if (u < thinLeft + full) {
+                x[i] = spawnLeft + left + (u - thinLeft);
+            }
+            else {
+                x[i] = spawnLeft + left + full + (u - thinLeft - full) * stretch;
+            }
+        }
+    }
+
+    // Drops spawn already falling at the terminal speed for their size. Drag makes real drops
+    // reach it long before they are anywhere near the screen, so there's no acceleration phase
+    void setTerminalSpeeds(std::size_t first, std::size_t count) {
+        for (std::size_t i = first; i < first + count; ++i) {
+            drops.vy[i] = speeds.lookup(drops.size[i]);
+        }
+    }
+
+    // Column bucket holding x, clamped to the columns sortByColumn made
+    std::size_t bucketOf(float x, std::size_t columns) const {
+        const float column = std::min(std::max(x / COLUMN_BUCKET_WIDTH, 0.0f), static_cast<float>(columns - 1));
+        return static_cast<std::size_t>(column);
+    }
+
+    // Screen column holding x, clamped to the screen
+    std::size_t columnOf(float x) const {
+        const float column = std::min(std::max(x, 0.0f), static_cast<float>(shadowTop.size() - 1));
+        return static_cast<std::size_t>(column);
+    }
+};
@@ -0,0 +1,142 @@
+#include "RemoteControl.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "RainIntensity.h"
+
+namespace {
+
+struct CommandName {
+    const char* name;
+    RemoteCommandType type;
+    bool takesValue;
+};
+
+const CommandName COMMAND_NAMES[] = {
+    { "walk", REMOTE_WALK, false },
+    { "run", REMOTE_RUN, false },
+    { "reset", REMOTE_RESET, false },
+    { "rate", REMOTE_SPAWN_RATE, true },
+    { "rain", REMOTE_RAIN, true },
+    { "wind", REMOTE_WIND, true },
+    { "width", REMOTE_PERSON_WIDTH, true },
+    { "height", REMOTE_PERSON_HEIGHT, true },
+    { "wetness", REMOTE_MAX_WETNESS, true },
+};
+
+// Reads one line, without its ending, into command. Returns null, or what's wrong with it
+const char* parseCommand(char* line, RemoteCommand& command) {
+    const char* name = std::strtok(line, " \t\r");
+    const char* value = std::strtok(nullptr, " \t\r");
+    if (name == nullptr) {
+        return "empty line";
+    }
+    for (const CommandName& known : COMMAND_NAMES) {
+        if (std::strcmp(name, known.name) != 0) {
+            continue;
+        }
+        command.type = known.type;
+        command.value = 0.0f;
+        if (!known.takesValue) {
+            return value == nullptr ? nullptr : "takes no value";
+        }
+        if (value == nullptr) {
+            return "needs a value";
+        }
+        if (known.type == REMOTE_RAIN) {
+            return parseRainIntensity(value, command.value) ? nullptr : "expected drizzle, moderate, heavy, downpour or mm per hour";
+        }
+        char* end = nullptr;
+        command.value = std::strtof(value, &end);
+        return *end == '\0' ? nullptr : "expected a number";
+    }
+    return "unknown command";
+}
+
+} // namespace
+
+RemoteControl::RemoteControl(unsigned short port) : available(false), connected(false), overflowed(false), used(0), read(0) {
+    if (listener.listen(port) != sf::Socket::Status::Done) {
+        std::cerr << "Couldn't listen for remote control on port " << port << std::endl;
+        return;
+    }
+    listener.setBlocking(false);
+    available = true;
+    std::cout << "Taking remote control on port " << port << std::endl;
+}
+
+void RemoteControl::receive() {
+    if (!available) {
+        return;
+    }
+    if (!connected) {
+        if (listener.accept(controller) != sf::Socket::Status::Done) {
+            return;
+        }
+        controller.setBlocking(false);
+        connected = true;
+        overflowed = false;
+        used = 0;
+        read = 0;
+    }
+
+    // Whatever's been handed out makes way for more
+    std::memmove(buffer, buffer + read, used - read);
+    used -= read;
+    read = 0;
+    if (used == BUFFER_BYTES) {
+        used = 0; // One line filled it; drop that and skip to the next line break
+        overflowed = true;
+        send("error line too long\n");
+    }
+
+    std::size_t received = 0;
+    const sf::Socket::Status status = controller.receive(buffer + used, BUFFER_BYTES - used, received);
+    if (status == sf::Socket::Status::Disconnected || status == sf::Socket::Status::Error) {
+        controller.disconnect();
+        connected = false;
+        used = 0;
+        return;
+    }
+    used += received;
+}
+
+bool RemoteControl::next(RemoteCommand& command) {
+    while (connected) {
+        char* line = buffer + read;
+        char* end = static_cast<char*>(std::memchr(line, '\n', used - read));
+        if (end == nullptr) {
+            return false;
+        }
+        *end = '\0';
+        read = end + 1 - buffer;
+        if (overflowed) {
+            overflowed = false; // The tail of the line that was too long
+            continue;
+        }
+        const char* error = parseCommand(line, command);
+        if (error == nullptr) {
+            return true;
+        }
+        reply(error);
+    }
+    return false;
+}
+
+void RemoteControl::reply(const char* error) {
+    if (error == nullptr) {
+        send("ok\n");
+        return;
+    }
+    char line[128];
+    std::snprintf(line, sizeof(line), "error %s\n", error);
+    send(line);
+}
+
+void RemoteControl::send(const char* text) {
+    std::size_t sent = 0;
+    (void)controller.send(text, std::strlen(text), sent);
+}
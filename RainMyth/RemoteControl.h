@@ -0,0 +1,71 @@
+#pragma once
+
+#include <SFML/Network/TcpListener.hpp>
+#include <SFML/Network/TcpSocket.hpp>
+#include <cstddef>
+
+// What a controller asked for
+enum RemoteCommandType {
+    REMOTE_WALK,          // Start a walk, as W does
+    REMOTE_RUN,           // Start a run, as R does
+    REMOTE_RESET,         // Put the person back at the start, dry
+    REMOTE_SPAWN_RATE,    // value drops per second per pixel of width
+    REMOTE_RAIN,          // value mm of rain an hour, from a number or a preset name
+    REMOTE_WIND,          // Steady wind of value pixels per second, positive to the right
+    REMOTE_PERSON_WIDTH,
+    REMOTE_PERSON_HEIGHT,
+    REMOTE_MAX_WETNESS
+};
+
+struct RemoteCommand {
+    RemoteCommandType type;
+    float value;
+};
+
+// Takes commands for a running simulation over TCP, for kiosks and render nodes nobody sits
+// at. A controller connects and sends lines of text, each a command and its value if it takes
+// one:
+//
+//   walk | run | reset
+//   rate DROPS_PER_SECOND_PER_PIXEL
+//   rain drizzle|moderate|heavy|downpour|MM_PER_HOUR
+//   wind PIXELS_PER_SECOND
+//   width PIXELS | height PIXELS | wetness MAX_WETNESS
+//
+// and gets a line back for each, "ok" or "error" and why. One controller is served at a time;
+// the next is taken once it hangs up. The listener and the connection are non-blocking and
+// polled once a frame, so a slow or silent controller never holds up a frame: bytes are taken
+// as they have arrived, and a reply the OS can't take at once is cut short rather than waited on
+class RemoteControl {
+public:
+    // Listens on port, on every interface. isAvailable() says whether that worked
+    explicit RemoteControl(unsigned short port);
+
+    bool isAvailable() const {
+        return available;
+    }
+
+    // Takes in a waiting controller and whatever it has sent since the last call
+    void receive();
+
+    // The next whole command received, false once there are none. Lines that aren't commands
+    // are answered with an error here and skipped
+    bool next(RemoteCommand& command);
+
+    // Answers the command next last returned: ok when error is null, else error
+    void reply(const char* error);
+
+private:
+    static const std::size_t BUFFER_BYTES = 1024; // Longest run of unread input; a longer line is thrown away
+
+    sf::TcpListener listener;
+    sf::TcpSocket controller;
+    bool available;
+    bool connected;
+    bool overflowed;   // Throwing away the rest of a line too long for the buffer
+    char buffer[BUFFER_BYTES];
+    std::size_t used;  // Bytes of buffer received
+    std::size_t read;  // Bytes of those already handed out as commands
+
+    void send(const char* text);
+};
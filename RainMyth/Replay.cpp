@@ -0,0 +1,207 @@
+#include "Replay.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "RainSystem.h"
+#include "RunSummary.h"
+#include "Scene.h"
+
+namespace {
+
+const char REPLAY_MAGIC[4] = { 'R', 'M', 'R', 'P' };
+const std::uint32_t REPLAY_VERSION = 5;
+
+// Fields are written in the machine's own byte order, which is little-endian on every x86 and
+// ARM target RainMyth builds for, so logs move between nodes as they are
+template <typename T>
+void writePod(std::ofstream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+bool readPod(std::ifstream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+void writeString(std::ofstream& out, const std::string& value) {
+    writePod(out, static_cast<std::uint32_t>(value.size()));
+    out.write(value.data(), value.size());
+}
+
+bool readString(std::ifstream& in, std::string& value) {
+    std::uint32_t length = 0;
+    if (!readPod(in, length) || length > 4096) {
+        return false;
+    }
+    value.resize(length);
+    return length == 0 || static_cast<bool>(in.read(&value[0], length));
+}
+
+void mix(std::uint64_t& hash, const void* data, std::size_t bytes) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < bytes; ++i) {
+        hash ^= p[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+} // namespace
+
+bool writeReplay(const std::string& path, const ReplayLog& log) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        std::cerr << "Could not write replay " << path << std::endl;
+        return false;
+    }
+    out.write(REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+    writePod(out, REPLAY_VERSION);
+    writePod(out, log.rain.seed);
+    writePod(out, static_cast<std::uint64_t>(log.rain.maxDrops));
+    writePod(out, log.rain.spawnRate);
+    writePod(out, log.rain.minSize);
+    writePod(out, log.rain.maxSize);
+    writePod(out, static_cast<std::uint8_t>(log.rain.sizeModel));
+    writePod(out, log.rain.rainIntensity);
+    writePod(out, log.rain.wind.speed);
+    writePod(out, log.rain.wind.gust);
+    writePod(out, log.rain.wind.gustPeriod);
+    writePod(out, log.rain.wind.turbulence);
+    writePod(out, log.simHz);
+    writePod(out, static_cast<std::uint32_t>(log.width));
+    writePod(out, static_cast<std::uint32_t>(log.height));
+    writePod(out, static_cast<std::uint8_t>(log.lod));
+    writeString(out, log.scenePath);
+    writeString(out, log.kernel);
+    writePod(out, static_cast<std::uint8_t>(log.strictFloat));
+
+    writePod(out, static_cast<std::uint64_t>(log.inputs.size()));
+    for (const ReplayInput& input : log.inputs) {
+        writePod(out, input.step);
+        writePod(out, static_cast<std::uint8_t>(input.event));
+    }
+    writePod(out, log.steps);
+    writePod(out, log.checksum);
+
+    if (!out) {
+        std::cerr << "Could not write replay " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool readReplay(const std::string& path, ReplayLog& log) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "Could not open replay " << path << std::endl;
+        return false;
+    }
+    char magic[4] = {};
+    std::uint32_t version = 0;
+    in.read(magic, sizeof(magic));
+    if (!in || std::memcmp(magic, REPLAY_MAGIC, sizeof(magic)) != 0 || !readPod(in, version) || version != REPLAY_VERSION) {
+        std::cerr << path << " is not a version " << REPLAY_VERSION << " replay" << std::endl;
+        return false;
+    }
+
+    std::uint64_t maxDrops = 0;
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    std::uint8_t lod = 0;
+    std::uint8_t sizeModel = 0;
+    std::uint8_t strictFloat = 0;
+    std::uint64_t inputCount = 0;
+    bool ok = readPod(in, log.rain.seed) && readPod(in, maxDrops) && readPod(in, log.rain.spawnRate)
+        && readPod(in, log.rain.minSize) && readPod(in, log.rain.maxSize)
+        && readPod(in, sizeModel) && readPod(in, log.rain.rainIntensity)
+        && readPod(in, log.rain.wind.speed) && readPod(in, log.rain.wind.gust)
+        && readPod(in, log.rain.wind.gustPeriod) && readPod(in, log.rain.wind.turbulence) && readPod(in, log.simHz)
+        && readPod(in, width) && readPod(in, height) && readPod(in, lod)
+        && readString(in, log.scenePath) && readString(in, log.kernel) && readPod(in, strictFloat)
+        && readPod(in, inputCount);
+    log.rain.maxDrops = static_cast<std::size_t>(maxDrops);
+    log.width = width;
+    log.height = height;
+    log.lod = lod != 0;
+    log.strictFloat = strictFloat != 0;
+    log.rain.sizeModel = sizeModel == DROP_SIZES_MARSHALL_PALMER ? DROP_SIZES_MARSHALL_PALMER : DROP_SIZES_UNIFORM;
+
+    log.inputs.clear();
+    for (std::uint64_t i = 0; ok && i < inputCount; ++i) {
+        ReplayInput input;
+        std::uint8_t event = 0;
+        ok = readPod(in, input.step) && readPod(in, event) && event <= REPLAY_RUN;
+        input.event = static_cast<ReplayEvent>(event);
+        log.inputs.push_back(input);
+    }
+    ok = ok && readPod(in, log.steps) && readPod(in, log.checksum);
+    if (!ok) {
+        std::cerr << "Replay " << path << " is truncated or corrupt" << std::endl;
+    }
+    else if (!log.strictFloat || !isStrictFloatBuild()) {
+        std::cerr << "Replay " << path << " was recorded by a " << (log.strictFloat ? "strict" : "fast") << " float build and this is a "
+            << (isStrictFloatBuild() ? "strict" : "fast") << " one, so it may not reproduce bit for bit" << std::endl;
+    }
+    return ok;
+}
+
+void applyReplay(const ReplayLog& log, Options& options) {
+    options.rain = log.rain;
+    options.simHz = log.simHz;
+    options.width = log.width;
+    options.height = log.height;
+    options.lod = log.lod;
+    options.scenePath = log.scenePath;
+    options.kernel = log.kernel;
+}
+
+void applyReplayEvent(ReplayEvent event, Person& person, sf::Vector2u screen) {
+    person.reset(startPoint(screen));
+    person.startMove(endPoint(screen), event == REPLAY_RUN ? RUN_SPEED : WALK_SPEED);
+}
+
+std::uint64_t stateChecksum(const RainField& drops, float wetness) {
+    std::uint64_t hash = 14695981039346656037ull;
+    const std::size_t count = drops.count();
+    mix(hash, &count, sizeof(count));
+    mix(hash, drops.x.data(), count * sizeof(float));
+    mix(hash, drops.y.data(), count * sizeof(float));
+    mix(hash, drops.vy.data(), count * sizeof(float));
+    mix(hash, drops.size.data(), count * sizeof(float));
+    mix(hash, &wetness, sizeof(wetness));
+    return hash;
+}
+
+int runReplay(const ReplayLog& log, IntegrateKernel integrate, JobSystem& jobs) {
+    // Set up exactly as the rendered run was, minus the window
+    const sf::Vector2u screen(log.width, log.height);
+    const float timestep = 1.0f / log.simHz;
+    const Scene scene = loadScene(log.scenePath, screen);
+    RainSystem rainSystem(screen, log.rain, scene, integrate, jobs);
+    if (log.lod) {
+        const sf::Vector2f band = nearBand(screen, scene, sf::Vector2f(PERSON_WIDTH, PERSON_HEIGHT), log.rain.maxSize);
+        rainSystem.setSpawnBand(band.x, band.y);
+    }
+    Person person(startPoint(screen));
+
+    std::size_t next = 0;
+    for (std::uint64_t step = 0; step < log.steps; ++step) {
+        for (; next < log.inputs.size() && log.inputs[next].step == step; ++next) {
+            applyReplayEvent(log.inputs[next].event, person, screen);
+        }
+        person.update(timestep);
+        person.addWetness(rainSystem.update(timestep, person.getBounds()));
+    }
+    addSimulatedWork(rainSystem.getLifetimes().stepCount, rainSystem.getLifetimes().liveSteps);
+
+    const std::uint64_t checksum = stateChecksum(rainSystem.getDrops(), person.getWetness());
+    std::cout << "Replayed " << log.steps << " steps, " << log.inputs.size() << " inputs" << std::endl;
+    std::cout << "Wetness: " << person.getWetness() << std::endl;
+    if (checksum != log.checksum) {
+        std::cout << "Final state differs from the recording" << std::endl;
+        return 1;
+    }
+    std::cout << "Final state matches the recording" << std::endl;
+    return 0;
+}
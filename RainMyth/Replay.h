@@ -0,0 +1,68 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "JobSystem.h"
+#include "Options.h"
+#include "Person.h"
+#include "RainConfig.h"
+#include "RainField.h"
+#include "RainKernels.h"
+
+// Inputs that change the simulation. Everything else a run depends on is in the log's header
+enum ReplayEvent {
+    REPLAY_WALK, // W: back to the start and walk
+    REPLAY_RUN   // R: back to the start and run
+};
+
+// An input and the simulation step it was applied before
+struct ReplayInput {
+    std::uint64_t step;
+    ReplayEvent event;
+};
+
+// Everything needed to repeat a rendered run step for step. The rain is seeded and advances
+// on the fixed --sim-hz step, so the seed, the configuration and the step each input landed on
+// pin the whole run down; frame timing only decides how many steps run per frame and drops out.
+// checksum is taken over the final drop state and wetness, so a replay can tell whether it
+// really reproduced the run
+struct ReplayLog {
+    RainConfig rain;
+    float simHz = SIM_HZ;
+    unsigned width = 0;
+    unsigned height = 0;
+    bool lod = false;
+    std::string scenePath;
+    std::string kernel;
+    bool strictFloat = true; // Recorded by a strict float build, see isStrictFloatBuild
+    std::vector<ReplayInput> inputs;
+    std::uint64_t steps = 0;
+    std::uint64_t checksum = 0;
+};
+
+// Writes the log as a small binary file. Returns false and reports on stderr on failure
+bool writeReplay(const std::string& path, const ReplayLog& log);
+
+// Reads a log written by writeReplay. Returns false and reports on stderr if it can't. Warns
+// if the log or this build isn't strict float, since the replay may then not reproduce
+bool readReplay(const std::string& path, ReplayLog& log);
+
+// Points options at the run the log recorded, kernel included, so the rain is set up the same
+// way. A fast float build's kernels only agree bit for bit when they do the same arithmetic, so
+// the recorded one is asked for even if this machine would pick another. Strict builds agree
+// whatever the kernel, so a node without it, like an ARM one given an AVX2 log, uses its own
+void applyReplay(const ReplayLog& log, Options& options);
+
+// What a W or R press does to the person
+void applyReplayEvent(ReplayEvent event, Person& person, sf::Vector2u screen);
+
+// FNV-1a over every live drop and the wetness, bit for bit
+std::uint64_t stateChecksum(const RainField& drops, float wetness);
+
+// Replays log with no window and prints the wetness and whether the final state matches the
+// recording. Returns the process exit code, nonzero if the replay diverged
+int runReplay(const ReplayLog& log, IntegrateKernel integrate, JobSystem& jobs);
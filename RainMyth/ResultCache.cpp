@@ -0,0 +1,206 @@
+#include "ResultCache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include "Fingerprint.h"
+#include "SfmlCompat.h"
+
+namespace {
+
+// The file is "RMRC" and a version, then one record per result: its key as a 64-bit integer,
+// its count of floats as a 32-bit one, the floats, and an FNV-1a checksum of all that. Numbers
+// are in the machine's own byte order like the telemetry's, and keys are only comparable
+// between machines of the same kind, see Fingerprint
+const char CACHE_MAGIC[4] = { 'R', 'M', 'R', 'C' };
+const std::uint32_t CACHE_VERSION = 1;
+const std::size_t HEADER_BYTES = 4 + 4;
+
+template <typename T>
+void append(std::vector<unsigned char>& bytes, const T& value) {
+    const unsigned char* at = reinterpret_cast<const unsigned char*>(&value);
+    bytes.insert(bytes.end(), at, at + sizeof(value));
+}
+
+template <typename T>
+bool take(const unsigned char* bytes, std::size_t size, std::size_t& at, T& value) {
+    if (size - at < sizeof(value)) {
+        return false;
+    }
+    std::memcpy(&value, bytes + at, sizeof(value));
+    at += sizeof(value);
+    return true;
+}
+
+} // namespace
+
+ResultCache::ResultCache(const std::string& path) : path(path), file(nullptr), hits(0), misses(0) {
+    std::error_code error;
+    if (std::filesystem::exists(path, error)) {
+        const std::size_t good = index();
+        if (good == 0) {
+            std::cerr << path << " isn't a result cache, running without one" << std::endl;
+            return;
+        }
+        if (good < mapped.size()) {
+            // Cut off a record a crash tore, which can't be done while the file is mapped
+            mapped.close();
+            std::filesystem::resize_file(path, good, error);
+            if (error || index() != good) {
+                std::cerr << "Couldn't cut the torn end off " << path << ", running without a result cache" << std::endl;
+                mapped.close();
+                stored.clear();
+                return;
+            }
+        }
+        file = std::fopen(path.c_str(), "ab");
+    }
+    else {
+        file = std::fopen(path.c_str(), "wb");
+        if (file != nullptr) {
+            std::vector<unsigned char> header(CACHE_MAGIC, CACHE_MAGIC + sizeof(CACHE_MAGIC));
+            append(header, CACHE_VERSION);
+            std::fwrite(header.data(), 1, header.size(), file);
+            std::fflush(file);
+        }
+    }
+    if (file == nullptr) {
+        std::cerr << "Couldn't open " << path << " for writing, running without a result cache" << std::endl;
+    }
+}
+
+ResultCache::~ResultCache() {
+    if (file != nullptr) {
+        std::fclose(file);
+    }
+}
+
+bool ResultCache::find(std::uint64_t key, std::vector<float>& results) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto kept = added.find(key);
+    if (kept != added.end()) {
+        results = kept->second;
+        ++hits;
+        return true;
+    }
+    const auto at = stored.find(key);
+    if (at == stored.end()) {
+        ++misses;
+        return false;
+    }
+    std::uint32_t count = 0;
+    std::memcpy(&count, mapped.data() + at->second, sizeof(count));
+    results.resize(count);
+    std::memcpy(results.data(), mapped.data() + at->second + sizeof(count), count * sizeof(float));
+    ++hits;
+    return true;
+}
+
+void ResultCache::add(std::uint64_t key, const std::vector<float>& results) {
+    std::vector<unsigned char> record;
+    append(record, key);
+    append(record, static_cast<std::uint32_t>(results.size()));
+    for (float result : results) {
+        append(record, result);
+    }
+    Fingerprint checksum;
+    checksum.addBytes(record.data(), record.size());
+    append(record, checksum.value());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file == nullptr || stored.count(key) != 0 || !added.emplace(key, results).second) {
+        return;
+    }
+    if (std::fwrite(record.data(), 1, record.size(), file) != record.size() || std::fflush(file) != 0) {
+        std::cerr << "Couldn't write to " << path << ", running on without keeping results" << std::endl;
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+// Maps the file and indexes its records. Returns where the last whole record ends, or 0 if
+// it isn't a cache of this version
+std::size_t ResultCache::index() {
+    stored.clear();
+    if (!mapped.open(path)) {
+        return 0;
+    }
+    const unsigned char* bytes = mapped.data();
+    const std::size_t size = mapped.size();
+    std::size_t at = sizeof(CACHE_MAGIC);
+    std::uint32_t version = 0;
+    if (size < HEADER_BYTES || std::memcmp(bytes, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || !take(bytes, size, at, version)
+        || version != CACHE_VERSION) {
+        return 0;
+    }
+    std::size_t good = at;
+    for (;;) {
+        const std::size_t start = at;
+        std::uint64_t key = 0;
+        std::uint32_t count = 0;
+        if (!take(bytes, size, at, key) || !take(bytes, size, at, count)
+            || size - at < count * sizeof(float) + sizeof(std::uint64_t)) {
+            break;
+        }
+        at += count * sizeof(float);
+        Fingerprint checksum;
+        checksum.addBytes(bytes + start, at - start);
+        std::uint64_t sum = 0;
+        take(bytes, size, at, sum);
+        if (sum != checksum.value()) {
+            break;
+        }
+        stored.emplace(key, start + sizeof(key));
+        good = at;
+    }
+    return good;
+}
+
+std::uint64_t crowdKey(const Options& options, const RainConfig& rain, const Scene& scene, const std::vector<Walker>& walkers,
+    std::uint64_t route) {
+    Fingerprint print;
+    print.add(rain.seed);
+    print.add(static_cast<std::uint64_t>(rain.maxDrops));
+    print.add(rain.spawnRate);
+    print.add(rain.minSize);
+    print.add(rain.maxSize);
+    print.add(static_cast<std::uint32_t>(rain.sizeModel));
+    print.add(rain.rainIntensity);
+    print.add(rain.wind.speed);
+    print.add(rain.wind.gust);
+    print.add(rain.wind.gustPeriod);
+    print.add(rain.wind.turbulence);
+    print.add(rain.columnBuckets);
+    print.add(static_cast<std::uint64_t>(rain.coarseSteps));
+    print.add(static_cast<std::uint32_t>(rain.body));
+    print.add(rain.shelterDrips);
+    print.add(rain.coalesceDistance);
+    print.add(static_cast<std::uint32_t>(rain.hits));
+    print.add(options.simHz);
+    print.add(options.width);
+    print.add(options.height);
+    print.add(options.eventDriven);
+    print.add(options.procedural);
+    print.add(options.densityField);
+    print.add(options.densityParticles);
+    print.add(options.clothingCapacity);
+    print.add(options.prewarm);
+    print.add(static_cast<std::uint64_t>(scene.getColliders().size()));
+    for (const SceneCollider& collider : scene.getColliders()) {
+        print.add(static_cast<std::uint32_t>(collider.kind));
+        print.add(rectLeft(collider.bounds));
+        print.add(rectTop(collider.bounds));
+        print.add(rectWidth(collider.bounds));
+        print.add(rectHeight(collider.bounds));
+    }
+    print.add(static_cast<std::uint64_t>(walkers.size()));
+    for (const Walker& walker : walkers) {
+        print.add(walker.personWidth);
+        print.add(walker.personHeight);
+        print.add(walker.speed);
+        print.add(walker.startTime);
+        print.add(walker.trajectory != nullptr ? route : 0);
+    }
+    return print.value();
+}
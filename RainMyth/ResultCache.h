@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Headless.h"
+#include "MappedFile.h"
+#include "Options.h"
+#include "RainConfig.h"
+#include "Scene.h"
+
+// Results of simulations already run, kept on disk under a key for everything the results
+// depend on, so a study that runs the same simulation again, a sweep re-plotted or an optimizer
+// revisiting a speed, looks it up instead. Results only depend on the settings and the seed,
+// so a hit is exactly what running it again would give.
+//
+// The file is memory-mapped when opened and looked up in place; what's added afterwards is kept
+// in memory and appended to the file with a checksum, so a record torn by a crash is dropped
+// the next time it's opened. Any number of studies can share one file. The layout is described
+// in ResultCache.cpp
+class ResultCache {
+public:
+    // Opens the cache at path, making it if there isn't one. Problems are reported on stderr
+    // and leave the cache closed, so every lookup misses and nothing is kept
+    explicit ResultCache(const std::string& path);
+    ~ResultCache();
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    bool isOpen() const {
+        return file != nullptr;
+    }
+
+    // Copies the results kept under key into results and returns true, or returns false.
+    // Safe from several threads, as is add()
+    bool find(std::uint64_t key, std::vector<float>& results);
+
+    // Keeps results under key, unless something already is
+    void add(std::uint64_t key, const std::vector<float>& results);
+
+    std::size_t hitCount() const {
+        return hits;
+    }
+
+    std::size_t missCount() const {
+        return misses;
+    }
+
+private:
+    std::string path;
+    MappedFile mapped;
+    std::FILE* file;
+    std::mutex mutex;
+    std::unordered_map<std::uint64_t, std::size_t> stored; // Offset in mapped of each key's result count
+    std::unordered_map<std::uint64_t, std::vector<float>> added;
+    std::size_t hits;
+    std::size_t misses;
+
+    std::size_t index();
+};
+
+// The key a crowd's results are kept under: every setting simulateCrowd reads from options,
+// the rain with its seed, the scene's colliders as loaded, and each walker. A walker's
+// trajectory is keyed by route, a fingerprint of however the caller built it, since the
+// trajectory itself doesn't say; 0 for walkers that go straight
+std::uint64_t crowdKey(const Options& options, const RainConfig& rain, const Scene& scene, const std::vector<Walker>& walkers,
+    std::uint64_t route = 0);
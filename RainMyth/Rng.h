@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Fast seeded random source (xoshiro128**). One instance is owned by whoever spawns drops,
+// so drawing a number is a handful of integer ops instead of a trip to std::random_device
+class Rng {
+public:
+    explicit Rng(std::uint64_t seed = 0) {
+        reseed(seed);
+    }
+
+    // Expands the 64-bit seed into the 128-bit state with splitmix64
+    void reseed(std::uint64_t seed) {
+        for (int i = 0; i < 4; i += 2) {
+            std::uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            z ^= z >> 31;
+            state[i] = static_cast<std::uint32_t>(z);
+            state[i + 1] = static_cast<std::uint32_t>(z >> 32);
+        }
+    }
+
+    std::uint32_t next() {
+        const std::uint32_t result = rotl(state[1] * 5u, 7) * 9u;
+        const std::uint32_t t = state[1] << 9;
+
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 11);
+
+        return result;
+    }
+
+    // Uniform float in [0, 1) built from the top 24 bits
+    float uniform() {
+        return static_cast<float>(next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    float uniform(float lo, float hi) {
+        return lo + (hi - lo) * uniform();
+    }
+
+    // Fills out[0..n) with uniform floats in [lo, hi)
+    void fillUniform(float* out, std::size_t n, float lo, float hi) {
+        const float scale = (hi - lo) * (1.0f / 16777216.0f);
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = lo + static_cast<float>(next() >> 8) * scale;
+        }
+    }
+
+    // The raw generator state, so a snapshot can carry on the same stream
+    void getState(std::uint32_t out[4]) const {
+        for (int i = 0; i < 4; ++i) {
+            out[i] = state[i];
+        }
+    }
+
+    void setState(const std::uint32_t in[4]) {
+        for (int i = 0; i < 4; ++i) {
+            state[i] = in[i];
+        }
+    }
+
+private:
+    std::uint32_t state[4];
+
+    static std::uint32_t rotl(std::uint32_t v, int k) {
+        return (v << k) | (v >> (32 - k));
+    }
+};
+
+// Counter-based random source (Philox4x32-10, Salmon et al. 2011). There's no state to advance:
+// the numbers for a counter are a pure function of it and the key, so any thread can draw the
+// numbers of any item without the others, in any order, and get what a serial loop would.
+// Blocks of COUNTER_RNG_LANES counters are worked through in lockstep in plain arrays, which
+// compilers turn into vector multiplies where there are any
+class CounterRng {
+public:
+    explicit CounterRng(std::uint64_t seed = 0) {
+        key[0] = static_cast<std::uint32_t>(seed);
+        key[1] = static_cast<std::uint32_t>(seed >> 32);
+    }
+
+    // The four words for counter (index, stream)
+    void generate(std::uint64_t stream, std::uint32_t index, std::uint32_t out[4]) const {
+        std::uint32_t c0 = index, c1 = static_cast<std::uint32_t>(stream), c2 = static_cast<std::uint32_t>(stream >> 32), c3 = 0;
+        std::uint32_t k0 = key[0], k1 = key[1];
+        for (int round = 0; round < 10; ++round) {
+            const std::uint64_t p0 = static_cast<std::uint64_t>(MULTIPLIER_0) * c0;
+            const std::uint64_t p1 = static_cast<std::uint64_t>(MULTIPLIER_1) * c2;
+            const std::uint32_t n0 = static_cast<std::uint32_t>(p1 >> 32) ^ c1 ^ k0;
+            const std::uint32_t n2 = static_cast<std::uint32_t>(p0 >> 32) ^ c3 ^ k1;
+            c1 = static_cast<std::uint32_t>(p1);
+            c3 = static_cast<std::uint32_t>(p0);
+            c0 = n0;
+            c2 = n2;
+            k0 += WEYL_0;
+            k1 += WEYL_1;
+        }
+        out[0] = c0;
+        out[1] = c1;
+        out[2] = c2;
+        out[3] = c3;
+    }
+
+    // Uniform floats in [0, 1) for items first..first + count of stream, from the first three
+    // words of each item's block: item first + i gets a[i], b[i] and c[i]
+    void fillUniform3(std::uint64_t stream, std::uint32_t first, std::size_t count, float* a, float* b, float* c) const {
+        const std::uint32_t s0 = static_cast<std::uint32_t>(stream), s1 = static_cast<std::uint32_t>(stream >> 32);
+        std::size_t i = 0;
+        for (; i + COUNTER_RNG_LANES <= count; i += COUNTER_RNG_LANES) {
+            std::uint32_t c0[COUNTER_RNG_LANES], c1[COUNTER_RNG_LANES], c2[COUNTER_RNG_LANES], c3[COUNTER_RNG_LANES];
+            for (std::size_t lane = 0; lane < COUNTER_RNG_LANES; ++lane) {
+                c0[lane] = first + static_cast<std::uint32_t>(i + lane);
+                c1[lane] = s0;
+                c2[lane] = s1;
+                c3[lane] = 0;
+            }
+            std::uint32_t k0 = key[0], k1 = key[1];
+            for (int round = 0; round < 10; ++round) {
+                for (std::size_t lane = 0; lane < COUNTER_RNG_LANES; ++lane) {
+                    const std::uint64_t p0 = static_cast<std::uint64_t>(MULTIPLIER_0) * c0[lane];
+                    const std::uint64_t p1 = static_cast<std::uint64_t>(MULTIPLIER_1) * c2[lane];
+                    const std::uint32_t n0 = static_cast<std::uint32_t>(p1 >> 32) ^ c1[lane] ^ k0;
+                    const std::uint32_t n2 = static_cast<std::uint32_t>(p0 >> 32) ^ c3[lane] ^ k1;
+                    c1[lane] = static_cast<std::uint32_t>(p1);
+                    c3[lane] = static_cast<std::uint32_t>(p0);
+                    c0[lane] = n0;
+                    c2[lane] = n2;
+                }
+                k0 += WEYL_0;
+                k1 += WEYL_1;
+            }
+            for (std::size_t lane = 0; lane < COUNTER_RNG_LANES; ++lane) {
+                a[i + lane] = toUniform(c0[lane]);
+                b[i + lane] = toUniform(c1[lane]);
+                c[i + lane] = toUniform(c2[lane]);
+            }
+        }
+        for (; i < count; ++i) {
+            std::uint32_t words[4];
+            generate(stream, first + static_cast<std::uint32_t>(i), words);
+            a[i] = toUniform(words[0]);
+            b[i] = toUniform(words[1]);
+            c[i] = toUniform(words[2]);
+        }
+    }
+
+private:
+    static const std::size_t COUNTER_RNG_LANES = 8;
+    static const std::uint32_t MULTIPLIER_0 = 0xD2511F53u;
+    static const std::uint32_t MULTIPLIER_1 = 0xCD9E8D57u;
+    static const std::uint32_t WEYL_0 = 0x9E3779B9u; // Key schedule increments
+    static const std::uint32_t WEYL_1 = 0xBB67AE85u;
+
+    std::uint32_t key[2];
+
+    // Top 24 bits, as Rng::uniform
+    static float toUniform(std::uint32_t word) {
+        return static_cast<float>(word >> 8) * (1.0f / 16777216.0f);
+    }
+};
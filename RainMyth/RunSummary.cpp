@@ -0,0 +1,133 @@
+#include "RunSummary.h"
+
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+std::atomic<std::uint64_t> simulatedSteps(0);
+std::atomic<std::uint64_t> simulatedDropSteps(0);
+
+// s as a JSON string, quoted, with what JSON can't hold raw escaped
+void writeString(std::ostream& out, const std::string& s) {
+    out << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+        }
+        else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+double dropsPerSecond(const RunSummary& summary) {
+    return summary.wallSeconds > 0.0 ? summary.dropSteps / summary.wallSeconds : 0.0;
+}
+
+} // namespace
+
+void RunSummary::print(std::ostream& out) const {
+    const double megabyte = 1024.0 * 1024.0;
+    out << "Run: " << (scenario.empty() ? "built-in scenario" : scenario) << ", " << (scene.empty() ? "built-in scene" : scene)
+        << ", seed " << seed << ", " << rain << " rain, " << hits << " hits, " << kernel << " kernel, " << threads << " threads" << std::endl;
+    out << "  " << steps << " steps in " << wallSeconds << " s, " << dropSteps << " drop steps, " << dropsPerSecond(*this) / 1e6
+        << " M drops/s, peak memory " << peakMemory / megabyte << " MB" << std::endl;
+    if (frames.count() > 0) {
+        out << "  Frames: " << frames.count() << ", p50 " << frames.percentile(0.5) << " ms, p90 " << frames.percentile(0.9)
+            << " ms, p99 " << frames.percentile(0.99) << " ms, max " << frames.maxMilliseconds() << " ms" << std::endl;
+    }
+    if (!wetness.empty()) {
+        out << "  Wetness:";
+        for (float w : wetness) {
+            out << " " << w;
+        }
+        out << std::endl;
+    }
+}
+
+bool RunSummary::append(const std::string& path) const {
+    std::ofstream out(path, std::ios::app);
+    if (!out) {
+        std::cerr << "Couldn't open " << path << " for the run summary" << std::endl;
+        return false;
+    }
+    // Floats round-trip at 9 significant digits
+    out << std::setprecision(9) << "{\"scenario\":";
+    writeString(out, scenario);
+    out << ",\"scene\":";
+    writeString(out, scene);
+    out << ",\"seed\":" << seed << ",\"rain\":";
+    writeString(out, rain);
+    out << ",\"hits\":";
+    writeString(out, hits);
+    out << ",\"kernel\":";
+    writeString(out, kernel);
+    out << ",\"threads\":" << threads << ",\"steps\":" << steps << ",\"dropSteps\":" << dropSteps << ",\"wallSeconds\":" << wallSeconds
+        << ",\"dropsPerSecond\":" << dropsPerSecond(*this) << ",\"frames\":" << frames.count() << ",\"frameP50\":" << frames.percentile(0.5)
+        << ",\"frameP90\":" << frames.percentile(0.9) << ",\"frameP99\":" << frames.percentile(0.99) << ",\"frameMax\":" << frames.maxMilliseconds()
+        << ",\"peakMemory\":" << peakMemory << ",\"wetness\":[";
+    for (std::size_t i = 0; i < wetness.size(); ++i) {
+        out << (i > 0 ? "," : "") << wetness[i];
+    }
+    out << "]}\n";
+    return static_cast<bool>(out);
+}
+
+RunSummary summaryOf(const Options& options, const char* rain, const char* kernel, unsigned threads) {
+    RunSummary summary = RunSummary();
+    summary.scenario = options.scenarioPath;
+    summary.scene = options.scenePath;
+    summary.seed = options.rain.seed;
+    summary.rain = rain;
+    summary.hits = options.rain.columnBuckets ? "column-buckets" : options.rain.hits == HITS_RASTER ? "raster" : "swept";
+    summary.kernel = kernel;
+    summary.threads = threads;
+    return summary;
+}
+
+void addSimulatedWork(std::uint64_t steps, std::uint64_t dropSteps) {
+    simulatedSteps.fetch_add(steps, std::memory_order_relaxed);
+    simulatedDropSteps.fetch_add(dropSteps, std::memory_order_relaxed);
+}
+
+SimulatedWork simulatedWork() {
+    const SimulatedWork work = { simulatedSteps.load(std::memory_order_relaxed), simulatedDropSteps.load(std::memory_order_relaxed) };
+    return work;
+}
+
+std::size_t peakResidentMemory() {
+#if defined(_WIN32)
+    // K32 is kernel32's own copy, so nothing extra has to be linked
+    PROCESS_MEMORY_COUNTERS counters;
+    if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return static_cast<std::size_t>(usage.ru_maxrss); // Bytes there, kilobytes everywhere else
+#else
+    return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "FrameTimes.h"
+#include "Options.h"
+
+// What one rendered crossing from the start platform to the end platform took, or everything a
+// windowless mode simulated, with how it was run, so a wetness that gets quoted can be
+// reproduced and its cost compared from machine to machine
+struct RunSummary {
+    std::string scenario;   // --scenario file, empty for the built-in one
+    std::string scene;      // --scene file, empty for the built-in one
+    std::uint64_t seed;
+    std::string rain;       // cpu or gpu
+    std::string hits;       // swept, raster or column-buckets
+    std::string kernel;
+    unsigned threads;
+    std::uint64_t steps;
+    std::uint64_t dropSteps; // Drops alive at each step, summed
+    double wallSeconds;
+    DurationHistogram frames;
+    std::size_t peakMemory; // Bytes the process has had resident at most, 0 where that isn't known
+    std::vector<float> wetness; // The rendered person's then the crowd's, or --headless's walk, run and route.
+                                // Empty for modes with too many to list
+
+    // A few lines, for the console
+    void print(std::ostream& out) const;
+
+    // Adds the summary to path as one line of JSON, creating it if need be. False if it
+    // couldn't be written
+    bool append(const std::string& path) const;
+};
+
+// A summary of a run on options' settings, rain ("cpu" or "gpu") and kernel, with nothing
+// counted yet
+RunSummary summaryOf(const Options& options, const char* rain, const char* kernel, unsigned threads);
+
+// Steps the engines have simulated and the drops alive at each, summed, from every thread since
+// the program started. Only the difference between two reads means anything
+struct SimulatedWork {
+    std::uint64_t steps;
+    std::uint64_t dropSteps;
+};
+
+// Adds an engine's steps and drop steps to the program's, so a windowless run can summarize
+// the crowds and trials it had simulated without seeing them
+void addSimulatedWork(std::uint64_t steps, std::uint64_t dropSteps);
+
+SimulatedWork simulatedWork();
+
+// The most memory the process has had resident so far, in bytes, or 0 if the OS won't say
+std::size_t peakResidentMemory();
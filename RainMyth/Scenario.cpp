@@ -0,0 +1,106 @@
+#include "Scenario.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <system_error>
+
+#include "AssetPack.h"
+#include "Constants.h"
+
+namespace {
+
+// Ticks of path's last write time, or 0 when it can't be read
+long long writeTime(const std::string& path) {
+    std::error_code error;
+    const std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+    return error ? 0 : static_cast<long long>(time.time_since_epoch().count());
+}
+
+float* field(Scenario& scenario, const std::string& key) {
+    if (key == "spawn-rate") {
+        return &scenario.spawnRate;
+    }
+    if (key == "walk-speed") {
+        return &scenario.walkSpeed;
+    }
+    if (key == "run-speed") {
+        return &scenario.runSpeed;
+    }
+    if (key == "person-width") {
+        return &scenario.personWidth;
+    }
+    if (key == "person-height") {
+        return &scenario.personHeight;
+    }
+    if (key == "max-wetness") {
+        return &scenario.maxWetness;
+    }
+    return nullptr;
+}
+
+} // namespace
+
+Scenario defaultScenario() {
+    Scenario scenario;
+    scenario.spawnRate = RAINDROP_SPAWN_RATE;
+    scenario.walkSpeed = WALK_SPEED;
+    scenario.runSpeed = RUN_SPEED;
+    scenario.personWidth = PERSON_WIDTH;
+    scenario.personHeight = PERSON_HEIGHT;
+    scenario.maxWetness = MAX_WETNESS;
+    return scenario;
+}
+
+bool loadScenario(const std::string& path, Scenario& scenario) {
+    std::istringstream packed;
+    std::ifstream loose;
+    std::istream& file = openText(path, packed, loose);
+    if (!file) {
+        std::cerr << "Couldn't open scenario " << path << std::endl;
+        return false;
+    }
+
+    Scenario loaded = scenario;
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); ++lineNumber) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string key;
+        if (!(fields >> key)) {
+            continue; // Blank or comment
+        }
+
+        float* target = field(loaded, key);
+        float value = 0.0f;
+        if (target == nullptr || !(fields >> value) || value < 0.0f) {
+            std::cerr << path << ":" << lineNumber << ": expected a known key and a value of 0 or more" << std::endl;
+            return false;
+        }
+        *target = value;
+    }
+    scenario = loaded;
+    return true;
+}
+
+ScenarioWatcher::ScenarioWatcher(const std::string& path, float interval)
+    : path(path), interval(interval), sinceCheck(0.0f), lastWrite(path.empty() ? 0 : writeTime(path)) {}
+
+bool ScenarioWatcher::poll(float frameSeconds, Scenario& scenario) {
+    if (path.empty()) {
+        return false;
+    }
+    sinceCheck += frameSeconds;
+    if (sinceCheck < interval) {
+        return false;
+    }
+    sinceCheck = 0.0f;
+
+    const long long written = writeTime(path);
+    if (written == lastWrite) {
+        return false;
+    }
+    lastWrite = written;
+    return loadScenario(path, scenario);
+}
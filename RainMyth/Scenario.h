@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+
+// The tuning a scenario file sets, so an experiment is an edit instead of a recompile. The
+// file is "key value" lines with # comments, with any of these keys:
+//
+//   spawn-rate     drops per second per pixel of width
+//   walk-speed     pixels per second for W
+//   run-speed      pixels per second for R
+//   person-width   pixels
+//   person-height  pixels
+//   max-wetness    wetness at which the person is drawn fully soaked
+//
+// See Assets/Scenarios/Default.txt. Rendered runs keep watching the file and apply changes
+// as they're saved, without restarting or reallocating anything
+struct Scenario {
+    float spawnRate;
+    float walkSpeed;
+    float runSpeed;
+    float personWidth;
+    float personHeight;
+    float maxWetness;
+};
+
+// The values in Constants.h
+Scenario defaultScenario();
+
+// Reads the file at path over scenario, leaving the keys it doesn't mention as they were.
+// Problems are reported on stderr; returns false, with scenario untouched, if the file
+// couldn't be used
+bool loadScenario(const std::string& path, Scenario& scenario);
+
+// Polls a scenario file for changes a couple of times a second
+class ScenarioWatcher {
+public:
+    // An empty path watches nothing
+    explicit ScenarioWatcher(const std::string& path, float interval = 0.5f);
+
+    // Counts frameSeconds towards the next check. Returns true, with scenario reloaded, when
+    // the file has been saved since the last check and loads cleanly
+    bool poll(float frameSeconds, Scenario& scenario);
+
+private:
+    std::string path;
+    float interval;
+    float sinceCheck;
+    long long lastWrite; // Ticks of the file's last write time as of the last check
+};
@@ -0,0 +1,225 @@
+#include "Scene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "AssetPack.h"
+#include "Constants.h"
+#include "Person.h"
+#include "SfmlCompat.h"
+
+namespace {
+
+// Reads a coordinate along an axis of the given length: "120" is pixels, "12.5%" a fraction of
+// the length, and negative values of either count back from the far edge
+bool parseCoordinate(const std::string& text, float length, float& value) {
+    char* end = nullptr;
+    value = std::strtof(text.c_str(), &end);
+    if (end == text.c_str()) {
+        return false;
+    }
+    if (*end == '%') {
+        value *= length / 100.0f;
+        ++end;
+    }
+    if (*end != '\0') {
+        return false;
+    }
+    if (text[0] == '-') {
+        value += length;
+    }
+    return true;
+}
+
+bool parseKind(const std::string& text, ColliderKind& kind) {
+    if (text == "platform") {
+        kind = COLLIDER_PLATFORM;
+    }
+    else if (text == "awning") {
+        kind = COLLIDER_AWNING;
+    }
+    else if (text == "umbrella") {
+        kind = COLLIDER_UMBRELLA;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+// Rectangle of the given size centred on (x, y)
+const char* kindName(ColliderKind kind) {
+    switch (kind) {
+    case COLLIDER_AWNING:
+        return "awning";
+    case COLLIDER_UMBRELLA:
+        return "umbrella";
+    default:
+        return "platform";
+    }
+}
+
+// The columns [first, last) of a shadow columns wide whose centres bounds covers
+void columnsUnder(const sf::FloatRect& bounds, long columns, long& first, long& last) {
+    first = std::max(0l, static_cast<long>(std::ceil(rectLeft(bounds) - 0.5f)));
+    last = std::min(columns, static_cast<long>(std::ceil(rectLeft(bounds) + rectWidth(bounds) - 0.5f)));
+}
+
+sf::FloatRect centredOn(float x, float y, float width, float height) {
+    return sf::FloatRect(sf::Vector2f(x - width / 2.0f, y - height / 2.0f), sf::Vector2f(width, height));
+}
+
+} // namespace
+
+Scene::Scene() : revision(0), lastMoved(NO_COLLIDER) {}
+
+Scene Scene::defaultScene(sf::Vector2u screen) {
+    Scene scene;
+    scene.add(COLLIDER_PLATFORM, centredOn(screen.x * START_ACROSS, screen.y - PLATFORM_RISE, PLATFORM_WIDTH, PLATFORM_HEIGHT));
+    scene.add(COLLIDER_PLATFORM, centredOn(screen.x * END_ACROSS, screen.y - PLATFORM_RISE, PLATFORM_WIDTH, PLATFORM_HEIGHT));
+    return scene;
+}
+
+bool Scene::loadFromFile(const std::string& path, sf::Vector2u screen) {
+    std::istringstream packed;
+    std::ifstream loose;
+    std::istream& file = openText(path, packed, loose);
+    if (!file) {
+        std::cerr << "Couldn't open scene " << path << std::endl;
+        return false;
+    }
+
+    std::vector<SceneCollider> loaded;
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); ++lineNumber) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string kindText, xText, yText;
+        float width = 0.0f;
+        float height = 0.0f;
+        if (!(fields >> kindText)) {
+            continue; // Blank or comment
+        }
+
+        SceneCollider collider;
+        float x = 0.0f;
+        float y = 0.0f;
+        if (!(fields >> xText >> yText >> width >> height) || !parseKind(kindText, collider.kind)
+            || !parseCoordinate(xText, static_cast<float>(screen.x), x)
+            || !parseCoordinate(yText, static_cast<float>(screen.y), y) || width <= 0.0f || height <= 0.0f) {
+            std::cerr << path << ":" << lineNumber << ": expected kind x y width height" << std::endl;
+            return false;
+        }
+        collider.bounds = centredOn(x, y, width, height);
+        loaded.push_back(collider);
+    }
+    colliders.swap(loaded);
+    ++revision;
+    lastMoved = NO_COLLIDER;
+    return true;
+}
+
+bool Scene::saveToFile(const std::string& path) const {
+    std::ofstream file(path);
+    file << "# Colliders for --scene, one per line: kind x y width height, centres in pixels\n";
+    for (const SceneCollider& collider : colliders) {
+        const sf::FloatRect& bounds = collider.bounds;
+        file << kindName(collider.kind) << ' ' << rectLeft(bounds) + rectWidth(bounds) / 2.0f << ' '
+            << rectTop(bounds) + rectHeight(bounds) / 2.0f << ' ' << rectWidth(bounds) << ' ' << rectHeight(bounds) << '\n';
+    }
+    file.flush();
+    if (!file) {
+        std::cerr << "Couldn't write scene " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void Scene::add(ColliderKind kind, const sf::FloatRect& bounds) {
+    SceneCollider collider;
+    collider.kind = kind;
+    collider.bounds = bounds;
+    colliders.push_back(collider);
+    ++revision;
+    lastMoved = NO_COLLIDER;
+}
+
+void Scene::move(std::size_t index, const sf::FloatRect& bounds) {
+    colliders[index].bounds = bounds;
+    ++revision;
+    lastMoved = static_cast<std::uint32_t>(index);
+}
+
+std::uint32_t Scene::colliderAt(sf::Vector2f point) const {
+    for (std::size_t i = colliders.size(); i-- > 0;) {
+        if (colliders[i].bounds.contains(point)) {
+            return static_cast<std::uint32_t>(i);
+        }
+    }
+    return NO_COLLIDER;
+}
+
+std::vector<float> Scene::rainShadow(sf::Vector2u screen, std::vector<std::uint32_t>* owners) const {
+    std::vector<float> shadow(std::max(screen.x, 1u));
+    if (owners) {
+        owners->resize(shadow.size());
+    }
+    shadeColumns(0, static_cast<long>(shadow.size()), static_cast<float>(screen.y), shadow, owners);
+    return shadow;
+}
+
+void Scene::updateRainShadow(const sf::FloatRect& bounds, sf::Vector2u screen, std::vector<float>& shadow,
+    std::vector<std::uint32_t>* owners) const {
+    long first = 0;
+    long last = 0;
+    columnsUnder(bounds, static_cast<long>(shadow.size()), first, last);
+    shadeColumns(first, last, static_cast<float>(screen.y), shadow, owners);
+}
+
+// Works out columns [first, last) afresh from every collider over them
+void Scene::shadeColumns(long first, long last, float ground, std::vector<float>& shadow, std::vector<std::uint32_t>* owners) const {
+    if (first >= last) {
+        return;
+    }
+    std::fill(shadow.begin() + first, shadow.begin() + last, ground);
+    if (owners) {
+        std::fill(owners->begin() + first, owners->begin() + last, NO_COLLIDER);
+    }
+    for (std::size_t i = 0; i < colliders.size(); ++i) {
+        const sf::FloatRect& bounds = colliders[i].bounds;
+        long from = 0;
+        long to = 0;
+        columnsUnder(bounds, last, from, to);
+        for (long column = std::max(from, first); column < to; ++column) {
+            if (rectTop(bounds) < shadow[column]) {
+                shadow[column] = rectTop(bounds);
+                if (owners) {
+                    (*owners)[column] = static_cast<std::uint32_t>(i);
+                }
+            }
+        }
+    }
+}
+
+Scene loadScene(const std::string& path, sf::Vector2u screen) {
+    Scene scene = Scene::defaultScene(screen);
+    if (!path.empty() && !scene.loadFromFile(path, screen)) {
+        std::cerr << "Using the default scene" << std::endl;
+    }
+    return scene;
+}
+
+sf::Vector2f nearBand(sf::Vector2u screen, const Scene& scene, sf::Vector2f personSize, float maxDropSize) {
+    const sf::FloatRect corridor = travelCorridor(screen, personSize);
+    float left = rectLeft(corridor);
+    float right = rectLeft(corridor) + rectWidth(corridor);
+    for (const SceneCollider& collider : scene.getColliders()) {
+        left = std::min(left, rectLeft(collider.bounds));
+        right = std::max(right, rectLeft(collider.bounds) + rectWidth(collider.bounds));
+    }
+    return sf::Vector2f(std::max(left - maxDropSize, 0.0f), std::min(right + maxDropSize, static_cast<float>(screen.x)));
+}
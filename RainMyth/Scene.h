@@ -0,0 +1,88 @@
+#pragma once
+
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// What a collider represents. Rain treats them all the same; only the colour differs
+enum ColliderKind {
+    COLLIDER_PLATFORM,
+    COLLIDER_AWNING,
+    COLLIDER_UMBRELLA
+};
+
+struct SceneCollider {
+    ColliderKind kind;
+    sf::FloatRect bounds;
+};
+
+// Marks a column of the rain shadow that nothing shelters
+const std::uint32_t NO_COLLIDER = 0xffffffffu;
+
+// The static rectangles rain can land on. Scenes are loaded from a small text file, see
+// Assets/Scenes/Shelters.txt for the format, so shelters can be added without touching code
+class Scene {
+public:
+    Scene();
+
+    // The start and end platforms the walk runs between
+    static Scene defaultScene(sf::Vector2u screen);
+
+    // Replaces the colliders with the ones in the file at path, laid out for the given screen
+    // size. Problems are reported on stderr; returns false if the file couldn't be used
+    bool loadFromFile(const std::string& path, sf::Vector2u screen);
+
+    // Writes the colliders to path in the format loadFromFile reads, placed in pixels
+    bool saveToFile(const std::string& path) const;
+
+    void add(ColliderKind kind, const sf::FloatRect& bounds);
+
+    // Puts collider index at bounds. Whatever was built from the scene can redo just that
+    // collider, see getLastMoved
+    void move(std::size_t index, const sf::FloatRect& bounds);
+
+    const std::vector<SceneCollider>& getColliders() const {
+        return colliders;
+    }
+
+    // Goes up every time the colliders change, so whatever was built from them knows to rebuild
+    std::uint32_t getRevision() const {
+        return revision;
+    }
+
+    // The collider the latest revision moved, or NO_COLLIDER if it changed the scene some other way
+    std::uint32_t getLastMoved() const {
+        return lastMoved;
+    }
+
+    // The collider drawn on top at point, the last one added that contains it, or NO_COLLIDER
+    std::uint32_t colliderAt(sf::Vector2f point) const;
+
+    // Rain falls straight down, so everything in a screen column below the highest collider
+    // top is sheltered. Returns that height for each of the screen's columns, or the bottom of
+    // the screen where nothing is overhead. Columns are matched by their centres, so collider
+    // edges are accurate to the nearest pixel. If owners is given, it gets the index of the
+    // collider whose top that is for each column, or NO_COLLIDER
+    std::vector<float> rainShadow(sf::Vector2u screen, std::vector<std::uint32_t>* owners = nullptr) const;
+
+    // Brings a shadow and owners that rainShadow made up to date over the columns under bounds
+    // only. After a move, call it with the collider's old bounds and then its new ones
+    void updateRainShadow(const sf::FloatRect& bounds, sf::Vector2u screen, std::vector<float>& shadow,
+        std::vector<std::uint32_t>* owners = nullptr) const;
+
+private:
+    std::vector<SceneCollider> colliders;
+    std::uint32_t revision;
+    std::uint32_t lastMoved;
+
+    void shadeColumns(long first, long last, float ground, std::vector<float>& shadow, std::vector<std::uint32_t>* owners) const;
+};
+
+// The scene at path, or the default scene if path is empty or can't be loaded
+Scene loadScene(const std::string& path, sf::Vector2u screen);
+
+// The columns the near layer has to simulate to get the wetness and the scene right: the
+// person's whole corridor and every collider, widened by the largest drop on each side
+sf::Vector2f nearBand(sf::Vector2u screen, const Scene& scene, sf::Vector2f personSize, float maxDropSize);
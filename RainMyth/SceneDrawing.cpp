@@ -0,0 +1,70 @@
+#include "SceneDrawing.h"
+
+#include "SfmlCompat.h"
+
+namespace {
+
+sf::Color colorOf(ColliderKind kind) {
+    switch (kind) {
+    case COLLIDER_AWNING:
+        return sf::Color(150, 80, 60);
+    case COLLIDER_UMBRELLA:
+        return sf::Color(40, 40, 120);
+    default:
+        return sf::Color(100, 100, 100);
+    }
+}
+
+void writeCollider(sf::Vertex* out, const SceneCollider& collider) {
+    const sf::FloatRect& bounds = collider.bounds;
+    const sf::Color color = colorOf(collider.kind);
+    writeQuad(out, sf::Vertex{ sf::Vector2f(rectLeft(bounds), rectTop(bounds)), color },
+        sf::Vertex{ sf::Vector2f(rectLeft(bounds) + rectWidth(bounds), rectTop(bounds)), color },
+        sf::Vertex{ sf::Vector2f(rectLeft(bounds) + rectWidth(bounds), rectTop(bounds) + rectHeight(bounds)), color },
+        sf::Vertex{ sf::Vector2f(rectLeft(bounds), rectTop(bounds) + rectHeight(bounds)), color });
+}
+
+} // namespace
+
+SceneDrawing::SceneDrawing() : vertices(QUAD_PRIMITIVE), builtFrom(nullptr), builtRevision(0), useBuffer(false) {}
+
+void SceneDrawing::draw(sf::RenderTarget& target, const Scene& scene) {
+    if (builtFrom == &scene && builtRevision + 1 == scene.getRevision() && scene.getLastMoved() != NO_COLLIDER) {
+        moveCollider(scene, scene.getLastMoved());
+    }
+    else if (builtFrom != &scene || builtRevision != scene.getRevision()) {
+        buildGeometry(scene);
+    }
+    if (useBuffer) {
+        target.draw(*buffer);
+    }
+    else {
+        target.draw(vertices);
+    }
+}
+
+void SceneDrawing::buildGeometry(const Scene& scene) {
+    builtFrom = &scene;
+    builtRevision = scene.getRevision();
+    const std::vector<SceneCollider>& colliders = scene.getColliders();
+    vertices.resize(colliders.size() * QUAD_VERTICES);
+    for (std::size_t i = 0; i < colliders.size(); ++i) {
+        writeCollider(&vertices[i * QUAD_VERTICES], colliders[i]);
+    }
+
+    if (!buffer && sf::VertexBuffer::isAvailable()) {
+        buffer.reset(new sf::VertexBuffer(QUAD_PRIMITIVE, sf::VertexBuffer::Usage::Static));
+    }
+    const std::size_t count = vertices.getVertexCount();
+    useBuffer = buffer && count > 0 && buffer->create(count) && buffer->update(&vertices[0]);
+}
+
+void SceneDrawing::moveCollider(const Scene& scene, std::size_t index) {
+    builtRevision = scene.getRevision();
+    const std::size_t first = index * QUAD_VERTICES;
+    writeCollider(&vertices[first], scene.getColliders()[index]);
+    if (useBuffer) {
+        // A failed upload leaves the buffer stale, so the array is drawn from then on
+        useBuffer = buffer->update(&vertices[first], QUAD_VERTICES, static_cast<unsigned>(first));
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <memory>
+
+#include "Scene.h"
+
+// Draws a scene's colliders in one call. Their quads go into a static vertex buffer on the
+// first draw and again only after the scene's revision changes, so drawing an unchanged scene
+// uploads nothing, and a revision that moved one collider uploads only its quad. Kept out of
+// Scene so the simulation needs no graphics
+class SceneDrawing {
+public:
+    SceneDrawing();
+
+    void draw(sf::RenderTarget& target, const Scene& scene);
+
+private:
+    sf::VertexArray vertices;               // Quads for the colliders, kept when there are no vertex buffers
+    std::unique_ptr<sf::VertexBuffer> buffer; // Created on the first draw, so headless runs never need GL
+    const Scene* builtFrom;                 // The scene and revision the quads were built for
+    std::uint32_t builtRevision;
+    bool useBuffer;
+
+    void buildGeometry(const Scene& scene);
+    void moveCollider(const Scene& scene, std::size_t index);
+};
@@ -0,0 +1,54 @@
+#include "SceneEditor.h"
+
+#include <algorithm>
+
+#include "SfmlCompat.h"
+
+SceneEditor::SceneEditor(sf::Vector2u world)
+    : world(world), on(false), held(NO_COLLIDER), grip(0.0f, 0.0f), pointer(0.0f, 0.0f), moved(false) {}
+
+void SceneEditor::toggle() {
+    on = !on;
+    release();
+}
+
+void SceneEditor::press(const Scene& scene, sf::Vector2f point) {
+    if (!on) {
+        return;
+    }
+    held = scene.colliderAt(point);
+    if (held != NO_COLLIDER) {
+        const sf::FloatRect& bounds = scene.getColliders()[held].bounds;
+        grip = sf::Vector2f(rectLeft(bounds), rectTop(bounds)) - point;
+        pointer = point;
+    }
+}
+
+void SceneEditor::drag(sf::Vector2f point) {
+    if (held != NO_COLLIDER) {
+        pointer = point;
+        moved = true;
+    }
+}
+
+void SceneEditor::release() {
+    held = NO_COLLIDER;
+    moved = false;
+}
+
+bool SceneEditor::apply(Scene& scene, std::size_t& index, sf::FloatRect& previous) {
+    if (held == NO_COLLIDER || !moved) {
+        return false;
+    }
+    moved = false;
+    previous = scene.getColliders()[held].bounds;
+    sf::FloatRect bounds = previous;
+    rectLeft(bounds) = std::min(std::max(pointer.x + grip.x, 0.0f), std::max(world.x - rectWidth(bounds), 0.0f));
+    rectTop(bounds) = std::min(std::max(pointer.y + grip.y, 0.0f), std::max(world.y - rectHeight(bounds), 0.0f));
+    if (rectLeft(bounds) == rectLeft(previous) && rectTop(bounds) == rectTop(previous)) {
+        return false;
+    }
+    index = held;
+    scene.move(index, bounds);
+    return true;
+}
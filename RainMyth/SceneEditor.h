@@ -0,0 +1,41 @@
+#pragma once
+
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <cstddef>
+#include <cstdint>
+
+#include "Scene.h"
+
+// Drags the scene's colliders about with the mouse while it's on. A press picks the collider on
+// top under the pointer, and the pointer's moves are gathered until apply() puts it where the
+// last one left it, so however many moves a frame polls, the scene changes once, by one
+// collider, and everything built from it can redo just that one. Colliders stay inside the world
+class SceneEditor {
+public:
+    explicit SceneEditor(sf::Vector2u world);
+
+    bool isOn() const {
+        return on;
+    }
+
+    // Turning it off lets go of whatever is held
+    void toggle();
+
+    // The pointer, in world coordinates
+    void press(const Scene& scene, sf::Vector2f point);
+    void drag(sf::Vector2f point);
+    void release();
+
+    // Moves the held collider to follow the pointer, if it has moved since the last call.
+    // Returns whether it did, with the collider's index and where it was before
+    bool apply(Scene& scene, std::size_t& index, sf::FloatRect& previous);
+
+private:
+    sf::Vector2f world;
+    bool on;
+    std::uint32_t held;  // The collider being dragged, or NO_COLLIDER
+    sf::Vector2f grip;   // From the pointer to the held collider's top left corner
+    sf::Vector2f pointer;
+    bool moved;          // Whether the pointer has moved since apply() last ran
+};
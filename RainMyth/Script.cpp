@@ -0,0 +1,201 @@
+#include "Script.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "Constants.h"
+#include "RainIntensity.h"
+#include "RainSystem.h"
+#include "RunSummary.h"
+#include "Scene.h"
+
+namespace {
+
+const char* actionName(ScriptActionType type) {
+    switch (type) {
+    case SCRIPT_RESET:
+        return "reset";
+    case SCRIPT_MOVE:
+        return "move";
+    case SCRIPT_SPAWN_RATE:
+        return "spawn rate";
+    case SCRIPT_WIND:
+        return "wind";
+    case SCRIPT_PERSON_WIDTH:
+        return "person width";
+    case SCRIPT_PERSON_HEIGHT:
+        return "person height";
+    }
+    return "?";
+}
+
+} // namespace
+
+bool Script::parse(const std::string& text, const std::string& where, const Options& options) {
+    program.clear();
+    restart();
+    std::istringstream lines(text);
+    std::string line;
+    for (int lineNumber = 1; std::getline(lines, line); ++lineNumber) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream statements(line);
+        std::string statement;
+        while (std::getline(statements, statement, ';')) {
+            std::istringstream fields(statement);
+            std::string word;
+            if (!(fields >> word)) {
+                continue; // Blank
+            }
+            const std::string at = where + ":" + std::to_string(lineNumber);
+            Instruction instruction = { OP_ACT, { SCRIPT_RESET, 0.0f }, 0.0f };
+            float value = 0.0f;
+            if (word == "wait") {
+                instruction.op = OP_WAIT;
+                if (!(fields >> instruction.value) || instruction.value < 0.0f) {
+                    std::cerr << at << ": expected seconds of 0 or more after wait" << std::endl;
+                    return false;
+                }
+            }
+            else if (word == "until") {
+                std::string what;
+                fields >> what;
+                if (what == "arrived") {
+                    instruction.op = OP_UNTIL_ARRIVED;
+                }
+                else if (what == "wetness" && (fields >> instruction.value)) {
+                    instruction.op = OP_UNTIL_WETNESS;
+                }
+                else {
+                    std::cerr << at << ": expected until arrived or until wetness AREA" << std::endl;
+                    return false;
+                }
+            }
+            else if (word == "walk" || word == "run") {
+                // A reset first, as W and R do
+                program.push_back(instruction);
+                instruction.action.type = SCRIPT_MOVE;
+                instruction.action.value = word == "walk" ? options.scenario.walkSpeed : options.scenario.runSpeed;
+                if (fields >> value) {
+                    instruction.action.value = value;
+                }
+            }
+            else if (word == "reset") {
+                instruction.action.type = SCRIPT_RESET;
+            }
+            else if (word == "rain") {
+                std::string preset;
+                RainConfig rain = options.rain;
+                if (!(fields >> preset) || !parseRainIntensity(preset.c_str(), rain.rainIntensity)) {
+                    std::cerr << at << ": expected rain drizzle, moderate, heavy, downpour or mm per hour" << std::endl;
+                    return false;
+                }
+                instruction.action.type = SCRIPT_SPAWN_RATE;
+                instruction.action.value = spawnRateFor(rain);
+            }
+            else {
+                if (word == "spawn-rate") {
+                    instruction.action.type = SCRIPT_SPAWN_RATE;
+                }
+                else if (word == "wind") {
+                    instruction.action.type = SCRIPT_WIND;
+                }
+                else if (word == "person-width") {
+                    instruction.action.type = SCRIPT_PERSON_WIDTH;
+                }
+                else if (word == "person-height") {
+                    instruction.action.type = SCRIPT_PERSON_HEIGHT;
+                }
+                else {
+                    std::cerr << at << ": unknown instruction " << word << std::endl;
+                    return false;
+                }
+                if (!(fields >> instruction.action.value)) {
+                    std::cerr << at << ": expected a value after " << word << std::endl;
+                    return false;
+                }
+            }
+            program.push_back(instruction);
+        }
+    }
+    return true;
+}
+
+bool Script::load(const std::string& path, const Options& options) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Couldn't open " << path << std::endl;
+        return false;
+    }
+    std::ostringstream text;
+    text << file.rdbuf();
+    return parse(text.str(), path, options);
+}
+
+int runScript(const Options& options, IntegrateKernel integrate, JobSystem& jobs) {
+    Script script;
+    if (!script.load(options.scriptPath, options)) {
+        return EXIT_FAILURE;
+    }
+
+    // Set up as a rendered run is, minus the window
+    const sf::Vector2u screen(options.width, options.height);
+    const float timestep = 1.0f / options.simHz;
+    const Scene scene = loadScene(options.scenePath, screen);
+    RainSystem rainSystem(screen, options.rain, scene, integrate, jobs);
+    Person person(startPoint(screen), sf::Vector2f(options.scenario.personWidth, options.scenario.personHeight));
+    if (options.prewarm) {
+        const sf::FloatRect bounds = person.getBounds();
+        rainSystem.prewarm(&bounds, 1);
+    }
+
+    const std::uint64_t limit = static_cast<std::uint64_t>(SCRIPT_TIME_LIMIT / timestep);
+    std::uint64_t step = 0;
+    for (; step < limit; ++step) {
+        script.resume(step, timestep, person, [&](const ScriptAction& action) {
+            std::cout << step * timestep << " s: " << actionName(action.type);
+            if (action.type != SCRIPT_RESET) {
+                std::cout << " " << action.value;
+            }
+            std::cout << ", wetness " << person.getWetness() << std::endl;
+            switch (action.type) {
+            case SCRIPT_RESET:
+                person.reset(startPoint(screen));
+                break;
+            case SCRIPT_MOVE:
+                person.startMove(endPoint(screen), action.value);
+                break;
+            case SCRIPT_SPAWN_RATE:
+                rainSystem.setSpawnRate(action.value);
+                break;
+            case SCRIPT_WIND:
+                rainSystem.setWindSpeed(action.value);
+                break;
+            case SCRIPT_PERSON_WIDTH:
+                person.setSize(sf::Vector2f(action.value, person.getSize().y));
+                break;
+            case SCRIPT_PERSON_HEIGHT:
+                person.setSize(sf::Vector2f(person.getSize().x, action.value));
+                break;
+            }
+        });
+        if (script.isFinished()) {
+            break;
+        }
+        person.update(timestep);
+        SurfaceWetness split = SurfaceWetness();
+        person.addWetness(rainSystem.update(timestep, person.getBounds(), &split));
+        person.addSurfaceWetness(split);
+    }
+    addSimulatedWork(rainSystem.getLifetimes().stepCount, rainSystem.getLifetimes().liveSteps);
+
+    if (!script.isFinished()) {
+        std::cout << "Gave up after " << SCRIPT_TIME_LIMIT << " s of simulated time, still waiting" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const SurfaceWetness& split = person.getSurfaceWetness();
+    std::cout << "Script finished after " << step << " steps, " << step * timestep << " s" << std::endl;
+    std::cout << "Wetness: " << person.getWetness() << " (top " << split.top << ", front " << split.front << ", back " << split.back << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "JobSystem.h"
+#include "Options.h"
+#include "Person.h"
+#include "RainKernels.h"
+
+// What a script does to the simulation
+enum ScriptActionType {
+    SCRIPT_RESET,         // Put the person back at the start, dry
+    SCRIPT_MOVE,          // Send the person to the end at value pixels per second
+    SCRIPT_SPAWN_RATE,    // Spawn value drops per pixel of width per second
+    SCRIPT_WIND,          // Blow a steady wind of value pixels per second
+    SCRIPT_PERSON_WIDTH,
+    SCRIPT_PERSON_HEIGHT
+};
+
+struct ScriptAction {
+    ScriptActionType type;
+    float value;
+};
+
+// A scenario played out on the fixed step instead of at the keyboard. A script is a list of
+// instructions, one per line or separated by ';', with # comments:
+//
+//   wait SECONDS          let the simulation run on
+//   until arrived         wait for the person to stop
+//   until wetness AREA    wait for the person's wetness to reach AREA
+//   walk [SPEED]          reset and walk to the end, at the scenario's walk speed by default
+//   run [SPEED]           reset and run, at its run speed by default
+//   reset                 put the person back at the start
+//   rain PRESET|MM        rain as hard as --rain would
+//   spawn-rate RATE
+//   wind SPEED            skipped when column buckets or coarse steps need calm air
+//   person-width PIXELS
+//   person-height PIXELS
+//
+// The loop that steps the simulation resumes the script at the start of every step, and it
+// carries on from where it was waiting through every action it can until it has to wait
+// again. Waits count whole steps, so a script plays out the same, step for step, headless as
+// fast as the machine goes and rendered in real time
+class Script {
+public:
+    // Reads a script from text, with speeds and rain presets resolved against options. where
+    // names it in messages. Reports problems on stderr and returns false
+    bool parse(const std::string& text, const std::string& where, const Options& options);
+
+    // Reads the script in path. Reports problems on stderr and returns false
+    bool load(const std::string& path, const Options& options);
+
+    // Carries on at the start of step, taking timestep seconds each, calling act(action) for
+    // each action before the next wait the person or the clock doesn't let it past yet
+    template <typename Act>
+    void resume(std::uint64_t step, float timestep, const Person& person, Act&& act) {
+        while (next < program.size()) {
+            const Instruction& instruction = program[next];
+            switch (instruction.op) {
+            case OP_ACT:
+                act(instruction.action);
+                break;
+            case OP_WAIT:
+                if (!waiting) {
+                    waiting = true;
+                    waitUntil = step + static_cast<std::uint64_t>(instruction.value / timestep + 0.5f);
+                }
+                if (step < waitUntil) {
+                    return;
+                }
+                waiting = false;
+                break;
+            case OP_UNTIL_ARRIVED:
+                if (person.isMovingToTarget()) {
+                    return;
+                }
+                break;
+            case OP_UNTIL_WETNESS:
+                if (person.getWetness() < instruction.value) {
+                    return;
+                }
+                break;
+            }
+            ++next;
+        }
+    }
+
+    bool isFinished() const {
+        return next == program.size();
+    }
+
+    // Back to the first instruction
+    void restart() {
+        next = 0;
+        waiting = false;
+    }
+
+private:
+    enum Op {
+        OP_ACT,
+        OP_WAIT,
+        OP_UNTIL_ARRIVED,
+        OP_UNTIL_WETNESS
+    };
+
+    struct Instruction {
+        Op op;
+        ScriptAction action; // For OP_ACT
+        float value;         // Seconds or wetness to wait for
+    };
+
+    std::vector<Instruction> program;
+    std::size_t next = 0;
+    bool waiting = false;
+    std::uint64_t waitUntil = 0;
+};
+
+// Plays options.scriptPath out with no window, as fast as the machine allows, from an empty
+// sky as a rendered run starts, printing each action as it happens and the wetness at the
+// end. Gives up after SCRIPT_TIME_LIMIT seconds of simulated time. Returns the process exit code
+int runScript(const Options& options, IntegrateKernel integrate, JobSystem& jobs);
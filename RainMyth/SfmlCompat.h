@@ -0,0 +1,270 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// RainMyth builds against SFML 2.6, from Dependencies/SFML, or against SFML 3, from
+// External/SFML-3.0.0, chosen by the project configuration. The calls whose spelling differs
+// between the two go through here, so the rest of the tree reads the same under both. The
+// rest is written the way both accept it: scoped enumerators like sf::PrimitiveType::Lines and
+// sf::Keyboard::Key::W, rectangles made from a position and a size, setters taking vectors,
+// and the <cstdint> types in place of sf::Uint8 and friends.
+//
+// SFML 3 has no quads, so there RainMyth draws each quad as two triangles. The vertex
+// builders write quads through writeQuad and size their output by QUAD_VERTICES, and draw
+// them as QUAD_PRIMITIVE, which covers both
+
+#if SFML_VERSION_MAJOR >= 3
+
+const sf::PrimitiveType QUAD_PRIMITIVE = sf::PrimitiveType::Triangles;
+const std::size_t QUAD_VERTICES = 6;
+
+// The corners clockwise from the top left
+inline void writeQuad(sf::Vertex* out, const sf::Vertex& topLeft, const sf::Vertex& topRight, const sf::Vertex& bottomRight, const sf::Vertex& bottomLeft) {
+    out[0] = topLeft;
+    out[1] = topRight;
+    out[2] = bottomRight;
+    out[3] = topLeft;
+    out[4] = bottomRight;
+    out[5] = bottomLeft;
+}
+
+// A rectangle's edges and extent, to read or assign
+template <typename Rect>
+auto& rectLeft(Rect&& rect) {
+    return rect.position.x;
+}
+
+template <typename Rect>
+auto& rectTop(Rect&& rect) {
+    return rect.position.y;
+}
+
+template <typename Rect>
+auto& rectWidth(Rect&& rect) {
+    return rect.size.x;
+}
+
+template <typename Rect>
+auto& rectHeight(Rect&& rect) {
+    return rect.size.y;
+}
+
+inline bool rectsIntersect(const sf::FloatRect& a, const sf::FloatRect& b) {
+    return a.findIntersection(b).has_value();
+}
+
+inline sf::VideoMode videoMode(unsigned width, unsigned height) {
+    return sf::VideoMode(sf::Vector2u(width, height));
+}
+
+inline void createWindow(sf::RenderWindow& window, const sf::VideoMode& mode, const char* title, bool fullScreen) {
+    if (fullScreen) {
+        window.create(mode, title, sf::State::Fullscreen);
+    }
+    else {
+        window.create(mode, title, sf::Style::Default, sf::State::Windowed);
+    }
+}
+
+inline bool createRenderTexture(sf::RenderTexture& texture, sf::Vector2u size) {
+    return texture.resize(size);
+}
+
+inline void createImage(sf::Image& image, sf::Vector2u size, sf::Color fill) {
+    image.resize(size, fill);
+}
+
+inline void createImage(sf::Image& image, sf::Vector2u size, const std::uint8_t* pixels) {
+    image.resize(size, pixels);
+}
+
+inline void setImagePixel(sf::Image& image, unsigned x, unsigned y, sf::Color color) {
+    image.setPixel(sf::Vector2u(x, y), color);
+}
+
+// Copies all of source into image with its top left corner at (x, y)
+inline void copyImage(sf::Image& image, const sf::Image& source, unsigned x, unsigned y) {
+    (void)image.copy(source, sf::Vector2u(x, y));
+}
+
+// Encodes image as format, "png" and the like, into output. False if it couldn't be
+inline bool saveImageToMemory(const sf::Image& image, const char* format, std::vector<std::uint8_t>& output) {
+    std::optional<std::vector<std::uint8_t>> encoded = image.saveToMemory(format);
+    if (!encoded) {
+        return false;
+    }
+    output = std::move(*encoded);
+    return true;
+}
+
+inline bool openFont(sf::Font& font, const void* data, std::size_t bytes) {
+    return font.openFromMemory(data, bytes);
+}
+
+// SFML 3 text can't exist without its font
+inline sf::Text makeText(const sf::Font& font, unsigned characterSize) {
+    return sf::Text(font, "", characterSize);
+}
+
+#else
+
+const sf::PrimitiveType QUAD_PRIMITIVE = sf::PrimitiveType::Quads;
+const std::size_t QUAD_VERTICES = 4;
+
+// The corners clockwise from the top left
+inline void writeQuad(sf::Vertex* out, const sf::Vertex& topLeft, const sf::Vertex& topRight, const sf::Vertex& bottomRight, const sf::Vertex& bottomLeft) {
+    out[0] = topLeft;
+    out[1] = topRight;
+    out[2] = bottomRight;
+    out[3] = bottomLeft;
+}
+
+// A rectangle's edges and extent, to read or assign
+template <typename Rect>
+auto& rectLeft(Rect&& rect) {
+    return rect.left;
+}
+
+template <typename Rect>
+auto& rectTop(Rect&& rect) {
+    return rect.top;
+}
+
+template <typename Rect>
+auto& rectWidth(Rect&& rect) {
+    return rect.width;
+}
+
+template <typename Rect>
+auto& rectHeight(Rect&& rect) {
+    return rect.height;
+}
+
+inline bool rectsIntersect(const sf::FloatRect& a, const sf::FloatRect& b) {
+    return a.intersects(b);
+}
+
+inline sf::VideoMode videoMode(unsigned width, unsigned height) {
+    return sf::VideoMode(width, height);
+}
+
+inline void createWindow(sf::RenderWindow& window, const sf::VideoMode& mode, const char* title, bool fullScreen) {
+    window.create(mode, title, fullScreen ? sf::Style::Fullscreen : sf::Style::Default);
+}
+
+inline bool createRenderTexture(sf::RenderTexture& texture, sf::Vector2u size) {
+    return texture.create(size.x, size.y);
+}
+
+inline void createImage(sf::Image& image, sf::Vector2u size, sf::Color fill) {
+    image.create(size.x, size.y, fill);
+}
+
+inline void createImage(sf::Image& image, sf::Vector2u size, const std::uint8_t* pixels) {
+    image.create(size.x, size.y, pixels);
+}
+
+inline void setImagePixel(sf::Image& image, unsigned x, unsigned y, sf::Color color) {
+    image.setPixel(x, y, color);
+}
+
+inline void copyImage(sf::Image& image, const sf::Image& source, unsigned x, unsigned y) {
+    image.copy(source, x, y);
+}
+
+inline bool saveImageToMemory(const sf::Image& image, const char* format, std::vector<std::uint8_t>& output) {
+    return image.saveToMemory(output, format);
+}
+
+inline bool openFont(sf::Font& font, const void* data, std::size_t bytes) {
+    return font.loadFromMemory(data, bytes);
+}
+
+inline sf::Text makeText(const sf::Font& font, unsigned characterSize) {
+    return sf::Text("", font, characterSize);
+}
+
+#endif
+
+// The window events RainMyth acts on, read the same way under either SFML
+enum WindowEventType {
+    WINDOW_EVENT_OTHER,
+    WINDOW_CLOSED,
+    WINDOW_RESIZED,
+    WINDOW_KEY_PRESSED,
+    WINDOW_MOUSE_PRESSED,  // The left button only
+    WINDOW_MOUSE_MOVED,
+    WINDOW_MOUSE_RELEASED
+};
+
+struct WindowEvent {
+    WindowEventType type;
+    sf::Keyboard::Key key; // Which key, for WINDOW_KEY_PRESSED
+    sf::Vector2i mouse;    // Where the pointer is in the window, for the mouse events
+};
+
+// Takes the window's next pending event into event; false once there are none
+inline bool pollWindowEvent(sf::Window& window, WindowEvent& event) {
+    event.type = WINDOW_EVENT_OTHER;
+    event.key = sf::Keyboard::Key::Unknown;
+    event.mouse = sf::Vector2i(0, 0);
+#if SFML_VERSION_MAJOR >= 3
+    const std::optional<sf::Event> polled = window.pollEvent();
+    if (!polled) {
+        return false;
+    }
+    if (polled->is<sf::Event::Closed>()) {
+        event.type = WINDOW_CLOSED;
+    }
+    else if (polled->is<sf::Event::Resized>()) {
+        event.type = WINDOW_RESIZED;
+    }
+    else if (const sf::Event::KeyPressed* pressed = polled->getIf<sf::Event::KeyPressed>()) {
+        event.type = WINDOW_KEY_PRESSED;
+        event.key = pressed->code;
+    }
+    else if (const sf::Event::MouseButtonPressed* clicked = polled->getIf<sf::Event::MouseButtonPressed>()) {
+        event.type = clicked->button == sf::Mouse::Button::Left ? WINDOW_MOUSE_PRESSED : WINDOW_EVENT_OTHER;
+        event.mouse = clicked->position;
+    }
+    else if (const sf::Event::MouseMoved* moved = polled->getIf<sf::Event::MouseMoved>()) {
+        event.type = WINDOW_MOUSE_MOVED;
+        event.mouse = moved->position;
+    }
+    else if (const sf::Event::MouseButtonReleased* released = polled->getIf<sf::Event::MouseButtonReleased>()) {
+        event.type = released->button == sf::Mouse::Button::Left ? WINDOW_MOUSE_RELEASED : WINDOW_EVENT_OTHER;
+        event.mouse = released->position;
+    }
+#else
+    sf::Event polled;
+    if (!window.pollEvent(polled)) {
+        return false;
+    }
+    if (polled.type == sf::Event::Closed) {
+        event.type = WINDOW_CLOSED;
+    }
+    else if (polled.type == sf::Event::Resized) {
+        event.type = WINDOW_RESIZED;
+    }
+    else if (polled.type == sf::Event::KeyPressed) {
+        event.type = WINDOW_KEY_PRESSED;
+        event.key = polled.key.code;
+    }
+    else if (polled.type == sf::Event::MouseButtonPressed || polled.type == sf::Event::MouseButtonReleased) {
+        if (polled.mouseButton.button == sf::Mouse::Button::Left) {
+            event.type = polled.type == sf::Event::MouseButtonPressed ? WINDOW_MOUSE_PRESSED : WINDOW_MOUSE_RELEASED;
+        }
+        event.mouse = sf::Vector2i(polled.mouseButton.x, polled.mouseButton.y);
+    }
+    else if (polled.type == sf::Event::MouseMoved) {
+        event.type = WINDOW_MOUSE_MOVED;
+        event.mouse = sf::Vector2i(polled.mouseMove.x, polled.mouseMove.y);
+    }
+#endif
+    return true;
+}
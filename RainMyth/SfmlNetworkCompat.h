@@ -0,0 +1,40 @@
+#pragma once
+
+#include <SFML/Network.hpp>
+#include <cstdint>
+#include <string>
+
+// The network side of SfmlCompat.h: the few calls the sweep and the metrics emitter make
+// whose spelling differs between SFML 2.6 and SFML 3
+
+// Packets carry 64-bit fields as sf::Uint64 under SFML 2, which isn't std::uint64_t everywhere
+#if SFML_VERSION_MAJOR >= 3
+typedef std::uint64_t PacketUint64;
+#else
+typedef sf::Uint64 PacketUint64;
+#endif
+
+// Looks host up, by name or dotted address, into address; false if it can't be resolved
+inline bool resolveAddress(const std::string& host, sf::IpAddress& address) {
+#if SFML_VERSION_MAJOR >= 3
+    const std::optional<sf::IpAddress> resolved = sf::IpAddress::resolve(host);
+    if (!resolved) {
+        return false;
+    }
+    address = *resolved;
+    return true;
+#else
+    address = sf::IpAddress(host);
+    return address != sf::IpAddress::None;
+#endif
+}
+
+// Who's on the other end of a connected socket, for messages
+inline std::string remoteName(const sf::TcpSocket& socket) {
+#if SFML_VERSION_MAJOR >= 3
+    const std::optional<sf::IpAddress> address = socket.getRemoteAddress();
+    return address ? address->toString() : std::string("(unknown)");
+#else
+    return socket.getRemoteAddress().toString();
+#endif
+}
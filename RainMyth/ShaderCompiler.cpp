@@ -0,0 +1,29 @@
+#include "ShaderCompiler.h"
+
+std::unique_ptr<sf::Shader> compileShader(const char* vertex, const char* geometry, const char* fragment) {
+    std::unique_ptr<sf::Shader> shader(new sf::Shader());
+    bool compiled = false;
+    if (vertex && geometry && fragment) {
+        compiled = shader->loadFromMemory(vertex, geometry, fragment);
+    }
+    else if (vertex && fragment) {
+        compiled = shader->loadFromMemory(vertex, fragment);
+    }
+    else if (fragment) {
+        compiled = shader->loadFromMemory(fragment, sf::Shader::Type::Fragment);
+    }
+    else if (vertex) {
+        compiled = shader->loadFromMemory(vertex, sf::Shader::Type::Vertex);
+    }
+    if (!compiled) {
+        shader.reset();
+    }
+    return shader;
+}
+
+void compileShaderInBackground(Deferred<sf::Shader>& compiled, const char* vertex, const char* geometry, const char* fragment) {
+    compiled.start([vertex, geometry, fragment]() {
+        sf::Context context;
+        return compileShader(vertex, geometry, fragment);
+    });
+}
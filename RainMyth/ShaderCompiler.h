@@ -0,0 +1,15 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <memory>
+
+#include "Startup.h"
+
+// Compiles a shader from whichever of its stages aren't null. Null where the driver won't
+// compile it
+std::unique_ptr<sf::Shader> compileShader(const char* vertex, const char* geometry, const char* fragment);
+
+// The same on a thread of its own, in a GL context of its own, so nothing waits on the
+// driver's compiler. Contexts share what they make, so the shader taken from compiled works
+// in any of them, the window's included. The sources must outlive the compile
+void compileShaderInBackground(Deferred<sf::Shader>& compiled, const char* vertex, const char* geometry, const char* fragment);
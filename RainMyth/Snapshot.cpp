@@ -0,0 +1,164 @@
+#include "Snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "SfmlCompat.h"
+
+namespace {
+
+const char SNAPSHOT_MAGIC[4] = { 'R', 'M', 'S', 'N' };
+const std::uint32_t SNAPSHOT_VERSION = 4;
+const std::uint64_t SNAPSHOT_ALIGNMENT = 64;
+
+std::uint64_t alignUp(std::uint64_t offset) {
+    return (offset + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+}
+
+// Writes bytes at offset, padding with zeros from wherever the file is up to
+void writeAt(std::ofstream& out, std::uint64_t offset, const void* bytes, std::size_t count) {
+    static const char zeros[SNAPSHOT_ALIGNMENT] = {};
+    for (std::uint64_t at = static_cast<std::uint64_t>(out.tellp()); at < offset;) {
+        const std::size_t pad = static_cast<std::size_t>(std::min<std::uint64_t>(offset - at, SNAPSHOT_ALIGNMENT));
+        out.write(zeros, pad);
+        at += pad;
+    }
+    out.write(static_cast<const char*>(bytes), count);
+}
+
+bool sameConfig(const RainConfig& a, const RainConfig& b) {
+    return a.seed == b.seed && a.maxDrops == b.maxDrops && a.spawnRate == b.spawnRate && a.minSize == b.minSize
+        && a.maxSize == b.maxSize && a.sizeModel == b.sizeModel && a.rainIntensity == b.rainIntensity && a.wind.speed == b.wind.speed && a.wind.gust == b.wind.gust
+        && a.wind.gustPeriod == b.wind.gustPeriod && a.wind.turbulence == b.wind.turbulence && a.columnBuckets == b.columnBuckets
+        && a.body == b.body && a.shelterDrips == b.shelterDrips && a.coalesceDistance == b.coalesceDistance
+        && a.hits == b.hits;
+}
+
+} // namespace
+
+bool writeSnapshot(const std::string& path, sf::Vector2u world, const RainConfig& config, const RainSystem& rain,
+    const std::vector<Person>& people, const Scene& scene) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        std::cerr << "Couldn't open " << path << " for writing" << std::endl;
+        return false;
+    }
+    const RainField& drops = rain.getDrops();
+    const std::uint64_t count = drops.count();
+    const std::vector<SceneCollider>& sceneColliders = scene.getColliders();
+    std::vector<PersonState> personStates;
+    for (const Person& person : people) {
+        personStates.push_back(person.getState());
+    }
+    std::vector<SnapshotCollider> colliders;
+    for (const SceneCollider& collider : sceneColliders) {
+        const SnapshotCollider stored = { static_cast<std::uint32_t>(collider.kind), rectLeft(collider.bounds), rectTop(collider.bounds),
+            rectWidth(collider.bounds), rectHeight(collider.bounds) };
+        colliders.push_back(stored);
+    }
+
+    SnapshotHeader header = SnapshotHeader(); // Zeroes the padding too, so files are reproducible
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.headerSize = sizeof(SnapshotHeader);
+    header.worldWidth = world.x;
+    header.worldHeight = world.y;
+    header.personCount = static_cast<std::uint32_t>(personStates.size());
+    header.colliderCount = static_cast<std::uint32_t>(colliders.size());
+    header.rain = config;
+    header.dropCount = count;
+    header.x = alignUp(sizeof(SnapshotHeader));
+    header.y = alignUp(header.x + count * sizeof(float));
+    header.vy = alignUp(header.y + count * sizeof(float));
+    header.size = alignUp(header.vy + count * sizeof(float));
+    header.absorbed = alignUp(header.size + count * sizeof(float));
+    header.people = alignUp(header.absorbed + count * sizeof(std::uint32_t));
+    header.colliders = alignUp(header.people + personStates.size() * sizeof(PersonState));
+    header.fileSize = header.colliders + colliders.size() * sizeof(SnapshotCollider);
+    header.state = rain.getState();
+
+    writeAt(out, 0, &header, sizeof(header));
+    writeAt(out, header.x, drops.x.data(), count * sizeof(float));
+    writeAt(out, header.y, drops.y.data(), count * sizeof(float));
+    writeAt(out, header.vy, drops.vy.data(), count * sizeof(float));
+    writeAt(out, header.size, drops.size.data(), count * sizeof(float));
+    writeAt(out, header.absorbed, drops.absorbed.data(), count * sizeof(std::uint32_t));
+    writeAt(out, header.people, personStates.data(), personStates.size() * sizeof(PersonState));
+    writeAt(out, header.colliders, colliders.data(), colliders.size() * sizeof(SnapshotCollider));
+    if (!out) {
+        std::cerr << "Couldn't write snapshot " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+SnapshotView::SnapshotView() : data(nullptr), bytes(0) {}
+
+bool SnapshotView::open(const std::string& path) {
+    close();
+    if (!file.open(path)) {
+        std::cerr << "Couldn't open snapshot " << path << std::endl;
+        return false;
+    }
+    data = file.data();
+    bytes = file.size();
+
+    // Everything the accessors can reach has to be inside the file, each array after the last
+    const SnapshotHeader& stored = header();
+    std::uint64_t end = sizeof(SnapshotHeader);
+    auto fits = [&](std::uint64_t offset, std::uint64_t length) {
+        const bool inside = offset >= end && offset % SNAPSHOT_ALIGNMENT == 0 && offset + length <= stored.fileSize;
+        end = offset + length;
+        return inside;
+    };
+    const std::uint64_t count = stored.dropCount;
+    const bool valid = bytes >= sizeof(SnapshotHeader) && std::memcmp(stored.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0
+        && stored.version == SNAPSHOT_VERSION && stored.headerSize == sizeof(SnapshotHeader) && stored.fileSize <= bytes
+        && stored.personCount <= MAX_PEOPLE && count <= stored.rain.maxDrops
+        && fits(stored.x, count * sizeof(float)) && fits(stored.y, count * sizeof(float)) && fits(stored.vy, count * sizeof(float))
+        && fits(stored.size, count * sizeof(float)) && fits(stored.absorbed, count * sizeof(std::uint32_t))
+        && fits(stored.people, stored.personCount * sizeof(PersonState))
+        && fits(stored.colliders, stored.colliderCount * sizeof(SnapshotCollider));
+    if (!valid) {
+        std::cerr << path << " isn't a snapshot this build can read" << std::endl;
+        close();
+        return false;
+    }
+    return true;
+}
+
+void SnapshotView::close() {
+    file.close();
+    data = nullptr;
+    bytes = 0;
+}
+
+bool SnapshotView::matches(sf::Vector2u world, const RainConfig& config, const Scene& scene) const {
+    const SnapshotHeader& stored = header();
+    const std::vector<SceneCollider>& sceneColliders = scene.getColliders();
+    if (stored.worldWidth != world.x || stored.worldHeight != world.y || !sameConfig(stored.rain, config)
+        || stored.colliderCount != sceneColliders.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < sceneColliders.size(); ++i) {
+        const SnapshotCollider& collider = colliders()[i];
+        const sf::FloatRect& bounds = sceneColliders[i].bounds;
+        if (collider.left != rectLeft(bounds) || collider.top != rectTop(bounds) || collider.width != rectWidth(bounds) || collider.height != rectHeight(bounds)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SnapshotView::restore(RainSystem& rain, std::vector<Person>& people) const {
+    const SnapshotHeader& stored = header();
+    rain.setState(stored.state, x(), y(), vy(), size(), absorbed(), static_cast<std::size_t>(stored.dropCount));
+    people.clear();
+    for (std::size_t i = 0; i < stored.personCount; ++i) {
+        Person person(sf::Vector2f(0.0f, 0.0f));
+        person.setState(this->people()[i]);
+        people.push_back(person);
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "Person.h"
+#include "RainConfig.h"
+#include "RainSystem.h"
+#include "Scene.h"
+
+// A collider as a snapshot stores it
+struct SnapshotCollider {
+    std::uint32_t kind;
+    float left;
+    float top;
+    float width;
+    float height;
+};
+
+// A snapshot file is this header followed by the arrays it points to, each at an offset from
+// the start of the file that is a multiple of 64. Everything is in the machine's own byte
+// order and the structs' own layout, so a mapped file can be read in place: opening one checks
+// the header and parses nothing. headerSize catches a header from a build with another layout
+struct SnapshotHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t headerSize;
+    std::uint32_t worldWidth;
+    std::uint32_t worldHeight;
+    std::uint32_t personCount;
+    std::uint32_t colliderCount;
+    std::uint32_t reserved;
+    std::uint64_t fileSize;
+    RainConfig rain;             // What the RainSystem was built with
+    std::uint64_t dropCount;
+    std::uint64_t x;             // Offsets of dropCount floats each
+    std::uint64_t y;
+    std::uint64_t vy;
+    std::uint64_t size;
+    std::uint64_t absorbed;      // dropCount uint32s
+    std::uint64_t people;        // personCount PersonStates
+    std::uint64_t colliders;     // colliderCount SnapshotColliders
+    RainState state;
+};
+
+// Writes the rain, the people in it and the scene, with the world size and configuration they
+// were made for. Problems are reported on stderr; returns false if the file couldn't be written
+bool writeSnapshot(const std::string& path, sf::Vector2u world, const RainConfig& config, const RainSystem& rain,
+    const std::vector<Person>& people, const Scene& scene);
+
+// A snapshot file mapped read-only. Everything it returns points into the mapping, and stays
+// valid until the view is closed or destroyed
+class SnapshotView {
+public:
+    SnapshotView();
+    SnapshotView(const SnapshotView&) = delete;
+    SnapshotView& operator=(const SnapshotView&) = delete;
+
+    // Maps the file at path and checks its header. Problems are reported on stderr; returns
+    // false if it isn't a snapshot this build can read
+    bool open(const std::string& path);
+    void close();
+
+    const SnapshotHeader& header() const {
+        return *reinterpret_cast<const SnapshotHeader*>(data);
+    }
+
+    const float* x() const {
+        return at<float>(header().x);
+    }
+
+    const float* y() const {
+        return at<float>(header().y);
+    }
+
+    const float* vy() const {
+        return at<float>(header().vy);
+    }
+
+    const float* size() const {
+        return at<float>(header().size);
+    }
+
+    const std::uint32_t* absorbed() const {
+        return at<std::uint32_t>(header().absorbed);
+    }
+
+    const PersonState* people() const {
+        return at<PersonState>(header().people);
+    }
+
+    const SnapshotCollider* colliders() const {
+        return at<SnapshotCollider>(header().colliders);
+    }
+
+    // Whether the snapshot was made in a world of this size, with this configuration and these
+    // colliders, so that restoring it stands in for simulating up to where it was taken
+    bool matches(sf::Vector2u world, const RainConfig& config, const Scene& scene) const;
+
+    // Puts rain and people back as they were when the snapshot was written. rain must have been
+    // built for a world, configuration and scene the snapshot matches; people is resized to it
+    void restore(RainSystem& rain, std::vector<Person>& people) const;
+
+private:
+    MappedFile file;
+    const unsigned char* data; // The file's bytes
+    std::size_t bytes;
+
+    template <typename T>
+    const T* at(std::uint64_t offset) const {
+        return reinterpret_cast<const T*>(data + offset);
+    }
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Constants.h"
+#include "MemoryUsage.h"
+#include "Rng.h"
+#include "SfmlCompat.h"
+
+// Where a drop landed on the scene or the ground
+struct RainImpact {
+    float x;
+    float y;
+    float size;
+};
+
+// Short-lived droplets thrown up where rain lands. They live in a fixed ring of their own, apart
+// from the drop store: emitting writes at the head, overwriting the oldest once the ring is
+// full, and since every droplet lives for the same SPLASH_LIFETIME the live ones are always one
+// contiguous run of the ring that expires from its tail. Nothing is allocated after
+// construction. Each frame may emit at most its budget of droplets, so heavy rain thins the
+// splashes out instead of stretching the frame
+class SplashSystem {
+public:
+    SplashSystem(std::size_t budget, std::uint64_t seed)
+        : x(SPLASH_CAPACITY), y(SPLASH_CAPACITY), vx(SPLASH_CAPACITY), vy(SPLASH_CAPACITY), age(SPLASH_CAPACITY),
+          rng(seed ^ 0x53504C41ull), tail(0), live(0), budget(budget), budgetLeft(budget) {}
+
+    // Droplets the frames from now on may emit
+    void setBudget(std::size_t perFrame) {
+        budget = perFrame;
+        budgetLeft = std::min(budgetLeft, budget);
+    }
+
+    std::size_t getBudget() const {
+        return budget;
+    }
+
+    // Refills the frame's budget
+    void beginFrame() {
+        budgetLeft = budget;
+    }
+
+    // Throws SPLASH_DROPLETS droplets up and out of every impact, while the budget lasts
+    void emit(const std::vector<RainImpact>& impacts) {
+        for (const RainImpact& impact : impacts) {
+            for (std::size_t k = 0; k < SPLASH_DROPLETS && budgetLeft > 0; ++k, --budgetLeft) {
+                const std::size_t i = (tail + live) % SPLASH_CAPACITY;
+                if (live == SPLASH_CAPACITY) {
+                    tail = (tail + 1) % SPLASH_CAPACITY; // Full: the oldest droplet makes room
+                }
+                else {
+                    ++live;
+                }
+                // Bigger drops splash harder
+                const float strength = impact.size / RAINDROP_MAX_SIZE;
+                x[i] = impact.x + impact.size * 0.5f;
+                y[i] = impact.y;
+                vx[i] = rng.uniform(-80.0f, 80.0f) * strength;
+                vy[i] = -rng.uniform(60.0f, 180.0f) * strength;
+                age[i] = 0.0f;
+            }
+        }
+    }
+
+    // Moves every droplet on ballistically and expires the ones past their lifetime
+    void update(float deltaTime) {
+        for (std::size_t n = 0; n < live; ++n) {
+            const std::size_t i = (tail + n) % SPLASH_CAPACITY;
+            vy[i] += GRAVITY * deltaTime;
+            x[i] += vx[i] * deltaTime;
+            y[i] += vy[i] * deltaTime;
+            age[i] += deltaTime;
+        }
+        while (live > 0 && age[tail] >= SPLASH_LIFETIME) {
+            tail = (tail + 1) % SPLASH_CAPACITY;
+            --live;
+        }
+    }
+
+    std::size_t count() const {
+        return live;
+    }
+
+    // Rewrites vertices as the droplet quads, fading each one out over its life. Their texCoords
+    // cover sprite, the droplet's place in whatever texture they're drawn with. Droplets are
+    // drawn lag seconds back along their flight, which an update moves them along at their new
+    // velocity, so any lag up to a step lands between the last two updates
+    void build(sf::Color color, sf::VertexArray& vertices, const sf::FloatRect& sprite = sf::FloatRect(), float lag = 0.0f) const {
+        vertices.setPrimitiveType(QUAD_PRIMITIVE);
+        vertices.resize(live * QUAD_VERTICES);
+        for (std::size_t n = 0; n < live; ++n) {
+            const std::size_t i = (tail + n) % SPLASH_CAPACITY;
+            sf::Color faded = color;
+            faded.a = static_cast<std::uint8_t>(color.a * (1.0f - age[i] / SPLASH_LIFETIME));
+            const float left = x[i] - vx[i] * lag;
+            const float top = y[i] - vy[i] * lag;
+
+            writeQuad(&vertices[n * QUAD_VERTICES],
+                sf::Vertex{ sf::Vector2f(left, top), faded, sf::Vector2f(rectLeft(sprite), rectTop(sprite)) },
+                sf::Vertex{ sf::Vector2f(left + 1.5f, top), faded, sf::Vector2f(rectLeft(sprite) + rectWidth(sprite), rectTop(sprite)) },
+                sf::Vertex{ sf::Vector2f(left + 1.5f, top + 1.5f), faded, sf::Vector2f(rectLeft(sprite) + rectWidth(sprite), rectTop(sprite) + rectHeight(sprite)) },
+                sf::Vertex{ sf::Vector2f(left, top + 1.5f), faded, sf::Vector2f(rectLeft(sprite), rectTop(sprite) + rectHeight(sprite)) });
+        }
+    }
+
+
+    MemoryUsage memoryUsage() const {
+        MemoryUsage usage = vectorUsage(x, live);
+        usage += vectorUsage(y, live);
+        usage += vectorUsage(vx, live);
+        usage += vectorUsage(vy, live);
+        usage += vectorUsage(age, live);
+        return usage;
+    }
+
+private:
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> vx;
+    std::vector<float> vy;
+    std::vector<float> age;
+    Rng rng;
+    std::size_t tail;       // Oldest live droplet
+    std::size_t live;
+    std::size_t budget;     // Droplets per frame
+    std::size_t budgetLeft;
+};
@@ -0,0 +1,114 @@
+#include "SpriteAtlas.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "AssetPack.h"
+#include "SfmlCompat.h"
+
+namespace {
+
+const unsigned ATLAS_WIDTH = 128;  // Texels across the atlas; rows are added down it as needed
+const unsigned ATLAS_PADDING = 2;  // Transparent texels around each sprite, so filtering never picks up a neighbour's
+
+const char* const SPRITE_NAMES[SPRITE_COUNT] = { "white", "drop", "splash", "person" };
+const unsigned SPRITE_SIZES[SPRITE_COUNT][2] = { { 4, 4 }, { 8, 16 }, { 4, 4 }, { 32, 64 } };
+
+float smoothstep(float edge0, float edge1, float x) {
+    const float t = std::min(std::max((x - edge0) / (edge1 - edge0), 0.0f), 1.0f);
+    return t * t * (3.0f - 2.0f * t);
+}
+
+// How much of texel (x, y) of a width by height sprite the shape covers, with a texel of
+// soft edge all round
+float coverage(SpriteId sprite, unsigned x, unsigned y, unsigned width, unsigned height) {
+    const float px = x + 0.5f;
+    const float py = y + 0.5f;
+    const float radius = width / 2.0f;
+    switch (sprite) {
+    case SPRITE_DROP: {
+        // A circle at the bottom, its sides running straight up to a point at the top
+        const float centreY = height - radius;
+        const float halfWidth = py >= centreY ? std::sqrt(std::max(radius * radius - (py - centreY) * (py - centreY), 0.0f)) : radius * py / centreY;
+        return 1.0f - smoothstep(halfWidth - 1.0f, halfWidth, std::abs(px - radius));
+    }
+    case SPRITE_SPLASH:
+        return 1.0f - smoothstep(radius - 1.0f, radius, std::hypot(px - radius, py - height / 2.0f));
+    case SPRITE_PERSON: {
+        // A body with rounded shoulders and feet
+        const float corner = width / 5.0f;
+        const float dx = std::max(std::abs(px - radius) - (radius - corner), 0.0f);
+        const float dy = std::max(std::abs(py - height / 2.0f) - (height / 2.0f - corner), 0.0f);
+        return 1.0f - smoothstep(corner - 1.0f, corner, std::hypot(dx, dy));
+    }
+    default:
+        return 1.0f;
+    }
+}
+
+sf::Image drawSprite(SpriteId sprite) {
+    const unsigned width = SPRITE_SIZES[sprite][0];
+    const unsigned height = SPRITE_SIZES[sprite][1];
+    sf::Image image;
+    createImage(image, sf::Vector2u(width, height), sf::Color::Transparent);
+    for (unsigned y = 0; y < height; ++y) {
+        for (unsigned x = 0; x < width; ++x) {
+            const float alpha = coverage(sprite, x, y, width, height);
+            setImagePixel(image, x, y, sf::Color(255, 255, 255, static_cast<std::uint8_t>(alpha * 255.0f + 0.5f)));
+        }
+    }
+    return image;
+}
+
+} // namespace
+
+SpriteAtlas::SpriteAtlas() {}
+
+bool SpriteAtlas::build() {
+    sf::Image images[SPRITE_COUNT];
+    for (int i = 0; i < SPRITE_COUNT; ++i) {
+        AssetData packed;
+        const std::string name = std::string("Sprites/") + SPRITE_NAMES[i] + ".png";
+        if (i == SPRITE_WHITE || !assets().find(name, packed) || !images[i].loadFromMemory(packed.data, packed.size)) {
+            images[i] = drawSprite(static_cast<SpriteId>(i));
+        }
+    }
+
+    // Tallest first, left to right along rows
+    int order[SPRITE_COUNT];
+    for (int i = 0; i < SPRITE_COUNT; ++i) {
+        order[i] = i;
+    }
+    std::sort(order, order + SPRITE_COUNT, [&](int a, int b) {
+        return images[a].getSize().y > images[b].getSize().y;
+    });
+    unsigned x = 0;
+    unsigned y = 0;
+    unsigned rowHeight = 0;
+    for (int n = 0; n < SPRITE_COUNT; ++n) {
+        const sf::Vector2u size = images[order[n]].getSize();
+        if (x + size.x + 2 * ATLAS_PADDING > ATLAS_WIDTH && x > 0) {
+            x = 0;
+            y += rowHeight;
+            rowHeight = 0;
+        }
+        rects[order[n]] = sf::IntRect(sf::Vector2i(x + ATLAS_PADDING, y + ATLAS_PADDING), sf::Vector2i(size));
+        x += size.x + 2 * ATLAS_PADDING;
+        rowHeight = std::max(rowHeight, size.y + 2 * ATLAS_PADDING);
+    }
+
+    sf::Image atlas;
+    createImage(atlas, sf::Vector2u(ATLAS_WIDTH, y + rowHeight), sf::Color::Transparent);
+    for (int i = 0; i < SPRITE_COUNT; ++i) {
+        copyImage(atlas, images[i], rectLeft(rects[i]), rectTop(rects[i]));
+    }
+    if (!texture.loadFromImage(atlas)) {
+        return false;
+    }
+    texture.setSmooth(true);
+
+    // The white block is sampled at its middle only, so filtering never reaches its edges
+    const sf::IntRect& white = rects[SPRITE_WHITE];
+    rects[SPRITE_WHITE] = sf::IntRect(sf::Vector2i(rectLeft(white) + rectWidth(white) / 2, rectTop(white) + rectHeight(white) / 2), sf::Vector2i(0, 0));
+    return true;
+}
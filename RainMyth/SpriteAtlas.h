@@ -0,0 +1,43 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+// The small images the rendered scene is drawn with
+enum SpriteId {
+    SPRITE_WHITE,  // A solid texel block, for anything drawn untextured in the same batch
+    SPRITE_DROP,   // A raindrop, round at the bottom and narrowing to the top
+    SPRITE_SPLASH, // A splash droplet
+    SPRITE_PERSON, // The person's silhouette
+    SPRITE_COUNT
+};
+
+// Every sprite in one texture, so what draws with any of them can share a batch and none of
+// them costs a texture switch. Each sprite comes from the asset pack as Sprites/<name>.png
+// when it has one and is drawn procedurally otherwise, white with its shape in the alpha so
+// vertex colours tint it, then packed in rows with room between them for filtering
+class SpriteAtlas {
+public:
+    SpriteAtlas();
+
+    // Packs the sprites and uploads the texture, which needs a GL context. Returns false if the
+    // texture couldn't be made, and the scene should be drawn untextured
+    bool build();
+
+    const sf::Texture& getTexture() const {
+        return texture;
+    }
+
+    // Where sprite is in the texture, in texels
+    const sf::IntRect& getRect(SpriteId sprite) const {
+        return rects[sprite];
+    }
+
+    // The same as floats, for texCoords
+    sf::FloatRect getTexCoords(SpriteId sprite) const {
+        return sf::FloatRect(rects[sprite]);
+    }
+
+private:
+    sf::Texture texture;
+    sf::IntRect rects[SPRITE_COUNT];
+};
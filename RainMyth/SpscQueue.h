@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Fixed-size ring for handing values from exactly one producer thread to exactly one consumer
+// thread without locks. Each side owns one index and only reads the other's, so push() and
+// pop() never wait on each other: a full queue makes push() fail and an empty one makes
+// peek() return nullptr. Capacity must be a power of two; one slot is kept free to tell a full
+// ring from an empty one
+template <typename T, std::size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer only. Returns false, dropping value, when the consumer has fallen a whole ring behind
+    bool push(const T& value) {
+        const std::size_t at = tail.load(std::memory_order_relaxed);
+        const std::size_t next = (at + 1) & (Capacity - 1);
+        if (next == head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        slots[at] = value;
+        tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. The oldest value, left in the queue, or nullptr when there's none
+    const T* peek() const {
+        const std::size_t at = head.load(std::memory_order_relaxed);
+        if (at == tail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &slots[at];
+    }
+
+    // Consumer only. Drops the value peek() returned
+    void pop() {
+        const std::size_t at = head.load(std::memory_order_relaxed);
+        head.store((at + 1) & (Capacity - 1), std::memory_order_release);
+    }
+
+private:
+    T slots[Capacity];
+    // Each index on its own cache line, so the two threads don't false-share
+    alignas(64) std::atomic<std::size_t> head; // Written by the consumer
+    alignas(64) std::atomic<std::size_t> tail; // Written by the producer
+};
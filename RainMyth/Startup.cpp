@@ -0,0 +1,30 @@
+#include "Startup.h"
+
+#include <iomanip>
+#include <iostream>
+
+StartupTimeline::StartupTimeline(bool enabled)
+    : started(std::chrono::steady_clock::now()), last(started), enabled(enabled) {
+}
+
+void StartupTimeline::mark(const char* stage) {
+    const auto now = std::chrono::steady_clock::now();
+    if (enabled) {
+        const std::chrono::duration<double, std::milli> took = now - last;
+        std::cout << "Startup: " << stage << " took " << std::fixed << std::setprecision(1) << took.count()
+            << " ms, done " << elapsed() << " ms in" << std::defaultfloat << std::endl;
+    }
+    last = now;
+}
+
+void StartupTimeline::ready(const char* what) const {
+    if (enabled) {
+        std::cout << "Startup: " << what << " ready " << std::fixed << std::setprecision(1) << elapsed()
+            << " ms in" << std::defaultfloat << std::endl;
+    }
+}
+
+double StartupTimeline::elapsed() const {
+    const std::chrono::duration<double, std::milli> since = std::chrono::steady_clock::now() - started;
+    return since.count();
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <utility>
+
+// Where the time before the first frame goes. Each mark() reports how long the stage just
+// finished took and how far into startup it ended, on standard output as it happens. A
+// timeline made disabled only keeps the clock
+class StartupTimeline {
+public:
+    explicit StartupTimeline(bool enabled);
+
+    void mark(const char* stage);
+
+    // For what was started in the background, often done after the first frame: only when it
+    // was handed over, without counting it as a stage
+    void ready(const char* what) const;
+
+    // Milliseconds since the timeline was made
+    double elapsed() const;
+
+private:
+    std::chrono::steady_clock::time_point started;
+    std::chrono::steady_clock::time_point last;
+    bool enabled;
+};
+
+// An optional subsystem made on a thread of its own while startup carries on, for the ones
+// that wait on a device or the network. take() hands it over, once, when it's ready, and
+// nullptr until then; a subsystem that didn't come up hands over nullptr too, and pending()
+// turns false either way
+template <typename T>
+class Deferred {
+public:
+    template <typename Make>
+    void start(Make make) {
+        made = std::async(std::launch::async, std::move(make));
+    }
+
+    bool pending() const {
+        return made.valid();
+    }
+
+    std::unique_ptr<T> take() {
+        if (!made.valid() || made.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return nullptr;
+        }
+        return made.get();
+    }
+
+private:
+    std::future<std::unique_ptr<T>> made;
+};
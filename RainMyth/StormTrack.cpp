@@ -0,0 +1,93 @@
+#include "StormTrack.h"
+
+#include <cstdlib>
+#include <limits>
+#include <cstring>
+#include <iostream>
+
+#include "Constants.h"
+
+StormTrack::StormTrack() : cursor(0), prefetched(0), lineNumber(0), before(), after(), ended(true) {}
+
+bool StormTrack::open(const std::string& path) {
+    this->path = path;
+    cursor = 0;
+    prefetched = 0;
+    lineNumber = 0;
+    ended = true;
+    if (!file.open(path)) {
+        std::cerr << "Couldn't open storm " << path << std::endl;
+        return false;
+    }
+    if (!readSample(-std::numeric_limits<double>::infinity(), before)) {
+        std::cerr << "Storm " << path << " has no samples" << std::endl;
+        file.close();
+        return false;
+    }
+    ended = !readSample(before.time, after);
+    return true;
+}
+
+StormSample StormTrack::at(double time) {
+    while (!ended && after.time <= time) {
+        before = after;
+        ended = !readSample(before.time, after);
+    }
+    if (ended || time <= before.time) {
+        return before;
+    }
+    const float t = static_cast<float>((time - before.time) / (after.time - before.time));
+    const StormSample sample = { time, before.mmPerHour + (after.mmPerHour - before.mmPerHour) * t, before.wind + (after.wind - before.wind) * t };
+    return sample;
+}
+
+bool StormTrack::readSample(double since, StormSample& sample) {
+    const char* const text = reinterpret_cast<const char*>(file.data());
+    while (cursor < file.size()) {
+        if (cursor + STORM_PREFETCH_BYTES / 2 > prefetched) {
+            file.prefetch(prefetched, STORM_PREFETCH_BYTES);
+            prefetched += STORM_PREFETCH_BYTES;
+        }
+
+        // The mapping has no terminator, so each line is copied out to be parsed
+        const char* newline = static_cast<const char*>(std::memchr(text + cursor, '\n', file.size() - cursor));
+        const std::size_t end = newline ? static_cast<std::size_t>(newline - text) : file.size();
+        ++lineNumber;
+        char line[STORM_LINE_BYTES];
+        const std::size_t start = cursor;
+        const std::size_t length = end - start;
+        cursor = end + 1;
+        if (length >= sizeof(line)) {
+            std::cerr << path << ":" << lineNumber << ": line too long, the storm ends here" << std::endl;
+            return false;
+        }
+        std::memcpy(line, text + start, length);
+        line[length] = '\0';
+        if (char* comment = std::strchr(line, '#')) {
+            *comment = '\0';
+        }
+
+        char* next = line;
+        char* parsed = nullptr;
+        sample.time = std::strtod(next, &parsed);
+        if (parsed == next) {
+            if (line[std::strspn(line, " \t\r")] == '\0') {
+                continue; // Blank or comment
+            }
+            std::cerr << path << ":" << lineNumber << ": expected seconds mm-per-hour [wind], the storm ends here" << std::endl;
+            return false;
+        }
+        next = parsed;
+        sample.mmPerHour = std::strtof(next, &parsed);
+        const bool hasRain = parsed != next;
+        next = parsed;
+        const float metresPerSecond = std::strtof(next, &parsed);
+        sample.wind = parsed != next ? metresPerSecond * 100.0f : 0.0f; // A pixel is a centimetre
+        if (!hasRain || sample.mmPerHour < 0.0f || sample.time <= since) {
+            std::cerr << path << ":" << lineNumber << ": expected seconds mm-per-hour [wind] after the last sample's time, the storm ends here" << std::endl;
+            return false;
+        }
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "MappedFile.h"
+
+// The weather a moment into a recorded storm
+struct StormSample {
+    double time;     // Seconds into the storm
+    float mmPerHour; // Rain intensity, as --rain takes it
+    float wind;      // Pixels per second, positive blowing right
+};
+
+// A recorded storm for --storm: rain intensity and wind over time, one sample per line of a
+// text file, "seconds mm-per-hour [wind]" with the wind in metres per second and # starting
+// a comment. Times go up from line to line, at whatever spacing the radar gave. The file is
+// mapped rather than read in, and lines are only decoded as playback reaches them, two samples
+// at a time, so an hour-long storm takes no more memory than a minute's. The next
+// STORM_PREFETCH_BYTES past the last line decoded are always being read in ahead, so playing
+// on never waits on the disk
+class StormTrack {
+public:
+    StormTrack();
+
+    // Problems are reported on stderr; returns false if the file has no usable first sample
+    bool open(const std::string& path);
+
+    // The storm time seconds in, interpolated between the samples either side, and held at
+    // the last sample once the file runs out. Times asked for mustn't go backwards
+    StormSample at(double time);
+
+    // Whether at() has passed the last sample
+    bool isFinished() const {
+        return ended;
+    }
+
+private:
+    MappedFile file;
+    std::string path;
+    std::size_t cursor;     // Offset of the first line not yet decoded
+    std::size_t prefetched; // Offset up to which the file has been asked to be read in
+    std::size_t lineNumber;
+    StormSample before;     // The samples either side of the last time asked for
+    StormSample after;
+    bool ended;             // No sample after before
+
+    // Decodes the next sample into sample, skipping blank lines and comments. False at the end
+    // of the file or at a line that isn't a sample later than since, which is reported
+    bool readSample(double since, StormSample& sample);
+};
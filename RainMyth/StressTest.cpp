@@ -0,0 +1,71 @@
+#include "StressTest.h"
+
+#include <iomanip>
+
+#include "Constants.h"
+
+StressRamp::StressRamp(float startRate, std::size_t capacity)
+    : rate(startRate), capacity(capacity), elapsed(0.0f), dropFrames(0.0), finished(false), poolFull(false) {}
+
+float StressRamp::addFrame(float frameSeconds, float workSeconds, std::size_t drops) {
+    if (finished) {
+        return -1.0f;
+    }
+    elapsed += frameSeconds;
+    if (elapsed < STRESS_SETTLE_SECONDS) {
+        return -1.0f;
+    }
+    work.add(workSeconds);
+    dropFrames += drops;
+    if (elapsed < STRESS_SETTLE_SECONDS + STRESS_LEVEL_SECONDS) {
+        return -1.0f;
+    }
+
+    Level level;
+    level.spawnRate = rate;
+    level.meanDrops = dropFrames / work.count();
+    level.p50 = work.percentile(0.5);
+    level.p99 = work.percentile(0.99);
+    level.sustained = level.p99 <= 1000.0f / STRESS_TARGET_FPS;
+    levels.push_back(level);
+    poolFull = level.meanDrops >= capacity * 0.99;
+    finished = !level.sustained || poolFull || levels.size() == STRESS_MAX_LEVELS;
+    elapsed = 0.0f;
+    dropFrames = 0.0;
+    work = DurationHistogram();
+    if (finished) {
+        return -1.0f;
+    }
+    rate *= STRESS_RAMP;
+    return rate;
+}
+
+void StressRamp::print(std::ostream& out, const char* kernel, const char* renderer) const {
+    out << "Stress test, " << kernel << " kernel, " << renderer << " rendering, work ms per frame against "
+        << 1000.0f / STRESS_TARGET_FPS << ":" << std::endl;
+    out << std::setw(12) << "spawn rate" << std::setw(12) << "drops" << std::setw(10) << "p50" << std::setw(10) << "p99" << std::endl;
+    const Level* best = nullptr;
+    for (const Level& level : levels) {
+        out << std::setw(12) << level.spawnRate << std::setw(12) << static_cast<std::size_t>(level.meanDrops)
+            << std::setw(10) << level.p50 << std::setw(10) << level.p99 << (level.sustained ? "" : "  over budget") << std::endl;
+        if (level.sustained) {
+            best = &level;
+        }
+    }
+    if (best == nullptr) {
+        out << "Not even the first level held " << STRESS_TARGET_FPS << " fps" << std::endl;
+        return;
+    }
+    out << "Most drops sustained at " << STRESS_TARGET_FPS << " fps: " << static_cast<std::size_t>(best->meanDrops)
+        << " (spawn rate " << best->spawnRate << ")";
+    if (poolFull) {
+        out << ", where the drop pool filled; raise --max-drops to push further";
+    }
+    else if (finished && levels.back().sustained) {
+        out << ", after the last of " << STRESS_MAX_LEVELS << " levels";
+    }
+    else if (!finished) {
+        out << ", stopped before the ramp found the limit";
+    }
+    out << std::endl;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+#include "FrameTimes.h"
+
+// --stress: how much rain this machine can render at 60 fps. The spawn rate starts where it
+// was asked for and goes up by STRESS_RAMP a level at a time. Each level is given
+// STRESS_SETTLE_SECONDS for the population to fill the sky at the new rate and then timed
+// for STRESS_LEVEL_SECONDS; it's sustained if the 99th percentile frame's work, the frame
+// less the wait in display, fits in a 60 fps frame. Work rather than the whole frame since
+// the pacer holds every frame that fits to the same length, so the headroom only shows in
+// the work. The ramp stops at the first level that isn't sustained, or once the drop pool
+// is full, since past that a higher rate only rejects more spawns
+class StressRamp {
+public:
+    StressRamp(float startRate, std::size_t capacity);
+
+    // Feeds in a frame's work and the drops it showed. Returns the spawn rate to change to
+    // when a level has just finished and the next begins, and a negative number otherwise
+    float addFrame(float frameSeconds, float workSeconds, std::size_t drops);
+
+    bool isFinished() const {
+        return finished;
+    }
+
+    // Every level timed and the most drops sustained, for the backend named
+    void print(std::ostream& out, const char* kernel, const char* renderer) const;
+
+private:
+    struct Level {
+        float spawnRate;
+        double meanDrops;
+        float p50;  // Milliseconds of work
+        float p99;
+        bool sustained;
+    };
+
+    float rate;
+    std::size_t capacity;
+    float elapsed;        // Seconds into the level
+    double dropFrames;    // Drops summed over the level's timed frames
+    DurationHistogram work;
+    std::vector<Level> levels;
+    bool finished;
+    bool poolFull;
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+
+// Faces of a person's box a drop can first touch
+enum BodySurface {
+    SURFACE_TOP,   // Head and shoulders: the drop came down onto them
+    SURFACE_FRONT, // The face towards the way they're going: they walked into the drop
+    SURFACE_BACK   // The face behind them: the drop caught up with them, as a tailwind can make it
+};
+
+// Wetness split by the surface that caught it, each drop counted once on the face it touched first
+struct SurfaceWetness {
+    float top;
+    float front;
+    float back;
+
+    void add(BodySurface surface, float area) {
+        if (surface == SURFACE_TOP) {
+            top += area;
+        }
+        else if (surface == SURFACE_FRONT) {
+            front += area;
+        }
+        else {
+            back += area;
+        }
+    }
+
+    SurfaceWetness& operator+=(const SurfaceWetness& other) {
+        top += other.top;
+        front += other.front;
+        back += other.back;
+        return *this;
+    }
+
+    float total() const {
+        return top + front + back;
+    }
+};
+
+// Which face of a box moving boxDx in a step a drop moving (dropDx, dropDy) in the same step
+// entered through, from where both were when the step began: whichever face the drop's path
+// relative to the box crosses last, since that's when the two start to overlap. The drop spans
+// columns dropLeft to dropRight with its bottom edge at dropBottom; the box spans left to right
+// with its top at top.
+// facing is the sign of the way the person is heading, so a side face is the front or back.
+// Drops that were already overlapping count as coming from above
+inline BodySurface classifyHit(float dropLeft, float dropRight, float dropBottom, float dropDx, float dropDy,
+    float left, float top, float right, float boxDx, float facing) {
+    const float relativeDx = dropDx - boxDx;
+    const float fromAbove = dropBottom <= top && dropDy > 0.0f ? (top - dropBottom) / dropDy : -1.0f;
+    float fromSide = -1.0f;
+    float side = 0.0f; // -1 for the box's left face, 1 for its right
+    if (dropRight <= left && relativeDx > 0.0f) {
+        fromSide = (left - dropRight) / relativeDx;
+        side = -1.0f;
+    }
+    else if (dropLeft >= right && relativeDx < 0.0f) {
+        fromSide = (dropLeft - right) / -relativeDx;
+        side = 1.0f;
+    }
+    if (side == 0.0f || fromSide <= fromAbove) {
+        return SURFACE_TOP;
+    }
+    return side * facing >= 0.0f ? SURFACE_FRONT : SURFACE_BACK;
+}
+
+// Whether a drop and a box that both move in straight lines during a step overlap at some
+// moment of it, with the strict rule of sf::FloatRect::intersects. Both are placed where they
+// were when the step began: the drop spans (dropLeft, dropTop) to (dropRight, dropBottom) and
+// moves (dropDx, dropDy), the box spans (left, top) to (right, bottom) and moves boxDx. The
+// drop only counts until reach, the fraction of the step before it landed. Each edge pair
+// overlaps for an interval of the step, so this is the intersection of four intervals
+inline bool sweptContact(float dropLeft, float dropTop, float dropRight, float dropBottom, float dropDx, float dropDy,
+    float left, float top, float right, float bottom, float boxDx, float reach) {
+    float begin = 0.0f;
+    float end = reach;
+    // Narrows (begin, end) to where from + rate * t < to
+    auto below = [&](float from, float rate, float to) {
+        if (rate == 0.0f) {
+            if (from >= to) {
+                end = begin;
+            }
+        }
+        else if (rate > 0.0f) {
+            end = std::min(end, (to - from) / rate);
+        }
+        else {
+            begin = std::max(begin, (to - from) / rate);
+        }
+    };
+    const float relativeDx = dropDx - boxDx;
+    below(dropLeft, relativeDx, right);
+    below(left, -relativeDx, dropRight);
+    below(dropTop, dropDy, bottom);
+    below(top, -dropDy, dropBottom);
+    return begin < end;
+}
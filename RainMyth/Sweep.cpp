@@ -0,0 +1,240 @@
+#include "Sweep.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "ColumnWriter.h"
+#include "Constants.h"
+#include "Headless.h"
+#include "ResultCache.h"
+#include "SweepCheckpoint.h"
+
+namespace {
+
+// Smallest drop width a size sweep will spawn
+const float SWEEP_MIN_DROP_SIZE = 0.05f;
+
+// Decodes point index into one value from each range, speed varying fastest
+Crossing crossingAt(const Options& options, std::size_t index) {
+    const SweepSpec& sweep = options.sweep;
+    const unsigned speed = static_cast<unsigned>(index % sweep.speed.steps);
+    index /= sweep.speed.steps;
+    const unsigned rate = static_cast<unsigned>(index % sweep.spawnRate.steps);
+    index /= sweep.spawnRate.steps;
+    const unsigned drop = static_cast<unsigned>(index % sweep.dropSize.steps);
+    index /= sweep.dropSize.steps;
+    const unsigned width = static_cast<unsigned>(index % sweep.personWidth.steps);
+    index /= sweep.personWidth.steps;
+    const unsigned height = static_cast<unsigned>(index);
+
+    // Every point rains from the same seed, so neighbouring points differ by their parameters
+    // rather than by luck of the draw
+    Crossing crossing;
+    crossing.rain = options.rain;
+    crossing.rain.spawnRate = sweep.spawnRate.at(rate);
+    const float halfSpread = (RAINDROP_MAX_SIZE - RAINDROP_MIN_SIZE) / 2.0f;
+    const float meanSize = sweep.dropSize.at(drop);
+    crossing.rain.minSize = std::max(meanSize - halfSpread, SWEEP_MIN_DROP_SIZE);
+    crossing.rain.maxSize = std::max(meanSize + halfSpread, SWEEP_MIN_DROP_SIZE);
+    crossing.personWidth = sweep.personWidth.at(width);
+    crossing.personHeight = sweep.personHeight.at(height);
+    crossing.speed = sweep.speed.at(speed);
+    return crossing;
+}
+
+// writeSweepResults' columnar side: the same columns as the CSV, typed
+bool writeSweepColumns(const Options& options, const std::vector<SweepResult>& results) {
+    ColumnWriter table(options.sweepPath);
+    if (!table.isOpen()) {
+        return false;
+    }
+    const std::size_t speed = table.addColumn("speed", COLUMN_FLOAT32);
+    const std::size_t spawnRate = table.addColumn("spawn_rate", COLUMN_FLOAT32);
+    const std::size_t dropMin = table.addColumn("drop_min", COLUMN_FLOAT32);
+    const std::size_t dropMax = table.addColumn("drop_max", COLUMN_FLOAT32);
+    const std::size_t personWidth = table.addColumn("person_width", COLUMN_FLOAT32);
+    const std::size_t personHeight = table.addColumn("person_height", COLUMN_FLOAT32);
+    const std::size_t wetness = table.addColumn("wetness", COLUMN_FLOAT32);
+    const std::size_t analyticTop = table.addColumn("analytic_top", COLUMN_FLOAT32);
+    const std::size_t analyticFront = table.addColumn("analytic_front", COLUMN_FLOAT32);
+    const std::size_t seed = table.addColumn("seed", COLUMN_UINT64);
+    const std::size_t wetnessTop = table.addColumn("wetness_top", COLUMN_FLOAT32);
+    const std::size_t wetnessFront = table.addColumn("wetness_front", COLUMN_FLOAT32);
+    const std::size_t wetnessBack = table.addColumn("wetness_back", COLUMN_FLOAT32);
+    const std::size_t seconds = table.addColumn("seconds", COLUMN_FLOAT32);
+    for (std::size_t point = 0; point < results.size(); ++point) {
+        const Crossing crossing = crossingAt(options, point);
+        const WetnessEstimate estimate = estimateCrossing(options, crossing);
+        const SweepResult& result = results[point];
+        table.put(speed, crossing.speed);
+        table.put(spawnRate, crossing.rain.spawnRate);
+        table.put(dropMin, crossing.rain.minSize);
+        table.put(dropMax, crossing.rain.maxSize);
+        table.put(personWidth, crossing.personWidth);
+        table.put(personHeight, crossing.personHeight);
+        table.put(wetness, result.wetness);
+        table.put(analyticTop, estimate.top);
+        table.put(analyticFront, estimate.front);
+        table.put(seed, static_cast<std::uint64_t>(crossing.rain.seed));
+        table.put(wetnessTop, result.surfaces.top);
+        table.put(wetnessFront, result.surfaces.front);
+        table.put(wetnessBack, result.surfaces.back);
+        table.put(seconds, result.seconds);
+        table.endRow();
+    }
+    return table.finish();
+}
+
+} // namespace
+
+std::size_t sweepPointCount(const SweepSpec& sweep) {
+    return static_cast<std::size_t>(sweep.speed.steps) * sweep.spawnRate.steps
+        * sweep.dropSize.steps * sweep.personWidth.steps * sweep.personHeight.steps;
+}
+
+std::size_t sweepCrowdCount(const SweepSpec& sweep) {
+    const std::size_t speeds = sweep.speed.steps;
+    return sweepPointCount(sweep) / speeds * ((speeds + MAX_PEOPLE - 1) / MAX_PEOPLE);
+}
+
+void sweepCrowdPoints(const SweepSpec& sweep, std::size_t crowd, std::size_t& first, std::size_t& last) {
+    const std::size_t speeds = sweep.speed.steps;
+    const std::size_t crowdsPerGroup = (speeds + MAX_PEOPLE - 1) / MAX_PEOPLE;
+    first = crowd / crowdsPerGroup * speeds + crowd % crowdsPerGroup * MAX_PEOPLE;
+    last = std::min(first + MAX_PEOPLE, crowd / crowdsPerGroup * speeds + speeds);
+}
+
+std::vector<SweepResult> simulateSweepCrowd(const Options& options, const Scene& scene, std::size_t crowd, IntegrateKernel integrate,
+    ResultCache* cache) {
+    std::size_t first = 0;
+    std::size_t last = 0;
+    sweepCrowdPoints(options.sweep, crowd, first, last);
+    std::vector<Walker> walkers;
+    for (std::size_t point = first; point < last; ++point) {
+        const Crossing crossing = crossingAt(options, point);
+        Walker walker;
+        walker.personWidth = crossing.personWidth;
+        walker.personHeight = crossing.personHeight;
+        walker.speed = crossing.speed;
+        walker.startTime = 0.0f;
+        walkers.push_back(walker);
+    }
+
+    // Cached, each point is kept as its wetness, its top, front and back wetness, and the
+    // seconds the crowd took when it was simulated
+    const RainConfig rain = crossingAt(options, first).rain;
+    const std::uint64_t key = cache ? crowdKey(options, rain, scene, walkers) : 0;
+    std::vector<float> kept;
+    std::vector<SweepResult> results(walkers.size());
+    if (cache && cache->find(key, kept) && kept.size() == results.size() * 5) {
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            results[i].wetness = kept[i * 5];
+            results[i].surfaces.top = kept[i * 5 + 1];
+            results[i].surfaces.front = kept[i * 5 + 2];
+            results[i].surfaces.back = kept[i * 5 + 3];
+            results[i].seconds = kept[i * 5 + 4];
+        }
+        return results;
+    }
+
+    JobSystem serial(1);
+    std::vector<SurfaceWetness> surfaces;
+    const auto started = std::chrono::steady_clock::now();
+    const std::vector<float> wetness = simulateCrowd(options, rain, scene, walkers, integrate, serial, nullptr, &surfaces);
+    const std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - started;
+    kept.clear();
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        results[i].wetness = wetness[i];
+        results[i].surfaces = surfaces[i];
+        results[i].seconds = elapsed.count();
+        const float fields[] = { wetness[i], surfaces[i].top, surfaces[i].front, surfaces[i].back, elapsed.count() };
+        kept.insert(kept.end(), fields, fields + 5);
+    }
+    if (cache) {
+        cache->add(key, kept);
+    }
+    return results;
+}
+
+bool writeSweepResults(const Options& options, const std::vector<SweepResult>& results) {
+    if (isColumnarPath(options.sweepPath)) {
+        return writeSweepColumns(options, results);
+    }
+    std::ofstream csv(options.sweepPath);
+    if (!csv) {
+        std::cerr << "Couldn't open " << options.sweepPath << " for writing" << std::endl;
+        return false;
+    }
+    csv << "speed,spawn_rate,drop_min,drop_max,person_width,person_height,wetness,analytic_top,analytic_front,"
+        "seed,wetness_top,wetness_front,wetness_back,seconds\n";
+    for (std::size_t point = 0; point < results.size(); ++point) {
+        const Crossing crossing = crossingAt(options, point);
+        const WetnessEstimate estimate = estimateCrossing(options, crossing);
+        const SweepResult& result = results[point];
+        csv << crossing.speed << ',' << crossing.rain.spawnRate << ','
+            << crossing.rain.minSize << ',' << crossing.rain.maxSize << ','
+            << crossing.personWidth << ',' << crossing.personHeight << ','
+            << result.wetness << ',' << estimate.top << ',' << estimate.front << ','
+            << crossing.rain.seed << ',' << result.surfaces.top << ',' << result.surfaces.front << ','
+            << result.surfaces.back << ',' << result.seconds << '\n';
+    }
+    if (!csv) {
+        std::cerr << "Couldn't write " << options.sweepPath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int runSweep(const Options& options, IntegrateKernel integrate, JobSystem& jobs) {
+    // Each crowd is a whole simulation, so the pool parallelizes across crowds and every
+    // simulation runs inline on its worker through a single-thread pool of its own. Finished
+    // crowds go to the checkpoint as they come in, and the ones an earlier run finished are skipped
+    const std::size_t points = sweepPointCount(options.sweep);
+    const std::size_t crowds = sweepCrowdCount(options.sweep);
+    SweepCheckpoint checkpoint(options.sweepPath + ".checkpoint", options);
+    Options sweepOptions = options;
+    sweepOptions.rain.seed = checkpoint.seed();
+    std::vector<std::size_t> pending;
+    for (std::size_t crowd = 0; crowd < crowds; ++crowd) {
+        if (!checkpoint.isDone(crowd)) {
+            pending.push_back(crowd);
+        }
+    }
+    if (checkpoint.doneCount() > 0) {
+        std::cout << "Resuming: " << checkpoint.doneCount() << " of " << crowds << " simulations already done" << std::endl;
+    }
+    std::cout << "Sweeping " << points << " points in " << crowds << " simulations on " << jobs.threadCount() << " threads" << std::endl;
+    const auto started = std::chrono::steady_clock::now();
+    const Scene scene = loadScene(options.scenePath, sf::Vector2u(options.width, options.height));
+    std::vector<SweepResult> results = checkpoint.results();
+    std::unique_ptr<ResultCache> cache;
+    if (!options.cachePath.empty()) {
+        cache.reset(new ResultCache(options.cachePath));
+    }
+    const Options unsaved = withoutSnapshotSave(sweepOptions); // Only crowd 0 saves --save-snapshot
+    jobs.run(pending.size(), [&](std::size_t index, unsigned) {
+        const std::size_t crowd = pending[index];
+        std::size_t first = 0;
+        std::size_t last = 0;
+        sweepCrowdPoints(options.sweep, crowd, first, last);
+        const std::vector<SweepResult> crowdResults = simulateSweepCrowd(crowd == 0 ? sweepOptions : unsaved, scene, crowd, integrate, cache.get());
+        std::copy(crowdResults.begin(), crowdResults.end(), results.begin() + first);
+        checkpoint.add(crowd, crowdResults);
+    });
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+
+    if (!writeSweepResults(sweepOptions, results)) {
+        return EXIT_FAILURE;
+    }
+    checkpoint.remove();
+    if (cache) {
+        std::cout << cache->hitCount() << " of " << pending.size() << " simulations came from " << options.cachePath << std::endl;
+    }
+    std::cout << "Wrote " << options.sweepPath << " in " << elapsed.count() << " s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "JobSystem.h"
+#include "Options.h"
+#include "RainKernels.h"
+#include "Scene.h"
+#include "SurfaceWetness.h"
+
+// What one point of a sweep came to
+struct SweepResult {
+    float wetness;
+    SurfaceWetness surfaces; // The wetness split by the surface that caught it
+    float seconds;           // Wall time of the crowd the point was simulated in, which all its points share
+};
+
+// A sweep is split into crowds: up to MAX_PEOPLE consecutive points that differ only in speed
+// and so share their rain. Each crowd is a whole simulation of its own, the unit a sweep hands
+// to a thread or, with --sweep-serve, to another machine
+std::size_t sweepPointCount(const SweepSpec& sweep);
+std::size_t sweepCrowdCount(const SweepSpec& sweep);
+
+// Points [first, last) that crowd covers
+void sweepCrowdPoints(const SweepSpec& sweep, std::size_t crowd, std::size_t& first, std::size_t& last);
+
+class ResultCache;
+
+// Simulates crowd inline on the calling thread and returns the results of its points in order.
+// Given cache, looks the crowd up there first, and keeps it there once simulated
+std::vector<SweepResult> simulateSweepCrowd(const Options& options, const Scene& scene, std::size_t crowd, IntegrateKernel integrate,
+    ResultCache* cache = nullptr);
+
+// Writes one row per point of the sweep to options.sweepPath, next to the flux-model estimate:
+// as a columnar file, see ColumnWriter.h, if the path ends in .cols, and as CSV otherwise.
+// Problems are reported on stderr
+bool writeSweepResults(const Options& options, const std::vector<SweepResult>& results);
+
+// Simulates a headless crossing for every combination of the options.sweep ranges and writes
+// one row per point to options.sweepPath, next to the flux-model estimate. Points that only
+// differ in speed are simulated together as a crowd in the same rain, and the crowds run in
+// parallel on the job pool, one per chunk. For --sweep-serve, where the crowds go to
+// --sweep-worker processes instead, call runSweepCoordinator, see SweepNetwork.h. Finished crowds are kept in FILE.checkpoint until the
+// results are written, so running the same sweep again after a crash only simulates the rest,
+// see SweepCheckpoint.h. With --cache, crowds run before by any study are looked up instead.
+// Returns the process exit code
+int runSweep(const Options& options, IntegrateKernel integrate, JobSystem& jobs);
@@ -0,0 +1,241 @@
+#include "SweepCheckpoint.h"
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#include "Fingerprint.h"
+
+namespace {
+
+// The file is "RMSC", a version, a fingerprint of every setting that changes the results but
+// the seed, the seed and the number of points, then one record per finished crowd: its number
+// as a 64-bit integer, its point count as a 32-bit one, each point's wetness, top, front and
+// back wetness and seconds as floats, and an FNV-1a checksum of all that. Numbers are in the
+// machine's own byte order like the telemetry's
+const char CHECKPOINT_MAGIC[4] = { 'R', 'M', 'S', 'C' };
+const std::uint32_t CHECKPOINT_VERSION = 1;
+const std::size_t HEADER_BYTES = 4 + 4 + 8 + 8 + 8;
+const std::size_t POINT_FLOATS = 5;
+
+void addRange(Fingerprint& print, const SweepRange& range) {
+    print.add(range.first);
+    print.add(range.last);
+    print.add(range.steps);
+}
+
+// Everything simulateSweepCrowd reads from the options but the seed
+std::uint64_t fingerprintOf(const Options& options) {
+    const RainConfig& rain = options.rain;
+    Fingerprint print;
+    print.add(static_cast<std::uint64_t>(rain.maxDrops));
+    print.add(rain.spawnRate);
+    print.add(rain.minSize);
+    print.add(rain.maxSize);
+    print.add(static_cast<std::uint32_t>(rain.sizeModel));
+    print.add(rain.rainIntensity);
+    print.add(rain.wind.speed);
+    print.add(rain.wind.gust);
+    print.add(rain.wind.gustPeriod);
+    print.add(rain.wind.turbulence);
+    print.add(rain.columnBuckets);
+    print.add(static_cast<std::uint64_t>(rain.coarseSteps));
+    print.add(static_cast<std::uint32_t>(rain.body));
+    print.add(rain.shelterDrips);
+    print.add(rain.coalesceDistance);
+    print.add(static_cast<std::uint32_t>(rain.hits));
+    print.add(options.simHz);
+    print.add(options.width);
+    print.add(options.height);
+    print.add(options.eventDriven);
+    print.add(options.procedural);
+    print.add(options.densityField);
+    print.add(options.densityParticles);
+    print.add(options.clothingCapacity);
+    print.add(options.scenePath);
+    addRange(print, options.sweep.speed);
+    addRange(print, options.sweep.spawnRate);
+    addRange(print, options.sweep.dropSize);
+    addRange(print, options.sweep.personWidth);
+    addRange(print, options.sweep.personHeight);
+    return print.value();
+}
+
+template <typename T>
+void append(std::vector<unsigned char>& bytes, const T& value) {
+    const unsigned char* at = reinterpret_cast<const unsigned char*>(&value);
+    bytes.insert(bytes.end(), at, at + sizeof(value));
+}
+
+template <typename T>
+bool take(const std::vector<char>& bytes, std::size_t& at, T& value) {
+    if (bytes.size() - at < sizeof(value)) {
+        return false;
+    }
+    std::memcpy(&value, &bytes[at], sizeof(value));
+    at += sizeof(value);
+    return true;
+}
+
+} // namespace
+
+SweepCheckpoint::SweepCheckpoint(const std::string& path, const Options& options)
+    : path(path), file(nullptr), sweep(options.sweep), sweepSeed(options.rain.seed), done(sweepCrowdCount(options.sweep), false),
+      points(sweepPointCount(options.sweep)), finished(0) {
+    const std::uint64_t fingerprint = fingerprintOf(options);
+    if (readBack(fingerprint, options.seedGiven)) {
+        file = std::fopen(path.c_str(), "ab");
+    }
+    else {
+        // Nothing to carry on from: start the file afresh, in the seed options gave
+        sweepSeed = options.rain.seed;
+        std::fill(done.begin(), done.end(), false);
+        std::fill(points.begin(), points.end(), SweepResult());
+        finished = 0;
+        file = std::fopen(path.c_str(), "wb");
+        if (file != nullptr) {
+            std::vector<unsigned char> header;
+            header.insert(header.end(), CHECKPOINT_MAGIC, CHECKPOINT_MAGIC + sizeof(CHECKPOINT_MAGIC));
+            append(header, CHECKPOINT_VERSION);
+            append(header, fingerprint);
+            append(header, sweepSeed);
+            append(header, static_cast<std::uint64_t>(points.size()));
+            std::fwrite(header.data(), 1, header.size(), file);
+            sync();
+        }
+    }
+    if (file == nullptr) {
+        std::cerr << "Couldn't open " << path << " for writing, sweeping without a checkpoint" << std::endl;
+    }
+}
+
+SweepCheckpoint::~SweepCheckpoint() {
+    if (file != nullptr) {
+        std::fclose(file);
+    }
+}
+
+void SweepCheckpoint::add(std::size_t crowd, const std::vector<SweepResult>& crowdResults) {
+    std::vector<unsigned char> record;
+    append(record, static_cast<std::uint64_t>(crowd));
+    append(record, static_cast<std::uint32_t>(crowdResults.size()));
+    for (const SweepResult& result : crowdResults) {
+        append(record, result.wetness);
+        append(record, result.surfaces.top);
+        append(record, result.surfaces.front);
+        append(record, result.surfaces.back);
+        append(record, result.seconds);
+    }
+    Fingerprint checksum;
+    checksum.addBytes(record.data(), record.size());
+    append(record, checksum.value());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file == nullptr) {
+        return;
+    }
+    if (std::fwrite(record.data(), 1, record.size(), file) != record.size()) {
+        std::cerr << "Couldn't write to " << path << ", sweeping on without a checkpoint" << std::endl;
+        std::fclose(file);
+        file = nullptr;
+        return;
+    }
+    sync();
+}
+
+void SweepCheckpoint::remove() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file != nullptr) {
+        std::fclose(file);
+        file = nullptr;
+    }
+    std::error_code error;
+    std::filesystem::remove(path, error);
+}
+
+// Reads the records of an earlier run of the same sweep into done and points, and cuts off a
+// torn one at the end. Returns false if there's nothing to carry on from
+bool SweepCheckpoint::readBack(std::uint64_t fingerprint, bool seedGiven) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    const std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::size_t at = sizeof(CHECKPOINT_MAGIC);
+    std::uint32_t version = 0;
+    std::uint64_t storedFingerprint = 0;
+    std::uint64_t storedSeed = 0;
+    std::uint64_t storedPoints = 0;
+    if (bytes.size() < HEADER_BYTES || std::memcmp(bytes.data(), CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0
+        || !take(bytes, at, version) || !take(bytes, at, storedFingerprint) || !take(bytes, at, storedSeed) || !take(bytes, at, storedPoints)
+        || version != CHECKPOINT_VERSION || storedFingerprint != fingerprint || storedPoints != points.size()
+        || (seedGiven && storedSeed != sweepSeed)) {
+        std::cerr << path << " is from another sweep, starting over" << std::endl;
+        return false;
+    }
+    sweepSeed = storedSeed;
+
+    std::size_t good = at;
+    for (;;) {
+        const std::size_t start = at;
+        std::uint64_t crowd = 0;
+        std::uint32_t count = 0;
+        if (!take(bytes, at, crowd) || !take(bytes, at, count) || crowd >= done.size()) {
+            break;
+        }
+        std::size_t first = 0;
+        std::size_t last = 0;
+        sweepCrowdPoints(sweep, static_cast<std::size_t>(crowd), first, last);
+        if (count != last - first || bytes.size() - at < count * POINT_FLOATS * sizeof(float) + sizeof(std::uint64_t)) {
+            break;
+        }
+        std::vector<SweepResult> crowdResults(count);
+        for (SweepResult& result : crowdResults) {
+            take(bytes, at, result.wetness);
+            take(bytes, at, result.surfaces.top);
+            take(bytes, at, result.surfaces.front);
+            take(bytes, at, result.surfaces.back);
+            take(bytes, at, result.seconds);
+        }
+        Fingerprint checksum;
+        checksum.addBytes(&bytes[start], at - start);
+        std::uint64_t stored = 0;
+        take(bytes, at, stored);
+        if (stored != checksum.value()) {
+            break;
+        }
+        if (!done[crowd]) {
+            done[crowd] = true;
+            ++finished;
+        }
+        std::copy(crowdResults.begin(), crowdResults.end(), points.begin() + first);
+        good = at;
+    }
+    if (good < bytes.size()) {
+        std::error_code error;
+        std::filesystem::resize_file(path, good, error);
+        if (error) {
+            std::cerr << "Couldn't cut the torn end off " << path << ", starting over" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Pushes what's been written through the OS's cache to the disk
+void SweepCheckpoint::sync() {
+    std::fflush(file);
+#if defined(_WIN32)
+    _commit(_fileno(file));
+#else
+    fsync(fileno(file));
+#endif
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Options.h"
+#include "Sweep.h"
+
+// The crowds of a sweep finished so far, kept on disk so a sweep that dies, or the machine
+// under it, carries on where it stopped instead of starting again. Each finished crowd is
+// appended with a checksum and forced to disk before add() returns, so after a crash the file
+// holds every crowd that was reported done, and at worst a torn last record, which is dropped.
+//
+// Results only depend on the settings and the seed, so a crowd is never simulated twice: a
+// restart of the same sweep reads the finished crowds back and only runs the rest. The seed is
+// kept with them, so a sweep whose seed came from the OS carries on in the rain it started in.
+// A checkpoint left by a different sweep is started over. The layout is described in
+// SweepCheckpoint.cpp
+class SweepCheckpoint {
+public:
+    // Opens path for the sweep options describes and reads back what an earlier run of it left
+    // there. Problems are reported on stderr and leave the checkpoint closed, so the sweep runs
+    // without one
+    SweepCheckpoint(const std::string& path, const Options& options);
+    ~SweepCheckpoint();
+
+    SweepCheckpoint(const SweepCheckpoint&) = delete;
+    SweepCheckpoint& operator=(const SweepCheckpoint&) = delete;
+
+    bool isOpen() const {
+        return file != nullptr;
+    }
+
+    // The seed to sweep in: the earlier run's when resuming one whose seed wasn't given
+    std::uint64_t seed() const {
+        return sweepSeed;
+    }
+
+    bool isDone(std::size_t crowd) const {
+        return crowd < done.size() && done[crowd];
+    }
+
+    std::size_t doneCount() const {
+        return finished;
+    }
+
+    // Every point of the sweep, with the results of the finished crowds filled in
+    const std::vector<SweepResult>& results() const {
+        return points;
+    }
+
+    // Records crowd's results and returns once they're on disk. Safe from several threads
+    void add(std::size_t crowd, const std::vector<SweepResult>& crowdResults);
+
+    // Deletes the checkpoint, once the sweep's results are written
+    void remove();
+
+private:
+    std::string path;
+    std::FILE* file;
+    std::mutex mutex;
+    SweepSpec sweep;
+    std::uint64_t sweepSeed;
+    std::vector<bool> done;
+    std::vector<SweepResult> points;
+    std::size_t finished;
+
+    bool readBack(std::uint64_t fingerprint, bool seedGiven);
+    void sync();
+};
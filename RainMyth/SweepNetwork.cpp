@@ -0,0 +1,358 @@
+#include "SweepNetwork.h"
+
+#include <SFML/Network.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "Constants.h"
+#include "Headless.h"
+#include "Scene.h"
+#include "SfmlNetworkCompat.h"
+#include "Sweep.h"
+#include "SweepCheckpoint.h"
+
+namespace {
+
+// Bumped whenever a message changes, so mismatched builds refuse each other
+const std::uint32_t SWEEP_PROTOCOL_VERSION = 5;
+
+// Every packet starts with one of these
+enum SweepMessage {
+    MESSAGE_HELLO,    // Worker to coordinator: protocol version, thread count
+    MESSAGE_SETTINGS, // Coordinator to worker: what writeSettings writes
+    MESSAGE_WORK,     // Coordinator to worker: a count, then that many crowd numbers
+    MESSAGE_RESULT,   // Worker to coordinator: a crowd number, a count, then that many results as writeResult writes them
+    MESSAGE_DONE      // Coordinator to worker: nothing left, disconnect
+};
+
+void writeRange(sf::Packet& packet, const SweepRange& range) {
+    packet << range.first << range.last << static_cast<std::uint32_t>(range.steps);
+}
+
+bool readRange(sf::Packet& packet, SweepRange& range) {
+    std::uint32_t steps = 0;
+    if (!(packet >> range.first >> range.last >> steps) || steps == 0) {
+        return false;
+    }
+    range.steps = steps;
+    return true;
+}
+
+void writeResult(sf::Packet& packet, const SweepResult& result) {
+    packet << result.wetness << result.surfaces.top << result.surfaces.front << result.surfaces.back << result.seconds;
+}
+
+bool readResult(sf::Packet& packet, SweepResult& result) {
+    return static_cast<bool>(packet >> result.wetness >> result.surfaces.top >> result.surfaces.front >> result.surfaces.back >> result.seconds);
+}
+
+// Everything simulateSweepCrowd reads from the options
+void writeSettings(sf::Packet& packet, const Options& options) {
+    const RainConfig& rain = options.rain;
+    packet << static_cast<std::uint8_t>(MESSAGE_SETTINGS)
+        << static_cast<PacketUint64>(rain.seed) << static_cast<PacketUint64>(rain.maxDrops)
+        << rain.spawnRate << rain.minSize << rain.maxSize << static_cast<std::uint8_t>(rain.sizeModel) << rain.rainIntensity
+        << rain.wind.speed << rain.wind.gust << rain.wind.gustPeriod << rain.wind.turbulence
+        << rain.columnBuckets << static_cast<PacketUint64>(rain.coarseSteps) << static_cast<std::uint8_t>(rain.body)
+        << rain.shelterDrips << rain.coalesceDistance << static_cast<std::uint8_t>(rain.hits)
+        << options.simHz << static_cast<std::uint32_t>(options.width) << static_cast<std::uint32_t>(options.height)
+        << options.eventDriven << options.procedural << options.densityField << options.densityParticles
+        << options.clothingCapacity << options.scenePath;
+    writeRange(packet, options.sweep.speed);
+    writeRange(packet, options.sweep.spawnRate);
+    writeRange(packet, options.sweep.dropSize);
+    writeRange(packet, options.sweep.personWidth);
+    writeRange(packet, options.sweep.personHeight);
+}
+
+bool readSettings(sf::Packet& packet, Options& options) {
+    RainConfig& rain = options.rain;
+    PacketUint64 seed = 0;
+    PacketUint64 maxDrops = 0;
+    std::uint8_t sizeModel = 0;
+    PacketUint64 coarseSteps = 0;
+    std::uint8_t body = 0;
+    std::uint8_t hits = 0;
+    std::uint32_t width = 0;
+    std::uint32_t height = 0;
+    if (!(packet >> seed >> maxDrops >> rain.spawnRate >> rain.minSize >> rain.maxSize >> sizeModel >> rain.rainIntensity
+            >> rain.wind.speed >> rain.wind.gust >> rain.wind.gustPeriod >> rain.wind.turbulence
+            >> rain.columnBuckets >> coarseSteps >> body >> rain.shelterDrips >> rain.coalesceDistance >> hits
+            >> options.simHz >> width >> height >> options.eventDriven >> options.procedural
+            >> options.densityField >> options.densityParticles >> options.clothingCapacity >> options.scenePath)
+        || sizeModel > DROP_SIZES_MARSHALL_PALMER || coarseSteps == 0 || body > BODY_LEANING || hits > HITS_RASTER) {
+        return false;
+    }
+    rain.seed = seed;
+    rain.maxDrops = static_cast<std::size_t>(maxDrops);
+    rain.sizeModel = static_cast<DropSizeModel>(sizeModel);
+    rain.coarseSteps = static_cast<std::size_t>(coarseSteps);
+    rain.body = static_cast<BodyShape>(body);
+    rain.hits = static_cast<HitTest>(hits);
+    options.width = width;
+    options.height = height;
+    return readRange(packet, options.sweep.speed) && readRange(packet, options.sweep.spawnRate)
+        && readRange(packet, options.sweep.dropSize) && readRange(packet, options.sweep.personWidth)
+        && readRange(packet, options.sweep.personHeight);
+}
+
+// "host:port", or just "host" for the default port
+bool parseAddress(const std::string& text, std::string& host, unsigned short& port) {
+    const std::string::size_type colon = text.rfind(':');
+    host = text.substr(0, colon);
+    port = SWEEP_PORT;
+    if (colon != std::string::npos) {
+        const unsigned long value = std::strtoul(text.c_str() + colon + 1, nullptr, 10);
+        if (value == 0 || value > 65535) {
+            return false;
+        }
+        port = static_cast<unsigned short>(value);
+    }
+    return !host.empty();
+}
+
+// A connected worker and the crowds it's been handed and not yet returned
+struct RemoteWorker {
+    std::unique_ptr<sf::TcpSocket> socket;
+    std::string name;
+    unsigned threads;
+    std::vector<std::size_t> assigned;
+};
+
+} // namespace
+
+int runSweepCoordinator(const Options& options) {
+    sf::TcpListener listener;
+    if (listener.listen(options.sweepServePort) != sf::Socket::Status::Done) {
+        std::cerr << "Couldn't listen on port " << options.sweepServePort << std::endl;
+        return EXIT_FAILURE;
+    }
+    const std::size_t points = sweepPointCount(options.sweep);
+    const std::size_t crowds = sweepCrowdCount(options.sweep);
+    SweepCheckpoint checkpoint(options.sweepPath + ".checkpoint", options);
+    Options sweepOptions = options;
+    sweepOptions.rain.seed = checkpoint.seed();
+    if (checkpoint.doneCount() > 0) {
+        std::cout << "Resuming: " << checkpoint.doneCount() << " of " << crowds << " simulations already done" << std::endl;
+    }
+    std::cout << "Sweeping " << points << " points in " << crowds << " simulations, waiting for workers on port "
+        << options.sweepServePort << std::endl;
+
+    std::deque<std::size_t> unassigned;
+    std::vector<bool> finished(crowds, false);
+    for (std::size_t crowd = 0; crowd < crowds; ++crowd) {
+        finished[crowd] = checkpoint.isDone(crowd);
+        if (!finished[crowd]) {
+            unassigned.push_back(crowd);
+        }
+    }
+    std::size_t remaining = crowds - checkpoint.doneCount();
+    std::vector<SweepResult> results = checkpoint.results();
+    std::vector<std::unique_ptr<RemoteWorker>> workers;
+    sf::SocketSelector selector;
+    selector.add(listener);
+    const auto started = std::chrono::steady_clock::now();
+
+    // Hands a worker its next batch, if there's anything left to hand out
+    auto assign = [&](RemoteWorker& worker) {
+        sf::Packet packet;
+        std::vector<std::size_t> batch;
+        while (batch.size() < worker.threads && !unassigned.empty()) {
+            batch.push_back(unassigned.front());
+            unassigned.pop_front();
+        }
+        if (batch.empty()) {
+            return;
+        }
+        packet << static_cast<std::uint8_t>(MESSAGE_WORK) << static_cast<std::uint32_t>(batch.size());
+        for (std::size_t crowd : batch) {
+            packet << static_cast<PacketUint64>(crowd);
+        }
+        worker.assigned = batch;
+        (void)worker.socket->send(packet); // A send that fails shows up as a disconnect on the next receive
+    };
+
+    // Gives a worker's crowds back to whoever asks next
+    auto drop = [&](std::size_t index, const char* why) {
+        RemoteWorker& worker = *workers[index];
+        std::cerr << "Worker " << worker.name << " " << why << ", handing its " << worker.assigned.size()
+            << " simulations to the others" << std::endl;
+        for (std::size_t crowd : worker.assigned) {
+            unassigned.push_front(crowd);
+        }
+        selector.remove(*worker.socket);
+        workers.erase(workers.begin() + index);
+
+        // Someone idle may be able to take them now
+        for (std::unique_ptr<RemoteWorker>& other : workers) {
+            if (other->threads > 0 && other->assigned.empty()) {
+                assign(*other);
+            }
+        }
+    };
+
+    while (remaining > 0) {
+        if (!selector.wait(sf::seconds(5.0f))) {
+            continue;
+        }
+        if (selector.isReady(listener)) {
+            std::unique_ptr<RemoteWorker> worker(new RemoteWorker());
+            worker->socket.reset(new sf::TcpSocket());
+            worker->threads = 0; // Nothing is handed out before it says hello
+            if (listener.accept(*worker->socket) == sf::Socket::Status::Done) {
+                worker->name = remoteName(*worker->socket);
+                selector.add(*worker->socket);
+                workers.push_back(std::move(worker));
+            }
+        }
+
+        for (std::size_t index = workers.size(); index-- > 0;) {
+            RemoteWorker& worker = *workers[index];
+            if (!selector.isReady(*worker.socket)) {
+                continue;
+            }
+            sf::Packet packet;
+            if (worker.socket->receive(packet) != sf::Socket::Status::Done) {
+                drop(index, "disconnected");
+                continue;
+            }
+            std::uint8_t type = 0;
+            packet >> type;
+            if (type == MESSAGE_HELLO) {
+                std::uint32_t version = 0;
+                std::uint32_t threads = 0;
+                if (!(packet >> version >> threads) || version != SWEEP_PROTOCOL_VERSION || threads == 0) {
+                    drop(index, "speaks another protocol version");
+                    continue;
+                }
+                std::cout << "Worker " << worker.name << " joined with " << threads << " threads" << std::endl;
+                worker.threads = threads;
+                sf::Packet settings;
+                writeSettings(settings, sweepOptions);
+                (void)worker.socket->send(settings);
+                assign(worker);
+            }
+            else if (type == MESSAGE_RESULT) {
+                PacketUint64 crowd = 0;
+                std::uint32_t count = 0;
+                std::size_t first = 0;
+                std::size_t last = 0;
+                if (!(packet >> crowd >> count) || crowd >= crowds) {
+                    drop(index, "sent a bad result");
+                    continue;
+                }
+                sweepCrowdPoints(options.sweep, static_cast<std::size_t>(crowd), first, last);
+                std::vector<SweepResult> crowdResults(count);
+                bool read = true;
+                for (SweepResult& result : crowdResults) {
+                    read = read && readResult(packet, result);
+                }
+                if (!read || count != last - first) {
+                    drop(index, "sent a bad result");
+                    continue;
+                }
+
+                // A crowd handed out again after its worker dropped may come back twice
+                if (!finished[crowd]) {
+                    finished[crowd] = true;
+                    --remaining;
+                    std::copy(crowdResults.begin(), crowdResults.end(), results.begin() + first);
+                    checkpoint.add(static_cast<std::size_t>(crowd), crowdResults);
+                }
+                worker.assigned.erase(std::remove(worker.assigned.begin(), worker.assigned.end(), static_cast<std::size_t>(crowd)),
+                    worker.assigned.end());
+                if (worker.assigned.empty()) {
+                    assign(worker);
+                }
+            }
+        }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+
+    for (std::unique_ptr<RemoteWorker>& worker : workers) {
+        sf::Packet done;
+        done << static_cast<std::uint8_t>(MESSAGE_DONE);
+        (void)worker->socket->send(done);
+    }
+    if (!writeSweepResults(sweepOptions, results)) {
+        return EXIT_FAILURE;
+    }
+    checkpoint.remove();
+    std::cout << "Wrote " << options.sweepPath << " in " << elapsed.count() << " s" << std::endl;
+    return 0;
+}
+
+int runSweepWorker(const Options& options, IntegrateKernel integrate, JobSystem& jobs) {
+    std::string host;
+    unsigned short port = 0;
+    if (!parseAddress(options.sweepWorker, host, port)) {
+        std::cerr << "Couldn't read coordinator address " << options.sweepWorker << ", expected host:port" << std::endl;
+        return EXIT_FAILURE;
+    }
+    sf::IpAddress address = sf::IpAddress::Any;
+    sf::TcpSocket socket;
+    if (!resolveAddress(host, address) || socket.connect(address, port, sf::seconds(10.0f)) != sf::Socket::Status::Done) {
+        std::cerr << "Couldn't reach the coordinator at " << host << ":" << port << std::endl;
+        return EXIT_FAILURE;
+    }
+    sf::Packet hello;
+    hello << static_cast<std::uint8_t>(MESSAGE_HELLO) << SWEEP_PROTOCOL_VERSION << static_cast<std::uint32_t>(jobs.threadCount());
+    (void)socket.send(hello);
+
+    // The coordinator's settings replace this process's own
+    Options settings = options;
+    Scene scene;
+    bool configured = false;
+    std::size_t simulated = 0;
+    for (;;) {
+        sf::Packet packet;
+        if (socket.receive(packet) != sf::Socket::Status::Done) {
+            std::cerr << "Lost the coordinator" << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::uint8_t type = 0;
+        packet >> type;
+        if (type == MESSAGE_SETTINGS) {
+            if (!readSettings(packet, settings)) {
+                std::cerr << "Couldn't read the sweep settings" << std::endl;
+                return EXIT_FAILURE;
+            }
+            scene = loadScene(settings.scenePath, sf::Vector2u(settings.width, settings.height));
+            configured = true;
+        }
+        else if (type == MESSAGE_WORK && configured) {
+            std::uint32_t count = 0;
+            packet >> count;
+            std::vector<std::size_t> batch(count);
+            for (std::size_t& crowd : batch) {
+                PacketUint64 value = 0;
+                packet >> value;
+                crowd = static_cast<std::size_t>(value);
+            }
+            std::vector<std::vector<SweepResult>> results(batch.size());
+            const Options unsaved = withoutSnapshotSave(settings); // Only crowd 0 saves --save-snapshot, wherever it runs
+            jobs.run(batch.size(), [&](std::size_t i, unsigned) {
+                results[i] = simulateSweepCrowd(batch[i] == 0 ? settings : unsaved, scene, batch[i], integrate);
+            });
+            for (std::size_t i = 0; i < batch.size(); ++i) {
+                sf::Packet result;
+                result << static_cast<std::uint8_t>(MESSAGE_RESULT) << static_cast<PacketUint64>(batch[i])
+                    << static_cast<std::uint32_t>(results[i].size());
+                for (const SweepResult& point : results[i]) {
+                    writeResult(result, point);
+                }
+                (void)socket.send(result);
+            }
+            simulated += batch.size();
+        }
+        else if (type == MESSAGE_DONE) {
+            std::cout << "Sweep finished, " << simulated << " simulations run here" << std::endl;
+            return 0;
+        }
+    }
+}
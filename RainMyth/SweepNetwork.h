@@ -0,0 +1,20 @@
+#pragma once
+
+#include "JobSystem.h"
+#include "Options.h"
+#include "RainKernels.h"
+
+// A sweep spread over machines. The coordinator, started with --sweep FILE --sweep-serve PORT
+// and the usual sweep options, listens on PORT and simulates nothing itself. Workers, started
+// with --sweep-worker HOST:PORT on any number of machines, connect to it, are sent the sweep's
+// settings, and are handed crowds (see Sweep.h) a batch at a time, one per worker thread,
+// until none are left. The coordinator gathers the results and writes the CSV as runSweep
+// would. Results only depend on the settings, so they don't depend on which machine ran what.
+//
+// Everything travels as sf::Packet over sf::TcpSocket. A worker that drops out has its
+// crowds handed to someone else, and one that joins late just gets the next batch. A --scene
+// file is sent by path, so it must be at that path on every worker.
+//
+// Both return the process exit code
+int runSweepCoordinator(const Options& options);
+int runSweepWorker(const Options& options, IntegrateKernel integrate, JobSystem& jobs);
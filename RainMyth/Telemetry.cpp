@@ -0,0 +1,94 @@
+#include "Telemetry.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace {
+
+// The binary file is "RMTS", a version, the size of a sample and the number of them, then the
+// samples as TelemetrySample lays them out: six floats and ten 32-bit integers, in the machine's
+// own byte order like the replay logs. Version 1 samples stopped after the track, version 2's
+// before the stalls
+const char TELEMETRY_MAGIC[4] = { 'R', 'M', 'T', 'S' };
+const std::uint32_t TELEMETRY_VERSION = 3;
+
+static_assert(sizeof(TelemetrySample) == 64, "TelemetrySample must have no padding, it's written as is");
+
+template <typename T>
+void writePod(std::ofstream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+bool endsWith(const std::string& text, const char* suffix) {
+    const std::string tail(suffix);
+    return text.size() >= tail.size() && text.compare(text.size() - tail.size(), tail.size(), tail) == 0;
+}
+
+} // namespace
+
+Telemetry::Telemetry(std::size_t capacity)
+    : slots(std::max<std::size_t>(capacity, 1)), next(0), written(0), tracks(0) {}
+
+std::uint32_t Telemetry::addTracks(std::size_t count) {
+    const std::uint32_t first = tracks;
+    tracks += static_cast<std::uint32_t>(count);
+    return first;
+}
+
+std::size_t Telemetry::size() const {
+    return static_cast<std::size_t>(std::min<std::uint64_t>(written, slots.size()));
+}
+
+std::uint64_t Telemetry::overwritten() const {
+    return written - size();
+}
+
+template <typename Visit>
+void Telemetry::forEach(Visit visit) const {
+    // Until the ring wraps, the oldest sample is the first slot; after, it's the next one to go
+    const std::size_t first = written > slots.size() ? next : 0;
+    for (std::size_t i = 0; i < size(); ++i) {
+        const std::size_t at = first + i;
+        visit(slots[at < slots.size() ? at : at - slots.size()]);
+    }
+}
+
+bool Telemetry::write(const std::string& path) const {
+    const bool csv = endsWith(path, ".csv");
+    std::ofstream out(path, csv ? std::ios::out : std::ios::binary);
+    if (!out) {
+        std::cerr << "Couldn't open " << path << " for writing" << std::endl;
+        return false;
+    }
+
+    if (csv) {
+        out << "track,time,x,y,hit_rate,wetness,drops,step_ms,tested,candidates,pairs,contacts,hits,culled_scene,culled_offscreen,stalls\n";
+        forEach([&](const TelemetrySample& sample) {
+            out << sample.track << ',' << sample.time << ',' << sample.x << ',' << sample.y << ','
+                << sample.hitRate << ',' << sample.wetness << ',' << sample.drops << ','
+                << sample.stepSeconds * 1000.0f << ',' << sample.tested << ',' << sample.candidates << ','
+                << sample.pairs << ',' << sample.contacts << ',' << sample.hits << ',' << sample.culledByScene << ','
+                << sample.culledOffscreen << ',' << sample.stalls << '\n';
+        });
+    }
+    else {
+        out.write(TELEMETRY_MAGIC, sizeof(TELEMETRY_MAGIC));
+        writePod(out, TELEMETRY_VERSION);
+        writePod(out, static_cast<std::uint32_t>(sizeof(TelemetrySample)));
+        writePod(out, static_cast<std::uint64_t>(size()));
+        forEach([&](const TelemetrySample& sample) {
+            writePod(out, sample);
+        });
+    }
+
+    if (!out) {
+        std::cerr << "Couldn't write " << path << std::endl;
+        return false;
+    }
+    if (overwritten() > 0) {
+        std::cerr << "Telemetry kept the last " << size() << " samples; " << overwritten()
+            << " earlier ones were overwritten, raise --telemetry-samples to keep them" << std::endl;
+    }
+    return true;
+}
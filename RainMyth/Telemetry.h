@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MemoryUsage.h"
+
+// One person's state at the end of a simulation step
+struct TelemetrySample {
+    float time;          // Simulated seconds since the clock started
+    float x;             // Centre of the person
+    float y;
+    float hitRate;       // Drop area caught per second over the step
+    float wetness;       // Drop area caught so far
+    float stepSeconds;   // Wall time the step took
+    std::uint32_t drops; // Drops in the air
+    std::uint32_t track; // Which crossing or person of the run the sample belongs to
+    std::uint32_t tested;          // The step's CollisionCounters, the same for every track of
+    std::uint32_t candidates;      // the run. Zero where the rain doesn't count them
+    std::uint32_t pairs;
+    std::uint32_t contacts;
+    std::uint32_t hits;
+    std::uint32_t culledByScene;
+    std::uint32_t culledOffscreen;
+    std::uint32_t stalls;          // Frames that stalled in the run so far, see StallPolicy. Zero headless
+};
+
+// Per-step samples of where and how fast people get wet, kept in a ring that's allocated up
+// front: record() is a store and an index bump, with no allocation or I/O, so it can sit in
+// the step loop. A full ring overwrites its oldest samples. The simulation thread is the only
+// writer; everyone else reads only once it's finished, after the FrameWorker's wait() in a
+// rendered run, so the ring needs no locks. write() dumps it at the end of the run
+class Telemetry {
+public:
+    // Room for capacity samples, the latest of which are kept
+    explicit Telemetry(std::size_t capacity);
+
+    // Reserves count consecutive track numbers for the people of one simulation and returns the first
+    std::uint32_t addTracks(std::size_t count);
+
+    void record(const TelemetrySample& sample) {
+        slots[next] = sample;
+        next = next + 1 == slots.size() ? 0 : next + 1;
+        ++written;
+    }
+
+    // Samples held, and how many were overwritten before they could be written out
+    std::size_t size() const;
+    std::uint64_t overwritten() const;
+
+    MemoryUsage memoryUsage() const {
+        return vectorUsage(slots, size());
+    }
+
+    // Writes the samples held, oldest first: as CSV with a header row if path ends in .csv,
+    // otherwise as the binary layout described in Telemetry.cpp. Problems are reported on stderr
+    bool write(const std::string& path) const;
+
+private:
+    std::vector<TelemetrySample> slots;
+    std::size_t next;      // Slot the next sample goes in
+    std::uint64_t written; // Samples recorded so far
+    std::uint32_t tracks;
+
+    // Calls visit(sample) on each sample held, oldest first
+    template <typename Visit>
+    void forEach(Visit visit) const;
+};
@@ -0,0 +1,193 @@
+#include "ThreadAffinity.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+
+namespace {
+
+// Deals processors out a node at a time, each node's in order of sibling and then number
+std::vector<Processor> interleaveNodes(std::vector<Processor> processors) {
+    std::sort(processors.begin(), processors.end(), [](const Processor& a, const Processor& b) {
+        if (a.node != b.node) {
+            return a.node < b.node;
+        }
+        if (a.sibling != b.sibling) {
+            return a.sibling < b.sibling;
+        }
+        return a.group != b.group ? a.group < b.group : a.number < b.number;
+    });
+    std::map<std::uint32_t, std::vector<Processor>> byNode;
+    for (const Processor& processor : processors) {
+        byNode[processor.node].push_back(processor);
+    }
+    std::vector<Processor> order;
+    for (std::size_t turn = 0; order.size() < processors.size(); ++turn) {
+        for (const auto& node : byNode) {
+            if (turn < node.second.size()) {
+                order.push_back(node.second[turn]);
+            }
+        }
+    }
+    return order;
+}
+
+#if defined(__linux__)
+
+// Reads a sysfs list like "0-3,8,10-11"
+std::vector<unsigned> readCpuList(const std::string& path) {
+    std::vector<unsigned> cpus;
+    std::ifstream in(path);
+    std::string text;
+    if (!std::getline(in, text)) {
+        return cpus;
+    }
+    const char* at = text.c_str();
+    while (*at != '\0') {
+        char* end = nullptr;
+        const unsigned first = static_cast<unsigned>(std::strtoul(at, &end, 10));
+        if (end == at) {
+            break;
+        }
+        unsigned last = first;
+        at = end;
+        if (*at == '-') {
+            last = static_cast<unsigned>(std::strtoul(at + 1, &end, 10));
+            at = end;
+        }
+        for (unsigned cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+        if (*at == ',') {
+            ++at;
+        }
+        else {
+            break;
+        }
+    }
+    return cpus;
+}
+
+#endif
+
+} // namespace
+
+#if defined(_WIN32)
+
+std::vector<Processor> pinningOrder() {
+    std::vector<Processor> processors;
+    DWORD bytes = 0;
+    GetLogicalProcessorInformationEx(RelationAll, nullptr, &bytes);
+    std::vector<unsigned char> buffer(bytes);
+    if (bytes == 0 || !GetLogicalProcessorInformationEx(RelationAll, reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()), &bytes)) {
+        return processors;
+    }
+
+    // Cores first, then which node each of their processors sits on
+    std::map<std::pair<WORD, DWORD>, std::uint32_t> nodeOf;
+    for (DWORD at = 0; at < bytes;) {
+        const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX& info = *reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(&buffer[at]);
+        if (info.Relationship == RelationProcessorCore) {
+            std::uint32_t sibling = 0;
+            for (WORD g = 0; g < info.Processor.GroupCount; ++g) {
+                const GROUP_AFFINITY& mask = info.Processor.GroupMask[g];
+                for (DWORD bit = 0; bit < sizeof(KAFFINITY) * 8; ++bit) {
+                    if (mask.Mask & (static_cast<KAFFINITY>(1) << bit)) {
+                        const Processor processor = { mask.Group, static_cast<std::uint16_t>(bit), 0, sibling++ };
+                        processors.push_back(processor);
+                    }
+                }
+            }
+        }
+        else if (info.Relationship == RelationNumaNode) {
+            const GROUP_AFFINITY& mask = info.NumaNode.GroupMask;
+            for (DWORD bit = 0; bit < sizeof(KAFFINITY) * 8; ++bit) {
+                if (mask.Mask & (static_cast<KAFFINITY>(1) << bit)) {
+                    nodeOf[std::make_pair(mask.Group, bit)] = info.NumaNode.NodeNumber;
+                }
+            }
+        }
+        at += info.Size;
+    }
+    for (Processor& processor : processors) {
+        processor.node = nodeOf[std::make_pair(static_cast<WORD>(processor.group), static_cast<DWORD>(processor.number))];
+    }
+    return interleaveNodes(processors);
+}
+
+bool pinCurrentThread(const Processor& processor) {
+    GROUP_AFFINITY affinity = {};
+    affinity.Group = processor.group;
+    affinity.Mask = static_cast<KAFFINITY>(1) << processor.number;
+    return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != 0;
+}
+
+#elif defined(__linux__)
+
+std::vector<Processor> pinningOrder() {
+    std::vector<Processor> processors;
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return processors;
+    }
+    const std::string root = "/sys/devices/system/cpu/cpu";
+    for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &allowed)) {
+            continue;
+        }
+        const std::string dir = root + std::to_string(cpu);
+        Processor processor = { 0, static_cast<std::uint16_t>(cpu), 0, 0 };
+
+        // The node shows up as a nodeN link in the processor's directory, on NUMA kernels
+        std::error_code error;
+        for (std::filesystem::directory_iterator entry(dir, error), end; !error && entry != end; entry.increment(error)) {
+            const std::string name = entry->path().filename().string();
+            if (name.size() > 4 && name.compare(0, 4, "node") == 0) {
+                processor.node = static_cast<std::uint32_t>(std::strtoul(name.c_str() + 4, nullptr, 10));
+            }
+        }
+        const std::vector<unsigned> siblings = readCpuList(dir + "/topology/thread_siblings_list");
+        processor.sibling = static_cast<std::uint32_t>(std::find(siblings.begin(), siblings.end(), cpu) - siblings.begin());
+        if (processor.sibling == siblings.size()) {
+            processor.sibling = 0;
+        }
+        processors.push_back(processor);
+    }
+    return interleaveNodes(processors);
+}
+
+bool pinCurrentThread(const Processor& processor) {
+    if (processor.number >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(processor.number, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+#else
+
+// Elsewhere, macOS included, threads can't be pinned
+std::vector<Processor> pinningOrder() {
+    return std::vector<Processor>();
+}
+
+bool pinCurrentThread(const Processor&) {
+    return false;
+}
+
+#endif
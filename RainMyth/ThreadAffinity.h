@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// A logical processor, as the OS numbers it. Windows counts processors within groups of up
+// to 64, elsewhere group is always 0
+struct Processor {
+    std::uint16_t group;
+    std::uint16_t number;
+    std::uint32_t node; // NUMA node whose memory is local to it
+    std::uint32_t sibling; // Which hardware thread of its core it is, 0 for the first
+};
+
+// The processors this process may run on, in the order to pin a pool's threads to them: the
+// NUMA nodes take turns, so a pool smaller than the machine still has every node's memory
+// controller to itself, and a core's second hardware thread is only used once every core on
+// its node has one. Empty where the topology can't be read
+std::vector<Processor> pinningOrder();
+
+// Keeps the calling thread on processor from now on. False if the OS refused, or can't pin
+bool pinCurrentThread(const Processor& processor);
@@ -0,0 +1,132 @@
+#include "Trajectory.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+Trajectory::Trajectory(sf::Vector2f start) : end(start), totalTime(0.0f) {
+    resample();
+}
+
+void Trajectory::moveTo(sf::Vector2f target, float speed, float acceleration) {
+    const sf::Vector2f offset = target - end;
+    const float length = std::sqrt(offset.x * offset.x + offset.y * offset.y);
+    speed = std::max(speed, 1e-3f);
+    acceleration = std::max(acceleration, 0.0f);
+
+    Leg leg = { totalTime, length / speed, end, target, speed, acceleration };
+    if (acceleration > 0.0f) {
+        // Too short to reach full speed: half the way speeding up and half slowing down
+        const float rampLength = speed * speed / (2.0f * acceleration);
+        if (2.0f * rampLength >= length) {
+            leg.speed = std::sqrt(length * acceleration);
+            leg.duration = 2.0f * leg.speed / acceleration;
+        }
+        else {
+            leg.duration = 2.0f * speed / acceleration + (length - 2.0f * rampLength) / speed;
+        }
+    }
+    legs.push_back(leg);
+    end = target;
+    totalTime += leg.duration;
+    resample();
+}
+
+void Trajectory::wait(float seconds) {
+    const Leg leg = { totalTime, std::max(seconds, 0.0f), end, end, 1.0f, 0.0f };
+    legs.push_back(leg);
+    totalTime += leg.duration;
+    resample();
+}
+
+float Trajectory::minX() const {
+    float x = samples.front().x;
+    for (const Leg& leg : legs) {
+        x = std::min(x, std::min(leg.from.x, leg.to.x));
+    }
+    return x;
+}
+
+float Trajectory::maxX() const {
+    float x = samples.front().x;
+    for (const Leg& leg : legs) {
+        x = std::max(x, std::max(leg.from.x, leg.to.x));
+    }
+    return x;
+}
+
+// How far along the leg the person is time seconds into it
+float Trajectory::distanceAlong(const Leg& leg, float time) {
+    if (leg.from == leg.to) {
+        return 0.0f;
+    }
+    if (leg.acceleration == 0.0f) {
+        return leg.speed * time;
+    }
+    const float rampTime = leg.speed / leg.acceleration;
+    const float rampLength = 0.5f * leg.speed * rampTime;
+    if (time < rampTime) {
+        return 0.5f * leg.acceleration * time * time;
+    }
+    const float slowing = leg.duration - rampTime;
+    if (time < slowing) {
+        return rampLength + leg.speed * (time - rampTime);
+    }
+    const float left = leg.duration - time;
+    return rampLength + leg.speed * (slowing - rampTime) + rampLength - 0.5f * leg.acceleration * left * left;
+}
+
+// Samples every leg, exactly, on the fixed grid positionAt reads
+void Trajectory::resample() {
+    const std::size_t count = static_cast<std::size_t>(std::ceil(totalTime * TRAJECTORY_SAMPLE_RATE)) + 2;
+    samples.assign(count, end);
+    std::size_t leg = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const float time = i / TRAJECTORY_SAMPLE_RATE;
+        while (leg < legs.size() && time >= legs[leg].startTime + legs[leg].duration) {
+            ++leg;
+        }
+        if (leg == legs.size()) {
+            break; // The rest stay at the end
+        }
+        const Leg& current = legs[leg];
+        const sf::Vector2f offset = current.to - current.from;
+        const float length = std::sqrt(offset.x * offset.x + offset.y * offset.y);
+        const float along = length > 0.0f ? std::min(distanceAlong(current, time - current.startTime) / length, 1.0f) : 0.0f;
+        samples[i] = current.from + offset * along;
+    }
+}
+
+bool parseTrajectory(const std::string& spec, sf::Vector2f start, sf::Vector2f end, Trajectory& trajectory) {
+    trajectory = Trajectory(start);
+    std::istringstream steps(spec);
+    std::string step;
+    while (std::getline(steps, step, ';')) {
+        std::istringstream words(step);
+        std::string verb;
+        if (!(words >> verb)) {
+            continue; // Empty, as after a trailing ';'
+        }
+        if (verb == "wait") {
+            float seconds = 0.0f;
+            if (!(words >> seconds)) {
+                std::cerr << "Expected wait SECONDS in the route, got \"" << step << "\"" << std::endl;
+                return false;
+            }
+            trajectory.wait(seconds);
+            continue;
+        }
+        std::string across;
+        float speed = 0.0f;
+        float acceleration = 0.0f;
+        if (verb != "move" || !(words >> across >> speed)) {
+            std::cerr << "Expected move X SPEED [ACCELERATION] or wait SECONDS in the route, got \"" << step << "\"" << std::endl;
+            return false;
+        }
+        words >> acceleration;
+        const float x = across == "end" ? end.x : std::strtof(across.c_str(), nullptr);
+        trajectory.moveTo(sf::Vector2f(x, start.y), speed, acceleration);
+    }
+    return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Constants.h"
+
+// A person's whole route, built from legs and waits and then sampled TRAJECTORY_SAMPLE_RATE
+// times a second, so where they are at any time is an index and a lerp however the route is
+// made up. A leg starts and ends at rest, speeding up and slowing down at a constant
+// acceleration and cruising in between if it's long enough, or moves at full speed the whole
+// way if the acceleration is 0, as Person::startMove does
+class Trajectory {
+public:
+    explicit Trajectory(sf::Vector2f start);
+
+    // Walks in a straight line from wherever the last leg ended to target
+    void moveTo(sf::Vector2f target, float speed, float acceleration = 0.0f);
+
+    // Stands still for seconds
+    void wait(float seconds);
+
+    // Seconds from the start to the end of the last leg or wait
+    float duration() const {
+        return totalTime;
+    }
+
+    // Leftmost and rightmost x the route visits
+    float minX() const;
+    float maxX() const;
+
+    sf::Vector2f positionAt(float time) const {
+        const float position = std::min(std::max(time, 0.0f), totalTime) * TRAJECTORY_SAMPLE_RATE;
+        const std::size_t index = std::min(static_cast<std::size_t>(position), samples.size() - 2);
+        const float t = position - index;
+        return samples[index] + (samples[index + 1] - samples[index]) * t;
+    }
+
+private:
+    struct Leg {
+        float startTime;
+        float duration;
+        sf::Vector2f from;
+        sf::Vector2f to;
+        float speed;
+        float acceleration; // 0 for full speed throughout
+    };
+
+    std::vector<Leg> legs;
+    std::vector<sf::Vector2f> samples; // Position at every 1 / TRAJECTORY_SAMPLE_RATE s, and one past the end
+    sf::Vector2f end;
+    float totalTime;
+
+    void resample();
+    static float distanceAlong(const Leg& leg, float time);
+};
+
+// Reads a route from spec: legs and waits separated by ';', each "move X SPEED [ACCELERATION]"
+// or "wait SECONDS". X is a position across the world, or "end" for the end platform, and the
+// person stays at the height they started at. Reports problems on stderr and returns false
+bool parseTrajectory(const std::string& spec, sf::Vector2f start, sf::Vector2f end, Trajectory& trajectory);
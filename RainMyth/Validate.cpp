@@ -0,0 +1,132 @@
+#include "Validate.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include "Constants.h"
+#include "Headless.h"
+#include "Person.h"
+#include "RainSystem.h"
+#include "RunSummary.h"
+#include "Scene.h"
+
+namespace {
+
+// How far apart a and b are, relative to the larger of them and never less than 1
+float relativeDifference(float a, float b) {
+    return std::abs(a - b) / std::max(std::max(std::abs(a), std::abs(b)), 1.0f);
+}
+
+// The furthest any drop of one store is from the same drop of the other. Both must hold as many
+float maxPositionDifference(const RainField& a, const RainField& b) {
+    float furthest = 0.0f;
+    for (std::size_t i = 0; i < a.count(); ++i) {
+        furthest = std::max(furthest, std::max(std::abs(a.x[i] - b.x[i]), std::abs(a.y[i] - b.y[i])));
+    }
+    return furthest;
+}
+
+} // namespace
+
+int runValidation(const Options& options, IntegrateKernel integrate, JobSystem& jobs) {
+    const sf::Vector2u screen(options.width, options.height);
+    const float timestep = 1.0f / options.simHz;
+    const Scene scene = loadScene(options.scenePath, screen);
+
+    RainConfig referenceConfig = options.rain;
+    referenceConfig.columnBuckets = false;
+    referenceConfig.coarseSteps = 1;
+    JobSystem referenceJobs(1);
+    RainSystem reference(screen, referenceConfig, scene, integrateScalar, referenceJobs);
+    RainSystem optimized(screen, options.rain, scene, integrate, jobs);
+    const bool comparePositions = !options.rain.columnBuckets && options.rain.coarseSteps <= 1; // Both sort the store differently
+    // A strict build does the reference's arithmetic whatever the kernel and thread count, so
+    // unless the store is reordered nothing may differ at all
+    const bool exact = comparePositions && isStrictFloatBuild();
+    const float wetnessTolerance = exact ? 0.0f : VALIDATE_TOLERANCE;
+    const float positionTolerance = exact ? 0.0f : VALIDATE_POSITION_TOLERANCE;
+
+    const sf::Vector2f size(options.scenario.personWidth, options.scenario.personHeight);
+    Person referencePerson(startPoint(screen), size);
+    Person optimizedPerson(startPoint(screen), size);
+    const sf::FloatRect startBounds = referencePerson.getBounds();
+    reference.prewarm(&startBounds, 1);
+    optimized.prewarm(&startBounds, 1);
+    referencePerson.startMove(endPoint(screen), options.scenario.walkSpeed);
+    optimizedPerson.startMove(endPoint(screen), options.scenario.walkSpeed);
+
+    bool passed = true;
+    std::size_t step = 0;
+    float furthest = 0.0f;
+    float worstWetness = 0.0f;
+    for (; referencePerson.isMovingToTarget(); ++step) {
+        referencePerson.update(timestep);
+        optimizedPerson.update(timestep);
+        referencePerson.addWetness(reference.update(timestep, referencePerson.getBounds()));
+        optimizedPerson.addWetness(optimized.update(timestep, optimizedPerson.getBounds()));
+
+        const RainField& referenceDrops = reference.getDrops();
+        const RainField& optimizedDrops = optimized.getDrops();
+        if (referenceDrops.count() != optimizedDrops.count()) {
+            std::cout << "Step " << step << ": " << optimizedDrops.count() << " drops, the reference has " << referenceDrops.count() << std::endl;
+            passed = false;
+            break;
+        }
+        const float wetness = relativeDifference(referencePerson.getWetness(), optimizedPerson.getWetness());
+        worstWetness = std::max(worstWetness, wetness);
+        if (wetness > wetnessTolerance) {
+            std::cout << "Step " << step << ": wetness " << optimizedPerson.getWetness() << ", the reference has "
+                << referencePerson.getWetness() << std::endl;
+            passed = false;
+            break;
+        }
+        if (comparePositions) {
+            const float position = maxPositionDifference(referenceDrops, optimizedDrops);
+            furthest = std::max(furthest, position);
+            if (position > positionTolerance) {
+                std::cout << "Step " << step << ": a drop is " << position << " pixels from where the reference put it" << std::endl;
+                passed = false;
+                break;
+            }
+        }
+    }
+    for (const RainSystem* rain : { &reference, &optimized }) {
+        addSimulatedWork(rain->getLifetimes().stepCount, rain->getLifetimes().liveSteps);
+    }
+
+    std::cout << "Compared " << step << " steps with the reference: wetness " << optimizedPerson.getWetness() << " against "
+        << referencePerson.getWetness() << ", at most " << worstWetness << " apart";
+    if (comparePositions) {
+        std::cout << "; drops at most " << furthest << " pixels apart";
+    }
+    if (exact) {
+        std::cout << ", where a strict float build allows none";
+    }
+    std::cout << std::endl;
+
+    if (options.eventDriven && options.rain.wind.isCalm()) {
+        Crossing walk;
+        walk.rain = referenceConfig;
+        walk.personWidth = size.x;
+        walk.personHeight = size.y;
+        walk.speed = options.scenario.walkSpeed;
+        Options stepped = options;
+        stepped.eventDriven = false;
+        stepped.snapshotPath.clear();
+        stepped.saveSnapshotPath.clear();
+        const float steppedWetness = simulateCrossing(stepped, walk, scene, integrateScalar, referenceJobs);
+        Options events = stepped;
+        events.eventDriven = true;
+        const float eventWetness = simulateCrossing(events, walk, scene, integrate, jobs);
+        const float difference = relativeDifference(steppedWetness, eventWetness);
+        std::cout << "Event-driven wetness " << eventWetness << " against " << steppedWetness << ", " << difference << " apart" << std::endl;
+        if (difference > VALIDATE_EVENT_TOLERANCE) {
+            passed = false;
+        }
+    }
+
+    std::cout << (passed ? "Validation passed" : "Validation FAILED") << std::endl;
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
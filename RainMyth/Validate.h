@@ -0,0 +1,16 @@
+#pragma once
+
+#include "JobSystem.h"
+#include "Options.h"
+#include "RainKernels.h"
+
+// Checks the path the options select against the reference path: integrateScalar on one
+// thread with no column buckets or coarse steps. Two RainSystems start the walk of --headless from the same
+// seed and step in lockstep, and every step their drop counts must match and the person's
+// wetness agree to VALIDATE_TOLERANCE. Unless column buckets or coarse steps reorder the store, the drops
+// themselves must also be where the reference put them, to VALIDATE_POSITION_TOLERANCE. In a
+// strict float build, see isStrictFloatBuild, both tolerances are then zero. With
+// --event-driven in calm air, EventRain's crossing is compared with the reference's too; it
+// draws its drops differently, so only the wetness is, to VALIDATE_EVENT_TOLERANCE. Prints
+// where the paths first part and returns the process exit code, non-zero if they do
+int runValidation(const Options& options, IntegrateKernel integrate, JobSystem& jobs);
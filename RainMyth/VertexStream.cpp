@@ -0,0 +1,219 @@
+#include "VertexStream.h"
+
+#include <SFML/OpenGL.hpp>
+#include <SFML/Window/Context.hpp>
+#include <cstddef>
+#include <cstdint>
+
+#include "SfmlCompat.h"
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+namespace {
+
+// Only OpenGL 1.1 is declared by the system headers on Windows, so everything newer is spelled out here
+const GLenum GL_ARRAY_BUFFER_ = 0x8892;
+const GLbitfield GL_MAP_WRITE_BIT_ = 0x0002;
+const GLbitfield GL_MAP_PERSISTENT_BIT_ = 0x0040;
+const GLbitfield GL_MAP_COHERENT_BIT_ = 0x0080;
+const GLenum GL_SYNC_GPU_COMMANDS_COMPLETE_ = 0x9117;
+const GLbitfield GL_SYNC_FLUSH_COMMANDS_BIT_ = 0x0001;
+const GLenum GL_TIMEOUT_EXPIRED_ = 0x911B;
+
+typedef std::ptrdiff_t GlSizeiptr;
+typedef std::ptrdiff_t GlIntptr;
+typedef struct GlSyncObject* GlSync;
+
+struct GlFunctions {
+    void (APIENTRY* genBuffers)(GLsizei, GLuint*);
+    void (APIENTRY* deleteBuffers)(GLsizei, const GLuint*);
+    void (APIENTRY* bindBuffer)(GLenum, GLuint);
+    void (APIENTRY* bufferStorage)(GLenum, GlSizeiptr, const void*, GLbitfield);
+    void* (APIENTRY* mapBufferRange)(GLenum, GlIntptr, GlSizeiptr, GLbitfield);
+    GLboolean (APIENTRY* unmapBuffer)(GLenum);
+    GlSync (APIENTRY* fenceSync)(GLenum, GLbitfield);
+    GLenum (APIENTRY* clientWaitSync)(GlSync, GLbitfield, std::uint64_t);
+    void (APIENTRY* deleteSync)(GlSync);
+    void (APIENTRY* blendFuncSeparate)(GLenum, GLenum, GLenum, GLenum);
+};
+
+GlFunctions gl;
+
+template <typename Fn>
+bool loadFunction(Fn& fn, const char* name) {
+    fn = reinterpret_cast<Fn>(sf::Context::getFunction(name));
+    return fn != nullptr;
+}
+
+bool loadFunctions() {
+    return loadFunction(gl.genBuffers, "glGenBuffers") && loadFunction(gl.deleteBuffers, "glDeleteBuffers")
+        && loadFunction(gl.bindBuffer, "glBindBuffer") && loadFunction(gl.bufferStorage, "glBufferStorage")
+        && loadFunction(gl.mapBufferRange, "glMapBufferRange") && loadFunction(gl.unmapBuffer, "glUnmapBuffer")
+        && loadFunction(gl.fenceSync, "glFenceSync") && loadFunction(gl.clientWaitSync, "glClientWaitSync")
+        && loadFunction(gl.deleteSync, "glDeleteSync") && loadFunction(gl.blendFuncSeparate, "glBlendFuncSeparate");
+}
+
+bool isSupported() {
+    const sf::Context* context = sf::Context::getActiveContext();
+    if (context == nullptr) {
+        return false;
+    }
+    const sf::ContextSettings settings = context->getSettings();
+    const bool core = settings.majorVersion > 4 || (settings.majorVersion == 4 && settings.minorVersion >= 4);
+    return (core || (sf::Context::isExtensionAvailable("GL_ARB_buffer_storage") && sf::Context::isExtensionAvailable("GL_ARB_sync")))
+        && loadFunctions();
+}
+
+GLenum blendFactor(sf::BlendMode::Factor factor) {
+    switch (factor) {
+    case sf::BlendMode::Factor::Zero: return GL_ZERO;
+    case sf::BlendMode::Factor::One: return GL_ONE;
+    case sf::BlendMode::Factor::SrcColor: return GL_SRC_COLOR;
+    case sf::BlendMode::Factor::OneMinusSrcColor: return GL_ONE_MINUS_SRC_COLOR;
+    case sf::BlendMode::Factor::DstColor: return GL_DST_COLOR;
+    case sf::BlendMode::Factor::OneMinusDstColor: return GL_ONE_MINUS_DST_COLOR;
+    case sf::BlendMode::Factor::SrcAlpha: return GL_SRC_ALPHA;
+    case sf::BlendMode::Factor::OneMinusSrcAlpha: return GL_ONE_MINUS_SRC_ALPHA;
+    case sf::BlendMode::Factor::DstAlpha: return GL_DST_ALPHA;
+    case sf::BlendMode::Factor::OneMinusDstAlpha: return GL_ONE_MINUS_DST_ALPHA;
+    }
+    return GL_ONE;
+}
+
+GLenum primitive(sf::PrimitiveType type) {
+    switch (type) {
+    case sf::PrimitiveType::Points: return GL_POINTS;
+    case sf::PrimitiveType::Lines: return GL_LINES;
+    case sf::PrimitiveType::LineStrip: return GL_LINE_STRIP;
+    case sf::PrimitiveType::Triangles: return GL_TRIANGLES;
+    case sf::PrimitiveType::TriangleStrip: return GL_TRIANGLE_STRIP;
+    case sf::PrimitiveType::TriangleFan: return GL_TRIANGLE_FAN;
+#if SFML_VERSION_MAJOR < 3
+    case sf::PrimitiveType::Quads: return GL_QUADS; // Gone from SFML 3, which draws quads as triangles
+#endif
+    }
+    return GL_POINTS;
+}
+
+} // namespace
+
+VertexStream::VertexStream()
+    : available(isSupported()), buffer(0), mapped(nullptr), regionSize(0), current(0) {
+    for (void*& fence : fences) {
+        fence = nullptr;
+    }
+}
+
+VertexStream::~VertexStream() {
+    if (available) {
+        destroy();
+    }
+}
+
+sf::Vertex* VertexStream::map(std::size_t count) {
+    if (!available) {
+        return nullptr;
+    }
+    if (count > regionSize) {
+        // Grow geometrically so the buffer is only recreated while the rain builds up
+        destroy();
+        available = create(count + count / 2);
+        if (!available) {
+            destroy();
+            return nullptr;
+        }
+    }
+    current = (current + 1) % REGIONS;
+    waitFor(current);
+    return reinterpret_cast<sf::Vertex*>(mapped) + current * regionSize;
+}
+
+// Sets up what SFML would for these states, points the fixed-function arrays at the region
+// and draws it. sf::Vertex is laid out as position, colour, texture coordinates
+void VertexStream::draw(sf::RenderTarget& target, sf::PrimitiveType type, std::size_t count, const sf::RenderStates& states) {
+    if (!available || count == 0 || !target.setActive(true)) {
+        return;
+    }
+
+    const sf::IntRect viewport = target.getViewport(target.getView());
+    glViewport(rectLeft(viewport), static_cast<GLint>(target.getSize().y) - (rectTop(viewport) + rectHeight(viewport)), rectWidth(viewport), rectHeight(viewport));
+    glMatrixMode(GL_PROJECTION);
+    glLoadMatrixf(target.getView().getTransform().getMatrix());
+    glMatrixMode(GL_MODELVIEW);
+    glLoadMatrixf(states.transform.getMatrix());
+
+    const sf::BlendMode& blend = states.blendMode;
+    glEnable(GL_BLEND);
+    gl.blendFuncSeparate(blendFactor(blend.colorSrcFactor), blendFactor(blend.colorDstFactor),
+        blendFactor(blend.alphaSrcFactor), blendFactor(blend.alphaDstFactor));
+    sf::Texture::bind(states.texture);
+    sf::Shader::bind(states.shader);
+
+    const std::size_t offset = current * regionSize * sizeof(sf::Vertex);
+    const char* base = reinterpret_cast<const char*>(offset);
+    gl.bindBuffer(GL_ARRAY_BUFFER_, buffer);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(2, GL_FLOAT, sizeof(sf::Vertex), base);
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(sf::Vertex), base + 8);
+    glTexCoordPointer(2, GL_FLOAT, sizeof(sf::Vertex), base + 12);
+    glDrawArrays(primitive(type), 0, static_cast<GLsizei>(count));
+    gl.bindBuffer(GL_ARRAY_BUFFER_, 0);
+
+    // Nothing may write this region again until the GPU is past this draw
+    if (fences[current] != nullptr) {
+        gl.deleteSync(static_cast<GlSync>(fences[current]));
+    }
+    fences[current] = gl.fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE_, 0);
+
+    sf::Shader::bind(nullptr);
+    target.resetGLStates();
+}
+
+bool VertexStream::create(std::size_t vertices) {
+    regionSize = vertices;
+    const GlSizeiptr bytes = static_cast<GlSizeiptr>(REGIONS * regionSize * sizeof(sf::Vertex));
+    const GLbitfield flags = GL_MAP_WRITE_BIT_ | GL_MAP_PERSISTENT_BIT_ | GL_MAP_COHERENT_BIT_;
+    gl.genBuffers(1, &buffer);
+    gl.bindBuffer(GL_ARRAY_BUFFER_, buffer);
+    gl.bufferStorage(GL_ARRAY_BUFFER_, bytes, nullptr, flags);
+    mapped = static_cast<char*>(gl.mapBufferRange(GL_ARRAY_BUFFER_, 0, bytes, flags));
+    gl.bindBuffer(GL_ARRAY_BUFFER_, 0);
+    return mapped != nullptr;
+}
+
+// The buffer may still be in use by draws in flight, so they're waited for before it goes
+void VertexStream::destroy() {
+    for (unsigned region = 0; region < REGIONS; ++region) {
+        waitFor(region);
+    }
+    if (buffer != 0) {
+        if (mapped != nullptr) {
+            gl.bindBuffer(GL_ARRAY_BUFFER_, buffer);
+            gl.unmapBuffer(GL_ARRAY_BUFFER_);
+            gl.bindBuffer(GL_ARRAY_BUFFER_, 0);
+        }
+        gl.deleteBuffers(1, &buffer);
+    }
+    buffer = 0;
+    mapped = nullptr;
+    regionSize = 0;
+}
+
+// Blocks until the last draw out of region has finished. The first wait flushes, so the fence
+// is sure to be signalled eventually; after that it's a plain wait in one-second slices
+void VertexStream::waitFor(unsigned region) {
+    GlSync fence = static_cast<GlSync>(fences[region]);
+    if (fence == nullptr) {
+        return;
+    }
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT_;
+    while (gl.clientWaitSync(fence, flags, 1000000000ull) == GL_TIMEOUT_EXPIRED_) {
+        flags = 0;
+    }
+    gl.deleteSync(fence);
+    fences[region] = nullptr;
+}
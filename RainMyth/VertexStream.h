@@ -0,0 +1,58 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+
+#include "MemoryUsage.h"
+
+// Streams a frame's worth of vertices to the GPU without going through glBufferSubData. One
+// buffer with immutable storage is mapped once, persistently and coherently, and split into
+// three regions used in turn. Each draw out of a region leaves a fence behind, and a region is
+// only written again once its fence says the GPU has finished with it, which with three of
+// them in flight is almost never a wait. The CPU writes straight into the mapped memory,
+// so the data is never copied on the way.
+//
+// Needs OpenGL 4.4 or ARB_buffer_storage; isAvailable() is false without them and the caller
+// should keep to sf::VertexBuffer. Every call must be made with the same context active, and
+// draw() leaves the target's cached GL states reset
+class VertexStream {
+public:
+    VertexStream();
+    ~VertexStream();
+
+    VertexStream(const VertexStream&) = delete;
+    VertexStream& operator=(const VertexStream&) = delete;
+
+    bool isAvailable() const {
+        return available;
+    }
+
+    // Moves on to the next region and returns room for count vertices in it, growing the
+    // buffer if they won't fit. The memory is write-only: reading it back is very slow. Returns
+    // nullptr, and the stream is no longer available, if the buffer couldn't be recreated
+    sf::Vertex* map(std::size_t count);
+
+    // Draws the first count vertices of the region last mapped
+    void draw(sf::RenderTarget& target, sf::PrimitiveType type, std::size_t count, const sf::RenderStates& states);
+
+    // GPU memory. Every region is mapped and one frame or another is using it, so it's all in use
+    MemoryUsage memoryUsage() const {
+        const std::size_t bytes = available ? REGIONS * regionSize * sizeof(sf::Vertex) : 0;
+        const MemoryUsage usage = { bytes, bytes };
+        return usage;
+    }
+
+private:
+    static const unsigned REGIONS = 3;
+
+    bool available;
+    unsigned buffer;
+    char* mapped;             // Start of the whole mapping
+    std::size_t regionSize;   // In vertices
+    unsigned current;         // Region last handed out by map()
+    void* fences[REGIONS];    // GLsync per region, null once the GPU is known to be done with it
+
+    bool create(std::size_t vertices);
+    void destroy();
+    void waitFor(unsigned region);
+};
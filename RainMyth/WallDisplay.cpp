@@ -0,0 +1,85 @@
+#include "WallDisplay.h"
+
+#include "Instrument.h"
+#include "SfmlCompat.h"
+#include "SpriteAtlas.h"
+#include "WorldView.h"
+
+WallDisplay::WallDisplay(sf::Vector2u world, const sf::FloatRect& area, const sf::VideoMode& mode, sf::Vector2i position, const std::string& title,
+    const std::string& scenePath, RainRenderMode renderMode, const SpriteAtlas* atlas, sf::Color rainColor, sf::Color waterColor)
+    : world(world), area(area), scene(loadScene(scenePath, world)), background(sf::Color::Black), rainBatch(true, renderMode), atlas(atlas),
+      rainColor(rainColor), waterColor(waterColor), frame(), activated(false), worker(true) {
+    createWindow(window, mode, title.c_str(), false);
+    window.setPosition(position);
+    view = areaView(area, window.getSize());
+    window.setView(view);
+    // Made current on the display's thread by its first frame, and a context can only be
+    // current on one thread at a time
+    (void)window.setActive(false);
+    rainBatch.setArena(&arena);
+    rainBatch.setVisibleArea(area);
+    rainBatch.setAtlas(atlas);
+    if (atlas) {
+        personSprite.setTexture(&atlas->getTexture(), atlas->getRect(SPRITE_PERSON));
+    }
+}
+
+WallDisplay::~WallDisplay() {
+    // Hand the context back before the window goes, so it isn't destroyed current on another thread
+    worker.wait();
+    if (activated) {
+        worker.start([this]() { (void)window.setActive(false); });
+        worker.wait();
+    }
+}
+
+bool WallDisplay::pollEvents() {
+    WindowEvent event;
+    bool open = window.isOpen();
+    while (open && pollWindowEvent(window, event)) {
+        if (event.type == WINDOW_CLOSED || (event.type == WINDOW_KEY_PRESSED && event.key == sf::Keyboard::Key::Escape)) {
+            open = false;
+        }
+        else if (event.type == WINDOW_RESIZED) {
+            view = areaView(area, window.getSize());
+            window.setView(view);
+        }
+    }
+    return open;
+}
+
+void WallDisplay::show(const WallFrame& next) {
+    frame = next;
+    worker.start([this]() { draw(); });
+}
+
+void WallDisplay::wait() {
+    worker.wait();
+}
+
+void WallDisplay::draw() {
+    RAINMYTH_ZONE("Wall display");
+    if (!activated) {
+        (void)window.setActive(true);
+        activated = true;
+    }
+    arena.reset();
+    rainBatch.build(*frame.drops, rainColor, frame.lag);
+    background.draw(window, scene); // In place of clearing the window
+    rainBatch.draw(window);
+    frame.ground->build(groundStrip, static_cast<float>(world.y), waterColor);
+    window.draw(groundStrip);
+    window.draw(*frame.splashes, atlas ? &atlas->getTexture() : nullptr);
+    personSprite.draw(window, *frame.person, frame.alpha);
+    window.display();
+}
+
+MemoryUsage WallDisplay::memoryUsage() const {
+    MemoryUsage usage = rainBatch.memoryUsage();
+    usage += background.memoryUsage();
+    usage += arena.memoryUsage();
+    const std::size_t stripBytes = groundStrip.getVertexCount() * sizeof(sf::Vertex);
+    const MemoryUsage stripUsage = { stripBytes, stripBytes };
+    usage += stripUsage;
+    return usage;
+}
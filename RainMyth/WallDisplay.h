@@ -0,0 +1,78 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <string>
+
+#include "BackgroundCache.h"
+#include "FrameArena.h"
+#include "FrameWorker.h"
+#include "GroundWater.h"
+#include "MemoryUsage.h"
+#include "Person.h"
+#include "PersonSprite.h"
+#include "RainBatch.h"
+#include "RainField.h"
+#include "Scene.h"
+
+class SpriteAtlas;
+
+// What one simulated frame gives a wall to draw. Everything pointed to belongs to the main
+// thread and must be left alone from show() until wait()
+struct WallFrame {
+    const RainField* drops;
+    const sf::VertexArray* splashes;
+    const GroundWater* ground;
+    const Person* person;
+    float alpha; // How far into the step after the frame's last it's drawn, 0 to 1
+    float lag;   // The same in seconds, for the rain
+};
+
+// One window of a wall of displays, showing its own part of the world from the frames a single
+// simulation leaves, so every display shows the same rain. Each draws on a thread of its own:
+// show() hands it a frame and returns at once, and wait() collects it before the frame is
+// reused. It builds its own vertices for its own view and draws with its own scene, background
+// and batch, so the threads share nothing but the frame they read and the atlas texture. The
+// window itself is made and its events read on the main thread
+class WallDisplay {
+public:
+    // Opens a window of mode at position showing area of the world, of world size, and sets
+    // it up to be drawn from the display's thread
+    WallDisplay(sf::Vector2u world, const sf::FloatRect& area, const sf::VideoMode& mode, sf::Vector2i position, const std::string& title,
+        const std::string& scenePath, RainRenderMode renderMode, const SpriteAtlas* atlas, sf::Color rainColor, sf::Color waterColor);
+    ~WallDisplay();
+
+    WallDisplay(const WallDisplay&) = delete;
+    WallDisplay& operator=(const WallDisplay&) = delete;
+
+    // Handles the window's events between wait() and show(). Returns false once it's been closed
+    // or Escape pressed on it
+    bool pollEvents();
+
+    // Starts drawing frame
+    void show(const WallFrame& frame);
+
+    // Returns once the frame last shown is on the screen
+    void wait();
+
+    MemoryUsage memoryUsage() const;
+
+private:
+    sf::RenderWindow window;
+    sf::Vector2u world;
+    sf::FloatRect area;
+    sf::View view;
+    Scene scene;
+    BackgroundCache background;
+    RainBatch rainBatch;
+    FrameArena arena;
+    const SpriteAtlas* atlas;
+    sf::Color rainColor;
+    sf::Color waterColor;
+    sf::VertexArray groundStrip;
+    WallFrame frame;
+    PersonSprite personSprite;
+    bool activated; // Whether the window's context has been made current on the display's thread
+    FrameWorker worker;
+
+    void draw();
+};
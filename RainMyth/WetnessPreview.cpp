@@ -0,0 +1,92 @@
+#include "WetnessPreview.h"
+
+namespace {
+
+// Trials of a crossing before its interval is trusted to say it's settled
+const std::size_t PREVIEW_MIN_TRIALS = 10;
+
+bool sameCrossing(const Crossing& a, const Crossing& b) {
+    return a.rain.spawnRate == b.rain.spawnRate && a.personWidth == b.personWidth && a.personHeight == b.personHeight
+        && a.speed == b.speed;
+}
+
+} // namespace
+
+WetnessPreview::WetnessPreview(const Options& options, const Scene& scene, IntegrateKernel integrate, unsigned threadCount)
+    : options(options), scene(scene), integrate(integrate), generation(0), stopping(false) {
+    crossings[0] = defaultCrossing(options, options.scenario.walkSpeed);
+    crossings[1] = defaultCrossing(options, options.scenario.runSpeed);
+    for (std::size_t which = 0; which < 2; ++which) {
+        estimates[which] = estimateCrossing(options, crossings[which]);
+    }
+    for (unsigned i = 0; i < threadCount; ++i) {
+        threads.emplace_back(&WetnessPreview::work, this, i);
+    }
+}
+
+WetnessPreview::~WetnessPreview() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void WetnessPreview::follow(const Crossing& walk, const Crossing& run) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (sameCrossing(walk, crossings[0]) && sameCrossing(run, crossings[1])) {
+            return;
+        }
+        crossings[0] = walk;
+        crossings[1] = run;
+        for (std::size_t which = 0; which < 2; ++which) {
+            estimates[which] = estimateCrossing(options, crossings[which]);
+            stats[which] = RunningStats();
+        }
+        ++generation;
+    }
+    wake.notify_all();
+}
+
+PreviewReading WetnessPreview::reading(std::size_t which) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    const PreviewReading reading = { estimates[which], stats[which].count(), stats[which].mean(), stats[which].halfWidth95() };
+    return reading;
+}
+
+bool WetnessPreview::settled(std::size_t which) const {
+    const RunningStats& trials = stats[which];
+    if (options.trials > 0 && trials.count() >= options.trials) {
+        return true;
+    }
+    return trials.count() >= PREVIEW_MIN_TRIALS && trials.halfWidth95() <= options.precision * trials.mean();
+}
+
+// Each thread takes whichever unsettled crossing has the fewer trials, and carries its rain on
+// from one trial to the next, walk or run, while the spawn rate and person size stay the same.
+// Past the first a trial then costs only its own steps. Threads start in rain of their own
+void WetnessPreview::work(unsigned thread) {
+    JobSystem serial(1);
+    TrialRunner runner(options, scene, integrate, serial);
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [this]() { return stopping || !settled(0) || !settled(1); });
+        if (stopping) {
+            return;
+        }
+        const std::size_t which = settled(0) || (!settled(1) && stats[1].count() < stats[0].count()) ? 1 : 0;
+        Crossing crossing = crossings[which];
+        crossing.rain.seed = options.rain.seed + thread;
+        const std::uint64_t started = generation;
+        lock.unlock();
+        const float wetness = runner.run(crossing, true);
+        lock.lock();
+        if (generation == started) {
+            stats[which].add(wetness);
+        }
+    }
+}
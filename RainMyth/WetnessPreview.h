@@ -0,0 +1,62 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Analytic.h"
+#include "Headless.h"
+#include "MonteCarlo.h"
+#include "Options.h"
+#include "RainKernels.h"
+#include "Scene.h"
+
+// What a WetnessPreview knows of one crossing so far
+struct PreviewReading {
+    WetnessEstimate analytic; // The flux model's, there from the start
+    std::size_t trials;       // Simulated crossings behind mean, 0 until the first finishes
+    double mean;
+    double halfWidth;         // Of the 95% interval of mean
+};
+
+// Estimates the wetness of a walk and a run in the scenario being shown, for the HUD to show
+// while it's being edited. The flux model's answer is there as soon as the crossings are set,
+// and simulated trials refine it on background threads, each with its own TrialRunner, until
+// the 95% interval is within options.precision of the mean or options.trials have run, if
+// set. Setting new crossings drops the trials of the old ones, and a trial still running for
+// them is thrown away when it finishes
+class WetnessPreview {
+public:
+    WetnessPreview(const Options& options, const Scene& scene, IntegrateKernel integrate, unsigned threadCount);
+    ~WetnessPreview();
+
+    WetnessPreview(const WetnessPreview&) = delete;
+    WetnessPreview& operator=(const WetnessPreview&) = delete;
+
+    // Starts over on walk and run, unless they're the spawn rate, person size and speeds being
+    // previewed already
+    void follow(const Crossing& walk, const Crossing& run);
+
+    // The walk's reading for 0, the run's for 1
+    PreviewReading reading(std::size_t which) const;
+
+private:
+    Options options;
+    Scene scene;
+    IntegrateKernel integrate;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    Crossing crossings[2];
+    WetnessEstimate estimates[2];
+    RunningStats stats[2];
+    std::uint64_t generation; // Counts follow()s that started over, so trials know when theirs are stale
+    bool stopping;
+    std::vector<std::thread> threads;
+
+    void work(unsigned thread);
+    bool settled(std::size_t which) const;
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Constants.h"
+#include "RainConfig.h"
+#include "RainKernels.h"
+#include "Rng.h"
+
+// The horizontal wind over the screen, as a coarse grid of samples a WIND_CELL_SIZE apart.
+// Drops are small enough for drag to hold them at the speed of the air around them, so the wind
+// at a drop is its sideways speed, and moving it is one bilinear lookup into a grid that fits
+// in a few cache lines. The grid is rebuilt every step: gusts are two incommensurate sines over
+// time, so they don't visibly repeat, and every cell adds its own drifting sine with a phase
+// drawn from the seed, so the wind is the same from run to run
+class WindField {
+public:
+    WindField(float width, float height, const WindConfig& config, std::uint64_t seed)
+        : config(config), time(0.0f) {
+        grid.originX = 0.0f;
+        grid.originY = -100.0f;
+        grid.invCellSize = 1.0f / WIND_CELL_SIZE;
+        grid.columns = static_cast<int>(width / WIND_CELL_SIZE) + 2;
+        grid.rows = static_cast<int>((height + 100.0f) / WIND_CELL_SIZE) + 2;
+        cells.assign(static_cast<std::size_t>(grid.columns) * grid.rows, config.speed);
+        phases.resize(cells.size());
+        grid.cells = nullptr;
+        reseed(seed);
+    }
+
+    // Starts the wind over from time 0 as it blows for seed, in the memory it has
+    void reseed(std::uint64_t seed) {
+        Rng rng(seed ^ 0x57494E44ull); // Its own stream, so turning wind on doesn't change the drops
+        rng.fillUniform(phases.data(), phases.size(), 0.0f, 6.2831853f);
+        time = 0.0f;
+        std::fill(cells.begin(), cells.end(), config.speed);
+    }
+
+    // Advances the gusts and the turbulence to deltaTime later
+    void update(float deltaTime) {
+        if (config.isCalm()) {
+            return;
+        }
+        time += deltaTime;
+        const float tau = 6.2831853f;
+        const float gustPhase = tau * time / std::max(config.gustPeriod, 0.01f);
+        const float base = config.speed + config.gust * 0.5f * (std::sin(gustPhase) + std::sin(gustPhase * 0.618034f + 1.0f));
+        for (std::size_t c = 0; c < cells.size(); ++c) {
+            cells[c] = base + config.turbulence * std::sin(phases[c] + time * (0.5f + 0.25f * std::cos(phases[c])));
+        }
+    }
+
+    bool isCalm() const {
+        return config.isCalm();
+    }
+
+    // Seconds of wind so far. Setting it recomputes the field as it was then
+    float getTime() const {
+        return time;
+    }
+
+    void setTime(float seconds) {
+        time = seconds;
+        update(0.0f);
+    }
+
+    float maxSpeed() const {
+        return config.maxSpeed();
+    }
+
+    // Changes the steady wind the gusts and turbulence blow around, from now on
+    void setSpeed(float speed) {
+        config.speed = speed;
+        std::fill(cells.begin(), cells.end(), speed);
+        update(0.0f);
+    }
+
+    // The grid as the drift kernel reads it. Built on each call, so it stays valid when the
+    // field is copied along with its RainSystem
+    WindGrid getGrid() const {
+        WindGrid view = grid;
+        view.cells = cells.data();
+        return view;
+    }
+
+private:
+    WindConfig config;
+    float time;
+    std::vector<float> cells;  // Wind speed at each grid point, row by row
+    std::vector<float> phases; // Per-cell turbulence phase
+    WindGrid grid;             // Layout of cells; the pointer is filled in by getGrid
+};
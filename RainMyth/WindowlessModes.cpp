@@ -0,0 +1,72 @@
+#include "WindowlessModes.h"
+
+#include <chrono>
+#include <iostream>
+
+#include "Batch.h"
+#include "Headless.h"
+#include "ImportanceSampling.h"
+#include "MonteCarlo.h"
+#include "Optimizer.h"
+#include "RunSummary.h"
+#include "Script.h"
+#include "Sweep.h"
+#include "SweepNetwork.h"
+#include "Validate.h"
+
+bool runWindowlessMode(const Options& options, const ReplayLog* replay, IntegrateKernel integrate, JobSystem& jobs, int& exitCode) {
+    // Whatever the mode simulates is summarized once it's done, from what the engines added up
+    const char* kernel = nullptr;
+    selectIntegrateKernel(options.kernel.c_str(), &kernel); // The caller's choice, named again
+    RunSummary run = summaryOf(options, "cpu", kernel, jobs.threadCount());
+    const SimulatedWork before = simulatedWork();
+    const auto started = std::chrono::steady_clock::now();
+    if (!options.sweepWorker.empty()) {
+        exitCode = runSweepWorker(options, integrate, jobs);
+    }
+    else if (!options.sweepPath.empty() && options.sweepServePort != 0) {
+        exitCode = runSweepCoordinator(options);
+        return true; // It simulates nothing itself
+    }
+    else if (!options.sweepPath.empty()) {
+        exitCode = runSweep(options, integrate, jobs);
+    }
+    else if (options.validate) {
+        exitCode = runValidation(options, integrate, jobs);
+    }
+    else if (options.optimizeTrials > 0) {
+        exitCode = runOptimizer(options, integrate, jobs);
+    }
+    else if (options.importanceSamples > 0) {
+        exitCode = runImportance(options, jobs);
+    }
+    else if (options.trials > 0) {
+        exitCode = runMonteCarlo(options, integrate, jobs);
+    }
+    else if (!options.batchPath.empty()) {
+        exitCode = runBatch(options, integrate, jobs);
+    }
+    else if (options.headless && options.offlinePath.empty()) {
+        // --offline wins over --headless, and is the caller's to run
+        if (replay) {
+            exitCode = runReplay(*replay, integrate, jobs);
+        }
+        else {
+            exitCode = options.scriptPath.empty() ? runHeadless(options, integrate, jobs, &run.wetness) : runScript(options, integrate, jobs);
+        }
+    }
+    else {
+        return false;
+    }
+
+    const SimulatedWork after = simulatedWork();
+    run.steps = after.steps - before.steps;
+    run.dropSteps = after.dropSteps - before.dropSteps;
+    run.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    run.peakMemory = peakResidentMemory();
+    run.print(std::cout);
+    if (!options.summaryPath.empty()) {
+        run.append(options.summaryPath);
+    }
+    return true;
+}
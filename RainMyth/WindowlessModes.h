@@ -0,0 +1,13 @@
+#pragma once
+
+#include "JobSystem.h"
+#include "Options.h"
+#include "RainKernels.h"
+#include "Replay.h"
+
+// Runs whichever mode the options ask for that needs no window, GL context or font: the sweep
+// coordinator and workers, sweeps, validation, the optimizer, trials, batches and --headless
+// runs, including a replay's given its log. Offline renders draw, so they aren't among them.
+// Returns false if the options ask for none of these, otherwise true with the process exit
+// code in exitCode. Both RainMyth and the windowless RainMythHeadless start here
+bool runWindowlessMode(const Options& options, const ReplayLog* replay, IntegrateKernel integrate, JobSystem& jobs, int& exitCode);
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <SFML/Graphics/View.hpp>
+#include <algorithm>
+
+// A view of area of the world, scaled to fit a target of the given size and centred with bars
+// where the shapes differ
+inline sf::View areaView(const sf::FloatRect& area, sf::Vector2u target) {
+    sf::View view(area);
+    const float targetAspect = target.x / static_cast<float>(std::max(target.y, 1u));
+    const float areaAspect = view.getSize().x / std::max(view.getSize().y, 1.0f);
+    if (targetAspect > areaAspect) {
+        const float width = areaAspect / targetAspect;
+        view.setViewport(sf::FloatRect(sf::Vector2f((1.0f - width) / 2.0f, 0.0f), sf::Vector2f(width, 1.0f)));
+    }
+    else {
+        const float height = targetAspect / areaAspect;
+        view.setViewport(sf::FloatRect(sf::Vector2f(0.0f, (1.0f - height) / 2.0f), sf::Vector2f(1.0f, height)));
+    }
+    return view;
+}
+
+// A view of the whole world, fitted to the target the same way
+inline sf::View worldView(sf::Vector2u world, sf::Vector2u target) {
+    return areaView(sf::FloatRect(sf::Vector2f(0.0f, 0.0f), sf::Vector2f(world)), target);
+}
+
+// The part of the world a view shows, for views that aren't rotated
+inline sf::FloatRect viewBounds(const sf::View& view) {
+    return sf::FloatRect(view.getCenter() - view.getSize() / 2.0f, view.getSize());
+}
@@ -1,351 +1,1577 @@
 #include <iostream>
-#include <vector>
-#include <memory>
 #include <SFML/Graphics.hpp>
 #include <SFML/Window.hpp>
 #include <SFML/OpenGL.hpp>
 #include <algorithm>
 #include <cmath>
-#include <random>
-
-// Constants for the simulation
-const float GRAVITY = 9.81f * 100; // 9.81 m/s^2 assumes 1 pixel is a meter. We want it to be 100 pixels is a meter
-const float RAINDROP_MIN_SIZE = 0.5f;
-const float RAINDROP_MAX_SIZE = 1.5f;
-const float RAINDROP_SPAWN_RATE = 175.0f; // Raindrops rate. Do not run this too high
-const float WALK_SPEED = 50.0f; // Pixels per second
-const float RUN_SPEED = 200.0f; // Pixels per second
-const float PERSON_WIDTH = 40.0f;
-const float PERSON_HEIGHT = 100.0f;
-const float MAX_WETNESS = 1000.0f; // A threshold for the maximum visual wetness
-
-// A class to represent a single raindrop
-class Raindrop {
-public:
-    // Constructor initializes a raindrop with a random size and position at the top
-    Raindrop(sf::Vector2u windowSize) {
-        // Use a random device and engine to generate random numbers
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_real_distribution<> xDist(0.0f, windowSize.x);
-        std::uniform_real_distribution<> sizeDist(RAINDROP_MIN_SIZE, RAINDROP_MAX_SIZE);
-        std::uniform_real_distribution<> yDist(-100.0f, -50.0f);
-
-        // Randomly set the size and initial x-position
-        float size = static_cast<float>(sizeDist(gen));
-        float x = static_cast<float>(xDist(gen));
-        float y = static_cast<float>(yDist(gen));
-
-        // Initialize the shape (thin rectangle for a droplet)
-        shape.setSize(sf::Vector2f(size, size * 2.0f)); // Make drops longer than they are wide
-        shape.setFillColor(sf::Color(173, 216, 230, 200)); // Light blue with transparency
-        shape.setPosition(x, y); // Start just above the top of the window
-
-        // Initialize the velocity
-        velocity = sf::Vector2f(0.0f, 0.0f);
-    }
-
-    // Updates the raindrop's position based on gravity and a time step
-    void update(float deltaTime) {
-        // Apply gravity to the velocity
-        velocity.y += GRAVITY * deltaTime;
-
-        // Update the position
-        shape.move(velocity * deltaTime);
-    }
-
-    // Draws the raindrop on the window
-    void draw(sf::RenderWindow& window) {
-        window.draw(shape);
-    }
-
-    // Checks if the raindrop has fallen off the bottom of the screen
-    bool isOffScreen(sf::Vector2u windowSize) const {
-        return shape.getPosition().y > windowSize.y;
-    }
-
-	// Checks if the raindrop has hit a platform. This can definitely be improved: a rain drop should be gone if it's past the platform and in the y range of the platform
-    bool isOnPlatty(sf::Vector2u windowSize) const {
-		// Hardcoded platform position and size for simplicity. I'd like to make them constant but it depends on the window size
-        if (shape.getPosition().x > windowSize.x / 8.0f - 100.0f && shape.getPosition().x < windowSize.x / 8.0f + 100.0f) {
-            if(shape.getPosition().y > windowSize.y - 250.0f - 25.0f && shape.getPosition().y < windowSize.y - 250.0f + 25.0f) {
-                return true;
-			}
-            else {
-                return false;
-            }
-        }
-        else if (shape.getPosition().x > windowSize.x * 7.0f / 8.0f - 100.0f && shape.getPosition().x < windowSize.x * 7.0f / 8.0f + 100.0f) {
-            if (shape.getPosition().y > windowSize.y - 250.0f - 25.0f && shape.getPosition().y < windowSize.y - 250.0f + 25.0f) {
-                return true;
-            }
-            else {
-                return false;
-            }
-        }
-        else {
-            return false;
-        }
-        
-    }
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
 
-    // Returns the area of the raindrop for wetness calculation
-    float getArea() const {
-        return shape.getSize().x * shape.getSize().y;
-    }
+#include "AllocationCounter.h"
+#include "AssetPack.h"
+#include "BackgroundCache.h"
+#include "Camera.h"
+#include "Clothing.h"
+#include "Constants.h"
+#include "Crowd.h"
+#include "CycleTimer.h"
+#include "EmbeddedFont.h"
+#include "FarRain.h"
+#include "FrameArena.h"
+#include "FrameCapture.h"
+#include "FramePacer.h"
+#include "FrameTimes.h"
+#include "FrameWorker.h"
+#include "GpuRain.h"
+#include "GroundWater.h"
+#include "HitLog.h"
+#include "IdleTasks.h"
+#include "InputLatency.h"
+#include "Hud.h"
+#include "Instrument.h"
+#include "MemoryUsage.h"
+#include "MetricsEmitter.h"
+#include "JobSystem.h"
+#include "Offline.h"
+#include "Options.h"
+#include "PaceStick.h"
+#include "PeopleBatch.h"
+#include "Person.h"
+#include "PersonSprite.h"
+#include "Profiler.h"
+#include "QualityGovernor.h"
+#include "RainAudio.h"
+#include "RainBatch.h"
+#include "RainDetail.h"
+#include "RainIntensity.h"
+#include "RainKernels.h"
+#include "RainSystem.h"
+#include "RemoteControl.h"
+#include "Replay.h"
+#include "RunSummary.h"
+#include "Scene.h"
+#include "SceneEditor.h"
+#include "Script.h"
+#include "SfmlCompat.h"
+#include "SpriteAtlas.h"
+#include "SpscQueue.h"
+#include "Startup.h"
+#include "StormTrack.h"
+#include "StressTest.h"
+#include "Telemetry.h"
+#include "WallDisplay.h"
+#include "WetnessPreview.h"
+#include "WindowlessModes.h"
+#include "WorldView.h"
 
-    // Returns the global bounding box for collision detection
-    sf::FloatRect getBounds() const {
-        return shape.getGlobalBounds();
+namespace {
+
+// What one simulation job leaves for the renderer: copies of the drops and the person as they
+// were after its last step, the splash quads, how long it took and the collision work it did
+struct SimFrame {
+    SimFrame(std::size_t capacity, const Person& person)
+        : drops(capacity), person(person), clothes(), runoff(0.0f), splashes(QUAD_PRIMITIVE), people(sf::PrimitiveType::Points), steps(0), movesStarted(0), alpha(0.0f), updateSeconds(0.0f),
+          collisionSeconds(0.0f), counters() {
+        sounds.clear();
     }
-private:
-    sf::RectangleShape shape;
-    sf::Vector2f velocity;
+
+    RainField drops;
+    Person person;
+    SurfaceWetness clothes; // With --clothing, what the person's clothes hold, and what's run off them
+    float runoff;
+    sf::VertexArray splashes;
+    sf::VertexArray people; // Instances for PeopleBatch: the crowd, and the person unless the atlas textures them
+    unsigned steps;
+    unsigned movesStarted; // W and R presses the job's steps acted on
+    float alpha; // How far into the step after its last the frame is shown, 0 to 1
+    float updateSeconds;
+    float collisionSeconds;
+    CollisionCounters counters; // Summed over the job's steps
+    RainSoundEvents sounds;
+    GroundWater ground;
 };
 
-// A class to manage the entire rain system
-class RainSystem {
-public:
-    RainSystem(sf::Vector2u windowSize) : windowSize(windowSize) {}
+// With --common-rain, the rain as it was when W or R was first pressed, which every later
+// press puts back, so each strategy tried crosses exactly the same drops
+struct CommonRain {
+    explicit CommonRain(std::size_t capacity) : drops(capacity), saved(false), state() {}
 
-    // Updates all raindrops and respawns those that are off-screen
-    void update(float deltaTime) {
-        for (auto& drop : drops) {
-            drop.update(deltaTime);
+    RainField drops;
+    bool saved;
+    RainState state;
+
+    void restoreOrSave(RainSystem& rain) {
+        if (saved) {
+            rain.setState(state, drops.x.data(), drops.y.data(), drops.vy.data(), drops.size.data(), drops.absorbed.data(), drops.count());
+            return;
         }
+        state = rain.getState();
+        const RainField& current = rain.getDrops();
+        drops.assign(current.x.data(), current.y.data(), current.vy.data(), current.size.data(), current.absorbed.data(), current.count());
+        saved = true;
+    }
+};
+
+enum SimCommandType {
+    COMMAND_RESET,       // Put the person back at the start, dry
+    COMMAND_START_MOVE,  // Send the person to the end at value pixels per second
+    COMMAND_SPAWN_RATE,  // Spawn value drops per pixel of width per second
+    COMMAND_PERSON_WIDTH,
+    COMMAND_PERSON_HEIGHT,
+    COMMAND_MAX_WETNESS, // Wetness the person is drawn fully soaked at
+    COMMAND_WIND,        // Blow a steady wind of value pixels per second
+    COMMAND_PACE         // Carry on the move under way at value pixels per second
+};
+
+// An input on its way from the render thread to the simulation, stamped with the simulated
+// time it was made at. It takes effect at the start of the step that time falls in
+struct SimCommand {
+    SimCommandType type;
+    double time;
+    float value;
+};
 
-        // Remove raindrops that are off-screen. This is a wild line of code
-        drops.erase(std::remove_if(drops.begin(), drops.end(),
-            [this](const Raindrop& drop) {
-                return drop.isOffScreen(this->windowSize);
-            }),
-            drops.end());
+// A script's actions are carried out as the inputs they stand for
+SimCommandType commandForScript(ScriptActionType type) {
+    switch (type) {
+    case SCRIPT_RESET:
+        return COMMAND_RESET;
+    case SCRIPT_MOVE:
+        return COMMAND_START_MOVE;
+    case SCRIPT_SPAWN_RATE:
+        return COMMAND_SPAWN_RATE;
+    case SCRIPT_WIND:
+        return COMMAND_WIND;
+    case SCRIPT_PERSON_WIDTH:
+        return COMMAND_PERSON_WIDTH;
+    case SCRIPT_PERSON_HEIGHT:
+        return COMMAND_PERSON_HEIGHT;
+    }
+    return COMMAND_RESET;
+}
 
-        // Remove raindrops that are on a platty
-        drops.erase(std::remove_if(drops.begin(), drops.end(),
-            [this](const Raindrop& drop) {
-                return drop.isOnPlatty(this->windowSize);
-            }),
-            drops.end());
+// Inputs that haven't been sent yet. 64 is far more than a frame's worth of key presses
+typedef SpscQueue<SimCommand, 64> CommandQueue;
 
-        for (int i = 0; i < RAINDROP_SPAWN_RATE; ++i) {
-                drops.emplace_back(windowSize);
-        }
+} // namespace
 
+int main(int argc, char* argv[])
+{
+    if (const char* missing = missingInstructionSet()) {
+        std::cerr << "This build needs a CPU with " << missing << "; use the Release build on this machine" << std::endl;
+        return EXIT_FAILURE;
+    }
+    Options options = parseOptions(argc, argv);
+    StartupTimeline startup(options.startupTimes);
+    if (!options.packAssetsPath.empty()) {
+        return writeAssetPack("Assets", options.packAssetsPath) ? EXIT_SUCCESS : EXIT_FAILURE;
     }
 
-    // Draws all raindrops
-    void draw(sf::RenderWindow& window) {
-        for (auto& drop : drops) {
-            drop.draw(window);
+    // A replay takes its settings from the log, before anything is set up from them
+    ReplayLog replay;
+    const bool replaying = !options.replayPath.empty();
+    if (replaying) {
+        if (!readReplay(options.replayPath, replay)) {
+            return EXIT_FAILURE;
         }
+        applyReplay(replay, options);
     }
+    const bool recording = !options.recordPath.empty() && !replaying;
 
-    // Returns a reference to the drops vector for collision checks
-    const std::vector<Raindrop>& getDrops() const {
-        return drops;
+    // A log carries the rain but not the person, so recorded and replayed runs keep the
+    // default person and don't watch the scenario for changes
+    Scenario scenario = options.scenario;
+    if ((recording || replaying) && !options.scenarioPath.empty()) {
+        std::cerr << "Only the scenario's spawn rate applies while recording or replaying" << std::endl;
+        const float spawnRate = scenario.spawnRate;
+        scenario = defaultScenario();
+        scenario.spawnRate = spawnRate;
     }
-private:
-    std::vector<Raindrop> drops;
-    sf::Vector2u windowSize;
-};
+    ScenarioWatcher watcher(recording || replaying ? std::string() : options.scenarioPath);
 
-// A class to represent the person in the simulation
-class Person {
-public:
-    Person(sf::Vector2f position)
-        : totalWetness(0.0f), isMoving(false), currentSpeed(0.0f) {
-        shape.setSize(sf::Vector2f(PERSON_WIDTH, PERSON_HEIGHT));
-        shape.setOrigin(PERSON_WIDTH / 2.0f, PERSON_HEIGHT / 2.0f);
-        shape.setPosition(position);
-        shape.setFillColor(sf::Color(139, 69, 19)); // Brown
+    const char* kernelName = nullptr;
+    IntegrateKernel integrate = selectIntegrateKernel(options.kernel.c_str(), &kernelName);
+    std::cout << "Integration kernel: " << kernelName << std::endl;
+    JobSystem jobs(options.threads, options.pinThreads);
+    if (jobs.isPinned()) {
+        std::cout << "Job threads pinned, one per processor" << std::endl;
     }
+    startup.mark("Options and job system");
 
-    // Starts movement towards a target position
-    void startMove(sf::Vector2f target, float speed) {
-        if (!isMoving) {
-            targetPosition = target;
-            currentSpeed = speed;
-            isMoving = true;
+    // Headless runs never create a window, GL context or font
+    int exitCode = EXIT_SUCCESS;
+    if (runWindowlessMode(options, replaying ? &replay : nullptr, integrate, jobs, exitCode)) {
+        return exitCode;
+    }
+    if (!options.offlinePath.empty()) {
+        if (replaying) {
+            std::cerr << "Offline renders take the replay's settings but not its inputs" << std::endl;
         }
+        return runOffline(options, integrate, jobs);
     }
 
-    // Resets the person's wetness and position
-    void reset(sf::Vector2f position) {
-        totalWetness = 0.0f;
-        isMoving = false;
-        shape.setPosition(position);
-        updateColor();
+    // A script stands in for the keys, which a log already does for a replay and couldn't hold
+    // the rain changes of for a recording
+    Script script;
+    const bool scripted = !options.scriptPath.empty() && !recording && !replaying;
+    if (!options.scriptPath.empty() && !scripted) {
+        std::cerr << "Recording and replaying don't take a script, ignoring --script" << std::endl;
+    }
+    if (scripted && !script.load(options.scriptPath, options)) {
+        return EXIT_FAILURE;
     }
 
-    void update(float deltaTime) {
-        if (isMoving) {
-            // Calculate the direction vector
-            sf::Vector2f direction = targetPosition - shape.getPosition();
+    // The world is --width by --height units, or what the replay was recorded in, whatever the
+    // display: a bigger monitor draws the same simulation larger rather than simulating more.
+    // A live run fills the desktop unless --windowed; a replay gets a window of the world's size.
+    // F11 switches between the two at any time
+    const sf::VideoMode desktopMode = sf::VideoMode::getDesktopMode();
+    const unsigned defaultWindowWidth = 1280;
+    const unsigned defaultWindowHeight = 720;
+    const sf::VideoMode windowedMode = replaying ? videoMode(replay.width, replay.height) : videoMode(defaultWindowWidth, defaultWindowHeight);
+    const char* title = replaying ? "Rain Simulation (replay)" : "Rain Simulation";
+    bool isFullScreen = !replaying && !options.windowed;
+    sf::RenderWindow window;
+    createWindow(window, isFullScreen ? desktopMode : windowedMode, title, isFullScreen);
+    FramePacer pacer(window, options.pacing, options.fps, options.lowLatency);
+    startup.mark("Window and GL context");
 
-            // Check if we are close to the target to stop
-            float distance = std::sqrt(direction.x * direction.x + direction.y * direction.y);
-            if (distance < 5.0f) { // Arbitrary small threshold
-                isMoving = false;
-                shape.setPosition(targetPosition);
-            }
-            else {
-                // Normalize the direction vector and move
-                direction /= distance;
-                shape.move(direction * currentSpeed * deltaTime);
-            }
+    // Everything from here on works in world units; only drawing knows about the window, so a
+    // resize or a new window only changes the view
+    const sf::Vector2u windowSize(options.width, options.height);
+    window.setView(worldView(windowSize, window.getSize()));
+
+    // Create the rain system
+    Scene scene = loadScene(options.scenePath, windowSize);
+    RainSystem rainSystem(windowSize, options.rain, scene, integrate, jobs);
+    SplashSystem splashes(options.splashBudget, options.rain.seed);
+    // Sounds are placed by where drops land, so with audio on some landings are kept even without splashes
+    const std::size_t splashImpacts = options.splashBudget > 0 ? options.splashBudget / SPLASH_DROPLETS + 1 : 0;
+    rainSystem.recordImpacts(options.audioVolume > 0.0f ? std::max(splashImpacts, AUDIO_IMPACT_SAMPLES) : splashImpacts);
+    RainBatch rainBatch(true, options.renderMode);
+    rainBatch.setStreaks(options.streakExposure, options.streakPersistence);
+    rainBatch.setResolution(options.rainResolution);
+    rainBatch.setBackgroundCompile(true); // Quads until the points shader is in, for the first frame's sake
+    startup.mark("Scene and rain system");
+
+    // The camera zooms and pans the view over the world, and the rain is drawn in as much
+    // detail as the zoom calls for: tiles far out, RainBatch's drops, then full streaks close in
+    Camera camera(windowSize);
+    RainDetail rainDetail;
+    RainDetailLevel detail = DETAIL_DROPS;
+
+    // Scratch for the main thread's side of each frame, the rain's vertices when they aren't
+    // streamed among it. The job's scratch comes from the job system's arenas, one per worker
+    FrameArena renderArena;
+    rainBatch.setArena(&renderArena);
+
+    // The rain, the splashes and the person all draw from one texture
+    SpriteAtlas atlas;
+    const bool useAtlas = atlas.build();
+    if (useAtlas) {
+        rainBatch.setAtlas(&atlas);
+    }
+    else {
+        std::cerr << "Couldn't build the sprite atlas, drawing untextured" << std::endl;
+    }
+    startup.mark("Sprite atlas");
+
+    // The GPU path replaces RainSystem when it's asked for and the driver can run it. Its
+    // results depend on the driver, so recording and replaying always use the CPU rain
+    std::unique_ptr<GpuRain> gpuRain;
+    if (options.gpu && (recording || replaying)) {
+        std::cerr << "Recording and replaying use the CPU rain, ignoring --gpu" << std::endl;
+    }
+    else if (options.gpu) {
+        gpuRain.reset(new GpuRain(window, windowSize, options.rain, scene, options.gpuDrops, options.gpuBackend, options.shaderCachePath));
+        if (!gpuRain->isAvailable()) {
+            std::cerr << "Falling back to CPU rain" << std::endl;
+            gpuRain.reset();
         }
+        startup.mark("GPU rain");
     }
 
-    void draw(sf::RenderWindow& window) {
-        updateColor();
-        window.draw(shape);
+    // Level of detail: the particles only cover the columns that matter for the wetness and
+    // the scene, and the far layer draws the rest. Only the CPU rain is banded. A live run
+    // simulates the whole screen until the far layer's shader has compiled in the background;
+    // a log says whether the band was in use, so recording and replaying wait for it here.
+    // The depth layers behind come from the same shader, with any rain
+    std::unique_ptr<FarRain> farRain;
+    bool drawFarRain = false;
+    bool drawDepthRain = false;
+    const bool banded = options.lod && !gpuRain;
+    sf::Vector2f farBand(0.0f, 0.0f); // The columns the far layer leaves to the simulated rain
+    const auto useFarRain = [&]() {
+        if (!farRain->isAvailable()) {
+            std::cerr << "No shader support for the far rain layer" << (banded ? ", simulating the whole screen" : "") << std::endl;
+            return;
+        }
+        if (banded) {
+            farBand = nearBand(windowSize, scene, sf::Vector2f(scenario.personWidth, scenario.personHeight), options.rain.maxSize);
+            rainSystem.setSpawnBand(farBand.x, farBand.y);
+            farRain->setNearBand(farBand.x, farBand.y);
+            drawFarRain = true;
+        }
+        drawDepthRain = farRain->getDepthLayers() > 0;
+    };
+    if (banded || options.depthLayers > 0 || options.idleSeconds > 0.0f) {
+        farRain.reset(new FarRain(options.rain, windowSize, !recording && !replaying));
+        farRain->setDepthLayers(options.depthLayers);
+        if (!farRain->isCompiling()) {
+            useFarRain();
+            startup.mark("Far rain shader");
+        }
+    }
+
+    // The ramp sets the spawn rate, which recordings don't log, and the GPU rain keeps a fixed
+    // population, so it's only run when neither is in play
+    std::unique_ptr<StressRamp> stress;
+    if (options.stress && (recording || replaying || gpuRain)) {
+        std::cerr << "The stress test needs the CPU rain and no recording or replay, ignoring --stress" << std::endl;
+    }
+    else if (options.stress) {
+        stress.reset(new StressRamp(options.rain.spawnRate, options.rain.maxDrops));
     }
 
-    // Accumulates wetness from a raindrop
-    void addWetness(float area) {
-        totalWetness += area;
+    // The governor thins the rain outside the columns that matter to the person. That changes
+    // the random draws, so it stays off while recording or replaying, and it would hide the
+    // cost the stress test is after
+    QualityGovernor governor(recording || replaying || gpuRain || stress ? 0.0f : options.targetMs);
+    const sf::Vector2f fullBand = nearBand(windowSize, scene, sf::Vector2f(scenario.personWidth, scenario.personHeight), options.rain.maxSize);
+
+    ReplayLog record;
+    if (recording) {
+        record.rain = options.rain;
+        record.simHz = options.simHz;
+        record.width = windowSize.x;
+        record.height = windowSize.y;
+        record.lod = drawFarRain;
+        record.scenePath = options.scenePath;
+        record.kernel = kernelName;
+        record.strictFloat = isStrictFloatBuild();
     }
 
-    // Returns the person's bounding box for collision detection
-    sf::FloatRect getBounds() const {
-        return shape.getGlobalBounds();
+    // Create the person
+    Person person(startPoint(windowSize), sf::Vector2f(scenario.personWidth, scenario.personHeight));
+    person.setMaxWetness(scenario.maxWetness);
+    Clothing clothing(options.clothingCapacity);
+    clothing.addPerson(scenario.personWidth, scenario.personHeight);
+    Crowd crowd(options.crowdCount, windowSize, sf::Vector2f(scenario.personWidth, scenario.personHeight), scenario.walkSpeed,
+        scenario.runSpeed, CROWD_RUNNERS, options.rain.maxSize, options.rain.seed);
+    PeopleBatch peopleBatch;
+    PersonSprite personSprite;
+    if (useAtlas) {
+        personSprite.setTexture(&atlas.getTexture(), atlas.getRect(SPRITE_PERSON));
     }
 
-    // Returns the total accumulated wetness
-    float getWetness() const {
-        return totalWetness;
+    // Prewarming draws from the same stream as spawning, so it stays off while recording or
+    // replaying, as with the governor
+    if (options.prewarm && (recording || replaying)) {
+        std::cerr << "Recording and replaying start from an empty sky, ignoring --prewarm" << std::endl;
+    }
+    else if (options.prewarm && !gpuRain) {
+        const sf::FloatRect bounds = person.getBounds();
+        rainSystem.prewarm(&bounds, 1);
+        startup.mark("Prewarm");
     }
 
-private:
-    sf::RectangleShape shape;
-    sf::Vector2f targetPosition;
-    float currentSpeed;
-    float totalWetness;
-    bool isMoving;
+    // Set up text for displaying wetness. The font is built in, and only loaded once the first
+    // frame is up, when the HUD is shown at all; without it the run carries on with no overlay
+    sf::Font font;
+    bool showHud = false;
+    sf::Text wetnessText = makeText(font, 24);
+    wetnessText.setFillColor(sf::Color::White);
+    wetnessText.setPosition(sf::Vector2f(10.0f, 10.0f));
+    Hud hud(wetnessText);
 
-    // Updates the color based on the current wetness
-    void updateColor() {
-        // Linearly interpolate between brown and light blue based on wetness
-        float normalizedWetness = std::min(totalWetness, MAX_WETNESS) / MAX_WETNESS;
+    // Estimates of the walk and the run in the scenario as it's edited, for the HUD
+    std::unique_ptr<WetnessPreview> preview;
+    if (options.hud && options.previewThreads > 0) {
+        preview.reset(new WetnessPreview(options, scene, integrate, options.previewThreads));
+    }
 
-        sf::Uint8 red = static_cast<sf::Uint8>(139 + normalizedWetness * (173 - 139));
-        sf::Uint8 green = static_cast<sf::Uint8>(69 + normalizedWetness * (216 - 69));
-        sf::Uint8 blue = static_cast<sf::Uint8>(19 + normalizedWetness * (230 - 19));
+    // The simulation advances in fixed steps of 1 / --sim-hz seconds. Frame time is banked in
+    // the accumulator and spent in whole steps, as many per frame as it takes
+    const float timestep = 1.0f / options.simHz;
+    float accumulator = 0.0f;
+    std::uint64_t step = 0;     // Steps taken so far, which inputs are logged against
+    std::size_t nextInput = 0;  // Next replayed input to apply
+    bool replayFinished = false;
+    sf::Clock clock;
+    Profiler profiler;
+    InputLatency latency; // W and R or their remote commands, from poll to present
 
-        shape.setFillColor(sf::Color(red, green, blue));
+    // Opening the audio device, resolving the metrics host and binding the control port can
+    // each wait on the OS, so they're started in the background and picked up by the frame
+    // loop once they're ready, the first frames going without them
+    std::unique_ptr<RainAudio> audio;
+    Deferred<RainAudio> audioStartup;
+    if (options.audioVolume > 0.0f) {
+        const float volume = options.audioVolume;
+        audioStartup.start([windowSize, volume]() {
+            return std::unique_ptr<RainAudio>(new RainAudio(windowSize, volume));
+        });
     }
-};
+    std::unique_ptr<MetricsEmitter> metrics;
+    Deferred<MetricsEmitter> metricsStartup;
+    if (!options.metricsAddress.empty()) {
+        const std::string address = options.metricsAddress;
+        metricsStartup.start([address]() {
+            std::unique_ptr<MetricsEmitter> emitter(new MetricsEmitter(address));
+            if (!emitter->isAvailable()) {
+                emitter.reset();
+            }
+            return emitter;
+        });
+    }
+    std::unique_ptr<RemoteControl> remote;
+    Deferred<RemoteControl> remoteStartup;
+    if (options.controlPort != 0) {
+        const unsigned short port = options.controlPort;
+        remoteStartup.start([port]() {
+            std::unique_ptr<RemoteControl> control(new RemoteControl(port));
+            if (!control->isAvailable()) {
+                control.reset();
+            }
+            return control;
+        });
+    }
+    std::unique_ptr<FrameCapture> capture;
+    if (!options.capturePath.empty()) {
+        capture.reset(new FrameCapture(options.capturePath, true));
+    }
+    std::unique_ptr<Telemetry> telemetry; // Written by the job, read once the last one is done
+    if (!options.telemetryPath.empty()) {
+        telemetry.reset(new Telemetry(options.telemetrySamples));
+        telemetry->addTracks(1);
+    }
+    std::unique_ptr<HitLog> hitLog; // Like the telemetry, fed by the job
+    if (!options.hitLogPath.empty() && gpuRain) {
+        std::cerr << "The GPU rain doesn't report its hits, ignoring --hit-log" << std::endl;
+    }
+    else if (!options.hitLogPath.empty()) {
+        hitLog.reset(new HitLog(options.hitLogPath, timestep));
+        hitLog->addTracks(1);
+        rainSystem.recordHits(HIT_LOG_CHUNK_HITS);
+    }
+    std::vector<TimedSpan> trace; // Every thread's spans, drained once a frame so no ring fills
+    if (!options.tracePath.empty()) {
+        trace.reserve(TRACE_MAX_SPANS);
+    }
+    const sf::Color rainColor(173, 216, 230, 200); // Light blue with transparency
+    const sf::Color waterColor(90, 140, 190, 170); // Standing water, deeper than the drops
+    sf::VertexArray groundStrip;
+    BackgroundCache background(sf::Color::Black);
 
+    // A wall of windows, each showing its own strip of the world from the same simulation, for
+    // spreading it over several monitors. The main window stays the operator's, with the HUD
+    // and the camera. SFML can only make a window fullscreen on the primary monitor, so the wall
+    // is windows placed side by side, for the desktop to span across its monitors
+    std::vector<std::unique_ptr<WallDisplay>> walls;
+    if (options.wallDisplays > 0 && gpuRain) {
+        std::cerr << "The GPU rain only draws into the main window, ignoring --wall" << std::endl;
+    }
+    else if (options.wallDisplays > 0) {
+        const float stripWidth = windowSize.x / static_cast<float>(options.wallDisplays);
+        for (unsigned i = 0; i < options.wallDisplays; ++i) {
+            const sf::FloatRect area(sf::Vector2f(i * stripWidth, 0.0f), sf::Vector2f(stripWidth, static_cast<float>(windowSize.y)));
+            const std::string wallTitle = "Rain Simulation (wall " + std::to_string(i + 1) + " of " + std::to_string(options.wallDisplays) + ")";
+            walls.emplace_back(new WallDisplay(windowSize, area, windowedMode, sf::Vector2i(static_cast<int>(i * defaultWindowWidth), 0), wallTitle,
+                options.scenePath, options.renderMode, useAtlas ? &atlas : nullptr, rainColor, waterColor));
+        }
+        (void)window.setActive(true); // Making each wall's window left its context current here
+        if (farRain) {
+            std::cerr << "The far rain is only drawn in the main window" << std::endl;
+        }
+    }
 
-int main()
-{
-    sf::VideoMode desktopMode = sf::VideoMode::getDesktopMode();
-    sf::RenderWindow window(desktopMode, "Rain Simulation", sf::Style::Fullscreen);
-    window.setFramerateLimit(60);
+    // Each frame's steps run as one job. Pipelined, the job runs on the worker while the main
+    // thread draws what the previous job left in the shown frame, so the simulation hides
+    // behind rendering at the cost of a frame of latency. The job owns the rain, the person,
+    // the splashes and the step counters while it runs; the main thread only touches them
+    // between wait() and the next start(). The GPU rain needs the window's GL context, so it
+    // always runs inline
+    FrameWorker worker(options.pipeline && !gpuRain);
+    SimFrame frames[2] = { SimFrame(options.rain.maxDrops, person), SimFrame(options.rain.maxDrops, person) };
+    SimFrame* shown = &frames[0];
+    SimFrame* pending = &frames[1];
+    CommandQueue commands;
+    double inputTime = 0.0; // Simulated time banked so far, which inputs are stamped with
+    float spawnRate = options.rain.spawnRate; // The rate last sent
+    std::unique_ptr<CommonRain> commonRain; // Touched only by the job, like the rain itself
+    if (options.commonRain && !recording && !replaying && !gpuRain) {
+        commonRain.reset(new CommonRain(options.rain.maxDrops));
+    }
 
-    bool isFullScreen = true;
-    const int defaultWindowWidth = 1280;
-    const int defaultWindowHeight = 720;
+    // Most of what's measured belongs to the job, so the report is only gathered after a wait()
+    MemoryReport memory;
+    const auto gatherMemory = [&]() {
+        memory.clear();
+        memory.add("Rain system", rainSystem.memoryUsage());
+        MemoryUsage copies = MemoryUsage();
+        for (const SimFrame& frame : frames) {
+            copies += frame.drops.memoryUsage();
+            const std::size_t splashBytes = frame.splashes.getVertexCount() * sizeof(sf::Vertex);
+            const MemoryUsage splashUsage = { splashBytes, splashBytes };
+            copies += splashUsage;
+        }
+        memory.add("Frame copies", copies);
+        memory.add("Splashes", splashes.memoryUsage());
+        memory.add("Rain batch", rainBatch.memoryUsage());
+        memory.add("Rain detail", rainDetail.memoryUsage());
+        memory.add("Background", background.memoryUsage());
+        MemoryUsage arenas = jobs.arenaUsage();
+        arenas += renderArena.memoryUsage();
+        memory.add("Frame arenas", arenas);
+        if (gpuRain) {
+            memory.add("GPU rain", gpuRain->memoryUsage());
+        }
+        if (!walls.empty()) {
+            MemoryUsage wallUsage = MemoryUsage();
+            for (const std::unique_ptr<WallDisplay>& wall : walls) {
+                wallUsage += wall->memoryUsage();
+            }
+            memory.add("Wall displays", wallUsage);
+        }
+        if (telemetry) {
+            memory.add("Telemetry", telemetry->memoryUsage());
+        }
+        if (hitLog) {
+            memory.add("Hit log", hitLog->memoryUsage());
+        }
+        if (capture) {
+            memory.add("Capture", capture->memoryUsage());
+        }
+    };
 
-    sf::Vector2u windowSize = window.getSize();
+    // Carries out an input, from the keys, the remote control or the script, at the start of
+    // the step it falls in
+    const auto applyCommand = [&](SimCommandType type, float value, SimFrame& frame) {
+        switch (type) {
+        case COMMAND_RESET:
+            person.reset(startPoint(windowSize));
+            clothing.reset();
+            if (commonRain) {
+                commonRain->restoreOrSave(rainSystem);
+            }
+            break;
+        case COMMAND_START_MOVE:
+            person.startMove(endPoint(windowSize), value);
+            ++frame.movesStarted;
+            if (recording) {
+                const ReplayInput logged = { step, value == RUN_SPEED ? REPLAY_RUN : REPLAY_WALK };
+                record.inputs.push_back(logged);
+            }
+            break;
+        case COMMAND_SPAWN_RATE:
+            rainSystem.setSpawnRate(value);
+            if (commonRain) {
+                commonRain->saved = false; // Other rain now, so the next press starts it afresh
+            }
+            break;
+        case COMMAND_PERSON_WIDTH:
+            person.setSize(sf::Vector2f(value, person.getSize().y));
+            clothing.setSize(0, person.getSize().x, person.getSize().y);
+            break;
+        case COMMAND_PERSON_HEIGHT:
+            person.setSize(sf::Vector2f(person.getSize().x, value));
+            clothing.setSize(0, person.getSize().x, person.getSize().y);
+            break;
+        case COMMAND_MAX_WETNESS:
+            person.setMaxWetness(value);
+            break;
+        case COMMAND_WIND:
+            rainSystem.setWindSpeed(value);
+            if (commonRain) {
+                commonRain->saved = false;
+            }
+            break;
+        case COMMAND_PACE:
+            person.setSpeed(value);
+            break;
+        }
+    };
 
-    // Create the rain system
-    RainSystem rainSystem(windowSize);
+    // --free-sim: rather than take the steps the frame banked, the job keeps its own clock and
+    // steps whenever a step's end has passed on it, resting in between, until the main thread
+    // wants the frame. So a main thread stuck in the window's message pump, as Windows holds it
+    // while a window is dragged, doesn't stop the rain, and the stall isn't cut out of the
+    // timeline. It needs the job on a thread of its own
+    const bool freeRunning = options.freeSim && worker.isThreaded();
+    if (options.freeSim && !freeRunning) {
+        std::cerr << "--free-sim needs the simulation pipelined on its own thread, ignoring it" << std::endl;
+    }
+    const FrameWorker::Clock::duration stepLength = std::chrono::duration_cast<FrameWorker::Clock::duration>(std::chrono::duration<double>(timestep));
+    const FrameWorker::Clock::duration maxLag = std::chrono::duration_cast<FrameWorker::Clock::duration>(std::chrono::duration<double>(MAX_FRAME_TIME));
+    const FrameWorker::Clock::duration stallLength = std::chrono::duration_cast<FrameWorker::Clock::duration>(std::chrono::duration<double>(STALL_SECONDS));
+    FrameWorker::Clock::time_point simEpoch = FrameWorker::Clock::now(); // When simulated time 0 was on that clock
+    std::uint64_t restedCycles = 0;
+    // Stalls so far. The main thread counts them, or free running the job does, and the job
+    // records them with jobStalls, set with the rest of a frame's job
+    std::uint32_t stalls = 0;
+    std::uint32_t jobStalls = 0;
+    // Returns once the next step is due, true, or the frame is wanted, false. More than
+    // STALL_SECONDS behind, after a heavy stretch or with the job not running, that's a stall,
+    // and the clock is moved up to leave only what the stall policy banks still to do
+    const auto awaitStep = [&]() {
+        for (;;) {
+            const FrameWorker::Clock::time_point now = FrameWorker::Clock::now();
+            FrameWorker::Clock::time_point due = simEpoch + stepLength * static_cast<long long>(step + 1);
+            if (now - due > stallLength) {
+                ++stalls;
+                jobStalls = stalls;
+                const FrameWorker::Clock::duration owed = options.stallPolicy == STALL_CLAMP ? FrameWorker::Clock::duration::zero()
+                    : options.stallPolicy == STALL_PAUSE ? -stepLength : std::min<FrameWorker::Clock::duration>(now - due, maxLag);
+                simEpoch += now - due - owed;
+                due = now - owed;
+            }
+            const std::uint64_t restBegun = cycleCount();
+            const bool wanted = worker.rest(due);
+            restedCycles += cycleCount() - restBegun;
+            if (wanted) {
+                return false;
+            }
+            if (FrameWorker::Clock::now() >= due) {
+                return true;
+            }
+        }
+    };
 
-    // Create the platforms
-    sf::RectangleShape startPlatform;
-    startPlatform.setSize(sf::Vector2f(200, 50));
-    startPlatform.setOrigin(100, 25);
-    startPlatform.setPosition(windowSize.x / 8.0f, windowSize.y - 250.0f);
-    startPlatform.setFillColor(sf::Color(100, 100, 100));
+    // Each frame's steps, run as one job. It's made once, here, and handed to the worker by
+    // reference, so starting it never allocates; each frame only sets how many steps it takes
+    // and which SimFrame it fills in before starting it
+    unsigned jobSteps = 0;
+    float jobAlpha = 0.0f;
+    SimFrame* jobTarget = pending;
+    const auto simulateFrame = [&]() {
+        RAINMYTH_ZONE("Simulate frame");
+        RAINMYTH_TIMED("Simulate frame");
+        const std::uint64_t jobBegun = cycleCount();
+        restedCycles = 0;
+        SimFrame& frame = *jobTarget;
+        const unsigned steps = jobSteps;
+        frame.collisionSeconds = 0.0f;
+        frame.counters = CollisionCounters();
+        frame.sounds.clear();
+        frame.movesStarted = 0;
+        splashes.beginFrame();
 
-    sf::RectangleShape endPlatform;
-    endPlatform.setSize(sf::Vector2f(200, 50));
-    endPlatform.setOrigin(100, 25);
-    endPlatform.setPosition(windowSize.x * 7.0f / 8.0f, windowSize.y - 250.0f);
-    endPlatform.setFillColor(sf::Color(100, 100, 100));
+        unsigned taken = 0;
+        for (; freeRunning ? awaitStep() : taken < steps; ++taken) {
+            // Apply the inputs made before this step ends, then whatever the script gets to
+            for (const SimCommand* command = commands.peek(); command && command->time < (step + 1) * static_cast<double>(timestep); command = commands.peek()) {
+                applyCommand(command->type, command->value, frame);
+                commands.pop();
+            }
+            if (scripted && !script.isFinished()) {
+                script.resume(step, timestep, person, [&](const ScriptAction& action) {
+                    applyCommand(commandForScript(action.type), action.value, frame);
+                });
+                if (script.isFinished()) {
+                    std::cout << "Script finished after " << step << " steps, wetness " << person.getWetness() << std::endl;
+                }
+            }
 
-    // Create the person
-    Person person(startPlatform.getPosition() - sf::Vector2f(0, -150));
+            if (replaying) {
+                if (step == replay.steps) {
+                    break; // The recording ends here; hold the last frame
+                }
+                for (; nextInput < replay.inputs.size() && replay.inputs[nextInput].step == step; ++nextInput) {
+                    applyReplayEvent(replay.inputs[nextInput].event, person, windowSize);
+                }
+            }
 
-    // Set up text for displaying wetness
-    sf::Font font;
-    if (!font.loadFromFile("Assets\\Font\\Roboto-Regular.ttf")) {
-        
-        return EXIT_FAILURE;
+            // The person moves first so the rain sweep collides against where they are now
+            const std::uint64_t stepStarted = cycleCount();
+            float caught = 0.0f;
+            person.update(timestep);
+            crowd.update(timestep, jobs);
+            if (gpuRain) {
+                gpuRain->update(timestep, person.getBounds());
+                // No landings come back from the GPU; in steady rain as many land as spawn
+                frame.sounds.landings += static_cast<std::uint32_t>(rainSystem.getSpawnRate() * windowSize.x * timestep);
+            }
+            else {
+                SurfaceWetness split = SurfaceWetness();
+                caught = rainSystem.update(timestep, person.getBounds(), &split);
+                person.addWetness(caught);
+                person.addSurfaceWetness(split);
+                if (options.clothingCapacity > 0.0f) {
+                    clothing.soak(&split);
+                }
+                crowd.collide(rainSystem.getDrops(), timestep, jobs);
+                splashes.emit(rainSystem.getImpacts());
+                frame.collisionSeconds += rainSystem.getTimings().collision;
+                frame.counters += rainSystem.getCounters();
+                frame.sounds.landings += rainSystem.getCounters().culledByScene + rainSystem.getCounters().culledOffscreen;
+                frame.sounds.addImpacts(rainSystem.getImpacts(), static_cast<float>(windowSize.x));
+                frame.sounds.personCatch += caught;
+            }
+            splashes.update(timestep);
+            ++step;
+            if (hitLog) {
+                hitLog->record(step, 0, rainSystem.getHits());
+            }
+
+            // The GPU rain's wetness only arrives once a frame, so its hit rate reads zero, and
+            // it has no collision counters
+            if (telemetry) {
+                const CollisionCounters counted = gpuRain ? CollisionCounters() : rainSystem.getCounters();
+                const TelemetrySample sample = { step * timestep, person.getPosition().x, person.getPosition().y,
+                    caught / timestep, person.getWetness(), cycleSeconds(cycleCount() - stepStarted),
+                    static_cast<std::uint32_t>(gpuRain ? gpuRain->count() : rainSystem.getDrops().count()), 0,
+                    counted.tested, counted.candidates, counted.pairs, counted.contacts, counted.hits,
+                    counted.culledByScene, counted.culledOffscreen, jobStalls };
+                telemetry->record(sample);
+            }
+        }
+        if (replaying && !replayFinished && step == replay.steps) {
+            replayFinished = true;
+            const bool matches = stateChecksum(rainSystem.getDrops(), person.getWetness()) == replay.checksum;
+            std::cout << "Replay finished after " << step << " steps: final state "
+                << (matches ? "matches" : "differs from") << " the recording" << std::endl;
+        }
+        if (gpuRain) {
+            // The only readback of the frame
+            const float caught = gpuRain->takeWetness();
+            person.addWetness(caught);
+            frame.sounds.personCatch += caught;
+        }
+
+        if (freeRunning) {
+            // Shown as far into the step that's under way as the clock is
+            const std::chrono::duration<float> into = FrameWorker::Clock::now() - (simEpoch + stepLength * static_cast<long long>(step));
+            jobAlpha = std::min(std::max(into.count() / timestep, 0.0f), 1.0f);
+        }
+
+        // Hand the results over in copies, so the next job can carry on while they're drawn
+        frame.steps = taken;
+        frame.alpha = jobAlpha;
+        frame.person = person;
+        frame.clothes = clothing.held(0);
+        frame.runoff = clothing.runoff(0);
+        if (!gpuRain) {
+            frame.drops.copyLive(rainSystem.getDrops());
+            frame.ground = rainSystem.getGroundWater();
+        }
+        splashes.build(rainColor, frame.splashes, useAtlas ? atlas.getTexCoords(SPRITE_SPLASH) : sf::FloatRect(), (1.0f - jobAlpha) * timestep);
+        frame.people.clear();
+        if (!useAtlas) {
+            appendPerson(frame.people, person.getDrawnPosition(jobAlpha), person.getSize(), person.getWetness(), person.getMaxWetness());
+        }
+        appendCrowd(frame.people, crowd, scenario.maxWetness, (1.0f - jobAlpha) * timestep);
+        frame.updateSeconds = cycleSeconds(cycleCount() - jobBegun - restedCycles);
+    };
+
+    // Steady-state frames shouldn't reach the heap at all. Allocations are counted frame by
+    // frame, and reported once the first SETTLE_FRAMES have grown every buffer to size
+    std::uint64_t allocationsBefore = allocationCount();
+    std::uint64_t frameAllocations = 0;
+    std::uint64_t settledAllocations = 0;
+    std::uint64_t frameCount = 0;
+    FrameTimes frameTimes; // Settled frames only, like the allocations
+    std::uint64_t allocatingFrames = 0;
+    // The crossing under way, from the first frame that shows the person moving, for the summary
+    // printed when they reach the end platform. A reset on the way drops it
+    RunSummary run = summaryOf(options, gpuRain ? "gpu" : "cpu", gpuRain ? "gpu" : kernelName, jobs.threadCount());
+    bool runUnderway = false;
+    sf::Clock runClock;
+    std::uint64_t liveStepsSeen = 0; // The rain's drop steps so far, to tell each frame's
+#if defined(RAINMYTH_TRACK_ALLOCATIONS)
+    ZoneAllocationWatch zoneWatch; // Names the zones behind them, in tracking builds
+#endif
+    // Inputs from outside the window reach the simulation the way the keys do, stamped with
+    // the time of the frame that picked them up
+    double eventTime = 0.0;
+    // Low power: once nobody's crossing and there's been no input for options.idleSeconds, the
+    // particles stop where they are, the far layer draws the rain over the whole screen, and
+    // frames come at IDLE_FPS; the next input brings it all back, the drops carrying on from
+    // where they stopped, so the sky is as full as it was. Only live runs that show nothing
+    // else moving, and never while the far layer's shader isn't there to stand in
+    const bool canRest = options.idleSeconds > 0.0f && !recording && !replaying && !scripted && !stress && !gpuRain && crowd.size() == 0
+        && walls.empty();
+    float quietSeconds = 0.0f;
+    bool resting = false;
+    // The scene editor drags colliders about live. The GPU rain and the wall displays build
+    // from the scene once, and recordings and replays only log its path, so it's offered
+    // only when none of them is in play
+    const bool canEdit = !recording && !replaying && !gpuRain && walls.empty();
+    SceneEditor editor(windowSize);
+    // --joystick steers the pace, and the HUD shows how fast the person is getting wet at it,
+    // over the frames since it last showed. Recordings only log walks and runs, so it's off with
+    // them
+    const bool steering = options.joystick && !recording && !replaying;
+    if (options.joystick && !steering) {
+        std::cerr << "Recordings and replays only know walks and runs, ignoring --joystick" << std::endl;
     }
-    sf::Text wetnessText;
-    wetnessText.setFont(font);
-    wetnessText.setCharacterSize(24);
-    wetnessText.setFillColor(sf::Color::White);
-    wetnessText.setPosition(10.0f, 10.0f);
+    PaceStick stick(STICK_TOP_PACE * scenario.runSpeed);
+    float stickPace = 0.0f;
+    double paceCaught = 0.0;
+    float paceSeconds = 0.0f;
+    float wetnessRate = 0.0f;
+    // --storm sets the spawn rate and the wind the way Up, Down and the remote do, so it's off
+    // where they are
+    StormTrack storm;
+    const bool storming = !options.stormPath.empty() && !recording && !replaying && !gpuRain && storm.open(options.stormPath);
+    if (!options.stormPath.empty() && (recording || replaying || gpuRain)) {
+        std::cerr << "Recordings, replays and the GPU rain keep the rain they started with, ignoring --storm" << std::endl;
+    }
+    const bool stormWind = storming && rainSystem.canSetWind();
+    if (storming && !stormWind) {
+        std::cerr << "Column buckets and coarse steps need calm air, so the storm's wind is left out" << std::endl;
+    }
+    StormSample stormSent = StormSample();
+    double stormNext = 0.0; // The storm's next whole second to send
+    bool stormStarted = false;
+    bool stormFinished = false;
+    bool simulated = false; // Whether a job was started last frame, and so has results to show
 
-    sf::Clock clock;
+    const auto send = [&](SimCommandType type, float value) {
+        quietSeconds = 0.0f;
+        const SimCommand command = { type, eventTime, value };
+        if (!commands.push(command)) {
+            std::cerr << "Input queue full, dropping an input" << std::endl;
+        }
+    };
+
+    // Housekeeping runs in what's left of each frame once it's been displayed, see IdleTasks.h,
+    // with how many frames in a row each can be put off. Remote commands go through the same
+    // queue as the keys, with the same limits, and a controller that hasn't sent a whole line
+    // yet is simply looked at again next time
+    IdleTasks idle;
+    idle.add([&](float) {
+        if (remote) {
+            RAINMYTH_ZONE("Remote control");
+            remote->receive();
+            RemoteCommand command;
+            while (remote->next(command)) {
+                const bool rainCommand = command.type == REMOTE_SPAWN_RATE || command.type == REMOTE_RAIN || command.type == REMOTE_WIND;
+                if (replaying && (command.type == REMOTE_WALK || command.type == REMOTE_RUN || rainCommand)) {
+                    remote->reply("a replay is playing");
+                    continue;
+                }
+                if (rainCommand && (recording || gpuRain)) {
+                    remote->reply(recording ? "recordings don't log the rain" : "the GPU rain can't change");
+                    continue;
+                }
+                switch (command.type) {
+                case REMOTE_WALK:
+                case REMOTE_RUN:
+                    send(COMMAND_RESET, 0.0f);
+                    send(COMMAND_START_MOVE, command.type == REMOTE_WALK ? scenario.walkSpeed : scenario.runSpeed);
+                    latency.pressed();
+                    break;
+                case REMOTE_RESET:
+                    send(COMMAND_RESET, 0.0f);
+                    break;
+                case REMOTE_SPAWN_RATE:
+                case REMOTE_RAIN: {
+                    RainConfig rain = options.rain;
+                    rain.rainIntensity = command.value;
+                    spawnRate = command.type == REMOTE_RAIN ? spawnRateFor(rain) : std::max(command.value, 0.0f);
+                    send(COMMAND_SPAWN_RATE, spawnRate);
+                    break;
+                }
+                case REMOTE_WIND:
+                    if (!rainSystem.canSetWind()) {
+                        remote->reply("column buckets and coarse steps need calm air");
+                        continue;
+                    }
+                    send(COMMAND_WIND, command.value);
+                    break;
+                case REMOTE_PERSON_WIDTH:
+                    send(COMMAND_PERSON_WIDTH, command.value);
+                    break;
+                case REMOTE_PERSON_HEIGHT:
+                    send(COMMAND_PERSON_HEIGHT, command.value);
+                    break;
+                case REMOTE_MAX_WETNESS:
+                    send(COMMAND_MAX_WETNESS, command.value);
+                    break;
+                }
+                remote->reply(nullptr);
+            }
+        }
+    }, 3);
+    // An edited scenario file goes to the simulation like any other input. Only what changed
+    // is sent, so a save doesn't undo a rate set with Up and Down
+    idle.add([&](float seconds) {
+        const Scenario previous = scenario;
+        if (watcher.poll(seconds, scenario)) {
+            std::cout << "Reloaded " << options.scenarioPath << std::endl;
+            if (scenario.spawnRate != previous.spawnRate && !gpuRain) {
+                spawnRate = scenario.spawnRate;
+                send(COMMAND_SPAWN_RATE, spawnRate);
+            }
+            if (scenario.personWidth != previous.personWidth) {
+                send(COMMAND_PERSON_WIDTH, scenario.personWidth);
+            }
+            if (scenario.personHeight != previous.personHeight) {
+                send(COMMAND_PERSON_HEIGHT, scenario.personHeight);
+            }
+            if (scenario.maxWetness != previous.maxWetness) {
+                send(COMMAND_MAX_WETNESS, scenario.maxWetness);
+            }
+        }
+    }, 30);
+    // The storm is read a simulated second at a time as the banked time reaches it, and only
+    // what changed is sent. However far a stall carried the clock, one sample catches up
+    idle.add([&](float) {
+        if (!storming || inputTime < stormNext) {
+            return;
+        }
+        const double second = std::floor(inputTime);
+        const StormSample sample = storm.at(second);
+        stormNext = second + 1.0;
+        if (!stormStarted || sample.mmPerHour != stormSent.mmPerHour) {
+            RainConfig rain = options.rain;
+            rain.rainIntensity = sample.mmPerHour;
+            spawnRate = spawnRateFor(rain);
+            send(COMMAND_SPAWN_RATE, spawnRate);
+        }
+        if (stormWind && (!stormStarted || sample.wind != stormSent.wind)) {
+            send(COMMAND_WIND, sample.wind);
+        }
+        if (storm.isFinished() && !stormFinished) {
+            std::cout << "Storm " << options.stormPath << " finished after " << second << " s, holding its last rain" << std::endl;
+        }
+        stormStarted = true;
+        stormFinished = storm.isFinished();
+        stormSent = sample;
+        stormSent.time = second;
+    }, 30);
+    // The preview follows the spawn rate as it's changed and the scenario as its file is edited,
+    // starting over only when either moves
+    idle.add([&](float) {
+        if (preview) {
+            Crossing walk = defaultCrossing(options, scenario.walkSpeed);
+            walk.rain.spawnRate = spawnRate;
+            walk.personWidth = scenario.personWidth;
+            walk.personHeight = scenario.personHeight;
+            Crossing run = walk;
+            run.speed = scenario.runSpeed;
+            preview->follow(walk, run);
+        }
+    }, 30);
+    idle.add([&](float) {
+        if (metrics && metrics->isDue()) {
+            metrics->send(profiler, gpuRain ? gpuRain->count() : shown->drops.count(), shown->person.getWetness());
+        }
+    }, 30);
+    // Update the wetness text and the profiler overlay, a few times a second. Phase times are
+    // smoothed over the last few frames
+    idle.add([&](float seconds) {
+        if (showHud && hud.begin(seconds)) {
+            hud.text("Total Wetness: ");
+            hud.number(shown->person.getWetness(), 2);
+            if (!gpuRain) {
+                const SurfaceWetness& split = shown->person.getSurfaceWetness();
+                hud.text("\n  Top ");
+                hud.number(split.top, 2);
+                hud.text(", front ");
+                hud.number(split.front, 2);
+                hud.text(", back ");
+                hud.number(split.back, 2);
+                if (options.clothingCapacity > 0.0f) {
+                    hud.text("\n  Clothes hold ");
+                    hud.number(shown->clothes.total(), 2);
+                    hud.text(", ran off ");
+                    hud.number(shown->runoff, 2);
+                }
+            }
+            if (preview) {
+                const char* const names[] = { "\nExpected walk ", ", run " };
+                for (std::size_t which = 0; which < 2; ++which) {
+                    const PreviewReading reading = preview->reading(which);
+                    hud.text(names[which]);
+                    if (reading.trials == 0) {
+                        hud.number(reading.analytic.total(), 2);
+                        hud.text(" (flux model)");
+                        continue;
+                    }
+                    hud.number(static_cast<float>(reading.mean), 2);
+                    hud.text(" +/- ");
+                    hud.number(static_cast<float>(reading.halfWidth), 2);
+                    hud.text(" (");
+                    hud.number(reading.trials);
+                    hud.text(reading.trials == 1 ? " trial)" : " trials)");
+                }
+            }
+            hud.text("\nFrame: ");
+            hud.number(profiler.frameMilliseconds(), 2);
+            hud.text(" ms\n  Update: ");
+            hud.number(profiler.milliseconds(PHASE_UPDATE), 2);
+            hud.text(worker.isThreaded() ? " ms on the worker (collision " : " ms (collision ");
+            hud.number(profiler.milliseconds(PHASE_COLLISION), 2);
+            hud.text(" ms CPU)\n  Build: ");
+            hud.number(profiler.milliseconds(PHASE_BUILD), 2);
+            hud.text(" ms\n  Draw: ");
+            hud.number(profiler.milliseconds(PHASE_DRAW), 2);
+            hud.text(" ms\n  Display: ");
+            hud.number(profiler.milliseconds(PHASE_DISPLAY), 2);
+            hud.text(" ms\nDrops: ");
+            hud.number(gpuRain ? gpuRain->count() : shown->drops.count());
+            if (!gpuRain) {
+                // Over the frame's steps: how many drops the broadphase gets down to, and how
+                // many of the rest landed instead
+                const CollisionCounters& counted = shown->counters;
+                hud.text("\n  Tested ");
+                hud.number(static_cast<std::size_t>(counted.tested));
+                hud.text(", near ");
+                hud.number(static_cast<std::size_t>(counted.candidates));
+                hud.text(", pairs ");
+                hud.number(static_cast<std::size_t>(counted.pairs));
+                hud.text(", contacts ");
+                hud.number(static_cast<std::size_t>(counted.contacts));
+                hud.text(", hits ");
+                hud.number(static_cast<std::size_t>(counted.hits));
+                hud.text("\n  Landed on the scene ");
+                hud.number(static_cast<std::size_t>(counted.culledByScene));
+                hud.text(", on the ground ");
+                hud.number(static_cast<std::size_t>(counted.culledOffscreen));
+            }
+            const MemoryUsage used = memory.total();
+            hud.text("\nMemory: ");
+            hud.number(used.reserved / (1024.0f * 1024.0f), 1);
+            hud.text(" MB reserved, ");
+            hud.number(used.used / (1024.0f * 1024.0f), 1);
+            hud.text(" MB used\nAllocations: ");
+            hud.number(static_cast<std::size_t>(frameAllocations));
+            hud.text(" last frame");
+            if (latency.count() > 0) {
+                hud.text("\nInput latency: ");
+                hud.number(latency.lastMilliseconds(), 1);
+                hud.text(" ms");
+            }
+            if (governor.isEnabled()) {
+                hud.text("\nQuality: ");
+                hud.number(governor.getLevel() * 100.0f, 0);
+                hud.text("%");
+            }
+            if (steering) {
+                if (paceSeconds > 0.0f) {
+                    wetnessRate = static_cast<float>(paceCaught / paceSeconds);
+                    paceCaught = 0.0;
+                    paceSeconds = 0.0f;
+                }
+                hud.text("\nPace: ");
+                hud.number(stickPace, 0);
+                hud.text(" px/s, wetting ");
+                hud.number(wetnessRate, 2);
+                hud.text(" a second");
+                if (stickPace > 0.0f) {
+                    hud.text(", ");
+                    hud.number(wetnessRate / stickPace * 100.0f, 2);
+                    hud.text(" per 100 px");
+                }
+            }
+            if (storming) {
+                hud.text("\nStorm: ");
+                hud.number(stormSent.mmPerHour, 1);
+                hud.text(" mm/h, wind ");
+                hud.number(stormSent.wind / 100.0f, 1);
+                hud.text(" m/s at ");
+                hud.number(static_cast<std::size_t>(stormSent.time));
+                hud.text(stormFinished ? " s, finished" : " s");
+            }
+            if (editor.isOn()) {
+                hud.text("\nEditing the scene: drag colliders, S saves, E stops");
+            }
+            hud.end();
+        }
+    }, 15);
+
+    startup.mark("Logs, walls and frame state");
 
     while (window.isOpen())
     {
-        float deltaTime = clock.restart().asSeconds();
+        const FramePacer::Clock::time_point frameBegun = FramePacer::Clock::now();
+        const std::uint64_t allocationsNow = allocationCount();
+        frameAllocations = allocationsNow - allocationsBefore;
+        allocationsBefore = allocationsNow;
+        if (++frameCount > SETTLE_FRAMES && frameAllocations > 0) {
+            settledAllocations += frameAllocations;
+            ++allocatingFrames;
+        }
+#if defined(RAINMYTH_TRACK_ALLOCATIONS)
+        zoneWatch.endFrame(frameCount > SETTLE_FRAMES, std::cerr);
+#endif
+        renderArena.reset();
 
-        sf::Event event;
-        while (window.pollEvent(event))
-        {
-            if (event.type == sf::Event::Closed)
+        // Don't try to catch up on more than MAX_FRAME_TIME after a hitch
+        const float frameTime = clock.restart().asSeconds();
+        if (frameCount > SETTLE_FRAMES) {
+            frameTimes.add(frameTime, profiler);
+        }
+        if (runUnderway) {
+            run.frames.add(frameTime);
+        }
+        if (stress) {
+            const float nextRate = stress->addFrame(frameTime, frameTime - profiler.frameSeconds(PHASE_DISPLAY), shown->drops.count());
+            if (nextRate >= 0.0f) {
+                spawnRate = nextRate;
+                send(COMMAND_SPAWN_RATE, spawnRate);
+            }
+            if (stress->isFinished()) {
                 window.close();
+            }
+        }
+        profiler.endFrame(frameTime);
+        if (!freeRunning) {
+            stalls += frameTime > STALL_SECONDS ? 1 : 0;
+            accumulator += stallBanked(options.stallPolicy, frameTime, timestep);
+        }
 
-            if (event.type == sf::Event::KeyPressed) {
-                // Toggle fullscreen
-                if (event.key.code == sf::Keyboard::Escape)
-                {
+        // This frame's events happened some time since the last frame, so they're stamped with the
+        // start of that interval, the earliest they might have been. Free running, the
+        // simulation is already past that, so they go to its next step
+        eventTime = freeRunning ? 0.0 : inputTime;
+        inputTime += stallBanked(options.stallPolicy, frameTime, timestep);
+
+        {
+            RAINMYTH_ZONE("Poll events");
+            WindowEvent event;
+            while (pollWindowEvent(window, event))
+            {
+                if (event.type == WINDOW_CLOSED)
                     window.close();
 
+                if (event.type == WINDOW_RESIZED) {
+                    window.setView(worldView(windowSize, window.getSize()));
                 }
 
-                // Start the simulation with 'W' for walk or 'R' for run
-                if (event.key.code == sf::Keyboard::W) {
-                    person.reset(startPlatform.getPosition() + sf::Vector2f(0, -150));
-                    person.startMove(endPlatform.getPosition() + sf::Vector2f(0, -150), WALK_SPEED);
+                if (event.type == WINDOW_KEY_PRESSED) {
+                    quietSeconds = 0.0f;
+                    if (event.key == sf::Keyboard::Key::Escape)
+                    {
+                        window.close();
+
+                    }
+
+                    // Toggle fullscreen. The new window shares every GL resource with the old one,
+                    // so the rain, the batches and the caches carry on; only what belongs to the window
+                    // itself, the view and the pacing, is set again. The GPU rain's framebuffer
+                    // lives in the window's own context and wouldn't survive the switch
+                    if (event.key == sf::Keyboard::Key::F11 && gpuRain) {
+                        std::cerr << "The GPU rain can't move to a new window, so F11 is off with --gpu" << std::endl;
+                    }
+                    else if (event.key == sf::Keyboard::Key::F11) {
+                        isFullScreen = !isFullScreen;
+                        createWindow(window, isFullScreen ? desktopMode : windowedMode, title, isFullScreen);
+                        pacer.attach(window);
+                        rainBatch.contextChanged();
+                        window.setView(worldView(windowSize, window.getSize()));
+                    }
+
+                    // Start the simulation with 'W' for walk or 'R' for run. A replay ignores them
+                    // and plays back the recorded presses instead. They reach the person through the
+                    // command queue, so this never waits on the simulation
+                    if (!replaying && (event.key == sf::Keyboard::Key::W || event.key == sf::Keyboard::Key::R)) {
+                        send(COMMAND_RESET, 0.0f);
+                        send(COMMAND_START_MOVE, event.key == sf::Keyboard::Key::W ? scenario.walkSpeed : scenario.runSpeed);
+                        latency.pressed();
+                    }
+
+                    // Up and Down make the rain heavier or lighter. Recordings don't log the rate, and
+                    // the GPU rain keeps a fixed population, so it's only offered when neither is in play
+                    if (!recording && !replaying && !gpuRain && (event.key == sf::Keyboard::Key::Up || event.key == sf::Keyboard::Key::Down)) {
+                        spawnRate *= event.key == sf::Keyboard::Key::Up ? 1.25f : 0.8f;
+                        send(COMMAND_SPAWN_RATE, spawnRate);
+                    }
+
+                    // + and - zoom in on the person and out, Left, Right, Page Up and Page Down pan
+                    // away from them, and Home goes back to the whole world. The GPU rain draws
+                    // straight to the window, ignoring the view, so the camera stays put with it
+                    const bool zoomKey = event.key == sf::Keyboard::Key::Equal || event.key == sf::Keyboard::Key::Add
+                        || event.key == sf::Keyboard::Key::Hyphen || event.key == sf::Keyboard::Key::Subtract;
+                    const bool panKey = event.key == sf::Keyboard::Key::Left || event.key == sf::Keyboard::Key::Right
+                        || event.key == sf::Keyboard::Key::PageUp || event.key == sf::Keyboard::Key::PageDown;
+                    if (gpuRain && (zoomKey || panKey)) {
+                        std::cerr << "The GPU rain ignores the view, so the camera is off with --gpu" << std::endl;
+                    }
+                    else if (zoomKey) {
+                        const bool in = event.key == sf::Keyboard::Key::Equal || event.key == sf::Keyboard::Key::Add;
+                        camera.zoom(in ? CAMERA_ZOOM_STEP : 1.0f / CAMERA_ZOOM_STEP);
+                    }
+                    else if (panKey) {
+                        const float across = event.key == sf::Keyboard::Key::Left ? -1.0f : event.key == sf::Keyboard::Key::Right ? 1.0f : 0.0f;
+                        const float down = event.key == sf::Keyboard::Key::PageUp ? -1.0f : event.key == sf::Keyboard::Key::PageDown ? 1.0f : 0.0f;
+                        camera.pan(sf::Vector2f(across, down) * CAMERA_PAN_STEP);
+                    }
+                    if (event.key == sf::Keyboard::Key::Home) {
+                        camera.reset();
+                    }
+
+                    // E turns the scene editor on and off. While it's on, the left button drags
+                    // colliders and S writes the scene out, to the --scene file if there is one
+                    if (event.key == sf::Keyboard::Key::E && !canEdit) {
+                        std::cerr << "Recordings, replays, the GPU rain and wall displays keep the scene they started with, so E is off" << std::endl;
+                    }
+                    else if (event.key == sf::Keyboard::Key::E) {
+                        editor.toggle();
+                        std::cout << (editor.isOn() ? "Editing the scene: drag colliders with the mouse, S saves" : "Stopped editing the scene") << std::endl;
+                    }
+                    if (editor.isOn() && event.key == sf::Keyboard::Key::S) {
+                        const std::string path = options.scenePath.empty() ? "Scene.txt" : options.scenePath;
+                        if (scene.saveToFile(path)) {
+                            std::cout << "Saved the scene to " << path << std::endl;
+                        }
+                    }
                 }
-                if (event.key.code == sf::Keyboard::R) {
-                    person.reset(startPlatform.getPosition() + sf::Vector2f(0, -150));
-                    person.startMove(endPlatform.getPosition() + sf::Vector2f(0, -150), RUN_SPEED);
+
+                // The pointer is mapped through the view the last frame was drawn with, the one
+                // on screen
+                if (editor.isOn() && event.type == WINDOW_MOUSE_PRESSED) {
+                    quietSeconds = 0.0f;
+                    editor.press(scene, window.mapPixelToCoords(event.mouse));
+                }
+                else if (event.type == WINDOW_MOUSE_MOVED) {
+                    editor.drag(window.mapPixelToCoords(event.mouse));
+                }
+                else if (event.type == WINDOW_MOUSE_RELEASED) {
+                    editor.release();
                 }
             }
         }
 
-        // --- Simulation Logic ---
-        rainSystem.update(deltaTime);
-        person.update(deltaTime);
+        // Once a frame, after the events SFML updates joysticks with. Only what changed is sent
+        if (steering) {
+            const StickReading reading = stick.sample();
+            stickPace = reading.pace;
+            if (reading.reset) {
+                send(COMMAND_RESET, 0.0f);
+            }
+            if (reading.start) {
+                send(COMMAND_RESET, 0.0f);
+                send(COMMAND_START_MOVE, reading.pace);
+                latency.pressed();
+            }
+            else if (reading.paceChanged) {
+                send(COMMAND_PACE, reading.pace);
+            }
+        }
+
+        // What was started in the background joins in as it comes up
+        if (audioStartup.pending() && (audio = audioStartup.take())) {
+            startup.ready("Audio");
+        }
+        if (metricsStartup.pending() && (metrics = metricsStartup.take())) {
+            startup.ready("Metrics");
+        }
+        if (remoteStartup.pending() && (remote = remoteStartup.take())) {
+            startup.ready("Remote control");
+        }
 
-        // Check for collisions between raindrops and the person
-        sf::FloatRect personBounds = person.getBounds();
-        for (const auto& drop : rainSystem.getDrops()) {
-            if (personBounds.intersects(drop.getBounds())) {
-                person.addWetness(drop.getArea());
+        // The walls finish drawing the shown frame before it's handed back to the simulation
+        if (!walls.empty()) {
+            RAINMYTH_ZONE("Wait for walls");
+            for (const std::unique_ptr<WallDisplay>& wall : walls) {
+                wall->wait();
+                if (!wall->pollEvents()) {
+                    window.close();
+                }
             }
         }
 
-        // Check if the person is under a platform and should not get wet
-        if (startPlatform.getGlobalBounds().intersects(personBounds) || endPlatform.getGlobalBounds().intersects(personBounds)) {
+        // Collect the last job and show what it left
+        {
+            RAINMYTH_ZONE("Wait for simulation");
+            worker.wait();
+        }
+        jobs.resetArenas();
+        if (simulated) {
+            std::swap(shown, pending);
+            profiler.add(PHASE_UPDATE, shown->updateSeconds);
+            profiler.add(PHASE_COLLISION, shown->collisionSeconds);
+            paceCaught += shown->sounds.personCatch;
+            paceSeconds += shown->steps * timestep;
 
+            const std::uint64_t liveSteps = rainSystem.getLifetimes().liveSteps;
+            const std::uint64_t dropSteps = gpuRain ? static_cast<std::uint64_t>(gpuRain->count()) * shown->steps
+                : liveSteps >= liveStepsSeen ? liveSteps - liveStepsSeen : liveSteps; // All of them after a reset
+            liveStepsSeen = liveSteps;
+            const bool moving = shown->person.isMovingToTarget();
+            if (moving && !runUnderway) {
+                runUnderway = true;
+                run.steps = 0;
+                run.dropSteps = 0;
+                run.frames = DurationHistogram();
+                runClock.restart();
+            }
+            if (runUnderway) {
+                run.steps += shown->steps;
+                run.dropSteps += dropSteps;
+            }
+            if (!moving && runUnderway) {
+                runUnderway = false;
+                if (shown->person.getPosition() == endPoint(windowSize)) {
+                    run.wallSeconds = runClock.getElapsedTime().asSeconds();
+                    run.peakMemory = peakResidentMemory();
+                    // The simulation is idle until the next frame starts, so the crowd can be read
+                    run.wetness.assign(1, shown->person.getWetness());
+                    run.wetness.insert(run.wetness.end(), crowd.wetness.begin(), crowd.wetness.end());
+                    run.print(std::cout);
+                    if (!options.summaryPath.empty()) {
+                        run.append(options.summaryPath);
+                    }
+                }
+            }
+        }
+        if (showHud) {
+            gatherMemory();
+        }
+        if (resting) {
+            farRain->update(std::min(frameTime, MAX_FRAME_TIME));
+        }
+        else if (drawFarRain || drawDepthRain) {
+            farRain->update(shown->steps * timestep);
+        }
+        if (canRest) {
+            quietSeconds = shown->person.isMovingToTarget() ? 0.0f : quietSeconds + frameTime;
+            const bool rest = quietSeconds >= options.idleSeconds && farRain->isAvailable();
+            if (rest != resting) {
+                resting = rest;
+                pacer.throttle(window, resting ? IDLE_FPS : 0.0f);
+                farRain->setNearBand(resting ? 0.0f : farBand.x, resting ? 0.0f : farBand.y);
+                accumulator = 0.0f; // Nothing to catch up on either way
+            }
         }
 
-        // Update the wetness text
-        //std::stringstream ss;
-        //ss << "Total Wetness: " << std::fixed << std::setprecision(2) << person.getWetness();
-        //wetnessText.setString(ss.str());
+        // The simulation is idle until the next start, so this is where its settings may change
+        if (farRain && farRain->isCompiling()) {
+            farRain->poll();
+            if (!farRain->isCompiling()) {
+                useFarRain();
+                startup.ready("Far rain shader");
+            }
+        }
+        if (governor.update(profiler.frameMilliseconds(), profiler.frameMilliseconds() - profiler.milliseconds(PHASE_DISPLAY))) {
+            const float level = governor.getLevel();
+            rainSystem.setOuterDensity(fullBand.x, fullBand.y, level);
+            rainBatch.setStreaks(options.streakExposure * level, options.streakPersistence);
+            splashes.setBudget(static_cast<std::size_t>(options.splashBudget * level));
+        }
+        // A dragged collider moves once a frame, to where the pointer last was. The rain redoes
+        // its shadow over the columns that changed, the scene's vertex buffer that collider's
+        // quad, and the background is drawn again; the near band follows it
+        std::size_t movedCollider = 0;
+        sf::FloatRect movedFrom;
+        if (editor.apply(scene, movedCollider, movedFrom)) {
+            RAINMYTH_ZONE("Move collider");
+            rainSystem.moveCollider(scene, movedCollider, movedFrom);
+            background.invalidate();
+            if (drawFarRain) {
+                farBand = nearBand(windowSize, scene, sf::Vector2f(scenario.personWidth, scenario.personHeight), options.rain.maxSize);
+                rainSystem.setSpawnBand(farBand.x, farBand.y);
+                if (!resting) {
+                    farRain->setNearBand(farBand.x, farBand.y);
+                }
+            }
+        }
 
-        // Clear the window
-        window.clear(sf::Color::Black);
+        // --- Simulation Logic ---
+        simulated = !resting;
+        if (simulated) {
+            if (!freeRunning) {
+                const unsigned steps = static_cast<unsigned>(accumulator / timestep);
+                accumulator -= steps * timestep;
+                jobSteps = steps;
+                jobAlpha = accumulator / timestep; // How far we'll be into the next step
+                jobStalls = stalls;
+            }
+            jobTarget = pending;
+            worker.start(std::ref(simulateFrame));
+            if (!worker.isThreaded()) {
+                std::swap(shown, pending); // Ran inline, so its results are this frame's
+            }
+        }
+        else {
+            accumulator = 0.0f;
+        }
 
+        // Everything is drawn as far between the shown frame's last two steps as that frame's
+        // alpha says, rather than at the last step, so physics running slower than the display
+        // doesn't judder. Pipelined, that's the alpha of the frame before, which goes with its
+        // steps
+        const float alpha = shown->alpha;
+        const float lag = (1.0f - alpha) * timestep;
+
+        // The walls draw the same frame on their own threads while this one draws the main window
+        if (!walls.empty()) {
+            const WallFrame wallFrame = { &shown->drops, &shown->splashes, &shown->ground, &shown->person, alpha, lag };
+            for (const std::unique_ptr<WallDisplay>& wall : walls) {
+                wall->show(wallFrame);
+            }
+        }
+
+        if (audio) {
+            const sf::FloatRect bounds = shown->person.getBounds();
+            audio->update(shown->sounds, frameTime, sf::Vector2f(rectLeft(bounds) + rectWidth(bounds) / 2.0f, rectTop(bounds) + rectHeight(bounds) / 2.0f));
+        }
+        if (metrics) {
+            metrics->addFrame(frameTime);
+        }
         // --- Rendering Logic ---
-        window.draw(startPlatform);
-        window.draw(endPlatform);
-        rainSystem.draw(window);
-        person.draw(window);
-        window.draw(wetnessText);
+        {
+            ScopedTimer timer(profiler, PHASE_BUILD);
+            RAINMYTH_ZONE("Build");
+            if (!gpuRain && !resting) {
+                // Only the presented state is ever turned into vertices, however many steps ran,
+                // and only the drops in view
+                window.setView(camera.view(window.getSize(), shown->person.getDrawnPosition(alpha)));
+                const sf::FloatRect inView = viewBounds(window.getView());
+                const float pixelsPerUnit = camera.pixelsPerUnit(window.getSize());
+                detail = rainDetailFor(pixelsPerUnit);
+                if (detail == DETAIL_TILES) {
+                    rainDetail.buildTiles(shown->drops, rainColor, inView, DENSITY_TILE_PIXELS / pixelsPerUnit, lag);
+                }
+                else if (detail == DETAIL_STREAKS) {
+                    rainDetail.buildStreaks(shown->drops, rainColor, inView, options.streakExposure, lag);
+                }
+                else {
+                    rainBatch.setVisibleArea(inView);
+                    rainBatch.setDropPixels(options.rain.maxSize * pixelsPerUnit * governor.getLevel());
+                    rainBatch.build(shown->drops, rainColor, lag);
+                }
+            }
+        }
+        {
+            ScopedTimer timer(profiler, PHASE_DRAW);
+            RAINMYTH_ZONE("Draw");
+            background.draw(window, scene); // In place of clearing the window
+            if (drawDepthRain) {
+                farRain->drawDepth(window, rainColor, lag);
+            }
+            if (drawFarRain || resting) {
+                farRain->draw(window, rainColor, lag);
+            }
+            if (resting) {
+                // The far layer has the whole screen
+            }
+            else if (gpuRain) {
+                gpuRain->draw(rainColor);
+            }
+            else if (detail != DETAIL_DROPS) {
+                rainDetail.draw(window);
+            }
+            else {
+                rainBatch.draw(window);
+            }
+            if (!gpuRain) {
+                shown->ground.build(groundStrip, static_cast<float>(windowSize.y), waterColor);
+                window.draw(groundStrip);
+            }
+            if (!resting) {
+                window.draw(shown->splashes, useAtlas ? &atlas.getTexture() : nullptr); // Resting, they'd hang in the air
+            }
+            peopleBatch.draw(window, shown->people);
+            if (useAtlas) {
+                personSprite.draw(window, shown->person, alpha);
+            }
+            if (showHud) {
+                // The HUD is sized in window pixels, so it reads the same on any display
+                const sf::View view = window.getView();
+                window.setView(window.getDefaultView());
+                window.draw(wetnessText);
+                window.setView(view);
+            }
+        }
+
+        if (capture) {
+            RAINMYTH_ZONE("Capture");
+            capture->capture(window);
+        }
+        {
+            ScopedTimer timer(profiler, PHASE_DISPLAY);
+            RAINMYTH_ZONE("Display");
+            const FramePacer::Clock::duration work = FramePacer::Clock::now() - frameBegun;
+            window.display();
+            {
+                RAINMYTH_ZONE("Housekeeping");
+                idle.run(pacer.spareUntil(work));
+                if (!options.tracePath.empty() && trace.size() < TRACE_MAX_SPANS) {
+                    drainSpans(trace);
+                }
+            }
+            pacer.wait();
+        }
+        const float pressLatency = latency.presented(shown->movesStarted);
+        if (metrics && pressLatency >= 0.0f) {
+            metrics->addInputLatency(pressLatency);
+        }
+        if (frameCount == 1) {
+            startup.mark("First frame");
+            if (options.hud) {
+                showHud = openFont(font, ROBOTO_REGULAR_TTF, ROBOTO_REGULAR_TTF_SIZE);
+                if (!showHud) {
+                    std::cerr << "Couldn't load the HUD font, running without the HUD" << std::endl;
+                }
+                startup.mark("HUD font");
+            }
+        }
+        RAINMYTH_FRAME();
+    }
+    for (const std::unique_ptr<WallDisplay>& wall : walls) {
+        wall->wait();
+    }
+    worker.wait();
+    gatherMemory();
+    capture.reset(); // While the window's context is still current
 
-        window.display();
+    const RainField& drops = rainSystem.getDrops();
+    if (recording) {
+        record.steps = step;
+        record.checksum = stateChecksum(drops, person.getWetness());
+        if (writeReplay(options.recordPath, record)) {
+            std::cout << "Recorded " << step << " steps to " << options.recordPath << std::endl;
+        }
+    }
+    if (telemetry && telemetry->write(options.telemetryPath)) {
+        std::cout << "Wrote " << telemetry->size() << " telemetry samples to " << options.telemetryPath << std::endl;
+    }
+    if (!options.tracePath.empty()) {
+        drainSpans(trace);
+        if (writeTrace(options.tracePath, trace)) {
+            std::cout << "Wrote " << trace.size() << " spans to " << options.tracePath;
+            if (droppedSpans() > 0) {
+                std::cout << " (" << droppedSpans() << " dropped when a thread's ring filled)";
+            }
+            std::cout << std::endl;
+        }
+    }
+    if (hitLog && rainSystem.lostHitCount() > 0) {
+        std::cerr << rainSystem.lostHitCount() << " hits didn't fit in the hit log's rows and weren't logged" << std::endl;
+    }
+    hitLog.reset();
+    std::cout << "Drop pool high-water mark: " << drops.highWaterMark() << " of " << drops.capacity()
+        << " (" << drops.rejectedCount() << " spawns rejected)" << std::endl;
+    if (stalls > 0) {
+        static const char* const policies[] = { "caught up on", "clamped to a step", "paused" };
+        std::cout << stalls << " frames stalled, longer than " << STALL_SECONDS * 1000.0f << " ms, and were "
+            << policies[options.stallPolicy] << std::endl;
+    }
+    if (options.dropLifetimes) {
+        rainSystem.getLifetimes().print(std::cout);
+    }
+    if (crowd.size() > 0) {
+        crowd.print(std::cout);
+    }
+    memory.print(std::cout);
+    frameTimes.print(std::cout);
+    if (stress) {
+        stress->print(std::cout, kernelName, renderModeName(rainBatch.renderMode()));
+    }
+    latency.print(std::cout);
+    if (frameCount > SETTLE_FRAMES) {
+        std::cout << "Heap allocations after the first " << SETTLE_FRAMES << " frames: " << settledAllocations << " in "
+            << allocatingFrames << " of " << frameCount - SETTLE_FRAMES << " frames" << std::endl;
+#if defined(RAINMYTH_TRACK_ALLOCATIONS)
+        zoneWatch.print(std::cout);
+#endif
     }
 
     return 0;
@@ -0,0 +1,116 @@
+#include "RainMythApi.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Constants.h"
+#include "Headless.h"
+#include "JobSystem.h"
+#include "Options.h"
+#include "RainKernels.h"
+#include "Scene.h"
+
+struct RainMythSimulator {
+    Options options;
+    Scene scene;
+    IntegrateKernel integrate;
+    std::unique_ptr<JobSystem> jobs;
+};
+
+RainMythSimulator* rainmyth_create(int argc, const char* const* argv) {
+    try {
+        // parseOptions wants a program name first and writable strings
+        std::vector<std::string> arguments(1, "RainMythApi");
+        for (int i = 0; i < argc; ++i) {
+            arguments.push_back(argv[i] ? argv[i] : "");
+        }
+        std::vector<char*> pointers;
+        for (std::string& argument : arguments) {
+            pointers.push_back(&argument[0]);
+        }
+
+        std::unique_ptr<RainMythSimulator> simulator(new RainMythSimulator());
+        simulator->options = parseOptions(static_cast<int>(pointers.size()), pointers.data());
+        const Options& options = simulator->options;
+        simulator->scene = loadScene(options.scenePath, sf::Vector2u(options.width, options.height));
+        const char* kernelName = nullptr;
+        simulator->integrate = selectIntegrateKernel(options.kernel.c_str(), &kernelName);
+        simulator->jobs.reset(new JobSystem(options.threads, options.pinThreads));
+        return simulator.release();
+    }
+    catch (const std::exception& error) {
+        std::cerr << "Couldn't create the simulator: " << error.what() << std::endl;
+        return nullptr;
+    }
+}
+
+void rainmyth_destroy(RainMythSimulator* simulator) {
+    delete simulator;
+}
+
+void rainmyth_default_crossing(const RainMythSimulator* simulator, RainMythCrossing* crossing) {
+    if (simulator == nullptr || crossing == nullptr) {
+        return;
+    }
+    const Options& options = simulator->options;
+    crossing->speed = options.scenario.walkSpeed;
+    crossing->spawnRate = options.rain.spawnRate;
+    crossing->personWidth = options.scenario.personWidth;
+    crossing->personHeight = options.scenario.personHeight;
+}
+
+int rainmyth_run_trials(RainMythSimulator* simulator, const RainMythCrossing* crossing, const std::uint64_t* seeds, std::size_t count,
+    float* wetness, float* top, float* front, float* back) {
+    if (simulator == nullptr || crossing == nullptr || (count > 0 && (seeds == nullptr || wetness == nullptr))) {
+        return -1;
+    }
+    const Options& options = simulator->options;
+    Crossing trial;
+    trial.rain = options.rain;
+    trial.rain.spawnRate = crossing->spawnRate;
+    trial.speed = crossing->speed;
+    trial.personWidth = crossing->personWidth;
+    trial.personHeight = crossing->personHeight;
+    const bool split = top != nullptr || front != nullptr || back != nullptr;
+
+    // As runMonteCarlo does it: each job runs a store's worth of lanes on one thread, and
+    // writes its results straight into the caller's arrays. Nothing may be thrown out of a
+    // job, or the host process ends, so running out of memory or anything else is only noted
+    const std::size_t lanes = std::min(std::max<std::size_t>(options.trialLanes, 1), MAX_PEOPLE);
+    const std::size_t groups = (count + lanes - 1) / lanes;
+    std::atomic<bool> failed(false);
+    simulator->jobs->run(groups, [&](std::size_t group, unsigned) {
+        try {
+            const std::size_t first = group * lanes;
+            const std::vector<std::uint64_t> laneSeeds(seeds + first, seeds + std::min(first + lanes, count));
+            JobSystem serial(1);
+            std::vector<SurfaceWetness> surfaces;
+            const std::vector<float> results =
+                simulateTrials(options, trial, laneSeeds, simulator->scene, simulator->integrate, serial, split ? &surfaces : nullptr);
+            for (std::size_t i = 0; i < laneSeeds.size(); ++i) {
+                wetness[first + i] = results[i];
+                if (!split) {
+                    continue;
+                }
+                if (top) {
+                    top[first + i] = surfaces[i].top;
+                }
+                if (front) {
+                    front[first + i] = surfaces[i].front;
+                }
+                if (back) {
+                    back[first + i] = surfaces[i].back;
+                }
+            }
+        }
+        catch (...) {
+            failed = true;
+        }
+    });
+    return failed ? -1 : 0;
+}
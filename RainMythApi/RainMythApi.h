@@ -0,0 +1,66 @@
+#pragma once
+
+/* C interface to the simulation core, for driving trials from Python, R or anything else
+ * with a foreign function interface, in process and without files. Built as RainMythApi.dll;
+ * define RAINMYTH_API_STATIC to compile it into a program instead.
+ *
+ * Results go straight into arrays the caller owns, one slot per seed, so a NumPy or R vector
+ * can be handed over as is. With Python's ctypes, for example:
+ *
+ *   sim = lib.rainmyth_create(2, (c_char_p * 2)(b"--scene", b"Assets/Scenes/Shelters.txt"))
+ *   crossing = RainMythCrossing(); lib.rainmyth_default_crossing(sim, byref(crossing))
+ *   seeds = numpy.arange(100000, dtype=numpy.uint64); wetness = numpy.empty(100000, numpy.float32)
+ *   lib.rainmyth_run_trials(sim, byref(crossing), seeds.ctypes, len(seeds), wetness.ctypes, None, None, None)
+ *
+ * A simulator runs its trials on a job pool of its own and is not to be shared between
+ * threads; make one per thread instead */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(RAINMYTH_API_STATIC)
+#define RAINMYTH_API
+#elif defined(_WIN32) && defined(RAINMYTH_API_EXPORTS)
+#define RAINMYTH_API __declspec(dllexport)
+#elif defined(_WIN32)
+#define RAINMYTH_API __declspec(dllimport)
+#else
+#define RAINMYTH_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct RainMythSimulator RainMythSimulator;
+
+/* What a trial varies: the rest comes from the options the simulator was made with */
+typedef struct RainMythCrossing {
+    float speed;        /* Pixels per second */
+    float spawnRate;    /* Drops per second per pixel of width */
+    float personWidth;  /* Pixels */
+    float personHeight;
+} RainMythCrossing;
+
+/* Makes a simulator from the same flags the program takes, such as "--scene", "--sim-hz",
+ * "--threads" or "--trial-lanes", without the program name. Unknown flags are reported on
+ * stderr and ignored. Returns NULL if it couldn't be made */
+RAINMYTH_API RainMythSimulator* rainmyth_create(int argc, const char* const* argv);
+
+RAINMYTH_API void rainmyth_destroy(RainMythSimulator* simulator);
+
+/* The walk the simulator's options and scenario describe, as a starting point */
+RAINMYTH_API void rainmyth_default_crossing(const RainMythSimulator* simulator, RainMythCrossing* crossing);
+
+/* Simulates crossing once in the rain drawn from each of the count seeds, spread over the
+ * simulator's job pool, and writes the wetness of trial i to wetness[i]. top, front and back
+ * may each be NULL, or get the same wetness split by the surface that caught it. Each trial
+ * comes out as a single crossing in that seed's rain would, to rounding. Returns 0, or
+ * -1 if an argument was unusable, memory ran out or a trial failed, with the outputs left
+ * partly written */
+RAINMYTH_API int rainmyth_run_trials(RainMythSimulator* simulator, const RainMythCrossing* crossing, const uint64_t* seeds, size_t count,
+    float* wetness, float* top, float* front, float* back);
+
+#ifdef __cplusplus
+}
+#endif
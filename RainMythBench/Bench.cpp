@@ -0,0 +1,503 @@
+// Throughput benchmark for the rain update. Each measurement restores a RainSystem holding a
+// fixed number of drops in mid-fall, advances it one step and times the phases separately, so
+// the numbers don't drift as drops leave the screen. Nothing here opens a window or a GL context.
+// The float and int16 rows time one thread integrating every drop in the float layout and in
+// CompactRainField, for comparing the two where memory bandwidth is the limit
+//
+// With --suite, it instead runs the regression suite: named crossings through the same rain
+// as --headless, each timed over --runs runs and reporting its final wetness. The results go
+// to stdout as CSV, and to --save-baseline if given. Against --baseline, a scenario fails if
+// its median is more than --threshold slower or its wetness has moved at all beyond
+// --wetness-tolerance, so a speed-up that changes the answer is caught along with a slow-down
+//
+// With --kernels, it instead times each stage's kernel alone on one thread over a synthetic
+// store: spawn, integrate, collide, cull and emit (the batch's vertex build). Each runs at
+// sizes from one that fits the L1 cache to one only DRAM holds, and reports ns and bytes
+// moved per drop, so a kernel's cost can be told apart from the memory it streams through
+
+#include <SFML/System/Clock.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "CompactRainField.h"
+#include "Constants.h"
+#include "DropSizes.h"
+#include "Headless.h"
+#include "JobSystem.h"
+#include "Options.h"
+#include "Person.h"
+#include "RainBatch.h"
+#include "RainKernels.h"
+#include "RainSystem.h"
+#include "Rng.h"
+#include "Scene.h"
+#include "TerminalVelocity.h"
+
+namespace {
+
+const std::size_t BENCH_DROP_COUNTS[] = { 10000, 100000, 1000000 };
+
+// Sizes of the --kernels sweep. At 20 bytes a drop these fit a typical L1, L2 and L3 cache in
+// turn, and the last is well past any of them
+const std::size_t KERNEL_DROP_COUNTS[] = { 1024, 16384, 262144, 4194304 };
+const char* const KERNEL_RESIDENCY[] = { "L1", "L2", "L3", "DRAM" };
+const std::size_t KERNEL_SAMPLE_DROPS = 1 << 22; // Drops a timed sample covers at least, by running small sizes repeatedly
+
+// What a run measures, from the command line
+struct BenchOptions {
+    unsigned warmup = 5;        // --warmup N. Untimed steps before measuring
+    unsigned repetitions = 50;  // --reps N
+    unsigned threads = JobSystem::defaultThreadCount(); // --threads N
+    const char* kernel = "";    // --kernel NAME
+    const char* suite = nullptr;        // --suite NAME, or all. Runs the regression suite instead
+    const char* kernels = nullptr;      // --kernels NAME, or all. Times the stage kernels instead
+    unsigned runs = 3;                  // --runs N. Timed runs of each suite scenario
+    const char* baseline = nullptr;     // --baseline FILE. Results to compare the suite against
+    const char* saveBaseline = nullptr; // --save-baseline FILE
+    float threshold = 0.1f;             // --threshold F. Slow-down over the baseline median that fails
+    float wetnessTolerance = 1.0e-4f;   // --wetness-tolerance F. Relative change in wetness that fails
+};
+
+BenchOptions parseBenchOptions(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--warmup") == 0) {
+            options.warmup = static_cast<unsigned>(std::strtoul(argv[i + 1], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--reps") == 0) {
+            options.repetitions = std::max(1u, static_cast<unsigned>(std::strtoul(argv[i + 1], nullptr, 10)));
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0) {
+            options.threads = static_cast<unsigned>(std::strtoul(argv[i + 1], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--kernel") == 0) {
+            options.kernel = argv[i + 1];
+        }
+        else if (std::strcmp(argv[i], "--suite") == 0) {
+            options.suite = argv[i + 1];
+        }
+        else if (std::strcmp(argv[i], "--kernels") == 0) {
+            options.kernels = argv[i + 1];
+        }
+        else if (std::strcmp(argv[i], "--runs") == 0) {
+            options.runs = std::max(1u, static_cast<unsigned>(std::strtoul(argv[i + 1], nullptr, 10)));
+        }
+        else if (std::strcmp(argv[i], "--baseline") == 0) {
+            options.baseline = argv[i + 1];
+        }
+        else if (std::strcmp(argv[i], "--save-baseline") == 0) {
+            options.saveBaseline = argv[i + 1];
+        }
+        else if (std::strcmp(argv[i], "--threshold") == 0) {
+            options.threshold = static_cast<float>(std::atof(argv[i + 1]));
+        }
+        else if (std::strcmp(argv[i], "--wetness-tolerance") == 0) {
+            options.wetnessTolerance = static_cast<float>(std::atof(argv[i + 1]));
+        }
+        else {
+            std::cerr << "Unknown option " << argv[i] << std::endl;
+        }
+    }
+    return options;
+}
+
+// Times of one phase over every repetition
+struct Samples {
+    const char* phase;
+    std::vector<float> seconds;
+
+    // Prints min, median and 99th percentile, plus throughput at the median
+    void report(std::size_t drops) {
+        std::sort(seconds.begin(), seconds.end());
+        const std::size_t n = seconds.size();
+        const float median = seconds[n / 2];
+        const float p99 = seconds[std::min(n - 1, (n * 99 + 99) / 100 - 1)];
+        std::cout << std::setw(10) << phase << std::setw(10) << drops
+            << std::setw(12) << seconds.front() * 1000.0f
+            << std::setw(12) << median * 1000.0f
+            << std::setw(12) << p99 * 1000.0f
+            << std::setw(14) << (median > 0.0f ? drops / median / 1.0e6f : 0.0f) << std::endl;
+    }
+};
+
+void benchmark(std::size_t dropCount, const BenchOptions& options, IntegrateKernel integrate, JobSystem& jobs) {
+    const sf::Vector2u screen(WORLD_WIDTH, WORLD_HEIGHT);
+    const float timestep = 1.0f / SIM_HZ;
+
+    // No spawning, so every step works on exactly the prefilled drops
+    RainConfig config;
+    config.seed = 1;
+    config.maxDrops = dropCount;
+    config.spawnRate = 0.0f;
+    RainSystem prototype(screen, config, Scene::defaultScene(screen), integrate, jobs);
+    prototype.prefill(dropCount);
+    const sf::FloatRect personBounds = Person(startPoint(screen)).getBounds();
+    RainBatch batch(false);
+
+    Samples update = { "update", {} };
+    Samples integratePass = { "integrate", {} };
+    Samples collision = { "collision", {} };
+    Samples cull = { "cull", {} };
+    Samples build = { "build", {} };
+    Samples floatPass = { "float", {} };
+    Samples compactPass = { "int16", {} };
+
+    // Both layouts integrate the same drops, with the same band, on one thread
+    const RainField& start = prototype.getDrops();
+    const IntegrateParams params = { timestep, static_cast<float>(screen.y), screen.y * 0.5f, screen.y * 0.75f };
+    const CompactIntegrateParams compactParams = { CompactRainField::toFixed(params.killY),
+        CompactRainField::toFixed(params.bandTop), CompactRainField::toFixed(params.bandBottom) };
+    CompactRainField compact;
+    compact.pack(start, timestep);
+    std::vector<float> y;
+    std::vector<std::int16_t> compactY;
+    std::vector<std::uint8_t> flags(dropCount / 8 + 1);
+
+    for (unsigned rep = 0; rep < options.warmup + options.repetitions; ++rep) {
+        RainSystem rain(prototype);
+
+        sf::Clock clock;
+        rain.update(timestep, personBounds);
+        const float updateTime = clock.restart().asSeconds();
+        batch.build(rain.getDrops(), sf::Color::White);
+        const float buildTime = clock.getElapsedTime().asSeconds();
+
+        y.assign(start.y.begin(), start.y.begin() + dropCount);
+        clock.restart();
+        integrate(y.data(), start.vy.data(), dropCount, params, flags.data());
+        const float floatTime = clock.getElapsedTime().asSeconds();
+        compactY = compact.y;
+        clock.restart();
+        integrateCompact(compactY.data(), compact.dy.data(), dropCount, compactParams, flags.data());
+        const float compactTime = clock.getElapsedTime().asSeconds();
+
+        if (rep < options.warmup) {
+            continue;
+        }
+        const StepTimings& timings = rain.getTimings();
+        update.seconds.push_back(updateTime);
+        integratePass.seconds.push_back(timings.integrate);
+        collision.seconds.push_back(timings.collision);
+        cull.seconds.push_back(timings.cull);
+        build.seconds.push_back(buildTime);
+        floatPass.seconds.push_back(floatTime);
+        compactPass.seconds.push_back(compactTime);
+    }
+
+    update.report(dropCount);
+    integratePass.report(dropCount);
+    collision.report(dropCount);
+    cull.report(dropCount);
+    build.report(dropCount);
+    floatPass.report(dropCount);
+    compactPass.report(dropCount);
+}
+
+// Times pass, one run of a kernel over count drops, repeated enough times per sample that a
+// sample covers KERNEL_SAMPLE_DROPS, and prints the median and fastest ns per drop, with bytes
+// the kernel moves per drop and the bandwidth that comes to at the median. Prints nothing for a
+// kernel --kernels didn't ask for
+template <typename Pass>
+void timeKernel(const char* name, std::size_t count, const char* residency, double bytes, const BenchOptions& options, Pass pass) {
+    if (std::strcmp(options.kernels, "all") != 0 && std::strcmp(options.kernels, name) != 0) {
+        return;
+    }
+    const std::size_t passes = std::max<std::size_t>(1, KERNEL_SAMPLE_DROPS / count);
+    std::vector<double> nanoseconds;
+    for (unsigned rep = 0; rep < options.warmup + options.repetitions; ++rep) {
+        sf::Clock clock;
+        for (std::size_t i = 0; i < passes; ++i) {
+            pass();
+        }
+        const double seconds = clock.getElapsedTime().asSeconds();
+        if (rep >= options.warmup) {
+            nanoseconds.push_back(seconds * 1.0e9 / (static_cast<double>(passes) * count));
+        }
+    }
+    std::sort(nanoseconds.begin(), nanoseconds.end());
+    const double median = nanoseconds[nanoseconds.size() / 2];
+    std::cout << std::setw(10) << name << std::setw(10) << count << std::setw(6) << residency
+        << std::setw(10) << median << std::setw(10) << nanoseconds.front()
+        << std::setw(10) << bytes << std::setw(10) << (median > 0.0 ? bytes / median : 0.0) << std::endl;
+}
+
+// Times every stage's kernel over count drops spawned as the rain spawns them and then spread
+// down the screen, one size of the sweep. Each kernel runs over the same store again and again,
+// which doesn't change what it costs: spawn writes the same drops each time, integrate only moves
+// them further down, and cull keeps finding the same flags over the same count
+void benchmarkKernels(std::size_t count, const char* residency, const BenchOptions& options, IntegrateKernel integrate) {
+    const sf::Vector2u screen(WORLD_WIDTH, WORLD_HEIGHT);
+    const float timestep = 1.0f / SIM_HZ;
+    RainConfig config;
+    config.seed = 1;
+    const DropSizeTable sizes(config);
+    const TerminalVelocityTable speeds(config.minSize, config.maxSize);
+    const CounterRng counter(config.seed);
+    const SpawnParams spawn = { 0.0f, static_cast<float>(screen.x), 0.0f, 0u };
+
+    RainField drops(count);
+    std::size_t first = 0;
+    drops.grow(count, first);
+    auto spawnPass = [&]() {
+        fillSpawns(counter, 0, 0, count, spawn, sizes, speeds, drops.x.data(), drops.y.data(), drops.vy.data(),
+            drops.size.data(), drops.absorbed.data());
+    };
+    spawnPass();
+    timeKernel("spawn", count, residency, 5.0 * sizeof(float), options, spawnPass);
+    Rng rng(config.seed);
+    rng.fillUniform(drops.y.data(), count, 0.0f, static_cast<float>(screen.y));
+
+    // Flags what crosses the lower half's band or leaves the screen, for cull to remove
+    const IntegrateParams params = { timestep, static_cast<float>(screen.y), screen.y * 0.5f, screen.y * 0.75f };
+    std::vector<std::uint8_t> flags((count + 7) / 8);
+    std::vector<float> y(drops.y.begin(), drops.y.begin() + count);
+    timeKernel("integrate", count, residency, 3.0 * sizeof(float) + 0.125, options, [&]() {
+        integrate(y.data(), drops.vy.data(), count, params, flags.data());
+    });
+    integrate(drops.y.data(), drops.vy.data(), count, params, flags.data());
+
+    // Every drop as a collision candidate, the way the narrow phase gathers them, against one
+    // person where the walk starts
+    std::vector<float> left(count), top(count), right(count), bottom(count), area(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        left[i] = drops.x[i];
+        top[i] = drops.y[i];
+        right[i] = drops.x[i] + drops.size[i];
+        bottom[i] = drops.y[i] + RainField::heightOf(drops.size[i]);
+        area[i] = RainField::areaOf(drops.size[i]);
+    }
+    const sf::FloatRect bounds = Person(startPoint(screen)).getBounds();
+    const HitBox person = { rectLeft(bounds), rectTop(bounds), rectLeft(bounds) + rectWidth(bounds), rectTop(bounds) + rectHeight(bounds) };
+    const HitBatch batch = { left.data(), top.data(), right.data(), bottom.data(), area.data(), drops.absorbed.data() };
+    std::vector<std::uint32_t> hits(count);
+    float wetness = 0.0f;
+    timeKernel("collide", count, residency, 6.0 * sizeof(float) + sizeof(std::uint32_t), options, [&]() {
+        hitTestPeople(batch, count, &person, 1, hits.data(), &wetness);
+    });
+
+    RainBatch emitted(false);
+    timeKernel("emit", count, residency, 4.0 * sizeof(float) + QUAD_VERTICES * sizeof(sf::Vertex), options, [&]() {
+        emitted.build(drops, sf::Color::White);
+    });
+
+    // Last, since it leaves the store shorter. Every pass reads all count drops and writes the
+    // survivors; the ones past them are left over from before and cost the same to read
+    const std::size_t kept = compactDrops(drops.x.data(), drops.y.data(), drops.vy.data(), drops.size.data(),
+        drops.absorbed.data(), count, flags.data());
+    const double culledBytes = 0.125 + 5.0 * sizeof(float) * (1.0 + static_cast<double>(kept) / count);
+    timeKernel("cull", count, residency, culledBytes, options, [&]() {
+        compactDrops(drops.x.data(), drops.y.data(), drops.vy.data(), drops.size.data(), drops.absorbed.data(), count, flags.data());
+    });
+}
+
+// One scenario of the regression suite. configure starts from the defaults --headless would
+// use with seed 1 and one walker at walking speed, and changes what the scenario is about
+struct SuiteScenario {
+    const char* name;
+    void (*configure)(Options& options, std::vector<Walker>& walkers);
+};
+
+const SuiteScenario SUITE_SCENARIOS[] = {
+    { "default", [](Options&, std::vector<Walker>&) {} },
+    { "dense", [](Options& options, std::vector<Walker>&) {
+        options.rain.spawnRate *= 4.0f;
+        options.rain.maxDrops *= 4;
+    } },
+    { "crowd", [](Options& options, std::vector<Walker>& walkers) {
+        // Walkers and runners setting off half a second apart, so they overtake one another
+        const Walker first = walkers.front();
+        walkers.clear();
+        for (std::size_t i = 0; i < 8; ++i) {
+            Walker walker = first;
+            walker.speed = i % 2 == 0 ? options.scenario.walkSpeed : options.scenario.runSpeed;
+            walker.startTime = i * 0.5f;
+            walkers.push_back(walker);
+        }
+    } },
+    { "wind", [](Options& options, std::vector<Walker>&) {
+        options.rain.wind.speed = 80.0f;
+        options.rain.wind.gust = 40.0f;
+        options.rain.wind.turbulence = 20.0f;
+    } },
+    { "4k", [](Options& options, std::vector<Walker>&) {
+        options.width = 3840;
+        options.height = 2160;
+    } },
+};
+
+struct SuiteResult {
+    std::string name;
+    float medianMs;
+    float minMs;
+    double wetness; // Summed over the walkers
+};
+
+SuiteResult runScenario(const SuiteScenario& scenario, const BenchOptions& benchOptions, IntegrateKernel integrate, JobSystem& jobs) {
+    char program[] = "RainMythBench";
+    char* argv[] = { program };
+    Options options = parseOptions(1, argv);
+    options.rain.seed = 1;
+    Walker walker;
+    walker.personWidth = options.scenario.personWidth;
+    walker.personHeight = options.scenario.personHeight;
+    walker.speed = options.scenario.walkSpeed;
+    walker.startTime = 0.0f;
+    std::vector<Walker> walkers(1, walker);
+    scenario.configure(options, walkers);
+    const Scene scene = Scene::defaultScene(sf::Vector2u(options.width, options.height));
+
+    SuiteResult result = { scenario.name, 0.0f, 0.0f, 0.0 };
+    std::vector<float> milliseconds;
+    for (unsigned run = 0; run < benchOptions.runs; ++run) {
+        sf::Clock clock;
+        const std::vector<float> wetness = simulateCrowd(options, options.rain, scene, walkers, integrate, jobs);
+        milliseconds.push_back(clock.getElapsedTime().asSeconds() * 1000.0f);
+        result.wetness = 0.0;
+        for (float caught : wetness) {
+            result.wetness += caught;
+        }
+    }
+    std::sort(milliseconds.begin(), milliseconds.end());
+    result.medianMs = milliseconds[milliseconds.size() / 2];
+    result.minMs = milliseconds.front();
+    return result;
+}
+
+void writeResults(std::ostream& out, const std::vector<SuiteResult>& results) {
+    out << "scenario,median_ms,min_ms,wetness" << std::endl;
+    for (const SuiteResult& result : results) {
+        out << result.name << "," << std::setprecision(6) << result.medianMs << "," << result.minMs << ","
+            << std::setprecision(12) << result.wetness << std::endl;
+    }
+}
+
+// Reads what writeResults wrote. Returns false if the file couldn't be opened
+bool readResults(const char* path, std::vector<SuiteResult>& results) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    std::string line;
+    std::getline(in, line); // Header
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        SuiteResult result;
+        char comma = 0;
+        if (std::getline(fields, result.name, ',') && fields >> result.medianMs >> comma >> result.minMs >> comma >> result.wetness) {
+            results.push_back(result);
+        }
+    }
+    return true;
+}
+
+// Prints each result beside its baseline and returns how many failed. Scenarios the baseline
+// doesn't have are reported but can't fail
+unsigned compareResults(const std::vector<SuiteResult>& results, const std::vector<SuiteResult>& baseline, const BenchOptions& options) {
+    unsigned failures = 0;
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << std::setw(10) << "scenario" << std::setw(14) << "baseline ms" << std::setw(12) << "median ms"
+        << std::setw(10) << "change" << std::setw(10) << "wetness" << std::setw(8) << "result" << std::endl;
+    for (const SuiteResult& result : results) {
+        const SuiteResult* base = nullptr;
+        for (const SuiteResult& candidate : baseline) {
+            if (candidate.name == result.name) {
+                base = &candidate;
+            }
+        }
+        if (base == nullptr) {
+            std::cout << std::setw(10) << result.name << std::setw(14) << "-" << std::setw(12) << result.medianMs
+                << std::setw(10) << "-" << std::setw(10) << "-" << std::setw(8) << "new" << std::endl;
+            continue;
+        }
+        const float change = base->medianMs > 0.0f ? result.medianMs / base->medianMs - 1.0f : 0.0f;
+        const bool slower = change > options.threshold;
+        const bool moved = std::abs(result.wetness - base->wetness) > options.wetnessTolerance * std::max(std::abs(base->wetness), 1.0);
+        if (slower || moved) {
+            ++failures;
+        }
+        std::cout << std::setw(10) << result.name << std::setw(14) << base->medianMs << std::setw(12) << result.medianMs
+            << std::setw(9) << change * 100.0f << "%" << std::setw(10) << (moved ? "changed" : "same")
+            << std::setw(8) << (slower || moved ? "FAIL" : "pass") << std::endl;
+    }
+    return failures;
+}
+
+// Runs the suite, or the one scenario named, and returns the process exit code
+int runSuite(const BenchOptions& options, IntegrateKernel integrate, JobSystem& jobs) {
+    std::vector<SuiteResult> results;
+    for (const SuiteScenario& scenario : SUITE_SCENARIOS) {
+        if (std::strcmp(options.suite, "all") == 0 || std::strcmp(options.suite, scenario.name) == 0) {
+            results.push_back(runScenario(scenario, options, integrate, jobs));
+        }
+    }
+    if (results.empty()) {
+        std::cerr << "No suite scenario called " << options.suite << std::endl;
+        return EXIT_FAILURE;
+    }
+    writeResults(std::cout, results);
+    if (options.saveBaseline != nullptr) {
+        std::ofstream out(options.saveBaseline);
+        writeResults(out, results);
+        if (!out) {
+            std::cerr << "Couldn't write the baseline to " << options.saveBaseline << std::endl;
+        }
+    }
+    if (options.baseline == nullptr) {
+        return EXIT_SUCCESS;
+    }
+    std::vector<SuiteResult> baseline;
+    if (!readResults(options.baseline, baseline)) {
+        std::cerr << "Couldn't read the baseline " << options.baseline << std::endl;
+        return EXIT_FAILURE;
+    }
+    const unsigned failures = compareResults(results, baseline, options);
+    std::cout << failures << " of " << results.size() << " scenarios failed" << std::endl;
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const BenchOptions options = parseBenchOptions(argc, argv);
+    const char* kernelName = nullptr;
+    IntegrateKernel integrate = selectIntegrateKernel(options.kernel, &kernelName);
+    JobSystem jobs(options.threads);
+
+    if (options.suite != nullptr) {
+        std::cerr << "Kernel " << kernelName << ", " << jobs.threadCount() << " threads, " << options.runs << " runs per scenario" << std::endl;
+        return runSuite(options, integrate, jobs);
+    }
+
+    if (options.kernels != nullptr) {
+        std::cout << "Kernel " << kernelName << ", one thread, " << options.warmup << " warmup + " << options.repetitions
+            << " timed samples of at least " << KERNEL_SAMPLE_DROPS << " drops per size" << std::endl;
+        std::cout << "Bytes are what each kernel reads and writes per drop; GB/s is that at the median" << std::endl;
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << std::setw(10) << "kernel" << std::setw(10) << "drops" << std::setw(6) << "fits"
+            << std::setw(10) << "ns/drop" << std::setw(10) << "min ns" << std::setw(10) << "B/drop" << std::setw(10) << "GB/s" << std::endl;
+        for (std::size_t i = 0; i < sizeof(KERNEL_DROP_COUNTS) / sizeof(KERNEL_DROP_COUNTS[0]); ++i) {
+            benchmarkKernels(KERNEL_DROP_COUNTS[i], KERNEL_RESIDENCY[i], options, integrate);
+        }
+        return 0;
+    }
+
+    std::cout << "Kernel " << kernelName << ", " << jobs.threadCount() << " threads, "
+        << options.warmup << " warmup + " << options.repetitions << " timed steps per size" << std::endl;
+    std::cout << "Collision is CPU time summed over threads; build is the CPU side of the batched draw" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << std::setw(10) << "phase" << std::setw(10) << "drops" << std::setw(12) << "min ms"
+        << std::setw(12) << "median ms" << std::setw(12) << "p99 ms" << std::setw(14) << "Mdrops/s" << std::endl;
+    for (std::size_t dropCount : BENCH_DROP_COUNTS) {
+        benchmark(dropCount, options, integrate, jobs);
+    }
+    return 0;
+}
@@ -0,0 +1,50 @@
+// RainMyth without the window, for sweep and batch nodes that have no display or no SFML
+// graphics: everything runWindowlessMode covers, from the same options as RainMyth. Links
+// only RainMythCore, SweepNetwork and SFML's system and network modules. Windowed runs and
+// offline renders need the full RainMyth
+
+#include <cstdlib>
+#include <iostream>
+
+#include "AssetPack.h"
+#include "JobSystem.h"
+#include "Options.h"
+#include "RainKernels.h"
+#include "Replay.h"
+#include "WindowlessModes.h"
+
+int main(int argc, char* argv[])
+{
+    if (const char* missing = missingInstructionSet()) {
+        std::cerr << "This build needs a CPU with " << missing << "; use the Release build on this machine" << std::endl;
+        return EXIT_FAILURE;
+    }
+    Options options = parseOptions(argc, argv);
+    if (!options.packAssetsPath.empty()) {
+        return writeAssetPack("Assets", options.packAssetsPath) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    ReplayLog replay;
+    const bool replaying = !options.replayPath.empty();
+    if (replaying) {
+        if (!readReplay(options.replayPath, replay)) {
+            return EXIT_FAILURE;
+        }
+        applyReplay(replay, options);
+    }
+
+    const char* kernelName = nullptr;
+    IntegrateKernel integrate = selectIntegrateKernel(options.kernel.c_str(), &kernelName);
+    std::cout << "Integration kernel: " << kernelName << std::endl;
+    JobSystem jobs(options.threads, options.pinThreads);
+    if (jobs.isPinned()) {
+        std::cout << "Job threads pinned, one per processor" << std::endl;
+    }
+
+    int exitCode = EXIT_SUCCESS;
+    if (runWindowlessMode(options, replaying ? &replay : nullptr, integrate, jobs, exitCode)) {
+        return exitCode;
+    }
+    std::cerr << "RainMythHeadless has no window: give --headless, --sweep, --sweep-worker, --trials, --optimize, "
+        "--importance, --batch or --validate, or use RainMyth" << std::endl;
+    return EXIT_FAILURE;
+}